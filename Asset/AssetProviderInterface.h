@@ -67,6 +67,15 @@ namespace Foundation
          */
         virtual bool RequestAsset(const std::string& asset_id, const std::string& asset_type, request_tag_t tag) = 0;
 
+        //! Removes a tag from a download, and stops the download if it has no tags left
+        /*! Providers that can not stop downloads may ignore this and send the ASSET_READY events anyway.
+
+            \param asset_id Asset ID
+            \param tag Asset request tag
+            \return true if the provider had a download with the tag
+         */
+        virtual bool CancelRequest(const std::string& asset_id, request_tag_t tag) { return false; }
+
         //! Returns whether a certain asset is already being downloaded
         /*! \param asset_id Asset ID
          */           
@@ -68,6 +68,14 @@ namespace Foundation
          */
         virtual request_tag_t RequestAsset(const std::string& asset_id, const std::string& asset_type) = 0;
 
+        //! Tells that a requested asset is no longer needed
+        /*! The download is stopped if no other request is waiting for it. No ASSET_READY event is sent for the tag.
+
+            \param asset_id Asset ID
+            \param tag Request tag returned by RequestAsset
+         */
+        virtual void CancelAssetRequest(const std::string& asset_id, request_tag_t tag) = 0;
+
         //! Checks asset id for validity
         /*! \return true if asset id is valid
          */
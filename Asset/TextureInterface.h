@@ -45,6 +45,17 @@ namespace Foundation
 
         //! Get ogre image pixel format
         virtual int GetFormat() = 0;
+
+        //! returns number of mipmap levels in the data, 1 if there is only the full size image
+        virtual uint GetMipCount() const { return 1; }
+
+        //! returns data of a mipmap level
+        /*! each level is half the width and height of the previous one, but at least 1. Level 0 is the same as GetData()
+         */
+        virtual u8* GetMipData(uint mip) { return mip ? 0 : GetData(); }
+
+        //! returns data size of a mipmap level
+        virtual uint GetMipDataSize(uint mip) { return mip ? 0 : GetDataSize(); }
     };
 }
 
@@ -34,6 +34,23 @@ namespace Foundation
          */
         virtual request_tag_t RequestTexture(const std::string& asset_id) = 0;
 
+        //! Tells that a texture request is no longer needed
+        /*! No RESOURCE_READY event is sent for the tag. If no other request waits for the texture, its download is
+            canceled and it is not decoded further.
+            \param asset_id texture ID
+            \param tag request tag returned by RequestTexture
+         */
+        virtual void CancelTextureRequest(const std::string& asset_id, request_tag_t tag) = 0;
+
+        //! Requests a texture that has already been received to be decoded at a lower quality level
+        /*! Used for making textures that are not in use take less memory. One RESOURCE_READY event is sent when
+            the level has been decoded, or RESOURCE_CANCELED if decoding failed.
+            \param asset_id texture ID
+            \param level quality level, 0 = highest. Each level halves the width and height.
+            \return request tag, or 0 if the texture data is not available
+         */
+        virtual request_tag_t RequestTextureLevel(const std::string& asset_id, int level) = 0;
+
         //! Gets a texture rousource from cache
         //! @param texture_id as std::string
         //! @return valid ptr if found, 0 ptr if not
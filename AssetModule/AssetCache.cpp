@@ -316,7 +316,8 @@ namespace Asset
     void AssetCache::StoreAsset(Foundation::AssetPtr asset, bool store_to_disk)
     {
         const std::string& asset_id = asset->GetId();
-        AssetModule::LogDebug("Storing complete asset " + asset_id);
+        if (AssetModule::IsLogEnabled(Poco::Message::PRIO_DEBUG))
+            AssetModule::LogDebug("Storing complete asset " + asset_id);
 
         // Store to memory cache
         assets_[asset_id] = asset;
@@ -76,6 +76,20 @@ namespace Asset
         return 0;
     }
 
+    void AssetManager::CancelAssetRequest(const std::string& asset_id, request_tag_t tag)
+    {
+        AssetProviderVector::iterator i = providers_.begin();
+        while (i != providers_.end())
+        {
+            if ((*i)->InProgress(asset_id))
+            {
+                (*i)->CancelRequest(asset_id, tag);
+                return;
+            }
+            ++i;
+        }
+    }
+
     Foundation::AssetPtr AssetManager::GetIncompleteAsset(const std::string& asset_id, const std::string& asset_type, uint received)
     {
         if (!received)
@@ -64,6 +64,12 @@ namespace Asset
          */
         virtual request_tag_t RequestAsset(const std::string& asset_id, const std::string& asset_type);
 
+        //! Tells that a requested asset is no longer needed
+        /*! \param asset_id Asset ID
+            \param tag Request tag returned by RequestAsset
+         */
+        virtual void CancelAssetRequest(const std::string& asset_id, request_tag_t tag);
+
         //! Queries status of asset download
         /*! If asset has been already fully received, size, received & received_continuous will be the same
         
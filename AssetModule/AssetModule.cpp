@@ -64,6 +64,18 @@ namespace Asset
         RegisterConsoleCommand(Console::CreateCommand(
             "RequestAsset", "Request asset from server. Usage: RequestAsset(uuid,assettype)", 
             Console::Bind(this, &AssetModule::ConsoleRequestAsset)));
+
+        RegisterConsoleCommand(Console::CreateCommand(
+            "HttpAssetStats", "Prints HTTP asset fetch queue and timing statistics. Usage: HttpAssetStats(reset)", 
+            Console::Bind(this, &AssetModule::ConsoleHttpAssetStats)));
+
+        RegisterConsoleCommand(Console::CreateCommand(
+            "RecordTextureStream", "Records received UDP texture transfers to a file. Usage: RecordTextureStream(file) to start, RecordTextureStream() to stop", 
+            Console::Bind(this, &AssetModule::ConsoleRecordTextureStream)));
+
+        RegisterConsoleCommand(Console::CreateCommand(
+            "BenchTextureStream", "Replays a recorded texture stream through the UDP transfer reassembly. Usage: BenchTextureStream(file,rounds)", 
+            Console::Bind(this, &AssetModule::ConsoleBenchTextureStream)));
     }
 
     void AssetModule::SubscribeToNetworkEvents(boost::weak_ptr<ProtocolUtilities::ProtocolModuleInterface> currentProtocolModule)
@@ -110,6 +122,44 @@ namespace Asset
         return Console::ResultSuccess();
     }
 
+    Console::CommandResult AssetModule::ConsoleHttpAssetStats(const StringVector &params)
+    {
+        QtHttpAssetProvider* provider = checked_static_cast<QtHttpAssetProvider*>(http_asset_provider_.get());
+        std::string report = provider->GetStatsReport();
+        if (params.size() && params[0] == "reset")
+            provider->ResetStats();
+        return Console::ResultSuccess(report);
+    }
+
+    Console::CommandResult AssetModule::ConsoleRecordTextureStream(const StringVector &params)
+    {
+        UDPAssetProvider* provider = checked_static_cast<UDPAssetProvider*>(udp_asset_provider_.get());
+        if (params.empty())
+            return Console::ResultSuccess("Recorded " + ToString<uint>(provider->StopRecording()) + " texture transfer messages");
+
+        if (!provider->StartRecording(params[0]))
+            return Console::ResultFailure("Could not open " + params[0]);
+        return Console::ResultSuccess("Recording texture transfers to " + params[0]);
+    }
+
+    Console::CommandResult AssetModule::ConsoleBenchTextureStream(const StringVector &params)
+    {
+        if (params.empty())
+            return Console::ResultFailure("Usage: BenchTextureStream(file,rounds)");
+
+        TextureStreamRecordVector records;
+        if (!LoadTextureStream(params[0], records))
+            return Console::ResultFailure("Could not read " + params[0]);
+
+        uint rounds = 10;
+        if (params.size() > 1)
+            rounds = ParseString<uint>(params[1], rounds);
+        if (!rounds)
+            rounds = 1;
+
+        return Console::ResultSuccess(BenchTextureStream(records, rounds));
+    }
+
     bool AssetModule::HandleEvent(
         event_category_id_t category_id,
         event_id_t event_id, 
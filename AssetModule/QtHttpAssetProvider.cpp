@@ -15,10 +15,17 @@
 #include <QNetworkReply>
 #include <QByteArray>
 
-#include <QDebug>
 #include <QStringList>
 
-#define MAX_HTTP_CONNECTIONS 10000 // Basically means no limit to parallel connections
+namespace
+{
+    const int DEFAULT_MAX_CONNECTIONS = 16;
+    // QNetworkAccessManager opens at most six connections to a host and queues the rest itself
+    const int DEFAULT_MAX_HOST_CONNECTIONS = 6;
+    const f64 DEFAULT_HTTP_TIMEOUT = 120.0;
+
+    const char *priority_names[Asset::HttpPriorityCount] = { "visible", "sound", "other" };
+}
 
 namespace Asset
 {
@@ -28,17 +35,31 @@ namespace Asset
         event_manager_(framework->GetEventManager().get()),
         name_("QtHttpAssetProvider"),
         network_manager_(new QNetworkAccessManager()),
-        filling_stack_(false),
+        burst_start_(0),
+        visible_ready_time_(0.0),
         get_texture_cap_(QUrl())
     {
         if (event_manager_)
             asset_event_category_ = event_manager_->QueryEventCategory("Asset");
+
+        asset_timeout_ = framework_->GetDefaultConfig().DeclareSetting("AssetSystem", "http_timeout", DEFAULT_HTTP_TIMEOUT);
+        max_connections_ = framework_->GetDefaultConfig().DeclareSetting("AssetSystem", "http_max_connections", DEFAULT_MAX_CONNECTIONS);
+        max_host_connections_ = framework_->GetDefaultConfig().DeclareSetting("AssetSystem", "http_max_connections_per_host", DEFAULT_MAX_HOST_CONNECTIONS);
+        if (max_connections_ < 1)
+            max_connections_ = 1;
+        if (max_host_connections_ < 1)
+            max_host_connections_ = 1;
+
+        for (int i = 0; i < HttpPriorityCount; ++i)
+            outstanding_[i] = 0;
+
         connect(network_manager_, SIGNAL(finished(QNetworkReply*)), SLOT(TranferCompleted(QNetworkReply*)));
         AssetModule::LogInfo("HttpAssetProvider initialized");
     }
 
     QtHttpAssetProvider::~QtHttpAssetProvider()
     {
+        ClearAllTransfers();
         SAFE_DELETE(network_manager_);
     }
 
@@ -53,6 +74,18 @@ namespace Asset
 
     void QtHttpAssetProvider::Update(f64 frametime)
     {
+        // Abort transfers that take too long, they hold a connection that queued transfers could use
+        QList<QtHttpAssetTransfer *> timed_out;
+        foreach (QtHttpAssetTransfer *transfer, replies_.values())
+            if (SecondsSince(transfer->GetStartTime()) > asset_timeout_)
+                timed_out.append(transfer);
+
+        foreach (QtHttpAssetTransfer *transfer, timed_out)
+        {
+            AssetModule::LogDebug("HTTP asset " + transfer->GetTranferInfo().id.toStdString() + " timed out");
+            AbortTransfer(transfer, true);
+        }
+
         StartTransferFromQueue();
     }
 
@@ -85,51 +118,66 @@ namespace Asset
             return false;
 
         QString asset_id_qstring = QString::fromStdString(asset_id);
-        if (assetid_to_transfer_map_.contains(asset_id_qstring))
+        QtHttpAssetTransfer *existing = transfers_.value(asset_id_qstring, 0);
+        if (existing)
+        {
+            existing->GetTranferInfo().AddTag(tag);
+            return true;
+        }
+
+        asset_type_t asset_type_int = RexTypes::GetAssetTypeFromTypeName(asset_type);
+        QtHttpAssetTransfer *transfer = 0;
+        if (IsAcceptableAssetType(asset_type) && RexUUID::IsValid(asset_id) && get_texture_cap_.isValid())
         {
-            assetid_to_transfer_map_[asset_id_qstring]->GetTranferInfo().AddTag(tag);
+            // Http texture/meshes via cap url
+            QString texture_url_string = get_texture_cap_.toString() + "?texture_id=" + asset_id_qstring;
+            QUrl texture_url(texture_url_string);
+            transfer = new QtHttpAssetTransfer(texture_url, asset_id_qstring, asset_type_int, tag);
         }
         else
         {
-            asset_type_t asset_type_int = RexTypes::GetAssetTypeFromTypeName(asset_type);
-            QtHttpAssetTransfer *transfer = 0;
-            if (IsAcceptableAssetType(asset_type) && RexUUID::IsValid(asset_id) && get_texture_cap_.isValid())
-            {
-                // Http texture/meshes via cap url
-                QString texture_url_string = get_texture_cap_.toString() + "?texture_id=" + asset_id_qstring;
-                QUrl texture_url(texture_url_string);
-                transfer = new QtHttpAssetTransfer(texture_url, asset_id_qstring, asset_type_int, tag);
-            }
-            else
-            {
-                // Normal http get
-                QUrl asset_url = CreateUrl(asset_id_qstring);
-                transfer = new QtHttpAssetTransfer(asset_url, asset_id_qstring, asset_type_int, tag);
-            }
+            // Normal http get
+            QUrl asset_url = CreateUrl(asset_id_qstring);
+            transfer = new QtHttpAssetTransfer(asset_url, asset_id_qstring, asset_type_int, tag);
+        }
 
-            if (!transfer)
-                return false;
+        if (!transfer)
+            return false;
 
-            transfer->setOriginatingObject(transfer);
-            if (assetid_to_transfer_map_.count() <= MAX_HTTP_CONNECTIONS)
-            {
-                assetid_to_transfer_map_[asset_id_qstring] = transfer;
-                network_manager_->get(*transfer);
-                AssetModule::LogDebug("New HTTP asset request: " + asset_id + " type: " + asset_type);
-            }
-            else
-                pending_request_queue_.append(transfer);
+        if (transfers_.isEmpty())
+        {
+            burst_start_ = transfer->GetRequestTime();
+            visible_ready_time_ = -1.0;
         }
+
+        transfers_[asset_id_qstring] = transfer;
+        hosts_[transfer->GetHost()].pending[transfer->GetPriority()].append(transfer);
+        ++outstanding_[transfer->GetPriority()];
+        ++stats_[transfer->GetPriority()].requested;
+
+        StartTransferFromQueue();
         return true;
     }
 
-    bool QtHttpAssetProvider::InProgress(const std::string& asset_id)
+    bool QtHttpAssetProvider::CancelRequest(const std::string& asset_id, request_tag_t tag)
     {
-        QString qt_asset_id = QString::fromStdString(asset_id);
-        if (assetid_to_transfer_map_.contains(qt_asset_id) || CheckRequestQueue(qt_asset_id))
-            return true;
-        else
+        QtHttpAssetTransfer *transfer = transfers_.value(QString::fromStdString(asset_id), 0);
+        if (!transfer || !transfer->GetTranferInfo().RemoveTag(tag))
             return false;
+
+        // Keep fetching as long as someone still wants the asset
+        if (transfer->GetTranferInfo().tags.isEmpty())
+        {
+            AssetModule::LogDebug("HTTP asset " + asset_id + " no longer needed");
+            AbortTransfer(transfer, false);
+            StartTransferFromQueue();
+        }
+        return true;
+    }
+
+    bool QtHttpAssetProvider::InProgress(const std::string& asset_id)
+    {
+        return transfers_.contains(QString::fromStdString(asset_id));
     }
 
     bool QtHttpAssetProvider::QueryAssetStatus(const std::string& asset_id, uint& size, uint& received, uint& received_continuous)
@@ -154,9 +202,9 @@ namespace Asset
     Foundation::AssetTransferInfoVector QtHttpAssetProvider::GetTransferInfo()
     {
         Foundation::AssetTransferInfoVector info_vector;
-        foreach (QtHttpAssetTransfer *transfer, assetid_to_transfer_map_.values())
+        foreach (QtHttpAssetTransfer *transfer, transfers_.values())
         {
-            HttpAssetTransferInfo iter_info = transfer->GetTranferInfo();
+            const HttpAssetTransferInfo &iter_info = transfer->GetTranferInfo();
             // What we know
             Foundation::AssetTransferInfo info;
             info.id_ = iter_info.id.toStdString();
@@ -171,6 +219,42 @@ namespace Asset
         return info_vector;
     }
 
+    std::string QtHttpAssetProvider::GetStatsReport() const
+    {
+        std::string report = "HTTP assets: " + ToString<int>(replies_.count()) + " fetching, " +
+            ToString<int>(transfers_.count() - replies_.count()) + " queued, " + ToString<int>(hosts_.count()) + " hosts, limits " +
+            ToString<int>(max_connections_) + " connections, " + ToString<int>(max_host_connections_) + " per host\n";
+
+        if (burst_start_)
+        {
+            if (visible_ready_time_ >= 0.0)
+                report += "Visible assets of the latest burst fetched in " + ToString<double>(visible_ready_time_) + " s\n";
+            else
+                report += "Visible assets of the latest burst still fetching after " + ToString<double>(SecondsSince(burst_start_)) + " s\n";
+        }
+
+        for (int i = 0; i < HttpPriorityCount; ++i)
+        {
+            const FetchStats &stats = stats_[i];
+            uint finished = stats.completed + stats.failed;
+            report += std::string(priority_names[i]) + ": " + ToString<uint>(stats.requested) + " requested, " +
+                ToString<uint>(stats.completed) + " completed, " + ToString<uint>(stats.failed) + " failed, " +
+                ToString<uint>(stats.canceled) + " canceled";
+            if (finished)
+                report += ", avg wait " + ToString<double>(stats.wait_time * 1000.0 / finished) + " ms, avg fetch " +
+                    ToString<double>(stats.fetch_time * 1000.0 / finished) + " ms, max fetch " +
+                    ToString<double>(stats.max_fetch_time * 1000.0) + " ms";
+            report += "\n";
+        }
+        return report;
+    }
+
+    void QtHttpAssetProvider::ResetStats()
+    {
+        for (int i = 0; i < HttpPriorityCount; ++i)
+            stats_[i] = FetchStats();
+    }
+
     // Private
 
     QUrl QtHttpAssetProvider::CreateUrl(QString assed_id)
@@ -182,207 +266,171 @@ namespace Asset
 
     void QtHttpAssetProvider::TranferCompleted(QNetworkReply *reply)
     {
-        fake_metadata_fetch_ = false;
-        QtHttpAssetTransfer *transfer = dynamic_cast<QtHttpAssetTransfer*>(reply->request().originatingObject());
+        // Replies of aborted and cleared transfers are not in the map anymore
+        QtHttpAssetTransfer *transfer = replies_.take(reply);
+        reply->deleteLater();
+        if (!transfer)
+            return;
+
+        // Forget the transfer before sending the events, so that new requests for the asset start a new transfer
+        HttpAssetTransferInfo transfer_info = transfer->GetTranferInfo();
+        FetchStats &stats = stats_[transfer->GetPriority()];
+        double fetch_time = SecondsSince(transfer->GetRequestTime());
+        stats.wait_time += (transfer->GetStartTime() - transfer->GetRequestTime()) / (double)GetCurrentClockFreq();
+        stats.fetch_time += fetch_time;
+        if (fetch_time > stats.max_fetch_time)
+            stats.max_fetch_time = fetch_time;
+        RemoveTransfer(transfer);
 
         /**** THIS IS A DATA REQUEST REPLY AND IT FAILED ****/
-        if (reply->error() != QNetworkReply::NoError && transfer)
+        if (reply->error() != QNetworkReply::NoError)
         {
+            ++stats.failed;
+
             // Send asset canceled events
-            HttpAssetTransferInfo error_transfer_data = transfer->GetTranferInfo();
-            Events::AssetCanceled *data = new Events::AssetCanceled(error_transfer_data.id.toStdString(), RexTypes::GetAssetTypeString(error_transfer_data.type));
+            Events::AssetCanceled *data = new Events::AssetCanceled(transfer_info.id.toStdString(), RexTypes::GetAssetTypeString(transfer_info.type));
             EventDataPtr data_ptr(data);
             event_manager_->SendDelayedEvent(asset_event_category_, Events::ASSET_CANCELED, data_ptr, 0);
 
-            // Clean up
-            RemoveFinishedTransfers(error_transfer_data.id, reply->url());
+            AssetModule::LogDebug("HTTP asset " + transfer_info.id.toStdString() + " canceled. Network error occurred.");
             StartTransferFromQueue();
-
-            AssetModule::LogDebug("HTTP asset " + error_transfer_data.id.toStdString() + " canceled. Network error occurred.");
-            reply->deleteLater();
             return;
         }
 
-        /**** THIS IS A /data REQUEST REPLY ****/
-        if (transfer)
-        {
-            // Create asset pointer
-            HttpAssetTransferInfo tranfer_info = transfer->GetTranferInfo();
-            std::string id = tranfer_info.id.toStdString();
-            std::string type = RexTypes::GetTypeNameFromAssetType(tranfer_info.type);
-            Foundation::AssetPtr asset_ptr = Foundation::AssetPtr(new RexAsset(id, type));
-
-            // Fill asset data with reply data
-            RexAsset::AssetDataVector& data_vector = checked_static_cast<RexAsset*>(asset_ptr.get())->GetDataInternal();
-            QByteArray data_array = reply->readAll();
-            for (int index = 0; index < data_array.count(); ++index)
-                data_vector.push_back(data_array.at(index));
-
-            // Get metadata if available
-            QString url_path = tranfer_info.url.path();
-            if (url_path.endsWith("/data") || url_path.endsWith("/data/"))
-            {
-                // Generate metada url
-                int clip_count;
-                if (url_path.endsWith("/data"))
-                    clip_count = 5;
-                else if (url_path.endsWith("/data/"))
-                    clip_count = 6;
-                else
-                {
-                    reply->deleteLater();
-                    return;
-                }
+        ++stats.completed;
 
-                QUrl metadata_url = tranfer_info.url;
-                url_path = url_path.left(url_path.count()-clip_count);
-                url_path = url_path + "/metadata";
-                metadata_url.setPath(url_path);
-                tranfer_info.url = metadata_url;
-
-                QNetworkRequest *metada_request = new QNetworkRequest(metadata_url);
-
-                // Store tranfer data and asset data pointer internally
-                QPair<HttpAssetTransferInfo, Foundation::AssetPtr> data_pair;
-                data_pair.first = tranfer_info;
-                data_pair.second = asset_ptr;
-                metadata_to_assetptr_[metada_request->url()] = data_pair;
-                
-                // Send metadata network request
-                //network_manager_->get(*metada_request);
-                
-                // HACK to avoid metadata fetch for now, we dont use it to anything yet
-                fake_metadata_url_ = metada_request->url();
-                fake_metadata_fetch_ = true;
-            }
-            // Asset data feched, lets store
-            else
-            {
-                AssetModule::LogDebug("HTTP asset " + tranfer_info.id.toStdString() + " completed");
+        // Create asset pointer
+        std::string id = transfer_info.id.toStdString();
+        std::string type = RexTypes::GetTypeNameFromAssetType(transfer_info.type);
+        Foundation::AssetPtr asset_ptr = Foundation::AssetPtr(new RexAsset(id, type));
 
-                // Store asset, but don't store textures, they have their own cache action after decoding
-                boost::shared_ptr<Foundation::AssetServiceInterface> asset_service = framework_->GetServiceManager()->GetService<Foundation::AssetServiceInterface>(Service::ST_Asset).lock();
-                if (asset_service) 
-                    asset_service->StoreAsset(asset_ptr);
+        // Fill asset data with reply data
+        RexAsset::AssetDataVector& data_vector = checked_static_cast<RexAsset*>(asset_ptr.get())->GetDataInternal();
+        QByteArray data_array = reply->readAll();
+        data_vector.assign(data_array.constData(), data_array.constData() + data_array.size());
 
-                // Send asset ready events
-                foreach (request_tag_t tag, tranfer_info.tags)
-                {
-                    Events::AssetReady event_data(asset_ptr.get()->GetId(), asset_ptr.get()->GetType(), asset_ptr, tag);
-                    event_manager_->SendEvent(asset_event_category_, Events::ASSET_READY, &event_data);
-                }
+        // Asset services may also offer /metadata next to /data. It is not fetched, as nothing uses the metadata yet.
+        if (AssetModule::IsLogEnabled(Poco::Message::PRIO_DEBUG))
+            AssetModule::LogDebug("HTTP asset " + id + " completed");
 
-                RemoveFinishedTransfers(tranfer_info.id, QUrl());
-                StartTransferFromQueue();
-            }
+        // Store asset
+        boost::shared_ptr<Foundation::AssetServiceInterface> asset_service = framework_->GetServiceManager()->GetService<Foundation::AssetServiceInterface>(Service::ST_Asset).lock();
+        if (asset_service) 
+            asset_service->StoreAsset(asset_ptr);
+
+        // Send asset ready events
+        foreach (request_tag_t tag, transfer_info.tags)
+        {
+            Events::AssetReady event_data(asset_ptr.get()->GetId(), asset_ptr.get()->GetType(), asset_ptr, tag);
+            event_manager_->SendEvent(asset_event_category_, Events::ASSET_READY, &event_data);
         }
 
-        // Complete /data and /metadata sequence, fake is here as long as we dont have xml parser for metadata
-        // or actually we dont use metadata in naali so thats the main reason its not fetched
-        if (fake_metadata_fetch_)
+        StartTransferFromQueue();
+    }
+
+    void QtHttpAssetProvider::ClearAllTransfers()
+    {
+        QList<QtHttpAssetTransfer *> transfers = transfers_.values();
+        QList<QNetworkReply *> replies = replies_.keys();
+        transfers_.clear();
+        replies_.clear();
+        hosts_.clear();
+        for (int i = 0; i < HttpPriorityCount; ++i)
+            outstanding_[i] = 0;
+        burst_start_ = 0;
+
+        // The replies finish right away when aborted, they are ignored as they are not in the map anymore
+        foreach (QNetworkReply *reply, replies)
+            reply->abort();
+        foreach (QtHttpAssetTransfer *transfer, transfers)
+            SAFE_DELETE(transfer);
+    }
+
+    void QtHttpAssetProvider::StartTransferFromQueue()
+    {
+        // Highest priority class first. Within a class, take turns between the hosts that have room.
+        for (int priority = 0; priority < HttpPriorityCount; ++priority)
         {
-            /**** THIS IS A /metadata REQUEST REPLY ****/
-            if (metadata_to_assetptr_.contains(fake_metadata_url_))
+            bool started = true;
+            while (started && replies_.count() < max_connections_)
             {
-                // Pull out transfer data and asset pointer assosiated with this reply url
-                QUrl metadata_transfer_url = fake_metadata_url_;
-                HttpAssetTransferInfo transfer_data = metadata_to_assetptr_[metadata_transfer_url].first;
-                Foundation::AssetPtr ready_asset_ptr = metadata_to_assetptr_[metadata_transfer_url].second;
-                if (!ready_asset_ptr)
+                started = false;
+                QHash<QString, HostQueue>::iterator i = hosts_.begin();
+                while (i != hosts_.end() && replies_.count() < max_connections_)
                 {
-                    reply->deleteLater();
-                    return;
+                    HostQueue &host = i.value();
+                    if (host.active < max_host_connections_ && !host.pending[priority].isEmpty())
+                    {
+                        StartTransfer(host.pending[priority].takeFirst());
+                        started = true;
+                    }
+                    ++i;
                 }
-
-                // Fill metadata
-                /*
-                const QByteArray &inbound_metadata = reply->readAll();
-                QString decoded_metadata = QString::fromUtf8(inbound_metadata.data());
-                #if defined(__GNUC__)
-                RexAssetMetadata *m = dynamic_cast<RexAssetMetadata*>(ready_asset_ptr.get()->GetMetadata());
-                #else	   
-                Foundation::AssetMetadataInterface *metadata = ready_asset_ptr.get()->GetMetadata();
-                RexAssetMetadata *m = static_cast<RexAssetMetadata*>(metadata);
-                #endif
-                std::string std_md(decoded_metadata.toStdString());
-                m->DesesrializeFromJSON(std_md); // TODO: implement a xml based metadata parser.
-                */
-
-                AssetModule::LogDebug("HTTP asset " + transfer_data.id.toStdString() + " completed with metadata");
-
-                // Store asset
-                boost::shared_ptr<Foundation::AssetServiceInterface> asset_service = framework_->GetServiceManager()->GetService<Foundation::AssetServiceInterface>(Service::ST_Asset).lock();
-                if (asset_service)
-                    asset_service->StoreAsset(ready_asset_ptr);
-
-                // Send asset ready events
-                foreach (request_tag_t tag, transfer_data.tags)
-                {
-                    Events::AssetReady event_data(ready_asset_ptr.get()->GetId(), ready_asset_ptr.get()->GetType(), ready_asset_ptr, tag);
-                    event_manager_->SendEvent(asset_event_category_, Events::ASSET_READY, &event_data);
-                }
-
-                RemoveFinishedTransfers(transfer_data.id, metadata_transfer_url);
-                StartTransferFromQueue();
             }
         }
-        reply->deleteLater();
     }
 
-    void QtHttpAssetProvider::RemoveFinishedTransfers(QString asset_transfer_key, QUrl metadata_transfer_key)
+    void QtHttpAssetProvider::StartTransfer(QtHttpAssetTransfer *transfer)
     {
-        QtHttpAssetTransfer *remove_transfer = assetid_to_transfer_map_[asset_transfer_key];
-        assetid_to_transfer_map_.remove(asset_transfer_key);
-        if (metadata_transfer_key.isValid())
-            metadata_to_assetptr_.remove(metadata_transfer_key);
-        SAFE_DELETE(remove_transfer);
+        ++hosts_[transfer->GetHost()].active;
+        QNetworkReply *reply = network_manager_->get(*transfer);
+        transfer->SetReply(reply);
+        replies_[reply] = transfer;
+
+        if (AssetModule::IsLogEnabled(Poco::Message::PRIO_DEBUG))
+            AssetModule::LogDebug("New HTTP asset request: " + transfer->GetTranferInfo().id.toStdString() + " type: " +
+                RexTypes::GetAssetTypeString(transfer->GetTranferInfo().type));
     }
 
-    void QtHttpAssetProvider::ClearAllTransfers()
+    void QtHttpAssetProvider::AbortTransfer(QtHttpAssetTransfer *transfer, bool send_canceled_event)
     {
-        foreach (QtHttpAssetTransfer *transfer, assetid_to_transfer_map_.values())
-            SAFE_DELETE(transfer);
-        assetid_to_transfer_map_.clear();
+        HttpAssetTransferInfo transfer_info = transfer->GetTranferInfo();
+        ++stats_[transfer->GetPriority()].canceled;
 
-        foreach (QtHttpAssetTransfer *transfer, pending_request_queue_)
-            SAFE_DELETE(transfer);
-        pending_request_queue_.clear();
+        QNetworkReply *reply = transfer->GetReply();
+        RemoveTransfer(transfer);
+        if (reply)
+            reply->abort();
+
+        if (send_canceled_event)
+        {
+            Events::AssetCanceled *data = new Events::AssetCanceled(transfer_info.id.toStdString(), RexTypes::GetAssetTypeString(transfer_info.type));
+            event_manager_->SendDelayedEvent(asset_event_category_, Events::ASSET_CANCELED, EventDataPtr(data), 0);
+        }
     }
 
-    void QtHttpAssetProvider::StartTransferFromQueue()
+    void QtHttpAssetProvider::RemoveTransfer(QtHttpAssetTransfer *transfer)
     {
-        if (pending_request_queue_.count() == 0)
-            return;
-
-        // If the whole map is empty then go and start new MAX_HTTP_CONNECTIONS amount of http gets
-        if (assetid_to_transfer_map_.count() == 0)
-            filling_stack_ = true;
+        transfers_.remove(transfer->GetTranferInfo().id);
 
-        if (!filling_stack_)
-            return;
-
-        if (assetid_to_transfer_map_.count() <= MAX_HTTP_CONNECTIONS && pending_request_queue_.count() > 0)
+        QHash<QString, HostQueue>::iterator i = hosts_.find(transfer->GetHost());
+        if (i != hosts_.end())
         {
-            if (assetid_to_transfer_map_.count() == MAX_HTTP_CONNECTIONS || pending_request_queue_.count() == 0)
-                filling_stack_ = false; 
-            else
+            HostQueue &host = i.value();
+            if (transfer->GetReply())
             {
-                QtHttpAssetTransfer *new_transfer = pending_request_queue_.takeAt(0);
-                assetid_to_transfer_map_[new_transfer->GetTranferInfo().id] = new_transfer;
-                network_manager_->get(*new_transfer);
-
-                AssetModule::LogDebug("New HTTP asset request from queue: " + new_transfer->GetTranferInfo().id.toStdString() + " type: " + RexTypes::GetAssetTypeString(new_transfer->GetTranferInfo().type));
-                StartTransferFromQueue(); // Recursivly fill the transfer map
+                replies_.remove(transfer->GetReply());
+                --host.active;
             }
+            else
+                host.pending[transfer->GetPriority()].removeOne(transfer);
+
+            bool empty = host.active <= 0;
+            for (int j = 0; j < HttpPriorityCount; ++j)
+                empty = empty && host.pending[j].isEmpty();
+            if (empty)
+                hosts_.erase(i);
         }
+
+        if (--outstanding_[transfer->GetPriority()] == 0 && transfer->GetPriority() == HttpPriorityVisible && visible_ready_time_ < 0.0)
+            visible_ready_time_ = SecondsSince(burst_start_);
+
+        SAFE_DELETE(transfer);
     }
 
-    bool QtHttpAssetProvider::CheckRequestQueue(QString assed_id)
+    double QtHttpAssetProvider::SecondsSince(tick_t time)
     {
-        foreach (QtHttpAssetTransfer *transfer, pending_request_queue_)
-            if (transfer->GetTranferInfo().id == assed_id)
-                return true;
-        return false;
+        return (GetCurrentClockTime() - time) / (double)GetCurrentClockFreq();
     }
 
     bool QtHttpAssetProvider::IsAcceptableAssetType(const std::string& asset_type)
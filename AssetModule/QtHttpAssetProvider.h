@@ -9,12 +9,18 @@
 
 #include <QNetworkAccessManager>
 #include <QObject>
-#include <QMap>
-#include <QPair>
+#include <QHash>
+#include <QList>
 #include <QUrl>
 
 namespace Asset
 {
+    //! Fetches assets over HTTP.
+    /*! Requests are queued by priority class (see HttpFetchPriority) and started only as far as the connection
+        limits allow: at most http_max_connections in total and http_max_connections_per_host to each host.
+        The same QNetworkAccessManager is used for everything, so the requests to a host reuse its kept-alive
+        connections. A request for an asset that is already queued or being fetched only adds its tag.
+     */
     class QtHttpAssetProvider : public QObject, public Foundation::AssetProviderInterface
     {
 
@@ -27,6 +33,12 @@ namespace Asset
         void SetGetTextureCap(std::string url);
         void ClearAllTransfers();
 
+        //! Returns fetch statistics, see HttpAssetStats console command
+        std::string GetStatsReport() const;
+
+        //! Resets fetch statistics
+        void ResetStats();
+
         //! Interface implementation
         void Update(f64 frametime);
 
@@ -34,6 +46,7 @@ namespace Asset
         bool IsValidId(const std::string& asset_id, const std::string& asset_type);
         
         bool RequestAsset(const std::string& asset_id, const std::string& asset_type, request_tag_t tag);
+        bool CancelRequest(const std::string& asset_id, request_tag_t tag);
         bool InProgress(const std::string& asset_id);
         bool QueryAssetStatus(const std::string& asset_id, uint& size, uint& received, uint& received_continuous);
 
@@ -43,13 +56,48 @@ namespace Asset
     private slots:
         QUrl CreateUrl(QString assed_id);
         void TranferCompleted(QNetworkReply *reply);
-        void RemoveFinishedTransfers(QString asset_transfer_key, QUrl metadata_transfer_key);
         void StartTransferFromQueue();
 
-        bool CheckRequestQueue(QString assed_id);
         bool IsAcceptableAssetType(const std::string& asset_type);
 
     private:
+        //! Transfers of one host
+        struct HostQueue
+        {
+            HostQueue() : active(0) {}
+            //! Number of started transfers
+            int active;
+            //! Queued transfers by priority class
+            QList<QtHttpAssetTransfer *> pending[HttpPriorityCount];
+        };
+
+        //! Statistics of a priority class
+        struct FetchStats
+        {
+            FetchStats() : requested(0), completed(0), failed(0), canceled(0), wait_time(0.0), fetch_time(0.0), max_fetch_time(0.0) {}
+            uint requested;
+            uint completed;
+            uint failed;
+            uint canceled;
+            //! Total seconds from request to start
+            double wait_time;
+            //! Total seconds from request to completion
+            double fetch_time;
+            double max_fetch_time;
+        };
+
+        //! Sends the request of a queued transfer
+        void StartTransfer(QtHttpAssetTransfer *transfer);
+
+        //! Stops a transfer that is no longer needed or timed out
+        void AbortTransfer(QtHttpAssetTransfer *transfer, bool send_canceled_event);
+
+        //! Forgets a transfer and deletes it
+        void RemoveTransfer(QtHttpAssetTransfer *transfer);
+
+        //! Returns seconds since a time
+        static double SecondsSince(tick_t time);
+
         Foundation::Framework *framework_;
         EventManager *event_manager_;
         const std::string name_;
@@ -57,14 +105,23 @@ namespace Asset
         
         event_category_id_t asset_event_category_;
         f64 asset_timeout_;
-
-        QMap<QString, QtHttpAssetTransfer *> assetid_to_transfer_map_;
-        QMap<QUrl, QPair<HttpAssetTransferInfo, Foundation::AssetPtr> > metadata_to_assetptr_;
-        QList<QtHttpAssetTransfer *> pending_request_queue_;
-
-        bool filling_stack_;
-        bool fake_metadata_fetch_;
-        QUrl fake_metadata_url_;
+        int max_connections_;
+        int max_host_connections_;
+
+        //! All queued and started transfers by asset id
+        QHash<QString, QtHttpAssetTransfer *> transfers_;
+        //! Started transfers by reply
+        QHash<QNetworkReply *, QtHttpAssetTransfer *> replies_;
+        //! Transfers by host
+        QHash<QString, HostQueue> hosts_;
+
+        //! Number of transfers not yet finished, by priority class
+        int outstanding_[HttpPriorityCount];
+        FetchStats stats_[HttpPriorityCount];
+        //! Time when the latest burst of requests started with no transfers in progress
+        tick_t burst_start_;
+        //! Seconds from burst start until all its visible assets were fetched, negative while fetching
+        double visible_ready_time_;
 
         QUrl get_texture_cap_;
 
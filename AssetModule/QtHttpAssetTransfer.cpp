@@ -5,6 +5,26 @@
 
 namespace Asset
 {
+    HttpFetchPriority GetHttpFetchPriority(asset_type_t asset_type)
+    {
+        using namespace RexTypes;
+
+        switch (asset_type)
+        {
+            case RexAT_Texture:
+            case RexAT_TextureJPEG:
+            case RexAT_Mesh:
+            case RexAT_MaterialScript:
+            case RexAT_Image:
+                return HttpPriorityVisible;
+            case RexAT_SoundVorbis:
+            case RexAT_SoundWav:
+                return HttpPrioritySound;
+            default:
+                return HttpPriorityOther;
+        }
+    }
+
     // ==========================================================
     // HttpAssetTransferInfo
 
@@ -32,14 +52,34 @@ namespace Asset
         tags.append(tag);
     }
 
+    bool HttpAssetTransferInfo::RemoveTag(request_tag_t tag)
+    {
+        return tags.removeOne(tag);
+    }
+
     // ==========================================================
     // QtHttpAssetTransfer
 
     QtHttpAssetTransfer::QtHttpAssetTransfer(QUrl asset_url, QString asset_id, asset_type_t asset_type, request_tag_t tag) :
         QObject(0),
         QNetworkRequest(asset_url),
-        transfer_info_(asset_url, asset_id, asset_type)
+        transfer_info_(asset_url, asset_id, asset_type),
+        priority_(GetHttpFetchPriority(asset_type)),
+        reply_(0),
+        requested_(GetCurrentClockTime()),
+        started_(0)
     {
         transfer_info_.AddTag(tag);
+
+        // Keep the connection open for the following requests to the same host
+        setRawHeader("Connection", "Keep-Alive");
+
+#if QT_VERSION >= 0x040700
+        // Also let QNetworkAccessManager order the requests it has queued
+        if (priority_ == HttpPriorityVisible)
+            setPriority(QNetworkRequest::HighPriority);
+        else if (priority_ == HttpPriorityOther)
+            setPriority(QNetworkRequest::LowPriority);
+#endif
     }
-}
\ No newline at end of file
+}
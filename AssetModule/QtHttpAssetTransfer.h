@@ -4,20 +4,39 @@
 #define incl_Asset_QtHttpAssetTransfer_h
 
 #include "RexTypes.h"
+#include "HighPerfClock.h"
 
 #include <QObject>
 #include <QNetworkRequest>
 #include <QUrl>
 #include <QString>
 
+class QNetworkReply;
+
 namespace Asset
 {
+    //! Priority classes of the HTTP fetch queue, fetched in this order
+    enum HttpFetchPriority
+    {
+        //! Textures, meshes and materials, needed to draw the scene
+        HttpPriorityVisible = 0,
+        //! Sounds
+        HttpPrioritySound,
+        //! Everything else
+        HttpPriorityOther,
+        HttpPriorityCount
+    };
+
+    //! Returns the priority class of an asset type
+    HttpFetchPriority GetHttpFetchPriority(asset_type_t asset_type);
+
     struct HttpAssetTransferInfo
     {
         HttpAssetTransferInfo();
         HttpAssetTransferInfo(const HttpAssetTransferInfo &info);
         HttpAssetTransferInfo(QUrl asset_url, QString asset_id, asset_type_t asset_type);
         void AddTag(request_tag_t tag);
+        bool RemoveTag(request_tag_t tag);
 
         QUrl url;
         QString id;
@@ -32,12 +51,34 @@ namespace Asset
 
     public:
         QtHttpAssetTransfer(QUrl asset_url, QString asset_id, asset_type_t asset_type, request_tag_t tag);
-        HttpAssetTransferInfo GetTranferInfo() { return transfer_info_; }
+        HttpAssetTransferInfo &GetTranferInfo() { return transfer_info_; }
+
+        //! Returns the priority class of the transfer
+        HttpFetchPriority GetPriority() const { return priority_; }
+
+        //! Returns the host the asset is fetched from, used for the per host connection limit
+        QString GetHost() const { return transfer_info_.url.host(); }
+
+        //! Marks the transfer started with a reply from QNetworkAccessManager
+        void SetReply(QNetworkReply *reply) { reply_ = reply; started_ = GetCurrentClockTime(); }
+
+        //! Returns the reply of a started transfer, null if still queued
+        QNetworkReply *GetReply() const { return reply_; }
+
+        //! Returns time when the transfer was requested
+        tick_t GetRequestTime() const { return requested_; }
+
+        //! Returns time when the transfer was started, 0 if still queued
+        tick_t GetStartTime() const { return started_; }
 
     private:
         HttpAssetTransferInfo transfer_info_;
+        HttpFetchPriority priority_;
+        QNetworkReply *reply_;
+        tick_t requested_;
+        tick_t started_;
 
     };
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -11,6 +11,9 @@ namespace Asset
 {
     class AssetTransfer;
 
+    //! Asset data buffer shared between a transfer and the partial assets made of it
+    typedef boost::shared_ptr<std::vector<u8> > AssetDataBufferPtr;
+
     //! ReX asset. Implements the AssetInterface.
     /*! \ingroup AssetModuleClient
      */ 
@@ -68,6 +71,56 @@ namespace Asset
         //! asset age
         mutable f64 age_;
     };
+
+    //! Partial asset that shares the data of an unfinished transfer instead of copying it.
+    /*! Used for progressive decoding of textures. The shared part of the transfer buffer is not written to anymore,
+        so the view may be read from other threads while the transfer continues. Not stored to the asset cache.
+        \ingroup AssetModuleClient
+     */
+    class RexAssetView : public Foundation::AssetInterface
+    {
+    public:
+        //! constructor
+        /*! \param buffer Transfer buffer
+            \param size Number of bytes from the buffer beginning that belong to the view
+         */
+        RexAssetView(const std::string& asset_id, const std::string& asset_type, AssetDataBufferPtr buffer, uint size) :
+            asset_id_(asset_id), asset_type_(asset_type), buffer_(buffer), size_(size) {}
+
+        //! destructor
+        virtual ~RexAssetView() {};
+
+        //! returns asset ID
+        virtual const std::string& GetId() const { return asset_id_; }
+
+        //! returns asset type
+        virtual const std::string& GetType() const { return asset_type_; }
+
+        //! returns asset data size
+        virtual uint GetSize() const { return size_; }
+
+        //! returns asset data
+        virtual const u8* GetData() const { return &(*buffer_)[0]; }
+
+        //! returns asset metadata
+        virtual Foundation::AssetMetadataInterface* GetMetadata() const { return (Foundation::AssetMetadataInterface*)&metadata_; }
+
+    private:
+        //! asset id
+        std::string asset_id_;
+
+        //! asset type
+        std::string asset_type_;
+
+        //! shared transfer buffer
+        AssetDataBufferPtr buffer_;
+
+        //! size of the view
+        uint size_;
+
+        //! asset metadata
+        RexAssetMetadata metadata_;
+    };
 }
 
 #endif
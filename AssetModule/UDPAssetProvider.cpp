@@ -84,17 +84,11 @@ namespace Asset
     {
         UDPAssetTransfer* transfer = GetTransfer(asset_id);
 
-        if ((transfer) && (transfer->GetReceivedContinuous() >= received))
+        if ((transfer) && (transfer->GetBuffer()) && (transfer->GetReceivedContinuous() >= received))
         {
-            // Make new temporary asset for the incomplete data
-            RexAsset* new_asset = new RexAsset(transfer->GetAssetId(), GetTypeNameFromAssetType(transfer->GetAssetType()));
-            Foundation::AssetPtr asset_ptr(new_asset);
-            
-            RexAsset::AssetDataVector& data = new_asset->GetDataInternal();
-            data.resize(transfer->GetReceivedContinuous());
-            transfer->AssembleData(&data[0]);
-
-            return asset_ptr;
+            // Make new temporary asset that shares the continuous data received so far
+            return Foundation::AssetPtr(new RexAssetView(transfer->GetAssetId(), GetTypeNameFromAssetType(transfer->GetAssetType()),
+                transfer->GetBuffer(), transfer->GetReceivedContinuous()));
         }
 
         return Foundation::AssetPtr();
@@ -294,7 +288,8 @@ namespace Asset
         new_transfer.InsertTags(tags);
         texture_transfers_[asset_id] = new_transfer;
 
-        AssetModule::LogDebug("Requesting texture " + asset_id.ToString());
+        if (AssetModule::IsLogEnabled(Poco::Message::PRIO_DEBUG))
+            AssetModule::LogDebug("Requesting texture " + asset_id.ToString());
 
         ProtocolUtilities::NetOutMessage *m = net->StartMessageBuilding(RexNetMsgRequestImage);
         assert(m);
@@ -333,7 +328,8 @@ namespace Asset
         new_transfer.InsertTags(tags);
         asset_transfers_[transfer_id] = new_transfer;
 
-        AssetModule::LogDebug("Requesting asset " + asset_id_str);
+        if (AssetModule::IsLogEnabled(Poco::Message::PRIO_DEBUG))
+            AssetModule::LogDebug("Requesting asset " + asset_id_str);
 
         ProtocolUtilities::NetOutMessage *m = net->StartMessageBuilding(RexNetMsgTransferRequest);
         assert(m);
@@ -416,14 +412,16 @@ namespace Asset
         UNREFERENCED_PARAM(codec);
         u32 size = msg->ReadU32();
         u16 packets = msg->ReadU16();
-        UNREFERENCED_PARAM(packets);
 
-        transfer.SetSize(size);
+        transfer.SetSize(size, packets);
 
         size_t data_size;
         const u8* data = msg->ReadBuffer(&data_size); // ImageData block
         transfer.ReceiveData(0, data, data_size);
 
+        if (recorder_.IsOpen())
+            recorder_.RecordHeader(asset_id, size, packets, data, data_size);
+
         SendAssetProgress(transfer);
 
         if (transfer.Ready())
@@ -452,6 +450,9 @@ namespace Asset
         const u8* data = msg->ReadBuffer(&data_size); // ImageData block
         transfer.ReceiveData(packet_index, data, data_size);
 
+        if (recorder_.IsOpen())
+            recorder_.RecordPacket(asset_id, packet_index, data, data_size);
+
         SendAssetProgress(transfer);
 
         if (transfer.Ready())
@@ -624,8 +625,7 @@ namespace Asset
 
             Foundation::AssetPtr new_asset = Foundation::AssetPtr(new RexAsset(asset_id, GetTypeNameFromAssetType(transfer.GetAssetType())));
             RexAsset::AssetDataVector& data = checked_static_cast<RexAsset*>(new_asset.get())->GetDataInternal();
-            data.resize(transfer.GetReceived());
-            transfer.AssembleData(&data[0]);
+            transfer.TakeData(data);
 
             asset_service->StoreAsset(new_asset);
 
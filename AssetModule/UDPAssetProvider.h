@@ -4,6 +4,7 @@
 #define incl_Asset_UDPAssetProvider_h
 
 #include "UDPAssetTransfer.h"
+#include "UDPTextureStream.h"
 #include "AssetProviderInterface.h"
 
 namespace Asset
@@ -79,6 +80,14 @@ namespace Asset
         /// Clears all transfers.
         void ClearAllTransfers();
 
+        //! Starts recording the received texture transfer messages to a file, for BenchTextureStream
+        /*! \return false if the file could not be opened
+         */
+        bool StartRecording(const std::string& filename) { return recorder_.Open(filename); }
+
+        //! Stops recording, returns number of messages recorded
+        uint StopRecording() { recorder_.Close(); return recorder_.GetCount(); }
+
     private:
         //! Pending asset request. Used internally by UDPAssetProvider
         struct AssetRequest
@@ -204,6 +213,9 @@ namespace Asset
 
         //! Current Protocol Module
         boost::weak_ptr<ProtocolUtilities::ProtocolModuleInterface> protocolModule_;
+
+        //! Recorder of texture transfer messages
+        TextureStreamRecorder recorder_;
     };
 }
 
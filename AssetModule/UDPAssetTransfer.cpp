@@ -6,7 +6,12 @@ namespace Asset
 {
     UDPAssetTransfer::UDPAssetTransfer() :
         size_(0),
+        packets_(0),
         received_(0),
+        received_continuous_(0),
+        continuous_packets_(0),
+        first_packet_size_(0),
+        packet_size_(0),
         time_(0.0)
     {
     }
@@ -20,29 +25,35 @@ namespace Asset
         if (!size_) 
             return false; // No header received, size not known yet
         
-        return received_ >= size_;
+        return received_continuous_ >= size_;
     }
     
-    uint UDPAssetTransfer::GetReceivedContinuous() const
+    void UDPAssetTransfer::SetSize(uint size, uint packets)
     {
-        uint size = 0;
+        if (buffer_)
+        {
+            if (size != size_)
+                AssetModule::LogDebug("Ignoring changed size of asset " + asset_id_);
+            return;
+        }
         
-        DataPacketMap::const_iterator i = data_packets_.begin();
+        size_ = size;
+        packets_ = packets;
+        if (!size_)
+            return;
         
-        uint expected_index = 0;
-      
-        while (i != data_packets_.end())
+        buffer_ = AssetDataBufferPtr(new std::vector<u8>(size_));
+        
+        // Now that the packet count is known, the packets that came before the header may tell the packet size
+        DataPacketMap::const_iterator i = pending_packets_.begin();
+        while (i != pending_packets_.end())
         {
-            if (i->first != expected_index)
-                break;
-            
-            size += i->second.size();
-            
-            ++expected_index;
+            LearnPacketSize(i->first, i->second.size());
             ++i;
         }
         
-        return size;
+        PlacePendingData();
+        UpdateContinuous();
     }
     
     void UDPAssetTransfer::ReceiveData(uint packet_index, const u8* data, uint size)
@@ -55,34 +66,134 @@ namespace Asset
             return;
         }
         
-        if (!data_packets_[packet_index].size())
+        if ((packet_index < packet_sizes_.size()) && (packet_sizes_[packet_index]))
         {
-            data_packets_[packet_index].resize(size);
-            memcpy(&data_packets_[packet_index][0], data, size);
-            received_ += size;
+            AssetModule::LogDebug("Already received asset data packet index " + ToString<uint>(packet_index));
+            return;
         }
-        else
+        
+        if (packet_index >= packet_sizes_.size())
+            packet_sizes_.resize(packet_index + 1, 0);
+        packet_sizes_[packet_index] = size;
+        received_ += size;
+        
+        LearnPacketSize(packet_index, size);
+        
+        if (PlaceData(packet_index, data, size))
         {
-            AssetModule::LogDebug("Already received asset data packet index " + ToString<uint>(packet_index));
+            // The packet may have told the offsets of the packets waiting for them
+            if (!pending_packets_.empty())
+                PlacePendingData();
         }
+        else
+            pending_packets_[packet_index].assign(data, data + size);
+        
+        UpdateContinuous();
     }
     
     void UDPAssetTransfer::AssembleData(u8* buffer) const
     {
-        DataPacketMap::const_iterator i = data_packets_.begin();
+        if ((buffer_) && (received_continuous_))
+            memcpy(buffer, &(*buffer_)[0], received_continuous_);
+    }
+    
+    void UDPAssetTransfer::TakeData(std::vector<u8>& data)
+    {
+        data.clear();
+        if (!buffer_)
+            return;
+        
+        // Partial assets given to the decoder may still be using the buffer
+        if (buffer_.unique())
+            data.swap(*buffer_);
+        else
+            data.assign(buffer_->begin(), buffer_->end());
+        
+        data.resize(received_continuous_);
+        buffer_.reset();
+    }
+    
+    void UDPAssetTransfer::LearnPacketSize(uint packet_index, uint size)
+    {
+        if (!packet_index)
+        {
+            first_packet_size_ = size;
+            // Without a packet count all packets are of the same size, except the last one
+            if (!packets_)
+                packet_size_ = size;
+        }
+        else if ((!packet_size_) && (packets_) && (packet_index + 1 < packets_))
+            packet_size_ = size;
+    }
+    
+    bool UDPAssetTransfer::GetPacketOffset(uint packet_index, uint& offset) const
+    {
+        if (!packet_index)
+        {
+            offset = 0;
+            return true;
+        }
+        
+        if (!first_packet_size_)
+            return false;
+        
+        if (packet_index == 1)
+        {
+            offset = first_packet_size_;
+            return true;
+        }
+        
+        if (!packet_size_)
+            return false;
+        
+        offset = first_packet_size_ + (packet_index - 1) * packet_size_;
+        return true;
+    }
+    
+    bool UDPAssetTransfer::PlaceData(uint packet_index, const u8* data, uint size)
+    {
+        uint offset;
+        if ((!buffer_) || (!GetPacketOffset(packet_index, offset)))
+            return false;
+        
+        if ((offset >= size_) || (size > size_ - offset))
+        {
+            AssetModule::LogDebug("Asset data packet index " + ToString<uint>(packet_index) + " does not fit in asset " + asset_id_);
+            // Forget the packet, so that it doesn't count as received
+            packet_sizes_[packet_index] = 0;
+            received_ -= size;
+            return true;
+        }
         
-        uint expected_index = 0;
-      
-        while (i != data_packets_.end())
+        memcpy(&(*buffer_)[offset], data, size);
+        return true;
+    }
+    
+    void UDPAssetTransfer::PlacePendingData()
+    {
+        DataPacketMap::iterator i = pending_packets_.begin();
+        while (i != pending_packets_.end())
         {
-            if (i->first != expected_index)
+            if (PlaceData(i->first, &i->second[0], i->second.size()))
+                pending_packets_.erase(i++);
+            else
+                ++i;
+        }
+    }
+    
+    void UDPAssetTransfer::UpdateContinuous()
+    {
+        while ((continuous_packets_ < packet_sizes_.size()) && (packet_sizes_[continuous_packets_]))
+        {
+            if ((!pending_packets_.empty()) && (pending_packets_.find(continuous_packets_) != pending_packets_.end()))
                 break;
             
-            memcpy(buffer, &i->second[0], i->second.size());
-            buffer += i->second.size();
+            uint offset;
+            if (!GetPacketOffset(continuous_packets_, offset))
+                break;
             
-            ++expected_index;
-            ++i;
+            received_continuous_ = offset + packet_sizes_[continuous_packets_];
+            ++continuous_packets_;
         }
     }
-}
\ No newline at end of file
+}
@@ -4,9 +4,21 @@
 #define incl_Asset_UDPAssetTransfer_h
 
 #include "CoreTypes.h"
+#include "RexAsset.h"
+
 namespace Asset
 {
     //! Stores data related to an UDP asset transfer that is in progress. Not necessary to clients of the AssetModule.
+    /*! The data is received to one buffer that is allocated when the asset size becomes known. Packets are copied
+        directly to their place in the buffer, so the received data never needs to be assembled. Bytes before
+        GetReceivedContinuous() are not written again, so partial assets may share the buffer while the transfer
+        continues, see GetBuffer().
+
+        Packet offsets are known from the size of the first packet and the size of the packets after it. The two
+        are the same for asset transfers. For image transfers they differ, and the packet size is learned from the
+        first packet that is neither the first nor the last one. Packets received before their offset is known,
+        or before the asset size is known, are kept aside until they can be placed.
+     */
     class UDPAssetTransfer
     {
     public:
@@ -30,6 +42,19 @@ namespace Asset
          */
         void AssembleData(u8* buffer) const;
         
+        //! Returns the buffer the asset is received to, null if the asset size is not known yet
+        /*! The first GetReceivedContinuous() bytes are final and may be read, also from other threads,
+            while the transfer continues. The buffer is never resized.
+         */
+        const AssetDataBufferPtr& GetBuffer() const { return buffer_; }
+        
+        //! Takes the buffer of a finished transfer
+        /*! Swaps the data into a vector without copying if no partial asset shares the buffer anymore,
+            otherwise copies it. The transfer has no data afterwards.
+            \param data Vector that receives the asset data
+         */
+        void TakeData(std::vector<u8>& data);
+        
         //! Sets asset ID
         /*! \param asset_id Asset id
          */
@@ -40,11 +65,13 @@ namespace Asset
          */
         void SetAssetType(uint asset_type) { asset_type_ = asset_type; }
         
-        //! Sets asset size
+        //! Sets asset size and allocates the receive buffer
         /*! Called when asset transfer header received
             \param size Asset size in bytes
+            \param packets Number of packets if the header tells it. When given, the first packet
+                   may be of different size than the rest, as in image transfers.
          */
-        void SetSize(uint size) { size_ = size; }
+        void SetSize(uint size, uint packets = 0);
         
         //! Adds elapsed time
         /*! \param delta_time Amount of time to add
@@ -79,7 +106,7 @@ namespace Asset
         uint GetReceived() const { return received_; }
         
         //! Returns total size of continuous data from the asset beginning received so far
-        uint GetReceivedContinuous() const;
+        uint GetReceivedContinuous() const { return received_continuous_; }
         
         //! Returns elapsed time since last packet
         f64 GetTime() const { return time_; }
@@ -90,6 +117,21 @@ namespace Asset
     private:
         typedef std::map<uint, std::vector<u8> > DataPacketMap;
         
+        //! Learns the packet sizes from a received packet
+        void LearnPacketSize(uint packet_index, uint size);
+        
+        //! Returns byte offset of a packet in the asset, false if not known yet
+        bool GetPacketOffset(uint packet_index, uint& offset) const;
+        
+        //! Copies a packet to its place in the buffer. Returns false if its place is not known yet.
+        bool PlaceData(uint packet_index, const u8* data, uint size);
+        
+        //! Places the packets that were received before their offset was known
+        void PlacePendingData();
+        
+        //! Advances the continuous data count over the placed packets
+        void UpdateContinuous();
+        
         //! Asset ID
         std::string asset_id_;
         
@@ -99,11 +141,32 @@ namespace Asset
         //! Expected size
         uint size_;
         
+        //! Number of packets, 0 if not known. Only known for image transfers.
+        uint packets_;
+        
         //! Received bytes
         uint received_;
         
-        //! Map of data packets
-        DataPacketMap data_packets_;
+        //! Continuous bytes placed in the buffer from the asset beginning
+        uint received_continuous_;
+        
+        //! Number of continuous packets placed in the buffer from the asset beginning
+        uint continuous_packets_;
+        
+        //! Size of the first packet, 0 if not received yet
+        uint first_packet_size_;
+        
+        //! Size of the packets after the first one, except the last, 0 if not known yet
+        uint packet_size_;
+        
+        //! Asset data, allocated to the full size when the size is known
+        AssetDataBufferPtr buffer_;
+        
+        //! Size of each received packet by packet index, 0 if not received
+        std::vector<uint> packet_sizes_;
+        
+        //! Packets received before their place in the buffer was known
+        DataPacketMap pending_packets_;
         
         //! Elapsed time since last packet
         f64 time_;
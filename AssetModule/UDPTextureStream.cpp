@@ -0,0 +1,272 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+
+#include "StableHeaders.h"
+#include "UDPTextureStream.h"
+#include "UDPAssetTransfer.h"
+#include "RexAsset.h"
+#include "RexTypes.h"
+#include "HighPerfClock.h"
+
+namespace Asset
+{
+    bool TextureStreamRecorder::Open(const std::string& filename)
+    {
+        Close();
+        file_.open(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        count_ = 0;
+        return file_.is_open();
+    }
+
+    void TextureStreamRecorder::Close()
+    {
+        if (file_.is_open())
+            file_.close();
+    }
+
+    void TextureStreamRecorder::RecordHeader(const RexUUID& asset_id, uint size, uint packets, const u8* data, uint data_size)
+    {
+        TextureStreamRecord record;
+        record.asset_id_ = asset_id;
+        record.header_ = true;
+        record.size_ = size;
+        record.packets_ = packets;
+        record.packet_index_ = 0;
+        Write(record, data, data_size);
+    }
+
+    void TextureStreamRecorder::RecordPacket(const RexUUID& asset_id, uint packet_index, const u8* data, uint data_size)
+    {
+        TextureStreamRecord record;
+        record.asset_id_ = asset_id;
+        record.header_ = false;
+        record.size_ = 0;
+        record.packets_ = 0;
+        record.packet_index_ = packet_index;
+        Write(record, data, data_size);
+    }
+
+    void TextureStreamRecorder::Write(const TextureStreamRecord& record, const u8* data, uint data_size)
+    {
+        // Record: header flag, asset id, size, packet count, packet index, data size, data
+        u8 header = record.header_ ? 1 : 0;
+        u32 fields[4] = { record.size_, record.packets_, record.packet_index_, data_size };
+        file_.write((const char*)&header, 1);
+        file_.write((const char*)record.asset_id_.data, 16);
+        file_.write((const char*)fields, sizeof(fields));
+        if (data_size)
+            file_.write((const char*)data, data_size);
+        ++count_;
+    }
+
+    bool LoadTextureStream(const std::string& filename, TextureStreamRecordVector& records)
+    {
+        std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+        if (!file.is_open())
+            return false;
+
+        for(;;)
+        {
+            TextureStreamRecord record;
+            u8 header = 0;
+            u32 fields[4];
+            if (!file.read((char*)&header, 1))
+                break;
+            if ((!file.read((char*)record.asset_id_.data, 16)) || (!file.read((char*)fields, sizeof(fields))))
+                return false;
+
+            record.header_ = header != 0;
+            record.size_ = fields[0];
+            record.packets_ = fields[1];
+            record.packet_index_ = fields[2];
+            record.data_.resize(fields[3]);
+            if ((fields[3]) && (!file.read((char*)&record.data_[0], fields[3])))
+                return false;
+
+            records.push_back(record);
+        }
+
+        return true;
+    }
+
+    namespace
+    {
+        //! Packet map reassembly the way UDPAssetTransfer did it before, for comparison
+        class PacketMapTransfer
+        {
+        public:
+            PacketMapTransfer() : size_(0), received_(0) {}
+
+            void SetSize(uint size, uint packets) { size_ = size; }
+            bool Ready() const { return (size_) && (received_ >= size_); }
+            uint GetSize() const { return size_; }
+
+            void ReceiveData(uint packet_index, const u8* data, uint size)
+            {
+                std::vector<u8>& packet = packets_[packet_index];
+                if (!packet.size())
+                {
+                    packet.assign(data, data + size);
+                    received_ += size;
+                }
+            }
+
+            uint GetReceivedContinuous() const
+            {
+                uint size = 0;
+                uint expected_index = 0;
+                for(std::map<uint, std::vector<u8> >::const_iterator i = packets_.begin(); i != packets_.end() && i->first == expected_index; ++i, ++expected_index)
+                    size += i->second.size();
+                return size;
+            }
+
+            void AssembleData(u8* buffer) const
+            {
+                uint expected_index = 0;
+                for(std::map<uint, std::vector<u8> >::const_iterator i = packets_.begin(); i != packets_.end() && i->first == expected_index; ++i, ++expected_index)
+                {
+                    memcpy(buffer, &i->second[0], i->second.size());
+                    buffer += i->second.size();
+                }
+            }
+
+        private:
+            std::map<uint, std::vector<u8> > packets_;
+            uint size_;
+            uint received_;
+        };
+
+        //! Data size a progressive decoder asks for before decoding a quality level, see TextureRequest::EstimateDataSize
+        uint GetLevelSize(uint size, int level)
+        {
+            if (!level)
+                return size;
+            return std::min(size, std::max(600u, size >> (2 * level)));
+        }
+
+        const int LEVELS = 6;
+
+        struct ReplayStats
+        {
+            ReplayStats() : textures(0), partials(0), copied(0), time(0.0) {}
+            uint textures;
+            uint partials;
+            u64 copied;
+            double time;
+        };
+
+        //! Replays the records through a transfer type, taking partial assets like TextureService would
+        template <typename Transfer, typename TakePartial, typename TakeFull>
+        void Replay(const TextureStreamRecordVector& records, TakePartial take_partial, TakeFull take_full, ReplayStats& stats)
+        {
+            typedef std::map<RexUUID, std::pair<Transfer, int> > TransferMap;
+            TransferMap transfers;
+            std::set<RexUUID> finished;
+
+            tick_t start = GetCurrentClockTime();
+            for(uint i = 0; i < records.size(); ++i)
+            {
+                const TextureStreamRecord& record = records[i];
+                if (finished.find(record.asset_id_) != finished.end())
+                    continue;
+
+                typename TransferMap::iterator t = transfers.find(record.asset_id_);
+                if (t == transfers.end())
+                    t = transfers.insert(std::make_pair(record.asset_id_, std::make_pair(Transfer(), LEVELS - 1))).first;
+                Transfer& transfer = t->second.first;
+                int& level = t->second.second;
+
+                if (record.header_)
+                    transfer.SetSize(record.size_, record.packets_);
+                if (record.data_.size())
+                    transfer.ReceiveData(record.packet_index_, &record.data_[0], record.data_.size());
+
+                if (transfer.Ready())
+                {
+                    stats.copied += take_full(transfer);
+                    ++stats.textures;
+                    finished.insert(record.asset_id_);
+                    transfers.erase(t);
+                    continue;
+                }
+
+                while ((level > 0) && (transfer.GetSize()) && (transfer.GetReceivedContinuous() >= GetLevelSize(transfer.GetSize(), level)))
+                {
+                    stats.copied += take_partial(transfer);
+                    ++stats.partials;
+                    --level;
+                }
+            }
+            stats.time += (GetCurrentClockTime() - start) / (double)GetCurrentClockFreq();
+        }
+
+        struct PacketMapPartial
+        {
+            uint operator()(PacketMapTransfer& transfer)
+            {
+                RexAsset asset("", RexTypes::ASSETTYPENAME_TEXTURE);
+                RexAsset::AssetDataVector& data = asset.GetDataInternal();
+                data.resize(transfer.GetReceivedContinuous());
+                transfer.AssembleData(&data[0]);
+                return data.size();
+            }
+        };
+
+        struct PacketMapFull
+        {
+            uint operator()(PacketMapTransfer& transfer)
+            {
+                RexAsset asset("", RexTypes::ASSETTYPENAME_TEXTURE);
+                RexAsset::AssetDataVector& data = asset.GetDataInternal();
+                data.resize(transfer.GetSize());
+                transfer.AssembleData(&data[0]);
+                return data.size();
+            }
+        };
+
+        struct BufferPartial
+        {
+            uint operator()(UDPAssetTransfer& transfer)
+            {
+                Foundation::AssetPtr asset(new RexAssetView("", RexTypes::ASSETTYPENAME_TEXTURE, transfer.GetBuffer(), transfer.GetReceivedContinuous()));
+                return 0;
+            }
+        };
+
+        struct BufferFull
+        {
+            uint operator()(UDPAssetTransfer& transfer)
+            {
+                RexAsset asset("", RexTypes::ASSETTYPENAME_TEXTURE);
+                transfer.TakeData(asset.GetDataInternal());
+                return 0;
+            }
+        };
+
+        std::string FormatStats(const std::string& name, const ReplayStats& stats, uint rounds)
+        {
+            return name + ": " + ToString<uint>(stats.textures / rounds) + " textures, " + ToString<uint>(stats.partials / rounds) +
+                " partial assets, " + ToString<double>(stats.time * 1000.0 / rounds) + " ms, " +
+                ToString<u64>(stats.copied / rounds) + " bytes copied to assets per round";
+        }
+    }
+
+    std::string BenchTextureStream(const TextureStreamRecordVector& records, uint rounds)
+    {
+        u64 packet_bytes = 0;
+        for(uint i = 0; i < records.size(); ++i)
+            packet_bytes += records[i].data_.size();
+
+        ReplayStats map_stats;
+        ReplayStats buffer_stats;
+        for(uint i = 0; i < rounds; ++i)
+        {
+            Replay<PacketMapTransfer>(records, PacketMapPartial(), PacketMapFull(), map_stats);
+            Replay<UDPAssetTransfer>(records, BufferPartial(), BufferFull(), buffer_stats);
+        }
+
+        return "Replayed " + ToString<uint>(records.size()) + " messages, " + ToString<u64>(packet_bytes) + " bytes, " +
+            ToString<uint>(rounds) + " rounds\n" +
+            FormatStats("Packet map", map_stats, rounds) + "\n" +
+            FormatStats("Contiguous buffer", buffer_stats, rounds);
+    }
+}
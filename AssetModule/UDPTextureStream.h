@@ -0,0 +1,79 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+
+#ifndef incl_Asset_UDPTextureStream_h
+#define incl_Asset_UDPTextureStream_h
+
+#include "CoreTypes.h"
+#include "RexUUID.h"
+
+#include <fstream>
+
+namespace Asset
+{
+    //! One recorded UDP image transfer message
+    struct TextureStreamRecord
+    {
+        //! Texture asset id
+        RexUUID asset_id_;
+        //! Whether this is the header (ImageData) message. The header carries the first packet.
+        bool header_;
+        //! Asset size, header only
+        uint size_;
+        //! Number of packets, header only
+        uint packets_;
+        //! Packet index
+        uint packet_index_;
+        //! Packet data
+        std::vector<u8> data_;
+    };
+
+    typedef std::vector<TextureStreamRecord> TextureStreamRecordVector;
+
+    //! Writes the UDP image transfer messages to a file, to be replayed later by BenchTextureStream
+    class TextureStreamRecorder
+    {
+    public:
+        //! Constructor
+        TextureStreamRecorder() : count_(0) {}
+
+        //! Starts recording to a file, returns false if the file could not be opened
+        bool Open(const std::string& filename);
+
+        //! Stops recording
+        void Close();
+
+        //! Returns whether recording
+        bool IsOpen() const { return file_.is_open(); }
+
+        //! Returns number of messages recorded
+        uint GetCount() const { return count_; }
+
+        //! Records a header message and the first packet
+        void RecordHeader(const RexUUID& asset_id, uint size, uint packets, const u8* data, uint data_size);
+
+        //! Records a data packet
+        void RecordPacket(const RexUUID& asset_id, uint packet_index, const u8* data, uint data_size);
+
+    private:
+        void Write(const TextureStreamRecord& record, const u8* data, uint data_size);
+
+        std::ofstream file_;
+        uint count_;
+    };
+
+    //! Reads a file written by TextureStreamRecorder
+    /*! \return false if the file could not be read
+     */
+    bool LoadTextureStream(const std::string& filename, TextureStreamRecordVector& records);
+
+    //! Replays a recorded texture stream through the UDP transfer reassembly, and for comparison
+    //! through a packet map that is assembled by copying, like the transfers did before.
+    /*! Partial assets are taken at the data sizes a progressive decoder would ask for, one for each
+        quality level, as TextureService does.
+        \param rounds How many times to replay the stream
+        \return Report of times and bytes copied
+     */
+    std::string BenchTextureStream(const TextureStreamRecordVector& records, uint rounds);
+}
+
+#endif
@@ -7,6 +7,12 @@
 #define EXPORT_CONFIGURATION
 #endif
 
+//! Least important log priority that is compiled in, from 1 (fatal) to 8 (trace). The logging functions
+//! of less important priorities compile to nothing, and so do the messages formatted inside an IsLogEnabled() check.
+#ifndef NAALI_LOG_LEVEL
+#define NAALI_LOG_LEVEL 8
+#endif
+
 #endif
 
 
@@ -0,0 +1,418 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+
+#include "StableHeaders.h"
+#include "CoreNumberFormat.h"
+
+#include <boost/cstdint.hpp>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    //! Powers of ten that are exactly representable as doubles.
+    const double exactPowersOfTen[] =
+    {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    const int maxExactPowerOfTen = 22;
+
+    //! Returns 10^exponent. Exact for |exponent| <= 22.
+    double PowerOfTen(int exponent)
+    {
+        if (exponent >= 0 && exponent <= maxExactPowerOfTen)
+            return exactPowersOfTen[exponent];
+        return std::pow(10.0, exponent);
+    }
+
+    //! Returns mantissa * 10^exponent, dividing by an exact power of ten for negative exponents to keep a single rounding when possible.
+    double ComposeDouble(boost::uint64_t mantissa, int exponent)
+    {
+        double m = (double)mantissa;
+        if (exponent >= 0)
+            return m * PowerOfTen(exponent);
+        if (-exponent <= maxExactPowerOfTen)
+            return m / exactPowersOfTen[-exponent];
+        // Very small values: split the scaling so that the intermediate result does not underflow.
+        return (m / exactPowersOfTen[maxExactPowerOfTen]) / PowerOfTen(-exponent - maxExactPowerOfTen);
+    }
+
+    //! Converts a double to float, saturating to infinity instead of relying on out-of-range conversion.
+    float ToFloat(double value)
+    {
+        // Values below FLT_MAX + half an ulp still round to FLT_MAX.
+        const double overflowThreshold = 3.4028235677973366e38;
+        if (value >= overflowThreshold)
+            return std::numeric_limits<float>::infinity();
+        if (value <= -overflowThreshold)
+            return -std::numeric_limits<float>::infinity();
+        return (float)value;
+    }
+
+    bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+    bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+    char ToLower(char c) { return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c; }
+
+    //! Returns true if [begin, end[ starts with the given lowercase keyword, case-insensitively.
+    bool StartsWithKeyword(const char *begin, const char *end, const char *keyword)
+    {
+        size_t len = strlen(keyword);
+        if ((size_t)(end - begin) < len)
+            return false;
+        for(size_t i = 0; i < len; ++i)
+            if (ToLower(begin[i]) != keyword[i])
+                return false;
+        return true;
+    }
+
+    const char *SkipSpace(const char *str, const char *end)
+    {
+        while(str < end && IsSpace(*str))
+            ++str;
+        return str;
+    }
+
+    //! Writes the decimal digits of value in reverse order. Returns the number of digits.
+    size_t WriteDigitsReversed(boost::uint64_t value, char *buffer)
+    {
+        size_t n = 0;
+        do
+        {
+            buffer[n++] = (char)('0' + (value % 10));
+            value /= 10;
+        } while(value != 0);
+        return n;
+    }
+
+    //! Writes the decimal digits of value. Returns the number of digits.
+    size_t WriteDigits(boost::uint64_t value, char *buffer)
+    {
+        char reversed[24];
+        size_t n = WriteDigitsReversed(value, reversed);
+        for(size_t i = 0; i < n; ++i)
+            buffer[i] = reversed[n - 1 - i];
+        return n;
+    }
+}
+
+size_t FormatFloat(float value, char *buffer)
+{
+    char *out = buffer;
+
+    if (value != value)
+    {
+        strcpy(buffer, "nan");
+        return 3;
+    }
+
+    boost::uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    if (bits & 0x80000000u)
+        *out++ = '-';
+
+    float absValue = std::fabs(value);
+    if (absValue == std::numeric_limits<float>::infinity())
+    {
+        strcpy(out, "inf");
+        return (size_t)(out - buffer) + 3;
+    }
+    if (absValue == 0.f)
+    {
+        *out++ = '0';
+        *out = 0;
+        return (size_t)(out - buffer);
+    }
+
+    // Find the decimal exponent of the first significant digit.
+    const double d = absValue;
+    int exponent = (int)std::floor(std::log10(d));
+    if (d >= PowerOfTen(exponent + 1))
+        ++exponent;
+    else if (d < PowerOfTen(exponent))
+        --exponent;
+
+    // Find the shortest digit sequence that converts back to the same float. 9 significant digits always suffice.
+    boost::uint64_t mantissa = 0;
+    int precision = 1;
+    for(; precision <= 9; ++precision)
+    {
+        const int scale = precision - 1 - exponent;
+        double scaled = (scale >= 0) ? d * PowerOfTen(scale) : d / PowerOfTen(-scale);
+        mantissa = (boost::uint64_t)(scaled + 0.5);
+        if (ToFloat(ComposeDouble(mantissa, -scale)) == absValue)
+            break;
+    }
+    if (precision > 9)
+        precision = 9;
+
+    // Rounding may have carried over to a new digit, f.ex. 9.99 -> 10.0.
+    if (mantissa >= (boost::uint64_t)PowerOfTen(precision))
+    {
+        mantissa /= 10;
+        ++exponent;
+    }
+
+    char digits[24];
+    size_t numDigits = WriteDigits(mantissa, digits);
+    while(numDigits > 1 && digits[numDigits - 1] == '0')
+        --numDigits;
+
+    if (exponent >= -5 && exponent < 9)
+    {
+        if (exponent >= 0)
+        {
+            // Integer part, padded with zeros if all significant digits are in it.
+            for(int i = 0; i <= exponent; ++i)
+                *out++ = ((size_t)i < numDigits) ? digits[i] : '0';
+            if (numDigits > (size_t)exponent + 1)
+            {
+                *out++ = '.';
+                for(size_t i = exponent + 1; i < numDigits; ++i)
+                    *out++ = digits[i];
+            }
+        }
+        else
+        {
+            *out++ = '0';
+            *out++ = '.';
+            for(int i = -1; i > exponent; --i)
+                *out++ = '0';
+            for(size_t i = 0; i < numDigits; ++i)
+                *out++ = digits[i];
+        }
+    }
+    else
+    {
+        // Exponent notation with at least two exponent digits, like printf.
+        *out++ = digits[0];
+        if (numDigits > 1)
+        {
+            *out++ = '.';
+            for(size_t i = 1; i < numDigits; ++i)
+                *out++ = digits[i];
+        }
+        *out++ = 'e';
+        *out++ = (exponent < 0) ? '-' : '+';
+        int absExponent = (exponent < 0) ? -exponent : exponent;
+        if (absExponent < 10)
+            *out++ = '0';
+        out += WriteDigits((boost::uint64_t)absExponent, out);
+    }
+
+    *out = 0;
+    return (size_t)(out - buffer);
+}
+
+size_t FormatInt(int value, char *buffer)
+{
+    char *out = buffer;
+    // Negate in unsigned arithmetic so that INT_MIN works.
+    boost::uint64_t absValue = (value < 0) ? (boost::uint64_t)(-(boost::int64_t)value) : (boost::uint64_t)value;
+    if (value < 0)
+        *out++ = '-';
+    out += WriteDigits(absValue, out);
+    *out = 0;
+    return (size_t)(out - buffer);
+}
+
+size_t FormatUInt(unsigned int value, char *buffer)
+{
+    size_t n = WriteDigits(value, buffer);
+    buffer[n] = 0;
+    return n;
+}
+
+size_t FormatFloatList(const float *values, size_t count, char separator, char *buffer)
+{
+    char *out = buffer;
+    for(size_t i = 0; i < count; ++i)
+    {
+        if (i != 0)
+            *out++ = separator;
+        out += FormatFloat(values[i], out);
+    }
+    *out = 0;
+    return (size_t)(out - buffer);
+}
+
+const char *ParseFloat(const char *begin, const char *end, float &value)
+{
+    const char *str = begin;
+    bool negative = false;
+    if (str < end && (*str == '-' || *str == '+'))
+    {
+        negative = (*str == '-');
+        ++str;
+    }
+
+    if (StartsWithKeyword(str, end, "nan"))
+    {
+        value = std::numeric_limits<float>::quiet_NaN();
+        return str + 3;
+    }
+    if (StartsWithKeyword(str, end, "inf"))
+    {
+        value = negative ? -std::numeric_limits<float>::infinity() : std::numeric_limits<float>::infinity();
+        return StartsWithKeyword(str, end, "infinity") ? str + 8 : str + 3;
+    }
+
+    // Accumulate at most 19 significant digits, which always fit in 64 bits. The rest only affect the exponent.
+    boost::uint64_t mantissa = 0;
+    int significantDigits = 0;
+    int exponent = 0;
+    bool anyDigits = false;
+
+    for(; str < end && IsDigit(*str); ++str)
+    {
+        anyDigits = true;
+        if (significantDigits < 19)
+        {
+            mantissa = mantissa * 10 + (*str - '0');
+            if (mantissa != 0)
+                ++significantDigits;
+        }
+        else
+            ++exponent;
+    }
+    if (str < end && *str == '.')
+    {
+        ++str;
+        for(; str < end && IsDigit(*str); ++str)
+        {
+            anyDigits = true;
+            if (significantDigits < 19)
+            {
+                mantissa = mantissa * 10 + (*str - '0');
+                if (mantissa != 0)
+                    ++significantDigits;
+                --exponent;
+            }
+        }
+    }
+    if (!anyDigits)
+        return 0;
+
+    if (str < end && (*str == 'e' || *str == 'E'))
+    {
+        const char *exponentStart = str;
+        ++str;
+        bool negativeExponent = false;
+        if (str < end && (*str == '-' || *str == '+'))
+        {
+            negativeExponent = (*str == '-');
+            ++str;
+        }
+        if (str < end && IsDigit(*str))
+        {
+            int explicitExponent = 0;
+            for(; str < end && IsDigit(*str); ++str)
+                if (explicitExponent < 10000)
+                    explicitExponent = explicitExponent * 10 + (*str - '0');
+            exponent += negativeExponent ? -explicitExponent : explicitExponent;
+        }
+        else
+            str = exponentStart; // Not an exponent after all, f.ex. "1e". Leave the 'e' unparsed.
+    }
+
+    float result = 0.f;
+    if (mantissa != 0)
+    {
+        // Clamp far out-of-range exponents so that the power of ten computation stays finite or zero.
+        if (exponent > 400)
+            result = std::numeric_limits<float>::infinity();
+        else if (exponent >= -400)
+            result = ToFloat(ComposeDouble(mantissa, exponent));
+    }
+    value = negative ? -result : result;
+    return str;
+}
+
+const char *ParseInt(const char *begin, const char *end, int &value)
+{
+    const char *str = begin;
+    bool negative = false;
+    if (str < end && (*str == '-' || *str == '+'))
+    {
+        negative = (*str == '-');
+        ++str;
+    }
+    if (str >= end || !IsDigit(*str))
+        return 0;
+
+    const boost::int64_t limit = negative ? -(boost::int64_t)std::numeric_limits<int>::min() : std::numeric_limits<int>::max();
+    boost::int64_t result = 0;
+    for(; str < end && IsDigit(*str); ++str)
+    {
+        result = result * 10 + (*str - '0');
+        if (result > limit)
+            return 0;
+    }
+    value = (int)(negative ? -result : result);
+    return str;
+}
+
+const char *ParseUInt(const char *begin, const char *end, unsigned int &value)
+{
+    const char *str = begin;
+    if (str < end && *str == '+')
+        ++str;
+    if (str >= end || !IsDigit(*str))
+        return 0;
+
+    boost::uint64_t result = 0;
+    for(; str < end && IsDigit(*str); ++str)
+    {
+        result = result * 10 + (*str - '0');
+        if (result > std::numeric_limits<unsigned int>::max())
+            return 0;
+    }
+    value = (unsigned int)result;
+    return str;
+}
+
+int ParseFloatList(const char *begin, const char *end, char separator, float *values, int maxCount)
+{
+    const char *str = SkipSpace(begin, end);
+    int count = 0;
+    while(str < end)
+    {
+        if (count >= maxCount)
+            return -1;
+        str = ParseFloat(str, end, values[count]);
+        if (!str)
+            return -1;
+        ++count;
+
+        const char *afterValue = str;
+        str = SkipSpace(str, end);
+        if (str >= end)
+            break;
+        if (*str == separator)
+            str = SkipSpace(str + 1, end);
+        else if (!IsSpace(separator) || str == afterValue)
+            return -1;
+    }
+    return count;
+}
+
+bool ParseFloatString(const char *begin, const char *end, float &value)
+{
+    const char *str = ParseFloat(SkipSpace(begin, end), end, value);
+    return str && SkipSpace(str, end) == end;
+}
+
+bool ParseIntString(const char *begin, const char *end, int &value)
+{
+    const char *str = ParseInt(SkipSpace(begin, end), end, value);
+    return str && SkipSpace(str, end) == end;
+}
+
+bool ParseUIntString(const char *begin, const char *end, unsigned int &value)
+{
+    const char *str = ParseUInt(SkipSpace(begin, end), end, value);
+    return str && SkipSpace(str, end) == end;
+}
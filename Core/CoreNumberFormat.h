@@ -0,0 +1,63 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+
+#ifndef incl_Core_NumberFormat_h
+#define incl_Core_NumberFormat_h
+
+#include <cstddef>
+
+//! Allocation-free conversions between numbers and text.
+/*! Unlike ToString/ParseString in CoreStringUtils.h, these functions do not go through boost::lexical_cast
+    or std::stringstream, do not create temporary strings, and do not depend on the C or C++ locale.
+    The output is written into a caller-provided buffer, which must be at least MAX_NUMBER_STRING_LENGTH
+    chars per formatted value. The output is always null-terminated.
+
+    Floats are formatted with the least amount of significant digits that parse back to exactly the same
+    value, f.ex. 0.1f is written as "0.1" instead of "0.100000001". Exponent notation is used only for very
+    large and very small values. Parsing accepts the output of these functions as well as the output of
+    boost::lexical_cast and printf-style formatting in the C locale.
+
+    Parse functions take a [begin, end[ range and return a pointer to the first char after the parsed value,
+    or null if the input did not start with a valid number. Leading whitespace is not skipped.
+*/
+
+//! Maximum length of a single formatted number, including the null terminator.
+const size_t MAX_NUMBER_STRING_LENGTH = 32;
+
+//! Formats a float with the shortest representation that round-trips. Returns the number of chars written, excluding the null terminator.
+size_t FormatFloat(float value, char *buffer);
+
+//! Formats a signed integer. Returns the number of chars written, excluding the null terminator.
+size_t FormatInt(int value, char *buffer);
+
+//! Formats an unsigned integer. Returns the number of chars written, excluding the null terminator.
+size_t FormatUInt(unsigned int value, char *buffer);
+
+//! Formats count floats separated by separator. The buffer must hold count * MAX_NUMBER_STRING_LENGTH chars.
+//! Returns the number of chars written, excluding the null terminator.
+size_t FormatFloatList(const float *values, size_t count, char separator, char *buffer);
+
+//! Parses a float. Accepts decimal and exponent notation, "nan", "inf" and "infinity" with an optional sign.
+const char *ParseFloat(const char *begin, const char *end, float &value);
+
+//! Parses a signed integer. Fails on overflow.
+const char *ParseInt(const char *begin, const char *end, int &value);
+
+//! Parses an unsigned integer. Fails on overflow and on a minus sign.
+const char *ParseUInt(const char *begin, const char *end, unsigned int &value);
+
+//! Parses a list of at most maxCount floats separated by separator. Whitespace around the values is skipped.
+/*! \return Number of values parsed, or -1 if the input was malformed, contained something else than the
+            list, or had more than maxCount values.
+*/
+int ParseFloatList(const char *begin, const char *end, char separator, float *values, int maxCount);
+
+//! Parses a whole [begin, end[ range as a single float, surrounding whitespace allowed. Returns true on success.
+bool ParseFloatString(const char *begin, const char *end, float &value);
+
+//! Parses a whole [begin, end[ range as a single signed integer, surrounding whitespace allowed. Returns true on success.
+bool ParseIntString(const char *begin, const char *end, int &value);
+
+//! Parses a whole [begin, end[ range as a single unsigned integer, surrounding whitespace allowed. Returns true on success.
+bool ParseUIntString(const char *begin, const char *end, unsigned int &value);
+
+#endif
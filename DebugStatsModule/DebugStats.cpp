@@ -31,10 +31,20 @@
 #include "UiProxyWidget.h"
 #include "EC_OpenSimPresence.h"
 #include "Console.h"
+#include "IAttribute.h"
+#include "Transform.h"
+#include "CoreNumberFormat.h"
+#include "SpatialIndex.h"
 
 #include <utility>
+#include <algorithm>
 #include <QDebug>
 
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int.hpp>
+#include <boost/random/uniform_real.hpp>
+#include <boost/random/variate_generator.hpp>
+
 #ifdef Q_WS_WIN
 #include "Performance.h"
 #endif 
@@ -119,6 +129,18 @@ void DebugStatsModule::PostInitialize()
         "Invokes action execution in entity",
         Console::Bind(this, &DebugStatsModule::Exec)));
 
+    RegisterConsoleCommand(Console::CreateCommand("benchattributes",
+        "Benchmarks attribute text serialization over the current scene. Usage: \"benchattributes(iterations)\"",
+        Console::Bind(this, &DebugStatsModule::BenchmarkAttributeSerialization)));
+
+    RegisterConsoleCommand(Console::CreateCommand("benchspatial",
+        "Benchmarks spatial index queries against linear scans. Usage: \"benchspatial(queries)\"",
+        Console::Bind(this, &DebugStatsModule::BenchmarkSpatialIndex)));
+
+    RegisterConsoleCommand(Console::CreateCommand("benchattributecolumns",
+        "Benchmarks per-entity and bulk attribute access over the current scene. Usage: \"benchattributecolumns(iterations, component, attribute)\"",
+        Console::Bind(this, &DebugStatsModule::BenchmarkAttributeColumns)));
+
     frameworkEventCategory_ = framework_->GetEventManager()->QueryEventCategory("Framework");
 
 
@@ -458,6 +480,232 @@ Console::CommandResult DebugStatsModule::LoadScene(const StringVector &params)
         return Console::ResultFailure("Failed to load the scene.");
 }
 
+Console::CommandResult DebugStatsModule::BenchmarkAttributeSerialization(const StringVector &params)
+{
+    Scene::ScenePtr scene = GetFramework()->GetDefaultWorldScene();
+    if (!scene)
+        return Console::ResultFailure("No active scene found.");
+    int iterations = (params.size() > 0) ? ParseString<int>(params[0], 10) : 10;
+    if (iterations < 1)
+        iterations = 1;
+
+    // Gather all attributes, and the float components of the numeric ones for the raw conversion comparison.
+    std::vector<IAttribute *> attributes;
+    std::vector<float> floats;
+    for(Scene::SceneManager::iterator iter = scene->begin(); iter != scene->end(); ++iter)
+    {
+        const Scene::Entity::ComponentVector &components = iter->second->GetComponentVector();
+        for(size_t i = 0; i < components.size(); ++i)
+        {
+            const AttributeVector &attrs = components[i]->GetAttributes();
+            for(size_t j = 0; j < attrs.size(); ++j)
+            {
+                attributes.push_back(attrs[j]);
+                if (Attribute<float> *f = dynamic_cast<Attribute<float> *>(attrs[j]))
+                    floats.push_back(f->Get());
+                else if (Attribute<Vector3df> *v = dynamic_cast<Attribute<Vector3df> *>(attrs[j]))
+                {
+                    floats.push_back(v->Get().x); floats.push_back(v->Get().y); floats.push_back(v->Get().z);
+                }
+                else if (Attribute<Quaternion> *q = dynamic_cast<Attribute<Quaternion> *>(attrs[j]))
+                {
+                    floats.push_back(q->Get().w); floats.push_back(q->Get().x); floats.push_back(q->Get().y); floats.push_back(q->Get().z);
+                }
+                else if (Attribute<Color> *c = dynamic_cast<Attribute<Color> *>(attrs[j]))
+                {
+                    floats.push_back(c->Get().r); floats.push_back(c->Get().g); floats.push_back(c->Get().b); floats.push_back(c->Get().a);
+                }
+                else if (Attribute<Transform> *t = dynamic_cast<Attribute<Transform> *>(attrs[j]))
+                {
+                    const Transform &tr = t->Get();
+                    floats.push_back(tr.position.x); floats.push_back(tr.position.y); floats.push_back(tr.position.z);
+                    floats.push_back(tr.rotation.x); floats.push_back(tr.rotation.y); floats.push_back(tr.rotation.z);
+                    floats.push_back(tr.scale.x); floats.push_back(tr.scale.y); floats.push_back(tr.scale.z);
+                }
+            }
+        }
+    }
+
+    const double freq = (double)GetCurrentClockFreq();
+    size_t checksum = 0;
+
+    tick_t start = GetCurrentClockTime();
+    for(int n = 0; n < iterations; ++n)
+        for(size_t i = 0; i < attributes.size(); ++i)
+            checksum += attributes[i]->ToString().size();
+    double attributeTime = (GetCurrentClockTime() - start) / freq;
+
+    start = GetCurrentClockTime();
+    for(int n = 0; n < iterations; ++n)
+        for(size_t i = 0; i < floats.size(); ++i)
+            checksum += (size_t)ParseString<float>(::ToString<float>(floats[i]), 0.f);
+    double legacyTime = (GetCurrentClockTime() - start) / freq;
+
+    start = GetCurrentClockTime();
+    char buffer[MAX_NUMBER_STRING_LENGTH];
+    for(int n = 0; n < iterations; ++n)
+        for(size_t i = 0; i < floats.size(); ++i)
+        {
+            float value = 0.f;
+            size_t len = FormatFloat(floats[i], buffer);
+            ParseFloatString(buffer, buffer + len, value);
+            checksum += (size_t)value;
+        }
+    double newTime = (GetCurrentClockTime() - start) / freq;
+
+    return Console::ResultSuccess("Attributes: " + ToString(attributes.size()) + ", float components: " + ToString(floats.size()) +
+        ", iterations: " + ToString(iterations) + " (checksum " + ToString(checksum) + ")\n" +
+        "IAttribute::ToString over all attributes: " + ToString(attributeTime * 1000.0) + " ms\n" +
+        "Float round trip, lexical_cast: " + ToString(legacyTime * 1000.0) + " ms\n" +
+        "Float round trip, CoreNumberFormat: " + ToString(newTime * 1000.0) + " ms");
+}
+
+Console::CommandResult DebugStatsModule::BenchmarkSpatialIndex(const StringVector &params)
+{
+    int queries = (params.size() > 0) ? ParseString<int>(params[0], 1000) : 1000;
+    if (queries < 1)
+        queries = 1;
+
+    // Entities are spread over a 2 km x 2 km region, which is about the size of an 8x8 region OpenSim grid.
+    const float extent = 2048.f;
+    const float radius = 20.f;
+    const size_t nearest = 10;
+    const double freq = (double)GetCurrentClockFreq();
+    const size_t counts[] = { 1000, 10000, 100000 };
+
+    std::string result = "Queries: " + ToString(queries) + ", radius " + ToString(radius) + ", nearest " + ToString(nearest);
+    for(size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+    {
+        // A fixed seed keeps the runs comparable, without reseeding the generator of the rest of the process
+        boost::mt19937 engine(0);
+        boost::variate_generator<boost::mt19937&, boost::uniform_real<float> > unit(engine, boost::uniform_real<float>(0.f, 1.f));
+        std::vector<Vector3df> positions(counts[c]);
+        Scene::SpatialIndex index;
+        for(size_t i = 0; i < positions.size(); ++i)
+        {
+            const float x = extent * unit();
+            const float y = extent * unit();
+            const float z = 100.f * unit();
+            positions[i] = Vector3df(x, y, z);
+            index.Update((entity_id_t)i, positions[i]);
+        }
+
+        boost::variate_generator<boost::mt19937&, boost::uniform_int<size_t> > pick(engine, boost::uniform_int<size_t>(0, positions.size() - 1));
+        std::vector<Scene::SpatialIndex::RadiusQuery> radiusQueries(queries);
+        for(size_t i = 0; i < radiusQueries.size(); ++i)
+            radiusQueries[i] = Scene::SpatialIndex::RadiusQuery(positions[pick()], radius);
+
+        size_t linearHits = 0;
+        tick_t start = GetCurrentClockTime();
+        for(size_t q = 0; q < radiusQueries.size(); ++q)
+            for(size_t i = 0; i < positions.size(); ++i)
+                if (positions[i].getDistanceFromSQ(radiusQueries[q].center) <= radius * radius)
+                    ++linearHits;
+        double linearTime = (GetCurrentClockTime() - start) / freq;
+
+        size_t indexHits = 0;
+        std::vector<entity_id_t> found;
+        start = GetCurrentClockTime();
+        for(size_t q = 0; q < radiusQueries.size(); ++q)
+        {
+            found.clear();
+            index.QueryRadius(radiusQueries[q].center, radius, found);
+            indexHits += found.size();
+        }
+        double indexTime = (GetCurrentClockTime() - start) / freq;
+
+        std::vector<std::vector<entity_id_t> > batchResults;
+        start = GetCurrentClockTime();
+        index.QueryRadiusBatch(radiusQueries, batchResults);
+        double batchTime = (GetCurrentClockTime() - start) / freq;
+
+        std::vector<std::pair<float, size_t> > distances(positions.size());
+        start = GetCurrentClockTime();
+        for(size_t q = 0; q < radiusQueries.size(); ++q)
+        {
+            for(size_t i = 0; i < positions.size(); ++i)
+                distances[i] = std::make_pair(positions[i].getDistanceFromSQ(radiusQueries[q].center), i);
+            std::partial_sort(distances.begin(), distances.begin() + std::min(nearest, distances.size()), distances.end());
+        }
+        double linearNearestTime = (GetCurrentClockTime() - start) / freq;
+
+        start = GetCurrentClockTime();
+        for(size_t q = 0; q < radiusQueries.size(); ++q)
+        {
+            found.clear();
+            index.QueryNearest(radiusQueries[q].center, nearest, found);
+        }
+        double indexNearestTime = (GetCurrentClockTime() - start) / freq;
+
+        result += "\n" + ToString(counts[c]) + " entities (" + ToString(index.GetCellCount()) + " cells, " +
+            ToString(linearHits) + "/" + ToString(indexHits) + " hits): radius linear " + ToString(linearTime * 1000.0) +
+            " ms, index " + ToString(indexTime * 1000.0) + " ms, index batched " + ToString(batchTime * 1000.0) +
+            " ms; nearest linear " + ToString(linearNearestTime * 1000.0) + " ms, index " + ToString(indexNearestTime * 1000.0) + " ms";
+    }
+
+    return Console::ResultSuccess(result);
+}
+
+Console::CommandResult DebugStatsModule::BenchmarkAttributeColumns(const StringVector &params)
+{
+    Scene::ScenePtr scene = GetFramework()->GetDefaultWorldScene();
+    if (!scene)
+        return Console::ResultFailure("No active scene found.");
+    int iterations = (params.size() > 0) ? ParseString<int>(params[0], 10) : 10;
+    if (iterations < 1)
+        iterations = 1;
+    QString typeName = (params.size() > 1) ? QString(params[1].c_str()) : QString("EC_Placeable");
+    QString attributeName = (params.size() > 2) ? QString(params[2].c_str()) : QString("Transform");
+
+    QVariantList ids = scene->GetEntityIdsWithComponent(typeName);
+    std::vector<entity_id_t> idVector;
+    for(int i = 0; i < ids.size(); ++i)
+        idVector.push_back((entity_id_t)ids[i].toUInt());
+    std::vector<float> values;
+    uint stride = scene->ReadAttributeColumn(idVector, typeName, attributeName, values);
+    if (!stride)
+        return Console::ResultFailure("No numeric attribute " + attributeName.toStdString() + " found in " + typeName.toStdString() + " components.");
+
+    // All paths write back the value they read, so the scene is left unchanged. LocalOnly keeps the changes off the network.
+    const double freq = (double)GetCurrentClockFreq();
+    tick_t start = GetCurrentClockTime();
+    for(int n = 0; n < iterations; ++n)
+        for(int i = 0; i < ids.size(); ++i)
+        {
+            Scene::Entity *entity = scene->GetEntityRaw(ids[i].toUInt());
+            ComponentPtr component = entity ? entity->GetComponent(typeName) : ComponentPtr();
+            IAttribute *attribute = component ? component->GetAttribute(attributeName) : 0;
+            if (attribute)
+                attribute->FromQVariant(attribute->ToQVariant(), AttributeChange::LocalOnly);
+        }
+    double perEntityTime = (GetCurrentClockTime() - start) / freq;
+
+    start = GetCurrentClockTime();
+    for(int n = 0; n < iterations; ++n)
+        scene->SetAttributeColumn(ids, typeName, attributeName, scene->GetAttributeColumn(ids, typeName, attributeName), AttributeChange::LocalOnly);
+    double listTime = (GetCurrentClockTime() - start) / freq;
+
+    start = GetCurrentClockTime();
+    for(int n = 0; n < iterations; ++n)
+        scene->SetAttributeColumnData(ids, typeName, attributeName, scene->GetAttributeColumnData(ids, typeName, attributeName), AttributeChange::LocalOnly);
+    double dataTime = (GetCurrentClockTime() - start) / freq;
+
+    start = GetCurrentClockTime();
+    for(int n = 0; n < iterations; ++n)
+    {
+        scene->ReadAttributeColumn(idVector, typeName, attributeName, values);
+        scene->WriteAttributeColumn(idVector, typeName, attributeName, &values[0], values.size(), AttributeChange::LocalOnly);
+    }
+    double nativeTime = (GetCurrentClockTime() - start) / freq;
+
+    return Console::ResultSuccess(ToString(ids.size()) + " x " + typeName.toStdString() + "." + attributeName.toStdString() +
+        " (" + ToString(stride) + " floats), " + ToString(iterations) + " read/write rounds:\n" +
+        "Per entity QVariant: " + ToString(perEntityTime * 1000.0) + " ms\n" +
+        "Column as list: " + ToString(listTime * 1000.0) + " ms\n" +
+        "Column as packed floats: " + ToString(dataTime * 1000.0) + " ms\n" +
+        "Column native: " + ToString(nativeTime * 1000.0) + " ms");
+}
+
 Console::CommandResult DebugStatsModule::DumpTextures(const StringVector &params)
 {
     boost::shared_ptr<OgreRenderer::Renderer> renderer = GetFramework()->GetServiceManager()->GetService
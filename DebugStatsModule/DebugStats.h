@@ -91,6 +91,17 @@ namespace DebugStats
         /// Invokes action in entity.
         Console::CommandResult Exec(const StringVector &params);
 
+        /// Measures attribute text serialization speed over all attributes in the current scene.
+        /// Compares the legacy boost::lexical_cast based float conversions with the CoreNumberFormat ones.
+        Console::CommandResult BenchmarkAttributeSerialization(const StringVector &params);
+
+        /// Measures Scene::SpatialIndex radius and nearest queries against linear scans at 1k, 10k and 100k entities.
+        Console::CommandResult BenchmarkSpatialIndex(const StringVector &params);
+
+        /// Compares reading and writing one attribute of all entities in the current scene one entity at a time through
+        /// QVariants, like scripts do, with the SceneManager attribute column functions.
+        Console::CommandResult BenchmarkAttributeColumns(const StringVector &params);
+
         /// A history of estimated frame times.
         std::vector<std::pair<uint64_t, double> > frameTimes;
 
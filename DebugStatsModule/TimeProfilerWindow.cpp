@@ -21,6 +21,8 @@
 #include "EC_Terrain.h"
 #include "NaaliMainWindow.h"
 #include "NaaliUi.h"
+#include "Renderer.h"
+#include "TextureResidency.h"
 #include <AssetEvents.h>
 #include <EventManager.h>
 //#include "RealXtend/RexProtocolMsgIDs.h"
@@ -552,7 +554,7 @@ void TimeProfilerWindow::OnProfilerWindowTabChanged(int newPage)
         RefreshRenderTargetProfilingData();
         break;
     case 8: // Textures
-        RefreshAssetData(Ogre::TextureManager::getSingleton(), tree_texture_assets_ );
+        RefreshTextureProfilingData();
         break;
     case 9: // Meshes
         RefreshAssetData(Ogre::MeshManager::getSingleton(), tree_mesh_assets_ );
@@ -1516,6 +1518,25 @@ void TimeProfilerWindow::RefreshNetworkProfilingData()
 
         RedrawHistoryGraph(packetsOut, findChild<QLabel*>("labelPacketsOutSecGraph"));
 
+        // Outbound messages before batching and ack piggybacking, compare to the datagrams above.
+        std::vector<double> messagesOut;
+        netMessageManager->sentMessages.OutputBucketedAccumulated(messagesOut, numEntries, bucketSize, &dstOccur);
+        double messagesOutPerSec = EventHistory::SmoothedAvgPerSecond(messagesOut, bucketSize, smoothingCoeff);
+        netMessageManager->sentMessageBytes.OutputBucketedAccumulated(dstAccum, numEntries, bucketSize, &dstOccur);
+        double messageBytesOutPerSec = EventHistory::SmoothedAvgPerSecond(dstAccum, bucketSize, smoothingCoeff);
+        sprintf(str, "%.2f m/sec, %s/sec", (float)messagesOutPerSec, FormatBytes(messageBytesOutPerSec).c_str());
+        findChild<QLabel*>("labelMessagesOutPerSec")->setText(str);
+
+        netMessageManager->appendedAcks.OutputBucketedAccumulated(dstAccum, numEntries, bucketSize, &dstOccur);
+        double appendedAcksPerSec = EventHistory::SmoothedAvgPerSecond(dstAccum, bucketSize, smoothingCoeff);
+        sprintf(str, "%.2f acks/sec", (float)appendedAcksPerSec);
+        findChild<QLabel*>("labelAcksAppendedPerSec")->setText(str);
+
+        netMessageManager->sendCalls.OutputBucketedAccumulated(dstAccum, numEntries, bucketSize, &dstOccur);
+        double sendCallsPerSec = EventHistory::SmoothedAvgPerSecond(dstAccum, bucketSize, smoothingCoeff);
+        sprintf(str, "%.2f calls/sec (%s)", (float)sendCallsPerSec, netMessageManager->GetOutboundBatching() ? "batched" : "immediate");
+        findChild<QLabel*>("labelSendCallsPerSec")->setText(str);
+
         netMessageManager->resentPackets.OutputBucketedAccumulated(dstAccum, numEntries, bucketSize, &dstOccur);
         double resentPacketsPerSec = EventHistory::SmoothedAvgPerSecond(dstAccum, bucketSize, smoothingCoeff);
         sprintf(str, "%.2f p/sec", (float)resentPacketsPerSec);
@@ -2207,18 +2228,27 @@ void TimeProfilerWindow::RefreshTextureProfilingData()
     if (!visibility_ || !tab_widget_ || tab_widget_->currentIndex() != 8)
         return;
 
-    Ogre::ResourceManager::ResourceMapIterator iter = Ogre::TextureManager::getSingleton().getResourceIterator();
+    RefreshAssetData(Ogre::TextureManager::getSingleton(), tree_texture_assets_);
 
-    while(iter.hasMoreElements())
+    QLabel *label = findChild<QLabel*>("texture_label");
+    boost::shared_ptr<OgreRenderer::Renderer> renderer = framework_->GetServiceManager()->GetService
+        <OgreRenderer::Renderer>(Service::ST_Renderer).lock();
+    if (label && renderer && renderer->GetTextureResidency())
     {
-        Ogre::ResourcePtr resource = iter.getNext();
-        // Is there already this kind of element? 
-        QTreeWidgetItem *item = FindItemByName(tree_texture_assets_, resource->getName().c_str());
-        if (item == 0) 
-            item = new QTreeWidgetItem(tree_texture_assets_);
-
-        FillItem(item, resource);
+        const OgreRenderer::TextureResidency::Stats &stats = renderer->GetTextureResidency()->GetStats();
+        QString text = QString("Decoded textures: %1, %2 MB").arg(stats.textures).arg(stats.bytes / (1024.0 * 1024.0), 0, 'f', 1);
+        if (stats.budget)
+            text += QString(" of %1 MB budget").arg(stats.budget / (1024.0 * 1024.0), 0, 'f', 0);
+        else
+            text += " (no budget)";
+        text += QString(". Reduced: %1 (%2 MB), reducing: %3, restoring: %4. Rendered in the last frame: %5. "
+            "Reductions: %6, restorations: %7.")
+            .arg(stats.reduced).arg(stats.reducedBytes / (1024.0 * 1024.0), 0, 'f', 1).arg(stats.reducing)
+            .arg(stats.restoring).arg(stats.rendered).arg(stats.reductions).arg(stats.restorations);
+        label->setText(text);
     }
+
+    QTimer::singleShot(1000, this, SLOT(RefreshTextureProfilingData()));
 }
 
 /// Derive the tree widget item to implement a custom sort predicate that sorts certain columns by numbers. 
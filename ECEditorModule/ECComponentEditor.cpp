@@ -157,6 +157,7 @@ namespace ECEditor
             iter++;
         }
         QObject::connect(component.get(), SIGNAL(OnAttributeChanged(IAttribute*, AttributeChange::Type)), this, SLOT(AttributeChanged(IAttribute*, AttributeChange::Type)));
+        QObject::connect(component.get(), SIGNAL(OnAttributesChanged(const AttributeVector&, AttributeChange::Type)), this, SLOT(AttributesChanged(const AttributeVector&, AttributeChange::Type)));
         UpdateGroupPropertyText();
     }
 
@@ -183,6 +184,7 @@ namespace ECEditor
                     attributeIter++;
                 }
                 disconnect(componentPtr.get(), SIGNAL(OnAttributeChanged(IAttribute*, AttributeChange::Type)), this, SLOT(AttributeChanged(IAttribute*, AttributeChange::Type)));
+                disconnect(componentPtr.get(), SIGNAL(OnAttributesChanged(const AttributeVector&, AttributeChange::Type)), this, SLOT(AttributesChanged(const AttributeVector&, AttributeChange::Type)));
                 components_.erase(iter);
                 break;
             }
@@ -209,9 +211,28 @@ namespace ECEditor
             return;
         if(component->TypeName() != typeName_)
             return;
+        //! Batched changes are handled by AttributesChanged.
+        if(component->IsAttributeChangeBatched())
+            return;
 
         AttributeEditorMap::iterator iter = attributeEditors_.find(attribute->GetName());
         if(iter != attributeEditors_.end())
             iter->second->UpdateEditorUI();
     }
+
+    void ECComponentEditor::AttributesChanged(const AttributeVector &attributes, AttributeChange::Type change)
+    {
+        IComponent *component = dynamic_cast<IComponent *>(sender());
+        if(!component)
+            return;
+        if(component->TypeName() != typeName_)
+            return;
+
+        for(uint i = 0; i < attributes.size(); i++)
+        {
+            AttributeEditorMap::iterator iter = attributeEditors_.find(attributes[i]->GetName());
+            if(iter != attributeEditors_.end())
+                iter->second->UpdateEditorUI();
+        }
+    }
 }
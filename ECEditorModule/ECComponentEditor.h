@@ -57,6 +57,9 @@ namespace ECEditor
         //! Method will ask the ECAttributeEditor to update it's fields to new attribute values (UpdateEditorUI).
         void AttributeChanged(IAttribute* attribute, AttributeChange::Type change);
 
+        //! When several attributes of a component have been changed in a batch, this method is called once for them.
+        void AttributesChanged(const AttributeVector &attributes, AttributeChange::Type change);
+
     private:
         //! Method is trying to find the right attribute type by using a dynamic_cast and if attribute is succefully casted 
         //! a new ECAttributeEditor instance is created and it's pointer returned to a user. If attribute type is not supported
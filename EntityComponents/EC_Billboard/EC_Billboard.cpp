@@ -18,11 +18,27 @@
 DEFINE_POCO_LOGGING_FUNCTIONS("EC_Billboard");
 
 #include <OgreBillboardSet.h>
+#include <OgreMaterialManager.h>
 #include <OgreTextureManager.h>
 #include <OgreResource.h>
 
 #include <QTimer>
 
+namespace
+{
+    /// Returns the material shared by all billboards showing the image, creates it on first use.
+    std::string GetSharedMaterial(const std::string &imageName)
+    {
+        std::string name = "BillboardMaterial_" + imageName;
+        if (Ogre::MaterialManager::getSingleton().getByName(name).isNull())
+        {
+            Ogre::MaterialPtr material = OgreRenderer::CloneMaterial("UnlitTexturedSoftAlpha", name);
+            OgreRenderer::SetTextureUnitOnMaterial(material, imageName);
+        }
+        return name;
+    }
+}
+
 EC_Billboard::EC_Billboard(IModule *module) :
     IComponent(module->GetFramework()),
     billboardSet_(0),
@@ -33,6 +49,13 @@ EC_Billboard::EC_Billboard(IModule *module) :
 
 EC_Billboard::~EC_Billboard()
 {
+    if (!billboardSet_)
+        return;
+
+    boost::shared_ptr<OgreRenderer::Renderer> renderer = GetFramework()->GetServiceManager()->GetService
+        <OgreRenderer::Renderer>(Service::ST_Renderer).lock();
+    if (renderer && renderer->GetSceneManager())
+        renderer->GetSceneManager()->destroyBillboardSet(billboardSet_);
 }
 
 void EC_Billboard::SetPosition(const Vector3df& position)
@@ -50,7 +73,7 @@ void EC_Billboard::SetDimensions(float w, float h)
 void EC_Billboard::Show(const std::string &imageName, int timeToShow)
 {
     assert(GetFramework());
-    if (GetFramework())
+    if (!GetFramework())
         return;
 
     boost::shared_ptr<OgreRenderer::Renderer> renderer = GetFramework()->GetServiceManager()->GetService
@@ -90,9 +113,8 @@ void EC_Billboard::Show(const std::string &imageName, int timeToShow)
         billboardSet_ = scene->createBillboardSet(renderer->GetUniqueObjectName(), 1);
         assert(billboardSet_);
 
-        materialName_ = std::string("material") + renderer->GetUniqueObjectName(); 
-        Ogre::MaterialPtr material = OgreRenderer::CloneMaterial("UnlitTexturedSoftAlpha", materialName_);
-        OgreRenderer::SetTextureUnitOnMaterial(material, imageName);
+        // Billboards showing the same image share the material, so they can be rendered without state changes
+        materialName_ = GetSharedMaterial(imageName);
         billboardSet_->setMaterialName(materialName_);
 
         billboard_ = billboardSet_->createBillboard(Ogre::Vector3(0, 0, 1.5f));
@@ -103,15 +125,9 @@ void EC_Billboard::Show(const std::string &imageName, int timeToShow)
     }
     else
     {
-        // Billboard already created Set new texture for the material
-        assert(!materialName_.empty());
-        if (!materialName_.empty())
-        {
-            Ogre::MaterialManager &mgr = Ogre::MaterialManager::getSingleton();
-            Ogre::MaterialPtr material = mgr.getByName(materialName_);
-            assert(material.get());
-            OgreRenderer::SetTextureUnitOnMaterial(material, imageName);
-        }
+        // Billboard already created, switch to the material of the new image
+        materialName_ = GetSharedMaterial(imageName);
+        billboardSet_->setMaterialName(materialName_);
     }
 
     Show(timeToShow);
@@ -16,13 +16,11 @@
 #include "Entity.h"
 #include "OgreMaterialUtils.h"
 #include "LoggingFunctions.h"
+#include "LabelAtlas.h"
 
 DEFINE_POCO_LOGGING_FUNCTIONS("EC_ChatBubble");
 
 #include <Ogre.h>
-#include <OgreBillboardSet.h>
-#include <OgreTextureManager.h>
-#include <OgreResource.h>
 
 #include <QFile>
 #include <QPainter>
@@ -36,8 +34,8 @@ EC_ChatBubble::EC_ChatBubble(IModule *module) :
     font_(QFont("Arial", 50)),
     bubbleColor_(QColor(48, 113, 255, 255)),
     textColor_(Qt::white),
-    billboardSet_(0),
-    billboard_(0),
+    quad_(0),
+    label_(0),
     pop_timer_(new QTimer(this)),
     bubble_max_rect_(0,0,1024,512),
     current_scale_(1.0f),
@@ -60,27 +58,28 @@ EC_ChatBubble::~EC_ChatBubble()
 
 void EC_ChatBubble::Destroy()
 {
-    if (!renderer_.expired())
+    OgreRenderer::LabelAtlas *atlas = GetLabelAtlas();
+    if (atlas)
     {
-        try{
-        Ogre::TextureManager::getSingleton().remove(texture_name_);
-        } catch(...)
-        {
-        }
-        try{
-        Ogre::MaterialManager::getSingleton().remove(materialName_);
-        } catch(...)
-        {
-        }
-        texture_name_ = "";
-        materialName_ = "";
+        atlas->DestroyQuad(quad_);
+        atlas->Release(label_);
     }
+
+    quad_ = 0;
+    label_ = 0;
+}
+
+OgreRenderer::LabelAtlas *EC_ChatBubble::GetLabelAtlas() const
+{
+    boost::shared_ptr<OgreRenderer::Renderer> renderer = renderer_.lock();
+    return renderer ? renderer->GetLabelAtlas() : 0;
 }
 
 void EC_ChatBubble::SetPosition(const Vector3df& position)
 {
-    if (billboard_)
-        billboard_->setPosition(Ogre::Vector3(position.x, position.y, position.z));
+    OgreRenderer::LabelAtlas *atlas = GetLabelAtlas();
+    if (atlas && quad_)
+        atlas->SetQuadOffset(quad_, Ogre::Vector3(position.x, position.y, position.z));
 }
 
 void EC_ChatBubble::SetScale(float scale)
@@ -90,17 +89,18 @@ void EC_ChatBubble::SetScale(float scale)
     scale = floorf(scale);
     scale /=100;
 
-    if (!billboardSet_ || !billboard_ || (current_scale_ == scale))
+    OgreRenderer::LabelAtlas *atlas = GetLabelAtlas();
+    if (!atlas || !quad_ || (current_scale_ == scale))
         return;
 
     // Make scale go inside our range
     clamp(scale, 0.5f, 2.5f);
 
-    // Update dimension
-    billboardSet_->setDefaultDimensions(2*scale, 1*scale);
+    // Update dimension, the full bubble image of 1024 x 512 pixels is 2 x 1 units when not scaled
+    atlas->SetQuadUnitsPerPixel(quad_, 2*scale / bubble_max_rect_.width());
 
     // Update position
-    Ogre::Vector3 position = billboard_->getPosition();
+    Ogre::Vector3 position = atlas->GetQuadOffset(quad_);
     if (scale <= 1.0)
         position.z = default_z_pos_ - (1.0-scale);
     else if (scale > 1.0 && scale <= 1.7)
@@ -109,15 +109,16 @@ void EC_ChatBubble::SetScale(float scale)
         position.z = default_z_pos_ + (scale - 1.7);
     else if (scale > 2.5)
         position.z = default_z_pos_ + (2.5 - 1.7);
-    billboard_->setPosition(position);
+    atlas->SetQuadOffset(quad_, position);
 
     current_scale_ = scale;
 }
 
 bool EC_ChatBubble::IsVisible() const
 {
-    if (billboardSet_)
-        return billboardSet_->isVisible();
+    OgreRenderer::LabelAtlas *atlas = GetLabelAtlas();
+    if (atlas && quad_)
+        return atlas->IsQuadVisible(quad_);
     else
         return false;
 }
@@ -127,9 +128,9 @@ void EC_ChatBubble::ShowMessage(const QString &msg)
     if (msg.isNull() || msg.isEmpty())
         return;
 
-    if (!billboardSet_ && !billboard_)
+    if (!quad_)
         Update();
-    if (!billboardSet_ && !billboard_)
+    if (!quad_)
         return;
 
     // Push message to queue and update rendering
@@ -144,7 +145,9 @@ void EC_ChatBubble::ShowNextMessage()
     // Return if nothing available and hide bubble
     if (messages_.isEmpty())
     {
-        billboardSet_->setVisible(false);
+        OgreRenderer::LabelAtlas *atlas = GetLabelAtlas();
+        if (atlas)
+            atlas->SetQuadVisible(quad_, false);
         current_message_ = "";
         return;
     }
@@ -231,48 +234,41 @@ QString EC_ChatBubble::ConstructCombined() const
 
 void EC_ChatBubble::Refresh()
 {
-    if (renderer_.expired() || !billboardSet_ || !billboard_)
+    OgreRenderer::LabelAtlas *atlas = GetLabelAtlas();
+    if (!atlas || !quad_)
         return;
 
     // If no messages in the log, hide the chat bubble.
     if (messages_.isEmpty())
     {
-        billboardSet_->setVisible(false);
+        atlas->SetQuadVisible(quad_, false);
         return;
     }
     else
-        billboardSet_->setVisible(true);
+        atlas->SetQuadVisible(quad_, true);
 
-    // Get image buffer and texture
-    QImage buffer = GetChatBubblePixmap().toImage();
-    Ogre::TexturePtr texture = Ogre::TextureManager::getSingleton().getByName(texture_name_);
-    if (buffer.isNull() || texture.isNull())
-        return;
-
-    // Check texture size
-    if ((int)texture->getWidth() != buffer.width() || (int)texture->getHeight() != buffer.height())
+    // Bubbles with the same text and look, eg. the same greeting from several avatars, share one label.
+    QString key = "ChatBubble|" + current_message_ + "|" + font_.toString() + "|" +
+        QString::number(textColor_.rgba(), 16) + "|" + QString::number(bubbleColor_.rgba(), 16);
+    OgreRenderer::LabelAtlas::label_id_t label = atlas->Acquire(key);
+    if (!label)
     {
-        texture->freeInternalResources();
-        texture->setWidth(buffer.width());
-        texture->setHeight(buffer.height());
-        texture->createInternalResources();
+        QSize source_size;
+        QImage buffer = GetChatBubbleImage(atlas->GetLabelScale(), source_size);
+        if (buffer.isNull())
+            return;
+        label = atlas->Add(key, buffer, source_size, bubble_max_rect_.size());
     }
 
-    // Update texture buffer
-    Ogre::Box update_box(0,0, buffer.width(), buffer.height());
-    Ogre::PixelBox pixel_box(update_box, Ogre::PF_A8R8G8B8, (void*)buffer.bits());
-    if (!texture->getBuffer().isNull())
-        texture->getBuffer()->blitFromMemory(pixel_box, update_box);
+    atlas->SetQuadLabel(quad_, label);
+    atlas->Release(label_);
+    label_ = label;
 }
 
 void EC_ChatBubble::Update()
 {
-    if (renderer_.expired())
-        return;
-
-    Ogre::SceneManager *scene = renderer_.lock()->GetSceneManager();
-    assert(scene);
-    if (!scene)
+    OgreRenderer::LabelAtlas *atlas = GetLabelAtlas();
+    if (!atlas)
         return;
 
     Scene::Entity *entity = GetParentEntity();
@@ -289,51 +285,30 @@ void EC_ChatBubble::Update()
     if (!sceneNode)
         return;
 
-    // Create billboard if it doesn't exist.
-    if (!billboardSet_ && !billboard_)
+    // Create the quad if it doesn't exist.
+    if (!quad_)
     {
-        // Create billboardset and billboard
-        billboardSet_ = scene->createBillboardSet(renderer_.lock()->GetUniqueObjectName(), 1);
-        assert(billboardSet_);
-
-        billboard_ = billboardSet_->createBillboard(Ogre::Vector3(0, 0, default_z_pos_));
-        assert(billboard_);
-
-        billboardSet_->setDefaultDimensions(2, 1);
-        sceneNode->attachObject(billboardSet_);
-
-        // Create material
-        materialName_ = std::string("ChatBubbleMaterial") + renderer_.lock()->GetUniqueObjectName(); 
-        Ogre::MaterialPtr material = OgreRenderer::CloneMaterial("UnlitTexturedSoftAlpha", materialName_);
-        billboardSet_->setMaterialName(materialName_);
-
-        // Create texture
-        texture_name_ = "ChatBubbleTexture" + renderer_.lock()->GetUniqueObjectName();
-        Ogre::TexturePtr texture = Ogre::TextureManager::getSingleton().createManual(
-            texture_name_, Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME,
-            Ogre::TEX_TYPE_2D, 1, 1, 0, Ogre::PF_A8R8G8B8, 
-            Ogre::TU_DYNAMIC_WRITE_ONLY_DISCARDABLE);
-
-        // Set texture to material
-        if (texture.isNull())
-            texture_name_ = "";
-        else
-            OgreRenderer::SetTextureUnitOnMaterial(material, texture_name_);
+        quad_ = atlas->CreateQuad(sceneNode, Ogre::Vector3(0, 0, default_z_pos_), 2.0f * current_scale_ / bubble_max_rect_.width());
+        assert(quad_);
+        atlas->SetQuadVisible(quad_, false);
     }
     else
     {
-        // Billboard already exists, remove it from the old and attach it to a new scene node.
-        LogInfo("Trying to detach chat bubble billboard from its old node and attach to a new node. This feature is not tested.");
-        Ogre::SceneNode *oldNode = billboardSet_->getParentSceneNode();
-        oldNode->detachObject(billboardSet_);
-        sceneNode->attachObject(billboardSet_);
+        // Quad already exists, recreate it for the new scene node.
+        LogInfo("Moving chat bubble from its old node to a new node. This feature is not tested.");
+        Ogre::Vector3 offset = atlas->GetQuadOffset(quad_);
+        bool visible = atlas->IsQuadVisible(quad_);
+        atlas->DestroyQuad(quad_);
+        quad_ = atlas->CreateQuad(sceneNode, offset, 2.0f * current_scale_ / bubble_max_rect_.width());
+        atlas->SetQuadLabel(quad_, label_);
+        atlas->SetQuadVisible(quad_, visible);
     }
 }
 
-QPixmap EC_ChatBubble::GetChatBubblePixmap()
+QImage EC_ChatBubble::GetChatBubbleImage(float scale, QSize &sourceSize)
 {
     if (renderer_.expired())
-        return 0;
+        return QImage();
 
 ///\todo    Resize the chat bubble and font size according to the render window size and distance
 ///         avatar's distance from the camera.
@@ -343,10 +318,6 @@ QPixmap EC_ChatBubble::GetChatBubblePixmap()
 //    const int max_width = viewport->getActualWidth()/4;
 //    int max_height = viewport->getActualHeight()/10;
 
-    // Create transparent pixmap
-    QPixmap pixmap(bubble_max_rect_.size());
-    pixmap.fill(Qt::transparent);
-
     // Gather chat log and calculate the bounding rect size.
     /*
     QStringListIterator it(messages_);
@@ -382,17 +353,13 @@ QPixmap EC_ChatBubble::GetChatBubblePixmap()
     }
     */
 
-    // Create painter
-    QPainter painter(&pixmap);
-    painter.setFont(font_);
-
     // Get padding from font metrics
-    QFontMetrics metric(painter.font());
+    QFontMetrics metric(font_);
     int padding = metric.averageCharWidth();
 
     // Text rect
     QRect text_boundaries(padding, padding, bubble_max_rect_.width()-(2*padding), bubble_max_rect_.height()-(2*padding));
-    QRect text_rect = painter.boundingRect(text_boundaries, Qt::AlignCenter | Qt::TextWordWrap, current_message_ /*fullChatLog*/);
+    QRect text_rect = metric.boundingRect(text_boundaries, Qt::AlignCenter | Qt::TextWordWrap, current_message_ /*fullChatLog*/);
     
     // Background rect
     int bg_left = text_rect.x() - (padding/2);
@@ -410,6 +377,16 @@ QPixmap EC_ChatBubble::GetChatBubblePixmap()
 
     QRect bg_rect(bg_left, bg_top, bg_width, bg_height); 
 
+    // Only the bubble is kept in the label atlas, so render it at the origin of a transparent image
+    sourceSize = bg_rect.size();
+    QImage image(qMax(1, (int)ceil(bg_rect.width() * scale)), qMax(1, (int)ceil(bg_rect.height() * scale)), QImage::Format_ARGB32);
+    image.fill(0);
+
+    QPainter painter(&image);
+    painter.scale(scale, scale);
+    painter.translate(-bg_rect.topLeft());
+    painter.setFont(font_);
+
     // Background color
     QLinearGradient grad(bg_rect.topLeft(), bg_rect.bottomLeft());
     grad.setColorAt(0, QColor(39, 92, 206, 255));
@@ -425,5 +402,5 @@ QPixmap EC_ChatBubble::GetChatBubblePixmap()
     painter.setPen(textColor_);
     painter.drawText(text_rect, Qt::AlignCenter | Qt::TextWordWrap, current_message_);
 
-    return pixmap;
+    return image;
 }
@@ -21,13 +21,7 @@
 namespace OgreRenderer
 {
     class Renderer;
-}
-
-namespace Ogre
-{
-    class SceneNode;
-    class BillboardSet;
-    class Billboard;
+    class LabelAtlas;
 }
 
 QT_BEGIN_NAMESPACE
@@ -132,23 +126,22 @@ private slots:
     void Refresh();
 
 private:
-    /// Returns pixmap with chat bubble and current messages renderer to it.
-    QPixmap GetChatBubblePixmap();
+    /// Returns image with chat bubble and current messages rendered to it.
+    /// @param scale Scale to render the bubble with.
+    /// @param sourceSize Returns size of the image before scaling.
+    QImage GetChatBubbleImage(float scale, QSize &sourceSize);
+
+    /// Returns the label atlas of the renderer, or null if the renderer is gone.
+    OgreRenderer::LabelAtlas *GetLabelAtlas() const;
 
     /// Renderer pointer.
     boost::weak_ptr<OgreRenderer::Renderer> renderer_;
 
-    /// Ogre billboard set.
-    Ogre::BillboardSet *billboardSet_;
-
-    /// Ogre billboard.
-    Ogre::Billboard *billboard_;
-
-    /// Name of the material used for the billboard set.
-    std::string materialName_;
+    /// Quad in the label atlas, 0 if not created yet.
+    uint quad_;
 
-    /// Name of the texture
-    std::string texture_name_;
+    /// Label in the label atlas, 0 if none.
+    uint label_;
 
     /// For used for the chat bubble text.
     QFont font_;
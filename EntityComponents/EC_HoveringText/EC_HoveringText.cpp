@@ -17,13 +17,11 @@
 #include "OgreMaterialUtils.h"
 #include "LoggingFunctions.h"
 #include "SceneManager.h"
+#include "LabelAtlas.h"
 
 DEFINE_POCO_LOGGING_FUNCTIONS("EC_Touchable");
 
 #include <Ogre.h>
-#include <OgreBillboardSet.h>
-#include <OgreTextureManager.h>
-#include <OgreResource.h>
 
 #include <QFile>
 #include <QPainter>
@@ -37,8 +35,8 @@ EC_HoveringText::EC_HoveringText(IModule *module) :
     font_(QFont("Arial", 100)),
     backgroundColor_(Qt::transparent),
     textColor_(Qt::black),
-    billboardSet_(0),
-    billboard_(0),
+    quad_(0),
+    label_(0),
     visibility_animation_timeline_(new QTimeLine(1000, this)),
     visibility_timer_(new QTimer(this)),
     usingGradAttr(this, "Use Gradiant", false),
@@ -72,49 +70,28 @@ EC_HoveringText::~EC_HoveringText()
 
 void EC_HoveringText::Destroy()
 {
-	boost::shared_ptr<OgreRenderer::Renderer> renderer = renderer_.lock();
-    if (renderer)
+    OgreRenderer::LabelAtlas *atlas = GetLabelAtlas();
+    if (atlas)
     {
-        try{
-        Ogre::TextureManager::getSingleton().remove(textureName_);
-        } catch(...)
-        {
-        }
-        try{
-        Ogre::MaterialManager::getSingleton().remove(materialName_);
-        } catch(...)
-        {
-        }
-		try{
-		if (billboardSet_ && billboard_)
-			billboardSet_->removeBillboard(billboard_);
-        } catch(...)
-        {
-        }
-		try{
-		
-		if (billboardSet_)
-		{
-			Ogre::SceneManager *scene = renderer->GetSceneManager();
-			if (scene)
-				scene->destroyBillboardSet(billboardSet_);
-		}
-
-        } catch(...)
-        {
-        }
+        atlas->DestroyQuad(quad_);
+        atlas->Release(label_);
     }
 
-	billboard_ = 0;
-	billboardSet_ = 0;
-	textureName_ = "";
-    materialName_ = "";
+    quad_ = 0;
+    label_ = 0;
+}
+
+OgreRenderer::LabelAtlas *EC_HoveringText::GetLabelAtlas() const
+{
+    boost::shared_ptr<OgreRenderer::Renderer> renderer = renderer_.lock();
+    return renderer ? renderer->GetLabelAtlas() : 0;
 }
 
 void EC_HoveringText::SetPosition(const Vector3df& position)
 {
-    if (billboard_)
-        billboard_->setPosition(Ogre::Vector3(position.x, position.y, position.z));
+    OgreRenderer::LabelAtlas *atlas = GetLabelAtlas();
+    if (atlas && quad_)
+        atlas->SetQuadOffset(quad_, Ogre::Vector3(position.x, position.y, position.z));
 }
 
 void EC_HoveringText::SetFont(const QFont &font)
@@ -145,8 +122,9 @@ void EC_HoveringText::SetBackgroundGradient(const QColor &start_color, const QCo
 
 void EC_HoveringText::Show()
 {
-    if (billboardSet_)
-        billboardSet_->setVisible(true);
+    OgreRenderer::LabelAtlas *atlas = GetLabelAtlas();
+    if (atlas && quad_)
+        atlas->SetQuadVisible(quad_, true);
 }
 
 void EC_HoveringText::AnimatedShow()
@@ -175,8 +153,9 @@ void EC_HoveringText::Clicked(int msec_to_show)
 
 void EC_HoveringText::Hide()
 {
-    if (billboardSet_)
-        billboardSet_->setVisible(false);
+    OgreRenderer::LabelAtlas *atlas = GetLabelAtlas();
+    if (atlas && quad_)
+        atlas->SetQuadVisible(quad_, false);
 }
 
 void EC_HoveringText::AnimatedHide()
@@ -192,18 +171,15 @@ void EC_HoveringText::AnimatedHide()
 
 void EC_HoveringText::UpdateAnimationStep(int step)
 {
-    if (materialName_.empty())
+    OgreRenderer::LabelAtlas *atlas = GetLabelAtlas();
+    if (!atlas || !quad_)
         return;
 
     float alpha = step;
     alpha /= 100;
 
-    Ogre::MaterialManager &mgr = Ogre::MaterialManager::getSingleton();
-    Ogre::MaterialPtr material = mgr.getByName(materialName_);
-    assert(material.get());
-
-    material->getTechnique(0)->getPass(0)->getTextureUnitState(0)->setAlphaOperation(
-        Ogre::LBX_BLEND_MANUAL, Ogre::LBS_TEXTURE, Ogre::LBS_MANUAL, 1.0, 0.0, alpha);
+    // The atlas material is shared, so the fading is done with the quad colour
+    atlas->SetQuadAlpha(quad_, alpha);
 }
 
 void EC_HoveringText::AnimationFinished()
@@ -214,20 +190,17 @@ void EC_HoveringText::AnimationFinished()
 
 bool EC_HoveringText::IsVisible() const
 {
-    if (billboardSet_)
-        return billboardSet_->isVisible();
+    OgreRenderer::LabelAtlas *atlas = GetLabelAtlas();
+    if (atlas && quad_)
+        return atlas->IsQuadVisible(quad_);
     else
         return false;
 }
 
 void EC_HoveringText::ShowMessage(const QString &text)
 {
-    if (renderer_.expired())
-        return;
-
-    Ogre::SceneManager *scene = renderer_.lock()->GetSceneManager();
-    assert(scene);
-    if (!scene)
+    OgreRenderer::LabelAtlas *atlas = GetLabelAtlas();
+    if (!atlas)
         return;
 
     Scene::Entity *entity = GetParentEntity();
@@ -244,22 +217,11 @@ void EC_HoveringText::ShowMessage(const QString &text)
     if (!sceneNode)
         return;
 
-    // Create billboard if it doesn't exist.
-    if (!billboardSet_ && !billboard_)
+    // Create the quad if it doesn't exist. The old per-entity billboard was 2 x 1 units for a 1024 x 512 texture.
+    if (!quad_)
     {
-        billboardSet_ = scene->createBillboardSet(renderer_.lock()->GetUniqueObjectName(), 1);
-        assert(billboardSet_);
-
-        materialName_ = std::string("HoveringTextMaterial") + renderer_.lock()->GetUniqueObjectName();
-        OgreRenderer::CloneMaterial("HoveringText", materialName_);
-        billboardSet_->setMaterialName(materialName_);
-        billboardSet_->setCastShadows(false);
-
-        billboard_ = billboardSet_->createBillboard(Ogre::Vector3(0, 0, 0.7f));
-        assert(billboard_);
-        billboardSet_->setDefaultDimensions(2, 1);
-
-        sceneNode->attachObject(billboardSet_);
+        quad_ = atlas->CreateQuad(sceneNode, Ogre::Vector3(0, 0, 0.7f), 2.0f / 1024.0f);
+        assert(quad_);
     }
 
     if (text.isNull() || text.isEmpty())
@@ -271,72 +233,43 @@ void EC_HoveringText::ShowMessage(const QString &text)
 
 void EC_HoveringText::Redraw()
 {
-    if (renderer_.expired() || !billboardSet_ || !billboard_)
+    OgreRenderer::LabelAtlas *atlas = GetLabelAtlas();
+    if (!atlas || !quad_)
         return;
 
-    // Get pixmap with text rendered to it.
-    QPixmap pixmap = GetTextPixmap();
-    if (pixmap.isNull())
-        return;
-    QImage img = pixmap.toImage();
-
-    // Create Ogre texture
-    Ogre::TexturePtr texPtr;
-    try
-    {
-        if (textureName_.empty())
-        {
-            textureName_ = "HoveringTextTexture" + renderer_.lock()->GetUniqueObjectName();
-
-            texPtr = Ogre::TextureManager::getSingleton().createManual(
-                textureName_, Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME, Ogre::TEX_TYPE_2D,
-                img.width(), img.height(), Ogre::MIP_DEFAULT, Ogre::PF_A8R8G8B8, Ogre::TU_DEFAULT);
-
-            assert(!texPtr.isNull());
-            if (texPtr.isNull())
-            {
-                LogError("Failed to create texture " + textureName_);
-                return;
-            }
-        }
-        else
-        {
-            texPtr = Ogre::TextureManager::getSingleton().getByName(textureName_);
-            assert(!texPtr.isNull());
-            // See if size/format changed, have to delete/recreate internal resources
-            if (img.width() != (int)texPtr->getWidth() || img.height() != (int)texPtr->getHeight())
-            {
-                texPtr->freeInternalResources();
-                texPtr->setWidth(img.width());
-                texPtr->setHeight(img.height());
-                texPtr->setFormat(Ogre::PF_A8R8G8B8);
-                texPtr->createInternalResources();
-            }
-        }
-
-        Ogre::Box dimensions(0,0, img.width(), img.height());
-        Ogre::PixelBox pixel_box(dimensions, Ogre::PF_A8R8G8B8, (void*)img.bits());
-        if (!texPtr->getBuffer().isNull())
-            texPtr->getBuffer()->blitFromMemory(pixel_box);
-    }
-    catch (Ogre::Exception &e)
+    // Identical labels, eg. the same name tag shown again, are shared in the atlas and not rendered again.
+    QString key = GetLabelKey();
+    OgreRenderer::LabelAtlas::label_id_t label = atlas->Acquire(key);
+    if (!label)
     {
-        LogError("Failed to create texture " + textureName_  + ": " + std::string(e.what()));
-        return;
+        QSize source_size;
+        QImage img = GetTextImage(atlas->GetLabelScale(), source_size);
+        if (img.isNull())
+            return;
+        label = atlas->Add(key, img, source_size, QSize(1024, 512));
     }
 
-    // Set new texture for the material
-    assert(!materialName_.empty());
-    if (!materialName_.empty())
+    atlas->SetQuadLabel(quad_, label);
+    atlas->Release(label_);
+    label_ = label;
+}
+
+QString EC_HoveringText::GetLabelKey() const
+{
+    QString key = "HoveringText|" + textAttr.Get() + "|" + font_.toString() + "|" +
+        QString::number(textColor_.rgba(), 16) + "|";
+    if (usingGradAttr.Get())
     {
-        Ogre::MaterialManager &mgr = Ogre::MaterialManager::getSingleton();
-        Ogre::MaterialPtr material = mgr.getByName(materialName_);
-        assert(material.get());
-        OgreRenderer::SetTextureUnitOnMaterial(material, textureName_);
+        QGradientStops stops = bg_grad_.stops();
+        for(int i = 0; i < stops.size(); ++i)
+            key += QString::number(stops[i].first) + ":" + QString::number(stops[i].second.rgba(), 16) + ",";
     }
+    else
+        key += QString::number(backgroundColor_.rgba(), 16);
+    return key;
 }
 
-QPixmap EC_HoveringText::GetTextPixmap()
+QImage EC_HoveringText::GetTextImage(float scale, QSize &sourceSize)
 {
 ///\todo Resize the font size according to the render window size and distance
 /// avatar's distance from the camera
@@ -348,27 +281,32 @@ QPixmap EC_HoveringText::GetTextPixmap()
 
 	//if (renderer_.expired() || text_.isEmpty() || text_ == " ")
     if (renderer_.expired())
-        return 0;
+        return QImage();
 
     QRect max_rect(0, 0, 1024, 512);
 
-    // Create transparent pixmap
-    QPixmap pixmap(max_rect.size());
-    pixmap.fill(Qt::transparent);
-
-    // Init painter with pixmap as the paint device
-    QPainter painter(&pixmap);
-
-    // Ask painter the rect for the text
-    painter.setFont(font_);
-    QRect rect = painter.boundingRect(max_rect, Qt::AlignCenter | Qt::TextWordWrap, textAttr.Get());
+    // Ask the rect for the text
+    QFontMetrics metric(font_); 
+    QRect rect = metric.boundingRect(max_rect, Qt::AlignCenter | Qt::TextWordWrap, textAttr.Get());
 
     // Add some padding to it
-    QFontMetrics metric(font_); 
     int width = metric.width(textAttr.Get()) + metric.averageCharWidth();
     int height = metric.height() + 20;
     rect.setWidth(width);
     rect.setHeight(height);
+    rect = rect.intersected(max_rect);
+    if (rect.isEmpty())
+        return QImage();
+
+    // Only the rect is kept in the label atlas, so render it at the origin of a transparent image
+    sourceSize = rect.size();
+    QImage image(qMax(1, (int)ceil(rect.width() * scale)), qMax(1, (int)ceil(rect.height() * scale)), QImage::Format_ARGB32);
+    image.fill(0);
+
+    QPainter painter(&image);
+    painter.scale(scale, scale);
+    painter.translate(-rect.topLeft());
+    painter.setFont(font_);
 
     // Set background brush
     if (usingGradAttr.Get())
@@ -387,7 +325,7 @@ QPixmap EC_HoveringText::GetTextPixmap()
     painter.setPen(textColor_);
     painter.drawText(rect, Qt::AlignCenter | Qt::TextWordWrap, textAttr.Get());
 
-    return pixmap;
+    return image;
 }
 
 void EC_HoveringText::UpdateSignals()
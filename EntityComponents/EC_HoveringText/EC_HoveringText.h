@@ -22,13 +22,7 @@
 namespace OgreRenderer
 {
     class Renderer;
-}
-
-namespace Ogre
-{
-    class SceneNode;
-    class BillboardSet;
-    class Billboard;
+    class LabelAtlas;
 }
 
 QT_BEGIN_NAMESPACE
@@ -210,23 +204,25 @@ private slots:
     void AttributeUpdated(IComponent *component, IAttribute *attribute);
 
 private:
-    /// Returns pixmap with chat bubble and current messages renderer to it.
-    QPixmap GetTextPixmap();
+    /// Returns image with the current text rendered to it.
+    /// @param scale Scale to render the text with.
+    /// @param sourceSize Returns size of the image before scaling.
+    QImage GetTextImage(float scale, QSize &sourceSize);
 
-    /// Renderer pointer.
-    boost::weak_ptr<OgreRenderer::Renderer> renderer_;
+    /// Returns the key that identifies the current text and appearance in the label atlas.
+    QString GetLabelKey() const;
 
-    /// Ogre billboard set.
-    Ogre::BillboardSet *billboardSet_;
+    /// Returns the label atlas of the renderer, or null if the renderer is gone.
+    OgreRenderer::LabelAtlas *GetLabelAtlas() const;
 
-    /// Ogre billboard.
-    Ogre::Billboard *billboard_;
+    /// Renderer pointer.
+    boost::weak_ptr<OgreRenderer::Renderer> renderer_;
 
-    /// Name of the material used for the billboard set.
-    std::string materialName_;
+    /// Quad in the label atlas, 0 if not created yet.
+    uint quad_;
 
-    /// Name of the texture used for the billboard set.
-    std::string textureName_;
+    /// Label in the label atlas, 0 if none.
+    uint label_;
 
     /// The font used for the hovering text.
     QFont font_;
@@ -13,8 +13,37 @@
 
 #include <QTimer>
 
+#include <cctype>
+
 DEFINE_POCO_LOGGING_FUNCTIONS("EC_OpenSimPrim");
 
+namespace
+{
+    //! Returns the first UUID-formatted substring of an asset url, or an empty string.
+    std::string FindEmbeddedUUID(const std::string &asset_id)
+    {
+        const size_t uuid_length = 36;
+        for(size_t i = 0; i + uuid_length <= asset_id.size(); ++i)
+        {
+            size_t j = 0;
+            for(; j < uuid_length; ++j)
+            {
+                char c = asset_id[i + j];
+                if (j == 8 || j == 13 || j == 18 || j == 23)
+                {
+                    if (c != '-')
+                        break;
+                }
+                else if (!isxdigit((unsigned char)c))
+                    break;
+            }
+            if (j == uuid_length)
+                return asset_id.substr(i, uuid_length);
+        }
+        return std::string();
+    }
+}
+
 EC_OpenSimPrim::EC_OpenSimPrim(IModule* module) :
     IComponent(module->GetFramework()),
     editor_(0),
@@ -199,6 +228,56 @@ void EC_OpenSimPrim::setMaterials(QVariantMap &qvmap)
         data.asset_id = strlist[1].toStdString();
         Materials[key.toUInt()] = data;
     }
+
+    UpdateAssetReferences();
+}
+
+void EC_OpenSimPrim::UpdateAssetReferences()
+{
+    Scene::Entity *entity = GetParentEntity();
+    Scene::SceneManager *scene = entity ? entity->GetScene() : 0;
+    if (!scene)
+        return;
+
+    Scene::AssetReferenceIndex &index = scene->GetAssetReferenceIndex();
+    const entity_id_t id = entity->GetId();
+    const uint all_slots = Scene::AssetReferenceIndex::ALL_SLOTS;
+    index.ClearReferences(id, this);
+
+    if (!RexTypes::IsNull(ParticleScriptID))
+        index.AddReference(ParticleScriptID, id, this, all_slots, RexTypes::RexAT_ParticleScript);
+
+    if (DrawType == RexTypes::DRAWTYPE_MESH)
+    {
+        if (!RexTypes::IsNull(MeshID))
+            index.AddReference(MeshID, id, this, all_slots, RexTypes::RexAT_Mesh);
+        if (!RexTypes::IsNull(AnimationPackageID))
+            index.AddReference(AnimationPackageID, id, this, all_slots, RexTypes::RexAT_Skeleton);
+
+        for(MaterialMap::const_iterator i = Materials.begin(); i != Materials.end(); ++i)
+        {
+            if (RexTypes::IsNull(i->second.asset_id))
+                continue;
+            index.AddReference(i->second.asset_id, id, this, i->first, i->second.Type);
+            // Url materials are also findable by the asset UUID they contain.
+            if (!RexUUID::IsValid(i->second.asset_id))
+                index.AddReference(FindEmbeddedUUID(i->second.asset_id), id, this, i->first, i->second.Type);
+        }
+    }
+    else if (DrawType == RexTypes::DRAWTYPE_PRIM)
+    {
+        // A material script in the first material slot overrides the face textures of the whole prim.
+        MaterialMap::const_iterator override_mat = Materials.find(0);
+        if (override_mat != Materials.end() && override_mat->second.Type == RexTypes::RexAT_MaterialScript &&
+            !RexTypes::IsNull(override_mat->second.asset_id))
+            index.AddReference(override_mat->second.asset_id, id, this, all_slots, RexTypes::RexAT_MaterialScript);
+
+        if (!RexTypes::IsNull(PrimDefaultTextureID))
+            index.AddReference(PrimDefaultTextureID, id, this, all_slots, RexTypes::RexAT_Texture);
+        for(TextureMap::const_iterator i = PrimTextures.begin(); i != PrimTextures.end(); ++i)
+            if (!RexTypes::IsNull(i->second))
+                index.AddReference(i->second, id, this, i->first, RexTypes::RexAT_Texture);
+    }
 }
 
 QStringList EC_OpenSimPrim::GetChildren()
@@ -248,6 +327,7 @@ void EC_OpenSimPrim::MyPropertyChanged(QObject *obj, const QString & property_na
 void EC_OpenSimPrim::SendRexPrimDataUpdate()
 {
     rex_prim_data_timer_->stop();
+    UpdateAssetReferences();
     emit RexPrimDataChanged(GetParentEntity());
 }
 
@@ -448,6 +448,13 @@ public:
     float ProfileHollow;*/
     bool HasPrimShapeData;
 
+    //! Registers the assets this prim uses (mesh, materials, textures) to the asset reference index of the scene.
+    /*! Replaces the previously registered references. Must be called after modifying DrawType, MeshID,
+        AnimationPackageID, ParticleScriptID, Materials, PrimDefaultTextureID or PrimTextures.
+        The slot of a reference is the submesh index for mesh prims and the face index for other prims.
+     */
+    void UpdateAssetReferences();
+
 public slots:
     QStringList GetChildren();
 
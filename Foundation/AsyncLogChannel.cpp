@@ -0,0 +1,216 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+
+#include "StableHeaders.h"
+#include "AsyncLogChannel.h"
+
+#include <Poco/Message.h>
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+
+namespace Foundation
+{
+    namespace
+    {
+        //! Orders queued messages by their sequence numbers
+        struct EntryOrder
+        {
+            template <typename T> bool operator()(const T &a, const T &b) const
+            {
+                // The sequence may wrap around, compare the difference
+                return (int)((uint)a.sequence - (uint)b.sequence) < 0;
+            }
+        };
+    }
+
+    AsyncLogChannel::AsyncLogChannel(Poco::Channel *target, uint bufferSize, uint interval) :
+        target_(target),
+        bufferSize_(bufferSize > 0 ? bufferSize : 1),
+        interval_(interval > 0 ? interval : 1),
+        sequence_(0),
+        closed_(0),
+        overflows_(0),
+        messages_(0),
+        drains_(0),
+        maxBacklog_(0),
+        stop_(false),
+        thread_(0)
+    {
+        assert(target_);
+        target_->duplicate();
+        thread_ = new Thread(boost::bind(&AsyncLogChannel::Run, this));
+    }
+
+    AsyncLogChannel::~AsyncLogChannel()
+    {
+        close();
+        // Write what was queued while closing. Threads that are still running keep their buffers until they exit.
+        Flush();
+        buffers_.clear();
+        target_->release();
+    }
+
+    AsyncLogChannel::ThreadBuffer *AsyncLogChannel::GetThreadBuffer()
+    {
+        ThreadBufferPtr *buffer = threadBuffer_.get();
+        if (!buffer)
+        {
+            buffer = new ThreadBufferPtr(new ThreadBuffer(bufferSize_));
+            threadBuffer_.reset(buffer);
+            MutexLock lock(buffersMutex_);
+            buffers_.push_back(*buffer);
+        }
+        return buffer->get();
+    }
+
+    void AsyncLogChannel::log(const Poco::Message &msg)
+    {
+        messages_.fetchAndAddRelaxed(1);
+        if (closed_)
+        {
+            Write(msg);
+            return;
+        }
+
+        ThreadBuffer *buffer = GetThreadBuffer();
+        int slots = buffer->entries.size();
+        int write_index = buffer->writeIndex;
+        int next = (write_index + 1) % slots;
+        if (next == buffer->readIndex.fetchAndAddAcquire(0))
+        {
+            // Buffer is full. Write the older messages first so that this one is not ahead of them.
+            overflows_.fetchAndAddRelaxed(1);
+            Flush();
+            Write(msg);
+            return;
+        }
+
+        Entry &entry = buffer->entries[write_index];
+        entry.message = new Poco::Message(msg);
+        entry.sequence = sequence_.fetchAndAddRelaxed(1);
+        // Publish the entry only after it has been written
+        buffer->writeIndex.fetchAndStoreOrdered(next);
+
+        // If the channel was closed meanwhile, its last flush may have missed the entry
+        if (closed_.fetchAndAddOrdered(0) || msg.getPriority() <= Poco::Message::PRIO_CRITICAL)
+            Flush();
+        else if (msg.getPriority() <= Poco::Message::PRIO_ERROR)
+            wake_.notify_one();
+    }
+
+    void AsyncLogChannel::close()
+    {
+        if (closed_.fetchAndStoreOrdered(1))
+            return;
+
+        {
+            MutexLock lock(wakeMutex_);
+            stop_ = true;
+        }
+        wake_.notify_one();
+        if (thread_)
+        {
+            thread_->join();
+            delete thread_;
+            thread_ = 0;
+        }
+
+        Flush();
+    }
+
+    void AsyncLogChannel::Flush()
+    {
+        MutexLock lock(drainMutex_);
+        Drain();
+    }
+
+    AsyncLogChannel::Stats AsyncLogChannel::GetStats() const
+    {
+        Stats stats;
+        stats.messages = (int)messages_;
+        stats.overflows = (int)overflows_;
+        {
+            MutexLock lock(const_cast<Mutex &>(drainMutex_));
+            stats.drains = drains_;
+            stats.maxBacklog = maxBacklog_;
+        }
+        {
+            MutexLock lock(const_cast<Mutex &>(buffersMutex_));
+            stats.threads = buffers_.size();
+        }
+        return stats;
+    }
+
+    void AsyncLogChannel::Drain()
+    {
+        drained_.clear();
+        {
+            MutexLock lock(buffersMutex_);
+            for(size_t i = 0; i < buffers_.size();)
+            {
+                // Only the channel refers to the buffer of a thread that has exited, so nothing more is written to it
+                bool exited = buffers_[i].unique();
+                ThreadBuffer *buffer = buffers_[i].get();
+                int slots = buffer->entries.size();
+                int read_index = buffer->readIndex;
+                int write_index = buffer->writeIndex.fetchAndAddAcquire(0);
+                while (read_index != write_index)
+                {
+                    drained_.push_back(buffer->entries[read_index]);
+                    read_index = (read_index + 1) % slots;
+                }
+                // Release the slots only after the entries have been read
+                buffer->readIndex.fetchAndStoreRelease(read_index);
+
+                if (exited)
+                    buffers_.erase(buffers_.begin() + i);
+                else
+                    ++i;
+            }
+        }
+
+        if (drained_.empty())
+            return;
+
+        std::sort(drained_.begin(), drained_.end(), EntryOrder());
+        for(size_t i = 0; i < drained_.size(); ++i)
+        {
+            Write(*drained_[i].message);
+            delete drained_[i].message;
+        }
+
+        ++drains_;
+        if (drained_.size() > maxBacklog_)
+            maxBacklog_ = drained_.size();
+        drained_.clear();
+    }
+
+    void AsyncLogChannel::Write(const Poco::Message &msg)
+    {
+        try
+        {
+            target_->log(msg);
+        }
+        catch(...)
+        {
+            // A failing log file must not take down the writer thread
+        }
+    }
+
+    void AsyncLogChannel::Run()
+    {
+        for(;;)
+        {
+            {
+                ScopedLock lock(wakeMutex_);
+                if (stop_)
+                    break;
+                wake_.timed_wait(lock, boost::posix_time::milliseconds(interval_));
+                if (stop_)
+                    break;
+            }
+            Flush();
+        }
+    }
+}
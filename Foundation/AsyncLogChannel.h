@@ -0,0 +1,143 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+
+#ifndef incl_Foundation_AsyncLogChannel_h
+#define incl_Foundation_AsyncLogChannel_h
+
+#include "CoreTypes.h"
+#include "CoreThread.h"
+
+#include <Poco/Channel.h>
+
+#include <boost/thread/tss.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <QAtomicInt>
+
+#include <vector>
+
+namespace Poco
+{
+    class Message;
+}
+
+namespace Foundation
+{
+    //! Log channel that hands the messages to a background thread, which writes them to the actual channel.
+    /*! Logging threads copy the message to a buffer of their own and return. The buffer is a lock-free queue
+        between the logging thread and the writer thread, so logging takes no locks and does no I/O unless the
+        buffer is full, in which case the message is written right away. The writer thread writes the messages
+        of all threads in the order they were logged. Messages of priority error and above wake the writer up,
+        and fatal and critical messages are written before log() returns, so that they are not lost in a crash.
+
+        The channel is created by Framework and set as the channel of the root logger, see log_async in the
+        configuration.
+     */
+    class AsyncLogChannel : public Poco::Channel
+    {
+    public:
+        //! Statistics of the channel
+        struct Stats
+        {
+            //! Messages logged
+            u64 messages;
+            //! Messages written by the logging thread because its buffer was full
+            u64 overflows;
+            //! Times the writer thread has written messages
+            u64 drains;
+            //! Most messages written at once
+            uint maxBacklog;
+            //! Number of running threads that have logged
+            uint threads;
+        };
+
+        //! Constructor. Starts the writer thread.
+        /*! \param target Channel the messages are written to
+            \param bufferSize Maximum number of messages buffered per logging thread
+            \param interval Time in milliseconds the writer thread waits between writes when nothing wakes it up
+         */
+        AsyncLogChannel(Poco::Channel *target, uint bufferSize = 4096, uint interval = 50);
+
+        //! Poco::Channel override. Queues the message.
+        virtual void log(const Poco::Message &msg);
+
+        //! Poco::Channel override. Stops the writer thread and writes the remaining messages.
+        /*! Messages logged after close() are written directly to the target channel.
+         */
+        virtual void close();
+
+        //! Writes all queued messages. Can be called from any thread.
+        void Flush();
+
+        //! Returns statistics of the channel
+        Stats GetStats() const;
+
+    protected:
+        //! Destructor. Closes the channel.
+        virtual ~AsyncLogChannel();
+
+    private:
+        struct Entry
+        {
+            Poco::Message *message;
+            //! Order in which the messages were logged
+            int sequence;
+        };
+
+        //! Messages of one logging thread. Written only by that thread and read only with drainMutex_ held.
+        /*! Shared by the channel and the thread, so that the buffer of an exited thread is freed once it has been drained.
+         */
+        struct ThreadBuffer
+        {
+            explicit ThreadBuffer(uint size) : entries(size + 1), readIndex(0), writeIndex(0) {}
+            //! One slot is always left empty to tell a full buffer from an empty one
+            std::vector<Entry> entries;
+            QAtomicInt readIndex;
+            QAtomicInt writeIndex;
+        };
+
+        //! Returns the buffer of the calling thread, creating it on first use
+        ThreadBuffer *GetThreadBuffer();
+
+        //! Writes the queued messages of all threads, in order, and frees the buffers of exited threads. Called with drainMutex_ held.
+        void Drain();
+
+        //! Writes a message to the target channel
+        void Write(const Poco::Message &msg);
+
+        //! Writer thread main loop
+        void Run();
+
+        Poco::Channel *target_;
+        uint bufferSize_;
+        uint interval_;
+
+        typedef boost::shared_ptr<ThreadBuffer> ThreadBufferPtr;
+
+        //! Buffer of each logging thread. The thread's reference is released when the thread exits.
+        boost::thread_specific_ptr<ThreadBufferPtr> threadBuffer_;
+        std::vector<ThreadBufferPtr> buffers_;
+        //! Protects buffers_
+        Mutex buffersMutex_;
+
+        //! Held while writing the queued messages
+        Mutex drainMutex_;
+        //! Entries being written, kept to reuse the memory
+        std::vector<Entry> drained_;
+
+        QAtomicInt sequence_;
+        QAtomicInt closed_;
+        QAtomicInt overflows_;
+        QAtomicInt messages_;
+        //! Protected by drainMutex_
+        u64 drains_;
+        //! Protected by drainMutex_
+        uint maxBacklog_;
+
+        Mutex wakeMutex_;
+        Condition wake_;
+        bool stop_;
+        Thread *thread_;
+    };
+}
+
+#endif
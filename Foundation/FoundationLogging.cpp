@@ -2,44 +2,72 @@
 
 #include "StableHeaders.h"
 #include "ForwardDefines.h"
+#include "CoreCompileConfig.h"
 
 #include <Poco/Logger.h>
+#include <Poco/AutoPtr.h>
+
+namespace
+{
+    //! Returns the Foundation logger, looked up only once
+    Poco::Logger &FoundationLogger()
+    {
+        static Poco::AutoPtr<Poco::Logger> logger(&Poco::Logger::get("Foundation"), true);
+        return *logger;
+    }
+}
 
 void RootLogFatal(const std::string &msg)
 {
-    Poco::Logger::get("Foundation").fatal("Fatal: " + msg);
+    Poco::Logger &logger = FoundationLogger();
+    if (Poco::Message::PRIO_FATAL <= NAALI_LOG_LEVEL && logger.is(Poco::Message::PRIO_FATAL))
+        logger.fatal("Fatal: " + msg);
 }
 
 void RootLogCritical(const std::string &msg)
 {
-    Poco::Logger::get("Foundation").critical("Critical: " + msg);
+    Poco::Logger &logger = FoundationLogger();
+    if (Poco::Message::PRIO_CRITICAL <= NAALI_LOG_LEVEL && logger.is(Poco::Message::PRIO_CRITICAL))
+        logger.critical("Critical: " + msg);
 }
 
 void RootLogError(const std::string &msg)
 {
-    Poco::Logger::get("Foundation").error("Error: " + msg);
+    Poco::Logger &logger = FoundationLogger();
+    if (Poco::Message::PRIO_ERROR <= NAALI_LOG_LEVEL && logger.is(Poco::Message::PRIO_ERROR))
+        logger.error("Error: " + msg);
 }
 
 void RootLogWarning(const std::string &msg)
 {
-    Poco::Logger::get("Foundation").warning("Warning: " + msg);
+    Poco::Logger &logger = FoundationLogger();
+    if (Poco::Message::PRIO_WARNING <= NAALI_LOG_LEVEL && logger.is(Poco::Message::PRIO_WARNING))
+        logger.warning("Warning: " + msg);
 }
 
 void RootLogNotice(const std::string &msg)
 {
-    Poco::Logger::get("Foundation").notice("Notice: " + msg);
+    Poco::Logger &logger = FoundationLogger();
+    if (Poco::Message::PRIO_NOTICE <= NAALI_LOG_LEVEL && logger.is(Poco::Message::PRIO_NOTICE))
+        logger.notice("Notice: " + msg);
 }
 void RootLogInfo(const std::string &msg)
 {
-    Poco::Logger::get("Foundation").information(msg);
+    Poco::Logger &logger = FoundationLogger();
+    if (Poco::Message::PRIO_INFORMATION <= NAALI_LOG_LEVEL && logger.is(Poco::Message::PRIO_INFORMATION))
+        logger.information(msg);
 }
 
 void RootLogTrace(const std::string &msg)
 {
-    Poco::Logger::get("Foundation").trace("Trace: " + msg);
+    Poco::Logger &logger = FoundationLogger();
+    if (Poco::Message::PRIO_TRACE <= NAALI_LOG_LEVEL && logger.is(Poco::Message::PRIO_TRACE))
+        logger.trace("Trace: " + msg);
 }
 
 void RootLogDebug(const std::string &msg)
 {
-    Poco::Logger::get("Foundation").debug("Debug: " + msg);
+    Poco::Logger &logger = FoundationLogger();
+    if (Poco::Message::PRIO_DEBUG <= NAALI_LOG_LEVEL && logger.is(Poco::Message::PRIO_DEBUG))
+        logger.debug("Debug: " + msg);
 }
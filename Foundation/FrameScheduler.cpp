@@ -0,0 +1,170 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+
+#include "StableHeaders.h"
+#include "DebugOperatorNew.h"
+
+#include "FrameScheduler.h"
+#include "Framework.h"
+#include "ConfigurationManager.h"
+#include "Profiler.h"
+#include "CoreStringUtils.h"
+
+#include <algorithm>
+
+#include "MemoryLeakCheck.h"
+
+namespace Foundation
+{
+    FrameScheduler::FrameScheduler(Framework *framework) :
+        budget_(0.004),
+        next_id_(1),
+        running_index_(0),
+        last_frame_work_count_(0),
+        last_frame_work_time_(0.0),
+        overrun_count_(0),
+        framework_(framework)
+    {
+        // Budget is stored in milliseconds in the config for readability.
+        float budget_ms = framework_->GetDefaultConfig().DeclareSetting(ConfigurationGroup(), "frame_budget_ms", 4.f);
+        budget_ = (budget_ms > 0.f) ? budget_ms / 1000.0 : 0.0;
+    }
+
+    FrameScheduler::~FrameScheduler()
+    {
+        if (!work_.empty())
+            RootLogDebug("FrameScheduler: discarding " + ToString(work_.size()) + " pending work items.");
+        work_.clear();
+    }
+
+    bool FrameScheduler::RunsBefore(const WorkItem &lhs, const WorkItem &rhs)
+    {
+        if (lhs.priority_ != rhs.priority_)
+            return lhs.priority_ > rhs.priority_;
+        return lhs.id_ < rhs.id_;
+    }
+
+    frame_work_id_t FrameScheduler::QueueWork(const std::string &name, const WorkFunction &work, int priority, double deadline)
+    {
+        if (work.empty())
+        {
+            RootLogWarning("FrameScheduler::QueueWork: tried to queue empty work function " + name);
+            return 0;
+        }
+
+        WorkItem item;
+        item.id_ = next_id_++;
+        if (next_id_ == 0)
+            next_id_ = 1;
+        item.name_ = name;
+        item.function_ = work;
+        item.priority_ = priority;
+        item.deadline_ = 0;
+        item.cancelled_ = false;
+        if (deadline >= 0.0)
+            item.deadline_ = GetCurrentClockTime() + (tick_t)(deadline * GetCurrentClockFreq());
+
+        // Keep the queue sorted so that RunQueuedWork() can just walk it from the front.
+        std::vector<WorkItem>::iterator pos = std::upper_bound(work_.begin(), work_.end(), item, &FrameScheduler::RunsBefore);
+        work_.insert(pos, item);
+        return item.id_;
+    }
+
+    bool FrameScheduler::CancelWork(frame_work_id_t id)
+    {
+        for(std::vector<WorkItem>::iterator it = work_.begin(); it != work_.end(); ++it)
+            if (it->id_ == id)
+            {
+                work_.erase(it);
+                return true;
+            }
+
+        // Work already taken for this frame is only marked, as RunQueuedWork() is walking the list.
+        for(size_t i = running_index_ + 1; i < running_.size(); ++i)
+            if (running_[i].id_ == id && !running_[i].cancelled_)
+            {
+                running_[i].cancelled_ = true;
+                return true;
+            }
+        return false;
+    }
+
+    void FrameScheduler::RunWorkItem(const WorkItem &item)
+    {
+        try
+        {
+            item.function_();
+        }
+        catch(const std::exception &e)
+        {
+            RootLogError("FrameScheduler: work item " + item.name_ + " threw an exception: " + (e.what() ? e.what() : "(null)"));
+        }
+        catch(...)
+        {
+            RootLogError("FrameScheduler: work item " + item.name_ + " threw an unknown exception.");
+        }
+    }
+
+    void FrameScheduler::RunQueuedWork()
+    {
+        last_frame_work_count_ = 0;
+        last_frame_work_time_ = 0.0;
+        if (work_.empty())
+            return;
+
+        const tick_t freq = GetCurrentClockFreq();
+        const tick_t start = GetCurrentClockTime();
+        const tick_t budget_ticks = (tick_t)(budget_ * freq);
+        bool overrun = false;
+
+        // Take the current queue; work queued by the work items themselves is run at the earliest next frame.
+        running_.swap(work_);
+
+        for(running_index_ = 0; running_index_ < running_.size(); ++running_index_)
+        {
+            // Copy, as work items may cancel later items of the list
+            const WorkItem item = running_[running_index_];
+            if (item.cancelled_)
+                continue;
+
+            const tick_t now = GetCurrentClockTime();
+            const bool budget_left = (now - start) < budget_ticks;
+            const bool deadline_passed = item.deadline_ != 0 && now >= item.deadline_;
+
+            if (!budget_left && !deadline_passed)
+            {
+                // Carry over, but keep looking for items whose deadline has passed.
+                work_.push_back(item);
+                continue;
+            }
+
+            RunWorkItem(item);
+            ++last_frame_work_count_;
+
+            if (!overrun && (GetCurrentClockTime() - start) > budget_ticks)
+            {
+                overrun = true;
+                ++overrun_count_;
+#ifdef PROFILING
+                // Attribute the hitch to the work item that pushed the frame over budget. The block is empty
+                // on purpose: its call count tells how many frames this work caused an overrun in.
+                Profiler *profiler = ProfilerSection::GetProfiler();
+                if (profiler)
+                {
+                    std::string block_name = "FrameScheduler_Overrun_" + item.name_;
+                    profiler->StartBlock(block_name);
+                    profiler->EndBlock(block_name);
+                }
+#endif
+            }
+        }
+
+        running_.clear();
+        running_index_ = 0;
+
+        // Work queued during this frame must be merged back in order.
+        if (!work_.empty())
+            std::stable_sort(work_.begin(), work_.end(), &FrameScheduler::RunsBefore);
+
+        last_frame_work_time_ = (double)(GetCurrentClockTime() - start) / (double)freq;
+    }
+}
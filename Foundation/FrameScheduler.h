@@ -0,0 +1,155 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+
+#ifndef incl_Foundation_FrameScheduler_h
+#define incl_Foundation_FrameScheduler_h
+
+#include "HighPerfClock.h"
+
+#include <boost/function.hpp>
+#include <boost/cstdint.hpp>
+
+#include <string>
+#include <vector>
+
+namespace Foundation
+{
+    class Framework;
+
+    //! Identifies a deferred work item queued to the FrameScheduler. Zero is never a valid id.
+    typedef boost::uint32_t frame_work_id_t;
+
+    //! Runs deferrable per-frame work within a time budget.
+    /*! Modules that have work which does not need to be finished during the frame it was produced in
+        (asset processing, prim meshing, avatar appearance setup, texture uploads, UI refreshes...) can queue
+        it here instead of doing it immediately in their Update() or event handlers. Framework runs the queue
+        once per frame, after the mandatory module updates, thread task results and delayed events, and stops
+        when the frame budget has been used. Work that did not fit is carried over to the next frame.
+
+        Work items are run in priority order, higher priority first. Items with equal priority run in the order
+        they were queued. An item whose deadline has passed is always run, even if the budget is already used,
+        so that low priority work can not starve forever.
+
+        Budget overruns are recorded through the profiler: the work item that caused the frame to go over budget
+        is reported under a "FrameScheduler_Overrun_<name>" block, so hitches can be attributed to the module that
+        queued the work.
+
+        The scheduler is not threadsafe. Queue work only from the main thread.
+
+        \ingroup Foundation_group
+    */
+    class FrameScheduler
+    {
+    public:
+        //! Deferred work function.
+        typedef boost::function<void()> WorkFunction;
+
+        //! Priority classes for deferred work. Any integer value may be used, these are provided for consistency.
+        enum Priority
+        {
+            PriorityLow = 0,
+            PriorityNormal = 50,
+            PriorityHigh = 100
+        };
+
+        //! Constructor.
+        /*! \param framework Framework, needed for reading the budget from config.
+        */
+        explicit FrameScheduler(Framework *framework);
+
+        //! Destructor. Pending work is discarded without running it.
+        ~FrameScheduler();
+
+        //! Queues a work item.
+        /*! \param name Descriptive name of the work, used in profiling data. F.ex. "Primitive_CreateGeometry".
+            \param work Function to run.
+            \param priority Priority of the work, higher is run first.
+            \param deadline Time in seconds from now after which the work is run regardless of the budget.
+                   Negative value means no deadline.
+            \return Id of the queued work, can be used to cancel it.
+        */
+        frame_work_id_t QueueWork(const std::string &name, const WorkFunction &work, int priority = PriorityNormal, double deadline = -1.0);
+
+        //! Cancels a queued work item.
+        /*! Can also be called from a work item, to cancel work that was taken to be run during the same frame.
+            \return True if the work was still pending and will not be run, false otherwise.
+        */
+        bool CancelWork(frame_work_id_t id);
+
+        //! Runs queued work until the frame budget is used. Called by Framework on each run of the main loop.
+        void RunQueuedWork();
+
+        //! Sets the per-frame budget in seconds.
+        void SetFrameBudget(double seconds) { budget_ = seconds; }
+
+        //! Returns the per-frame budget in seconds.
+        double GetFrameBudget() const { return budget_; }
+
+        //! Returns number of pending work items.
+        size_t GetPendingWorkCount() const { return work_.size(); }
+
+        //! Returns number of work items run during the last frame.
+        size_t GetLastFrameWorkCount() const { return last_frame_work_count_; }
+
+        //! Returns time in seconds spent running work during the last frame.
+        double GetLastFrameWorkTime() const { return last_frame_work_time_; }
+
+        //! Returns total number of frames in which the budget was exceeded.
+        size_t GetOverrunCount() const { return overrun_count_; }
+
+        //! Returns name of the configuration group used by the scheduler.
+        static const std::string &ConfigurationGroup()
+        {
+            static std::string group("FrameScheduler");
+            return group;
+        }
+
+    private:
+        //! Queued unit of work.
+        struct WorkItem
+        {
+            frame_work_id_t id_;
+            std::string name_;
+            WorkFunction function_;
+            int priority_;
+            //! Clock tick after which the work must be run, zero if no deadline.
+            tick_t deadline_;
+            //! Whether the work was cancelled after RunQueuedWork() took it.
+            bool cancelled_;
+        };
+
+        //! Ordering used for the work queue; higher priority and earlier queued first.
+        static bool RunsBefore(const WorkItem &lhs, const WorkItem &rhs);
+
+        //! Runs a single work item, catching and logging any exceptions.
+        void RunWorkItem(const WorkItem &item);
+
+        //! Pending work, kept sorted by RunsBefore().
+        std::vector<WorkItem> work_;
+
+        //! Work taken by RunQueuedWork() for the current frame.
+        std::vector<WorkItem> running_;
+
+        //! Index of the item in running_ that is being run.
+        size_t running_index_;
+
+        //! Per-frame budget in seconds.
+        double budget_;
+
+        //! Next id to give out.
+        frame_work_id_t next_id_;
+
+        //! Number of work items run during last frame.
+        size_t last_frame_work_count_;
+
+        //! Time spent running work during last frame.
+        double last_frame_work_time_;
+
+        //! Number of frames in which budget was exceeded.
+        size_t overrun_count_;
+
+        //! Framework.
+        Framework *framework_;
+    };
+}
+
+#endif
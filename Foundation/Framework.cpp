@@ -14,6 +14,7 @@
 #include "ServiceManager.h"
 #include "ResourceInterface.h"
 #include "ThreadTaskManager.h"
+#include "FrameScheduler.h"
 #include "RenderServiceInterface.h"
 #include "ConsoleServiceInterface.h"
 #include "ConsoleCommandServiceInterface.h"
@@ -31,14 +32,21 @@
 
 #include "SceneManager.h"
 #include "SceneEvents.h"
+#include "AsyncLogChannel.h"
+#include "HighPerfClock.h"
 
 #include <Poco/Logger.h>
 #include <Poco/LoggingFactory.h>
 #include <Poco/FormattingChannel.h>
 #include <Poco/SplitterChannel.h>
+#include <Poco/FileChannel.h>
+#include <Poco/AutoPtr.h>
+#include <Poco/File.h>
 #include <Poco/Path.h>
 #include <Poco/UnicodeConverter.h>
 
+#include <sstream>
+
 #include <QApplication>
 #include <QGraphicsView>
 #include <QIcon>
@@ -79,6 +87,7 @@ namespace Foundation
         argv_(argv),
         initialized_(false),
         log_formatter_(0),
+        async_log_channel_(0),
         splitterchannel(0),
         naaliApplication(0),
         frame(new Frame(this)),
@@ -108,6 +117,8 @@ namespace Foundation
             config_manager_->DeclareSetting(Framework::ConfigurationGroup(), std::string("window_title"), std::string("realXtend Naali"));
             config_manager_->DeclareSetting(Framework::ConfigurationGroup(), std::string("log_console"), bool(true));
             config_manager_->DeclareSetting(Framework::ConfigurationGroup(), std::string("log_level"), std::string("information"));
+            config_manager_->DeclareSetting(Framework::ConfigurationGroup(), std::string("log_async"), bool(true));
+            config_manager_->DeclareSetting(Framework::ConfigurationGroup(), std::string("log_async_buffer"), int(4096));
             
             platform_->PrepareApplicationDataDirectory(); // depends on config
 
@@ -136,6 +147,7 @@ namespace Foundation
             service_manager_ = ServiceManagerPtr(new ServiceManager());
             event_manager_ = EventManagerPtr(new EventManager(this));
             thread_task_manager_ = ThreadTaskManagerPtr(new ThreadTaskManager(this));
+            frame_scheduler_ = FrameSchedulerPtr(new FrameScheduler(this));
 
             Scene::Events::RegisterSceneEvents(event_manager_);
             Resource::Events::RegisterResourceEvents(event_manager_);
@@ -161,6 +173,7 @@ namespace Foundation
 
     Framework::~Framework()
     {
+        frame_scheduler_.reset();
         thread_task_manager_.reset();
         event_manager_.reset();
         service_manager_.reset();
@@ -170,6 +183,10 @@ namespace Foundation
         platform_.reset();
         application_.reset();
 
+        // Write what is left in the log buffers. Anything logged after this is written right away.
+        if (async_log_channel_)
+            async_log_channel_->close();
+
         Poco::Logger::shutdown();
 
         for (size_t i=0 ; i<log_channels_.size() ; ++i)
@@ -210,19 +227,41 @@ namespace Foundation
         filechannel->setProperty("archive","number");
         filechannel->setProperty("compress","false");
 
+        // Open the log file here, as with log_async the first write happens in the writer thread, which cannot
+        // report a failure.
+        bool file_opened = true;
+        try
+        {
+            filechannel->open();
+        }
+        catch(Poco::OpenFileException &/*e*/)
+        {
+            file_opened = false;
+        }
+
         splitterchannel = new Poco::SplitterChannel();
         if (consolechannel)
             splitterchannel->addChannel(consolechannel);
-        splitterchannel->addChannel(filechannel); 
+        if (file_opened)
+            splitterchannel->addChannel(filechannel); 
 
         log_formatter_ = loggingfactory->createFormatter("PatternFormatter");
         log_formatter_->setProperty("pattern","%H:%M:%S [%s] %t");
         log_formatter_->setProperty("times","local");
         Poco::Channel *formatchannel = new Poco::FormattingChannel(log_formatter_,splitterchannel);
 
+        // Format and write the log in a background thread, so that logging does not wait for I/O
+        Poco::Channel *rootchannel = formatchannel;
+        if (config_manager_->GetSetting<bool>(Framework::ConfigurationGroup(), "log_async"))
+        {
+            int buffer_size = config_manager_->GetSetting<int>(Framework::ConfigurationGroup(), "log_async_buffer");
+            async_log_channel_ = new AsyncLogChannel(formatchannel, buffer_size > 0 ? buffer_size : 4096);
+            rootchannel = async_log_channel_;
+        }
+
         try
         {
-            Poco::Logger::create("",formatchannel,Poco::Message::PRIO_TRACE);
+            Poco::Logger::create("",rootchannel,Poco::Message::PRIO_TRACE);
             Poco::Logger::create("Foundation",Poco::Logger::root().getChannel() ,Poco::Message::PRIO_TRACE);
         }
         catch (Poco::ExistsException &/*e*/)
@@ -230,21 +269,20 @@ namespace Foundation
             assert (false && "Somewhere, a message is pushed to log before the logger is initialized.");
         }
 
-        try
-        {
+        if (file_opened)
             RootLogInfo("Log file opened on " + GetLocalDateTimeString());
-        }
-        catch(Poco::OpenFileException &/*e*/)
+        else
         {
             // Do not create the log file.
-            splitterchannel->removeChannel(filechannel);
             RootLogInfo("Poco::OpenFileException. Log file not created.");
         }
 
 #ifndef _DEBUG
-        // make it so debug messages are not logged in release mode
+        // make it so debug messages are not logged in release mode. The module loggers are created later
+        // and inherit the level of the root logger.
         std::string log_level = config_manager_->GetSetting<std::string>(Framework::ConfigurationGroup(), "log_level");
-        Poco::Logger::get("Foundation").setLevel(log_level);
+        Poco::Logger::root().setLevel(log_level);
+        Poco::Logger::setLevel("", Poco::Logger::root().getLevel());
 #endif
 
         if (consolechannel)
@@ -252,6 +290,8 @@ namespace Foundation
         log_channels_.push_back(filechannel);
         log_channels_.push_back(splitterchannel);
         log_channels_.push_back(formatchannel);
+        if (async_log_channel_)
+            log_channels_.push_back(async_log_channel_);
 
         SAFE_DELETE(loggingfactory);
     }
@@ -339,6 +379,19 @@ namespace Foundation
                 event_manager_->ProcessDelayedEvents(frametime);
             }
 
+            // run deferred work queued by modules, within the frame budget
+            {
+                PROFILE(FW_RunDeferredWork);
+                frame_scheduler_->RunQueuedWork();
+            }
+
+            // deliver attribute changes that scenes have coalesced during the frame
+            {
+                PROFILE(FW_FlushAttributeChanges);
+                for(SceneMap::iterator it = scenes_.begin(); it != scenes_.end(); ++it)
+                    it->second->FlushAttributeChanges();
+            }
+
             // if we have a renderer service, render now
             boost::weak_ptr<Foundation::RenderServiceInterface> renderer = service_manager_->GetService<RenderServiceInterface>();
             if (renderer.expired() == false)
@@ -488,6 +541,19 @@ namespace Foundation
         return Console::ResultSuccess();
     }
 
+    Console::CommandResult Framework::ConsoleStartupTimeline(const StringVector &params)
+    {
+        boost::shared_ptr<Console::ConsoleServiceInterface> console = GetService<Console::ConsoleServiceInterface>(Service::ST_Console).lock();
+        if (console)
+        {
+            StringVector lines = SplitString(module_manager_->GetStartupTimelineReport(), '\n');
+            for(size_t i = 0 ; i < lines.size() ; ++i)
+                console->Print(lines[i]);
+        }
+
+        return Console::ResultSuccess();
+    }
+
     Console::CommandResult Framework::ConsoleSendEvent(const StringVector &params)
     {
         if (params.size() != 2)
@@ -503,6 +569,110 @@ namespace Foundation
         }
     }
 
+    Console::CommandResult Framework::ConsoleLogLevel(const StringVector &params)
+    {
+        if (params.size() < 1 || params.size() > 2)
+            return Console::ResultInvalidParameters();
+
+        try
+        {
+            if (params.size() == 2)
+                Poco::Logger::get(params[1]).setLevel(params[0]);
+            else
+            {
+                Poco::Logger::root().setLevel(params[0]);
+                Poco::Logger::setLevel("", Poco::Logger::root().getLevel());
+            }
+        }
+        catch(Poco::InvalidArgumentException &)
+        {
+            return Console::ResultFailure("Unknown log level " + params[0] +
+                ". Use none, fatal, critical, error, warning, notice, information, debug or trace.");
+        }
+        return Console::ResultSuccess();
+    }
+
+    Console::CommandResult Framework::ConsoleBenchLogging(const StringVector &params)
+    {
+        int count = 10000;
+        if (params.size() > 0)
+            count = ParseString<int>(params[0], count);
+        if (count <= 0)
+            return Console::ResultInvalidParameters();
+
+        // Log to a file of its own, formatted the same way as the real log
+        std::string path = platform_->GetUserDocumentsDirectory() + "/" + std::string(APPLICATION_NAME) + "_logbench.log";
+        Poco::AutoPtr<Poco::FileChannel> file_channel(new Poco::FileChannel(path));
+        Poco::AutoPtr<Poco::FormattingChannel> format_channel(new Poco::FormattingChannel(log_formatter_, file_channel));
+        Poco::AutoPtr<AsyncLogChannel> async_channel(new AsyncLogChannel(format_channel, count + 1));
+
+        Poco::Logger &sync_logger = Poco::Logger::get("LogBenchmark.Sync");
+        sync_logger.setChannel(format_channel);
+        sync_logger.setLevel(Poco::Message::PRIO_INFORMATION);
+        Poco::Logger &async_logger = Poco::Logger::get("LogBenchmark.Async");
+        async_logger.setChannel(async_channel);
+        async_logger.setLevel(Poco::Message::PRIO_INFORMATION);
+
+        const std::string asset_id = "0d2a2f6e-9c1b-4b7e-8a4f-3c5e7d9b1a2c";
+        const double freq = (double)GetCurrentClockFreq();
+        std::stringstream ss;
+        ss << "Logging " << count << " messages, time per message on this thread:" << std::endl;
+
+        // Debug message filtered out after formatting it and looking up the logger, as the logging functions did
+        tick_t start = GetCurrentClockTime();
+        for(int i = 0; i < count; ++i)
+        {
+            std::string msg = "Storing complete asset " + asset_id + " " + ToString(i);
+            Poco::Logger::get("LogBenchmark.Sync").debug("Debug: " + msg);
+        }
+        ss << "  filtered, unchecked     " << (GetCurrentClockTime() - start) / freq / count * 1000000.0 << " us" << std::endl;
+
+        // Debug message filtered out by checking the level first
+        start = GetCurrentClockTime();
+        for(int i = 0; i < count; ++i)
+        {
+            if (sync_logger.debug())
+                sync_logger.debug("Debug: Storing complete asset " + asset_id + " " + ToString(i));
+        }
+        ss << "  filtered, checked       " << (GetCurrentClockTime() - start) / freq / count * 1000000.0 << " us" << std::endl;
+
+        start = GetCurrentClockTime();
+        for(int i = 0; i < count; ++i)
+            sync_logger.information("Storing complete asset " + asset_id + " " + ToString(i));
+        ss << "  written synchronously   " << (GetCurrentClockTime() - start) / freq / count * 1000000.0 << " us" << std::endl;
+
+        start = GetCurrentClockTime();
+        for(int i = 0; i < count; ++i)
+            async_logger.information("Storing complete asset " + asset_id + " " + ToString(i));
+        ss << "  queued asynchronously   " << (GetCurrentClockTime() - start) / freq / count * 1000000.0 << " us" << std::endl;
+
+        start = GetCurrentClockTime();
+        async_channel->close();
+        ss << "  remaining asynchronous writes took " << (GetCurrentClockTime() - start) / freq * 1000.0 << " ms" << std::endl;
+
+        if (async_log_channel_)
+        {
+            AsyncLogChannel::Stats stats = async_log_channel_->GetStats();
+            ss << "Log: " << stats.messages << " messages from " << stats.threads << " threads, written in " << stats.drains
+               << " batches of at most " << stats.maxBacklog << ", " << stats.overflows << " written synchronously because of a full buffer";
+        }
+        else
+            ss << "Log is written synchronously, see log_async in the configuration";
+
+        Poco::Logger::destroy("LogBenchmark.Sync");
+        Poco::Logger::destroy("LogBenchmark.Async");
+        file_channel->close();
+        try
+        {
+            Poco::File(path).remove();
+        }
+        catch(Poco::Exception &)
+        {
+        }
+
+        return Console::ResultSuccess(ss.str());
+    }
+
     static std::string FormatTime(double time)
     {
         char str[128];
@@ -617,10 +787,22 @@ namespace Foundation
                 "Lists all loaded modules.", 
                 Console::Bind(this, &Framework::ConsoleListModules)));
 
+            console->RegisterCommand(Console::CreateCommand("StartupTimeline", 
+                "Prints the time each module took to load and initialize, and the critical path of module startup.", 
+                Console::Bind(this, &Framework::ConsoleStartupTimeline)));
+
             console->RegisterCommand(Console::CreateCommand("SendEvent", 
                 "Sends an internal event. Only for events that contain no data. Usage: SendEvent(event category name, event id)", 
                 Console::Bind(this, &Framework::ConsoleSendEvent)));
 
+            console->RegisterCommand(Console::CreateCommand("LogLevel", 
+                "Sets the log level of all loggers, or of one logger. Usage: LogLevel(level, logger)", 
+                Console::Bind(this, &Framework::ConsoleLogLevel)));
+
+            console->RegisterCommand(Console::CreateCommand("BenchLogging", 
+                "Measures how long logging takes from the main thread, synchronously and asynchronously. Usage: BenchLogging(count)", 
+                Console::Bind(this, &Framework::ConsoleBenchLogging)));
+
 #ifdef PROFILING
             console->RegisterCommand(Console::CreateCommand("Profile", 
                 "Outputs profiling data. Usage: Profile() for full, or Profile(name) for specific profiling block", 
@@ -671,6 +853,11 @@ namespace Foundation
         return thread_task_manager_;
     }
 
+    FrameSchedulerPtr Framework::GetFrameScheduler()
+    {
+        return frame_scheduler_;
+    }
+
     ConfigurationManager &Framework::GetDefaultConfig()
     {
         return *(config_manager_.get());
@@ -41,6 +41,7 @@ namespace Poco
 
 namespace Foundation
 {
+    class AsyncLogChannel;
     class NaaliApplication;
     class FrameworkQtApplication;
     class KeyStateListener;
@@ -118,6 +119,9 @@ namespace Foundation
         //! Returns thread task manager.
         ThreadTaskManagerPtr GetThreadTaskManager();
 
+        //! Returns frame scheduler, used for queuing deferrable work that is run within a per-frame time budget.
+        FrameSchedulerPtr GetFrameScheduler();
+
         //! Cancel a pending exit
         void CancelExit();
 
@@ -206,9 +210,18 @@ namespace Foundation
         //! List all loaded modules
         Console::CommandResult ConsoleListModules(const StringVector &params);
 
+        //! Print the per-module startup timeline
+        Console::CommandResult ConsoleStartupTimeline(const StringVector &params);
+
         //! send event
         Console::CommandResult ConsoleSendEvent(const StringVector &params);
 
+        //! Sets the level of all loggers, or of one logger. Usage: LogLevel(level, logger)
+        Console::CommandResult ConsoleLogLevel(const StringVector &params);
+
+        //! Measures the time logging takes from the calling thread. Usage: BenchLogging(count)
+        Console::CommandResult ConsoleBenchLogging(const StringVector &params);
+
         //! Output profiling data
         Console::CommandResult ConsoleProfile(const StringVector &params);
 
@@ -339,6 +352,9 @@ namespace Foundation
         //! Thread task manager.
         ThreadTaskManagerPtr thread_task_manager_;
 
+        //! Frame scheduler for budgeted deferred work.
+        FrameSchedulerPtr frame_scheduler_;
+
         //! default configuration
         ConfigurationManagerPtr config_manager_;
 
@@ -354,6 +370,9 @@ namespace Foundation
         //! Logger default formatter
         Poco::Formatter *log_formatter_;
 
+        //! Channel that writes the log in a background thread, null if log_async is false
+        AsyncLogChannel *async_log_channel_;
+
         //! map of scenes
         SceneMap scenes_;
 
@@ -13,6 +13,11 @@ DEFINE_POCO_LOGGING_FUNCTIONS("ModuleManager")
 
 #include <algorithm>
 #include <sstream>
+#include <iomanip>
+
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
 
 #include <Poco/Environment.h>
 #include <Poco/UnicodeConverter.h>
@@ -23,6 +28,60 @@ namespace fs = boost::filesystem;
 
 typedef void (*SetProfilerFunc)(Foundation::Profiler *profiler);
 
+namespace
+{
+    /// Hands out indices to the threads of ParallelFor.
+    class ParallelForWorker
+    {
+    public:
+        ParallelForWorker(size_t count, const boost::function<void(size_t)> &func) : next_(0), count_(count), func_(func) {}
+
+        void operator()()
+        {
+            for(;;)
+            {
+                size_t index;
+                {
+                    boost::mutex::scoped_lock lock(mutex_);
+                    if (next_ >= count_)
+                        return;
+                    index = next_++;
+                }
+                func_(index);
+            }
+        }
+
+    private:
+        boost::mutex mutex_;
+        size_t next_;
+        const size_t count_;
+        boost::function<void(size_t)> func_;
+    };
+
+    /// Calls func(i) for each i in [0, count[ using at most numThreads threads, including the calling thread.
+    void ParallelFor(size_t count, unsigned int numThreads, const boost::function<void(size_t)> &func)
+    {
+        if (numThreads <= 1 || count <= 1)
+        {
+            for(size_t i = 0; i < count; ++i)
+                func(i);
+            return;
+        }
+
+        ParallelForWorker worker(count, func);
+        boost::thread_group threads;
+        for(unsigned int i = 1; i < numThreads && i < count; ++i)
+            threads.create_thread(boost::ref(worker));
+        worker();
+        threads.join_all();
+    }
+
+    double SecondsSince(tick_t start)
+    {
+        return (double)(GetCurrentClockTime() - start) / (double)GetCurrentClockFreq();
+    }
+}
+
 namespace Module
 {
     SharedLibrary::SharedLibrary(const std::string &path) : path_(path)
@@ -52,8 +111,14 @@ namespace Module
 
 ModuleManager::ModuleManager(Foundation::Framework *framework) :
     framework_(framework),
-    DEFAULT_MODULES_PATH(framework->GetDefaultConfig().DeclareSetting<std::string>("ModuleManager", "Default_Modules_Path", "./modules"))
+    DEFAULT_MODULES_PATH(framework->GetDefaultConfig().DeclareSetting<std::string>("ModuleManager", "Default_Modules_Path", "./modules")),
+    xml_parse_time_(0.0)
 {
+    // Off by default: modules are always initialized in the main thread, so only xml parsing and library opening
+    // can overlap, and opening libraries concurrently has not been measured to pay off on all platforms.
+    parallel_startup_ = framework_->GetDefaultConfig().DeclareSetting("ModuleManager", "parallel_startup", false);
+    int threads = framework_->GetDefaultConfig().DeclareSetting("ModuleManager", "startup_threads", (int)boost::thread::hardware_concurrency());
+    startup_threads_ = (threads > 1) ? (unsigned int)threads : 1;
 }
 
 ModuleManager::~ModuleManager()
@@ -174,8 +239,13 @@ void ModuleManager::LoadAvailableModules()
     // Now parse all the definition files we found.
     std::vector<ModuleLoadDescription> moduleDescriptions;
     StringVector relativePathDependencyAdditions;
-    for(size_t i = 0; i < files->size(); ++i)
-        ParseModuleXMLFile((*files)[i], moduleDescriptions, relativePathDependencyAdditions);
+    tick_t parseStart = GetCurrentClockTime();
+    ParseModuleXMLFiles(*files, moduleDescriptions, relativePathDependencyAdditions);
+    xml_parse_time_ = SecondsSince(parseStart);
+
+    for(size_t i = 0; i < moduleDescriptions.size(); ++i)
+        for(size_t j = 0; j < moduleDescriptions[i].moduleNames.size(); ++j)
+            module_dependencies_[moduleDescriptions[i].moduleNames[j]] = moduleDescriptions[i].dependencies;
 
     // If any module needs any new directories in the path, add those there. But first, remove any duplicate entries.
     std::sort(relativePathDependencyAdditions.begin(), relativePathDependencyAdditions.end());
@@ -191,17 +261,114 @@ void ModuleManager::LoadAvailableModules()
 
     // Finally, load up all modules. The module description list is now sorted in a topological order, so that the dependencies
     // are satisfied when traversing begin()->end().
-    for(std::vector<ModuleLoadDescription>::iterator iter = moduleDescriptions.begin(); iter != moduleDescriptions.end(); ++iter)
+    LoadModuleLibraries(moduleDescriptions);
+}
+
+void ModuleManager::ParseModuleXMLFiles(const StringVector &files, std::vector<ModuleLoadDescription> &out, StringVector &relativePathDependencyAdditions)
+{
+    // Each file is parsed into its own slot so that the resulting order does not depend on thread scheduling.
+    std::vector<std::vector<ModuleLoadDescription> > descriptions(files.size());
+    std::vector<StringVector> additions(files.size());
+
+    ParallelFor(files.size(), parallel_startup_ ? startup_threads_ : 1, boost::bind(&ModuleManager::ParseModuleXMLFileAt,
+        this, _1, boost::cref(files), boost::ref(descriptions), boost::ref(additions)));
+
+    for(size_t i = 0; i < files.size(); ++i)
+    {
+        out.insert(out.end(), descriptions[i].begin(), descriptions[i].end());
+        relativePathDependencyAdditions.insert(relativePathDependencyAdditions.end(), additions[i].begin(), additions[i].end());
+    }
+}
+
+void ModuleManager::ParseModuleXMLFileAt(size_t index, const StringVector &files, std::vector<std::vector<ModuleLoadDescription> > &out,
+    std::vector<StringVector> &relativePathDependencyAdditions)
+{
+    ParseModuleXMLFile(files[index], out[index], relativePathDependencyAdditions[index]);
+}
+
+void ModuleManager::LoadModuleLibraries(const std::vector<ModuleLoadDescription> &modules)
+{
+    std::vector<Module::SharedLibraryPtr> libraries(modules.size());
+    std::vector<double> libraryLoadTimes(modules.size(), 0.0);
+
+    if (parallel_startup_ && startup_threads_ > 1)
+    {
+        // Group the libraries into levels: a library is on the level after the highest level of its dependencies.
+        // Libraries on the same level do not depend on each other and can be opened concurrently.
+        std::map<std::string, size_t> levelOfModule;
+        std::vector<std::vector<size_t> > levels;
+        for(size_t i = 0; i < modules.size(); ++i)
+        {
+            size_t level = 0;
+            for(size_t j = 0; j < modules[i].dependencies.size(); ++j)
+            {
+                std::map<std::string, size_t>::const_iterator dep = levelOfModule.find(modules[i].dependencies[j]);
+                if (dep != levelOfModule.end())
+                    level = std::max(level, dep->second + 1);
+            }
+            for(size_t j = 0; j < modules[i].moduleNames.size(); ++j)
+                levelOfModule[modules[i].moduleNames[j]] = level;
+            if (levels.size() <= level)
+                levels.resize(level + 1);
+            levels[level].push_back(i);
+        }
+
+        for(size_t level = 0; level < levels.size(); ++level)
+        {
+            // Only the indices of this level are opened, map them through the level's index list.
+            const std::vector<size_t> &indices = levels[level];
+            std::vector<Module::SharedLibraryPtr> levelLibraries(indices.size());
+            std::vector<double> levelLoadTimes(indices.size(), 0.0);
+            std::vector<ModuleLoadDescription> levelModules;
+            for(size_t i = 0; i < indices.size(); ++i)
+                levelModules.push_back(modules[indices[i]]);
+
+            ParallelFor(indices.size(), startup_threads_, boost::bind(&ModuleManager::OpenModuleLibraryAt,
+                this, _1, boost::cref(levelModules), boost::ref(levelLibraries), boost::ref(levelLoadTimes)));
+
+            for(size_t i = 0; i < indices.size(); ++i)
+            {
+                libraries[indices[i]] = levelLibraries[i];
+                libraryLoadTimes[indices[i]] = levelLoadTimes[i];
+            }
+        }
+    }
+
+    // Create the modules in the sorted order. Libraries that were not opened above (or failed to open) are opened here.
+    for(size_t i = 0; i < modules.size(); ++i)
         try
         {
-            LoadModule(iter->moduleDescFilename.native_directory_string(), iter->moduleNames);
+            tick_t loadStart = GetCurrentClockTime();
+            LoadModule(modules[i].moduleDescFilename.native_directory_string(), modules[i].moduleNames, libraries[i]);
+            double loadTime = SecondsSince(loadStart) + libraryLoadTimes[i];
+            for(size_t j = 0; j < modules[i].moduleNames.size(); ++j)
+                startup_timings_[modules[i].moduleNames[j]].load_ = loadTime;
         }
         catch (std::exception &e) // may not be fatal, depending on which module failed
         {
-            RootLogError(std::string("Trying to load module ") + iter->ToString() + " threw an exception: " + e.what());
+            RootLogError(std::string("Trying to load module ") + modules[i].ToString() + " threw an exception: " + e.what());
         }
 }
 
+void ModuleManager::OpenModuleLibraryAt(size_t index, const std::vector<ModuleLoadDescription> &modules, std::vector<Module::SharedLibraryPtr> &out,
+    std::vector<double> &durations)
+{
+    std::string path(modules[index].moduleDescFilename.native_directory_string());
+    path.append(Poco::SharedLibrary::suffix());
+
+    tick_t start = GetCurrentClockTime();
+    try
+    {
+        out[index] = Module::SharedLibraryPtr(new Module::SharedLibrary(path));
+    }
+    catch (Poco::Exception &)
+    {
+        // Leave empty, LoadModule will retry in the main thread and report the error.
+        out[index].reset();
+    }
+    durations[index] = SecondsSince(start);
+}
+
 bool ModuleManager::ModuleLoadDescription::Precedes(const ModuleLoadDescription &rhs) const
 {
     for(size_t i = 0; i < rhs.dependencies.size(); ++i)
@@ -308,18 +475,86 @@ void ModuleManager::InitializeModules()
     {
         IModule *mod = modules_[i].module_.get();
         if (mod->State() != MS_Initialized)
+        {
+            tick_t start = GetCurrentClockTime();
             PreInitializeModule(mod);
+            startup_timings_[modules_[i].entry_].preInitialize_ = SecondsSince(start);
+        }
     }
 
     for(size_t i = 0; i < modules_.size(); ++i)
     {
         IModule *mod = modules_[i].module_.get();
         if (mod->State() != MS_Initialized)
+        {
+            tick_t start = GetCurrentClockTime();
             InitializeModule(mod);
+            startup_timings_[modules_[i].entry_].initialize_ = SecondsSince(start);
+        }
     }
 
     for(size_t i = 0; i < modules_.size(); ++i)
+    {
+        tick_t start = GetCurrentClockTime();
         PostInitializeModule(modules_[i].module_.get());
+        startup_timings_[modules_[i].entry_].postInitialize_ = SecondsSince(start);
+    }
+
+    RootLogDebug(GetStartupTimelineReport());
+}
+
+std::string ModuleManager::GetStartupTimelineReport() const
+{
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(1);
+    ss << "Module startup timeline (ms), xml parsing " << xml_parse_time_ * 1000.0 << ":" << std::endl;
+    ss << std::left << std::setw(32) << "module" << std::right << std::setw(10) << "load" << std::setw(10) << "preinit"
+       << std::setw(10) << "init" << std::setw(10) << "postinit" << std::setw(10) << "finish" << std::endl;
+
+    // Walk the modules in load order, which is topological, and compute the earliest time each module could finish
+    // if all independent modules were run in parallel. The longest such chain is the critical path.
+    std::map<std::string, double> finish;
+    std::map<std::string, std::string> previous;
+    std::string last;
+    for(size_t i = 0; i < modules_.size(); ++i)
+    {
+        const std::string &entry = modules_[i].entry_;
+        StartupTiming timing;
+        std::map<std::string, StartupTiming>::const_iterator t = startup_timings_.find(entry);
+        if (t != startup_timings_.end())
+            timing = t->second;
+
+        double start = 0.0;
+        std::map<std::string, StringVector>::const_iterator deps = module_dependencies_.find(entry);
+        if (deps != module_dependencies_.end())
+            for(size_t j = 0; j < deps->second.size(); ++j)
+            {
+                std::map<std::string, double>::const_iterator f = finish.find(deps->second[j]);
+                if (f != finish.end() && f->second > start)
+                {
+                    start = f->second;
+                    previous[entry] = f->first;
+                }
+            }
+
+        finish[entry] = start + timing.load_ + timing.preInitialize_ + timing.initialize_ + timing.postInitialize_;
+        if (last.empty() || finish[entry] > finish[last])
+            last = entry;
+
+        ss << std::left << std::setw(32) << entry << std::right << std::setw(10) << timing.load_ * 1000.0
+           << std::setw(10) << timing.preInitialize_ * 1000.0 << std::setw(10) << timing.initialize_ * 1000.0
+           << std::setw(10) << timing.postInitialize_ * 1000.0 << std::setw(10) << finish[entry] * 1000.0 << std::endl;
+    }
+
+    if (!last.empty())
+    {
+        std::string path = last;
+        for(std::map<std::string, std::string>::const_iterator p = previous.find(last); p != previous.end(); p = previous.find(p->second))
+            path = p->second + " -> " + path;
+        ss << "Critical path (" << finish[last] * 1000.0 << " ms): " << path << std::endl;
+    }
+
+    return ss.str();
 }
 
 void ModuleManager::UninitializeModules()
@@ -481,7 +716,7 @@ bool ModuleManager::UnloadModuleByName(const std::string &module)
     return false;
 }
 
-void ModuleManager::LoadModule(const std::string &name, const StringVector &entries)
+void ModuleManager::LoadModule(const std::string &name, const StringVector &entries, Module::SharedLibraryPtr preloaded)
 {
     assert(name.empty() == false);
 
@@ -502,7 +737,7 @@ void ModuleManager::LoadModule(const std::string &name, const StringVector &entr
     if (!library)
         try
         {
-            library = Module::SharedLibraryPtr(new Module::SharedLibrary(path));
+            library = preloaded ? preloaded : Module::SharedLibraryPtr(new Module::SharedLibrary(path));
             if (!library->sl_.hasSymbol("SetProfiler"))
                 throw Poco::Exception("Function SetProfiler() need to be exported from the shared library for profiling to work properly!");
 
@@ -138,6 +138,12 @@ public:
     //! perform synchronized update on all modules
     void UpdateModules(f64 frametime);
 
+    //! Returns a readable report of the time each module took to load and initialize during startup.
+    /*! Also contains the critical path, i.e. the longest chain of dependent modules, which bounds the startup time
+        that can be gained by loading and initializing modules in parallel.
+    */
+    std::string GetStartupTimelineReport() const;
+
     //! Returns module by name
     //! \note The pointer may invalidate between frames, always reacquire at begin of frame update
     ModuleWeakPtr GetModule(const std::string &name);
@@ -241,8 +247,9 @@ private:
     /*!
         \param moduleName path to the shared lib containing the modules
         \param entries name of the entry classes in the lib
+        \param preloaded the shared library, if it was already opened by a startup worker thread
     */
-    void LoadModule(const std::string &moduleName, const StringVector &entries);
+    void LoadModule(const std::string &moduleName, const StringVector &entries, Module::SharedLibraryPtr preloaded = Module::SharedLibraryPtr());
 
     //! returns true if module is present
     bool HasModule(IModule *module) const;
@@ -253,6 +260,32 @@ private:
     //! adds needed dependency paths to process path
     void AddDependenciesToPath(const StringVector &all_additions);
 
+    /// Parses the given module xml files, in parallel if enabled. The descriptions are output in the same order as the files.
+    void ParseModuleXMLFiles(const StringVector &files, std::vector<ModuleLoadDescription> &out, StringVector &relativePathDependencyAdditions);
+
+    /// Parses files[index] into out[index] and relativePathDependencyAdditions[index]. Work function of ParseModuleXMLFiles.
+    void ParseModuleXMLFileAt(size_t index, const StringVector &files, std::vector<std::vector<ModuleLoadDescription> > &out,
+        std::vector<StringVector> &relativePathDependencyAdditions);
+
+    /// Opens the shared library of modules[index] into out[index] and records the time it took. Work function of LoadModuleLibraries.
+    void OpenModuleLibraryAt(size_t index, const std::vector<ModuleLoadDescription> &modules, std::vector<Module::SharedLibraryPtr> &out,
+        std::vector<double> &durations);
+
+    /// Loads the shared libraries of the given topologically sorted module descriptions. Libraries whose dependencies have
+    /// all been loaded are opened concurrently if parallel startup is enabled, modules are then created in the sorted order.
+    void LoadModuleLibraries(const std::vector<ModuleLoadDescription> &modules);
+
+    /// Timing information of a single module, recorded during startup.
+    struct StartupTiming
+    {
+        StartupTiming() : load_(0.0), preInitialize_(0.0), initialize_(0.0), postInitialize_(0.0) {}
+        /// Time spent loading the shared library and creating the module, in seconds.
+        double load_;
+        double preInitialize_;
+        double initialize_;
+        double postInitialize_;
+    };
+
     const std::string DEFAULT_MODULES_PATH;
 
     typedef std::set<std::string> ModuleTypeSet;
@@ -265,6 +298,21 @@ private:
 
     //! Framework pointer.
     Foundation::Framework *framework_;
+
+    //! Module dependencies as read from the module xml files, keyed by module entry name.
+    std::map<std::string, StringVector> module_dependencies_;
+
+    //! Startup timing of each module, keyed by module entry name.
+    std::map<std::string, StartupTiming> startup_timings_;
+
+    //! Time spent parsing module xml files, in seconds.
+    double xml_parse_time_;
+
+    //! If true, module xml files are parsed and independent libraries are opened in parallel. Off by default.
+    bool parallel_startup_;
+
+    //! Maximum number of worker threads used during startup.
+    unsigned int startup_threads_;
 };
 
 #endif
@@ -21,6 +21,15 @@ namespace HttpUtilities
             return 0;
     }
 
+    // Writer callback for cURL, when the reply data is given to a handler.
+    size_t HandlerWriteCallback(char *data, size_t size, size_t nmemb, HttpRequest::ResponseHandler* handler)
+    {
+        if (handler && (*handler)((const u8*)data, (uint)(size * nmemb)))
+            return size * nmemb;
+        else
+            return 0;
+    }
+
     HttpRequest::HttpRequest() :
         method_(Get),
         success_(false),
@@ -111,8 +120,16 @@ namespace HttpUtilities
         curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
         curl_easy_setopt(curl, CURLOPT_URL, url_.c_str());
         curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, (int)timeout_);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_data_);
+        if (response_handler_)
+        {
+            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, HandlerWriteCallback);
+            curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_handler_);
+        }
+        else
+        {
+            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
+            curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_data_);
+        }
         curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, curlerror);
         
         result = curl_easy_perform(curl);
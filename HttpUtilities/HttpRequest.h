@@ -5,12 +5,17 @@
 
 #include "CoreTypes.h"
 
+#include <boost/function.hpp>
+
 namespace HttpUtilities
 {
     //! Performs a blocking http request
     class HttpRequest
     {
     public:
+        //! Receives the reply data as it arrives. Return false to abort the request.
+        typedef boost::function<bool (const u8 *data, uint size)> ResponseHandler;
+
         //! Http methods
         enum Method
         {
@@ -55,6 +60,12 @@ namespace HttpUtilities
          */
         void SetTimeout(float seconds);
         
+        //! Sets a handler that receives the reply data in pieces as it arrives, instead of it being stored
+        /*! The data is then not available from GetResponseData(). Set an empty handler to store the data again.
+            \param handler Handler
+         */
+        void SetResponseHandler(const ResponseHandler &handler) { response_handler_ = handler; }
+        
         //! Performs the request
         void Perform();
         
@@ -92,6 +103,8 @@ namespace HttpUtilities
         std::string content_type_;
         //! Reply data
         std::vector<u8> response_data_;
+        //! Handler of the reply data, if it is not stored
+        ResponseHandler response_handler_;
         //! Request success
         bool success_;
         //! Error reason
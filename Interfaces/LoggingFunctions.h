@@ -14,24 +14,36 @@
  *
  *  Result: prints "[MyClass] Hello!" to std::cout, log file and console.
  *
+ *  The level is checked before the message is formatted. To skip formatting the argument too,
+ *  check it first: if (IsLogEnabled(Poco::Message::PRIO_DEBUG)) LogDebug("Stored " + id);
+ *
  *  @note Never include this file from headers!
  */
 
 #ifndef incl_Interfaces_LoggingFunctions_h
 #define incl_Interfaces_LoggingFunctions_h
 
+#include "CoreCompileConfig.h"
+
 #include <Poco/Logger.h>
+#include <Poco/AutoPtr.h>
 
 #define DEFINE_POCO_LOGGING_FUNCTIONS(name)                                                                             \
     static const std::string loggingName(name);                                                                         \
-    static void LogFatal(const std::string &msg)    { Poco::Logger::get(loggingName).fatal("Fatal: " + msg);         }  \
-    static void LogCritical(const std::string &msg) { Poco::Logger::get(loggingName).critical("Critical: " + msg);   }  \
-    static void LogError(const std::string &msg)    { Poco::Logger::get(loggingName).error("Error: " + msg);         }  \
-    static void LogWarning(const std::string &msg)  { Poco::Logger::get(loggingName).warning("Warning: " + msg);     }  \
-    static void LogNotice(const std::string &msg)   { Poco::Logger::get(loggingName).notice("Notice: " + msg);       }  \
-    static void LogInfo(const std::string &msg)     { Poco::Logger::get(loggingName).information(msg);               }  \
-    static void LogTrace(const std::string &msg)    { Poco::Logger::get(loggingName).trace("Trace: " + msg);         }  \
-    static void LogDebug(const std::string &msg)    { Poco::Logger::get(loggingName).debug("Debug: " + msg);         }
+    static Poco::Logger &GetLogger()                                                                                    \
+    {                                                                                                                   \
+        static Poco::AutoPtr<Poco::Logger> logger(&Poco::Logger::get(loggingName), true);                               \
+        return *logger;                                                                                                 \
+    }                                                                                                                   \
+    static bool IsLogEnabled(int priority) { return priority <= NAALI_LOG_LEVEL && GetLogger().is(priority); }         \
+    static void LogFatal(const std::string &msg)    { if (IsLogEnabled(Poco::Message::PRIO_FATAL)) GetLogger().fatal("Fatal: " + msg);             }  \
+    static void LogCritical(const std::string &msg) { if (IsLogEnabled(Poco::Message::PRIO_CRITICAL)) GetLogger().critical("Critical: " + msg); }  \
+    static void LogError(const std::string &msg)    { if (IsLogEnabled(Poco::Message::PRIO_ERROR)) GetLogger().error("Error: " + msg);             }  \
+    static void LogWarning(const std::string &msg)  { if (IsLogEnabled(Poco::Message::PRIO_WARNING)) GetLogger().warning("Warning: " + msg);     }  \
+    static void LogNotice(const std::string &msg)   { if (IsLogEnabled(Poco::Message::PRIO_NOTICE)) GetLogger().notice("Notice: " + msg);        }  \
+    static void LogInfo(const std::string &msg)     { if (IsLogEnabled(Poco::Message::PRIO_INFORMATION)) GetLogger().information(msg);            }  \
+    static void LogTrace(const std::string &msg)    { if (IsLogEnabled(Poco::Message::PRIO_TRACE)) GetLogger().trace("Trace: " + msg);             }  \
+    static void LogDebug(const std::string &msg)    { if (IsLogEnabled(Poco::Message::PRIO_DEBUG)) GetLogger().debug("Debug: " + msg);             }
 
 #endif
 
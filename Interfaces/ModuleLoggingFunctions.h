@@ -3,17 +3,28 @@
 #ifndef incl_Interfaces_ModuleLoggingFunctions_h
 #define incl_Interfaces_ModuleLoggingFunctions_h
 
+#include "CoreCompileConfig.h"
+
 #include <Poco/Logger.h>
+#include <Poco/AutoPtr.h>
 
+//! Logging functions of a module. The level is checked before the message is formatted, so a message that
+//! is filtered out costs only the check. To skip formatting the argument too, check IsLogEnabled() first:
+//! if (MyModule::IsLogEnabled(Poco::Message::PRIO_DEBUG)) MyModule::LogDebug("Stored " + id);
 #define MODULE_LOGGING_FUNCTIONS                                                                                            \
-    static void LogFatal(const std::string &msg)    { Poco::Logger::get(NameStatic()).fatal("Fatal: " + msg);         }     \
-    static void LogCritical(const std::string &msg) { Poco::Logger::get(NameStatic()).critical("Critical: " + msg);   }     \
-    static void LogError(const std::string &msg)    { Poco::Logger::get(NameStatic()).error("Error: " + msg);         }     \
-    static void LogWarning(const std::string &msg)  { Poco::Logger::get(NameStatic()).warning("Warning: " + msg);     }     \
-    static void LogNotice(const std::string &msg)   { Poco::Logger::get(NameStatic()).notice("Notice: " + msg);       }     \
-    static void LogInfo(const std::string &msg)     { Poco::Logger::get(NameStatic()).information(msg);               }     \
-    static void LogTrace(const std::string &msg)    { Poco::Logger::get(NameStatic()).trace("Trace: " + msg);         }     \
-    static void LogDebug(const std::string &msg)    { Poco::Logger::get(NameStatic()).debug("Debug: " + msg);         }
+    static Poco::Logger &GetLogger()                                                                                        \
+    {                                                                                                                       \
+        static Poco::AutoPtr<Poco::Logger> logger(&Poco::Logger::get(NameStatic()), true);                                  \
+        return *logger;                                                                                                     \
+    }                                                                                                                       \
+    static bool IsLogEnabled(int priority) { return priority <= NAALI_LOG_LEVEL && GetLogger().is(priority); }             \
+    static void LogFatal(const std::string &msg)    { if (IsLogEnabled(Poco::Message::PRIO_FATAL)) GetLogger().fatal("Fatal: " + msg);                } \
+    static void LogCritical(const std::string &msg) { if (IsLogEnabled(Poco::Message::PRIO_CRITICAL)) GetLogger().critical("Critical: " + msg);    } \
+    static void LogError(const std::string &msg)    { if (IsLogEnabled(Poco::Message::PRIO_ERROR)) GetLogger().error("Error: " + msg);                } \
+    static void LogWarning(const std::string &msg)  { if (IsLogEnabled(Poco::Message::PRIO_WARNING)) GetLogger().warning("Warning: " + msg);        } \
+    static void LogNotice(const std::string &msg)   { if (IsLogEnabled(Poco::Message::PRIO_NOTICE)) GetLogger().notice("Notice: " + msg);           } \
+    static void LogInfo(const std::string &msg)     { if (IsLogEnabled(Poco::Message::PRIO_INFORMATION)) GetLogger().information(msg);               } \
+    static void LogTrace(const std::string &msg)    { if (IsLogEnabled(Poco::Message::PRIO_TRACE)) GetLogger().trace("Trace: " + msg);                } \
+    static void LogDebug(const std::string &msg)    { if (IsLogEnabled(Poco::Message::PRIO_DEBUG)) GetLogger().debug("Debug: " + msg);                }
 
 #endif
-
@@ -126,6 +126,14 @@ namespace Foundation
          */
         virtual request_tag_t RequestResource(const std::string& id, const std::string& type) = 0;
 
+        //! Tells that a renderer-specific resource request is no longer needed
+        /*! No RESOURCE_READY event is sent for the tag. The download is stopped if no other request waits for it.
+            \param id Resource id
+            \param type Resource type
+            \param tag Request tag returned by RequestResource
+         */
+        virtual void CancelResourceRequest(const std::string& id, const std::string& type, request_tag_t tag) = 0;
+
         //! Removes a renderer-specific resource
         /*! \param id Resource id
             \param type Resource type
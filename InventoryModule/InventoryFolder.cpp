@@ -8,14 +8,17 @@
 #include "StableHeaders.h"
 #include "InventoryFolder.h"
 #include "InventoryAsset.h"
+#include "InventoryItemIndex.h"
 #include "RexUUID.h"
 
+#include <algorithm>
+
 namespace Inventory
 {
 
 InventoryFolder::InventoryFolder(const QString &id, const QString &name, InventoryFolder *parent, const bool editable) :
     AbstractInventoryItem(id, name, parent, editable), itemType_(AbstractInventoryItem::Type_Folder), dirty_(false),
-    libraryItem_(false)
+    libraryItem_(false), index_(0)
 {
 }
 
@@ -25,10 +28,50 @@ InventoryFolder::~InventoryFolder()
     qDeleteAll(children_);
 }
 
+void InventoryFolder::SetName(const QString &name)
+{
+    QString oldName = name_;
+    name_ = name;
+    if (index_)
+        index_->RenameFolder(this, oldName);
+}
+
+void InventoryFolder::SetIndex(InventoryItemIndex *index)
+{
+    if (index == index_)
+        return;
+
+    if (index_)
+        index_->Remove(this);
+
+    SetIndexRecursive(index);
+
+    if (index_)
+        index_->Insert(this);
+}
+
+void InventoryFolder::SetIndexRecursive(InventoryItemIndex *index)
+{
+    index_ = index;
+    QListIterator<AbstractInventoryItem *> it(children_);
+    while(it.hasNext())
+    {
+        AbstractInventoryItem *item = it.next();
+        if (item->GetItemType() == Type_Folder)
+            static_cast<InventoryFolder *>(item)->SetIndexRecursive(index);
+    }
+}
+
 AbstractInventoryItem *InventoryFolder::AddChild(AbstractInventoryItem *child)
 {
     child->SetParent(this);
     children_.append(child);
+
+    if (child->GetItemType() == Type_Folder)
+        static_cast<InventoryFolder *>(child)->SetIndexRecursive(index_);
+    if (index_)
+        index_->Insert(child);
+
     return children_.back();
 }
 
@@ -38,7 +81,12 @@ bool InventoryFolder::RemoveChildren(int position, int count)
         return false;
 
     for(int row = 0; row < count; ++row)
-        delete children_.takeAt(position);
+    {
+        AbstractInventoryItem *child = children_.takeAt(position);
+        if (index_)
+            index_->Remove(child);
+        delete child;
+    }
 
     return true;
 }
@@ -92,6 +140,15 @@ InventoryFolder *InventoryFolder::GetFirstChildFolderByName(const QString &searc
     if (GetName() == searchName)
         return const_cast<InventoryFolder *>(this);
 
+    if (index_)
+    {
+        QList<AbstractInventoryItem *> matches;
+        foreach(InventoryFolder *folder, index_->FindFoldersByName(searchName))
+            if (folder->IsDescendentOf(const_cast<InventoryFolder *>(this)))
+                matches << folder;
+        return static_cast<InventoryFolder *>(FirstInTreeOrder(matches));
+    }
+
     QListIterator<AbstractInventoryItem *> it(children_);
     while(it.hasNext())
     {
@@ -116,6 +173,15 @@ InventoryFolder *InventoryFolder::GetFirstChildFolderByName(const QString &searc
 
 InventoryFolder *InventoryFolder::GetChildFolderById(const QString &searchId) const
 {
+    if (index_ && InventoryItemIndex::IsIndexed(searchId))
+    {
+        QList<AbstractInventoryItem *> matches;
+        foreach(AbstractInventoryItem *item, index_->Find(searchId))
+            if (item->GetItemType() == Type_Folder && item->IsDescendentOf(const_cast<InventoryFolder *>(this)))
+                matches << item;
+        return static_cast<InventoryFolder *>(FirstInTreeOrder(matches));
+    }
+
     QListIterator<AbstractInventoryItem *> it(children_);
     while(it.hasNext())
     {
@@ -140,6 +206,15 @@ InventoryFolder *InventoryFolder::GetChildFolderById(const QString &searchId) co
 
 InventoryAsset *InventoryFolder::GetChildAssetById(const QString &searchId) const
 {
+    if (index_ && InventoryItemIndex::IsIndexed(searchId))
+    {
+        QList<AbstractInventoryItem *> matches;
+        foreach(AbstractInventoryItem *item, index_->Find(searchId))
+            if (item->GetItemType() == Type_Asset && item->GetParent() == this)
+                matches << item;
+        return static_cast<InventoryAsset *>(FirstInTreeOrder(matches));
+    }
+
     QListIterator<AbstractInventoryItem *> it(children_);
     while(it.hasNext())
     {
@@ -164,6 +239,15 @@ InventoryAsset *InventoryFolder::GetChildAssetById(const QString &searchId) cons
 
 AbstractInventoryItem *InventoryFolder::GetChildById(const QString &searchId) const
 {
+    if (index_ && InventoryItemIndex::IsIndexed(searchId))
+    {
+        QList<AbstractInventoryItem *> matches;
+        foreach(AbstractInventoryItem *item, index_->Find(searchId))
+            if (item->IsDescendentOf(const_cast<InventoryFolder *>(this)))
+                matches << item;
+        return FirstInTreeOrder(matches);
+    }
+
     QListIterator<AbstractInventoryItem *> it(children_);
     while(it.hasNext())
     {
@@ -292,6 +376,31 @@ int InventoryFolder::Row() const
     return 0;
 }
 
+AbstractInventoryItem *InventoryFolder::FirstInTreeOrder(const QList<AbstractInventoryItem *> &items)
+{
+    if (items.size() < 2)
+        return items.isEmpty() ? 0 : items.front();
+
+    // Compare the row numbers of the items and their ancestors, starting from the root.
+    AbstractInventoryItem *first = 0;
+    std::vector<int> firstPosition;
+    foreach(AbstractInventoryItem *item, items)
+    {
+        std::vector<int> position;
+        for(AbstractInventoryItem *i = item; i->GetParent(); i = i->GetParent())
+            position.push_back(static_cast<InventoryFolder *>(i->GetParent())->children_.indexOf(i));
+        std::reverse(position.begin(), position.end());
+
+        if (!first || position < firstPosition)
+        {
+            first = item;
+            firstPosition.swap(position);
+        }
+    }
+
+    return first;
+}
+
 #ifdef _DEBUG
 void InventoryFolder::DebugDumpInventoryFolderStructure(int indentationLevel)
 {
@@ -15,6 +15,7 @@
 namespace Inventory
 {
     class InventoryAsset;
+    class InventoryItemIndex;
 
     class INVENTORY_MODULE_API InventoryFolder : public AbstractInventoryItem
     {
@@ -37,7 +38,7 @@ namespace Inventory
         QString GetName() const { return name_; }
 
         /// AbstractInventoryItem override
-        void SetName(const QString &name) { name_ = name; }
+        void SetName(const QString &name);
 
         /// AbstractInventoryItem override
         QString GetID() const { return id_; }
@@ -77,6 +78,14 @@ namespace Inventory
         /// Sets the folder dirty flag.
         void SetDirty(const bool &dirty) { dirty_ = dirty; }
 
+        /// Sets the item index kept up to date by this folder and its descendents, and adds them to it.
+        /// Children added later use the index of their parent. The id lookups below use the index when it's set.
+        /// @param index Item index, or null if the folder shouldn't be indexed.
+        void SetIndex(InventoryItemIndex *index);
+
+        /// @return Item index of this folder, or null if the folder isn't indexed.
+        InventoryItemIndex *GetIndex() const { return index_; }
+
         /// Adds new child.
         /// @param child Child to be added.
         /// @return Pointer to the new child.
@@ -158,6 +167,12 @@ namespace Inventory
     private:
         Q_DISABLE_COPY(InventoryFolder);
 
+        /// Sets the index pointer of this folder and all descendent folders.
+        void SetIndexRecursive(InventoryItemIndex *index);
+
+        /// Returns the item that comes first in the tree, i.e. the one a recursive search would find first.
+        static AbstractInventoryItem *FirstInTreeOrder(const QList<AbstractInventoryItem *> &items);
+
         /// Type of item (folder or asset)
         InventoryItemType itemType_;
 
@@ -169,6 +184,9 @@ namespace Inventory
 
         /// Library asset flag.
         bool libraryItem_;
+
+        /// Item index, or null.
+        InventoryItemIndex *index_;
     };
 }
 
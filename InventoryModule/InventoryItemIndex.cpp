@@ -0,0 +1,60 @@
+/**
+ *  For conditions of distribution and use, see copyright notice in license.txt
+ *
+ *  @file   InventoryItemIndex.cpp
+ *  @brief  Flat id and name index of the items in an inventory item tree.
+ */
+
+#include "StableHeaders.h"
+#include "InventoryItemIndex.h"
+#include "InventoryFolder.h"
+#include "RexUUID.h"
+
+namespace Inventory
+{
+
+void InventoryItemIndex::Insert(AbstractInventoryItem *item)
+{
+    if (IsIndexed(item->GetID()))
+        items_.insert(item->GetID(), item);
+
+    if (item->GetItemType() != AbstractInventoryItem::Type_Folder)
+        return;
+
+    InventoryFolder *folder = static_cast<InventoryFolder *>(item);
+    foldersByName_.insert(folder->GetName(), folder);
+    for(int i = 0; i < folder->ChildCount(); ++i)
+        Insert(folder->Child(i));
+}
+
+void InventoryItemIndex::Remove(AbstractInventoryItem *item)
+{
+    items_.remove(item->GetID(), item);
+
+    if (item->GetItemType() != AbstractInventoryItem::Type_Folder)
+        return;
+
+    InventoryFolder *folder = static_cast<InventoryFolder *>(item);
+    foldersByName_.remove(folder->GetName(), folder);
+    for(int i = 0; i < folder->ChildCount(); ++i)
+        Remove(folder->Child(i));
+}
+
+void InventoryItemIndex::RenameFolder(InventoryFolder *folder, const QString &oldName)
+{
+    if (foldersByName_.remove(oldName, folder))
+        foldersByName_.insert(folder->GetName(), folder);
+}
+
+void InventoryItemIndex::Clear()
+{
+    items_.clear();
+    foldersByName_.clear();
+}
+
+bool InventoryItemIndex::IsIndexed(const QString &id)
+{
+    return id.length() >= 32 && RexUUID::IsValid(id);
+}
+
+}
@@ -0,0 +1,68 @@
+/**
+ *  For conditions of distribution and use, see copyright notice in license.txt
+ *
+ *  @file   InventoryItemIndex.h
+ *  @brief  Flat id and name index of the items in an inventory item tree.
+ */
+
+#ifndef incl_InventoryModule_InventoryItemIndex_h
+#define incl_InventoryModule_InventoryItemIndex_h
+
+#include "InventoryModuleApi.h"
+
+#include <QMultiHash>
+#include <QList>
+#include <QString>
+
+namespace Inventory
+{
+    class AbstractInventoryItem;
+    class InventoryFolder;
+
+    /// Flat id and name index of the items in an inventory item tree.
+    /** Folders that have an index set (see InventoryFolder::SetIndex) keep it up to date when children are added,
+        removed or renamed, so that items can be found by id without walking the whole tree.
+
+        Only items with UUID ids are indexed; placeholder items such as the "DummyItem" of unfetched folders are
+        looked up by walking the tree. The same id can be in the index more than once while an item is being
+        moved, so lookups return all matches and the caller decides which one it wants.
+    */
+    class INVENTORY_MODULE_API InventoryItemIndex
+    {
+    public:
+        /// Adds an item and, if it is a folder, all of its descendents.
+        void Insert(AbstractInventoryItem *item);
+
+        /// Removes an item and, if it is a folder, all of its descendents.
+        void Remove(AbstractInventoryItem *item);
+
+        /// Updates the name index of a folder.
+        /// @param folder Renamed folder.
+        /// @param oldName Name of the folder before the rename.
+        void RenameFolder(InventoryFolder *folder, const QString &oldName);
+
+        /// Removes all items.
+        void Clear();
+
+        /// @return Is the id of this kind that is kept in the index.
+        static bool IsIndexed(const QString &id);
+
+        /// @return All items with the requested id.
+        QList<AbstractInventoryItem *> Find(const QString &id) const { return items_.values(id); }
+
+        /// @return All folders with the requested name.
+        QList<InventoryFolder *> FindFoldersByName(const QString &name) const { return foldersByName_.values(name); }
+
+        /// @return Number of items in the index.
+        int Size() const { return items_.size(); }
+
+    private:
+        /// Items by id.
+        QMultiHash<QString, AbstractInventoryItem *> items_;
+
+        /// Folders by name.
+        QMultiHash<QString, InventoryFolder *> foldersByName_;
+    };
+}
+
+#endif
@@ -16,6 +16,8 @@
 #include "OpenSimInventoryDataModel.h"
 #include "WebdavInventoryDataModel.h"
 #include "InventoryAsset.h"
+#include "InventoryFolder.h"
+#include "InventoryItemIndex.h"
 #include "ItemPropertiesWindow.h"
 #include "InventoryService.h"
 
@@ -44,6 +46,10 @@
 #include <QStringList>
 #include <QVector>
 
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int.hpp>
+#include <boost/random/variate_generator.hpp>
+
 #include "MemoryLeakCheck.h"
 
 using namespace ProtocolUtilities;
@@ -92,6 +98,10 @@ void InventoryModule::Initialize()
     RegisterConsoleCommand(Console::CreateCommand("MultiUpload", "Upload multiple assets.",
         Console::Bind(this, &InventoryModule::UploadMultipleAssets)));
 
+    RegisterConsoleCommand(Console::CreateCommand("BenchInventory",
+        "Benchmarks item lookups of a 100000 item inventory with and without the item index. Usage: BenchInventory(lookups)",
+        Console::Bind(this, &InventoryModule::BenchmarkInventory)));
+
 #ifdef _DEBUG
     RegisterConsoleCommand(Console::CreateCommand("InvTest", "Inventory service debug/testing command.",
         Console::Bind(this, &InventoryModule::InventoryServiceTest)));
@@ -208,7 +218,7 @@ bool InventoryModule::HandleEvent(event_category_id_t category_id, event_id_t ev
             case AT_RealXtend:
             {
                 // Create OpenSim inventory model.
-                inventory_ = InventoryPtr(new OpenSimInventoryDataModel(this, auth->inventorySkeleton.get()));
+                inventory_ = InventoryPtr(new OpenSimInventoryDataModel(this, auth->inventorySkeleton));
 
                 // Set world stream used for sending udp packets.
                 static_cast<OpenSimInventoryDataModel *>(inventory_.get())->SetWorldStream(currentWorldStream_);
@@ -599,6 +609,70 @@ Console::CommandResult InventoryModule::InventoryServiceTest(const StringVector
     return Console::ResultSuccess();
 }
 
+Console::CommandResult InventoryModule::BenchmarkInventory(const StringVector &params)
+{
+    int lookups = (params.size() > 0) ? ParseString<int>(params[0], 100) : 100;
+    if (lookups < 1)
+        lookups = 1;
+
+    // Synthetic inventory of 1000 folders with 100 assets each.
+    const int folderCount = 1000;
+    const int assetsPerFolder = 100;
+    const double freq = (double)GetCurrentClockFreq();
+
+    InventoryFolder root(RexUUID::CreateRandom().ToQString(), "Benchmark");
+    QStringList ids;
+    for(int f = 0; f < folderCount; ++f)
+    {
+        InventoryFolder *folder = new InventoryFolder(RexUUID::CreateRandom().ToQString(),
+            "Folder " + QString::number(f), &root);
+        root.AddChild(folder);
+        for(int a = 0; a < assetsPerFolder; ++a)
+        {
+            QString id = RexUUID::CreateRandom().ToQString();
+            folder->AddChild(new InventoryAsset(id, "", "Asset " + QString::number(a), folder));
+            ids << id;
+        }
+    }
+
+    // A fixed seed keeps the runs comparable, without reseeding the generator of the rest of the process
+    boost::mt19937 engine(0);
+    boost::variate_generator<boost::mt19937&, boost::uniform_int<> > pick(engine, boost::uniform_int<>(0, ids.size() - 1));
+    QStringList searchIds;
+    for(int i = 0; i < lookups; ++i)
+        searchIds << ids[pick()];
+
+    int walkFound = 0;
+    tick_t start = GetCurrentClockTime();
+    foreach(const QString &id, searchIds)
+        if (root.GetChildById(id))
+            ++walkFound;
+    double walkTime = (GetCurrentClockTime() - start) / freq;
+
+    InventoryItemIndex index;
+    start = GetCurrentClockTime();
+    root.SetIndex(&index);
+    double indexBuildTime = (GetCurrentClockTime() - start) / freq;
+
+    int indexFound = 0;
+    start = GetCurrentClockTime();
+    foreach(const QString &id, searchIds)
+        if (root.GetChildById(id))
+            ++indexFound;
+    double indexTime = (GetCurrentClockTime() - start) / freq;
+
+    int itemCount = index.Size();
+    // Detach the index before the tree is destroyed.
+    root.SetIndex(0);
+
+    std::stringstream result;
+    result << "Items: " << itemCount << ", lookups: " << lookups << std::endl
+        << "Tree walk: " << walkTime * 1000.0 << " ms, found " << walkFound << std::endl
+        << "Index build: " << indexBuildTime * 1000.0 << " ms" << std::endl
+        << "Index: " << indexTime * 1000.0 << " ms, found " << indexFound;
+    return Console::ResultSuccess(result.str());
+}
+
 void InventoryModule::HandleInventoryDescendents(IEventData* event_data)
 {
     NetworkEventInboundData *data = checked_static_cast<NetworkEventInboundData *>(event_data);
@@ -93,6 +93,9 @@ namespace Inventory
         /// Console command for testing the inventory service.
         Console::CommandResult InventoryServiceTest(const StringVector &params);
 
+        /// Console command for benchmarking id lookups of a large inventory with and without the item index.
+        Console::CommandResult BenchmarkInventory(const StringVector &params);
+
         /// Creates inventory window.
         void CreateInventoryWindow();
 
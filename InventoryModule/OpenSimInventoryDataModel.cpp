@@ -46,12 +46,13 @@ namespace Inventory
 
 OpenSimInventoryDataModel::OpenSimInventoryDataModel(
     InventoryModule *owner,
-    ProtocolUtilities::InventorySkeleton *inventory_skeleton) :
+    ProtocolUtilities::InventoryPtr inventory_skeleton) :
     owner_(owner),
     rootFolder_(0),
+    inventorySkeleton_(inventory_skeleton),
     worldLibraryOwnerId_("")
 {
-    SetupModelData(inventory_skeleton);
+    SetupModelData(inventory_skeleton.get());
 }
 
 OpenSimInventoryDataModel::~OpenSimInventoryDataModel()
@@ -61,12 +62,19 @@ OpenSimInventoryDataModel::~OpenSimInventoryDataModel()
 
 AbstractInventoryItem *OpenSimInventoryDataModel::GetFirstChildFolderByName(const QString &searchName) const
 {
+    // Create the skeleton folders with this name first, so that the search finds the first one in the tree.
+    foreach(const QString &id, pendingFolderIdsByName_.values(searchName))
+        MaterializeFolder(id);
+
     return rootFolder_->GetFirstChildFolderByName(searchName);
 }
 
 AbstractInventoryItem *OpenSimInventoryDataModel::GetChildFolderById(const QString &searchId) const
 {
-    return rootFolder_->GetChildFolderById(searchId);
+    InventoryFolder *folder = rootFolder_->GetChildFolderById(searchId);
+    if (!folder)
+        folder = MaterializeFolder(searchId);
+    return folder;
 }
 
 AbstractInventoryItem *OpenSimInventoryDataModel::GetChildAssetById(const QString &searchId) const
@@ -76,7 +84,10 @@ AbstractInventoryItem *OpenSimInventoryDataModel::GetChildAssetById(const QStrin
 
 AbstractInventoryItem *OpenSimInventoryDataModel::GetChildById(const QString &searchId) const
 {
-    return rootFolder_->GetChildById(searchId);
+    AbstractInventoryItem *item = rootFolder_->GetChildById(searchId);
+    if (!item)
+        item = MaterializeFolder(searchId);
+    return item;
 }
 
 AbstractInventoryItem *OpenSimInventoryDataModel::GetRoot() const
@@ -86,17 +97,17 @@ AbstractInventoryItem *OpenSimInventoryDataModel::GetRoot() const
 
 AbstractInventoryItem *OpenSimInventoryDataModel::GetTrashFolder() const
 {
-    return rootFolder_->GetFirstChildFolderByName("Trash");
+    return GetFirstChildFolderByName("Trash");
 }
 
 InventoryFolder *OpenSimInventoryDataModel::GetMyInventoryFolder() const
 {
-    return rootFolder_->GetFirstChildFolderByName("My Inventory");
+    return static_cast<InventoryFolder *>(GetFirstChildFolderByName("My Inventory"));
 }
 
 InventoryFolder *OpenSimInventoryDataModel::GetOpenSimLibraryFolder() const
 {
-    return rootFolder_->GetFirstChildFolderByName("OpenSim Library");
+    return static_cast<InventoryFolder *>(GetFirstChildFolderByName("OpenSim Library"));
 }
 
 AbstractInventoryItem *OpenSimInventoryDataModel::GetOrCreateNewFolder(
@@ -109,13 +120,23 @@ AbstractInventoryItem *OpenSimInventoryDataModel::GetOrCreateNewFolder(
     if (!parent)
         return 0;
 
+    // Create the skeleton folders of the parent first so that they are not duplicated later.
+    BuildChildFolders(parent);
+
     // Return an existing folder if one with the given id is present.
     InventoryFolder *existing = dynamic_cast<InventoryFolder *>(parent->GetChildFolderById(id));
     if (existing)
         return existing;
 
-    // Create a new folder.
+    // Create a new folder. If this is a skeleton folder which the server has placed somewhere else, it's not
+    // created again from the skeleton, but its child folders still are.
     InventoryFolder *newFolder = new InventoryFolder(id, name, parent);
+    if (pendingFolders_.contains(id))
+    {
+        ProtocolUtilities::InventoryFolderSkeleton *skeleton = pendingFolders_.take(id).skeleton;
+        pendingFolderIdsByName_.remove(skeleton->name.c_str(), id);
+        unbuiltFolders_[id] = skeleton;
+    }
 
     if (GetOpenSimLibraryFolder())
         if (parent->IsDescendentOf(GetOpenSimLibraryFolder()))
@@ -142,6 +163,8 @@ AbstractInventoryItem *OpenSimInventoryDataModel::GetOrCreateNewAsset(
     if (!parent)
         return 0;
 
+    BuildChildFolders(parent);
+
     // Return an existing asset if one with the given id is present.
     InventoryAsset *existing = dynamic_cast<InventoryAsset *>(parent->GetChildAssetById(inventory_id));
     if (existing)
@@ -161,6 +184,9 @@ bool OpenSimInventoryDataModel::FetchInventoryDescendents(AbstractInventoryItem
     if (item->GetItemType() != AbstractInventoryItem::Type_Folder)
         return false;
 
+    // The folder is being expanded, so its child folders are needed now.
+    BuildChildFolders(static_cast<InventoryFolder *>(item));
+
     ///\note    Due to some server-side mystery behaviour we must send the same packet twice: once
     ///         with fetch_folders = true & fetch_items = false and once with fetch_folders = false & fetch_items = true
     ///         in order to reveice the inventory item information correctly (asset&inventory types at least).
@@ -323,6 +349,7 @@ bool OpenSimInventoryDataModel::OpenItem(AbstractInventoryItem *item)
 void OpenSimInventoryDataModel::UploadFile(const QString &filename, AbstractInventoryItem *parent_folder)
 {
     CreateRexInventoryFolders();
+    CreateUploadFolders(QStringList(filename));
 
     if (!HasUploadCapability())
     {
@@ -344,6 +371,7 @@ void OpenSimInventoryDataModel::UploadFile(const QString &filename, AbstractInve
 void OpenSimInventoryDataModel::UploadFiles(QStringList &filenames, QStringList &names, AbstractInventoryItem *parent_folder)
 {
     CreateRexInventoryFolders();
+    CreateUploadFolders(filenames);
 
     if (!HasUploadCapability())
     {
@@ -365,6 +393,7 @@ void OpenSimInventoryDataModel::UploadFilesFromBuffer(QStringList &filenames, QV
     AbstractInventoryItem *parent_folder)
 {
     CreateRexInventoryFolders();
+    CreateUploadFolders(filenames);
 
     if (!HasUploadCapability())
     {
@@ -841,19 +870,21 @@ QString OpenSimInventoryDataModel::CreateNameFromFilename(const QString &filenam
     return name;
 }
 
-void OpenSimInventoryDataModel::CreateNewFolderFromFolderSkeleton(
+InventoryFolder *OpenSimInventoryDataModel::CreateNewFolderFromFolderSkeleton(
     InventoryFolder *parent_folder,
-    ProtocolUtilities::InventoryFolderSkeleton *folder_skeleton)
+    ProtocolUtilities::InventoryFolderSkeleton *folder_skeleton) const
 {
-    using namespace ProtocolUtilities;
+    QString id = folder_skeleton->id.ToQString();
+    QString name = folder_skeleton->name.c_str();
 
-    InventoryFolder *newFolder = new InventoryFolder(folder_skeleton->id.ToQString(),
-        folder_skeleton->name.c_str(), parent_folder, folder_skeleton->editable);
+    InventoryFolder *newFolder = new InventoryFolder(id, name, parent_folder, folder_skeleton->editable);
     //if (!folder_skeleton->HasChildren())
     newFolder->SetDirty(true);
 
-    if (!rootFolder_ && !parent_folder)
-        rootFolder_ = newFolder;
+    pendingFolders_.remove(id);
+    pendingFolderIdsByName_.remove(name, id);
+    if (!folder_skeleton->children.empty())
+        unbuiltFolders_[id] = folder_skeleton;
 
     if (parent_folder)
     {
@@ -863,27 +894,76 @@ void OpenSimInventoryDataModel::CreateNewFolderFromFolderSkeleton(
         InventoryAsset *dummy = new InventoryAsset("DummyItem", "", "Loading...", newFolder);
         newFolder->AddChild(dummy);
 
-        if (newFolder == GetOpenSimLibraryFolder())
+        // Flag Library folders. They have some special behavior.
+        if (parent_folder->IsLibraryItem() || (parent_folder == rootFolder_ && name == "OpenSim Library"))
             newFolder->SetIsLibraryItem(true);
+    }
 
-        // Flag Library folders. They have some special behavior.
-        if (GetOpenSimLibraryFolder())
-            if (newFolder->IsDescendentOf(GetOpenSimLibraryFolder()))
-                newFolder->SetIsLibraryItem(true);
+    return newFolder;
+}
+
+void OpenSimInventoryDataModel::BuildChildFolders(InventoryFolder *folder) const
+{
+    using namespace ProtocolUtilities;
+
+    QHash<QString, InventoryFolderSkeleton *>::iterator it = unbuiltFolders_.find(folder->GetID());
+    if (it == unbuiltFolders_.end())
+        return;
+
+    InventoryFolderSkeleton *folder_skeleton = it.value();
+    unbuiltFolders_.erase(it);
+
+    InventoryFolderSkeleton::FolderIter iter = folder_skeleton->children.begin();
+    while(iter != folder_skeleton->children.end())
+    {
+        // Skip folders which the server has already placed in the tree.
+        if (pendingFolders_.contains(iter->id.ToQString()))
+            CreateNewFolderFromFolderSkeleton(folder, &*iter);
+        ++iter;
     }
+}
+
+InventoryFolder *OpenSimInventoryDataModel::MaterializeFolder(const QString &id) const
+{
+    QHash<QString, PendingFolder>::const_iterator it = pendingFolders_.find(id);
+    if (it == pendingFolders_.end())
+        return 0;
 
+    QString parentId = it.value().parentId;
+    InventoryFolder *parent = parentId == rootFolder_->GetID() ? rootFolder_ : rootFolder_->GetChildFolderById(parentId);
+    if (!parent)
+        parent = MaterializeFolder(parentId);
+    if (!parent)
+        return 0;
+
+    BuildChildFolders(parent);
+    return parent->GetChildFolderById(id);
+}
+
+void OpenSimInventoryDataModel::AddPendingSkeletonFolders(ProtocolUtilities::InventoryFolderSkeleton *folder_skeleton)
+{
+    using namespace ProtocolUtilities;
+
+    QString parentId = folder_skeleton->id.ToQString();
     InventoryFolderSkeleton::FolderIter iter = folder_skeleton->children.begin();
     while(iter != folder_skeleton->children.end())
     {
-        parent_folder = newFolder;
-        CreateNewFolderFromFolderSkeleton(parent_folder, &*iter);
+        PendingFolder pending;
+        pending.skeleton = &*iter;
+        pending.parentId = parentId;
+
+        QString id = iter->id.ToQString();
+        pendingFolders_[id] = pending;
+        pendingFolderIdsByName_.insert(iter->name.c_str(), id);
+
+        AddPendingSkeletonFolders(&*iter);
         ++iter;
     }
 }
 
 void OpenSimInventoryDataModel::SetupModelData(ProtocolUtilities::InventorySkeleton *inventory_skeleton)
 {
-    if (!inventory_skeleton && !inventory_skeleton->GetRoot())
+    if (!inventory_skeleton || !inventory_skeleton->GetRoot())
     {
         InventoryModule::LogError("Couldn't find inventory root folder skeleton. Can't create OpenSim inventory data model.");
         return;
@@ -891,7 +971,22 @@ void OpenSimInventoryDataModel::SetupModelData(ProtocolUtilities::InventorySkele
 
     worldLibraryOwnerId_ = inventory_skeleton->worldLibraryOwnerId.ToQString();
 
-    CreateNewFolderFromFolderSkeleton(0, inventory_skeleton->GetRoot());
+    // Only the root and its children are created now. Rest of the folders are created from the skeleton when
+    // they're expanded or looked up, so that logging in with a large inventory doesn't build the whole tree.
+    AddPendingSkeletonFolders(inventory_skeleton->GetRoot());
+    rootFolder_ = CreateNewFolderFromFolderSkeleton(0, inventory_skeleton->GetRoot());
+    rootFolder_->SetIndex(&itemIndex_);
+    BuildChildFolders(rootFolder_);
+}
+
+void OpenSimInventoryDataModel::CreateUploadFolders(const QStringList &filenames)
+{
+    foreach(const QString &filename, filenames)
+    {
+        asset_type_t asset_type = RexTypes::GetAssetTypeFromFilename(filename.toStdString());
+        if (asset_type != RexAT_None)
+            GetFirstChildFolderByName(RexTypes::GetCategoryNameForAssetType(asset_type).c_str());
+    }
 }
 
 void OpenSimInventoryDataModel::ThreadedUploadFiles(QStringList &filenames, QStringList &item_names)
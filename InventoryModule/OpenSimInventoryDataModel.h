@@ -9,11 +9,13 @@
 #define incl_InventoryModule_OpenSimInventoryDataModel_h
 
 #include "AbstractInventoryDataModel.h"
+#include "InventoryItemIndex.h"
 
 #include "RexTypes.h"
 
 #include <boost/shared_ptr.hpp>
 
+#include <QHash>
 #include <QMap>
 #include <QPair>
 #include <QVector>
@@ -26,6 +28,7 @@ namespace ProtocolUtilities
     class InventorySkeleton;
     class InventoryFolderSkeleton;
     class WorldStream;
+    typedef boost::shared_ptr<InventorySkeleton> InventoryPtr;
     typedef boost::shared_ptr<WorldStream> WorldStreamPtr;
 }
 
@@ -43,16 +46,20 @@ namespace Inventory
     public:
         /// Constructor.
         /// @param owner Owner module
-        /// @inventory_skeleton Inventory skeleton pointer.
-        OpenSimInventoryDataModel(InventoryModule *owner, ProtocolUtilities::InventorySkeleton *inventory_skeleton);
+        /// @inventory_skeleton Inventory skeleton. Folders are created from it as they are needed, so the data
+        /// model keeps a reference to it.
+        OpenSimInventoryDataModel(InventoryModule *owner, ProtocolUtilities::InventoryPtr inventory_skeleton);
 
         /// Destructor.
         virtual ~OpenSimInventoryDataModel();
 
         /// AbstractInventoryDataModel override.
+        /// @note Creates the folders of the inventory skeleton that have the requested name, if they haven't been
+        /// created yet.
         AbstractInventoryItem *GetFirstChildFolderByName(const QString &searchName) const;
 
         /// AbstractInventoryDataModel override.
+        /// @note Creates the folder, and its ancestors, from the inventory skeleton if it hasn't been created yet.
         AbstractInventoryItem *GetChildFolderById(const QString &searchId) const;
 
         /// AbstractInventoryDataModel override.
@@ -60,6 +67,7 @@ namespace Inventory
         AbstractInventoryItem *GetChildAssetById(const QString &searchId) const;
 
         /// AbstractInventoryDataModel override.
+        /// @note Creates the folder, and its ancestors, from the inventory skeleton if it hasn't been created yet.
         AbstractInventoryItem *GetChildById(const QString &searchId) const;
 
         /// AbstractInventoryDataModel override.
@@ -113,7 +121,7 @@ namespace Inventory
         /// @return Pointer to "My Inventory" folder or null if not found.
         InventoryFolder *GetMyInventoryFolder() const;
 
-        /// @return Pointer to "My Inventory" folder or null if not found.
+        /// @return Pointer to "OpenSim Library" folder or null if not found.
         InventoryFolder *GetOpenSimLibraryFolder() const;
 
         /// OpenSim inventory uses trash folder. Returns true.
@@ -198,17 +206,35 @@ namespace Inventory
     private:
         Q_DISABLE_COPY(OpenSimInventoryDataModel);
 
-        /// Utility function for creating new folders from the folder skeletons. Used recursively.
-        /// @param parent_folder Parent folder.
+        /// Utility function for creating a new folder from a folder skeleton. The child folders are not created
+        /// until BuildChildFolders() is called for the new folder.
+        /// @param parent_folder Parent folder, or null for the root folder.
         /// @param folder_skeleton Folder skeleton for the folder to be created.
-        void CreateNewFolderFromFolderSkeleton(
+        /// @return The new folder.
+        InventoryFolder *CreateNewFolderFromFolderSkeleton(
             InventoryFolder *parent_folder,
-            ProtocolUtilities::InventoryFolderSkeleton *folder_skeleton);
+            ProtocolUtilities::InventoryFolderSkeleton *folder_skeleton) const;
+
+        /// Creates the child folders of a folder from its skeleton, if they haven't been created yet.
+        /// @param folder Folder.
+        void BuildChildFolders(InventoryFolder *folder) const;
+
+        /// Creates a skeleton folder, and the ancestors it needs, if it hasn't been created yet.
+        /// @param id Folder ID.
+        /// @return The created folder, or null if there was no such skeleton folder left to create.
+        InventoryFolder *MaterializeFolder(const QString &id) const;
+
+        /// Adds the descendents of a skeleton folder to the folders waiting to be created. Used recursively.
+        /// @param folder_skeleton Folder skeleton.
+        void AddPendingSkeletonFolders(ProtocolUtilities::InventoryFolderSkeleton *folder_skeleton);
 
         /// Creates the tree model data for inventory.
         /// @param inventory_skeleton OpenSim inventory skeleton.
         void SetupModelData(ProtocolUtilities::InventorySkeleton *inventory_skeleton);
 
+        /// Makes sure the category folders of the files to be uploaded exist before the upload thread looks them up.
+        void CreateUploadFolders(const QStringList &filenames);
+
         /// Used by UploadFiles.
         void ThreadedUploadFiles(QStringList &filenames, QStringList &item_names);
 
@@ -232,6 +258,31 @@ namespace Inventory
         /// The root folder.
         InventoryFolder *rootFolder_;
 
+        /// Inventory skeleton received at login.
+        ProtocolUtilities::InventoryPtr inventorySkeleton_;
+
+        /// Index of the items in the inventory tree.
+        InventoryItemIndex itemIndex_;
+
+        /// Skeleton folder that hasn't been created yet.
+        struct PendingFolder
+        {
+            /// Folder skeleton.
+            ProtocolUtilities::InventoryFolderSkeleton *skeleton;
+
+            /// ID of the parent folder.
+            QString parentId;
+        };
+
+        /// Skeleton folders that haven't been created yet, by id.
+        mutable QHash<QString, PendingFolder> pendingFolders_;
+
+        /// Ids of the skeleton folders that haven't been created yet, by name.
+        mutable QMultiHash<QString, QString> pendingFolderIdsByName_;
+
+        /// Created folders whose child folders haven't been created from the skeleton yet, by id.
+        mutable QHash<QString, ProtocolUtilities::InventoryFolderSkeleton *> unbuiltFolders_;
+
         /// World Library owner id.
         QString worldLibraryOwnerId_;
 
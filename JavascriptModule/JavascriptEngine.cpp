@@ -4,23 +4,29 @@
 #include "DebugOperatorNew.h"
 #include "JavascriptEngine.h"
 #include "JavascriptModule.h"
-#include "ScriptMetaTypeDefines.h"
-#include "NaaliCoreTypeDefines.h"
+#include "JavascriptEnginePool.h"
+#include "JavascriptProgramCache.h"
+#include "HighPerfClock.h"
 
-#include <QFile>
+#include <QtScript>
 #include <QUiLoader>
 
 #include "MemoryLeakCheck.h"
 
-JavascriptEngine::JavascriptEngine(const QString &scriptRef):
+JavascriptEngine::JavascriptEngine(const QString &scriptRef, JavascriptModule *module):
     engine_(0),
-    scriptRef_(scriptRef)
+    scriptRef_(scriptRef),
+    module_(module)
 {
-    engine_ = new QScriptEngine;
+    loadStats_.scriptRef = scriptRef;
 
-    ExposeQtMetaTypes(engine_);
-    ExposeNaaliCoreTypes(engine_);
-    ExposeCoreApiMetaTypes(engine_);
+    tick_t start = GetCurrentClockTime();
+    JavascriptEnginePool *pool = module_ ? module_->GetEnginePool() : 0;
+    if (pool)
+        engine_ = pool->Acquire(&loadStats_.pooledEngine);
+    else
+        engine_ = JavascriptEnginePool::CreateEngine();
+    loadStats_.engineTime = (GetCurrentClockTime() - start) / (double)GetCurrentClockFreq();
 }
 
 JavascriptEngine::~JavascriptEngine()
@@ -44,19 +50,39 @@ void JavascriptEngine::Unload()
 
 void JavascriptEngine::Run()
 {
-    QString program = LoadScript();
+    if (!module_)
+        return;
+
+    const double freq = (double)GetCurrentClockFreq();
+    tick_t start = GetCurrentClockTime();
+    ///\todo Now all strings are evaluated as being relative filenames to the current working directory.
+    ///Scripts are all loaded locally. Support here fetching from the asset store, i.e. file://, or knet://, or http://.
+    JavascriptProgramCache::ProgramPtr program = module_->GetProgramCache().Load(scriptRef_.trimmed(), &loadStats_.cachedProgram);
+    loadStats_.loadTime = (GetCurrentClockTime() - start) / freq;
+    if (!program)
+    {
+        JavascriptModule::LogError(("Failed to load script from file " + scriptRef_.trimmed() + "!").toStdString());
+        return;
+    }
+
     //Before we begin to run the script check for syntax errors.
-    QScriptSyntaxCheckResult syntaxResult = engine_->checkSyntax(program);
-    if(syntaxResult.state() != QScriptSyntaxCheckResult::Valid)
+    if (!program->valid)
     {
-        JavascriptModule::LogError("Syntax error in " + scriptRef_.toStdString() + syntaxResult.errorMessage().toStdString()
-            + " In line:" + QString::number(syntaxResult.errorLineNumber()).toStdString());
+        JavascriptModule::LogError("Syntax error in " + scriptRef_.toStdString() + program->error.toStdString());
         return;
     }
 
-    QScriptValue result = engine_->evaluate(program, scriptRef_);
+    start = GetCurrentClockTime();
+#if QT_VERSION >= 0x040700
+    QScriptValue result = engine_->evaluate(program->program);
+#else
+    QScriptValue result = engine_->evaluate(program->source, scriptRef_);
+#endif
+    loadStats_.runTime = (GetCurrentClockTime() - start) / freq;
     if (engine_->hasUncaughtException())
         JavascriptModule::LogError(result.toString().toStdString());
+
+    module_->RecordLoadStats(loadStats_);
 }
 
 void JavascriptEngine::Stop()
@@ -69,21 +95,3 @@ void JavascriptEngine::RegisterService(QObject *serviceObject, const QString &na
     QScriptValue scriptValue = engine_->newQObject(serviceObject);
     engine_->globalObject().setProperty(name, scriptValue);
 }
-
-QString JavascriptEngine::LoadScript() const
-{
-    QString filename = scriptRef_.trimmed();
-    ///\todo Now all strings are evaluated as being relative filenames to the current working directory.
-    ///Scripts are all loaded locally. Support here fetching from the asset store, i.e. file://, or knet://, or http://.
-    QFile scriptFile(filename);
-    bool success = scriptFile.open(QIODevice::ReadOnly);
-    if (!success)
-    {
-        JavascriptModule::LogError(("Failed to load script from file " + filename + "!").toStdString());
-        return "";
-    }
-    QString result = scriptFile.readAll();
-    scriptFile.close();
-    return result;
-}
-
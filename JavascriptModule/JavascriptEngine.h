@@ -11,11 +11,38 @@
 #include "IScriptInstance.h"
 
 class QScriptEngine;
+class JavascriptModule;
+
+/// Load time measurements of one script instance.
+struct JavascriptLoadStats
+{
+    JavascriptLoadStats() : engineTime(0.0), loadTime(0.0), runTime(0.0), pooledEngine(false), cachedProgram(false) {}
+
+    /// Script file.
+    QString scriptRef;
+
+    /// Seconds spent getting the script engine.
+    double engineTime;
+
+    /// Seconds spent loading and checking the program.
+    double loadTime;
+
+    /// Seconds spent running the program.
+    double runTime;
+
+    /// Was the engine taken from the engine pool.
+    bool pooledEngine;
+
+    /// Was the program found in the program cache.
+    bool cachedProgram;
+};
 
 class JavascriptEngine: public IScriptInstance
 {
 public:
-    explicit JavascriptEngine(const QString &scriptRef);
+    /// @param scriptRef Script file.
+    /// @param module Module that provides the engine pool and program cache, and receives the load time measurements.
+    JavascriptEngine(const QString &scriptRef, JavascriptModule *module);
     ~JavascriptEngine();
 
     //! Overload from IScriptInstance
@@ -33,13 +60,16 @@ public:
     //! Register new service to java script engine.
     void RegisterService(QObject *serviceObject, const QString &name);
 
+    //! Returns load time measurements of the last run.
+    const JavascriptLoadStats &GetLoadStats() const { return loadStats_; }
+
     //void SetPrototype(QScriptable *prototype, );
 
 private:
-    QString LoadScript() const;
-
     QScriptEngine *engine_;
     QString scriptRef_;
+    JavascriptModule *module_;
+    JavascriptLoadStats loadStats_;
 };
 
-#endif
\ No newline at end of file
+#endif
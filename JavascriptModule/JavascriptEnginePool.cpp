@@ -0,0 +1,95 @@
+/**
+ *  For conditions of distribution and use, see copyright notice in license.txt
+ *
+ *  @file   JavascriptEnginePool.cpp
+ *  @brief  Pool of prewarmed script engines for Javascript script instances.
+ */
+
+#include "StableHeaders.h"
+#include "DebugOperatorNew.h"
+
+#include "JavascriptEnginePool.h"
+#include "ScriptMetaTypeDefines.h"
+#include "NaaliCoreTypeDefines.h"
+
+#include "Framework.h"
+
+#include <QtScript>
+#include <boost/bind.hpp>
+
+#include "MemoryLeakCheck.h"
+
+JavascriptEnginePool::JavascriptEnginePool(Foundation::Framework *framework, int targetSize) :
+    framework_(framework),
+    targetSize_(targetSize),
+    refillWorkId_(0),
+    hits_(0),
+    misses_(0)
+{
+}
+
+JavascriptEnginePool::~JavascriptEnginePool()
+{
+    Clear();
+}
+
+QScriptEngine *JavascriptEnginePool::Acquire(bool *pooled)
+{
+    QScriptEngine *engine = 0;
+    bool fromPool = !engines_.empty();
+    if (fromPool)
+    {
+        engine = engines_.back();
+        engines_.pop_back();
+        ++hits_;
+    }
+    else
+    {
+        engine = CreateEngine();
+        ++misses_;
+    }
+
+    if (pooled)
+        *pooled = fromPool;
+
+    Refill();
+    return engine;
+}
+
+void JavascriptEnginePool::Refill()
+{
+    if (refillWorkId_ || Size() >= targetSize_ || !framework_)
+        return;
+
+    refillWorkId_ = framework_->GetFrameScheduler()->QueueWork("JavascriptEnginePool_Prewarm",
+        boost::bind(&JavascriptEnginePool::PrewarmOne, this), Foundation::FrameScheduler::PriorityLow);
+}
+
+void JavascriptEnginePool::Clear()
+{
+    if (refillWorkId_ && framework_)
+        framework_->GetFrameScheduler()->CancelWork(refillWorkId_);
+    refillWorkId_ = 0;
+
+    for(size_t i = 0; i < engines_.size(); ++i)
+        delete engines_[i];
+    engines_.clear();
+}
+
+QScriptEngine *JavascriptEnginePool::CreateEngine()
+{
+    QScriptEngine *engine = new QScriptEngine;
+    ExposeQtMetaTypes(engine);
+    ExposeNaaliCoreTypes(engine);
+    ExposeCoreApiMetaTypes(engine);
+    return engine;
+}
+
+void JavascriptEnginePool::PrewarmOne()
+{
+    // Creating one engine at a time lets the frame scheduler spread the work over several frames.
+    refillWorkId_ = 0;
+    if (Size() < targetSize_)
+        engines_.push_back(CreateEngine());
+    Refill();
+}
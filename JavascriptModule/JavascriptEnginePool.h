@@ -0,0 +1,88 @@
+/**
+ *  For conditions of distribution and use, see copyright notice in license.txt
+ *
+ *  @file   JavascriptEnginePool.h
+ *  @brief  Pool of prewarmed script engines for Javascript script instances.
+ */
+
+#ifndef incl_JavascriptModule_JavascriptEnginePool_h
+#define incl_JavascriptModule_JavascriptEnginePool_h
+
+#include "FrameScheduler.h"
+
+#include <vector>
+
+class QScriptEngine;
+
+namespace Foundation
+{
+    class Framework;
+}
+
+/// Pool of prewarmed script engines for Javascript script instances.
+/** Creating a QScriptEngine and exposing the Naali types to it takes milliseconds, which adds up when a region with
+    hundreds of scripted entities is entered. The pool creates engines ahead of time as low priority frame scheduler
+    work, so that script instances can take a ready engine instead of building one while the region is loading.
+
+    Engines are not returned to the pool after use. A script leaves its globals and signal connections in its engine,
+    and the only reliable way to release them is to delete the engine.
+*/
+class JavascriptEnginePool
+{
+public:
+    /// Constructor.
+    /// @param framework Framework, used for the frame scheduler.
+    /// @param targetSize Number of engines to keep ready.
+    JavascriptEnginePool(Foundation::Framework *framework, int targetSize);
+
+    /// Destructor. Deletes the pooled engines.
+    ~JavascriptEnginePool();
+
+    /// Returns a ready engine, or creates one if the pool is empty. The caller owns the returned engine.
+    /// Starts refilling the pool.
+    /// @param pooled If not null, set to true if the engine was taken from the pool.
+    QScriptEngine *Acquire(bool *pooled = 0);
+
+    /// Queues frame scheduler work that creates engines until the pool has the target number of engines.
+    void Refill();
+
+    /// Deletes the pooled engines and cancels refilling.
+    void Clear();
+
+    /// Creates a new engine and exposes the Naali core types to it.
+    static QScriptEngine *CreateEngine();
+
+    /// @return Number of ready engines.
+    int Size() const { return (int)engines_.size(); }
+
+    /// @return Number of engines the pool tries to keep ready.
+    int TargetSize() const { return targetSize_; }
+
+    /// @return Number of Acquire calls that were served from the pool.
+    uint Hits() const { return hits_; }
+
+    /// @return Number of Acquire calls that had to create an engine.
+    uint Misses() const { return misses_; }
+
+private:
+    /// Creates one engine and queues the next one if the pool is still not full.
+    void PrewarmOne();
+
+    /// Framework.
+    Foundation::Framework *framework_;
+
+    /// Ready engines.
+    std::vector<QScriptEngine *> engines_;
+
+    /// Number of engines to keep ready.
+    int targetSize_;
+
+    /// Id of the queued refill work, zero if none.
+    Foundation::frame_work_id_t refillWorkId_;
+
+    /// Statistics.
+    uint hits_;
+    uint misses_;
+};
+
+#endif
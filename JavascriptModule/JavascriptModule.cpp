@@ -11,6 +11,7 @@
 #include "JavascriptModule.h"
 #include "ScriptMetaTypeDefines.h"
 #include "JavascriptEngine.h"
+#include "JavascriptEnginePool.h"
 
 #include "EC_Script.h"
 #include "SceneManager.h"
@@ -21,6 +22,7 @@
 #include "Console.h"
 #include "ConsoleCommandServiceInterface.h"
 #include "NaaliCoreTypeDefines.h"
+#include "ConfigurationManager.h"
 
 #include <QtScript>
 
@@ -33,7 +35,8 @@ JavascriptModule *javascriptModuleInstance_ = 0;
 
 JavascriptModule::JavascriptModule() :
     IModule(type_name_static_),
-    engine(new QScriptEngine(this))
+    engine(new QScriptEngine(this)),
+    enginePool_(0)
 {
 }
 
@@ -78,6 +81,12 @@ void JavascriptModule::Initialize()
 void JavascriptModule::PostInitialize()
 {
     RegisterNaaliCoreMetaTypes();
+    RegisterCoreApiMetaTypes();
+
+    // Script instances take their engines from the pool; start filling it in the background.
+    int poolSize = GetFramework()->GetDefaultConfig().DeclareSetting("JavascriptModule", "engine_pool_size", 8);
+    enginePool_ = new JavascriptEnginePool(GetFramework(), poolSize);
+    enginePool_->Refill();
 
     // Add Naali Core API objcects as js services.
     services_["input"] = GetFramework()->GetInput();
@@ -97,6 +106,10 @@ void JavascriptModule::PostInitialize()
     RegisterConsoleCommand(Console::CreateCommand(
         "JsReloadScripts", "Reloads and re-executes startup scripts.",
         Console::Bind(this, &JavascriptModule::ConsoleReloadScripts)));
+
+    RegisterConsoleCommand(Console::CreateCommand(
+        "JsLoadStats", "Prints load times of scripts, and engine pool and program cache statistics.",
+        Console::Bind(this, &JavascriptModule::ConsoleLoadStats)));
     
     // Initialize startup scripts
     LoadStartupScripts();
@@ -105,6 +118,7 @@ void JavascriptModule::PostInitialize()
 void JavascriptModule::Uninitialize()
 {
     UnloadStartupScripts();
+    SAFE_DELETE(enginePool_);
 }
 
 void JavascriptModule::Update(f64 frametime)
@@ -143,6 +157,33 @@ Console::CommandResult JavascriptModule::ConsoleReloadScripts(const StringVector
     return Console::ResultSuccess();
 }
 
+Console::CommandResult JavascriptModule::ConsoleLoadStats(const StringVector &params)
+{
+    LogInfo("Script load times (engine / load / run, ms):");
+    foreach(const JavascriptLoadStats &stats, loadStats_)
+    {
+        QString line = QString("  %1: %2%3 / %4%5 / %6").arg(stats.scriptRef)
+            .arg(stats.engineTime * 1000.0, 0, 'f', 2).arg(stats.pooledEngine ? " (pooled)" : "")
+            .arg(stats.loadTime * 1000.0, 0, 'f', 2).arg(stats.cachedProgram ? " (cached)" : "")
+            .arg(stats.runTime * 1000.0, 0, 'f', 2);
+        LogInfo(line.toStdString());
+    }
+    if (enginePool_)
+        LogInfo("Engine pool: " + ToString(enginePool_->Size()) + "/" + ToString(enginePool_->TargetSize()) + " ready, " +
+            ToString(enginePool_->Hits()) + " hits, " + ToString(enginePool_->Misses()) + " misses");
+    LogInfo("Program cache: " + ToString(programCache_.Size()) + " programs, " + ToString(programCache_.Hits()) + " hits, " +
+        ToString(programCache_.Misses()) + " misses");
+
+    return Console::ResultSuccess();
+}
+
+void JavascriptModule::RecordLoadStats(const JavascriptLoadStats &stats)
+{
+    loadStats_[stats.scriptRef] = stats;
+    LogDebug(QString("Loaded %1: engine %2 ms, load %3 ms, run %4 ms").arg(stats.scriptRef)
+        .arg(stats.engineTime * 1000.0, 0, 'f', 2).arg(stats.loadTime * 1000.0, 0, 'f', 2).arg(stats.runTime * 1000.0, 0, 'f', 2).toStdString());
+}
+
 JavascriptModule *JavascriptModule::GetInstance()
 {
     assert(javascriptModuleInstance_);
@@ -163,10 +204,17 @@ void JavascriptModule::RunString(const QString &codestr, const QVariantMap &cont
 
 void JavascriptModule::RunScript(const QString &scriptFileName)
 {
-    QFile scriptFile(scriptFileName);
-    scriptFile.open(QIODevice::ReadOnly);
-    engine->evaluate(scriptFile.readAll(), scriptFileName);
-    scriptFile.close();
+    JavascriptProgramCache::ProgramPtr program = programCache_.Load(scriptFileName);
+    if (!program)
+        return;
+#if QT_VERSION >= 0x040700
+    if (program->valid)
+    {
+        engine->evaluate(program->program);
+        return;
+    }
+#endif
+    engine->evaluate(program->source, scriptFileName);
 }
 
 void JavascriptModule::SceneAdded(const QString &name)
@@ -189,7 +237,7 @@ void JavascriptModule::ScriptChanged(const QString &scriptRef)
         // If script ref is empty or otherwise invalid we need to destroy the previous script if it's type is javascript.
         if(dynamic_cast<JavascriptEngine*>(sender->GetScriptInstance()))
         {
-            JavascriptEngine *javaScriptInstance = new JavascriptEngine("");
+            JavascriptEngine *javaScriptInstance = new JavascriptEngine("", this);
             sender->SetScriptInstance(javaScriptInstance);
         }
         return;
@@ -198,7 +246,7 @@ void JavascriptModule::ScriptChanged(const QString &scriptRef)
     if (sender->type.Get() != "js")
         return;
     
-    JavascriptEngine *javaScriptInstance = new JavascriptEngine(scriptRef);
+    JavascriptEngine *javaScriptInstance = new JavascriptEngine(scriptRef, this);
     sender->SetScriptInstance(javaScriptInstance);
 
     //Register all services to script engine
@@ -255,7 +303,7 @@ void JavascriptModule::LoadStartupScripts()
     // Create a scriptengine for each of the files, and try to run
     for (uint i = 0; i < scripts.size(); ++i)
     {
-        JavascriptEngine* javaScriptInstance = new JavascriptEngine(QString::fromStdString(scripts[i]));
+        JavascriptEngine* javaScriptInstance = new JavascriptEngine(QString::fromStdString(scripts[i]), this);
         
         //Register all services to script engine
         PrepareScriptEngine(javaScriptInstance);
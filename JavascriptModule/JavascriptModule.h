@@ -12,14 +12,17 @@
 #include "ModuleLoggingFunctions.h"
 #include "AttributeChangeType.h"
 #include "ScriptServiceInterface.h"
+#include "JavascriptEngine.h"
+#include "JavascriptProgramCache.h"
 
 #include <QObject>
+#include <QMap>
 
 class QScriptEngine;
 class QScriptContext;
 class QScriptEngine;
 class QScriptValue;
-class JavascriptEngine;
+class JavascriptEnginePool;
 
 /// Enables Javascript execution and scripting in Naali.
 /**
@@ -70,6 +73,16 @@ public:
     Console::CommandResult ConsoleRunString(const StringVector &params);
     Console::CommandResult ConsoleRunFile(const StringVector &params);
     Console::CommandResult ConsoleReloadScripts(const StringVector &params);
+    Console::CommandResult ConsoleLoadStats(const StringVector &params);
+
+    /// Returns the pool of prewarmed script engines, or null if the module is not initialized.
+    JavascriptEnginePool *GetEnginePool() const { return enginePool_; }
+
+    /// Returns the cache of loaded script programs.
+    JavascriptProgramCache &GetProgramCache() { return programCache_; }
+
+    /// Stores the load time measurements of a script for the JsLoadStats console command.
+    void RecordLoadStats(const JavascriptLoadStats &stats);
     
 public slots:
     //! New scene has been added to foundation.
@@ -106,6 +119,15 @@ private:
     
     /// Engines for executing startup (possibly persistent) scripts
     std::vector<JavascriptEngine*> startupScripts_;
+
+    /// Prewarmed engines for script instances
+    JavascriptEnginePool *enginePool_;
+
+    /// Loaded programs of script files
+    JavascriptProgramCache programCache_;
+
+    /// Load time measurements of the latest run of each script file
+    QMap<QString, JavascriptLoadStats> loadStats_;
 };
 
 //api stuff
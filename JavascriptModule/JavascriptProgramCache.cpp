@@ -0,0 +1,86 @@
+/**
+ *  For conditions of distribution and use, see copyright notice in license.txt
+ *
+ *  @file   JavascriptProgramCache.cpp
+ *  @brief  Cache of loaded and syntax checked Javascript programs.
+ */
+
+#include "StableHeaders.h"
+#include "DebugOperatorNew.h"
+
+#include "JavascriptProgramCache.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QCryptographicHash>
+#include <QScriptEngine>
+
+#include "MemoryLeakCheck.h"
+
+JavascriptProgramCache::JavascriptProgramCache() :
+    hits_(0),
+    misses_(0)
+{
+}
+
+JavascriptProgramCache::ProgramPtr JavascriptProgramCache::Load(const QString &fileName, bool *cacheHit)
+{
+    if (cacheHit)
+        *cacheHit = false;
+
+    QFileInfo info(fileName);
+    QMap<QString, FileEntry>::iterator file = files_.find(fileName);
+    if (file != files_.end() && info.exists() && file->modified == info.lastModified() && file->size == info.size())
+    {
+        ++hits_;
+        if (cacheHit)
+            *cacheHit = true;
+        return file->program;
+    }
+
+    QFile scriptFile(fileName);
+    if (!scriptFile.open(QIODevice::ReadOnly))
+        return ProgramPtr();
+    QByteArray contents = scriptFile.readAll();
+    scriptFile.close();
+
+    QByteArray hash = QCryptographicHash::hash(contents, QCryptographicHash::Md5);
+    ProgramPtr program = programs_.value(hash);
+    if (program)
+    {
+        ++hits_;
+        if (cacheHit)
+            *cacheHit = true;
+    }
+    else
+    {
+        ++misses_;
+        program = ProgramPtr(new Program);
+        program->fileName = fileName;
+        program->source = QString(contents);
+        program->hash = hash;
+
+        QScriptSyntaxCheckResult syntaxResult = QScriptEngine::checkSyntax(program->source);
+        program->valid = syntaxResult.state() == QScriptSyntaxCheckResult::Valid;
+        if (!program->valid)
+            program->error = syntaxResult.errorMessage() + " In line:" + QString::number(syntaxResult.errorLineNumber());
+#if QT_VERSION >= 0x040700
+        else
+            program->program = QScriptProgram(program->source, fileName);
+#endif
+        programs_[hash] = program;
+    }
+
+    FileEntry entry;
+    entry.modified = info.lastModified();
+    entry.size = info.size();
+    entry.program = program;
+    files_[fileName] = entry;
+    return program;
+}
+
+void JavascriptProgramCache::Clear()
+{
+    files_.clear();
+    programs_.clear();
+}
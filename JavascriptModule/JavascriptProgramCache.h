@@ -0,0 +1,100 @@
+/**
+ *  For conditions of distribution and use, see copyright notice in license.txt
+ *
+ *  @file   JavascriptProgramCache.h
+ *  @brief  Cache of loaded and syntax checked Javascript programs.
+ */
+
+#ifndef incl_JavascriptModule_JavascriptProgramCache_h
+#define incl_JavascriptModule_JavascriptProgramCache_h
+
+#include <QString>
+#include <QByteArray>
+#include <QDateTime>
+#include <QMap>
+#if QT_VERSION >= 0x040700
+#include <QScriptProgram>
+#endif
+
+#include <boost/shared_ptr.hpp>
+
+/// Cache of loaded and syntax checked Javascript programs.
+/** Programs are keyed by the MD5 hash of the script contents, so scripts with the same contents share one program
+    even if they are loaded from different files. The file name, modification time and size of each loaded file are
+    remembered, so that an unchanged file is not even read again.
+
+    What the cache saves is reading and hashing the file and checking its syntax. Every script runs in its own engine
+    from JavascriptEnginePool, and the program is still compiled again by each engine that evaluates it. With Qt 4.7
+    and later the cached program is a QScriptProgram, so the engines evaluate the same object instead of a copy of the
+    source, but QScriptProgram keeps its compiled form only within one engine.
+*/
+class JavascriptProgramCache
+{
+public:
+    /// Loaded script program.
+    struct Program
+    {
+        /// File the program was first loaded from.
+        QString fileName;
+
+        /// Source code.
+        QString source;
+
+        /// MD5 hash of the file contents.
+        QByteArray hash;
+
+        /// Did the source pass the syntax check.
+        bool valid;
+
+        /// Syntax error message and line, if not valid.
+        QString error;
+
+#if QT_VERSION >= 0x040700
+        /// Program object to evaluate, compiled separately by each engine.
+        QScriptProgram program;
+#endif
+    };
+
+    typedef boost::shared_ptr<Program> ProgramPtr;
+
+    JavascriptProgramCache();
+
+    /// Returns the program in a file, loading and checking it if it is not in the cache.
+    /// @param fileName Script file.
+    /// @param cacheHit If not null, set to true if the program was found in the cache.
+    /// @return Program, or null if the file could not be read.
+    ProgramPtr Load(const QString &fileName, bool *cacheHit = 0);
+
+    /// Removes all programs.
+    void Clear();
+
+    /// @return Number of cached programs.
+    int Size() const { return programs_.size(); }
+
+    /// @return Number of loads that were served from the cache.
+    uint Hits() const { return hits_; }
+
+    /// @return Number of loads that had to parse the script.
+    uint Misses() const { return misses_; }
+
+private:
+    /// Last seen state of a loaded file.
+    struct FileEntry
+    {
+        QDateTime modified;
+        qint64 size;
+        ProgramPtr program;
+    };
+
+    /// Loaded files by file name.
+    QMap<QString, FileEntry> files_;
+
+    /// Programs by content hash.
+    QMap<QByteArray, ProgramPtr> programs_;
+
+    /// Statistics.
+    uint hits_;
+    uint misses_;
+};
+
+#endif
@@ -177,7 +177,7 @@ void ExposeNaaliCoreTypes(QScriptEngine *engine)
     qScriptRegisterMetaType(engine, toScriptValueTransform, fromScriptValueTransform);
 
     //qScriptRegisterMetaType<IAttribute*>(engine, toScriptValueIAttribute, fromScriptValueIAttribute);
-    int id = qRegisterMetaType<IAttribute*>("IAttribute*");
+    static const int id = qRegisterMetaType<IAttribute*>("IAttribute*");
     qScriptRegisterMetaType_helper(
         engine, id, reinterpret_cast<QScriptEngine::MarshalFunction>(toScriptValueIAttribute),
         reinterpret_cast<QScriptEngine::DemarshalFunction>(fromScriptValueIAttribute),
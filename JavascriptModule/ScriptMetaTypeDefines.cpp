@@ -67,9 +67,6 @@ void ExposeCoreApiMetaTypes(QScriptEngine *engine)
     qScriptRegisterQObjectMetaType<MouseEvent*>(engine);
     qScriptRegisterQObjectMetaType<KeyEvent*>(engine);
     qScriptRegisterQObjectMetaType<InputContext*>(engine);
-    qRegisterMetaType<KeyEvent::EventType>("KeyEvent::EventType");
-    qRegisterMetaType<MouseEvent::EventType>("MouseEvent::EventType");
-    qRegisterMetaType<MouseEvent::MouseButton>("MouseEvent::MouseButton");
 
     // Scene metatypes.
     qScriptRegisterQObjectMetaType<Scene::Entity*>(engine);
@@ -78,7 +75,6 @@ void ExposeCoreApiMetaTypes(QScriptEngine *engine)
     qScriptRegisterQObjectMetaType<IComponent*>(engine);
     //qRegisterMetaType<AttributeChange::Type>("AttributeChange::Type");
     qScriptRegisterMetaType(engine, toScriptValueEnum<AttributeChange::Type>, fromScriptValueEnum<AttributeChange::Type>);
-    qRegisterMetaType<EntityAction::ExecutionType>("EntityAction::ExecutionType");
 
     // Console metatypes.
     qScriptRegisterQObjectMetaType<ScriptConsole*>(engine);
@@ -94,7 +90,18 @@ void ExposeCoreApiMetaTypes(QScriptEngine *engine)
     //Add support to create proxy widgets in javascript side.
     QScriptValue object = engine->scriptValueFromQMetaObject<UiProxyWidget>();
     engine->globalObject().setProperty("UiProxyWidget", object);
-    
+}
+
+void RegisterCoreApiMetaTypes()
+{
+    // Input metatypes.
+    qRegisterMetaType<KeyEvent::EventType>("KeyEvent::EventType");
+    qRegisterMetaType<MouseEvent::EventType>("MouseEvent::EventType");
+    qRegisterMetaType<MouseEvent::MouseButton>("MouseEvent::MouseButton");
+
+    // Scene metatypes.
+    qRegisterMetaType<EntityAction::ExecutionType>("EntityAction::ExecutionType");
+
     // Sound metatypes.
     qRegisterMetaType<sound_id_t>("sound_id_t");
     qRegisterMetaType<ISoundService::SoundState>("SoundState");
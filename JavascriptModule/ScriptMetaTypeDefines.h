@@ -54,4 +54,7 @@ void ExposeQtMetaTypes(QScriptEngine *engine);
 //! Will register all meta data types that are needed to use Naali Core API objects.
 void ExposeCoreApiMetaTypes(QScriptEngine *engine);
 
+//! Registers the Naali Core API types to the Qt meta type system. Needs to be called only once, not per engine.
+void RegisterCoreApiMetaTypes();
+
 #endif
@@ -18,6 +18,7 @@
 #include "Channel.h"
 #include "User.h"
 #include "PCMAudioFrame.h"
+#include "PCMAudioFramePool.h"
 #include <QUrl>
 #include <celt/celt_types.h>
 #include <celt/celt.h>
@@ -90,6 +91,10 @@ namespace MumbleLib
             state_(STATE_CONNECTING),
             send_position_(false),
             playback_buffer_length_ms_(playback_buffer_length_ms),
+            capture_frame_pool_(CAPTURE_FRAME_POOL_SIZE_, MumbleVoip::SAMPLE_RATE, MumbleVoip::SAMPLE_WIDTH, MumbleVoip::NUMBER_OF_CHANNELS, MumbleVoip::SAMPLES_IN_FRAME*MumbleVoip::SAMPLE_WIDTH/8),
+            playback_frame_pool_(PLAYBACK_FRAME_POOL_SIZE_, MumbleVoip::SAMPLE_RATE, MumbleVoip::SAMPLE_WIDTH, MumbleVoip::NUMBER_OF_CHANNELS, MumbleVoip::SAMPLES_IN_FRAME*MumbleVoip::SAMPLE_WIDTH/8),
+            encode_queue_(CAPTURE_FRAME_POOL_SIZE_),
+            spare_playback_frame_(0),
             statistics_(500)
     {
         // BlockingQueuedConnection for cross thread signaling
@@ -144,12 +149,7 @@ namespace MumbleLib
 
         UninitializeCELT();
 
-        QMutexLocker locker2(&mutex_encode_queue_);
-        while (encode_queue_.size() > 0)
-        {
-            MumbleVoip::PCMAudioFrame* frame = encode_queue_.takeFirst();
-            SAFE_DELETE(frame);
-        }
+        // Audio frames in encode queue are deleted with the frame pool
 
         QMutexLocker locker3(&mutex_channels_);
         while (channels_.size() > 0)
@@ -351,11 +351,8 @@ namespace MumbleLib
             int index = (first_index + i) % user_list.size();
             User* user = user_list[index];
 
-            if (!user->tryLock())
-                continue;
-
+            // Playback buffer of the user is lock-free, no need to lock the user
             MumbleVoip::PCMAudioFrame* frame = user->GetAudioFrame();
-            user->unlock();
             if (frame)
             {
                 first_index = i; // we want start next round from one user after this one
@@ -367,6 +364,21 @@ namespace MumbleLib
         return AudioPacket(0,0);
     }
 
+    void Connection::ReleaseAudioFrame(MumbleVoip::PCMAudioFrame* frame)
+    {
+        playback_frame_pool_.Release(frame);
+    }
+
+    MumbleVoip::JitterStatistics Connection::GetJitterStatistics(int session) const
+    {
+        return statistics_.GetJitterStatistics(session);
+    }
+
+    int Connection::GetDroppedAudioFrameCount() const
+    {
+        return statistics_.GetDroppedAudioFrameCount();
+    }
+
     void Connection::SendAudio(bool send)
     {
         sending_audio_ = send;
@@ -384,8 +396,6 @@ namespace MumbleLib
 
     void Connection::SendAudioFrame(MumbleVoip::PCMAudioFrame* frame, Vector3df users_position)
     {
-        QMutexLocker locker(&mutex_encode_queue_);
-
         lock_state_.lockForRead();
         if (state_ != STATE_OPEN)
         {
@@ -394,24 +404,36 @@ namespace MumbleLib
         }
         lock_state_.unlock();
 
-        MumbleVoip::PCMAudioFrame* f = new MumbleVoip::PCMAudioFrame(frame);
-        encode_queue_.push_back(f);
+        MumbleVoip::PCMAudioFrame* f = capture_frame_pool_.Acquire();
+        if (!f)
+        {
+            statistics_.NotifyAudioFrameDropped();
+            return;
+        }
+        memcpy(f->DataPtr(), frame->DataPtr(), std::min(f->DataSize(), frame->DataSize()));
+        if (!encode_queue_.Push(f))
+        {
+            capture_frame_pool_.Release(f);
+            statistics_.NotifyAudioFrameDropped();
+            return;
+        }
         
-        if (encode_queue_.size() < MumbleVoip::FRAMES_PER_PACKET)
+        if (encode_queue_.Size() < MumbleVoip::FRAMES_PER_PACKET)
             return;
 
         QMutexLocker encoder_locker(&mutex_encoder_);
 
         for (int i = 0; i < MumbleVoip::FRAMES_PER_PACKET; ++i)
         {
-            MumbleVoip::PCMAudioFrame* audio_frame = encode_queue_.takeFirst();
+            MumbleVoip::PCMAudioFrame* audio_frame = 0;
+            encode_queue_.Pop(audio_frame);
 
             int32_t len = celt_encode(celt_encoder_, reinterpret_cast<short *>(audio_frame->DataPtr()), NULL, encode_buffer_, std::min(BitrateForDecoder() / (100 * 8), 127));
             memcpy(encoded_frame_data_[i], encode_buffer_, len);
             encoded_frame_length_[i] = len;
             assert(len < ENCODE_BUFFER_SIZE_);
 
-            delete audio_frame;
+            capture_frame_pool_.Release(audio_frame);
         }
         const int PACKET_DATA_SIZE_MAX = 1024;
 	    static char data[PACKET_DATA_SIZE_MAX];
@@ -568,6 +590,7 @@ namespace MumbleLib
         data_stream >> session;
         data_stream >> seq;
 
+        int frame_count = 0;
         bool last_frame = true;
         do
         {
@@ -579,8 +602,10 @@ namespace MumbleLib
 
             if (frame_size > 0)
 				HandleIncomingCELTFrame(session, (unsigned char*)frame_data, frame_size);
+            frame_count++;
 	    }
         while (!last_frame && data_stream.isValid());
+        statistics_.NotifyAudioPacketReceived(session, seq, frame_count);
         if (!data_stream.isValid())
         {
             MumbleVoip::MumbleVoipModule::LogWarning("Syntax error in RawUdpTunnel packet.");
@@ -625,7 +650,7 @@ namespace MumbleLib
             MumbleVoip::MumbleVoipModule::LogWarning(message.toStdString());
             return;
         }
-        User* user = new User(mumble_user, channel);
+        User* user = new User(mumble_user, channel, &playback_frame_pool_);
         user->SetPlaybackBufferMaxLengthMs(playback_buffer_length_ms_);
         user->moveToThread(this->thread()); //! @todo Do we need this?
         
@@ -661,6 +686,7 @@ namespace MumbleLib
         QString message = QString("User '%1' Left.").arg(user->Name());
         MumbleVoip::MumbleVoipModule::LogDebug(message.toStdString());
         user->SetLeft();
+        statistics_.RemoveJitterStatistics(mumble_user.session);
         lock_users_.unlock();
         emit UserLeftFromServer(user);
     }
@@ -714,23 +740,27 @@ namespace MumbleLib
             return;
         }
 
-        MumbleVoip::PCMAudioFrame* audio_frame = new MumbleVoip::PCMAudioFrame(MumbleVoip::SAMPLE_RATE, MumbleVoip::SAMPLE_WIDTH, MumbleVoip::NUMBER_OF_CHANNELS, MumbleVoip::SAMPLES_IN_FRAME*MumbleVoip::SAMPLE_WIDTH/8);
+        // A frame that could not be passed on is kept for the next decode, as only the playback thread releases frames
+        if (!spare_playback_frame_)
+            spare_playback_frame_ = playback_frame_pool_.Acquire();
+        if (!spare_playback_frame_)
+        {
+            statistics_.NotifyAudioFrameDropped();
+            return;
+        }
+
+        MumbleVoip::PCMAudioFrame* audio_frame = spare_playback_frame_;
         int ret = celt_decode(celt_decoder_, data, size, (short*)audio_frame->DataPtr());
 
         switch (ret)
         {
         case CELT_OK:
             {
-                if (user->tryLock(5)) // 5 ms
-                {
-                    user->AddToPlaybackBuffer(audio_frame);
-                    user->unlock();
-                    return;
-                }
+                if (user->AddToPlaybackBuffer(audio_frame))
+                    spare_playback_frame_ = 0;
                 else
-                {
-                    MumbleVoip::MumbleVoipModule::LogWarning("Audio packet dropped: user object locked");
-                }
+                    statistics_.NotifyAudioFrameDropped();
+                return;
             }
             break;
         case CELT_BAD_ARG:
@@ -749,7 +779,6 @@ namespace MumbleLib
             MumbleVoip::MumbleVoipModule::LogError("CELT decoding error: CELT_UNIMPLEMENTED");
             break;
         }
-        delete audio_frame;
     }
 
     void Connection::SetEncodingQuality(double quality)
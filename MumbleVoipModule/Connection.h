@@ -13,6 +13,8 @@
 #include "Core.h"
 #include "MumbleDefines.h"
 #include "StatisticsHandler.h"
+#include "PCMAudioFramePool.h"
+#include "SPSCRingBuffer.h"
 
 class QNetworkReply;
 class QNetworkAccessManager;
@@ -49,6 +51,10 @@ namespace MumbleLib
     //! This is basically a wrapper over Client class of mumbleclient library.
     //  Mumbleclient library has a main loop whitch calls callback functions in this class
     //! so thread safaty have to be dealed within this class.
+    //!
+    //! Audio frames are preallocated in frame pools and passed between the capture, encode,
+    //! decode and playback stages in single-producer/single-consumer ring buffers, so the
+    //! mumble main loop thread and the main thread do not lock each other on every frame.
     //! 
     //! Connections has Channel and User objects.
     class Connection : public QObject
@@ -84,13 +90,25 @@ namespace MumbleLib
 
         //! @return first <user,audio frame> pair from playback queue
         //!         return <0,0> if playback queue is empty
-        //! The caller must delete audio frame object after usage
+        //! The caller must give the audio frame object back with ReleaseAudioFrame after usage
+        //! @note Must be called always from the same thread
         virtual AudioPacket GetAudioPacket();
 
+        //! Give audio frame returned by GetAudioPacket back to the frame pool
+        //! @note Must be called from the same thread as GetAudioPacket
+        virtual void ReleaseAudioFrame(MumbleVoip::PCMAudioFrame* frame);
+
         //! Encode and send given frame to Mumble server
-        //! Frame object is NOT deleted by this method 
+        //! Frame object is NOT deleted by this method, data is copied to an internal frame
+        //! @note Must be called always from the same thread
         virtual void SendAudioFrame(MumbleVoip::PCMAudioFrame* frame, Vector3df users_position);
 
+        //! @return jitter statistics of audio received from a user
+        virtual MumbleVoip::JitterStatistics GetJitterStatistics(int session) const;
+
+        //! @return number of audio frames dropped because a frame pool or a buffer was full
+        virtual int GetDroppedAudioFrameCount() const;
+
         //! @return list of channels available
         //! @todo CONSIDER TO USE boost::weak_ptr HERE
         virtual QList<Channel*> ChannelList();
@@ -185,6 +203,8 @@ namespace MumbleLib
         static const int ENCODE_BUFFER_SIZE_ = 4000;
         static const int USER_STATE_CHECK_TIME_MS = 1000;
         static const int FRAME_BUFFER_SIZE = 256;
+        static const int CAPTURE_FRAME_POOL_SIZE_ = 4 * MumbleVoip::FRAMES_PER_PACKET;
+        static const int PLAYBACK_FRAME_POOL_SIZE_ = 1024; // 10 s of audio
 
         char encoded_frame_data_[MumbleVoip::FRAMES_PER_PACKET][FRAME_BUFFER_SIZE];
         int encoded_frame_length_[MumbleVoip::FRAMES_PER_PACKET];
@@ -198,7 +218,10 @@ namespace MumbleLib
         QString reason_;
         MumbleClient::MumbleClient* client_;
         QString join_request_; // queued request to join a channel @todo IMPLEMENT BETTER
-        QList<MumbleVoip::PCMAudioFrame*> encode_queue_;
+        MumbleVoip::PCMAudioFramePool capture_frame_pool_;  // acquired and released by SendAudioFrame caller
+        MumbleVoip::PCMAudioFramePool playback_frame_pool_; // acquired by mumble main loop, released by GetAudioPacket caller
+        MumbleVoip::SPSCRingBuffer<MumbleVoip::PCMAudioFrame*> encode_queue_;
+        MumbleVoip::PCMAudioFrame* spare_playback_frame_; // decode target kept by mumble main loop thread
         QList<Channel*> channels_; // @todo Use shared ptr
         QMap<int, User*> users_; // maps: session id <-> User object
 
@@ -219,11 +242,11 @@ namespace MumbleLib
         
         QMutex mutex_channels_;
         QMutex mutex_authentication_;
-        QMutex mutex_encode_queue_;
         QMutex mutex_encoding_quality_;
-        QMutex mutex_raw_udp_tunnel_;
-        QMutex mutex_client_;
-        QMutex mutex_encoder_;
+        // The rings only cover the frames. Sending the encoded packet to the network is still mutex based:
+        QMutex mutex_raw_udp_tunnel_; // keeps Close and the destructor from tearing down CELT while the mumble main loop decodes a packet
+        QMutex mutex_client_; // client_ is used from both the main thread (Join, Close, SendAudioFrame) and the mumble main loop
+        QMutex mutex_encoder_; // SetEncodingQuality and UninitializeCELT change the encoder SendAudioFrame is encoding with
         QReadWriteLock lock_state_;
         QReadWriteLock lock_users_;
         
@@ -0,0 +1,60 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+
+#include "StableHeaders.h"
+#include "DebugOperatorNew.h"
+
+#include "PCMAudioFramePool.h"
+#include "PCMAudioFrame.h"
+
+#include "MemoryLeakCheck.h"
+
+namespace MumbleVoip
+{
+    PCMAudioFramePool::PCMAudioFramePool(int frame_count, int sample_rate, int sample_width, int channels, int data_size) :
+        free_frames_(frame_count)
+    {
+        for (int i = 0; i < frame_count; ++i)
+        {
+            PCMAudioFrame* frame = new PCMAudioFrame(sample_rate, sample_width, channels, data_size);
+            frames_.append(frame);
+            free_frames_.Push(frame);
+        }
+    }
+
+    PCMAudioFramePool::~PCMAudioFramePool()
+    {
+        foreach(PCMAudioFrame* frame, frames_)
+            SAFE_DELETE(frame);
+        frames_.clear();
+    }
+
+    PCMAudioFrame* PCMAudioFramePool::Acquire()
+    {
+        PCMAudioFrame* frame = 0;
+        if (!free_frames_.Pop(frame))
+            return 0;
+        return frame;
+    }
+
+    void PCMAudioFramePool::Release(PCMAudioFrame* frame)
+    {
+        if (!frame)
+            return;
+
+        // Cannot fail: there is a slot for every frame of the pool
+        bool ok = free_frames_.Push(frame);
+        assert(ok);
+        UNREFERENCED_PARAM(ok);
+    }
+
+    int PCMAudioFramePool::FrameCount() const
+    {
+        return frames_.size();
+    }
+
+    int PCMAudioFramePool::FreeFrameCount() const
+    {
+        return free_frames_.Size();
+    }
+
+} // namespace MumbleVoip
@@ -0,0 +1,49 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+
+#ifndef incl_MumbleVoipModule_PCMAudioFramePool_h
+#define incl_MumbleVoipModule_PCMAudioFramePool_h
+
+#include "SPSCRingBuffer.h"
+#include <QList>
+
+namespace MumbleVoip
+{
+    class PCMAudioFrame;
+
+    /**
+     * Fixed set of preallocated audio frames of equal size.
+     *
+     * Frames are taken with Acquire() and given back with Release(). All Acquire() calls must be made
+     * by one thread and all Release() calls by one thread, which can be the same or a different one.
+     * All frames are deleted with the pool, so no frame may be in use when the pool is deleted.
+     */
+    class PCMAudioFramePool
+    {
+    public:
+        //! Allocates all frames
+        PCMAudioFramePool(int frame_count, int sample_rate, int sample_width, int channels, int data_size);
+
+        //! Deletes all frames
+        virtual ~PCMAudioFramePool();
+
+        //! @return free frame, or 0 if all frames are in use
+        //! The data of the frame is not cleared.
+        virtual PCMAudioFrame* Acquire();
+
+        //! Gives frame back to the pool
+        virtual void Release(PCMAudioFrame* frame);
+
+        //! @return total number of frames
+        virtual int FrameCount() const;
+
+        //! @return number of free frames
+        virtual int FreeFrameCount() const;
+
+    private:
+        QList<PCMAudioFrame*> frames_;
+        SPSCRingBuffer<PCMAudioFrame*> free_frames_;
+    };
+
+} // namespace MumbleVoip
+
+#endif // incl_MumbleVoipModule_PCMAudioFramePool_h
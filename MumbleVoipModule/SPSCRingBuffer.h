@@ -0,0 +1,88 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+
+#ifndef incl_MumbleVoipModule_SPSCRingBuffer_h
+#define incl_MumbleVoipModule_SPSCRingBuffer_h
+
+#include <QAtomicInt>
+#include <vector>
+
+namespace MumbleVoip
+{
+    //! Fixed size lock-free queue between exactly one producer thread and one consumer thread.
+    //!
+    //! Push() may only be called by the producer and Pop() only by the consumer. The producer
+    //! and the consumer can be the same thread. Size() and IsEmpty() may be called from either
+    //! thread but the result is only a snapshot.
+    template <typename T>
+    class SPSCRingBuffer
+    {
+    public:
+        //! @param capacity Maximum number of items in the buffer
+        explicit SPSCRingBuffer(int capacity) :
+            slots_(capacity + 1),
+            items_(capacity + 1),
+            read_index_(0),
+            write_index_(0)
+        {
+        }
+
+        //! Add item to the end of the buffer
+        //! @return false if the buffer is full
+        bool Push(const T& item)
+        {
+            int write_index = write_index_;
+            int next = (write_index + 1) % slots_;
+            if (next == read_index_.fetchAndAddAcquire(0))
+                return false;
+
+            items_[write_index] = item;
+            // Publish the item only after it has been written
+            write_index_.fetchAndStoreRelease(next);
+            return true;
+        }
+
+        //! Take the first item from the buffer
+        //! @return false if the buffer is empty
+        bool Pop(T& item)
+        {
+            int read_index = read_index_;
+            if (read_index == write_index_.fetchAndAddAcquire(0))
+                return false;
+
+            item = items_[read_index];
+            // Release the slot only after the item has been read
+            read_index_.fetchAndStoreRelease((read_index + 1) % slots_);
+            return true;
+        }
+
+        //! @return number of items in the buffer
+        int Size() const
+        {
+            int write_index = write_index_;
+            int read_index = read_index_;
+            return (write_index - read_index + slots_) % slots_;
+        }
+
+        //! @return true if the buffer is empty
+        bool IsEmpty() const { return Size() == 0; }
+
+        //! @return maximum number of items in the buffer
+        int Capacity() const { return slots_ - 1; }
+
+    private:
+        //! Not copyable
+        SPSCRingBuffer(const SPSCRingBuffer&);
+        SPSCRingBuffer& operator=(const SPSCRingBuffer&);
+
+        //! One slot is always left empty to tell a full buffer from an empty one
+        const int slots_;
+        std::vector<T> items_;
+        //! Written only by the consumer
+        QAtomicInt read_index_;
+        //! Written only by the producer
+        QAtomicInt write_index_;
+    };
+
+} // namespace MumbleVoip
+
+#endif // incl_MumbleVoipModule_SPSCRingBuffer_h
@@ -39,7 +39,8 @@ namespace MumbleVoip
         connection_(0),
         settings_(settings),
         local_echo_mode_(false),
-        server_address_("")
+        server_address_(""),
+        recording_frame_(new PCMAudioFrame(SAMPLE_RATE, SAMPLE_WIDTH, NUMBER_OF_CHANNELS, SAMPLES_IN_FRAME*SAMPLE_WIDTH/8))
     {
         connect(settings_, SIGNAL(PlaybackBufferSizeMsChanged(int)), this, SLOT(SetPlaybackBufferSizeMs(int)));
         connect(settings_, SIGNAL(EncodeQualityChanged(double)), this, SLOT(SetEncodeQuality(double)));
@@ -48,6 +49,7 @@ namespace MumbleVoip
     Session::~Session()
     {
         Close();
+        SAFE_DELETE(recording_frame_);
     }
 
     void Session::OpenConnection(ServerInfo server_info)
@@ -454,7 +456,7 @@ namespace MumbleVoip
         while (sound_service->GetRecordedSoundSize() > SAMPLES_IN_FRAME*SAMPLE_WIDTH/8)
         {
             int bytes_to_read = SAMPLES_IN_FRAME*SAMPLE_WIDTH/8;
-            PCMAudioFrame* frame = new PCMAudioFrame(SAMPLE_RATE, SAMPLE_WIDTH, NUMBER_OF_CHANNELS, bytes_to_read );
+            PCMAudioFrame* frame = recording_frame_;
             int bytes = sound_service->GetRecordedSoundData(frame->DataPtr(), bytes_to_read);
             UNREFERENCED_PARAM(bytes);
             ApplyMicrophoneLevel(frame);
@@ -472,8 +474,6 @@ namespace MumbleVoip
             //}
             if (audio_sending_enabled_)
                 connection_->SendAudioFrame(frame, avatar_position);
-            else
-                delete frame;
         }
     }
 
@@ -502,8 +502,7 @@ namespace MumbleVoip
             }
             if (!source_muted)
                 PlaybackAudioFrame(packet.first, packet.second);
-            else
-                delete packet.second;
+            connection_->ReleaseAudioFrame(packet.second);
         }
     }
 
@@ -511,7 +510,7 @@ namespace MumbleVoip
     {
         boost::shared_ptr<ISoundService> sound_service = SoundService();
         if (!sound_service.get())
-            return;    
+            return;
 
         ISoundService::SoundBuffer sound_buffer;
         
@@ -551,8 +550,6 @@ namespace MumbleVoip
                 else
                     audio_playback_channels_[user->Session()] = sound_service->PlaySoundBuffer(sound_buffer,  ISoundService::Voice, 0);
         }
-
-        delete frame;
     }
 
     boost::shared_ptr<ISoundService> Session::SoundService()
@@ -587,7 +584,15 @@ namespace MumbleVoip
             int drop = static_cast<int>( 100*user->VoicePacketDropRatio() );
             QString line = QString("    participant %1:   audio buffer=%2 ms   frame loss=%3 %").arg(p->Name()).arg(buffer_len).arg(drop);
             lines.append(line);
+            if (connection_)
+            {
+                JitterStatistics jitter = connection_->GetJitterStatistics(user->Session());
+                line = QString("      jitter=%1 ms   lost frames=%2   late packets=%3").arg(jitter.jitter_ms, 0, 'f', 1).arg(jitter.lost_frames).arg(jitter.late_packets);
+                lines.append(line);
+            }
         }
+        if (connection_)
+            lines.append(QString("  Dropped audio frames: %1").arg(connection_->GetDroppedAudioFrameCount()));
         return lines;
     }
 
@@ -102,6 +102,7 @@ namespace MumbleVoip
         QString current_mumble_channel_;
         QMap<int, sound_id_t> audio_playback_channels_;
         std::string recording_device_;
+        PCMAudioFrame* recording_frame_; // reused for every recorded frame, the connection copies the data
         Settings* settings_;
         bool local_echo_mode_; // if true then acudio is only played locally
         QString server_address_;
@@ -4,16 +4,53 @@
 #include "DebugOperatorNew.h"
 
 #include "StatisticsHandler.h"
+#include "MumbleDefines.h"
 
 #include "MemoryLeakCheck.h"
 
 namespace MumbleVoip
 {
+    JitterStatistics::JitterStatistics() :
+        packets(0),
+        frames(0),
+        lost_frames(0),
+        late_packets(0),
+        jitter_ms(0),
+        next_sequence_(0),
+        last_transit_ms_(0)
+    {
+    }
+
+    void JitterStatistics::Update(int sequence, int frame_count, int arrival_time_ms)
+    {
+        const int frame_length_ms = 1000 * SAMPLES_IN_FRAME / SAMPLE_RATE;
+        int transit_ms = arrival_time_ms - sequence * frame_length_ms;
+
+        if (packets > 0)
+        {
+            if (sequence > next_sequence_)
+                lost_frames += sequence - next_sequence_;
+            else if (sequence < next_sequence_)
+                late_packets++;
+
+            int transit_change_ms = abs(transit_ms - last_transit_ms_);
+            jitter_ms += (transit_change_ms - jitter_ms) / 16;
+        }
+        if (packets == 0 || sequence >= next_sequence_)
+            next_sequence_ = sequence + frame_count;
+        last_transit_ms_ = transit_ms;
+
+        packets++;
+        frames += frame_count;
+    }
+
     StatisticsHandler::StatisticsHandler(int time_frame_ms) : 
         time_frame_ms_(time_frame_ms),
         bytes_in_(0),
-        bytes_out_(0)
+        bytes_out_(0),
+        dropped_audio_frames_(0)
     {
+        clock_.start();
         connect(&timer_, SIGNAL(timeout()), this, SLOT(UpdateStatistics()));
         if (time_frame_ms_ != 0)
         {
@@ -37,6 +74,35 @@ namespace MumbleVoip
         bytes_in_ += bytes;
     }
 
+    void StatisticsHandler::NotifyAudioPacketReceived(int session, int sequence, int frame_count)
+    {
+        int arrival_time_ms = clock_.elapsed();
+        QMutexLocker locker(&mutex_jitter_statistics_);
+        jitter_statistics_[session].Update(sequence, frame_count, arrival_time_ms);
+    }
+
+    void StatisticsHandler::NotifyAudioFrameDropped()
+    {
+        dropped_audio_frames_.ref();
+    }
+
+    JitterStatistics StatisticsHandler::GetJitterStatistics(int session) const
+    {
+        QMutexLocker locker(&mutex_jitter_statistics_);
+        return jitter_statistics_.value(session);
+    }
+
+    void StatisticsHandler::RemoveJitterStatistics(int session)
+    {
+        QMutexLocker locker(&mutex_jitter_statistics_);
+        jitter_statistics_.remove(session);
+    }
+
+    int StatisticsHandler::GetDroppedAudioFrameCount() const
+    {
+        return dropped_audio_frames_;
+    }
+
     int StatisticsHandler::GetAverageBandwidthIn() const
     {
         return average_bandwidth_in_;
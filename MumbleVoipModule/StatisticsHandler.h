@@ -6,9 +6,40 @@
 #include "ui_VoiceSettings.h"
 #include <QObject>
 #include <QTimer>
+#include <QTime>
+#include <QMap>
+#include <QMutex>
+#include <QAtomicInt>
 
 namespace MumbleVoip
 {
+    /// Jitter and loss statistics of the audio packets received from one user
+    struct JitterStatistics
+    {
+        JitterStatistics();
+
+        /// Updates statistics with a received packet
+        /// @param sequence Sequence number of the first frame in the packet
+        /// @param frame_count Number of frames in the packet
+        /// @param arrival_time_ms Arrival time of the packet
+        void Update(int sequence, int frame_count, int arrival_time_ms);
+
+        /// Number of packets received
+        int packets;
+        /// Number of frames received
+        int frames;
+        /// Number of frames missing from the sequence
+        int lost_frames;
+        /// Number of packets that arrived after a later packet
+        int late_packets;
+        /// Smoothed interarrival jitter as defined in RFC 3550
+        double jitter_ms;
+
+    private:
+        int next_sequence_;
+        int last_transit_ms_;
+    };
+
     /// Mumble server connection statistics handler
     class StatisticsHandler : public QObject
     {
@@ -19,6 +50,25 @@ namespace MumbleVoip
             
         void NotifyBytesSent(int bytes);
         void NotifyBytesReceived(int bytes);
+
+        /// Updates jitter statistics of a user. Thread safe.
+        /// @param session Session id of the sender
+        /// @param sequence Sequence number of the first frame in the packet
+        /// @param frame_count Number of frames in the packet
+        void NotifyAudioPacketReceived(int session, int sequence, int frame_count);
+
+        /// Counts audio frame that could not be played or sent. Thread safe.
+        void NotifyAudioFrameDropped();
+
+        /// @return jitter statistics of a user
+        JitterStatistics GetJitterStatistics(int session) const;
+
+        /// Removes jitter statistics of a user
+        void RemoveJitterStatistics(int session);
+
+        /// @return number of audio frames dropped
+        int GetDroppedAudioFrameCount() const;
+
         int GetAverageBandwidthIn() const;
         int GetAverageBandwidthOut() const;
         void SetTimeFrameMs(int time_frame_ms);
@@ -34,6 +84,10 @@ namespace MumbleVoip
         int average_bandwidth_out_;
         int bytes_in_;
         int bytes_out_;
+        QTime clock_;
+        QMap<int, JitterStatistics> jitter_statistics_;
+        mutable QMutex mutex_jitter_statistics_;
+        QAtomicInt dropped_audio_frames_;
     };
 
 } // MumbleVoip
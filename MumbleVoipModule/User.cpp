@@ -5,6 +5,7 @@
 
 #include "User.h"
 #include "PCMAudioFrame.h"
+#include "PCMAudioFramePool.h"
 #include "MumbleVoipModule.h"
 #include "stdint.h"
 #include "MumbleDefines.h"
@@ -18,26 +19,28 @@
 
 namespace MumbleLib
 {
-    User::User(const MumbleClient::User& user, MumbleLib::Channel* channel)
+    User::User(const MumbleClient::User& user, MumbleLib::Channel* channel, MumbleVoip::PCMAudioFramePool* frame_pool)
         : user_(user),
-          speaking_(false),
+          speaking_(0),
           position_known_(false),
           position_(0,0,0),
+          playback_queue_(PLAYBACK_BUFFER_CAPACITY_),
+          frame_pool_(frame_pool),
           left_(false),
           channel_(channel),
           received_voice_packet_count_(0),
           voice_packet_drop_count_(0),
+          last_audio_frame_time_ms_(0),
           playback_buffer_max_length_ms(DEFAUL_PLAYBACK_BUFFER_MAX_LENGTH_MS_)
     {
-        last_audio_frame_time_.start(); // initialize time state so that restart is possible later
+        clock_.start();
     }
 
     User::~User()
     {
-        foreach(MumbleVoip::PCMAudioFrame* audio, playback_queue_)
-            SAFE_DELETE(audio);
-
-        playback_queue_.clear();
+        MumbleVoip::PCMAudioFrame* frame = 0;
+        while (playback_queue_.Pop(frame))
+            frame_pool_->Release(frame);
     }
 
     QString User::Name() const
@@ -82,27 +85,22 @@ namespace MumbleLib
 
     bool User::IsSpeaking() const
     {
-        return speaking_;
+        return speaking_ != 0;
     }
 
-    void User::AddToPlaybackBuffer(MumbleVoip::PCMAudioFrame* frame)
+    bool User::AddToPlaybackBuffer(MumbleVoip::PCMAudioFrame* frame)
     {
-        received_voice_packet_count_++;
-        // Buffer overflow handling: We drop the oldest packet in the buffer
-        if (PlaybackBufferLengthMs() > playback_buffer_max_length_ms )
+        received_voice_packet_count_.ref();
+        if (!playback_queue_.Push(frame))
         {
-            MumbleVoip::PCMAudioFrame* frame = GetAudioFrame();
-            SAFE_DELETE(frame);
+            voice_packet_drop_count_.ref();
+            return false;
         }
 
-        playback_queue_.push_back(frame);
-        last_audio_frame_time_.restart();
-
-        if (!speaking_)
-        {
-            speaking_ = true;
+        last_audio_frame_time_ms_.fetchAndStoreRelease(clock_.elapsed());
+        if (speaking_.testAndSetOrdered(0, 1))
             emit StartReceivingAudio();
-        }
+        return true;
     }
 
     void User::UpdatePosition(Vector3df position)
@@ -120,32 +118,39 @@ namespace MumbleLib
 
     int User::PlaybackBufferLengthMs() const
     {
-        return 1000 * playback_queue_.size() * MumbleVoip::SAMPLES_IN_FRAME / MumbleVoip::SAMPLE_RATE;
+        return 1000 * playback_queue_.Size() * MumbleVoip::SAMPLES_IN_FRAME / MumbleVoip::SAMPLE_RATE;
     }
     
     MumbleVoip::PCMAudioFrame* User::GetAudioFrame()
     {
-        if (playback_queue_.size() == 0)
-            return 0;
+        MumbleVoip::PCMAudioFrame* frame = 0;
 
-        return playback_queue_.takeFirst();
+        // Buffer overflow handling: We drop the oldest frames in the buffer
+        while (PlaybackBufferLengthMs() > playback_buffer_max_length_ms && playback_queue_.Pop(frame))
+        {
+            frame_pool_->Release(frame);
+            voice_packet_drop_count_.ref();
+        }
+
+        if (!playback_queue_.Pop(frame))
+            return 0;
+        return frame;
     }
 
     double User::VoicePacketDropRatio() const
     {
-        if (received_voice_packet_count_ == 0)
+        int received = received_voice_packet_count_;
+        if (received == 0)
             return 0;
-        return static_cast<double>(voice_packet_drop_count_)/received_voice_packet_count_;
+        return static_cast<double>(voice_packet_drop_count_)/received;
     }
 
     void User::CheckSpeakingState()
     {
-        bool was_speaking = speaking_;
-
-        if (speaking_ && last_audio_frame_time_.elapsed() > SPEAKING_TIMEOUT_MS)
+        int last_audio_frame_time_ms = last_audio_frame_time_ms_.fetchAndAddAcquire(0);
+        if (clock_.elapsed() - last_audio_frame_time_ms > SPEAKING_TIMEOUT_MS)
         {
-            speaking_ = false;
-            if (was_speaking && !speaking_)
+            if (speaking_.testAndSetOrdered(1, 0))
                 emit StopReceivingAudio();
         }
     }
@@ -10,6 +10,8 @@
 #include <Core.h>
 #include <QTimer>
 #include <QTime>
+#include <QAtomicInt>
+#include "SPSCRingBuffer.h"
 
 namespace MumbleClient
 {
@@ -19,6 +21,7 @@ namespace MumbleClient
 namespace MumbleVoip
 {
     class PCMAudioFrame;
+    class PCMAudioFramePool;
 }
 
 namespace MumbleLib
@@ -27,6 +30,9 @@ namespace MumbleLib
 
     //! Wrapper over libmumbleclient library's User class
     //! Present mumble client intance on MurMur server
+    //!
+    //! The playback buffer is a lock-free queue: audio frames are added by the mumble main loop thread
+    //! and taken by the main thread without locking the user object.
     class User : public QObject, public QMutex
     {
         Q_OBJECT
@@ -34,7 +40,8 @@ namespace MumbleLib
         //! Default constructor
         //! @param user
         //! @param channel The channel where the user are located
-        User(const MumbleClient::User& user, Channel* channel);
+        //! @param frame_pool The pool where the audio frames of the playback buffer are released to
+        User(const MumbleClient::User& user, Channel* channel, MumbleVoip::PCMAudioFramePool* frame_pool);
 
         //! Destructor
         virtual ~User();
@@ -67,7 +74,8 @@ namespace MumbleLib
         virtual int PlaybackBufferLengthMs() const ;
 
         //! @return oldest audio frame available for playback 
-        //! @note caller must delete audio frame object after usage
+        //! @note caller must release audio frame object to the frame pool after usage
+        //! @note Must be called always from the same thread
         virtual MumbleVoip::PCMAudioFrame* GetAudioFrame();
 
         //! Set user status to be left
@@ -84,9 +92,12 @@ namespace MumbleLib
 
     public slots:
         //! Put audio frame to end of playback buffer 
-        //! If playback buffer is full it is cleared first.
+        //! If playback buffer has grown over its max length, the oldest frames are dropped when the next frame
+        //! is taken for playback.
         //! @param farme Audio data frame received from network and ment to be for playback locally
-        void AddToPlaybackBuffer(MumbleVoip::PCMAudioFrame* frame);
+        //! @return false if the playback buffer is full. The caller keeps the ownership of the frame then.
+        //! @note Must be called always from the same thread
+        bool AddToPlaybackBuffer(MumbleVoip::PCMAudioFrame* frame);
 
         //! Updatedes user last known position
         //! Also set position_known_ flag up
@@ -102,18 +113,21 @@ namespace MumbleLib
     private:
         static const int SPEAKING_TIMEOUT_MS = 100; // time to emit StopSpeaking after las audio packet is received
         static const int DEFAUL_PLAYBACK_BUFFER_MAX_LENGTH_MS_= 200;
+        static const int PLAYBACK_BUFFER_CAPACITY_ = 128; // frames, more than the max length that can be set
 
         const MumbleClient::User& user_;
-        bool speaking_;
+        QAtomicInt speaking_;
         Vector3df position_;
         bool position_known_;
 
-        QList<MumbleVoip::PCMAudioFrame*> playback_queue_;
+        MumbleVoip::SPSCRingBuffer<MumbleVoip::PCMAudioFrame*> playback_queue_;
+        MumbleVoip::PCMAudioFramePool* frame_pool_;
         bool left_;
         MumbleLib::Channel* channel_;
-        int received_voice_packet_count_;
-        int voice_packet_drop_count_;
-        QTime last_audio_frame_time_;
+        QAtomicInt received_voice_packet_count_;
+        QAtomicInt voice_packet_drop_count_;
+        QTime clock_; // started once, never restarted so that it can be read from both threads
+        QAtomicInt last_audio_frame_time_ms_;
         int playback_buffer_max_length_ms;
     signals:
         //! Emited when user has left from server
@@ -8,6 +8,8 @@
 #include "EventManager.h"
 #include "EC_Placeable.h"
 #include "EC_Mesh.h"
+#include "StaticBatcher.h"
+#include "SceneManager.h"
 #include "RexTypes.h"
 #include "OgreMeshResource.h"
 #include "OgreMaterialResource.h"
@@ -65,6 +67,7 @@ EC_Mesh::~EC_Mesh()
         return;
     RendererPtr renderer = renderer_.lock();
         
+    CancelResourceRequests(std::string());
     RemoveMesh();
     
     if (adjustment_node_)
@@ -561,6 +564,7 @@ bool EC_Mesh::SetMaterial(uint index, const std::string& material_name)
         return false;
     }
     
+    NotifyStaticBatcher();
     return true;
 }
 
@@ -719,6 +723,10 @@ void EC_Mesh::DetachEntity()
 {
     if ((!attached_) || (!entity_) || (!placeable_))
         return;
+
+    RendererPtr renderer = renderer_.lock();
+    if (renderer && renderer->GetStaticBatcher())
+        renderer->GetStaticBatcher()->RemoveEntity(entity_);
         
     EC_Placeable* placeable = checked_static_cast<EC_Placeable*>(placeable_.get());
     Ogre::SceneNode* node = placeable->GetSceneNode();
@@ -728,6 +736,16 @@ void EC_Mesh::DetachEntity()
     attached_ = false;
 }
 
+void EC_Mesh::NotifyStaticBatcher()
+{
+    if (!attached_ || !entity_)
+        return;
+
+    RendererPtr renderer = renderer_.lock();
+    if (renderer && renderer->GetStaticBatcher())
+        renderer->GetStaticBatcher()->EntityChanged(entity_);
+}
+
 void EC_Mesh::AttachEntity()
 {
     if ((attached_) || (!entity_) || (!placeable_))
@@ -739,6 +757,10 @@ void EC_Mesh::AttachEntity()
     adjustment_node_->attachObject(entity_);
             
     attached_ = true;
+
+    RendererPtr renderer = renderer_.lock();
+    if (renderer && renderer->GetStaticBatcher())
+        renderer->GetStaticBatcher()->AddEntity(entity_);
 }
 
 Ogre::Mesh* EC_Mesh::PrepareMesh(const std::string& mesh_name, bool clone)
@@ -802,14 +824,38 @@ Ogre::Mesh* EC_Mesh::PrepareMesh(const std::string& mesh_name, bool clone)
     
 void EC_Mesh::UpdateSignals()
 {
+    UpdateAssetReferences();
+}
+
+void EC_Mesh::UpdateAssetReferences()
+{
+    Scene::Entity *entity = GetParentEntity();
+    Scene::SceneManager *scene = entity ? entity->GetScene() : 0;
+    if (!scene)
+        return;
+
+    Scene::AssetReferenceIndex &index = scene->GetAssetReferenceIndex();
+    const entity_id_t id = entity->GetId();
+    index.ClearReferences(id, this);
+    index.AddReference(meshResourceId.Get().toStdString(), id, this, Scene::AssetReferenceIndex::ALL_SLOTS, RexTypes::RexAT_Mesh);
+    index.AddReference(skeletonId.Get().toStdString(), id, this, Scene::AssetReferenceIndex::ALL_SLOTS, RexTypes::RexAT_Skeleton);
+    QVariantList materials = meshMaterial.Get();
+    for(uint i = 0; i < materials.size(); ++i)
+        index.AddReference(materials[i].toString().toStdString(), id, this, i, RexTypes::RexAT_MaterialScript);
 }
 
 void EC_Mesh::AttributeUpdated(IAttribute *attribute)
 {
+    if (attribute == &meshResourceId || attribute == &skeletonId || attribute == &meshMaterial)
+        UpdateAssetReferences();
+
     if (attribute == &drawDistance)
     {
         if(entity_)
+        {
             entity_->setRenderingDistance(drawDistance.Get());
+            NotifyStaticBatcher();
+        }
     }
     else if (attribute == &castShadows)
     {
@@ -817,6 +863,7 @@ void EC_Mesh::AttributeUpdated(IAttribute *attribute)
         {
             if (entity_)
                 entity_->setCastShadows(castShadows.Get());
+            NotifyStaticBatcher();
             //! \todo might want to disable shadows for some attachments
             for (uint i = 0; i < attachment_entities_.size(); ++i)
             {
@@ -854,6 +901,9 @@ void EC_Mesh::AttributeUpdated(IAttribute *attribute)
     request_tag_t tag = 0;
     if (attribute == &meshResourceId)
     {
+        // A mesh still loading would replace the new one
+        CancelResourceRequests(OgreRenderer::OgreMeshResource::GetTypeStatic());
+
         //Ensure that mesh is requested only when it's has actualy changed.
         if(entity_)
             if(QString::fromStdString(entity_->getMesh()->getName()) == meshResourceId.Get())
@@ -871,6 +921,7 @@ void EC_Mesh::AttributeUpdated(IAttribute *attribute)
         // We wont request materials until we are sure that mesh has been loaded and it's safe to apply materials into it.
         if(!HasMaterialsChanged())
             return;
+        CancelResourceRequests(OgreRenderer::OgreMaterialResource::GetTypeStatic());
         QVariantList materials = meshMaterial.Get();
         materialRequestTags_.resize(materials.size(), 0);
         for(uint i = 0; i < materials.size(); i++)
@@ -887,6 +938,7 @@ void EC_Mesh::AttributeUpdated(IAttribute *attribute)
     }
     else if(attribute == &skeletonId)
     {
+        CancelResourceRequests(OgreRenderer::OgreSkeletonResource::GetTypeStatic());
         if(!skeletonId.Get().isEmpty())
         {
             // If same name skeleton already set no point to do it again.
@@ -926,9 +978,31 @@ request_tag_t EC_Mesh::RequestResource(const std::string& id, const std::string&
         return 0;
     }
 
+    resRequestIds_[ResourceKeyPair(tag, type)] = id;
     return tag;
 }
 
+void EC_Mesh::CancelResourceRequests(const std::string& type)
+{
+    if(renderer_.expired())
+        return;
+    RendererPtr renderer = renderer_.lock();
+
+    // The renderer keeps a download going if it is requested again in the same frame
+    ResourceIdMap::iterator iter = resRequestIds_.begin();
+    while(iter != resRequestIds_.end())
+    {
+        if(type.empty() || iter->first.second == type)
+        {
+            renderer->CancelResourceRequest(iter->second, iter->first.second, iter->first.first);
+            resRequestTags_.erase(iter->first);
+            resRequestIds_.erase(iter++);
+        }
+        else
+            ++iter;
+    }
+}
+
 bool EC_Mesh::HandleResourceEvent(event_id_t event_id, IEventData* data)
 {
     if (event_id != Resource::Events::RESOURCE_READY)
@@ -940,8 +1014,11 @@ bool EC_Mesh::HandleResourceEvent(event_id_t event_id, IEventData* data)
     MeshResourceHandlerMap::iterator iter2 = resRequestTags_.find(event_key);
     if(iter2 != resRequestTags_.end())
     {
-        iter2->second(event_id, data);
+        // The handler can cancel the other requests of its type, so erase the request first
+        MeshEventHandlerFunction handler = iter2->second;
         resRequestTags_.erase(iter2);
+        resRequestIds_.erase(event_key);
+        handler(event_id, data);
         return true;
     }
     return false;
@@ -382,12 +382,20 @@ private:
     //! detaches entity from placeable
     void DetachEntity();
     
+    //! tells the static batcher that the materials, shadow casting or draw distance of the attached entity have changed
+    void NotifyStaticBatcher();
+    
     bool HandleResourceEvent(event_id_t event_id, IEventData* data);
     bool HandleMeshResourceEvent(event_id_t event_id, IEventData* data);
     bool HandleSkeletonResourceEvent(event_id_t event_id, IEventData* data);
     bool HandleMaterialResourceEvent(event_id_t event_id, IEventData* data);
     request_tag_t RequestResource(const std::string& id, const std::string& type);
+    //! cancels the pending resource requests of a type, or all of them if type is empty
+    void CancelResourceRequests(const std::string& type);
     bool HasMaterialsChanged() const;
+
+    //! Registers the mesh, skeleton and material refs to the asset reference index of the scene.
+    void UpdateAssetReferences();
     
     //! placeable component 
     ComponentPtr placeable_;
@@ -421,6 +429,9 @@ private:
     typedef boost::function<bool(event_id_t,IEventData*)> MeshEventHandlerFunction;
     typedef std::map<ResourceKeyPair, MeshEventHandlerFunction> MeshResourceHandlerMap;
     MeshResourceHandlerMap resRequestTags_;
+    typedef std::map<ResourceKeyPair, std::string> ResourceIdMap;
+    //! resource ids of the pending requests, for canceling them
+    ResourceIdMap resRequestIds_;
 };
 
 #endif
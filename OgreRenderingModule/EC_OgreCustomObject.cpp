@@ -6,6 +6,7 @@
 #include "Entity.h"
 #include "EC_Placeable.h"
 #include "EC_OgreCustomObject.h"
+#include "StaticBatcher.h"
 
 #include <Ogre.h>
 
@@ -106,14 +107,20 @@ void EC_OgreCustomObject::SetDrawDistance(float draw_distance)
 {
     draw_distance_ = draw_distance;
     if (entity_)
+    {
         entity_->setRenderingDistance(draw_distance);
+        NotifyStaticBatcher();
+    }
 }
 
 void EC_OgreCustomObject::SetCastShadows(bool enabled)
 {
     cast_shadows_ = enabled;
     if (entity_)
+    {
         entity_->setCastShadows(enabled);
+        NotifyStaticBatcher();
+    }
 }
 
 bool EC_OgreCustomObject::SetMaterial(uint index, const std::string& material_name)
@@ -137,6 +144,7 @@ bool EC_OgreCustomObject::SetMaterial(uint index, const std::string& material_na
         return false;
     }
     
+    NotifyStaticBatcher();
     return true;
 }
 
@@ -169,6 +177,10 @@ void EC_OgreCustomObject::AttachEntity()
         Ogre::SceneNode* node = placeable->GetSceneNode();
         node->attachObject(entity_);
         attached_ = true;
+
+        RendererPtr renderer = renderer_.lock();
+        if (renderer && renderer->GetStaticBatcher())
+            renderer->GetStaticBatcher()->AddEntity(entity_);
     }
 }
 
@@ -176,6 +188,10 @@ void EC_OgreCustomObject::DetachEntity()
 {
     if ((placeable_) && (attached_) && (entity_))
     {
+        RendererPtr renderer = renderer_.lock();
+        if (renderer && renderer->GetStaticBatcher())
+            renderer->GetStaticBatcher()->RemoveEntity(entity_);
+
         EC_Placeable* placeable = checked_static_cast<EC_Placeable*>(placeable_.get());
         Ogre::SceneNode* node = placeable->GetSceneNode();
         node->detachObject(entity_);
@@ -183,6 +199,16 @@ void EC_OgreCustomObject::DetachEntity()
     }
 }
 
+void EC_OgreCustomObject::NotifyStaticBatcher()
+{
+    if (!attached_ || !entity_)
+        return;
+
+    RendererPtr renderer = renderer_.lock();
+    if (renderer && renderer->GetStaticBatcher())
+        renderer->GetStaticBatcher()->EntityChanged(entity_);
+}
+
 void EC_OgreCustomObject::DestroyEntity()
 {
     if (renderer_.expired())
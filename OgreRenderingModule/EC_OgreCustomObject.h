@@ -111,6 +111,9 @@ private:
     //! detaches entity from placeable
     void DetachEntity();
     
+    //! tells the static batcher that the materials, shadow casting or draw distance of the attached entity have changed
+    void NotifyStaticBatcher();
+    
     //! removes old entity and mesh
     void DestroyEntity();
     
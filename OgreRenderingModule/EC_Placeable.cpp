@@ -4,9 +4,13 @@
 #include "OgreRenderingModule.h"
 #include "Renderer.h"
 #include "EC_Placeable.h"
+#include "Entity.h"
+#include "SceneManager.h"
 #include <Ogre.h>
 #include <QDebug>
 
+#include <algorithm>
+
 using namespace OgreRenderer;
 
 EC_Placeable::EC_Placeable(IModule* module) :
@@ -30,10 +34,17 @@ EC_Placeable::EC_Placeable(IModule* module) :
     // Hook the transform attribute change
     connect(this, SIGNAL(OnAttributeChanged(IAttribute*, AttributeChange::Type)),
         SLOT(HandleAttributeChanged(IAttribute*, AttributeChange::Type)));
+    connect(this, SIGNAL(ParentEntitySet()), SLOT(HandleParentEntitySet()));
 }
 
 EC_Placeable::~EC_Placeable()
 {
+    if (parent_)
+    {
+        std::vector<EC_Placeable*> &siblings = checked_static_cast<EC_Placeable*>(parent_.get())->children_;
+        siblings.erase(std::remove(siblings.begin(), siblings.end(), this), siblings.end());
+    }
+
     if (renderer_.expired())
         return;
     RendererPtr renderer = renderer_.lock();
@@ -67,8 +78,16 @@ void EC_Placeable::SetParent(ComponentPtr placeable)
         return;
     }
     DetachNode();
+    if (parent_)
+    {
+        std::vector<EC_Placeable*> &siblings = checked_static_cast<EC_Placeable*>(parent_.get())->children_;
+        siblings.erase(std::remove(siblings.begin(), siblings.end(), this), siblings.end());
+    }
     parent_ = placeable;
+    if (parent_)
+        checked_static_cast<EC_Placeable*>(parent_.get())->children_.push_back(this);
     AttachNode();
+    UpdateSpatialIndex();
 }
 
 Vector3df EC_Placeable::GetPosition() const
@@ -89,6 +108,38 @@ Vector3df EC_Placeable::GetScale() const
     return Vector3df(scale.x, scale.y, scale.z);
 }
 
+Vector3df EC_Placeable::GetWorldPosition() const
+{
+    // Compose with the link nodes of the parents, which carry their position, orientation and transform scale.
+    Ogre::Vector3 pos = link_scene_node_->getPosition();
+    // Parents are checked to be placeables in SetParent().
+    const EC_Placeable *parent = static_cast<EC_Placeable*>(parent_.get());
+    while(parent)
+    {
+        const Ogre::SceneNode *node = parent->link_scene_node_;
+        pos = node->getOrientation() * (node->getScale() * pos) + node->getPosition();
+        parent = static_cast<EC_Placeable*>(parent->parent_.get());
+    }
+    return Vector3df(pos.x, pos.y, pos.z);
+}
+
+void EC_Placeable::UpdateSpatialIndex()
+{
+    Scene::Entity *entity = GetParentEntity();
+    Scene::SceneManager *scene = entity ? entity->GetScene() : 0;
+    if (!scene || !link_scene_node_)
+        return;
+
+    scene->GetSpatialIndex().Update(entity->GetId(), GetWorldPosition(), this);
+    for(size_t i = 0; i < children_.size(); ++i)
+        children_[i]->UpdateSpatialIndex();
+}
+
+void EC_Placeable::HandleParentEntitySet()
+{
+    UpdateSpatialIndex();
+}
+
 Vector3df EC_Placeable::GetLocalXAxis() const
 {
     const Ogre::Vector3& xaxis = link_scene_node_->getOrientation().xAxis();
@@ -129,11 +180,15 @@ void EC_Placeable::SetPosition(const Vector3df& position)
 {
     link_scene_node_->setPosition(Ogre::Vector3(position.x, position.y, position.z));
     AttachNode(); // Nodes become visible only after having their position set at least once
+    UpdateSpatialIndex();
 }
 
 void EC_Placeable::SetOrientation(const Quaternion& orientation)
 {
     link_scene_node_->setOrientation(Ogre::Quaternion(orientation.w, orientation.x, orientation.y, orientation.z));
+    // Orientation moves only the children
+    if (!children_.empty())
+        UpdateSpatialIndex();
 }
 
 void EC_Placeable::LookAt(const Vector3df& look_at)
@@ -142,21 +197,29 @@ void EC_Placeable::LookAt(const Vector3df& look_at)
     // so start in identity transform
     link_scene_node_->setOrientation(Ogre::Quaternion::IDENTITY);
     link_scene_node_->lookAt(Ogre::Vector3(look_at.x, look_at.y, look_at.z), Ogre::Node::TS_WORLD);
+    if (!children_.empty())
+        UpdateSpatialIndex();
 }
 
 void EC_Placeable::SetYaw(float radians)
 {
     link_scene_node_->yaw(Ogre::Radian(radians), Ogre::Node::TS_WORLD);
+    if (!children_.empty())
+        UpdateSpatialIndex();
 }
 
 void EC_Placeable::SetPitch(float radians)
 {
     link_scene_node_->pitch(Ogre::Radian(radians));
+    if (!children_.empty())
+        UpdateSpatialIndex();
 }
 
 void EC_Placeable::SetRoll(float radians)
 {
     link_scene_node_->roll(Ogre::Radian(radians));
+    if (!children_.empty())
+        UpdateSpatialIndex();
 } 
 
 float EC_Placeable::GetYaw() const
@@ -298,6 +361,7 @@ QVector3D EC_Placeable::translate(int axis, float amount)
 
     }
     link_scene_node_->translate(m, Ogre::Vector3(x, y, z), Ogre::Node::TS_LOCAL);
+    UpdateSpatialIndex();
     const Ogre::Vector3 newpos = link_scene_node_->getPosition();
     return QVector3D(newpos.x, newpos.y, newpos.z);
 }
@@ -327,6 +391,7 @@ void EC_Placeable::HandleAttributeChanged(IAttribute* attribute, AttributeChange
         link_scene_node_->setScale(newTransform.scale.x, newTransform.scale.y, newTransform.scale.z);
         
         AttachNode(); // Nodes become visible only after having their position set at least once
+        UpdateSpatialIndex();
     }
 }
 
@@ -137,6 +137,12 @@ public:
     //! returns scale
     Vector3df GetScale() const;
 
+    //! returns position in world space, taking parent placeables into account
+    /*! Unlike the derived position of the Ogre scene node, this is always up to date, also before the scene graph
+        has been updated for rendering.
+     */
+    Vector3df GetWorldPosition() const;
+
     //! Get the local X axis from the node orientation
     Vector3df GetLocalXAxis() const;
     //! Get the local Y axis from the node orientation
@@ -204,6 +210,9 @@ private slots:
      */
     void HandleAttributeChanged(IAttribute* attribute, AttributeChange::Type change);
 
+    //! Adds the placeable to the spatial index when it is attached to an entity.
+    void HandleParentEntitySet();
+
 private:
     //! constructor
     /*! \param module renderer module
@@ -215,12 +224,18 @@ private:
     
     //! detaches scenenode from parent
     void DetachNode();
+
+    //! pushes the world position of this placeable and its child placeables to the spatial index of the scene
+    void UpdateSpatialIndex();
     
     //! renderer
     OgreRenderer::RendererWeakPtr renderer_;
     
     //! parent placeable
     ComponentPtr parent_;
+
+    //! child placeables. They keep this placeable alive through their parent_ pointer.
+    std::vector<EC_Placeable*> children_;
     
     //! Ogre scene node for geometry. scale is handled here
     Ogre::SceneNode* scene_node_;
@@ -0,0 +1,546 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+
+#include "StableHeaders.h"
+#include "DebugOperatorNew.h"
+
+#include "LabelAtlas.h"
+#include "Renderer.h"
+#include "OgreMaterialUtils.h"
+#include "OgreRenderingModule.h"
+
+#include <Ogre.h>
+#include <OgreBillboardSet.h>
+#include <OgreBillboard.h>
+#include <OgreTextureManager.h>
+
+#include "MemoryLeakCheck.h"
+
+namespace OgreRenderer
+{
+    //! Empty pixels around each label, so that filtering does not bleed the neighbours into it
+    static const int cLabelPadding = 2;
+
+    LabelAtlas::ShelfPacker::ShelfPacker(int size) :
+        size_(size)
+    {
+    }
+
+    QRect LabelAtlas::ShelfPacker::Allocate(int width, int height)
+    {
+        if (width > size_ || height > size_)
+            return QRect();
+
+        // Use the lowest shelf the rectangle fits in, but don't waste a tall shelf on a low rectangle
+        // unless the shelf is empty.
+        Shelf *best = 0;
+        size_t bestSpan = 0;
+        for(size_t i = 0; i < shelves_.size(); ++i)
+        {
+            Shelf &shelf = shelves_[i];
+            if (shelf.height < height)
+                continue;
+            if (shelf.height > height + height / 2 && !IsEmpty(shelf))
+                continue;
+            if (best && best->height <= shelf.height)
+                continue;
+
+            for(size_t j = 0; j < shelf.free.size(); ++j)
+                if (shelf.free[j].second >= width)
+                {
+                    best = &shelf;
+                    bestSpan = j;
+                    break;
+                }
+        }
+
+        if (!best)
+        {
+            int y = shelves_.empty() ? 0 : shelves_.back().y + shelves_.back().height;
+            if (y + height > size_)
+                return QRect();
+
+            Shelf shelf;
+            shelf.y = y;
+            shelf.height = height;
+            shelf.free.push_back(std::make_pair(0, size_));
+            shelves_.push_back(shelf);
+            best = &shelves_.back();
+            bestSpan = 0;
+        }
+
+        std::pair<int, int> &span = best->free[bestSpan];
+        QRect rect(span.first, best->y, width, height);
+        span.first += width;
+        span.second -= width;
+        if (span.second == 0)
+            best->free.erase(best->free.begin() + bestSpan);
+        return rect;
+    }
+
+    void LabelAtlas::ShelfPacker::Free(const QRect &rect)
+    {
+        for(size_t i = 0; i < shelves_.size(); ++i)
+        {
+            Shelf &shelf = shelves_[i];
+            if (shelf.y != rect.y())
+                continue;
+
+            // Insert the span in x order and merge it with its neighbours
+            std::vector<std::pair<int, int> >::iterator it = shelf.free.begin();
+            while(it != shelf.free.end() && it->first < rect.x())
+                ++it;
+            it = shelf.free.insert(it, std::make_pair(rect.x(), rect.width()));
+            std::vector<std::pair<int, int> >::iterator next = it + 1;
+            if (next != shelf.free.end() && it->first + it->second == next->first)
+            {
+                it->second += next->second;
+                shelf.free.erase(next);
+            }
+            if (it != shelf.free.begin())
+            {
+                std::vector<std::pair<int, int> >::iterator prev = it - 1;
+                if (prev->first + prev->second == it->first)
+                {
+                    prev->second += it->second;
+                    shelf.free.erase(it);
+                }
+            }
+            break;
+        }
+
+        // Empty shelves at the end can be given a new height
+        while(!shelves_.empty() && IsEmpty(shelves_.back()))
+            shelves_.pop_back();
+    }
+
+    bool LabelAtlas::ShelfPacker::IsEmpty(const Shelf &shelf) const
+    {
+        return shelf.free.size() == 1 && shelf.free[0].second == size_;
+    }
+
+    LabelAtlas::LabelAtlas(Renderer *renderer, int pageSize) :
+        renderer_(renderer),
+        pageSize_(pageSize),
+        labelScale_(1.0f),
+        nextLabelId_(1),
+        nextQuadId_(1),
+        releaseCounter_(0)
+    {
+        memset(&stats_, 0, sizeof(stats_));
+    }
+
+    LabelAtlas::~LabelAtlas()
+    {
+        for(std::multimap<const Ogre::Node *, quad_id_t>::iterator it = nodeQuads_.begin(); it != nodeQuads_.end(); ++it)
+        {
+            Ogre::Node *node = const_cast<Ogre::Node *>(it->first);
+            if (node->getListener() == this)
+                node->setListener(0);
+        }
+
+        Ogre::SceneManager *scene = renderer_->GetSceneManager();
+        for(size_t i = 0; i < pages_.size(); ++i)
+        {
+            Page &page = pages_[i];
+            try
+            {
+                if (scene && page.billboards)
+                    scene->destroyBillboardSet(page.billboards);
+                Ogre::MaterialManager::getSingleton().remove(page.material);
+                Ogre::TextureManager::getSingleton().remove(page.texture);
+            }
+            catch(Ogre::Exception &e)
+            {
+                OgreRenderingModule::LogWarning("Failed to destroy label atlas page: " + std::string(e.what()));
+            }
+            delete page.packer;
+        }
+    }
+
+    LabelAtlas::label_id_t LabelAtlas::Acquire(const QString &key)
+    {
+        QHash<QString, label_id_t>::const_iterator it = labelsByKey_.find(key);
+        if (it == labelsByKey_.end())
+            return 0;
+
+        Label &label = labels_[it.value()];
+        ++label.refs;
+        ++stats_.reusedLabels;
+        stats_.fullUploadBytes += label.fullSize.width() * label.fullSize.height() * 4;
+        return it.value();
+    }
+
+    LabelAtlas::label_id_t LabelAtlas::Add(const QString &key, const QImage &image, const QSize &sourceSize, const QSize &fullSize)
+    {
+        label_id_t existing = Acquire(key);
+        if (existing)
+            return existing;
+
+        if (image.isNull())
+            return 0;
+
+        QRect rect;
+        int page = Allocate(image.width() + 2 * cLabelPadding, image.height() + 2 * cLabelPadding, rect);
+        if (page < 0)
+        {
+            OgreRenderingModule::LogWarning("Label of size " + ToString(image.width()) + "x" + ToString(image.height()) +
+                " does not fit in the label atlas");
+            return 0;
+        }
+
+        label_id_t id = nextLabelId_++;
+        Label &label = labels_[id];
+        label.key = key;
+        label.page = page;
+        label.rect = rect.adjusted(cLabelPadding, cLabelPadding, -cLabelPadding, -cLabelPadding);
+        label.sourceSize = sourceSize;
+        label.fullSize = fullSize;
+        label.refs = 1;
+        label.released = 0;
+        labelsByKey_[key] = id;
+
+        Upload(label, image);
+        stats_.fullUploadBytes += fullSize.width() * fullSize.height() * 4;
+        return id;
+    }
+
+    void LabelAtlas::Release(label_id_t id)
+    {
+        std::map<label_id_t, Label>::iterator it = labels_.find(id);
+        if (it == labels_.end())
+            return;
+
+        Label &label = it->second;
+        if (label.refs > 0 && --label.refs == 0)
+            label.released = ++releaseCounter_;
+    }
+
+    LabelAtlas::quad_id_t LabelAtlas::CreateQuad(Ogre::SceneNode *node, const Ogre::Vector3 &offset, float unitsPerPixel)
+    {
+        if (!node)
+            return 0;
+
+        if (node->getListener() && node->getListener() != this)
+            OgreRenderingModule::LogWarning("Scene node " + node->getName() + " already has a listener, labels will not follow it");
+        else
+            node->setListener(this);
+
+        quad_id_t id = nextQuadId_++;
+        Quad &quad = quads_[id];
+        quad.node = node;
+        quad.offset = offset;
+        quad.unitsPerPixel = unitsPerPixel;
+        quad.label = 0;
+        quad.billboard = 0;
+        quad.page = -1;
+        quad.visible = true;
+        quad.alpha = 1.0f;
+        nodeQuads_.insert(std::make_pair(node, id));
+        return id;
+    }
+
+    void LabelAtlas::DestroyQuad(quad_id_t id)
+    {
+        std::map<quad_id_t, Quad>::iterator it = quads_.find(id);
+        if (it == quads_.end())
+            return;
+
+        Quad &quad = it->second;
+        if (quad.billboard)
+            pages_[quad.page].billboards->removeBillboard(quad.billboard);
+
+        if (quad.node)
+        {
+            typedef std::multimap<const Ogre::Node *, quad_id_t>::iterator NodeIter;
+            std::pair<NodeIter, NodeIter> range = nodeQuads_.equal_range(quad.node);
+            for(NodeIter n = range.first; n != range.second; ++n)
+                if (n->second == id)
+                {
+                    nodeQuads_.erase(n);
+                    break;
+                }
+            if (nodeQuads_.find(quad.node) == nodeQuads_.end() && quad.node->getListener() == this)
+                quad.node->setListener(0);
+        }
+
+        quads_.erase(it);
+    }
+
+    void LabelAtlas::SetQuadLabel(quad_id_t id, label_id_t label)
+    {
+        std::map<quad_id_t, Quad>::iterator it = quads_.find(id);
+        if (it == quads_.end())
+            return;
+
+        it->second.label = labels_.find(label) != labels_.end() ? label : 0;
+        UpdateQuad(it->second);
+    }
+
+    void LabelAtlas::SetQuadOffset(quad_id_t id, const Ogre::Vector3 &offset)
+    {
+        std::map<quad_id_t, Quad>::iterator it = quads_.find(id);
+        if (it == quads_.end())
+            return;
+
+        it->second.offset = offset;
+        UpdateQuadPosition(it->second);
+    }
+
+    Ogre::Vector3 LabelAtlas::GetQuadOffset(quad_id_t id) const
+    {
+        std::map<quad_id_t, Quad>::const_iterator it = quads_.find(id);
+        return it != quads_.end() ? it->second.offset : Ogre::Vector3::ZERO;
+    }
+
+    void LabelAtlas::SetQuadUnitsPerPixel(quad_id_t id, float unitsPerPixel)
+    {
+        std::map<quad_id_t, Quad>::iterator it = quads_.find(id);
+        if (it == quads_.end())
+            return;
+
+        it->second.unitsPerPixel = unitsPerPixel;
+        UpdateQuadPosition(it->second);
+    }
+
+    void LabelAtlas::SetQuadVisible(quad_id_t id, bool visible)
+    {
+        std::map<quad_id_t, Quad>::iterator it = quads_.find(id);
+        if (it == quads_.end() || it->second.visible == visible)
+            return;
+
+        it->second.visible = visible;
+        UpdateQuad(it->second);
+    }
+
+    bool LabelAtlas::IsQuadVisible(quad_id_t id) const
+    {
+        std::map<quad_id_t, Quad>::const_iterator it = quads_.find(id);
+        return it != quads_.end() && it->second.billboard != 0;
+    }
+
+    void LabelAtlas::SetQuadAlpha(quad_id_t id, float alpha)
+    {
+        std::map<quad_id_t, Quad>::iterator it = quads_.find(id);
+        if (it == quads_.end())
+            return;
+
+        it->second.alpha = alpha;
+        if (it->second.billboard)
+            it->second.billboard->setColour(Ogre::ColourValue(1.0f, 1.0f, 1.0f, alpha));
+    }
+
+    LabelAtlas::Stats LabelAtlas::GetStats() const
+    {
+        Stats stats = stats_;
+        stats.pages = pages_.size();
+        stats.textureBytes = pages_.size() * pageSize_ * pageSize_ * 4;
+        stats.labels = labels_.size();
+        stats.quads = quads_.size();
+        stats.fullTextureBytes = 0;
+        for(std::map<quad_id_t, Quad>::const_iterator it = quads_.begin(); it != quads_.end(); ++it)
+        {
+            std::map<label_id_t, Label>::const_iterator label = labels_.find(it->second.label);
+            if (label != labels_.end())
+                stats.fullTextureBytes += label->second.fullSize.width() * label->second.fullSize.height() * 4;
+        }
+        return stats;
+    }
+
+    void LabelAtlas::nodeUpdated(const Ogre::Node *node)
+    {
+        typedef std::multimap<const Ogre::Node *, quad_id_t>::iterator NodeIter;
+        std::pair<NodeIter, NodeIter> range = nodeQuads_.equal_range(node);
+        for(NodeIter n = range.first; n != range.second; ++n)
+        {
+            std::map<quad_id_t, Quad>::iterator it = quads_.find(n->second);
+            if (it != quads_.end())
+                UpdateQuadPosition(it->second);
+        }
+    }
+
+    void LabelAtlas::nodeDestroyed(const Ogre::Node *node)
+    {
+        // The owners destroy their quads later, until then the quads stay hidden
+        typedef std::multimap<const Ogre::Node *, quad_id_t>::iterator NodeIter;
+        std::pair<NodeIter, NodeIter> range = nodeQuads_.equal_range(node);
+        for(NodeIter n = range.first; n != range.second; ++n)
+        {
+            std::map<quad_id_t, Quad>::iterator it = quads_.find(n->second);
+            if (it != quads_.end())
+            {
+                it->second.node = 0;
+                UpdateQuad(it->second);
+            }
+        }
+        nodeQuads_.erase(range.first, range.second);
+    }
+
+    int LabelAtlas::CreatePage()
+    {
+        Ogre::SceneManager *scene = renderer_->GetSceneManager();
+        if (!scene)
+            return -1;
+
+        Page page;
+        std::string suffix = renderer_->GetUniqueObjectName();
+        page.texture = "LabelAtlasTexture" + suffix;
+        page.material = "LabelAtlasMaterial" + suffix;
+        try
+        {
+            Ogre::TexturePtr texture = Ogre::TextureManager::getSingleton().createManual(
+                page.texture, Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME, Ogre::TEX_TYPE_2D,
+                pageSize_, pageSize_, 0, Ogre::PF_A8R8G8B8, Ogre::TU_DEFAULT);
+            if (texture.isNull() || texture->getBuffer().isNull())
+                return -1;
+
+            // Start from a transparent page, the padding around the labels is never written
+            std::vector<u8> clear(pageSize_ * pageSize_ * 4, 0);
+            Ogre::PixelBox pixel_box(Ogre::Box(0, 0, pageSize_, pageSize_), Ogre::PF_A8R8G8B8, &clear[0]);
+            texture->getBuffer()->blitFromMemory(pixel_box);
+            stats_.uploadedBytes += clear.size();
+
+            // The texture alpha is modulated with the billboard colour so that every quad can have its own opacity
+            Ogre::MaterialPtr material = OgreRenderer::CloneMaterial("HoveringText", page.material);
+            OgreRenderer::SetTextureUnitOnMaterial(material, page.texture);
+            Ogre::TextureUnitState *unit = material->getTechnique(0)->getPass(0)->getTextureUnitState(0);
+            unit->setAlphaOperation(Ogre::LBX_MODULATE, Ogre::LBS_TEXTURE, Ogre::LBS_DIFFUSE);
+            unit->setTextureAddressingMode(Ogre::TextureUnitState::TAM_CLAMP);
+            unit->setTextureFiltering(Ogre::TFO_BILINEAR);
+
+            page.billboards = scene->createBillboardSet(renderer_->GetUniqueObjectName(), 16);
+            page.billboards->setMaterialName(page.material);
+            page.billboards->setCastShadows(false);
+            page.billboards->setSortingEnabled(true);
+            // The billboards follow nodes anywhere in the scene, so cull them one by one instead of by set bounds
+            page.billboards->setCullIndividually(true);
+            page.billboards->setBounds(Ogre::AxisAlignedBox(Ogre::AxisAlignedBox::EXTENT_INFINITE), 1e6f);
+            scene->getRootSceneNode()->attachObject(page.billboards);
+        }
+        catch(Ogre::Exception &e)
+        {
+            OgreRenderingModule::LogError("Failed to create label atlas page: " + std::string(e.what()));
+            return -1;
+        }
+
+        page.packer = new ShelfPacker(pageSize_);
+        pages_.push_back(page);
+        return pages_.size() - 1;
+    }
+
+    int LabelAtlas::Allocate(int width, int height, QRect &rect)
+    {
+        if (width > pageSize_ || height > pageSize_)
+            return -1;
+
+        for(size_t i = 0; i < pages_.size(); ++i)
+        {
+            rect = pages_[i].packer->Allocate(width, height);
+            if (!rect.isNull())
+                return i;
+        }
+
+        // Make room by evicting the least recently used labels nobody shows anymore
+        std::multimap<uint, label_id_t> unused;
+        for(std::map<label_id_t, Label>::iterator it = labels_.begin(); it != labels_.end(); ++it)
+            if (it->second.refs == 0)
+                unused.insert(std::make_pair(it->second.released, it->first));
+
+        for(std::multimap<uint, label_id_t>::iterator it = unused.begin(); it != unused.end(); ++it)
+        {
+            int page = labels_[it->second].page;
+            Evict(it->second);
+            rect = pages_[page].packer->Allocate(width, height);
+            if (!rect.isNull())
+                return page;
+        }
+
+        int page = CreatePage();
+        if (page < 0)
+            return -1;
+        rect = pages_[page].packer->Allocate(width, height);
+        return rect.isNull() ? -1 : page;
+    }
+
+    void LabelAtlas::Evict(label_id_t id)
+    {
+        std::map<label_id_t, Label>::iterator it = labels_.find(id);
+        if (it == labels_.end())
+            return;
+
+        const Label &label = it->second;
+        pages_[label.page].packer->Free(label.rect.adjusted(-cLabelPadding, -cLabelPadding, cLabelPadding, cLabelPadding));
+        labelsByKey_.remove(label.key);
+        labels_.erase(it);
+    }
+
+    void LabelAtlas::Upload(const Label &label, const QImage &image)
+    {
+        QImage argb = image.format() == QImage::Format_ARGB32 ? image : image.convertToFormat(QImage::Format_ARGB32);
+        Ogre::TexturePtr texture = Ogre::TextureManager::getSingleton().getByName(pages_[label.page].texture);
+        if (texture.isNull() || texture->getBuffer().isNull())
+            return;
+
+        const QRect &rect = label.rect;
+        Ogre::Box source(0, 0, argb.width(), argb.height());
+        Ogre::Box dest(rect.x(), rect.y(), rect.x() + argb.width(), rect.y() + argb.height());
+        Ogre::PixelBox pixel_box(source, Ogre::PF_A8R8G8B8, (void *)argb.bits());
+        try
+        {
+            texture->getBuffer()->blitFromMemory(pixel_box, dest);
+        }
+        catch(Ogre::Exception &e)
+        {
+            OgreRenderingModule::LogError("Failed to upload label to atlas: " + std::string(e.what()));
+            return;
+        }
+
+        ++stats_.uploadedLabels;
+        stats_.uploadedBytes += argb.width() * argb.height() * 4;
+    }
+
+    void LabelAtlas::UpdateQuad(Quad &quad)
+    {
+        std::map<label_id_t, Label>::const_iterator label = labels_.find(quad.label);
+        bool show = quad.visible && quad.node && label != labels_.end();
+        int page = show ? label->second.page : -1;
+
+        if (quad.billboard && (!show || page != quad.page))
+        {
+            pages_[quad.page].billboards->removeBillboard(quad.billboard);
+            quad.billboard = 0;
+            quad.page = -1;
+        }
+
+        if (!show)
+            return;
+
+        if (!quad.billboard)
+        {
+            quad.billboard = pages_[page].billboards->createBillboard(Ogre::Vector3::ZERO);
+            quad.page = page;
+        }
+
+        const QRect &rect = label->second.rect;
+        float size = (float)pageSize_;
+        quad.billboard->setTexcoordRect(rect.x() / size, rect.y() / size,
+            (rect.x() + rect.width()) / size, (rect.y() + rect.height()) / size);
+        quad.billboard->setColour(Ogre::ColourValue(1.0f, 1.0f, 1.0f, quad.alpha));
+        UpdateQuadPosition(quad);
+    }
+
+    void LabelAtlas::UpdateQuadPosition(Quad &quad)
+    {
+        if (!quad.billboard || !quad.node)
+            return;
+
+        std::map<label_id_t, Label>::const_iterator label = labels_.find(quad.label);
+        if (label == labels_.end())
+            return;
+
+        const Ogre::Vector3 &scale = quad.node->_getDerivedScale();
+        quad.billboard->setPosition(quad.node->_getDerivedPosition() + quad.node->_getDerivedOrientation() * (scale * quad.offset));
+
+        const QSize &source = label->second.sourceSize;
+        quad.billboard->setDimensions(source.width() * quad.unitsPerPixel * scale.x, source.height() * quad.unitsPerPixel * scale.x);
+    }
+}
@@ -0,0 +1,244 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+
+#ifndef incl_OgreRenderer_LabelAtlas_h
+#define incl_OgreRenderer_LabelAtlas_h
+
+#include "OgreModuleApi.h"
+#include "CoreTypes.h"
+
+#include <OgreNode.h>
+#include <OgreVector3.h>
+
+#include <QHash>
+#include <QImage>
+#include <QRect>
+#include <QString>
+
+#include <map>
+#include <vector>
+
+namespace Ogre
+{
+    class BillboardSet;
+    class Billboard;
+}
+
+namespace OgreRenderer
+{
+    class Renderer;
+
+    //! Shared texture atlas for text labels such as hovering texts and chat bubbles.
+    /*! Labels are rendered with Qt by their owners and copied into one of a few large atlas textures.
+        Only the rectangle of the label is uploaded, and a label that is identical to one already in
+        the atlas (same key) is reused without rendering or uploading anything.
+
+        Labels are shown with quads. All quads that use labels of the same atlas page are billboards of
+        one billboard set, so each page is drawn with a single batch. A quad follows the scene node it
+        was created for, so that it moves like a billboard attached to the node would. The atlas
+        installs itself as the Ogre::Node::Listener of those nodes.
+
+        Created by Renderer, see Renderer::GetLabelAtlas.
+    */
+    class OGRE_MODULE_API LabelAtlas : public Ogre::Node::Listener
+    {
+    public:
+        //! Label id. 0 is not a valid id.
+        typedef uint label_id_t;
+        //! Quad id. 0 is not a valid id.
+        typedef uint quad_id_t;
+
+        //! Statistics of the atlas, for RenderStats
+        struct Stats
+        {
+            //! Number of atlas pages
+            uint pages;
+            //! Texture memory used by the pages, in bytes
+            uint textureBytes;
+            //! Number of labels in the atlas, including unused ones kept for reuse
+            uint labels;
+            //! Number of quads
+            uint quads;
+            //! Number of label requests that found an identical label already in the atlas
+            uint reusedLabels;
+            //! Number of labels rendered and uploaded
+            uint uploadedLabels;
+            //! Bytes uploaded to the atlas textures
+            u64 uploadedBytes;
+            //! Bytes a texture per label owner would have uploaded for the same requests
+            u64 fullUploadBytes;
+            //! Texture memory a texture per quad would use for the current quads
+            u64 fullTextureBytes;
+        };
+
+        //! Constructor
+        /*! \param renderer Renderer
+            \param pageSize Width and height of the atlas textures in pixels
+         */
+        LabelAtlas(Renderer *renderer, int pageSize);
+
+        //! Destructor. Destroys the atlas textures, materials and billboard sets.
+        ~LabelAtlas();
+
+        //! Returns the scale owners should render their labels with, 1.0 is the resolution of the old per-entity textures
+        float GetLabelScale() const { return labelScale_; }
+
+        //! Sets the label scale
+        void SetLabelScale(float scale) { labelScale_ = scale; }
+
+        //! Returns a label that is already in the atlas and adds a reference to it
+        /*! \param key Key that identifies the label contents, eg. the text, font and colors
+            \return Label id, or 0 if there is no label with the key
+         */
+        label_id_t Acquire(const QString &key);
+
+        //! Adds a label to the atlas, or references the existing one if there already is a label with the key
+        /*! \param key Key that identifies the label contents
+            \param image Label rendered with GetLabelScale
+            \param sourceSize Size of the label in unscaled pixels. Also used for the statistics
+                   of how much a per-label texture of fullSize would have used.
+            \param fullSize Size of the texture the owner used before the atlas
+            \return Label id, or 0 if the label does not fit in an atlas page
+         */
+        label_id_t Add(const QString &key, const QImage &image, const QSize &sourceSize, const QSize &fullSize);
+
+        //! Removes a reference to a label
+        /*! Labels without references are kept in the atlas until their space is needed.
+         */
+        void Release(label_id_t id);
+
+        //! Creates a quad that follows a scene node. The quad is hidden until it has a label.
+        /*! \param node Scene node. The atlas becomes the listener of the node.
+            \param offset Position relative to the node
+            \param unitsPerPixel Size of one unscaled label pixel in world units
+         */
+        quad_id_t CreateQuad(Ogre::SceneNode *node, const Ogre::Vector3 &offset, float unitsPerPixel);
+
+        //! Destroys a quad. Does not release its label.
+        void DestroyQuad(quad_id_t id);
+
+        //! Shows a label with the quad
+        void SetQuadLabel(quad_id_t id, label_id_t label);
+
+        //! Sets position of the quad relative to its node
+        void SetQuadOffset(quad_id_t id, const Ogre::Vector3 &offset);
+
+        //! Returns position of the quad relative to its node
+        Ogre::Vector3 GetQuadOffset(quad_id_t id) const;
+
+        //! Sets size of one unscaled label pixel in world units
+        void SetQuadUnitsPerPixel(quad_id_t id, float unitsPerPixel);
+
+        //! Shows or hides a quad
+        void SetQuadVisible(quad_id_t id, bool visible);
+
+        //! Returns whether the quad is visible
+        bool IsQuadVisible(quad_id_t id) const;
+
+        //! Sets the opacity of a quad
+        void SetQuadAlpha(quad_id_t id, float alpha);
+
+        //! Returns statistics of the atlas
+        Stats GetStats() const;
+
+        // Ogre::Node::Listener overrides
+        virtual void nodeUpdated(const Ogre::Node *node);
+        virtual void nodeDestroyed(const Ogre::Node *node);
+
+    private:
+        //! Rows of equal height, with a list of free spans in each row
+        class ShelfPacker
+        {
+        public:
+            explicit ShelfPacker(int size);
+
+            //! Returns the allocated rectangle, or a null rectangle if there is no room
+            QRect Allocate(int width, int height);
+
+            //! Frees a rectangle returned by Allocate
+            void Free(const QRect &rect);
+
+        private:
+            struct Shelf
+            {
+                int y;
+                int height;
+                //! Free spans, x and width, in x order
+                std::vector<std::pair<int, int> > free;
+            };
+
+            //! Returns whether a shelf is completely free
+            bool IsEmpty(const Shelf &shelf) const;
+
+            int size_;
+            std::vector<Shelf> shelves_;
+        };
+
+        struct Page
+        {
+            Page() : packer(0), billboards(0) {}
+            std::string texture;
+            std::string material;
+            ShelfPacker *packer;
+            Ogre::BillboardSet *billboards;
+        };
+
+        struct Label
+        {
+            QString key;
+            int page;
+            //! Rectangle in the atlas page, without the padding
+            QRect rect;
+            QSize sourceSize;
+            QSize fullSize;
+            int refs;
+            //! Time of the last release, for evicting the least recently used labels
+            uint released;
+        };
+
+        struct Quad
+        {
+            Ogre::SceneNode *node;
+            Ogre::Vector3 offset;
+            float unitsPerPixel;
+            label_id_t label;
+            Ogre::Billboard *billboard;
+            int page;
+            bool visible;
+            float alpha;
+        };
+
+        //! Creates a new atlas page, returns its index or -1 on failure
+        int CreatePage();
+
+        //! Allocates room for a label, evicting unused labels if needed. Returns the page or -1.
+        int Allocate(int width, int height, QRect &rect);
+
+        //! Removes an unused label from the atlas
+        void Evict(label_id_t id);
+
+        //! Copies a label image to its place in the atlas
+        void Upload(const Label &label, const QImage &image);
+
+        //! Creates, moves or updates the billboard of a quad after its label, visibility or transform changed
+        void UpdateQuad(Quad &quad);
+
+        //! Updates the billboard position of a quad from its node
+        void UpdateQuadPosition(Quad &quad);
+
+        Renderer *renderer_;
+        int pageSize_;
+        float labelScale_;
+        std::vector<Page> pages_;
+        std::map<label_id_t, Label> labels_;
+        QHash<QString, label_id_t> labelsByKey_;
+        std::map<quad_id_t, Quad> quads_;
+        //! Quads of each followed node
+        std::multimap<const Ogre::Node *, quad_id_t> nodeQuads_;
+        label_id_t nextLabelId_;
+        quad_id_t nextQuadId_;
+        uint releaseCounter_;
+        Stats stats_;
+    };
+}
+
+#endif
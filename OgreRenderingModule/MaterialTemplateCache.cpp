@@ -0,0 +1,100 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+
+#include "StableHeaders.h"
+#include "MaterialTemplateCache.h"
+#include "OgreMaterialUtils.h"
+#include "CoreStringUtils.h"
+
+#include <Ogre.h>
+
+#include <cstdlib>
+
+namespace
+{
+    const std::string cPlaceholderTexture("MaterialTemplateTexture");
+}
+
+namespace OgreRenderer
+{
+    MaterialTemplateCache::MaterialTemplateCache() :
+        count_(0)
+    {
+    }
+
+    MaterialTemplateCache::~MaterialTemplateCache()
+    {
+        Clear();
+    }
+
+    Ogre::MaterialPtr MaterialTemplateCache::GetTemplate(const std::string &script) const
+    {
+        TemplateMap::const_iterator i = templates_.find(GetHash(script));
+        if (i == templates_.end() || i->second.script != script)
+            return Ogre::MaterialPtr();
+        return i->second.material;
+    }
+
+    void MaterialTemplateCache::AddTemplate(const std::string &script, Ogre::MaterialPtr material)
+    {
+        u32 hash = GetHash(script);
+        // A different script with the same hash keeps its template
+        if (material.isNull() || templates_.find(hash) != templates_.end())
+            return;
+
+        Template &entry = templates_[hash];
+        entry.script = script;
+        entry.material = material->clone("MaterialTemplate" + ToString<uint>(++count_));
+        stats_.templates = templates_.size();
+    }
+
+    void MaterialTemplateCache::Clear()
+    {
+        for(TemplateMap::iterator i = templates_.begin(); i != templates_.end(); ++i)
+            RemoveMaterial(i->second.material);
+        templates_.clear();
+        stats_.templates = 0;
+    }
+
+    void MaterialTemplateCache::AddParse(f64 time)
+    {
+        ++stats_.parses;
+        stats_.parseTime += time;
+    }
+
+    void MaterialTemplateCache::AddHit(f64 time)
+    {
+        ++stats_.hits;
+        stats_.cloneTime += time;
+    }
+
+    f64 MaterialTemplateCache::GetTimeSaved() const
+    {
+        if (!stats_.parses)
+            return 0.0;
+        return stats_.hits * stats_.parseTime / stats_.parses - stats_.cloneTime;
+    }
+
+    std::string MaterialTemplateCache::GetPlaceholderTexture(uint index)
+    {
+        return cPlaceholderTexture + ToString<uint>(index);
+    }
+
+    int MaterialTemplateCache::GetPlaceholderIndex(const std::string &name)
+    {
+        if (name.length() <= cPlaceholderTexture.length() || name.compare(0, cPlaceholderTexture.length(), cPlaceholderTexture) != 0)
+            return -1;
+        return atoi(name.c_str() + cPlaceholderTexture.length());
+    }
+
+    u32 MaterialTemplateCache::GetHash(const std::string &script)
+    {
+        // FNV-1a
+        u32 hash = 2166136261u;
+        for(uint i = 0; i < script.length(); ++i)
+        {
+            hash ^= (u8)script[i];
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+}
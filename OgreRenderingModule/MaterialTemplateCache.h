@@ -0,0 +1,98 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+
+#ifndef incl_OgreRenderer_MaterialTemplateCache_h
+#define incl_OgreRenderer_MaterialTemplateCache_h
+
+#include "OgreModuleApi.h"
+#include "CoreTypes.h"
+
+#include <OgreMaterial.h>
+
+#include <map>
+#include <string>
+
+namespace OgreRenderer
+{
+    //! Parsed material scripts, shared by material assets that differ only by their texture references.
+    /*! OgreMaterialResource replaces the material name and the texture names of a material script with placeholders
+        before parsing it. The result is a template, keyed by the hash of the placeholder script, that later materials
+        with the same script are cloned from, with the placeholder textures set to their own textures.
+
+        Owned by ResourceHandler. Can be disabled with material_templates in the OgreRenderer configuration group.
+     */
+    class OGRE_MODULE_API MaterialTemplateCache
+    {
+    public:
+        //! Template statistics
+        struct Stats
+        {
+            Stats() : templates(0), parses(0), parseTime(0.0), hits(0), cloneTime(0.0) {}
+            //! Templates in the cache
+            uint templates;
+            //! Material scripts parsed
+            uint parses;
+            //! Seconds spent parsing
+            f64 parseTime;
+            //! Materials cloned from a template instead of parsed
+            uint hits;
+            //! Seconds spent cloning from templates
+            f64 cloneTime;
+        };
+
+        //! Constructor
+        MaterialTemplateCache();
+
+        //! Destructor. Removes the template materials.
+        ~MaterialTemplateCache();
+
+        //! Returns the template parsed from a placeholder script, or null if there is none
+        Ogre::MaterialPtr GetTemplate(const std::string &script) const;
+
+        //! Stores a copy of a material parsed from a placeholder script as its template
+        void AddTemplate(const std::string &script, Ogre::MaterialPtr material);
+
+        //! Removes all templates
+        void Clear();
+
+        //! Adds the time taken by parsing a material script to the statistics
+        void AddParse(f64 time);
+
+        //! Adds the time taken by cloning a material from a template to the statistics
+        void AddHit(f64 time);
+
+        //! Returns the statistics
+        const Stats& GetStats() const { return stats_; }
+
+        //! Returns an estimate of the seconds saved by cloning from templates instead of parsing
+        f64 GetTimeSaved() const;
+
+        //! Returns the placeholder name of the texture at index in a material script
+        static std::string GetPlaceholderTexture(uint index);
+
+        //! Returns the index of a placeholder texture name, or -1 if the name is not a placeholder
+        static int GetPlaceholderIndex(const std::string &name);
+
+    private:
+        //! A template and the script it was parsed from, to tell apart scripts that hash the same
+        struct Template
+        {
+            std::string script;
+            Ogre::MaterialPtr material;
+        };
+
+        typedef std::map<u32, Template> TemplateMap;
+
+        //! Returns the hash of a placeholder script
+        static u32 GetHash(const std::string &script);
+
+        //! Templates by script hash
+        TemplateMap templates_;
+
+        //! Number of template materials created, for unique names
+        uint count_;
+
+        Stats stats_;
+    };
+}
+
+#endif
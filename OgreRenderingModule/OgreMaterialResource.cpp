@@ -6,10 +6,18 @@
 #include "OgreRenderingModule.h"
 #include "OgreMaterialUtils.h"
 #include "ResourceHandler.h"
+#include "MaterialTemplateCache.h"
 #include "CoreStringUtils.h"
+#include "HighPerfClock.h"
 
 #include <Ogre.h>
 
+namespace
+{
+    //! Material name in the modified script, replaced with a temporary name for parsing
+    const std::string template_name("MaterialTemplate");
+}
+
 namespace OgreRenderer
 {
     OgreMaterialResource::OgreMaterialResource(const std::string& id, ShadowQuality shadowquality) : 
@@ -35,7 +43,7 @@ namespace OgreRenderer
         ogre_material_ = material;
     }
     
-    bool OgreMaterialResource::SetData(Foundation::AssetPtr source)
+    bool OgreMaterialResource::SetData(Foundation::AssetPtr source, MaterialTemplateCache* templates)
     {
         // Remove old material if any
         RemoveMaterial();
@@ -69,9 +77,13 @@ namespace OgreRenderer
             int brace_level = 0;
             bool skip_until_next = false;
             int skip_brace_level = 0;
-            // Parsed/modified material script
+            // Parsed/modified material script. The material name and texture names are replaced with placeholders,
+            // so that materials which differ only by their textures have the same script
             std::ostringstream output;
-            
+            // Position of the material name in the modified copy
+            size_t name_pos = std::string::npos;
+            // Texture names by placeholder index
+            StringVector texture_names;
 
             while (!data->eof())
             {
@@ -88,7 +100,8 @@ namespace OgreRenderer
                         {
                             if (num_materials == 0)
                             {
-                                line = "material " + tempname;
+                                line = "material " + template_name;
+                                name_pos = (size_t)output.tellp() + 9;
                                 ++num_materials;
                             }
                             else
@@ -107,9 +120,13 @@ namespace OgreRenderer
                                 // before requesting the reference
                                 references_.push_back(Foundation::ResourceReference(tex_name, OgreTextureResource::GetTypeStatic()));
                                 original_textures_.push_back(tex_name);
-                                // Replace any / with \ in the material, then change the texture names back later, so that Ogre does not go nuts
-                                ReplaceCharInplace(line, '/', '\\');
-                                ReplaceCharInplace(line, ':', '@');
+                                // Replace the texture name with a placeholder, and set the texture name back later. This also keeps
+                                // Ogre from going nuts over / and : in the name. Anything after the name is texture unit options.
+                                size_t name_end = tex_name.find_first_of(" \t");
+                                texture_names.push_back(tex_name.substr(0, name_end));
+                                line = "texture " + MaterialTemplateCache::GetPlaceholderTexture(texture_names.size() - 1);
+                                if (name_end != std::string::npos)
+                                    line += tex_name.substr(name_end);
                             }
                         }
 
@@ -129,28 +146,45 @@ namespace OgreRenderer
             }
 
             std::string output_str = output.str();
-            Ogre::DataStreamPtr modified_data = Ogre::DataStreamPtr(new Ogre::MemoryDataStream((u8 *)(&output_str[0]), output_str.size()));
+            tick_t start = GetCurrentClockTime();
 
-            matmgr.parseScript(modified_data, Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
-            Ogre::MaterialPtr tempmat;
-            tempmat = matmgr.getByName(tempname);
-            if (tempmat.isNull())
-            {
-                OgreRenderingModule::LogWarning(std::string("Failed to create an Ogre material from material asset ") +
-                    source->GetId());
+            // Clone from a template of the same script if there is one, otherwise parse the script
+            Ogre::MaterialPtr templ;
+            if (templates)
+                templ = templates->GetTemplate(output_str);
 
-                return false;
-            }
-            if(!tempmat->getNumTechniques())
+            if (!templ.isNull())
+                ogre_material_ = templ->clone(id_);
+            else
             {
-                OgreRenderingModule::LogWarning("Failed to create an Ogre material from material asset "  +
-                    source->GetId());
-                return false;
+                std::string script = output_str;
+                if (name_pos != std::string::npos)
+                    script.replace(name_pos, template_name.length(), tempname);
+                Ogre::DataStreamPtr modified_data = Ogre::DataStreamPtr(new Ogre::MemoryDataStream((u8 *)(&script[0]), script.size()));
+
+                matmgr.parseScript(modified_data, Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME);
+                Ogre::MaterialPtr tempmat;
+                tempmat = matmgr.getByName(tempname);
+                if (tempmat.isNull())
+                {
+                    OgreRenderingModule::LogWarning(std::string("Failed to create an Ogre material from material asset ") +
+                        source->GetId());
+
+                    return false;
+                }
+                if(!tempmat->getNumTechniques())
+                {
+                    OgreRenderingModule::LogWarning("Failed to create an Ogre material from material asset "  +
+                        source->GetId());
+                    return false;
+                }
+                
+                ogre_material_ = tempmat->clone(id_);
+                if (templates && !ogre_material_.isNull())
+                    templates->AddTemplate(output_str, tempmat);
+                tempmat.setNull();
+                matmgr.remove(tempname);
             }
-            
-            ogre_material_ = tempmat->clone(id_);
-            tempmat.setNull();
-            matmgr.remove(tempname);
             if (ogre_material_.isNull())
             {
                 OgreRenderingModule::LogWarning("Failed to create an Ogre material from material asset "  +
@@ -158,7 +192,7 @@ namespace OgreRenderer
                 return false;
             }
             
-            // Now go through all the texturenames and restore \ back to / and @ to :
+            // Now go through all the texture units and set the texture names back from the placeholders
             Ogre::Material::TechniqueIterator iter = ogre_material_->getTechniqueIterator();
             while (iter.hasMoreElements())
             {
@@ -171,16 +205,21 @@ namespace OgreRenderer
                     while (texIter.hasMoreElements())
                     {
                         Ogre::TextureUnitState *texUnit = texIter.getNext();
-                        std::string texname = texUnit->getTextureName();
-                        if (texname.find('\\') != std::string::npos)
-                        {
-                            ReplaceCharInplace(texname, '\\', '/');
-                            ReplaceCharInplace(texname, '@', ':');
-                            texUnit->setTextureName(texname);
-                        }
+                        int index = MaterialTemplateCache::GetPlaceholderIndex(texUnit->getTextureName());
+                        if (index >= 0 && index < (int)texture_names.size())
+                            texUnit->setTextureName(texture_names[index]);
                     }
                 }
             }
+
+            if (templates)
+            {
+                f64 time = (GetCurrentClockTime() - start) / (f64)GetCurrentClockFreq();
+                if (!templ.isNull())
+                    templates->AddHit(time);
+                else
+                    templates->AddParse(time);
+            }
             
             //workaround: if receives shadows, check the amount of shadowmaps. If only 1 specified, add 2 more to support 3 shadowmaps
             if(ogre_material_->getReceiveShadows() && shadowquality_ == Shadows_High && ogre_material_->getNumTechniques() > 0)
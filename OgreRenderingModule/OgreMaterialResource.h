@@ -13,6 +13,7 @@
 namespace OgreRenderer
 {
     class OgreMaterialResource;
+    class MaterialTemplateCache;
     typedef boost::shared_ptr<OgreMaterialResource> OgreMaterialResourcePtr;
 
     //! An Ogre-specific material script resource
@@ -50,9 +51,11 @@ namespace OgreRenderer
 
         //! sets contents from asset data
         /*! \param source asset data to construct the material from
+            \param templates if not null, the material is cloned from a template of the same script instead of parsed
+                   when there is one, and a template is stored when there is not
             \return true if successful
         */
-        bool SetData(Foundation::AssetPtr source);
+        bool SetData(Foundation::AssetPtr source, MaterialTemplateCache* templates = 0);
 
         //! sets to contain an external material pointer
         void SetMaterial(Ogre::MaterialPtr material);
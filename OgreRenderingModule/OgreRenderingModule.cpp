@@ -22,6 +22,8 @@
 #include "ConsoleServiceInterface.h"
 #include "ConsoleCommandServiceInterface.h"
 #include "RendererSettings.h"
+#include "LabelAtlas.h"
+#include "StaticBatcher.h"
 #include "ConfigurationManager.h"
 #include "EventManager.h"
 
@@ -110,6 +112,9 @@ namespace OgreRenderer
         RegisterConsoleCommand(Console::CreateCommand(
                 "RenderStats", "Prints out render statistics.", 
                 Console::Bind(this, &OgreRenderingModule::ConsoleStats)));
+        RegisterConsoleCommand(Console::CreateCommand(
+                "StaticBatching", "Enables or disables static batching. Usage: StaticBatching(on|off)", 
+                Console::Bind(this, &OgreRenderingModule::ConsoleStaticBatching)));
         renderer_settings_ = RendererSettingsPtr(new RendererSettings(framework_));
     }
 
@@ -200,12 +205,59 @@ namespace OgreRenderer
                 console->Print("Triangles: " + ToString(stats.triangleCount));
                 console->Print("Batches: " + ToString(stats.batchCount));
 
+                LabelAtlas *atlas = renderer_->GetExistingLabelAtlas();
+                if (atlas)
+                {
+                    LabelAtlas::Stats label_stats = atlas->GetStats();
+                    console->Print("Label atlas: " + ToString(label_stats.pages) + " pages, " + ToString(label_stats.labels) +
+                        " labels, " + ToString(label_stats.quads) + " quads");
+                    console->Print("Label texture memory: " + ToString(label_stats.textureBytes / 1024) + " KB, " +
+                        ToString(label_stats.fullTextureBytes / 1024) + " KB with a texture per label");
+                    console->Print("Label uploads: " + ToString(label_stats.uploadedLabels) + " labels, " +
+                        ToString(label_stats.uploadedBytes / 1024) + " KB, " + ToString(label_stats.fullUploadBytes / 1024) +
+                        " KB with a texture per label, " + ToString(label_stats.reusedLabels) + " identical labels reused");
+                }
+
+                ResourceHandlerPtr handler = renderer_->GetResourceHandler();
+                if (handler->GetUseMaterialTemplates())
+                {
+                    const MaterialTemplateCache& templates = handler->GetMaterialTemplates();
+                    const MaterialTemplateCache::Stats& template_stats = templates.GetStats();
+                    console->Print("Material scripts: " + ToString(template_stats.parses) + " parsed in " +
+                        ToString(template_stats.parseTime * 1000.0) + " ms, " + ToString(template_stats.hits) + " cloned from " +
+                        ToString(template_stats.templates) + " templates in " + ToString(template_stats.cloneTime * 1000.0) +
+                        " ms, about " + ToString(templates.GetTimeSaved() * 1000.0) + " ms saved");
+                }
+
+                StaticBatcher *batcher = renderer_->GetStaticBatcher();
+                if (batcher && batcher->IsEnabled())
+                {
+                    StaticBatcher::Stats batch_stats = batcher->GetStats();
+                    console->Print("Static batching: " + ToString(batch_stats.batched) + " of " + ToString(batch_stats.entities) +
+                        " entities in " + ToString(batch_stats.batches) + " batches of " + ToString(batch_stats.cells) + " cells, " +
+                        ToString(batch_stats.pending) + " cells waiting to be rebuilt");
+                    console->Print("Static batch rebuilds: " + ToString(batch_stats.rebuilds) + " in " +
+                        ToString(batch_stats.rebuildTime * 1000.0) + " ms, last " + ToString(batch_stats.lastRebuildTime * 1000.0) + " ms");
+                }
+
                 return Console::ResultSuccess();
             }
         }
 
         return Console::ResultFailure("No renderer found.");
     }
+
+    Console::CommandResult OgreRenderingModule::ConsoleStaticBatching(const StringVector &params)
+    {
+        if (!renderer_ || !renderer_->GetStaticBatcher())
+            return Console::ResultFailure("No renderer found.");
+
+        if (params.size() != 1 || (params[0] != "on" && params[0] != "off"))
+            return Console::ResultFailure("Usage: StaticBatching(on|off)");
+
+        renderer_->GetStaticBatcher()->SetEnabled(params[0] == "on");
+        return Console::ResultSuccess("Static batching " + params[0]);
+    }
 }
 
 extern "C" void POCO_LIBRARY_API SetProfiler(Foundation::Profiler *profiler);
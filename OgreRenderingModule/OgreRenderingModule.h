@@ -54,6 +54,9 @@ namespace OgreRenderer
         //! callback for console command
         Console::CommandResult ConsoleStats(const StringVector &params);
 
+        //! callback for console command, enables or disables static batching
+        Console::CommandResult ConsoleStaticBatching(const StringVector &params);
+
      
 
     private:
@@ -11,14 +11,16 @@ namespace OgreRenderer
     OgreTextureResource::OgreTextureResource(const std::string& id, TextureQuality texturequality) : 
         ResourceInterface(id),
         texturequality_(texturequality),
-        level_(-1)
+        level_(-1),
+        uploaded_mips_(0)
     {
     }
 
     OgreTextureResource::OgreTextureResource(const std::string& id, TextureQuality texturequality, Foundation::TexturePtr source) : 
         ResourceInterface(id),
         texturequality_(texturequality),
-        level_(-1)
+        level_(-1),
+        uploaded_mips_(0)
     {
         SetData(source);
     }
@@ -69,7 +71,8 @@ namespace OgreRenderer
             return false;
         }
 
-        OgreRenderingModule::LogDebug("Ogre texture " + id_ + " created");
+        if (OgreRenderingModule::IsLogEnabled(Poco::Message::PRIO_DEBUG))
+            OgreRenderingModule::LogDebug("Ogre texture " + id_ + " created");
         level_ = 0;
         return true;
     }
@@ -118,13 +121,23 @@ namespace OgreRenderer
             }
         }
 
+        // Mipmap levels of the source are uploaded as they are, otherwise Ogre generates them.
+        // In low quality mode the first mipmap level of the highest level texture is skipped.
+        uint mips = source->GetMipCount();
+        uint first_mip = ((mips > 1) && (!source->GetLevel()) && (texturequality_ == Texture_Low)) ? 1 : 0;
+        uint uploaded_mips = (mips > 1) ? mips - first_mip : 0;
+        uint width = std::max<uint>(source->GetWidth() >> first_mip, 1);
+        uint height = std::max<uint>(source->GetHeight() >> first_mip, 1);
+        int usage = uploaded_mips ? Ogre::TU_STATIC_WRITE_ONLY : Ogre::TU_DEFAULT;
+
         try
         {
+            size_t num_mipmaps = uploaded_mips ? uploaded_mips - 1 : Ogre::TextureManager::getSingleton().getDefaultNumMipmaps();
             if (ogre_texture_.isNull())
             {   
                 ogre_texture_ = Ogre::TextureManager::getSingleton().createManual(
                     id_, Ogre::ResourceGroupManager::DEFAULT_RESOURCE_GROUP_NAME, Ogre::TEX_TYPE_2D,
-                    source->GetWidth(), source->GetHeight(), Ogre::MIP_DEFAULT, pixel_format, Ogre::TU_DEFAULT); 
+                    width, height, num_mipmaps, pixel_format, usage); 
 
                 if (ogre_texture_.isNull())
                 {
@@ -134,21 +147,38 @@ namespace OgreRenderer
             }
             else
             {
-                // See if size/format changed, have to delete/recreate internal resources
-                if ((source->GetWidth() != ogre_texture_->getWidth()) ||
-                    (source->GetHeight() != ogre_texture_->getHeight()) ||
-                    (pixel_format != ogre_texture_->getFormat()))
+                // See if size/format/mipmaps changed, have to delete/recreate internal resources
+                if ((width != ogre_texture_->getWidth()) ||
+                    (height != ogre_texture_->getHeight()) ||
+                    (pixel_format != ogre_texture_->getFormat()) ||
+                    (uploaded_mips != uploaded_mips_))
                 {
                     ogre_texture_->freeInternalResources();
-                    ogre_texture_->setWidth(source->GetWidth());
-                    ogre_texture_->setHeight(source->GetHeight());
+                    ogre_texture_->setWidth(width);
+                    ogre_texture_->setHeight(height);
                     ogre_texture_->setFormat(pixel_format);
+                    ogre_texture_->setNumMipmaps(num_mipmaps);
+                    ogre_texture_->setUsage(usage);
                     ogre_texture_->createInternalResources();
                 }
             }
+            uploaded_mips_ = uploaded_mips;
 
+            if (uploaded_mips)
+            {
+                // The render system may support less mipmap levels than the source has
+                uint last_mip = std::min<uint>(mips, first_mip + ogre_texture_->getNumMipmaps() + 1);
+                for (uint i = first_mip; i < last_mip; ++i)
+                {
+                    Ogre::Box dimensions(0, 0, std::max<uint>(source->GetWidth() >> i, 1), std::max<uint>(source->GetHeight() >> i, 1));
+                    Ogre::PixelBox pixel_box(dimensions, pixel_format, (void*)source->GetMipData(i));
+                    Ogre::HardwarePixelBufferSharedPtr buffer = ogre_texture_->getBuffer(0, i - first_mip);
+                    if (!buffer.isNull())
+                        buffer->blitFromMemory(pixel_box);
+                }
+            }
             // For the highest level texture, reduce size in low quality mode
-            if ((!source->GetLevel()) && (texturequality_ == Texture_Low))
+            else if ((!source->GetLevel()) && (texturequality_ == Texture_Low))
             {
                 Ogre::Image tempImage;
                 Ogre::DataStreamPtr stream(new Ogre::MemoryDataStream((void*)source->GetData(), source->GetDataSize(), false));
@@ -171,7 +201,8 @@ namespace OgreRenderer
             return false;
         }
 
-        OgreRenderingModule::LogDebug("Ogre texture " + id_ + " updated");
+        if (OgreRenderingModule::IsLogEnabled(Poco::Message::PRIO_DEBUG))
+            OgreRenderingModule::LogDebug("Ogre texture " + id_ + " updated");
         level_ = source->GetLevel();
         return true;
     }
@@ -81,6 +81,9 @@ namespace OgreRenderer
         
         //! Texture quality
         TextureQuality texturequality_;
+
+        //! Mipmap levels uploaded from the source texture, 0 if Ogre generated them
+        uint uploaded_mips_;
     };
 }
 #endif
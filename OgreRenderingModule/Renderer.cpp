@@ -15,6 +15,9 @@
 #include "NaaliGraphicsView.h"
 #include "OgreShadowCameraSetupFocusedPSSM.h"
 #include "CompositionHandler.h"
+#include "LabelAtlas.h"
+#include "TextureResidency.h"
+#include "StaticBatcher.h"
 
 #include "SceneManager.h"
 #include "SceneEvents.h"
@@ -75,9 +78,25 @@ namespace OgreRenderer
         virtual bool renderableQueued(Ogre::Renderable* rend, Ogre::uint8 groupID,
             Ogre::ushort priority, Ogre::Technique** ppTech, Ogre::RenderQueue* pQueue)
         {
+            if (ppTech && *ppTech)
+                renderer_->visible_techniques_.insert(*ppTech);
+
             Ogre::Any any = rend->getUserAny();
             if (any.isEmpty())
                 return true;
+
+            // Renderables of static geometry draw several entities
+            if (any.getType() == typeid(StaticBatcher::BatchedEntities*))
+            {
+                StaticBatcher::BatchedEntities *batched = Ogre::any_cast<StaticBatcher::BatchedEntities*>(any);
+                unsigned long frame = Ogre::Root::getSingleton().getNextFrameNumber();
+                if (batched->frame != frame)
+                {
+                    batched->frame = frame;
+                    renderer_->visible_entities_.insert(batched->ids.begin(), batched->ids.end());
+                }
+                return true;
+            }
             
             Scene::Entity *entity = 0;
             try
@@ -150,7 +169,10 @@ namespace OgreRenderer
         view_distance_(500.0),
         shadowquality_(Shadows_High),
         texturequality_(Texture_Normal),
-        c_handler_(new CompositionHandler)
+        c_handler_(new CompositionHandler),
+        label_atlas_(0),
+        texture_residency_(0),
+        static_batcher_(0)
     {
         InitializeEvents();
     }
@@ -177,6 +199,9 @@ namespace OgreRenderer
         foreach(GaussianListener* listener, gaussianListeners_)
             SAFE_DELETE(listener);
 
+        SAFE_DELETE(label_atlas_);
+        SAFE_DELETE(texture_residency_);
+        SAFE_DELETE(static_batcher_);
         resource_handler_.reset();
         root_.reset();
         SAFE_DELETE(c_handler_);
@@ -248,6 +273,9 @@ namespace OgreRenderer
         texturequality_ = (TextureQuality)(framework_->GetDefaultConfig().DeclareSetting<int>(
             "OgreRenderer","texture_quality", 1));
 
+        texture_residency_ = new TextureResidency(resource_handler_.get(), framework_);
+        static_batcher_ = new StaticBatcher(this, framework_);
+
         // Ask Ogre if rendering system is available
         rendersystem = root_->getRenderSystemByName(rendersystem_name);
 
@@ -462,8 +490,25 @@ namespace OgreRenderer
     void Renderer::Update(f64 frametime)
     {
         Ogre::WindowEventUtilities::messagePump();
+
+        resource_handler_->CancelAbandonedRequests();
+        if (texture_residency_)
+            texture_residency_->Update(frametime);
+        if (static_batcher_)
+            static_batcher_->Update(frametime);
     }
     
+    LabelAtlas *Renderer::GetLabelAtlas()
+    {
+        if (!label_atlas_ && initialized_ && scenemanager_)
+        {
+            int page_size = framework_->GetDefaultConfig().DeclareSetting("OgreRenderer", "label_atlas_size", 1024);
+            label_atlas_ = new LabelAtlas(this, page_size);
+            label_atlas_->SetLabelScale(framework_->GetDefaultConfig().DeclareSetting("OgreRenderer", "label_scale", 0.5f));
+        }
+        return label_atlas_;
+    }
+
     void Renderer::SetCurrentCamera(Ogre::Camera* camera)
     {
         if (!camera)
@@ -670,8 +715,9 @@ namespace OgreRenderer
         if (resized_dirty_ > 0)
             resized_dirty_--;
 
-        // The RenderableListener will fill in visible entities for this frame
+        // The RenderableListener will fill in visible entities and techniques for this frame
         visible_entities_.clear();
+        visible_techniques_.clear();
 
 #ifdef PROFILING
         // Performance debugging: Toggle the UI overlay visibility based on a debug key.
@@ -684,6 +730,11 @@ namespace OgreRenderer
 
         root_->renderOneFrame();
         view->MarkViewUndirty();
+
+        // Techniques may be destroyed before the next frame, so use them right away
+        if (texture_residency_)
+            texture_residency_->MarkUsed(visible_techniques_);
+        visible_techniques_.clear();
     }
 
     uint GetSubmeshFromIndexRange(uint index, const std::vector<uint>& submeshstartindex)
@@ -1094,6 +1145,11 @@ namespace OgreRenderer
         return resource_handler_->RequestResource(id, type);
     }
 
+    void Renderer::CancelResourceRequest(const std::string& id, const std::string& type, request_tag_t tag)
+    {
+        resource_handler_->CancelResourceRequest(id, type, tag);
+    }
+
     void Renderer::RemoveResource(const std::string& id, const std::string& type)
     {
         return resource_handler_->RemoveResource(id, type);
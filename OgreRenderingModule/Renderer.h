@@ -44,6 +44,9 @@ namespace OgreRenderer
     class StereoController;
     class CompositionHandler;
     class GaussianListener;
+    class LabelAtlas;
+    class TextureResidency;
+    class StaticBatcher;
 
     typedef boost::shared_ptr<Ogre::Root> OgreRootPtr;
     typedef boost::shared_ptr<LogListener> OgreLogListenerPtr;
@@ -148,6 +151,14 @@ namespace OgreRenderer
          */
         virtual request_tag_t RequestResource(const std::string& id, const std::string& type);
 
+        //! Tells that a renderer-specific resource request is no longer needed
+        /*! No RESOURCE_READY event is sent for the tag. The download is stopped if no other request waits for it.
+            \param id Resource id
+            \param type Resource type
+            \param tag Request tag returned by RequestResource
+         */
+        virtual void CancelResourceRequest(const std::string& id, const std::string& type, request_tag_t tag);
+
         //! Removes a renderer-specific resource
         /*! \param id Resource id
             \param type Resource type
@@ -213,6 +224,20 @@ namespace OgreRenderer
         //! returns the composition handler responsible of the post-processing effects
         CompositionHandler *GetCompositionHandler() const { return c_handler_; }
 
+        //! Returns the shared texture atlas for hovering texts and chat bubbles, creates it on first use.
+        /*! Returns null if the renderer is not initialized.
+         */
+        LabelAtlas *GetLabelAtlas();
+
+        //! Returns the label atlas if it has been created, null otherwise
+        LabelAtlas *GetExistingLabelAtlas() const { return label_atlas_; }
+
+        //! Returns the texture memory budget, null if the renderer is not initialized
+        TextureResidency *GetTextureResidency() const { return texture_residency_; }
+
+        //! Returns the static geometry batcher
+        StaticBatcher *GetStaticBatcher() const { return static_batcher_; }
+
         //! Returns shadow quality
         ShadowQuality GetShadowQuality() const { return shadowquality_; }
 
@@ -330,6 +355,15 @@ namespace OgreRenderer
         //! handler for post-processing effects
         CompositionHandler *c_handler_;
 
+        //! Label atlas, created on first use
+        LabelAtlas *label_atlas_;
+
+        //! Texture memory budget
+        TextureResidency *texture_residency_;
+
+        //! Draws static entities that share materials with static geometry
+        StaticBatcher *static_batcher_;
+
         //! last width/height
         int last_height_;
         int last_width_;
@@ -345,6 +379,9 @@ namespace OgreRenderer
         //! Visible entities
         std::set<entity_id_t> visible_entities_;
 
+        //! Techniques rendered in the current frame, for tracking texture use
+        std::set<Ogre::Technique*> visible_techniques_;
+
         //! Shadow quality
         ShadowQuality shadowquality_;
 
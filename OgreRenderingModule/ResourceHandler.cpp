@@ -18,6 +18,9 @@
 #include "Framework.h"
 #include "EventManager.h"
 #include "ServiceManager.h"
+#include "ConfigurationManager.h"
+
+#include <algorithm>
 
 
 namespace OgreRenderer
@@ -32,6 +35,8 @@ namespace OgreRenderer
         source_types_[OgreMaterialResource::GetTypeStatic()] = RexTypes::ASSETTYPENAME_MATERIAL_SCRIPT;
         source_types_[OgreParticleResource::GetTypeStatic()] = RexTypes::ASSETTYPENAME_PARTICLE_SCRIPT;
         source_types_[OgreImageTextureResource::GetTypeStatic()] = RexTypes::ASSETTYPENAME_IMAGE;
+
+        use_material_templates_ = framework_->GetDefaultConfig().DeclareSetting("OgreRenderer", "material_templates", true);
     }
 
     ResourceHandler::~ResourceHandler()
@@ -115,7 +120,12 @@ namespace OgreRenderer
         else
         {
             if (i->second->GetType() == type)
+            {
                 resources_.erase(i);
+                reducing_.erase(id);
+                reduced_.erase(id);
+                restoring_.erase(id);
+            }
             else
             {
                 OgreRenderingModule::LogWarning("Attempted to remove resource " + id + " with mismatching type " + type + ", real type is " + i->second->GetType());
@@ -123,6 +133,67 @@ namespace OgreRenderer
         }
     }
     
+    void ResourceHandler::CancelResourceRequest(const std::string& id, const std::string& type, request_tag_t tag)
+    {
+        std::map<std::string, RequestTagVector>::iterator i = request_tags_.find(id);
+        if (i == request_tags_.end())
+            return;
+
+        RequestTagVector& tags = i->second;
+        RequestTagVector::iterator j = std::find(tags.begin(), tags.end(), tag);
+        if (j == tags.end())
+            return;
+        tags.erase(j);
+
+        // Keep the entry, so that a new request in the same frame does not make a new source request
+        if (tags.empty())
+            abandoned_[id] = type;
+    }
+
+    void ResourceHandler::CancelAbandonedRequests()
+    {
+        if (abandoned_.empty())
+            return;
+
+        ServiceManagerPtr service_manager = framework_->GetServiceManager();
+        std::map<std::string, std::string>::const_iterator i = abandoned_.begin();
+        while (i != abandoned_.end())
+        {
+            const std::string& id = i->first;
+            std::map<std::string, RequestTagVector>::iterator tags = request_tags_.find(id);
+            std::map<std::string, request_tag_t>::iterator source = source_tags_.find(id);
+            // Requested again, already received, or only waiting for its references
+            if (tags == request_tags_.end() || !tags->second.empty() || source == source_tags_.end() ||
+                expected_request_tags_.find(source->second) == expected_request_tags_.end())
+            {
+                ++i;
+                continue;
+            }
+
+            if (i->second == OgreTextureResource::GetTypeStatic())
+            {
+                boost::shared_ptr<Foundation::TextureServiceInterface> texture_service =
+                    service_manager->GetService<Foundation::TextureServiceInterface>(Service::ST_Texture).lock();
+                if (texture_service)
+                    texture_service->CancelTextureRequest(id, source->second);
+            }
+            else
+            {
+                boost::shared_ptr<Foundation::AssetServiceInterface> asset_service =
+                    service_manager->GetService<Foundation::AssetServiceInterface>(Service::ST_Asset).lock();
+                if (asset_service)
+                    asset_service->CancelAssetRequest(id, source->second);
+            }
+
+            OgreRenderingModule::LogDebug("Canceled request for unneeded resource " + id);
+            expected_request_tags_.erase(source->second);
+            source_tags_.erase(source);
+            request_tags_.erase(tags);
+            ++i;
+        }
+        abandoned_.clear();
+    }
+
     std::vector<Foundation::ResourcePtr> ResourceHandler::GetResources(const std::string& type)
     {
         std::vector<Foundation::ResourcePtr> resources;
@@ -180,6 +251,7 @@ namespace OgreRenderer
                     framework_->GetEventManager()->SendEvent(resource_event_category_, Resource::Events::RESOURCE_CANCELED, &canceled_event_data);
                 }
                 request_tags_.erase(event_data->asset_id_);
+                source_tags_.erase(event_data->asset_id_);
                 
                 // Check if the asset matches outstanding resource references
                 std::map<std::string, Foundation::ResourceReferenceVector>::iterator i = outstanding_references_.begin();
@@ -217,11 +289,26 @@ namespace OgreRenderer
                 {
                     // Check that the request tag matches our request, so we do not (possibly) update unnecessarily many times
                     // because of others' requests
-                    if (expected_request_tags_.find(event_data->tag_) != expected_request_tags_.end())
+                    if (reduce_tags_.find(event_data->tag_) != reduce_tags_.end())
+                        UpdateReducedTexture(event_data->resource_, event_data->tag_);
+                    else if (expected_request_tags_.find(event_data->tag_) != expected_request_tags_.end())
                         UpdateTexture(event_data->resource_, event_data->tag_);
                 }
             }
         }
+        
+        if (event_id == Resource::Events::RESOURCE_CANCELED)
+        {
+            Resource::Events::ResourceCanceled *event_data = checked_static_cast<Resource::Events::ResourceCanceled*>(data);
+            std::map<request_tag_t, std::string>::iterator i = reduce_tags_.find(event_data->tag_);
+            if (i != reduce_tags_.end())
+            {
+                std::map<std::string, request_tag_t>::iterator j = reducing_.find(i->second);
+                if (j != reducing_.end() && j->second == i->first)
+                    reducing_.erase(j);
+                reduce_tags_.erase(i);
+            }
+        }
 
         return false;
     }
@@ -291,6 +378,7 @@ namespace OgreRenderer
                 if (source_tag)
                 {
                     expected_request_tags_.insert(source_tag);
+                    source_tags_[id] = source_tag;
                     request_tags_[id].push_back(tag); 
                     return tag;
                 }
@@ -320,7 +408,13 @@ namespace OgreRenderer
 
         // If highest level, erase texture decode request tag (should not get more raw resource events for this texture)
         if (source_tex->GetLevel() == 0)
+        {
             expected_request_tags_.erase(tag);
+            source_tags_.erase(source_tex->GetId());
+            reducing_.erase(source_tex->GetId());
+            reduced_.erase(source_tex->GetId());
+            restoring_.erase(source_tex->GetId());
+        }
 
         // If success, send Ogre resource ready event
         bool success = false;
@@ -348,6 +442,85 @@ namespace OgreRenderer
         return success;
     }    
 
+    bool ResourceHandler::UpdateReducedTexture(Foundation::ResourcePtr source, request_tag_t tag)
+    {
+        std::map<request_tag_t, std::string>::iterator i = reduce_tags_.find(tag);
+        std::string id = i->second;
+        reduce_tags_.erase(i);
+
+        // Ignore results of reductions that have been superseded by a restore or a newer reduction
+        std::map<std::string, request_tag_t>::iterator j = reducing_.find(id);
+        if (j == reducing_.end() || j->second != tag)
+            return false;
+        reducing_.erase(j);
+
+        Foundation::TexturePtr source_tex = boost::shared_dynamic_cast<Foundation::TextureInterface>(source);
+        if (!source_tex || !source_tex->GetLevel())
+            return false;
+
+        // Only replace full quality textures that nobody is waiting for
+        Foundation::ResourcePtr tex = GetResourceInternal(id, OgreTextureResource::GetTypeStatic());
+        if (!tex || tex->GetType() != OgreTextureResource::GetTypeStatic() || IsTextureLoading(id))
+            return false;
+        OgreTextureResource* tex_res = checked_static_cast<OgreTextureResource*>(tex.get());
+        if (tex_res->GetLevel() != 0)
+            return false;
+
+        if (!tex_res->SetData(source_tex))
+            return false;
+
+        reduced_.insert(id);
+        return true;
+    }
+
+    bool ResourceHandler::ReduceTexture(const std::string& id, int level)
+    {
+        if (level <= 0 || IsReducing(id) || IsTextureLoading(id))
+            return false;
+
+        boost::shared_ptr<Foundation::TextureServiceInterface> texture_service = 
+            framework_->GetServiceManager()->GetService<Foundation::TextureServiceInterface>(Service::ST_Texture).lock();
+        if (!texture_service)
+            return false;
+
+        request_tag_t tag = texture_service->RequestTextureLevel(id, level);
+        if (!tag)
+            return false;
+
+        reduce_tags_[tag] = id;
+        reducing_[id] = tag;
+        return true;
+    }
+
+    bool ResourceHandler::RestoreTexture(const std::string& id)
+    {
+        // A reduction still being decoded is dropped when it arrives
+        reducing_.erase(id);
+        if (reduced_.find(id) == reduced_.end() || IsRestoring(id))
+            return false;
+
+        if (!IsTextureLoading(id))
+        {
+            boost::shared_ptr<Foundation::TextureServiceInterface> texture_service = 
+                framework_->GetServiceManager()->GetService<Foundation::TextureServiceInterface>(Service::ST_Texture).lock();
+            if (!texture_service)
+                return false;
+
+            request_tag_t source_tag = texture_service->RequestTexture(id);
+            if (!source_tag)
+                return false;
+            expected_request_tags_.insert(source_tag);
+        }
+
+        restoring_.insert(id);
+        return true;
+    }
+
+    bool ResourceHandler::IsReduced(const std::string& id) const
+    {
+        return reduced_.find(id) != reduced_.end() || reducing_.find(id) != reducing_.end();
+    }
+
     request_tag_t ResourceHandler::RequestOtherResource(const std::string& id, const std::string& type)
     {
         if (source_types_.find(type) == source_types_.end())
@@ -377,6 +550,7 @@ namespace OgreRenderer
                 {
                     request_tags_[id].push_back(tag);
                     expected_request_tags_.insert(source_tag);
+                    source_tags_[id] = source_tag;
                     return tag;
                 }
             }
@@ -393,6 +567,7 @@ namespace OgreRenderer
     bool ResourceHandler::UpdateMesh(Foundation::AssetPtr source, request_tag_t tag)
     {    
         expected_request_tags_.erase(tag);
+        source_tags_.erase(source->GetId());
             
         // If not found, prepare new
         Foundation::ResourcePtr mesh = GetResourceInternal(source->GetId(), OgreMeshResource::GetTypeStatic());
@@ -419,6 +594,7 @@ namespace OgreRenderer
     bool ResourceHandler::UpdateImageTexture(Foundation::AssetPtr source, request_tag_t tag)
     {    
         expected_request_tags_.erase(tag);
+        source_tags_.erase(source->GetId());
             
         // If not found, prepare new
         Foundation::ResourcePtr tex = GetResourceInternal(source->GetId(), OgreImageTextureResource::GetTypeStatic());
@@ -445,6 +621,7 @@ namespace OgreRenderer
     bool ResourceHandler::UpdateMaterial(Foundation::AssetPtr source, request_tag_t tag)
     {    
         expected_request_tags_.erase(tag);
+        source_tags_.erase(source->GetId());
             
         // If not found, prepare new
         Foundation::ResourcePtr material = GetResourceInternal(source->GetId(), OgreMaterialResource::GetTypeStatic());
@@ -458,7 +635,7 @@ namespace OgreRenderer
 
         // If data successfully set, or already have valid data, success; check resource references if any
         StringVector tex_names;
-        if ((material_res->IsValid()) || (material_res->SetData(source)))
+        if ((material_res->IsValid()) || (material_res->SetData(source, use_material_templates_ ? &material_templates_ : 0)))
         {
             resources_[source->GetId()] = material;
             ProcessResourceReferences(material);
@@ -472,6 +649,7 @@ namespace OgreRenderer
     bool ResourceHandler::UpdateParticles(Foundation::AssetPtr source, request_tag_t tag)
     {
         expected_request_tags_.erase(tag);
+        source_tags_.erase(source->GetId());
         
         // If not found, prepare new
         Foundation::ResourcePtr particle = GetResourceInternal(source->GetId(), OgreParticleResource::GetTypeStatic());
@@ -499,6 +677,7 @@ namespace OgreRenderer
     bool ResourceHandler::UpdateSkeleton(Foundation::AssetPtr source, request_tag_t tag)
     {    
         expected_request_tags_.erase(tag);
+        source_tags_.erase(source->GetId());
             
         // If not found, prepare new
         Foundation::ResourcePtr skeleton = GetResourceInternal(source->GetId(), OgreSkeletonResource::GetTypeStatic());
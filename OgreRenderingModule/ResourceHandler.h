@@ -6,6 +6,7 @@
 #include "ResourceInterface.h"
 #include "AssetInterface.h"
 #include "OgreModuleApi.h"
+#include "MaterialTemplateCache.h"
 
 namespace OgreRenderer
 {
@@ -30,6 +31,15 @@ namespace OgreRenderer
         
         //! Remove a renderer-specific resource. Called by Renderer
         void RemoveResource(const std::string& id, const std::string& type);
+
+        //! Tells that a resource request is no longer needed. Called by Renderer
+        /*! No RESOURCE_READY event is sent for the tag. If no other request waits for the resource, its download or
+            decode is canceled on the next frame, so that a request made again in the same frame keeps it going.
+         */
+        void CancelResourceRequest(const std::string& id, const std::string& type, request_tag_t tag);
+
+        //! Cancels the downloads and decodes of resources that no request has needed since the last frame. Called by Renderer
+        void CancelAbandonedRequests();
         
         //! Get all loaded resources of certain type
         std::vector<Foundation::ResourcePtr> GetResources(const std::string& type);
@@ -42,6 +52,36 @@ namespace OgreRenderer
         
         //! Internal method to parse braces from an Ogre script. Returns true if line contained open/close brace
         static bool ProcessBraces(const std::string& line, int& brace_level);
+
+        //! Replaces a full quality texture with a lower quality level decoded again from the texture asset. Called by TextureResidency
+        /*! \param id Resource ID, same as asset ID
+            \param level Quality level to decode, 1 or higher
+            \return true if the decode was queued
+         */
+        bool ReduceTexture(const std::string& id, int level);
+
+        //! Requests a reduced texture at full quality again. Called by TextureResidency
+        /*! \return true if the request was made
+         */
+        bool RestoreTexture(const std::string& id);
+
+        //! Returns true if the texture has been reduced, or a reduction is being decoded
+        bool IsReduced(const std::string& id) const;
+
+        //! Returns true if a reduction of the texture is being decoded
+        bool IsReducing(const std::string& id) const { return reducing_.find(id) != reducing_.end(); }
+
+        //! Returns true if the texture is being restored to full quality
+        bool IsRestoring(const std::string& id) const { return restoring_.find(id) != restoring_.end(); }
+
+        //! Returns true if the texture is being received or decoded for a request
+        bool IsTextureLoading(const std::string& id) const { return request_tags_.find(id) != request_tags_.end(); }
+
+        //! Returns the templates materials are cloned from
+        const MaterialTemplateCache& GetMaterialTemplates() const { return material_templates_; }
+
+        //! Returns true if materials are cloned from templates
+        bool GetUseMaterialTemplates() const { return use_material_templates_; }
         
     private:
         //! Get a renderer-specific resource, without caring if it is valid
@@ -68,6 +108,13 @@ namespace OgreRenderer
          */
         bool UpdateTexture(Foundation::ResourcePtr source, request_tag_t tag);
 
+        //! Updates a texture with a reduced quality level decoded for ReduceTexture
+        /*! \param source Raw texture
+            \param tag Request tag from raw texture resource event
+            \return true if successful
+         */
+        bool UpdateReducedTexture(Foundation::ResourcePtr source, request_tag_t tag);
+
         //! Creates or updates a mesh, based on source asset data
         /*! \param source Asset
             \param tag Request tag from asset event
@@ -127,6 +174,12 @@ namespace OgreRenderer
         
         //! Map of resource request tags by resource
         std::map<std::string, RequestTagVector> request_tags_;
+
+        //! Request tags of the asset or texture decoder requests made for resource requests, by resource
+        std::map<std::string, request_tag_t> source_tags_;
+
+        //! Types of the resources whose last request was canceled, by resource
+        std::map<std::string, std::string> abandoned_;
         
         //! Map of source asset types by renderer resource type
         std::map<std::string, std::string> source_types_;
@@ -136,6 +189,24 @@ namespace OgreRenderer
         
         //! Map of outstanding reference requests per resource
         std::map<std::string, Foundation::ResourceReferenceVector> outstanding_references_;
+
+        //! Texture ids of reduction decodes by request tag
+        std::map<request_tag_t, std::string> reduce_tags_;
+
+        //! Request tags of reduction decodes by texture id
+        std::map<std::string, request_tag_t> reducing_;
+
+        //! Textures at a reduced quality level
+        std::set<std::string> reduced_;
+
+        //! Reduced textures being restored to full quality
+        std::set<std::string> restoring_;
+
+        //! Parsed material scripts that materials with the same script are cloned from
+        MaterialTemplateCache material_templates_;
+
+        //! Whether materials are cloned from templates
+        bool use_material_templates_;
         
         //! Framework we belong to
         Foundation::Framework* framework_;
@@ -0,0 +1,515 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+
+#include "StableHeaders.h"
+#include "StaticBatcher.h"
+#include "Renderer.h"
+#include "OgreRenderingModule.h"
+#include "Entity.h"
+#include "Framework.h"
+#include "ConfigurationManager.h"
+#include "Profiler.h"
+#include "HighPerfClock.h"
+
+#include <Ogre.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    //! Seconds between assigning still entities to cells
+    const f64 cAssignInterval = 1.0;
+
+    //! Entities that must use a material for it to save batches
+    const uint cMinSharing = 2;
+}
+
+namespace OgreRenderer
+{
+    bool StaticBatcher::CellKey::operator <(const CellKey &rhs) const
+    {
+        if (x != rhs.x)
+            return x < rhs.x;
+        if (y != rhs.y)
+            return y < rhs.y;
+        if (z != rhs.z)
+            return z < rhs.z;
+        if (castShadows != rhs.castShadows)
+            return castShadows < rhs.castShadows;
+        return drawDistance < rhs.drawDistance;
+    }
+
+    bool StaticBatcher::CellKey::operator ==(const CellKey &rhs) const
+    {
+        return x == rhs.x && y == rhs.y && z == rhs.z && castShadows == rhs.castShadows && drawDistance == rhs.drawDistance;
+    }
+
+    StaticBatcher::StaticBatcher(Renderer *renderer, Foundation::Framework *framework) :
+        renderer_(renderer),
+        building_(false),
+        time_(0.0),
+        checkTime_(0.0)
+    {
+        Foundation::ConfigurationManager &config = framework->GetDefaultConfig();
+        enabled_ = config.DeclareSetting("OgreRenderer", "static_batching", true);
+        cellSize_ = config.DeclareSetting("OgreRenderer", "static_batch_cell_size", 32.0f);
+        if (cellSize_ < 1.0f)
+            cellSize_ = 1.0f;
+        delay_ = config.DeclareSetting("OgreRenderer", "static_batch_delay", 5.0f);
+        int maxRebuilds = config.DeclareSetting("OgreRenderer", "static_batch_max_rebuilds", 2);
+        maxRebuilds_ = maxRebuilds > 0 ? maxRebuilds : 1;
+    }
+
+    StaticBatcher::~StaticBatcher()
+    {
+        for(CellMap::iterator i = cells_.begin(); i != cells_.end(); ++i)
+            DestroyGeometry(i->second);
+        for(MemberMap::iterator i = members_.begin(); i != members_.end(); ++i)
+            if (i->first->getListener() == this)
+                i->first->setListener(0);
+    }
+
+    void StaticBatcher::AddEntity(Ogre::Entity *entity)
+    {
+        if (!entity)
+            return;
+
+        if (entity->getListener() && entity->getListener() != this)
+        {
+            OgreRenderingModule::LogWarning("Entity " + entity->getName() + " already has a listener, it will not be batched");
+            return;
+        }
+
+        entity->setListener(this);
+        Member &member = members_[entity];
+        member.lastChange = time_;
+    }
+
+    void StaticBatcher::RemoveEntity(Ogre::Entity *entity)
+    {
+        MemberMap::iterator i = members_.find(entity);
+        if (i == members_.end())
+            return;
+
+        Unassign(entity, i->second);
+        members_.erase(i);
+        if (entity->getListener() == this)
+            entity->setListener(0);
+    }
+
+    void StaticBatcher::EntityChanged(Ogre::Entity *entity)
+    {
+        OnEntityChanged(entity);
+    }
+
+    void StaticBatcher::Update(f64 frametime)
+    {
+        time_ += frametime;
+        if (!enabled_)
+            return;
+
+        CheckVisibility();
+
+        checkTime_ += frametime;
+        if (checkTime_ >= cAssignInterval)
+        {
+            checkTime_ = 0.0;
+            PROFILE(StaticBatcher_AssignEntities);
+            AssignEntities();
+        }
+
+        if (dirty_.empty())
+            return;
+
+        PROFILE(StaticBatcher_RebuildCells);
+        uint rebuilt = 0;
+        while(!dirty_.empty() && rebuilt < maxRebuilds_)
+        {
+            CellKey key = *dirty_.begin();
+            dirty_.erase(dirty_.begin());
+            CellMap::iterator i = cells_.find(key);
+            if (i == cells_.end())
+                continue;
+
+            RebuildCell(key, i->second);
+            ++rebuilt;
+            if (i->second.entities.empty() && !i->second.geometry)
+                cells_.erase(i);
+        }
+    }
+
+    void StaticBatcher::SetEnabled(bool enabled)
+    {
+        if (enabled == enabled_)
+            return;
+        enabled_ = enabled;
+        if (enabled_)
+            return;
+
+        for(CellMap::iterator i = cells_.begin(); i != cells_.end(); ++i)
+            DestroyGeometry(i->second);
+        for(MemberMap::iterator i = members_.begin(); i != members_.end(); ++i)
+        {
+            i->second.cell = 0;
+            i->second.materials.clear();
+        }
+        cells_.clear();
+        dirty_.clear();
+    }
+
+    StaticBatcher::Stats StaticBatcher::GetStats() const
+    {
+        Stats stats = stats_;
+        stats.entities = members_.size();
+        stats.pending = dirty_.size();
+        for(CellMap::const_iterator i = cells_.begin(); i != cells_.end(); ++i)
+        {
+            const Cell &cell = i->second;
+            if (!cell.geometry || cell.batched.empty())
+                continue;
+            ++stats.cells;
+            stats.batches += cell.batches;
+            stats.batched += cell.batched.size();
+        }
+        return stats;
+    }
+
+    void StaticBatcher::objectDestroyed(Ogre::MovableObject *object)
+    {
+        Ogre::Entity *entity = static_cast<Ogre::Entity *>(object);
+        MemberMap::iterator i = members_.find(entity);
+        if (i == members_.end())
+            return;
+
+        Unassign(entity, i->second, true);
+        members_.erase(i);
+        object->setListener(0);
+    }
+
+    void StaticBatcher::objectAttached(Ogre::MovableObject *object)
+    {
+        OnEntityChanged(static_cast<Ogre::Entity *>(object));
+    }
+
+    void StaticBatcher::objectDetached(Ogre::MovableObject *object)
+    {
+        OnEntityChanged(static_cast<Ogre::Entity *>(object));
+    }
+
+    void StaticBatcher::objectMoved(Ogre::MovableObject *object)
+    {
+        OnEntityChanged(static_cast<Ogre::Entity *>(object));
+    }
+
+    bool StaticBatcher::IsBatchable(Ogre::Entity *entity) const
+    {
+        if (!entity->isInScene() || !entity->getParentSceneNode() || !entity->getVisible())
+            return false;
+        // The static geometry is drawn with the default visibility flags
+        if (entity->getVisibilityFlags() != Ogre::MovableObject::getDefaultVisibilityFlags())
+            return false;
+        if (entity->hasSkeleton() || entity->hasVertexAnimation() || entity->getRenderQueueGroup() != Ogre::RENDER_QUEUE_MAIN)
+            return false;
+
+        for(uint i = 0; i < entity->getNumSubEntities(); ++i)
+        {
+            const Ogre::MaterialPtr &material = entity->getSubEntity(i)->getMaterial();
+            // Static geometry sorts by batch, not by entity, which would break the back to front order of transparent objects
+            if (material.isNull() || material->isTransparent())
+                return false;
+        }
+        return entity->getNumSubEntities() > 0;
+    }
+
+    StaticBatcher::CellKey StaticBatcher::GetCellKey(Ogre::Entity *entity) const
+    {
+        const Ogre::Vector3 &position = entity->getParentSceneNode()->_getDerivedPosition();
+        CellKey key;
+        key.x = (int)floor(position.x / cellSize_);
+        key.y = (int)floor(position.y / cellSize_);
+        key.z = (int)floor(position.z / cellSize_);
+        key.castShadows = entity->getCastShadows();
+        key.drawDistance = entity->getRenderingDistance();
+        return key;
+    }
+
+    bool StaticBatcher::HasMaterialsChanged(Ogre::Entity *entity, const Member &member) const
+    {
+        if (member.materials.size() != entity->getNumSubEntities())
+            return true;
+        for(uint i = 0; i < member.materials.size(); ++i)
+            if (entity->getSubEntity(i)->getMaterial().getPointer() != member.materials[i])
+                return true;
+        return false;
+    }
+
+    void StaticBatcher::AssignEntities()
+    {
+        for(MemberMap::iterator i = members_.begin(); i != members_.end(); ++i)
+        {
+            Ogre::Entity *entity = i->first;
+            Member &member = i->second;
+
+            if (member.cell)
+            {
+                // Moves are noticed by the listener, and changes made by the components through EntityChanged. Check
+                // for other changes when the cell has been built.
+                if (dirty_.find(member.key) != dirty_.end())
+                    continue;
+                if (HasMaterialsChanged(entity, member) || entity->getCastShadows() != member.key.castShadows ||
+                    entity->getRenderingDistance() != member.key.drawDistance)
+                {
+                    member.lastChange = time_;
+                    Unassign(entity, member);
+                }
+                continue;
+            }
+
+            if (time_ - member.lastChange < delay_ || !IsBatchable(entity))
+                continue;
+
+            // Reading the position updates the scene node, which notifies the entity if it has just moved
+            member.key = GetCellKey(entity);
+            if (member.lastChange == time_)
+                continue;
+            Cell &cell = cells_[member.key];
+            cell.entities.insert(entity);
+            member.cell = &cell;
+            dirty_.insert(member.key);
+        }
+    }
+
+    void StaticBatcher::Unassign(Ogre::Entity *entity, Member &member, bool destroyed)
+    {
+        Cell *cell = member.cell;
+        if (!cell)
+            return;
+
+        cell->entities.erase(entity);
+        if (member.batched)
+        {
+            std::vector<Ogre::Entity *>::iterator i = std::find(cell->batched.begin(), cell->batched.end(), entity);
+            if (i != cell->batched.end())
+                cell->batched.erase(i);
+            if (!destroyed)
+                ShowEntity(entity, member);
+            member.batched = false;
+            BreakCell(member.key, *cell);
+        }
+
+        member.cell = 0;
+        member.materials.clear();
+    }
+
+    void StaticBatcher::BreakCell(const CellKey &key, Cell &cell)
+    {
+        if (cell.geometry)
+            cell.geometry->setVisible(false);
+        for(uint i = 0; i < cell.batched.size(); ++i)
+        {
+            MemberMap::iterator j = members_.find(cell.batched[i]);
+            if (j != members_.end())
+                ShowEntity(cell.batched[i], j->second);
+        }
+        cell.batched.clear();
+        dirty_.insert(key);
+    }
+
+    void StaticBatcher::CheckVisibility()
+    {
+        for(CellMap::iterator i = cells_.begin(); i != cells_.end(); ++i)
+        {
+            Cell &cell = i->second;
+            if (!cell.geometry || !cell.geometry->isVisible())
+                continue;
+            for(uint j = 0; j < cell.batched.size(); ++j)
+            {
+                if (!cell.batched[j]->getVisible())
+                {
+                    BreakCell(i->first, cell);
+                    break;
+                }
+            }
+        }
+    }
+
+    void StaticBatcher::ShowEntity(Ogre::Entity *entity, Member &member)
+    {
+        if (!member.batched)
+            return;
+        entity->setVisibilityFlags(member.visibilityFlags);
+        member.batched = false;
+    }
+
+    void StaticBatcher::DestroyGeometry(Cell &cell)
+    {
+        for(uint i = 0; i < cell.batched.size(); ++i)
+        {
+            MemberMap::iterator j = members_.find(cell.batched[i]);
+            if (j != members_.end())
+                ShowEntity(cell.batched[i], j->second);
+        }
+        cell.batched.clear();
+        cell.batchedEntities.ids.clear();
+
+        if (cell.geometry)
+        {
+            Ogre::SceneManager *scene_mgr = renderer_->GetSceneManager();
+            if (scene_mgr)
+                scene_mgr->destroyStaticGeometry(cell.geometry);
+            cell.geometry = 0;
+            cell.batches = 0;
+        }
+    }
+
+    void StaticBatcher::RebuildCell(const CellKey &key, Cell &cell)
+    {
+        tick_t start = GetCurrentClockTime();
+        DestroyGeometry(cell);
+        building_ = true;
+
+        // Entities that still belong to the cell, and how many of them use each material
+        std::vector<Ogre::Entity *> candidates;
+        std::vector<Ogre::Entity *> leaving;
+        std::map<Ogre::Material *, uint> users;
+        for(std::set<Ogre::Entity *>::const_iterator i = cell.entities.begin(); i != cell.entities.end(); ++i)
+        {
+            Ogre::Entity *entity = *i;
+            if (!IsBatchable(entity) || !(GetCellKey(entity) == key))
+            {
+                leaving.push_back(entity);
+                continue;
+            }
+
+            Member &member = members_[entity];
+            member.materials.clear();
+            std::set<Ogre::Material *> used;
+            for(uint j = 0; j < entity->getNumSubEntities(); ++j)
+            {
+                Ogre::Material *material = entity->getSubEntity(j)->getMaterial().getPointer();
+                member.materials.push_back(material);
+                used.insert(material);
+            }
+            for(std::set<Ogre::Material *>::const_iterator j = used.begin(); j != used.end(); ++j)
+                ++users[*j];
+            candidates.push_back(entity);
+        }
+
+        for(uint i = 0; i < leaving.size(); ++i)
+        {
+            Member &member = members_[leaving[i]];
+            member.lastChange = time_;
+            Unassign(leaving[i], member);
+        }
+
+        // An entity whose materials are all its own would take as many batches in static geometry as by itself
+        std::vector<Ogre::Entity *> batch;
+        for(uint i = 0; i < candidates.size(); ++i)
+        {
+            const std::vector<Ogre::Material *> &materials = members_[candidates[i]].materials;
+            for(uint j = 0; j < materials.size(); ++j)
+            {
+                if (users[materials[j]] >= cMinSharing)
+                {
+                    batch.push_back(candidates[i]);
+                    break;
+                }
+            }
+        }
+
+        if (batch.size() >= cMinSharing)
+        {
+            Ogre::SceneManager *scene_mgr = renderer_->GetSceneManager();
+            try
+            {
+                cell.geometry = scene_mgr->createStaticGeometry(renderer_->GetUniqueObjectName());
+                // One region that covers the cell, with room for entities that reach over its edges
+                cell.geometry->setRegionDimensions(Ogre::Vector3(cellSize_ * 4.0f));
+                cell.geometry->setOrigin(Ogre::Vector3(key.x - 1.5f, key.y - 1.5f, key.z - 1.5f) * cellSize_);
+                cell.geometry->setCastShadows(key.castShadows);
+                cell.geometry->setRenderingDistance(key.drawDistance);
+
+                for(uint i = 0; i < batch.size(); ++i)
+                {
+                    Ogre::SceneNode *node = batch[i]->getParentSceneNode();
+                    cell.geometry->addEntity(batch[i], node->_getDerivedPosition(), node->_getDerivedOrientation(),
+                        node->_getDerivedScale());
+                }
+                cell.geometry->build();
+            }
+            catch (Ogre::Exception &e)
+            {
+                OgreRenderingModule::LogWarning("Could not build static geometry: " + std::string(e.what()));
+                if (cell.geometry)
+                    scene_mgr->destroyStaticGeometry(cell.geometry);
+                cell.geometry = 0;
+            }
+        }
+
+        if (cell.geometry)
+        {
+            for(uint i = 0; i < batch.size(); ++i)
+            {
+                // Hide with the visibility flags, so that the application can still hide and show the entity
+                Member &member = members_[batch[i]];
+                member.visibilityFlags = batch[i]->getVisibilityFlags();
+                member.batched = true;
+                batch[i]->setVisibilityFlags(0);
+
+                const Ogre::Any &any = batch[i]->getUserAny();
+                if (!any.isEmpty() && any.getType() == typeid(Scene::Entity *))
+                {
+                    Scene::Entity *entity = Ogre::any_cast<Scene::Entity *>(any);
+                    if (entity)
+                        cell.batchedEntities.ids.push_back(entity->GetId());
+                }
+            }
+            cell.batched = batch;
+
+            // Let the renderables of the cell tell Renderer which entities they draw, and count the batches drawn
+            // at full detail
+            Ogre::Any any(&cell.batchedEntities);
+            Ogre::StaticGeometry::RegionIterator regions = cell.geometry->getRegionIterator();
+            while(regions.hasMoreElements())
+            {
+                Ogre::StaticGeometry::Region::LODIterator lods = regions.getNext()->getLODIterator();
+                bool first_lod = true;
+                while(lods.hasMoreElements())
+                {
+                    Ogre::StaticGeometry::LODBucket::MaterialIterator materials = lods.getNext()->getMaterialIterator();
+                    while(materials.hasMoreElements())
+                    {
+                        Ogre::StaticGeometry::MaterialBucket::GeometryIterator geometries = materials.getNext()->getGeometryIterator();
+                        while(geometries.hasMoreElements())
+                        {
+                            geometries.getNext()->setUserAny(any);
+                            if (first_lod)
+                                ++cell.batches;
+                        }
+                    }
+                    first_lod = false;
+                }
+            }
+        }
+
+        building_ = false;
+
+        f64 time = (GetCurrentClockTime() - start) / (f64)GetCurrentClockFreq();
+        ++stats_.rebuilds;
+        stats_.rebuildTime += time;
+        stats_.lastRebuildTime = time;
+    }
+
+    void StaticBatcher::OnEntityChanged(Ogre::Entity *entity)
+    {
+        if (building_)
+            return;
+
+        MemberMap::iterator i = members_.find(entity);
+        if (i == members_.end())
+            return;
+
+        i->second.lastChange = time_;
+        Unassign(entity, i->second);
+    }
+}
@@ -0,0 +1,227 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+
+#ifndef incl_OgreRenderer_StaticBatcher_h
+#define incl_OgreRenderer_StaticBatcher_h
+
+#include "OgreModuleApi.h"
+#include "CoreTypes.h"
+
+#include <OgreMovableObject.h>
+
+#include <map>
+#include <set>
+#include <vector>
+
+namespace Foundation
+{
+    class Framework;
+}
+
+namespace OgreRenderer
+{
+    class Renderer;
+
+    //! Draws entities that do not move and share materials with Ogre::StaticGeometry, so that they take fewer batches.
+    /*! Prims (EC_OgreCustomObject) and meshes (EC_Mesh) add their Ogre entity when they attach it to their scene node.
+        An entity that has no skeleton or vertex animation and no transparent materials, and has not moved for a while,
+        is assigned to a cell of a uniform grid, separately for each cast shadows and draw distance setting. Each cell
+        is built into an Ogre::StaticGeometry of its own, which merges the geometry that uses the same material into one
+        batch. Only entities that share a material with another entity of the cell are built into it, as the others
+        would not save a batch. The batched entities are hidden by clearing their visibility flags, so that their own
+        visibility stays as the application sets it, and stay in their scene nodes so that raycasts and other scene
+        queries find them as before.
+
+        The batcher is the Ogre::MovableObject::Listener of the entities. When a batched entity moves or is detached,
+        the static geometry of its cell is hidden and the entities of the cell are shown, so the change is seen in
+        the same frame. The same happens when a batched entity is hidden, f.ex. with its scene node, and when the
+        components change the materials, shadow casting or draw distance of an entity and call EntityChanged.
+        Changed cells are then rebuilt, at most a few per frame; the other cells are not touched.
+
+        Owned by Renderer. Can be disabled with static_batching in the OgreRenderer configuration group, or with the
+        StaticBatching console command.
+     */
+    class OGRE_MODULE_API StaticBatcher : public Ogre::MovableObject::Listener
+    {
+    public:
+        //! Scene entities built into a cell. The renderables of the cell have a pointer to it as their user any.
+        struct BatchedEntities
+        {
+            BatchedEntities() : frame(0) {}
+            //! Scene entity ids
+            std::vector<entity_id_t> ids;
+            //! Ogre frame number when the ids were last added to the visible entities
+            unsigned long frame;
+        };
+
+        //! Batching statistics
+        struct Stats
+        {
+            Stats() : entities(0), batched(0), cells(0), batches(0), pending(0), rebuilds(0), rebuildTime(0.0),
+                lastRebuildTime(0.0) {}
+            //! Entities added
+            uint entities;
+            //! Entities drawn by static geometry
+            uint batched;
+            //! Cells with static geometry
+            uint cells;
+            //! Batches of the static geometry
+            uint batches;
+            //! Cells waiting to be rebuilt
+            uint pending;
+            //! Cell rebuilds since startup
+            uint rebuilds;
+            //! Seconds spent rebuilding cells since startup
+            f64 rebuildTime;
+            //! Seconds taken by the last rebuild
+            f64 lastRebuildTime;
+        };
+
+        //! Constructor. Reads the settings.
+        StaticBatcher(Renderer *renderer, Foundation::Framework *framework);
+
+        //! Destructor. Destroys the static geometry and shows the batched entities.
+        virtual ~StaticBatcher();
+
+        //! Adds an entity that has been attached to its scene node
+        void AddEntity(Ogre::Entity *entity);
+
+        //! Removes an entity before it is detached from its scene node or destroyed
+        void RemoveEntity(Ogre::Entity *entity);
+
+        //! Notifies that the materials, shadow casting or draw distance of an added entity have changed
+        void EntityChanged(Ogre::Entity *entity);
+
+        //! Assigns entities that have stopped moving to cells, and rebuilds changed cells. Called by Renderer.
+        void Update(f64 frametime);
+
+        //! Enables or disables batching. When disabled, all entities are drawn by themselves.
+        void SetEnabled(bool enabled);
+
+        //! Returns true if batching is enabled
+        bool IsEnabled() const { return enabled_; }
+
+        //! Returns the statistics
+        Stats GetStats() const;
+
+        // Ogre::MovableObject::Listener overrides
+        virtual void objectDestroyed(Ogre::MovableObject *object);
+        virtual void objectAttached(Ogre::MovableObject *object);
+        virtual void objectDetached(Ogre::MovableObject *object);
+        virtual void objectMoved(Ogre::MovableObject *object);
+
+    private:
+        //! Grid cell, and the settings that static geometry applies to all of its entities
+        struct CellKey
+        {
+            CellKey() : x(0), y(0), z(0), castShadows(false), drawDistance(0.0f) {}
+            bool operator <(const CellKey &rhs) const;
+            bool operator ==(const CellKey &rhs) const;
+
+            int x;
+            int y;
+            int z;
+            bool castShadows;
+            float drawDistance;
+        };
+
+        //! Entities of a cell, and the static geometry built from them
+        struct Cell
+        {
+            Cell() : geometry(0), batches(0) {}
+            //! Static geometry, null if not built
+            Ogre::StaticGeometry *geometry;
+            //! Number of batches in the static geometry
+            uint batches;
+            //! Entities assigned to the cell
+            std::set<Ogre::Entity *> entities;
+            //! Entities built into the static geometry
+            std::vector<Ogre::Entity *> batched;
+            //! Scene entities of the batched entities
+            BatchedEntities batchedEntities;
+        };
+
+        typedef std::map<CellKey, Cell> CellMap;
+
+        //! An added entity
+        struct Member
+        {
+            Member() : lastChange(0.0), cell(0), batched(false), visibilityFlags(0) {}
+            //! Time the entity was last moved, added or changed
+            f64 lastChange;
+            //! Cell the entity is assigned to, null if none
+            Cell *cell;
+            //! Key of the cell
+            CellKey key;
+            //! Whether the entity is drawn by the static geometry of its cell
+            bool batched;
+            //! Visibility flags of the entity, restored when it is no longer batched
+            uint visibilityFlags;
+            //! Materials of the entity when its cell was last built
+            std::vector<Ogre::Material *> materials;
+        };
+
+        typedef std::map<Ogre::Entity *, Member> MemberMap;
+
+        //! Returns true if the entity can be drawn by static geometry
+        bool IsBatchable(Ogre::Entity *entity) const;
+
+        //! Returns the cell key of an entity
+        CellKey GetCellKey(Ogre::Entity *entity) const;
+
+        //! Returns true if the materials of an assigned entity have changed since its cell was built
+        bool HasMaterialsChanged(Ogre::Entity *entity, const Member &member) const;
+
+        //! Assigns batchable entities that have not moved for a while to cells, and unassigns changed batched entities
+        void AssignEntities();
+
+        //! Unassigns an entity from its cell. If it was batched, the cell is broken.
+        /*! \param destroyed True if the entity is being destroyed, so that it must not be touched
+         */
+        void Unassign(Ogre::Entity *entity, Member &member, bool destroyed = false);
+
+        //! Hides the static geometry of a cell, shows its entities and queues the cell to be rebuilt
+        void BreakCell(const CellKey &key, Cell &cell);
+
+        //! Breaks the cells that draw an entity the application has hidden
+        void CheckVisibility();
+
+        //! Restores the visibility flags of a batched entity, so that it is drawn by itself if it is visible
+        void ShowEntity(Ogre::Entity *entity, Member &member);
+
+        //! Builds the static geometry of a cell again from its entities
+        void RebuildCell(const CellKey &key, Cell &cell);
+
+        //! Destroys the static geometry of a cell and shows its entities
+        void DestroyGeometry(Cell &cell);
+
+        //! Unassigns a moved, detached or changed entity, so that it is drawn by itself until it has been still for a while
+        void OnEntityChanged(Ogre::Entity *entity);
+
+        Renderer *renderer_;
+
+        //! Whether batching is enabled
+        bool enabled_;
+        //! Edge length of a cell
+        float cellSize_;
+        //! Seconds an entity must have been still before it is batched
+        f64 delay_;
+        //! Maximum cell rebuilds per frame
+        uint maxRebuilds_;
+        //! Whether a cell is being built. Entities are not moved by building, but reading their positions can notify them.
+        bool building_;
+
+        //! Time since startup
+        f64 time_;
+        //! Time since entities were last assigned
+        f64 checkTime_;
+
+        MemberMap members_;
+        CellMap cells_;
+        //! Keys of cells waiting to be rebuilt
+        std::set<CellKey> dirty_;
+
+        Stats stats_;
+    };
+}
+
+#endif
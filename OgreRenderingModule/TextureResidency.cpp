@@ -0,0 +1,163 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+
+#include "StableHeaders.h"
+#include "TextureResidency.h"
+#include "ResourceHandler.h"
+#include "OgreTextureResource.h"
+#include "OgreRenderingModule.h"
+#include "Framework.h"
+#include "ConfigurationManager.h"
+#include "Profiler.h"
+
+#include <Ogre.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace OgreRenderer
+{
+    TextureResidency::TextureResidency(ResourceHandler *handler, Foundation::Framework *framework) :
+        handler_(handler),
+        time_(0.0),
+        checkTime_(0.0)
+    {
+        Foundation::ConfigurationManager &config = framework->GetDefaultConfig();
+        int budget = config.DeclareSetting("OgreRenderer", "texture_budget_mb", 256);
+        budget_ = budget > 0 ? (u64)budget * 1024 * 1024 : 0;
+        idleTime_ = config.DeclareSetting("OgreRenderer", "texture_idle_time", 30.0f);
+        reduceLevels_ = config.DeclareSetting("OgreRenderer", "texture_reduce_levels", 2);
+        if (reduceLevels_ < 1)
+            reduceLevels_ = 1;
+        checkInterval_ = config.DeclareSetting("OgreRenderer", "texture_budget_check_interval", 1.0f);
+        maxReductions_ = config.DeclareSetting("OgreRenderer", "texture_max_reductions", 16);
+        stats_.budget = budget_;
+    }
+
+    void TextureResidency::MarkUsed(const std::set<Ogre::Technique*> &techniques)
+    {
+        uint rendered = 0;
+        for(std::set<Ogre::Technique*>::const_iterator i = techniques.begin(); i != techniques.end(); ++i)
+        {
+            Ogre::Technique::PassIterator passes = (*i)->getPassIterator();
+            while(passes.hasMoreElements())
+            {
+                Ogre::Pass::TextureUnitStateIterator units = passes.getNext()->getTextureUnitStateIterator();
+                while(units.hasMoreElements())
+                {
+                    const Ogre::TexturePtr &texture = units.getNext()->_getTexturePtr();
+                    if (texture.isNull())
+                        continue;
+
+                    const std::string &name = texture->getName();
+                    f64 &lastUse = lastUse_[name];
+                    if (lastUse == time_)
+                        continue;
+                    lastUse = time_;
+                    ++rendered;
+
+                    if (handler_->IsReduced(name) && handler_->RestoreTexture(name))
+                        ++stats_.restorations;
+                }
+            }
+        }
+        stats_.rendered = rendered;
+    }
+
+    void TextureResidency::Update(f64 frametime)
+    {
+        time_ += frametime;
+        checkTime_ += frametime;
+        if (checkTime_ < checkInterval_)
+            return;
+        checkTime_ = 0.0;
+
+        PROFILE(TextureResidency_CheckBudget);
+        CheckBudget();
+    }
+
+    f64 TextureResidency::GetIdleTime(const std::string &id) const
+    {
+        std::map<std::string, f64>::const_iterator i = lastUse_.find(id);
+        if (i == lastUse_.end())
+            return -1.0;
+        return time_ - i->second;
+    }
+
+    void TextureResidency::CheckBudget()
+    {
+        // Textures that can be reduced, by last use
+        typedef std::pair<f64, OgreTextureResource*> Candidate;
+        std::vector<Candidate> candidates;
+
+        Stats stats;
+        stats.budget = budget_;
+        stats.reductions = stats_.reductions;
+        stats.restorations = stats_.restorations;
+        stats.rendered = stats_.rendered;
+
+        // Last use of the textures that still exist. Entries of removed textures, and of textures that are not
+        // decoded from texture assets, are dropped, so that the map does not grow without bound.
+        std::map<std::string, f64> lastUse;
+
+        std::vector<Foundation::ResourcePtr> textures = handler_->GetResources(OgreTextureResource::GetTypeStatic());
+        for(uint i = 0; i < textures.size(); ++i)
+        {
+            OgreTextureResource *texture = checked_static_cast<OgreTextureResource*>(textures[i].get());
+            Ogre::TexturePtr ogreTexture = texture->GetTexture();
+            if (ogreTexture.isNull())
+                continue;
+
+            const std::string &id = texture->GetId();
+            size_t size = ogreTexture->getSize();
+            ++stats.textures;
+            stats.bytes += size;
+            if (handler_->IsReduced(id))
+            {
+                ++stats.reduced;
+                stats.reducedBytes += size;
+            }
+            if (handler_->IsReducing(id))
+                ++stats.reducing;
+            if (handler_->IsRestoring(id))
+                ++stats.restoring;
+
+            // Textures that have not been rendered age from when they were first seen
+            std::map<std::string, f64>::const_iterator k = lastUse_.find(id);
+            std::map<std::string, f64>::iterator j = lastUse.insert(std::make_pair(id, k != lastUse_.end() ? k->second : time_)).first;
+
+            if (texture->GetLevel() == 0 && time_ - j->second >= idleTime_ && !handler_->IsTextureLoading(id) &&
+                !handler_->IsReducing(id))
+                candidates.push_back(Candidate(j->second, texture));
+        }
+        lastUse_.swap(lastUse);
+
+        if (budget_ && stats.bytes > budget_)
+        {
+            // Go a bit below the budget, so that reductions are not needed again at the next check
+            u64 target = budget_ - budget_ / 10;
+            u64 bytes = stats.bytes;
+            uint queued = 0;
+
+            std::sort(candidates.begin(), candidates.end());
+            for(uint i = 0; i < candidates.size() && bytes > target && queued < maxReductions_; ++i)
+            {
+                OgreTextureResource *texture = candidates[i].second;
+                if (!handler_->ReduceTexture(texture->GetId(), reduceLevels_))
+                    continue;
+
+                // Each level halves the width and height
+                size_t size = texture->GetTexture()->getSize();
+                bytes -= size - (size >> (2 * reduceLevels_));
+                ++queued;
+                ++stats.reducing;
+            }
+
+            stats.reductions += queued;
+            if (queued && OgreRenderingModule::IsLogEnabled(Poco::Message::PRIO_DEBUG))
+                OgreRenderingModule::LogDebug("Textures use " + ToString(stats.bytes / 1024) + " KB, over the budget of " +
+                    ToString(budget_ / 1024) + " KB, reducing " + ToString(queued) + " textures");
+        }
+
+        stats_ = stats;
+    }
+}
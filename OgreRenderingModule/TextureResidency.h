@@ -0,0 +1,111 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+
+#ifndef incl_OgreRenderer_TextureResidency_h
+#define incl_OgreRenderer_TextureResidency_h
+
+#include "OgreModuleApi.h"
+#include "CoreTypes.h"
+
+#include <map>
+#include <set>
+#include <string>
+
+namespace Ogre
+{
+    class Technique;
+}
+
+namespace Foundation
+{
+    class Framework;
+}
+
+namespace OgreRenderer
+{
+    class ResourceHandler;
+
+    //! Keeps the memory used by decoded textures within a budget.
+    /*! Tracks when each texture was last rendered. When the textures decoded from texture assets take more memory
+        than the budget, the ones that have not been rendered for the longest time are replaced by a lower quality
+        level, which ResourceHandler has the texture decoder read from the mipmaps in the decoded texture cache, or
+        decode again from the texture asset in the asset cache.
+        A reduced texture is restored to full quality as soon as it is rendered again.
+
+        Owned by Renderer. The budget is texture_budget_mb in the OgreRenderer configuration group, 0 for no budget.
+     */
+    class OGRE_MODULE_API TextureResidency
+    {
+    public:
+        //! Residency statistics
+        struct Stats
+        {
+            Stats() : textures(0), reduced(0), reducing(0), restoring(0), rendered(0), bytes(0), reducedBytes(0), budget(0),
+                reductions(0), restorations(0) {}
+            //! Textures decoded from texture assets
+            uint textures;
+            //! Textures at a reduced quality level
+            uint reduced;
+            //! Reductions being decoded
+            uint reducing;
+            //! Reduced textures being restored to full quality
+            uint restoring;
+            //! Textures rendered in the last frame
+            uint rendered;
+            //! Memory used by the textures
+            u64 bytes;
+            //! Memory used by the reduced textures
+            u64 reducedBytes;
+            //! Memory budget, 0 if there is none
+            u64 budget;
+            //! Reductions queued since startup
+            uint reductions;
+            //! Restorations queued since startup
+            uint restorations;
+        };
+
+        //! Constructor. Reads the settings.
+        TextureResidency(ResourceHandler *handler, Foundation::Framework *framework);
+
+        //! Marks the textures of rendered techniques as used, and restores them if they have been reduced. Called by Renderer after rendering a frame.
+        void MarkUsed(const std::set<Ogre::Technique*> &techniques);
+
+        //! Reduces textures if over the budget, at most once per check interval. Called by Renderer.
+        void Update(f64 frametime);
+
+        //! Returns the statistics of the last check
+        const Stats& GetStats() const { return stats_; }
+
+        //! Returns seconds since the texture was last rendered, or -1 if it has not been rendered
+        f64 GetIdleTime(const std::string &id) const;
+
+    private:
+        //! Updates the statistics and reduces the least recently used textures if over the budget
+        void CheckBudget();
+
+        ResourceHandler *handler_;
+
+        //! Memory budget in bytes, 0 for none
+        u64 budget_;
+        //! Seconds a texture must have been unused before it can be reduced
+        f64 idleTime_;
+        //! Number of quality levels textures are reduced by
+        int reduceLevels_;
+        //! Seconds between checks
+        f64 checkInterval_;
+        //! Maximum reductions queued per check
+        uint maxReductions_;
+
+        //! Time since startup
+        f64 time_;
+        //! Time since the last check
+        f64 checkTime_;
+
+        //! Time each texture was last rendered, or first seen if it has not been rendered, by texture name.
+        //! Pruned to the existing texture resources at each check.
+        std::map<std::string, f64> lastUse_;
+
+        Stats stats_;
+    };
+}
+
+#endif
@@ -7,6 +7,14 @@
 #include "Framework.h"
 #include "ServiceManager.h"
 #include "EventManager.h"
+#include "ConsoleCommandServiceInterface.h"
+#include "VorbisStream.h"
+#include "SoundChannel.h"
+#include "HighPerfClock.h"
+
+#include <fstream>
+#include <iterator>
+#include <sstream>
 
 namespace OpenALAudio
 {
@@ -42,6 +50,22 @@ namespace OpenALAudio
             return;
         framework_->GetServiceManager()->RegisterService(Service::ST_Sound, soundsystem_);
         framework_->RegisterDynamicObject("audio", soundsystem_.get());
+        
+        RegisterConsoleCommand(Console::CreateCommand("SoundStreamStats",
+            "Shows decode times, startup latency and memory use of streamed sounds.",
+            Console::Bind(this, &OpenALAudioModule::ShowStreamStats)));
+        
+        RegisterConsoleCommand(Console::CreateCommand("BenchOggStream",
+            "Compares decoding a local ogg file as a whole to decoding it as a stream. Usage: BenchOggStream(filename)",
+            Console::Bind(this, &OpenALAudioModule::BenchmarkOggStream)));
+        
+        RegisterConsoleCommand(Console::CreateCommand("SoundVoiceStats",
+            "Shows the number of sound channels with an OpenAL source and the number of virtual channels.",
+            Console::Bind(this, &OpenALAudioModule::ShowVoiceStats)));
+        
+        RegisterConsoleCommand(Console::CreateCommand("BenchSoundVoices",
+            "Benchmarks channel updates with looped positional sounds around a moving listener. Usage: BenchSoundVoices(count, frames)",
+            Console::Bind(this, &OpenALAudioModule::BenchmarkVoices)));
     }
 
     void OpenALAudioModule::PostInitialize()
@@ -87,6 +111,90 @@ namespace OpenALAudio
         }
         return false;
     }
+    
+    Console::CommandResult OpenALAudioModule::ShowStreamStats(const StringVector &params)
+    {
+        if (!soundsystem_)
+            return Console::ResultFailure("Sound system not initialized.");
+        
+        const SoundStreamStats& stats = soundsystem_->GetStreamStats();
+        uint active_streams, buffered_size, decoded_size;
+        soundsystem_->GetStreamMemoryUse(active_streams, buffered_size, decoded_size);
+        
+        std::stringstream result;
+        result << "Streams started: " << stats.streams_started_ << ", chunks decoded: " << stats.chunks_decoded_ << std::endl;
+        if (stats.chunks_decoded_)
+            result << "Chunk decode time: average " << stats.decode_time_total_ * 1000.0 / stats.chunks_decoded_
+                << " ms, max " << stats.decode_time_max_ * 1000.0 << " ms" << std::endl;
+        if (stats.streams_started_)
+            result << "Time to first audio: average " << stats.first_audio_time_total_ * 1000.0 / stats.streams_started_
+                << " ms, max " << stats.first_audio_time_max_ * 1000.0 << " ms" << std::endl;
+        result << "Active streams: " << active_streams << ", buffered " << buffered_size / 1024
+            << " KB, fully decoded would be " << decoded_size / 1024 << " KB";
+        return Console::ResultSuccess(result.str());
+    }
+    
+    Console::CommandResult OpenALAudioModule::ShowVoiceStats(const StringVector &params)
+    {
+        if (!soundsystem_)
+            return Console::ResultFailure("Sound system not initialized.");
+        
+        uint real_voices, virtual_voices;
+        soundsystem_->GetVoiceCounts(real_voices, virtual_voices);
+        return Console::ResultSuccess("Channels with a source: " + ToString<uint>(real_voices) + ", virtual: " + ToString<uint>(virtual_voices));
+    }
+    
+    Console::CommandResult OpenALAudioModule::BenchmarkVoices(const StringVector &params)
+    {
+        if (!soundsystem_)
+            return Console::ResultFailure("Sound system not initialized.");
+        
+        uint count = (params.size() > 0) ? ParseString<uint>(params[0], 1000) : 1000;
+        uint frames = (params.size() > 1) ? ParseString<uint>(params[1], 600) : 600;
+        return Console::ResultSuccess(soundsystem_->BenchmarkVoices(count, frames));
+    }
+    
+    Console::CommandResult OpenALAudioModule::BenchmarkOggStream(const StringVector &params)
+    {
+        if (params.size() < 1)
+            return Console::ResultFailure("Usage: BenchOggStream(filename)");
+        
+        std::ifstream file(params[0].c_str(), std::ios::in | std::ios::binary);
+        if (!file.is_open())
+            return Console::ResultFailure("Could not open file " + params[0]);
+        SoundDataPtr data(new std::vector<u8>());
+        data->assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        file.close();
+        
+        uint chunk_size = soundsystem_ ? soundsystem_->GetStreamChunkSize() : 65536;
+        const f64 freq = (f64)GetCurrentClockFreq();
+        
+        // Decode the whole file, the way sounds shorter than the stream threshold are loaded
+        tick_t start = GetCurrentClockTime();
+        VorbisStream full(params[0], data);
+        if (!full.Open())
+            return Console::ResultFailure("Not a valid Ogg Vorbis file: " + params[0]);
+        std::vector<u8> full_data;
+        full_data.reserve(full.GetDecodedSize());
+        while (full.Read(full_data, chunk_size))
+            ;
+        f64 full_time = (GetCurrentClockTime() - start) / freq;
+        
+        // Decode only the first chunk, which is all a stream needs before it can start playing
+        start = GetCurrentClockTime();
+        VorbisStream stream(params[0], data);
+        stream.Open();
+        std::vector<u8> chunk;
+        stream.Read(chunk, chunk_size);
+        f64 first_chunk_time = (GetCurrentClockTime() - start) / freq;
+        
+        std::stringstream result;
+        result << "Duration: " << full.GetDuration() << " s, compressed " << data->size() / 1024 << " KB" << std::endl
+            << "Full decode: " << full_time * 1000.0 << " ms, " << full_data.size() / 1024 << " KB" << std::endl
+            << "Stream first chunk: " << first_chunk_time * 1000.0 << " ms, "
+            << STREAM_BUFFER_COUNT * chunk_size / 1024 << " KB in " << STREAM_BUFFER_COUNT << " buffers";
+        return Console::ResultSuccess(result.str());
+    }
 }
 
 extern "C" void POCO_LIBRARY_API SetProfiler(Foundation::Profiler *profiler);
@@ -42,6 +42,18 @@ namespace OpenALAudio
         bool HandleEvent(event_category_id_t category_id, event_id_t event_id, IEventData* data);
 
     private:
+        //! Console command for showing statistics of streamed sounds
+        Console::CommandResult ShowStreamStats(const StringVector &params);
+        
+        //! Console command for comparing full decode of a local ogg file to decoding it as a stream
+        Console::CommandResult BenchmarkOggStream(const StringVector &params);
+        
+        //! Console command for showing the number of real and virtual sound channels
+        Console::CommandResult ShowVoiceStats(const StringVector &params);
+        
+        //! Console command for benchmarking channel updates with many positional sounds
+        Console::CommandResult BenchmarkVoices(const StringVector &params);
+        
         //! Type name of the module.
         static std::string type_name_static_;
 
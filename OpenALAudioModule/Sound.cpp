@@ -10,6 +10,8 @@ namespace OpenALAudio
         name_(name),
         handle_(0), 
         size_(0), 
+        duration_(0.0),
+        stream_decoded_size_(0),
         age_(0.0)
     {
     }
@@ -19,25 +21,30 @@ namespace OpenALAudio
         DeleteBuffer();
     }
     
-    bool Sound::LoadFromBuffer(const ISoundService::SoundBuffer& buffer)
+    ALenum Sound::GetFormat(const ISoundService::SoundBuffer& buffer)
     {
-        DeleteBuffer();
-        
-        ALenum openal_format;
         if (!buffer.stereo_)
         {
             if (!buffer.sixteenbit_)
-                openal_format = AL_FORMAT_MONO8;
+                return AL_FORMAT_MONO8;
             else
-                openal_format = AL_FORMAT_MONO16;
+                return AL_FORMAT_MONO16;
         }
         else
         {
             if (!buffer.sixteenbit_)
-                openal_format = AL_FORMAT_STEREO8;
+                return AL_FORMAT_STEREO8;
             else
-                openal_format = AL_FORMAT_STEREO16;
+                return AL_FORMAT_STEREO16;
         }
+    }
+    
+    bool Sound::LoadFromBuffer(const ISoundService::SoundBuffer& buffer)
+    {
+        DeleteBuffer();
+        stream_data_.reset();
+        
+        ALenum openal_format = GetFormat(buffer);
         
         if (!CreateBuffer())
             return false;
@@ -51,9 +58,22 @@ namespace OpenALAudio
             return false;
         }
         size_ = buffer.data_.size();
+        
+        uint bytes_per_second = buffer.frequency_ * (buffer.stereo_ ? 2 : 1) * (buffer.sixteenbit_ ? 2 : 1);
+        duration_ = bytes_per_second ? (f64)size_ / bytes_per_second : 0.0;
         return true;
     }
     
+    void Sound::SetStreamData(SoundDataPtr data, f64 duration, uint decoded_size)
+    {
+        DeleteBuffer();
+        
+        stream_data_ = data;
+        duration_ = duration;
+        stream_decoded_size_ = decoded_size;
+        size_ = data ? data->size() : 0;
+    }
+    
     bool Sound::CreateBuffer()
     {    
         if (!handle_)
@@ -74,7 +94,8 @@ namespace OpenALAudio
         {
             alDeleteBuffers(1, &handle_);
             handle_ = 0;
-            size_ = 0;
         }
+        size_ = 0;
+        duration_ = 0.0;
     } 
 }
\ No newline at end of file
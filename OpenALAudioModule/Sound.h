@@ -6,6 +6,7 @@
 #include <AL/alc.h>
 
 #include "ISoundService.h"
+#include "VorbisStream.h"
 
 namespace OpenALAudio
 {
@@ -22,13 +23,35 @@ namespace OpenALAudio
         /*! Any existing sound data will be erased.
          */
         bool LoadFromBuffer(const ISoundService::SoundBuffer& buffer);
+        
+        //! Set Ogg Vorbis data to be decoded in chunks while playing, instead of decoding it all into a buffer
+        /*! Any existing sound data will be erased.
+            \param data Ogg Vorbis data
+            \param duration Duration in seconds
+            \param decoded_size Size of the whole sound when decoded, in bytes
+         */
+        void SetStreamData(SoundDataPtr data, f64 duration, uint decoded_size);
+        
+        //! Return whether sound is streamed
+        bool IsStreamed() const { return stream_data_.get() != 0; }
+        //! Return Ogg Vorbis data of a streamed sound
+        const SoundDataPtr& GetStreamData() const { ResetAge(); return stream_data_; }
+        //! Return decoded size of a streamed sound in bytes
+        uint GetStreamDecodedSize() const { return stream_decoded_size_; }
+        //! Return whether sound has data and can be played
+        bool IsReady() const { return handle_ != 0 || IsStreamed(); }
+
+        //! Return OpenAL format of sound data
+        static ALenum GetFormat(const ISoundService::SoundBuffer& buffer);
 
         //! Return sound name
         const std::string& GetName() const { return name_; }
         //! Return OpenAL handle
         ALuint GetHandle() const { ResetAge(); return handle_; }
-        //! Return datasize of sound in bytes
+        //! Return datasize of sound in bytes. For streamed sounds, this is the size of the compressed data
         uint GetSize() const { return size_; }
+        //! Return duration of sound in seconds
+        f64 GetDuration() const { return duration_; }
 
         //! Return age of sound (for caching)
         f64 GetAge() const { return age_; }
@@ -49,6 +72,12 @@ namespace OpenALAudio
         ALuint handle_;
         //! Total size of audio data
         uint size_;    
+        //! Ogg Vorbis data of streamed sound
+        SoundDataPtr stream_data_;
+        //! Duration in seconds
+        f64 duration_;
+        //! Decoded size of streamed sound
+        uint stream_decoded_size_;
         //! Age of sound (resetted when last accessed)
         mutable f64 age_;
     };
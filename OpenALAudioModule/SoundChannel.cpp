@@ -25,7 +25,19 @@ namespace OpenALAudio
         positional_(false),
         looped_(false),
         buffered_mode_(false),
-        state_(ISoundService::Stopped)
+        state_(ISoundService::Stopped),
+        virtual_(false),
+        virtual_time_(0.0),
+        resume_time_(0.0),
+        stream_requests_(0),
+        stream_ended_(false),
+        stream_waiting_(false),
+        stream_start_time_(0),
+        stream_buffered_size_(0),
+        stream_decoded_size_(0),
+        stream_byte_rate_(0),
+        stream_start_offset_(0.0),
+        stream_played_time_(0.0)
     { 
     }
     
@@ -34,9 +46,14 @@ namespace OpenALAudio
         DeleteSource();
     }
     
-    void SoundChannel::Update(const Vector3df& listener_pos)
+    void SoundChannel::Update(f64 frametime)
     {   
-        CalculateAttenuation(listener_pos);
+        if (virtual_)
+        {
+            UpdateVirtual(frametime);
+            return;
+        }
+        
         SetAttenuatedGain();
         QueueBuffers();
         UnqueueBuffers();
@@ -49,9 +66,20 @@ namespace OpenALAudio
                 alGetSourcei(handle_, AL_SOURCE_STATE, &playing);
                 if (playing != AL_PLAYING)
                 {
+                    // A stream stops when it has been played through. If the source ran out of data before
+                    // the decoder could keep up, it is restarted when more data has been queued
+                    if (stream_)
+                    {
+                        ALint queued = 0;
+                        alGetSourcei(handle_, AL_BUFFERS_QUEUED, &queued);
+                        if (queued)
+                            alSourcePlay(handle_);
+                        else if (stream_ended_ && !stream_requests_)
+                            state_ = ISoundService::Stopped;
+                    }
                     // Stopped state may trigger removal of audio channel, so don't
                     // do that in buffered mode
-                    if (buffered_mode_)
+                    else if (buffered_mode_)
                     {
                         state_ = ISoundService::Pending;
                     }
@@ -62,6 +90,105 @@ namespace OpenALAudio
         }
     }
     
+    float SoundChannel::UpdateAudibility(const Vector3df& listener_pos)
+    {
+        CalculateAttenuation(listener_pos);
+        
+        if (positional_)
+            return master_gain_ * gain_ * attenuation_;
+        else
+            return master_gain_ * gain_;
+    }
+    
+    void SoundChannel::SetVirtual(bool enable)
+    {
+        if ((enable == virtual_) || (enable && !CanVirtualize()))
+            return;
+        
+        virtual_ = enable;
+        if (virtual_)
+        {
+            // Keep the sound being played, so that playback can later continue from the same position
+            SoundPtr sound;
+            if ((state_ == ISoundService::Playing) && (playing_sounds_.size()))
+            {
+                sound = playing_sounds_[0];
+                virtual_time_ = GetPlaybackTime();
+            }
+            
+            StopStream();
+            if (handle_)
+            {
+                alSourceStop(handle_);
+                alSourcei(handle_, AL_BUFFER, 0);
+                alDeleteSources(1, &handle_);
+                handle_ = 0;
+            }
+            
+            playing_sounds_.clear();
+            if (sound)
+                playing_sounds_.push_back(sound);
+        }
+        else
+        {
+            // Requeue the sound. It will continue from the virtual position when the source is created on next update
+            if ((state_ == ISoundService::Playing) && (playing_sounds_.size()))
+            {
+                pending_sounds_.push_front(playing_sounds_[0]);
+                playing_sounds_.clear();
+                resume_time_ = virtual_time_;
+                state_ = ISoundService::Pending;
+            }
+        }
+    }
+    
+    void SoundChannel::UpdateVirtual(f64 frametime)
+    {
+        // A pending sound starts playing virtually as soon as its data is available
+        if (state_ == ISoundService::Pending)
+        {
+            if ((!pending_sounds_.size()) || (!(*pending_sounds_.begin())->IsReady()))
+                return;
+            playing_sounds_.clear();
+            playing_sounds_.push_back(*pending_sounds_.begin());
+            pending_sounds_.pop_front();
+            virtual_time_ = 0.0;
+            state_ = ISoundService::Playing;
+            return;
+        }
+        
+        if ((state_ != ISoundService::Playing) || (!playing_sounds_.size()))
+            return;
+        
+        f64 duration = playing_sounds_[0]->GetDuration();
+        virtual_time_ += frametime * pitch_;
+        if (virtual_time_ >= duration)
+        {
+            if ((looped_) && (duration > 0.0))
+                virtual_time_ = fmod(virtual_time_, duration);
+            else
+                Stop();
+        }
+    }
+    
+    f64 SoundChannel::GetPlaybackTime() const
+    {
+        if (!handle_)
+            return 0.0;
+        
+        ALfloat offset = 0.0f;
+        alGetSourcef(handle_, AL_SEC_OFFSET, &offset);
+        if (!stream_)
+            return offset;
+        
+        // The source only holds the last few chunks of a stream
+        f64 time = stream_start_offset_ + stream_played_time_ + offset;
+        f64 duration = playing_sounds_.size() ? playing_sounds_[0]->GetDuration() : 0.0;
+        if ((looped_) && (duration > 0.0))
+            time = fmod(time, duration);
+        return time;
+    }
+    
     void SoundChannel::Play(SoundPtr sound)
     {
         // Stop any previously buffered sound
@@ -79,6 +206,15 @@ namespace OpenALAudio
     
     void SoundChannel::AddBuffer(const ISoundService::SoundBuffer& buffer)
     {
+        // Buffers can not be mixed with a stream
+        StopStream();
+        // Buffered channels are never virtual, as their data can not be skipped
+        if (virtual_)
+        {
+            virtual_ = false;
+            playing_sounds_.clear();
+        }
+        
         // Construct a sound from the buffer
         SoundPtr new_sound(new Sound("buffer"));
         new_sound->LoadFromBuffer(buffer);
@@ -109,7 +245,7 @@ namespace OpenALAudio
         }   
         
         alSourcef(handle_, AL_PITCH, pitch_);
-        alSourcei(handle_, AL_LOOPING, looped_ ? AL_TRUE : AL_FALSE);
+        alSourcei(handle_, AL_LOOPING, (looped_ && !stream_) ? AL_TRUE : AL_FALSE);
         // No matter whether sound is positional or not, we use own attenuation, so OpenAL rolloff is 0
         alSourcef(handle_, AL_ROLLOFF_FACTOR, 0.0);
         
@@ -139,8 +275,11 @@ namespace OpenALAudio
             alSourcei(handle_, AL_BUFFER, 0);
         }
         
+        StopStream();
         pending_sounds_.clear();
         playing_sounds_.clear();
+        virtual_time_ = 0.0;
+        resume_time_ = 0.0;
         
         state_ = ISoundService::Stopped;
     }
@@ -178,8 +317,9 @@ namespace OpenALAudio
             enable = false;
         
         looped_ = enable;
+        // Streams are looped by the decoder, as the source only has a part of the sound queued at a time
         if (handle_)
-            alSourcei(handle_, AL_LOOPING, looped_ ? AL_TRUE : AL_FALSE);
+            alSourcei(handle_, AL_LOOPING, (looped_ && !stream_) ? AL_TRUE : AL_FALSE);
     }
     
     void SoundChannel::SetPitch(float pitch)
@@ -282,7 +422,7 @@ namespace OpenALAudio
         // See that we do have waiting sounds and they're ready to play
         if (!pending_sounds_.size())
             return;
-        if ((*pending_sounds_.begin())->GetHandle() == 0)
+        if (!(*pending_sounds_.begin())->IsReady())
             return;
         
         // Create source now if did not exist already
@@ -299,6 +439,15 @@ namespace OpenALAudio
         while (pending_sounds_.size())
         {
             SoundPtr sound = *pending_sounds_.begin();
+            if (sound->IsStreamed())
+            {
+                StartStream(sound);
+                pending_sounds_.pop_front();
+                // Playback starts when the first chunk has been decoded
+                state_ = ISoundService::Playing;
+                continue;
+            }
+            
             ALuint buffer = sound->GetHandle();
             // If no valid handle yet, cannot play this one, break out
             if (!buffer)
@@ -338,7 +487,13 @@ namespace OpenALAudio
             ALint playing;
             alGetSourcei(handle_, AL_SOURCE_STATE, &playing);
             if (playing != AL_PLAYING)
+            {
+                // Continue from where the channel was when it was made virtual
+                if (resume_time_ > 0.0)
+                    alSourcef(handle_, AL_SEC_OFFSET, (ALfloat)resume_time_);
                 alSourcePlay(handle_);
+            }
+            resume_time_ = 0.0;
             state_ = ISoundService::Playing;
         }
     }
@@ -355,6 +510,18 @@ namespace OpenALAudio
                 alSourceUnqueueBuffers(handle_, 1, &buffer);
                 if (buffer)
                 {
+                    // Stream buffers are refilled with the next chunks
+                    std::map<ALuint, uint>::iterator j = stream_buffers_.find(buffer);
+                    if (j != stream_buffers_.end())
+                    {
+                        if (stream_byte_rate_)
+                            stream_played_time_ += (f64)j->second / stream_byte_rate_;
+                        stream_buffered_size_ -= j->second;
+                        j->second = 0;
+                        free_stream_buffers_.push_back(buffer);
+                        continue;
+                    }
+                    
                     // See if we find matching buffer from the sounds vector.
                     // If found, erase so that the sound may be freed if not used elsewhere
                     for (uint i = 0; i < playing_sounds_.size(); ++i)
@@ -370,4 +537,118 @@ namespace OpenALAudio
         }
     }
     
+    void SoundChannel::StartStream(SoundPtr sound)
+    {
+        StopStream();
+        
+        stream_ = VorbisStreamPtr(new VorbisStream(sound->GetName(), sound->GetStreamData()));
+        // Continue from where the channel was when it was made virtual
+        stream_->SetStartTime(resume_time_);
+        stream_start_offset_ = resume_time_;
+        resume_time_ = 0.0;
+        // Keep the sound referenced while it plays, like buffered sounds
+        playing_sounds_.push_back(sound);
+        
+        for (uint i = 0; i < STREAM_BUFFER_COUNT; ++i)
+        {
+            ALuint buffer = 0;
+            alGenBuffers(1, &buffer);
+            if (!buffer)
+            {
+                OpenALAudioModule::LogError("Could not create OpenAL sound buffer");
+                break;
+            }
+            stream_buffers_[buffer] = 0;
+            free_stream_buffers_.push_back(buffer);
+        }
+        
+        stream_start_time_ = GetCurrentClockTime();
+        stream_waiting_ = true;
+        stream_decoded_size_ = sound->GetStreamDecodedSize();
+        
+        if (handle_)
+            alSourcei(handle_, AL_LOOPING, AL_FALSE);
+    }
+    
+    void SoundChannel::StopStream()
+    {
+        if (stream_buffers_.empty() && !stream_)
+            return;
+        
+        if (handle_)
+        {
+            alSourceStop(handle_);
+            alSourcei(handle_, AL_BUFFER, 0);
+        }
+        
+        std::map<ALuint, uint>::iterator i = stream_buffers_.begin();
+        while (i != stream_buffers_.end())
+        {
+            ALuint buffer = i->first;
+            alDeleteBuffers(1, &buffer);
+            ++i;
+        }
+        
+        stream_buffers_.clear();
+        free_stream_buffers_.clear();
+        stream_.reset();
+        stream_requests_ = 0;
+        stream_ended_ = false;
+        stream_waiting_ = false;
+        stream_buffered_size_ = 0;
+        stream_decoded_size_ = 0;
+        stream_byte_rate_ = 0;
+        stream_start_offset_ = 0.0;
+        stream_played_time_ = 0.0;
+    }
+    
+    uint SoundChannel::GetStreamChunksNeeded() const
+    {
+        if (!stream_ || stream_ended_)
+            return 0;
+        
+        uint free_buffers = free_stream_buffers_.size();
+        return free_buffers > stream_requests_ ? free_buffers - stream_requests_ : 0;
+    }
+    
+    void SoundChannel::AddStreamChunk(const ISoundService::SoundBuffer& buffer)
+    {
+        if (stream_requests_)
+            --stream_requests_;
+        if (!stream_ || !handle_)
+            return;
+        
+        if (!buffer.data_.size())
+        {
+            stream_ended_ = true;
+            stream_waiting_ = false;
+            return;
+        }
+        if (!free_stream_buffers_.size())
+            return;
+        
+        ALuint al_buffer = free_stream_buffers_.back();
+        
+        alGetError();
+        alBufferData(al_buffer, Sound::GetFormat(buffer), (u8*)&buffer.data_[0], buffer.data_.size(), buffer.frequency_);
+        alSourceQueueBuffers(handle_, 1, &al_buffer);
+        ALenum error = alGetError();
+        if (error != AL_NONE)
+        {
+            OpenALAudioModule::LogError("Could not queue OpenAL stream buffer: " + ToString<int>(error));
+            return;
+        }
+        
+        free_stream_buffers_.pop_back();
+        stream_buffers_[al_buffer] = buffer.data_.size();
+        stream_byte_rate_ = buffer.frequency_ * (buffer.stereo_ ? 4 : 2);
+        stream_buffered_size_ += buffer.data_.size();
+        stream_waiting_ = false;
+        
+        ALint playing;
+        alGetSourcei(handle_, AL_SOURCE_STATE, &playing);
+        if (playing != AL_PLAYING)
+            alSourcePlay(handle_);
+        state_ = ISoundService::Playing;
+    }
 }
\ No newline at end of file
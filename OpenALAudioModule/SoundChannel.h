@@ -4,9 +4,13 @@
 
 #include "ISoundService.h"
 #include "Sound.h"
+#include "HighPerfClock.h"
 
 namespace OpenALAudio
 {
+    //! Number of OpenAL buffers a streamed sound cycles through
+    const uint STREAM_BUFFER_COUNT = 4;
+    
     //! An OpenAL sound channel (source)
     class SoundChannel
     {
@@ -41,8 +45,26 @@ namespace OpenALAudio
         void SetRange(float inner_radius, float outer_radius, float rolloff);
         //! Stop.
         void Stop();
-        //! Per-frame update with new listener position
-        void Update(const Vector3df& listener_pos);
+        //! Per-frame update
+        /*! UpdateAudibility() should have been called first with the current listener position
+         */
+        void Update(f64 frametime);
+        //! Calculate attenuation with new listener position
+        /*! \return Final gain the channel would be heard at
+         */
+        float UpdateAudibility(const Vector3df& listener_pos);
+        
+        //! Set virtual state
+        /*! A virtual channel has no OpenAL source. It keeps track of the playback position, and resumes from
+            there when it is made real again. Channels in buffered mode can not be made virtual.
+         */
+        void SetVirtual(bool enable);
+        //! Return virtual state
+        bool IsVirtual() const { return virtual_; }
+        //! Return whether the channel can be made virtual
+        bool CanVirtualize() const { return !buffered_mode_; }
+        //! Return whether the channel currently has an OpenAL source
+        bool HasSource() const { return handle_ != 0; }
         //! Return current state of channel.
         ISoundService::SoundState GetState() const { return state_; }
         //! Return name/id of sound that's playing, empty if nothing playing
@@ -53,6 +75,25 @@ namespace OpenALAudio
         float GetGain() const {return gain_;}
         //! Return sound pitch.
         float GetPitch() const {return pitch_;}
+        //! Return looped state.
+        bool IsLooped() const { return looped_; }
+        
+        //! Return stream being played, or null if not playing a streamed sound
+        VorbisStreamPtr GetStream() const { return stream_; }
+        //! Return how many more chunks of the stream should be requested from the decoder
+        uint GetStreamChunksNeeded() const;
+        //! Note that a chunk of the stream has been requested from the decoder
+        void StreamChunkRequested() { ++stream_requests_; }
+        //! Queue a decoded chunk of the stream for playback. Zero size chunk marks end of stream
+        void AddStreamChunk(const ISoundService::SoundBuffer& buffer);
+        //! Return whether the stream has started, but no decoded data has arrived yet
+        bool IsWaitingForStream() const { return stream_ && stream_waiting_; }
+        //! Return time when the stream was started
+        tick_t GetStreamStartTime() const { return stream_start_time_; }
+        //! Return size of decoded data held by the stream buffers in bytes
+        uint GetStreamBufferedSize() const { return stream_buffered_size_; }
+        //! Return size of the whole stream when decoded in bytes
+        uint GetStreamDecodedSize() const { return stream_decoded_size_; }
         
     private:
         //! Queue buffers and start playing
@@ -69,6 +110,14 @@ namespace OpenALAudio
         void SetPositionAndMode();
         //! Set gain, taking attenuation into account
         void SetAttenuatedGain();
+        //! Start playing a streamed sound
+        void StartStream(SoundPtr sound);
+        //! Stop stream and free its buffers
+        void StopStream();
+        //! Advance playback position of a virtual channel
+        void UpdateVirtual(f64 frametime);
+        //! Return playback position of the currently playing sound in seconds
+        f64 GetPlaybackTime() const;
         
         //! Sound type
         ISoundService::SoundType type_;
@@ -102,6 +151,37 @@ namespace OpenALAudio
         Vector3df position_;
         //! State 
         ISoundService::SoundState state_;
+        //! Virtual flag
+        bool virtual_;
+        //! Playback position while virtual, in seconds
+        f64 virtual_time_;
+        //! Playback position to resume from when the sound is next queued, in seconds
+        f64 resume_time_;
+        
+        //! Stream being played
+        VorbisStreamPtr stream_;
+        //! OpenAL buffers of the stream, and size of the data in them
+        std::map<ALuint, uint> stream_buffers_;
+        //! Stream buffers that are not queued on the source
+        std::vector<ALuint> free_stream_buffers_;
+        //! Number of chunks requested from the decoder but not yet received
+        uint stream_requests_;
+        //! Decoder has reached the end of the stream
+        bool stream_ended_;
+        //! No data of the stream has been queued yet
+        bool stream_waiting_;
+        //! Time when the stream was started
+        tick_t stream_start_time_;
+        //! Size of decoded data queued on the source
+        uint stream_buffered_size_;
+        //! Size of the whole stream when decoded
+        uint stream_decoded_size_;
+        //! Decoded bytes per second of the stream
+        uint stream_byte_rate_;
+        //! Time the stream was started from, in seconds
+        f64 stream_start_offset_;
+        //! Duration of the stream buffers played so far, in seconds
+        f64 stream_played_time_;
     };
     
     typedef boost::shared_ptr<SoundChannel> SoundChannelPtr;
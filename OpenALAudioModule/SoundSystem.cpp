@@ -15,11 +15,22 @@
 #include "EventManager.h"
 
 #include <boost/thread/mutex.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_real.hpp>
+#include <boost/random/variate_generator.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <sstream>
 
 namespace OpenALAudio
 {
     const uint DEFAULT_SOUND_CACHE_SIZE = 32 * 1024 * 1024;
     const f64 CACHE_CHECK_INTERVAL = 1.0;
+    const f64 DEFAULT_STREAM_THRESHOLD = 10.0;
+    const uint DEFAULT_STREAM_CHUNK_SIZE = 65536;
+    const uint DEFAULT_MAX_SOURCES = 32;
+    const float VOICE_HYSTERESIS = 1.1f;
     
     SoundSystem::SoundSystem(Foundation::Framework *framework) : 
         framework_(framework),
@@ -31,10 +42,20 @@ namespace OpenALAudio
         capture_sample_size_(0),
         next_channel_id_(0),
         sound_cache_size_(DEFAULT_SOUND_CACHE_SIZE),
+        stream_threshold_(DEFAULT_STREAM_THRESHOLD),
+        stream_chunk_size_(DEFAULT_STREAM_CHUNK_SIZE),
+        max_sources_(DEFAULT_MAX_SOURCES),
+        real_voices_(0),
+        virtual_voices_(0),
         update_time_(0),
         listener_position_(0.0, 0.0, 0.0)
     {
         sound_cache_size_ = framework_->GetDefaultConfig().DeclareSetting("SoundSystem", "sound_cache_size", DEFAULT_SOUND_CACHE_SIZE);
+        stream_threshold_ = framework_->GetDefaultConfig().DeclareSetting("SoundSystem", "stream_threshold", DEFAULT_STREAM_THRESHOLD);
+        stream_chunk_size_ = framework_->GetDefaultConfig().DeclareSetting("SoundSystem", "stream_chunk_size", DEFAULT_STREAM_CHUNK_SIZE);
+        // Chunks must hold whole 16bit stereo samples
+        stream_chunk_size_ = std::max(stream_chunk_size_ & ~3u, 4096u);
+        max_sources_ = framework_->GetDefaultConfig().DeclareSetting("SoundSystem", "max_sources", DEFAULT_MAX_SOURCES);
         
         // By default, initialize default playback device
         Initialize();
@@ -175,7 +196,6 @@ namespace OpenALAudio
             return;
             
 //        mutex.lock();
-        std::vector<SoundChannelMap::iterator> channels_to_delete;
 
         // Update listener position/orientation to sound device
         ALfloat pos[] = {listener_position_.x, listener_position_.y, listener_position_.z};
@@ -185,11 +205,28 @@ namespace OpenALAudio
         ALfloat orient[] = {front.x, front.y, front.z, up.x, up.y, up.z};
         alListenerfv(AL_ORIENTATION, orient);    
         
-        // Update channel attenuations, check which have stopped
+        UpdateChannels(frametime);
+        
+     //   mutex.unlock();
+        
+        // Age the sound cache
+        UpdateCache(frametime);
+    }
+    
+    void SoundSystem::UpdateChannels(f64 frametime)
+    {
+        PROFILE(SoundSystem_UpdateChannels);
+        
+        std::vector<SoundChannelMap::iterator> channels_to_delete;
+        
+        // Decide which channels get an OpenAL source before the channels create them
+        UpdateVoices();
+        
+        // Update channels, check which have stopped
         SoundChannelMap::iterator i = channels_.begin();
         while (i != channels_.end())
         {
-            i->second->Update(listener_position_);
+            i->second->Update(frametime);
             if (i->second->GetState() == ISoundService::Stopped)
             {
                 channels_to_delete.push_back(i);
@@ -201,10 +238,137 @@ namespace OpenALAudio
         for (uint j = 0; j < channels_to_delete.size(); ++j)
             channels_.erase(channels_to_delete[j]);   
         
-     //   mutex.unlock();
+        // Keep the buffers of streaming channels filled
+        for (i = channels_.begin(); i != channels_.end(); ++i)
+            RequestStreamChunks(i->first, i->second.get());
+    }
+    
+    void SoundSystem::UpdateVoices()
+    {
+        voice_candidates_.clear();
+        uint reserved = 0;
         
-        // Age the sound cache
-        UpdateCache(frametime);
+        SoundChannelMap::iterator i = channels_.begin();
+        while (i != channels_.end())
+        {
+            SoundChannel* channel = i->second.get();
+            ++i;
+            
+            float audibility = channel->UpdateAudibility(listener_position_);
+            if (channel->GetState() == ISoundService::Stopped)
+                continue;
+            // Buffered channels, such as voice, always get a source
+            if (!channel->CanVirtualize())
+            {
+                ++reserved;
+                continue;
+            }
+            // Favor channels that already have a source, so that channels near the cutoff do not swap every frame
+            if (!channel->IsVirtual())
+                audibility *= VOICE_HYSTERESIS;
+            voice_candidates_.push_back(std::make_pair(audibility, channel));
+        }
+        
+        // Only the most audible channels get a source
+        uint sources = max_sources_ > reserved ? max_sources_ - reserved : 0;
+        if (sources < voice_candidates_.size())
+            std::nth_element(voice_candidates_.begin(), voice_candidates_.begin() + sources, voice_candidates_.end(),
+                std::greater<std::pair<float, SoundChannel*> >());
+        
+        real_voices_ = reserved;
+        virtual_voices_ = 0;
+        for (uint j = 0; j < voice_candidates_.size(); ++j)
+        {
+            bool real = (j < sources) && (voice_candidates_[j].first > 0.0f);
+            voice_candidates_[j].second->SetVirtual(!real);
+            if (real)
+                ++real_voices_;
+            else
+                ++virtual_voices_;
+        }
+    }
+    
+    std::string SoundSystem::BenchmarkVoices(uint count, uint frames)
+    {
+        if (!initialized_)
+            return "Sound system not initialized.";
+        if (!frames)
+            frames = 1;
+        
+        // One second of 440 Hz tone
+        ISoundService::SoundBuffer buffer;
+        buffer.frequency_ = 22050;
+        buffer.sixteenbit_ = true;
+        buffer.stereo_ = false;
+        buffer.data_.resize(buffer.frequency_ * sizeof(s16));
+        s16* samples = (s16*)&buffer.data_[0];
+        for (uint j = 0; j < buffer.frequency_; ++j)
+            samples[j] = (s16)(8192.0f * sin(j * 2.0f * PI * 440.0f / buffer.frequency_));
+        SoundPtr sound(new Sound("benchmark_tone"));
+        if (!sound->LoadFromBuffer(buffer))
+            return "Could not create test sound.";
+        
+        // Scatter the sounds evenly over a square around the listener, like sounds attached to prims of a crowded region
+        const float area_size = 200.0f;
+        const Vector3df saved_position = listener_position_;
+        std::vector<sound_id_t> ids;
+        // A fixed seed keeps the runs comparable, without reseeding the generator of the rest of the process
+        boost::mt19937 engine(0);
+        boost::variate_generator<boost::mt19937&, boost::uniform_real<float> > offset(engine,
+            boost::uniform_real<float>(-area_size * 0.5f, area_size * 0.5f));
+        for (uint j = 0; j < count; ++j)
+        {
+            SoundChannelPtr channel(new SoundChannel(ISoundService::Triggered));
+            channel->SetMasterGain(sound_master_gain_[ISoundService::Triggered] * master_gain_);
+            channel->SetPositional(true);
+            const float x = offset();
+            const float y = offset();
+            channel->SetPosition(Vector3df(x, y, 0.0f));
+            channel->SetRange(1.0f, 20.0f, 1.0f);
+            channel->SetLooped(true);
+            channel->Play(sound);
+            
+            sound_id_t id = GetNextSoundChannelID();
+            channels_[id] = channel;
+            ids.push_back(id);
+        }
+        
+        // Walk the listener across the area
+        const f64 frametime = 1.0 / 60.0;
+        const f64 freq = (f64)GetCurrentClockFreq();
+        f64 total_time = 0.0;
+        f64 max_time = 0.0;
+        uint max_real = 0;
+        for (uint f = 0; f < frames; ++f)
+        {
+            listener_position_ = Vector3df(area_size * f / frames - area_size * 0.5f, 0.0f, 0.0f);
+            tick_t start = GetCurrentClockTime();
+            UpdateChannels(frametime);
+            f64 time = (GetCurrentClockTime() - start) / freq;
+            total_time += time;
+            max_time = std::max(max_time, time);
+            max_real = std::max(max_real, real_voices_);
+        }
+        
+        uint sources = 0;
+        for (uint j = 0; j < ids.size(); ++j)
+        {
+            SoundChannelMap::iterator i = channels_.find(ids[j]);
+            if ((i != channels_.end()) && (i->second->HasSource()))
+                ++sources;
+        }
+        uint virtual_voices = virtual_voices_;
+        
+        for (uint j = 0; j < ids.size(); ++j)
+            channels_.erase(ids[j]);
+        listener_position_ = saved_position;
+        
+        std::stringstream result;
+        result << "Sounds: " << count << ", frames: " << frames << ", source limit: " << max_sources_ << std::endl
+            << "Update: average " << total_time * 1000.0 / frames << " ms, max " << max_time * 1000.0 << " ms" << std::endl
+            << "Channels with a source: max " << max_real << ", test sounds on last frame " << sources
+            << ", virtual on last frame " << virtual_voices;
+        return result.str();
     }
     
     void SoundSystem::SetListener(const Vector3df& position, const Quaternion& orientation)
@@ -525,24 +689,112 @@ namespace OpenALAudio
             return false;
         }
 
-        VorbisDecodeRequestPtr new_request(new VorbisDecodeRequest());
-        new_request->name_ = name;
+        SoundDataPtr sound_data(new std::vector<u8>());
     
         std::filebuf *pbuf = file.rdbuf();
         size_t size = pbuf->pubseekoff(0, std::ios::end, std::ios::in);
-        new_request->buffer_.resize(size);
+        sound_data->resize(size);
         pbuf->pubseekpos(0, std::ios::in);
-        pbuf->sgetn((char *)&new_request->buffer_[0], size);
+        if (size)
+            pbuf->sgetn((char *)&(*sound_data)[0], size);
         file.close();
         
+        if (SetStreamedIfLong(sound, sound_data))
+            return true;
+        
+        VorbisDecodeRequestPtr new_request(new VorbisDecodeRequest());
+        new_request->name_ = name;
+        new_request->buffer_.swap(*sound_data);
         framework_->GetThreadTaskManager()->AddRequest("VorbisDecoder", new_request);
         return true;
     }
     
+    bool SoundSystem::SetStreamedIfLong(Sound* sound, SoundDataPtr data)
+    {
+        if (stream_threshold_ <= 0.0 || data->empty())
+            return false;
+        
+        // Only the headers are parsed here; the data is decoded by the decoder thread while playing
+        VorbisStream probe(sound->GetName(), data);
+        if (!probe.Open() || probe.GetDuration() < stream_threshold_)
+            return false;
+        
+        sound->SetStreamData(data, probe.GetDuration(), probe.GetDecodedSize());
+        OpenALAudioModule::LogDebug("Streaming sound " + sound->GetName() + ", duration " + ToString<f64>(probe.GetDuration()) + " seconds");
+        return true;
+    }
+    
+    void SoundSystem::RequestStreamChunks(sound_id_t id, SoundChannel* channel)
+    {
+        uint chunks = channel->GetStreamChunksNeeded();
+        for (uint j = 0; j < chunks; ++j)
+        {
+            VorbisStreamRequestPtr new_request(new VorbisStreamRequest());
+            new_request->stream_ = channel->GetStream();
+            new_request->channel_ = id;
+            new_request->max_size_ = stream_chunk_size_;
+            new_request->loop_ = channel->IsLooped();
+            framework_->GetThreadTaskManager()->AddRequest("VorbisDecoder", new_request);
+            channel->StreamChunkRequested();
+        }
+    }
+    
+    void SoundSystem::HandleStreamResult(VorbisStreamResult* result)
+    {
+        ++stream_stats_.chunks_decoded_;
+        stream_stats_.decode_time_total_ += result->decode_time_;
+        stream_stats_.decode_time_max_ = std::max(stream_stats_.decode_time_max_, result->decode_time_);
+        
+        // The channel may have been stopped or started another sound while the chunk was decoded
+        SoundChannelMap::iterator i = channels_.find(result->channel_);
+        if (i == channels_.end() || i->second->GetStream() != result->stream_)
+            return;
+        SoundChannel* channel = i->second.get();
+        
+        if (channel->IsWaitingForStream() && result->buffer_.data_.size())
+        {
+            f64 first_audio_time = (f64)(GetCurrentClockTime() - channel->GetStreamStartTime()) / (f64)GetCurrentClockFreq();
+            ++stream_stats_.streams_started_;
+            stream_stats_.first_audio_time_total_ += first_audio_time;
+            stream_stats_.first_audio_time_max_ = std::max(stream_stats_.first_audio_time_max_, first_audio_time);
+        }
+        
+        channel->AddStreamChunk(result->buffer_);
+        // Refill right away instead of waiting for next update, to keep the decoder busy during startup
+        RequestStreamChunks(i->first, channel);
+    }
+    
+    void SoundSystem::GetStreamMemoryUse(uint& active_streams, uint& buffered_size, uint& decoded_size) const
+    {
+        active_streams = 0;
+        buffered_size = 0;
+        decoded_size = 0;
+        
+        SoundChannelMap::const_iterator i = channels_.begin();
+        while (i != channels_.end())
+        {
+            if (i->second->GetStream())
+            {
+                ++active_streams;
+                buffered_size += i->second->GetStreamBufferedSize();
+                decoded_size += i->second->GetStreamDecodedSize();
+            }
+            ++i;
+        }
+    }
+    
     bool SoundSystem::HandleTaskEvent(event_id_t event_id, IEventData* data)
     {
         if (event_id != Task::Events::REQUEST_COMPLETED)
             return false;
+        
+        VorbisStreamResult* stream_result = dynamic_cast<VorbisStreamResult*>(data);
+        if (stream_result && stream_result->task_description_ == "VorbisDecoder")
+        {
+            HandleStreamResult(stream_result);
+            return true;
+        }
+        
         VorbisDecodeResult* result = dynamic_cast<VorbisDecodeResult*>(data);
         if (!result || result->task_description_ != "VorbisDecoder")
             return false;
@@ -619,6 +871,11 @@ namespace OpenALAudio
                 // If sound already has data, do not queue another decode request
                 if (i->second->GetSize() != 0)
                     return false;
+                
+                // Long sounds are streamed from the asset data instead of decoding them as a whole
+                SoundDataPtr sound_data(new std::vector<u8>(event_data->asset_->GetData(), event_data->asset_->GetData() + event_data->asset_->GetSize()));
+                if (SetStreamedIfLong(i->second.get(), sound_data))
+                    return false;
             }
             
             VorbisDecodeRequestPtr new_request(new VorbisDecodeRequest());
@@ -18,8 +18,37 @@ class IEventData;
 
 namespace OpenALAudio
 {
+    class VorbisStreamResult;
+    
     typedef std::map<sound_id_t, SoundChannelPtr> SoundChannelMap;
     typedef std::map<std::string, SoundPtr> SoundMap;
+    
+    //! Statistics of streamed sound playback
+    struct SoundStreamStats
+    {
+        SoundStreamStats() :
+            chunks_decoded_(0),
+            decode_time_total_(0.0),
+            decode_time_max_(0.0),
+            streams_started_(0),
+            first_audio_time_total_(0.0),
+            first_audio_time_max_(0.0)
+        {
+        }
+        
+        //! Number of stream chunks decoded
+        uint chunks_decoded_;
+        //! Total time spent decoding stream chunks, in seconds
+        f64 decode_time_total_;
+        //! Longest decode time of a single chunk, in seconds
+        f64 decode_time_max_;
+        //! Number of streams that have started playing
+        uint streams_started_;
+        //! Total time from starting streams to their first audio, in seconds
+        f64 first_audio_time_total_;
+        //! Longest time from starting a stream to its first audio, in seconds
+        f64 first_audio_time_max_;
+    };
       
     //! Sound service implementation. Owned by OpenALAudioModule.
     class SoundSystem : public ISoundService
@@ -225,6 +254,30 @@ namespace OpenALAudio
         
         //! Returns initialized status
         bool IsInitialized() const { return initialized_; }
+        
+        //! Returns statistics of streamed sound playback
+        const SoundStreamStats& GetStreamStats() const { return stream_stats_; }
+        
+        //! Returns memory use of the currently playing streams
+        /*! \param active_streams Number of channels playing a stream
+            \param buffered_size Size of decoded data in the stream buffers, in bytes
+            \param decoded_size Size the streamed sounds would take if fully decoded, in bytes
+         */
+        void GetStreamMemoryUse(uint& active_streams, uint& buffered_size, uint& decoded_size) const;
+        
+        //! Returns chunk size used for decoding streamed sounds, in bytes
+        uint GetStreamChunkSize() const { return stream_chunk_size_; }
+        
+        //! Returns number of channels that had an OpenAL source and that were virtual on last update
+        void GetVoiceCounts(uint& real_voices, uint& virtual_voices) const { real_voices = real_voices_; virtual_voices = virtual_voices_; }
+        
+        //! Plays looped positional test sounds scattered around the listener and measures channel updates
+        /*! The listener is moved across the sounds during the benchmark. The test channels are removed afterwards.
+            \param count Number of sounds
+            \param frames Number of updates to run
+            \return Results as text
+         */
+        std::string BenchmarkVoices(uint count, uint frames);
 
     private:
         //! Uninitialize OpenAL sound
@@ -244,10 +297,24 @@ namespace OpenALAudio
         /* \return true if file could be found & decode initiated. This does not yet tell if the data is valid, though
          */
         bool DecodeLocalOggFile(Sound* sound, const std::string& name);
+        //! Sets sound to be streamed, if it is long enough
+        /*! \return true if sound was set to be streamed. Otherwise the data should be decoded as a whole
+         */
+        bool SetStreamedIfLong(Sound* sound, SoundDataPtr data);
+        //! Posts decode requests for the chunks a streaming channel needs
+        void RequestStreamChunks(sound_id_t id, SoundChannel* channel);
+        //! Handles a decoded chunk of a streamed sound
+        void HandleStreamResult(VorbisStreamResult* result);
         
         //! Update sound cache. Ages sounds and removes oldest if cache too big
         void UpdateCache(f64 frametime);
         
+        //! Update channels and remove stopped ones
+        void UpdateChannels(f64 frametime);
+        
+        //! Rank channels by audibility, and make all but the most audible max_sources_ channels virtual
+        void UpdateVoices();
+        
         //! Framework
         Foundation::Framework* framework_;
         //! Initialized flag
@@ -266,6 +333,20 @@ namespace OpenALAudio
         SoundMap sounds_;
         //! Sound cache size
         uint sound_cache_size_;
+        //! Minimum duration of sounds to stream instead of decoding as a whole, in seconds. 0 disables streaming
+        f64 stream_threshold_;
+        //! Size of decoded stream chunks in bytes
+        uint stream_chunk_size_;
+        //! Streaming statistics
+        SoundStreamStats stream_stats_;
+        //! Maximum number of OpenAL sources to use
+        uint max_sources_;
+        //! Number of channels with a source on last update
+        uint real_voices_;
+        //! Number of virtual channels on last update
+        uint virtual_voices_;
+        //! Audibility and channel of virtualizable channels. Kept to avoid reallocation every frame
+        std::vector<std::pair<float, SoundChannel*> > voice_candidates_;
         //! Update timer (for cache)
         f64 update_time_;
         //! Next channel id
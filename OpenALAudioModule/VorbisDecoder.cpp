@@ -4,87 +4,12 @@
 #include "VorbisDecoder.h"
 #include "OpenALAudioModule.h"
 #include "Profiler.h"
-
-#include <vorbis/vorbisfile.h>
+#include "HighPerfClock.h"
 
 namespace OpenALAudio
 {
-    static const int MAX_DECODE_SIZE = 16384;
-    
-    class OggMemDataSource
-    {
-    public:
-        OggMemDataSource(u8* data, uint size) :
-            data_(data),
-            size_(size),
-            position_(0)    
-        {
-        }
-            
-        size_t Read(void* ptr, size_t size)
-        {
-            uint max_read = size_ - position_;
-            if (size > max_read) size = max_read;
-            if (size)
-            {
-                memcpy(ptr, &data_[position_], size);
-                position_ += size;
-            }
-            return size;
-        }
-            
-        int Seek(ogg_int64_t offset, int whence)
-        {
-            ogg_int64_t new_pos = position_;
-            switch (whence)
-            {
-            case SEEK_SET:
-                new_pos = offset;
-                break;
-                
-            case SEEK_CUR:
-                new_pos += offset;
-                break;
-                
-            case SEEK_END:
-                new_pos = size_ + offset;
-                break;
-            }    
-             
-            if ((new_pos < 0) || (new_pos > size_))
-                return -1;
-            position_ = (uint)new_pos;
-            return 0;
-        }
-        
-        long Tell() const
-        {
-            return (long)position_;
-        }            
-            
-    private:
-        u8* data_;
-        uint size_;
-        uint position_;        
-    };
-
-    size_t OggReadCallback(void* ptr, size_t size, size_t nmemb, void* datasource)
-    {
-        OggMemDataSource* source = (OggMemDataSource*)datasource;
-        return source->Read(ptr, size * nmemb);         
-    }
-    
-    int OggSeekCallback(void* datasource, ogg_int64_t offset, int whence)
-    {
-        OggMemDataSource* source = (OggMemDataSource*)datasource;
-        return source->Seek(offset, whence);
-    }
-    
-    long OggTellCallback(void* datasource)
-    {   
-        OggMemDataSource* source = (OggMemDataSource*)datasource;
-        return source->Tell();
-    }
+    //! Chunk size used when decoding whole sounds
+    static const uint MAX_DECODE_SIZE = 65536;
 
     VorbisDecoder::VorbisDecoder() :
         Foundation::ThreadTask("VorbisDecoder")
@@ -97,12 +22,21 @@ namespace OpenALAudio
         {
             WaitForRequests();
             
-            VorbisDecodeRequestPtr request = GetNextRequest<VorbisDecodeRequest>();
-            if (request)
+            Foundation::ThreadTaskRequestPtr request = GetNextRequest();
+            VorbisDecodeRequestPtr decode_request = boost::dynamic_pointer_cast<VorbisDecodeRequest>(request);
+            if (decode_request)
             {
                 {
                     PROFILE(VorbisDecoder_Decode);
-                    PerformDecode(request);
+                    PerformDecode(decode_request);
+                }
+            }
+            VorbisStreamRequestPtr stream_request = boost::dynamic_pointer_cast<VorbisStreamRequest>(request);
+            if (stream_request)
+            {
+                {
+                    PROFILE(VorbisDecoder_DecodeStream);
+                    PerformStreamDecode(stream_request);
                 }
             }
 
@@ -122,60 +56,56 @@ namespace OpenALAudio
         result->buffer_.sixteenbit_ = true;
         result->buffer_.stereo_ = false;
         
-        OggVorbis_File vf;
-        OggMemDataSource src(&request->buffer_[0], request->buffer_.size());
-        
-        ov_callbacks cb;
-        cb.read_func = &OggReadCallback;
-        cb.seek_func = &OggSeekCallback;
-        cb.tell_func = &OggTellCallback;
-        cb.close_func = 0;
-                       
-        int ret = ov_open_callbacks(&src, &vf, 0, 0, cb);
-        if (ret < 0)
+        SoundDataPtr data(new std::vector<u8>());
+        data->swap(request->buffer_);
+        VorbisStream stream(request->name_, data);
+        if (!stream.Open())
         {
-            OpenALAudioModule::LogError("Not ogg vorbis format");
-            ov_clear(&vf);
             QueueResult<VorbisDecodeResult>(result);
             return;
         }
         
-        vorbis_info* vi = ov_info(&vf, -1);
-        if (vi)
-        {
-            std::ostringstream msg;
-            msg << "Decoding ogg vorbis stream with " << vi->channels << " channels, frequency " << vi->rate; 
-            OpenALAudioModule::LogDebug(msg.str()); 
-            
-            result->buffer_.frequency_ = vi->rate;
-            result->buffer_.stereo_ = (vi->channels == 2); 
-        }
-        else
-        {
-            OpenALAudioModule::LogError("No ogg vorbis stream info");
-            ov_clear(&vf);
-            QueueResult<VorbisDecodeResult>(result);
-            return;
-        }
- 
-        uint decoded_bytes = 0;
-        for (;;)
-        {
-            result->buffer_.data_.resize(decoded_bytes + MAX_DECODE_SIZE);
-            int bitstream;
-            long ret = ov_read(&vf, (char*)&result->buffer_.data_[decoded_bytes], MAX_DECODE_SIZE, 0, 2, 1, &bitstream);
-            if (ret <= 0)
-                break;
-            decoded_bytes += ret;
-        }
+        std::ostringstream msg;
+        msg << "Decoding ogg vorbis stream with " << (stream.IsStereo() ? 2 : 1) << " channels, frequency " << stream.GetFrequency(); 
+        OpenALAudioModule::LogDebug(msg.str()); 
         
-        result->buffer_.data_.resize(decoded_bytes);
+        result->buffer_.frequency_ = stream.GetFrequency();
+        result->buffer_.stereo_ = stream.IsStereo();
         
-        std::ostringstream msg;
-        msg << "Decoded " << decoded_bytes << " bytes of ogg vorbis sound data";
+        result->buffer_.data_.reserve(stream.GetDecodedSize());
+        while (stream.Read(result->buffer_.data_, MAX_DECODE_SIZE))
+            ;
+        
+        msg.str("");
+        msg << "Decoded " << result->buffer_.data_.size() << " bytes of ogg vorbis sound data";
         OpenALAudioModule::LogDebug(msg.str());
          
-        ov_clear(&vf);
         QueueResult<VorbisDecodeResult>(result);
     }
+    
+    void VorbisDecoder::PerformStreamDecode(VorbisStreamRequestPtr request)
+    {
+        if (!request || !request->stream_)
+            return;
+        
+        VorbisStreamResultPtr result(new VorbisStreamResult());
+        result->stream_ = request->stream_;
+        result->channel_ = request->channel_;
+        result->buffer_.frequency_ = 0;
+        result->buffer_.sixteenbit_ = true;
+        result->buffer_.stereo_ = false;
+        result->decode_time_ = 0.0;
+        
+        VorbisStream* stream = request->stream_.get();
+        tick_t start = GetCurrentClockTime();
+        if (stream->Open())
+        {
+            result->buffer_.frequency_ = stream->GetFrequency();
+            result->buffer_.stereo_ = stream->IsStereo();
+            stream->Read(result->buffer_.data_, request->max_size_, request->loop_);
+        }
+        result->decode_time_ = (f64)(GetCurrentClockTime() - start) / GetCurrentClockFreq();
+        
+        QueueResult<VorbisStreamResult>(result);
+    }
 }
\ No newline at end of file
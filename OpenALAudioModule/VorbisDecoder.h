@@ -4,6 +4,7 @@
 
 #include "ISoundService.h"
 #include "ThreadTask.h"
+#include "VorbisStream.h"
 
 namespace OpenALAudio
 {
@@ -28,8 +29,37 @@ namespace OpenALAudio
         ISoundService::SoundBuffer buffer_;
     };
     
+    //! Request to decode the next chunk of a streamed sound
+    class VorbisStreamRequest : public Foundation::ThreadTaskRequest
+    {
+    public:
+        //! Stream to decode. Requests of one stream are served in order
+        VorbisStreamPtr stream_;
+        //! Sound channel the stream is playing on
+        sound_id_t channel_;
+        //! Maximum size of decoded chunk in bytes
+        uint max_size_;
+        //! Whether to continue from the beginning at the end of stream
+        bool loop_;
+    };
+    
+    class VorbisStreamResult : public Foundation::ThreadTaskResult
+    {
+    public:
+        //! Decoded stream
+        VorbisStreamPtr stream_;
+        //! Sound channel the stream is playing on
+        sound_id_t channel_;
+        //! Decoded chunk. Will always be 16bit signed. Zero size at end of stream
+        ISoundService::SoundBuffer buffer_;
+        //! Time spent decoding the chunk, in seconds
+        f64 decode_time_;
+    };
+    
     typedef boost::shared_ptr<VorbisDecodeRequest> VorbisDecodeRequestPtr;
     typedef boost::shared_ptr<VorbisDecodeResult> VorbisDecodeResultPtr;
+    typedef boost::shared_ptr<VorbisStreamRequest> VorbisStreamRequestPtr;
+    typedef boost::shared_ptr<VorbisStreamResult> VorbisStreamResultPtr;
 
     //! Ogg Vorbis decoder that runs in a thread and serves decode requests, used by SoundSystem
     class VorbisDecoder : public Foundation::ThreadTask
@@ -47,7 +77,12 @@ namespace OpenALAudio
          */
         void PerformDecode(VorbisDecodeRequestPtr request);
         
+        //! decode next chunk of a stream & queue result
+        /*! \param request stream decode request to serve
+         */
+        void PerformStreamDecode(VorbisStreamRequestPtr request);
+        
         uint decodes_per_frame_;
     };
 }
-#endif
\ No newline at end of file
+#endif
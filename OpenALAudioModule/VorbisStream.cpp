@@ -0,0 +1,193 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+
+#include "StableHeaders.h"
+#include "VorbisStream.h"
+#include "OpenALAudioModule.h"
+
+#include <vorbis/vorbisfile.h>
+
+namespace OpenALAudio
+{
+    static const int MAX_DECODE_SIZE = 16384;
+    
+    class OggMemDataSource
+    {
+    public:
+        OggMemDataSource(u8* data, uint size) :
+            data_(data),
+            size_(size),
+            position_(0)    
+        {
+        }
+            
+        size_t Read(void* ptr, size_t size)
+        {
+            uint max_read = size_ - position_;
+            if (size > max_read) size = max_read;
+            if (size)
+            {
+                memcpy(ptr, &data_[position_], size);
+                position_ += size;
+            }
+            return size;
+        }
+            
+        int Seek(ogg_int64_t offset, int whence)
+        {
+            ogg_int64_t new_pos = position_;
+            switch (whence)
+            {
+            case SEEK_SET:
+                new_pos = offset;
+                break;
+                
+            case SEEK_CUR:
+                new_pos += offset;
+                break;
+                
+            case SEEK_END:
+                new_pos = size_ + offset;
+                break;
+            }    
+             
+            if ((new_pos < 0) || (new_pos > size_))
+                return -1;
+            position_ = (uint)new_pos;
+            return 0;
+        }
+        
+        long Tell() const
+        {
+            return (long)position_;
+        }            
+            
+    private:
+        u8* data_;
+        uint size_;
+        uint position_;        
+    };
+
+    static size_t OggReadCallback(void* ptr, size_t size, size_t nmemb, void* datasource)
+    {
+        OggMemDataSource* source = (OggMemDataSource*)datasource;
+        return source->Read(ptr, size * nmemb);         
+    }
+    
+    static int OggSeekCallback(void* datasource, ogg_int64_t offset, int whence)
+    {
+        OggMemDataSource* source = (OggMemDataSource*)datasource;
+        return source->Seek(offset, whence);
+    }
+    
+    static long OggTellCallback(void* datasource)
+    {   
+        OggMemDataSource* source = (OggMemDataSource*)datasource;
+        return source->Tell();
+    }
+
+    VorbisStream::VorbisStream(const std::string& name, SoundDataPtr data) :
+        name_(name),
+        data_(data),
+        source_(0),
+        file_(0),
+        frequency_(0),
+        stereo_(false),
+        duration_(0.0),
+        start_time_(0.0)
+    {
+    }
+    
+    VorbisStream::~VorbisStream()
+    {
+        if (file_)
+        {
+            ov_clear(file_);
+            delete file_;
+        }
+        delete source_;
+    }
+    
+    bool VorbisStream::Open()
+    {
+        if (file_)
+            return true;
+        if (!data_ || data_->empty())
+            return false;
+        
+        delete source_;
+        source_ = new OggMemDataSource(&(*data_)[0], data_->size());
+        
+        ov_callbacks cb;
+        cb.read_func = &OggReadCallback;
+        cb.seek_func = &OggSeekCallback;
+        cb.tell_func = &OggTellCallback;
+        cb.close_func = 0;
+        
+        OggVorbis_File* file = new OggVorbis_File;
+        int ret = ov_open_callbacks(source_, file, 0, 0, cb);
+        if (ret < 0)
+        {
+            OpenALAudioModule::LogError("Not ogg vorbis format");
+            ov_clear(file);
+            delete file;
+            return false;
+        }
+        
+        vorbis_info* vi = ov_info(file, -1);
+        if (!vi)
+        {
+            OpenALAudioModule::LogError("No ogg vorbis stream info");
+            ov_clear(file);
+            delete file;
+            return false;
+        }
+        
+        file_ = file;
+        frequency_ = vi->rate;
+        stereo_ = (vi->channels == 2);
+        double duration = ov_time_total(file_, -1);
+        duration_ = duration > 0.0 ? duration : 0.0;
+        
+        if (start_time_ > 0.0 && start_time_ < duration_ && ov_time_seek(file_, start_time_) != 0)
+            OpenALAudioModule::LogWarning("Could not seek ogg vorbis stream " + name_);
+        return true;
+    }
+    
+    uint VorbisStream::Read(std::vector<u8>& data, uint max_bytes, bool loop)
+    {
+        if (!file_)
+            return 0;
+        
+        uint start = data.size();
+        uint decoded_bytes = 0;
+        bool rewound = false;
+        data.resize(start + max_bytes);
+        while (decoded_bytes < max_bytes)
+        {
+            int read_size = std::min<int>(MAX_DECODE_SIZE, max_bytes - decoded_bytes);
+            int bitstream;
+            long ret = ov_read(file_, (char*)&data[start + decoded_bytes], read_size, 0, 2, 1, &bitstream);
+            if (ret > 0)
+            {
+                decoded_bytes += ret;
+                rewound = false;
+                continue;
+            }
+            // At the end of a looped stream, start over. Give up if the stream produces no data after a rewind
+            if (ret == 0 && loop && !rewound && ov_pcm_seek(file_, 0) == 0)
+            {
+                rewound = true;
+                continue;
+            }
+            break;
+        }
+        
+        data.resize(start + decoded_bytes);
+        return decoded_bytes;
+    }
+    
+    uint VorbisStream::GetDecodedSize() const
+    {
+        return (uint)(duration_ * frequency_) * (stereo_ ? 4 : 2);
+    }
+}
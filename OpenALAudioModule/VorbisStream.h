@@ -0,0 +1,85 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+#ifndef incl_OpenALAudio_VorbisStream_h
+#define incl_OpenALAudio_VorbisStream_h
+
+#include "CoreTypes.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <vector>
+
+struct OggVorbis_File;
+
+namespace OpenALAudio
+{
+    class OggMemDataSource;
+
+    //! Compressed sound data shared between a cached sound and the streams playing it
+    typedef boost::shared_ptr<std::vector<u8> > SoundDataPtr;
+
+    //! Incremental decoder of an in-memory Ogg Vorbis stream.
+    /*! Used by VorbisDecoder both for decoding whole sounds and for decoding streamed sounds in chunks.
+        A stream is not threadsafe: after it has been handed to the decoder thread, only the decoder thread
+        may use it. The compressed data is shared and never modified, so several streams may play the same data.
+     */
+    class VorbisStream : public boost::noncopyable
+    {
+    public:
+        //! Constructor
+        /*! \param name Name/id of sound
+            \param data Ogg Vorbis data
+         */
+        VorbisStream(const std::string& name, SoundDataPtr data);
+        //! Destructor
+        ~VorbisStream();
+
+        //! Parse stream headers. Returns true if the data is a valid Ogg Vorbis stream
+        bool Open();
+        //! Return whether stream has been successfully opened
+        bool IsOpen() const { return file_ != 0; }
+        //! Set time in seconds to start decoding from. Must be called before Open()
+        void SetStartTime(f64 time) { start_time_ = time; }
+
+        //! Decode up to max_bytes of 16bit signed PCM data, appended to data
+        /*! \param loop Whether to continue from the beginning when the end of the stream is reached
+            \return Number of bytes decoded, 0 at the end of stream
+         */
+        uint Read(std::vector<u8>& data, uint max_bytes, bool loop = false);
+
+        //! Return name/id of sound
+        const std::string& GetName() const { return name_; }
+        //! Return compressed data
+        const SoundDataPtr& GetData() const { return data_; }
+        //! Return frequency
+        uint GetFrequency() const { return frequency_; }
+        //! Return stereo flag
+        bool IsStereo() const { return stereo_; }
+        //! Return duration in seconds
+        f64 GetDuration() const { return duration_; }
+        //! Return size of the whole stream when decoded, in bytes
+        uint GetDecodedSize() const;
+
+    private:
+        //! Name/id of sound
+        std::string name_;
+        //! Compressed data
+        SoundDataPtr data_;
+        //! Read position in compressed data
+        OggMemDataSource* source_;
+        //! Vorbisfile decoder state, null if not open
+        OggVorbis_File* file_;
+        //! Frequency
+        uint frequency_;
+        //! Stereo flag
+        bool stereo_;
+        //! Duration in seconds
+        f64 duration_;
+        //! Time to start decoding from, in seconds
+        f64 start_time_;
+    };
+
+    typedef boost::shared_ptr<VorbisStream> VorbisStreamPtr;
+}
+
+#endif
@@ -9,6 +9,7 @@
 #include "OpenSimLoginThread.h"
 #include "ProtocolModuleOpenSim.h"
 #include "XmlRpcEpi.h"
+#include "XmlRpcStreamReader.h"
 
 // ProtocolUtilities includes
 #include "OpenSim/OpenSimAuth.h"
@@ -19,6 +20,7 @@
 #include "Md5.h"
 #include "Framework.h"
 #include "ConfigurationManager.h"
+#include "HighPerfClock.h"
 
 // Extenal lib includes
 #include <boost/shared_ptr.hpp>
@@ -255,10 +257,21 @@ namespace OpenSimProtocol
             return false;
         }
 
+        // Read the login reply as it arrives, so that the inventory skeleton and buddy list are collected
+        // to compact structures instead of the whole reply being built in memory first.
+        XmlRpcStreamReader reader;
+        InventoryStreamParser inventoryParser(reader);
+        BuddyListStreamParser buddyListParser(reader);
+        bool streamed = callMethod_ == LOGIN_TO_SIMULATOR &&
+            framework_->GetDefaultConfig().DeclareSetting("ProtocolModuleOpenSim", "stream_login_reply", true);
+        if (streamed)
+            call.SetStreamReader(&reader);
+
         /////////////////////////////////////
         //           SEND CALL             //
         /////////////////////////////////////
 
+        tick_t sendStart = GetCurrentClockTime();
         try
         {
             call.Send();
@@ -275,6 +288,8 @@ namespace OpenSimProtocol
             return false;
         }
 
+        tick_t replyReceived = GetCurrentClockTime();
+
         /////////////////////////////////////
         //          PARSE RESULTS          //
         /////////////////////////////////////
@@ -306,28 +321,7 @@ namespace OpenSimProtocol
                     threadState_->parameters.circuitCode == 0)
                     throw XmlRpcException("Failed to receive sessionID, agentID or circuitCode from login_to_simulator reply!");
 
-                // Inventory
-                try
-                {
-                    threadState_->parameters.inventory = InventoryParser::ExtractInventoryFromXMLRPCReply(call);
-                }
-                catch (XmlRpcException &e)
-                {
-                    ProtocolModuleOpenSim::LogWarning(QString("Failed to read inventory: %1").arg(e.what()).toStdString());
-                    threadState_->parameters.inventory = boost::shared_ptr<InventorySkeleton>(new InventorySkeleton);
-                    InventoryParser::SetErrorFolder(threadState_->parameters.inventory->GetRoot());
-                }
-
-                // Buddy List
-                try
-                {
-                    threadState_->parameters.buddy_list = BuddyListParser::ExtractBuddyListFromXMLRPCReply(call);
-                }
-                catch (XmlRpcException &e)
-                {
-                    ProtocolModuleOpenSim::LogWarning(QString("Failed to read buddy list: %1").arg(e.what()).toStdString());
-                    threadState_->parameters.buddy_list = BuddyListPtr(new BuddyList());
-                }
+                ExtractInventoryAndBuddyList(call, streamed ? &inventoryParser : 0, streamed ? &buddyListParser : 0);
             }
             else if (authentication_ == REALXTEND_AUTHENTICATION && callMethod_ == CLIENT_AUTHENTICATION) 
             {
@@ -357,28 +351,7 @@ namespace OpenSimProtocol
                 if (threadState_->parameters.gridUrl.size() == 0)
                     throw XmlRpcException("Failed to extract sim_ip and sim_port from login_to_simulator reply!");
 
-                // Inventory
-                try
-                {
-                    threadState_->parameters.inventory = InventoryParser::ExtractInventoryFromXMLRPCReply(call);
-                }
-                catch(XmlRpcException &e)
-                {
-                    ProtocolModuleOpenSim::LogWarning(QString("Failed to read inventory: %1").arg(e.what()).toStdString());
-                    threadState_->parameters.inventory = boost::shared_ptr<InventorySkeleton>(new InventorySkeleton);
-                    InventoryParser::SetErrorFolder(threadState_->parameters.inventory->GetRoot());
-                }
-
-                // Buddy List
-                try
-                {
-                    threadState_->parameters.buddy_list = BuddyListParser::ExtractBuddyListFromXMLRPCReply(call);
-                }
-                catch(XmlRpcException &e)
-                {
-                    ProtocolModuleOpenSim::LogWarning(QString("Failed to read buddy list: %1").arg(e.what()).toStdString());
-                    threadState_->parameters.buddy_list = BuddyListPtr(new BuddyList());
-                }
+                ExtractInventoryAndBuddyList(call, streamed ? &inventoryParser : 0, streamed ? &buddyListParser : 0);
             }
             else
                 throw XmlRpcException(QString("Undefined login method %1 at parsing call results in PerformXMLRPCLogin()").arg(callMethod_.c_str()).toStdString());
@@ -398,9 +371,64 @@ namespace OpenSimProtocol
             }
             return false;
         }
+
+        if (callMethod_ == LOGIN_TO_SIMULATOR)
+        {
+            f64 freq = (f64)GetCurrentClockFreq();
+            f64 receiveTime = (replyReceived - sendStart) / freq;
+            f64 buildTime = (GetCurrentClockTime() - replyReceived) / freq;
+            if (streamed)
+            {
+                const XmlRpcStreamReader::Stats &stats = reader.GetStats();
+                ProtocolModuleOpenSim::LogInfo(QString("Login reply of %1 bytes received in %2 ms, of which %3 ms parsing. "
+                    "Inventory of %4 folders and %5 buddies built in %6 ms. At most %7 bytes held by the reply parser.")
+                    .arg(stats.bytes).arg(receiveTime * 1000.0, 0, 'f', 1).arg(stats.parseTime * 1000.0, 0, 'f', 1)
+                    .arg(inventoryParser.GetFolderCount()).arg(buddyListParser.GetBuddyCount())
+                    .arg(buildTime * 1000.0, 0, 'f', 1).arg(stats.peakBytesHeld).toStdString());
+            }
+            else
+                ProtocolModuleOpenSim::LogInfo(QString("Login reply received and parsed in %1 ms, inventory and buddy list read in %2 ms.")
+                    .arg(receiveTime * 1000.0, 0, 'f', 1).arg(buildTime * 1000.0, 0, 'f', 1).toStdString());
+        }
+
         return true;
     }
 
+    void OpenSimLoginThread::ExtractInventoryAndBuddyList(XmlRpcEpi &call, ProtocolUtilities::InventoryStreamParser *inventoryParser,
+        ProtocolUtilities::BuddyListStreamParser *buddyListParser)
+    {
+        using namespace ProtocolUtilities;
+
+        // Inventory
+        try
+        {
+            if (inventoryParser)
+                threadState_->parameters.inventory = inventoryParser->ExtractInventory();
+            else
+                threadState_->parameters.inventory = InventoryParser::ExtractInventoryFromXMLRPCReply(call);
+        }
+        catch (XmlRpcException &e)
+        {
+            ProtocolModuleOpenSim::LogWarning(QString("Failed to read inventory: %1").arg(e.what()).toStdString());
+            threadState_->parameters.inventory = boost::shared_ptr<InventorySkeleton>(new InventorySkeleton);
+            InventoryParser::SetErrorFolder(threadState_->parameters.inventory->GetRoot());
+        }
+
+        // Buddy List
+        try
+        {
+            if (buddyListParser)
+                threadState_->parameters.buddy_list = buddyListParser->ExtractBuddyList();
+            else
+                threadState_->parameters.buddy_list = BuddyListParser::ExtractBuddyListFromXMLRPCReply(call);
+        }
+        catch (XmlRpcException &e)
+        {
+            ProtocolModuleOpenSim::LogWarning(QString("Failed to read buddy list: %1").arg(e.what()).toStdString());
+            threadState_->parameters.buddy_list = BuddyListPtr(new BuddyList());
+        }
+    }
+
     volatile ProtocolUtilities::Connection::State OpenSimLoginThread::GetState() const
     {
         if (!ready_)
@@ -18,6 +18,14 @@ namespace Foundation
     class Framework;
 }
 
+namespace ProtocolUtilities
+{
+    class InventoryStreamParser;
+    class BuddyListStreamParser;
+}
+
+class XmlRpcEpi;
+
 namespace OpenSimProtocol
 {
     /// XML-RPC login worker.
@@ -113,6 +121,12 @@ namespace OpenSimProtocol
     private:
         Q_DISABLE_COPY(OpenSimLoginThread);
 
+        /// Reads the inventory and buddy list of a login_to_simulator reply to the client parameters.
+        /// @param inventoryParser Parser the inventory was read with if the reply was streamed, or null to read it from @p call.
+        /// @param buddyListParser Parser the buddy list was read with if the reply was streamed, or null to read it from @p call.
+        void ExtractInventoryAndBuddyList(XmlRpcEpi &call, ProtocolUtilities::InventoryStreamParser *inventoryParser,
+            ProtocolUtilities::BuddyListStreamParser *buddyListParser);
+
         /// Triggers the XML-RPC login procedure.
         bool start_login_;
 
@@ -130,6 +130,8 @@ namespace TaigaProtocol
                 {
                     LogError(e.what());
                     LogError("Network error occured. Closing server connection.");
+                    // Close without sending the queued datagrams, as the connection has failed
+                    networkManager_->Disconnect(false);
                     DisconnectFromServer();
                 }
             }
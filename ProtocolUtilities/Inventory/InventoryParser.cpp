@@ -10,10 +10,66 @@
 
 #include "Inventory/InventorySkeleton.h"
 #include "InventoryParser.h"
+#include "CoreStringUtils.h"
+
+#include <boost/bind.hpp>
 
 namespace ProtocolUtilities
 {
 
+namespace
+{
+    /// Reads the folders of a inventory-skeleton or inventory-skel-lib array.
+    void ReadFolders(XMLRPC_VALUE node, InventoryParser::FolderRecordList &folders)
+    {
+        XMLRPC_VALUE item = XMLRPC_VectorRewind(node);
+        while(item)
+        {
+            XMLRPC_VALUE_TYPE type = XMLRPC_GetValueType(item);
+            if (type == xmlrpc_vector) // xmlrpc-epi handles structs as arrays.
+            {
+                InventoryParser::FolderRecord folder;
+
+                XMLRPC_VALUE val = XMLRPC_VectorGetValueWithID(item, "name");
+                if (val && XMLRPC_GetValueType(val) == xmlrpc_string)
+                    folder.name = XMLRPC_GetValueString(val);
+
+                val = XMLRPC_VectorGetValueWithID(item, "parent_id");
+                if (val && XMLRPC_GetValueType(val) == xmlrpc_string)
+                    folder.parent_id.FromString(XMLRPC_GetValueString(val));
+
+                val = XMLRPC_VectorGetValueWithID(item, "version");
+                if (val && XMLRPC_GetValueType(val) == xmlrpc_int)
+                    folder.version = XMLRPC_GetValueInt(val);
+
+                val = XMLRPC_VectorGetValueWithID(item, "type_default");
+                if (val && XMLRPC_GetValueType(val) == xmlrpc_int)
+                    folder.type_default = XMLRPC_GetValueInt(val);
+
+                val = XMLRPC_VectorGetValueWithID(item, "folder_id");
+                if (val && XMLRPC_GetValueType(val) == xmlrpc_string)
+                    folder.id.FromString(XMLRPC_GetValueString(val));
+
+                folders.push_back(folder);
+            }
+
+            item = XMLRPC_VectorNext(node);
+        }
+    }
+
+    /// Creates the tree folder of a folder record.
+    InventoryFolderSkeleton MakeFolder(const InventoryParser::FolderRecord &record, bool editable)
+    {
+        InventoryFolderSkeleton folder;
+        folder.id = record.id;
+        folder.name = record.name;
+        folder.version = record.version;
+        folder.type_default = record.type_default;
+        folder.editable = editable;
+        return folder;
+    }
+}
+
 // static
 bool InventoryParser::IsHardcodedOpenSimFolder(const char *name)
 {
@@ -58,43 +114,8 @@ boost::shared_ptr<ProtocolUtilities::InventorySkeleton> InventoryParser::Extract
     if (!inventoryNode || XMLRPC_GetValueType(inventoryNode) != xmlrpc_vector)
         throw XmlRpcException("Failed to read inventory, inventory-skeleton in the reply was not properly formed!");
 
-    typedef std::pair<RexUUID, ProtocolUtilities::InventoryFolderSkeleton> DetachedInventoryFolder;
-    typedef std::list<DetachedInventoryFolder> DetachedInventoryFolderList;
-    DetachedInventoryFolderList folders;
-
-    XMLRPC_VALUE item = XMLRPC_VectorRewind(inventoryNode);
-    while(item)
-    {
-        XMLRPC_VALUE_TYPE type = XMLRPC_GetValueType(item);
-        if (type == xmlrpc_vector) // xmlrpc-epi handles structs as arrays.
-        {
-            DetachedInventoryFolder folder;
-
-            XMLRPC_VALUE val = XMLRPC_VectorGetValueWithID(item, "name");
-            if (val && XMLRPC_GetValueType(val) == xmlrpc_string)
-                folder.second.name = XMLRPC_GetValueString(val);
-
-            val = XMLRPC_VectorGetValueWithID(item, "parent_id");
-            if (val && XMLRPC_GetValueType(val) == xmlrpc_string)
-                folder.first.FromString(XMLRPC_GetValueString(val));
-
-            val = XMLRPC_VectorGetValueWithID(item, "version");
-            if (val && XMLRPC_GetValueType(val) == xmlrpc_int)
-                folder.second.version = XMLRPC_GetValueInt(val);
-
-            val = XMLRPC_VectorGetValueWithID(item, "type_default");
-            if (val && XMLRPC_GetValueType(val) == xmlrpc_int)
-                folder.second.type_default = XMLRPC_GetValueInt(val);
-
-            val = XMLRPC_VectorGetValueWithID(item, "folder_id");
-            if (val && XMLRPC_GetValueType(val) == xmlrpc_string)
-                folder.second.id.FromString(XMLRPC_GetValueString(val));
-
-            folders.push_back(folder);
-        }
-
-        item = XMLRPC_VectorNext(inventoryNode);
-    }
+    InventoryParser::FolderRecordList folders;
+    ReadFolders(inventoryNode, folders);
 
     // Find and set the inventory root folder.
     XMLRPC_VALUE inventoryRootNode = XMLRPC_VectorGetValueWithID(result, "inventory-root");
@@ -116,54 +137,9 @@ boost::shared_ptr<ProtocolUtilities::InventorySkeleton> InventoryParser::Extract
     if (inventoryRootFolderID.IsNull())
         throw XmlRpcException("Failed to read inventory, inventory-root value folder_id was null or unparseable!");
 
-    // Find the root folder from the list of detached folders, and set it as the root folder to start with.
-    for(DetachedInventoryFolderList::iterator iter = folders.begin(); iter != folders.end(); ++iter)
-    {
-        if (iter->second.id == inventoryRootFolderID)
-        {
-            ProtocolUtilities::InventoryFolderSkeleton *root = inventory->GetRoot();
-            iter->second.editable = false;
-            root->AddChildFolder(iter->second);
-            folders.erase(iter);
-            break;
-        }
-    }
-
-    if ( inventory->GetFirstChildFolderByName("My Inventory") == 0) 
-        throw XmlRpcException("Failed to read inventory, inventory-root value folder_id pointed to a nonexisting folder!");
-
-    if (inventory->GetFirstChildFolderByName("My Inventory")->id != inventoryRootFolderID)
+    ProtocolUtilities::InventoryFolderSkeleton *root = AddFolders(*inventory, folders, inventoryRootFolderID, false);
+    if (!root || root->name != "My Inventory")
         throw XmlRpcException("Failed to read inventory, inventory-root value folder_id pointed to a nonexisting folder!");
-    
-
-    // Insert the detached folders onto the tree view until all folders have been added or there are orphans left
-    // that cannot be added, and quit.
-    bool progress = true;
-    while(folders.size() > 0 && progress)
-    {
-        progress = false;
-        DetachedInventoryFolderList::iterator iter = folders.begin();
-        while(iter != folders.end())
-        {
-            DetachedInventoryFolderList::iterator next = iter;
-            ++next;
-
-            ProtocolUtilities::InventoryFolderSkeleton *parent = inventory->GetChildFolderById(iter->first);
-            if (parent)
-            {
-                // Mark harcoded OpenSim Library folders non-editable.
-                if (parent->id == inventoryRootFolderID &&
-                    IsHardcodedOpenSimFolder(iter->second.name.c_str()))
-                    iter->second.editable = false;
-
-                parent->AddChildFolder(iter->second);
-                progress = true;
-                folders.erase(iter);
-            }
-
-            iter = next;
-        }
-    }
 
     /********** World Library **********/
 
@@ -213,41 +189,8 @@ boost::shared_ptr<ProtocolUtilities::InventorySkeleton> InventoryParser::Extract
         return inventory;
     }
 
-    DetachedInventoryFolderList library_folders;
-
-    item = XMLRPC_VectorRewind(inventoryLibraryNode);
-    while(item)
-    {
-        XMLRPC_VALUE_TYPE type = XMLRPC_GetValueType(item);
-        if (type == xmlrpc_vector) // xmlrpc-epi handles structs as arrays.
-        {
-            DetachedInventoryFolder folder;
-
-            XMLRPC_VALUE val = XMLRPC_VectorGetValueWithID(item, "name");
-            if (val && XMLRPC_GetValueType(val) == xmlrpc_string)
-                folder.second.name = XMLRPC_GetValueString(val);
-
-            val = XMLRPC_VectorGetValueWithID(item, "parent_id");
-            if (val && XMLRPC_GetValueType(val) == xmlrpc_string)
-                folder.first.FromString(XMLRPC_GetValueString(val));
-
-            val = XMLRPC_VectorGetValueWithID(item, "version");
-            if (val && XMLRPC_GetValueType(val) == xmlrpc_int)
-                folder.second.version = XMLRPC_GetValueInt(val);
-
-            val = XMLRPC_VectorGetValueWithID(item, "type_default");
-            if (val && XMLRPC_GetValueType(val) == xmlrpc_int)
-                folder.second.type_default = XMLRPC_GetValueInt(val);
-
-            val = XMLRPC_VectorGetValueWithID(item, "folder_id");
-            if (val && XMLRPC_GetValueType(val) == xmlrpc_string)
-                folder.second.id.FromString(XMLRPC_GetValueString(val));
-
-            library_folders.push_back(folder);
-        }
-
-        item = XMLRPC_VectorNext(inventoryLibraryNode);
-    }
+    InventoryParser::FolderRecordList library_folders;
+    ReadFolders(inventoryLibraryNode, library_folders);
 
     // Find and set the world library root folder.
     XMLRPC_VALUE inventoryLibraryRootNode = XMLRPC_VectorGetValueWithID(result, "inventory-lib-root");
@@ -269,49 +212,166 @@ boost::shared_ptr<ProtocolUtilities::InventorySkeleton> InventoryParser::Extract
     if (inventoryLibraryRootFolderID.IsNull())
         throw XmlRpcException("Failed to read inventory, inventory-lib-root value folder_id was null or unparseable!");
 
-    // Find the root folder from the list of detached folders, and set it as the root folder to start with.
-    for(DetachedInventoryFolderList::iterator iter = library_folders.begin(); iter != library_folders.end(); ++iter)
+    if (!AddFolders(*inventory, library_folders, inventoryLibraryRootFolderID, true))
+        throw XmlRpcException("Failed to read inventory, inventory-lib-root value folder_id pointed to a nonexisting folder!");
+
+    return inventory;
+}
+
+// static
+ProtocolUtilities::InventoryFolderSkeleton *InventoryParser::AddFolders(InventorySkeleton &inventory,
+    const FolderRecordList &folders, const RexUUID &rootId, bool library)
+{
+    // Index the folders by their parents, so that each folder is looked up once instead of the tree being
+    // searched for the parent of every folder.
+    typedef std::map<RexUUID, std::vector<size_t> > ChildIndex;
+    ChildIndex children;
+    size_t root_index = folders.size();
+    for(size_t i = 0; i < folders.size(); ++i)
     {
-        if (iter->second.id == inventoryLibraryRootFolderID)
-        {
-            ProtocolUtilities::InventoryFolderSkeleton *root = inventory->GetRoot();
-            iter->second.editable = false;
-            root->AddChildFolder(iter->second);
-            library_folders.erase(iter);
-            break;
-        }
+        if (root_index == folders.size() && folders[i].id == rootId)
+            root_index = i;
+        else
+            children[folders[i].parent_id].push_back(i);
     }
 
-    ProtocolUtilities::InventoryFolderSkeleton *worldLibrary = inventory->GetChildFolderById(inventoryLibraryRootFolderID);
-    if (!worldLibrary)
-        throw XmlRpcException("Failed to read inventory, inventory-lib-root value folder_id pointed to a nonexisting folder!");
+    if (root_index == folders.size())
+        return 0;
+
+    ProtocolUtilities::InventoryFolderSkeleton *root = inventory.GetRoot()->AddChildFolder(MakeFolder(folders[root_index], false));
 
-    // Insert the detached folders onto the tree view until all folders have been added or there are orphans left
-    // that cannot be added, and quit.
-    progress = true;
-    while(library_folders.size() > 0 && progress)
+    // Add the descendants of the root breadth first. Folders that are not reached are orphans and are left out.
+    std::vector<bool> added(folders.size(), false);
+    added[root_index] = true;
+    std::queue<ProtocolUtilities::InventoryFolderSkeleton *> parents;
+    parents.push(root);
+    while(!parents.empty())
     {
-        progress = false;
-        DetachedInventoryFolderList::iterator iter = library_folders.begin();
-        while(iter != library_folders.end())
-        {
-            DetachedInventoryFolderList::iterator next = iter;
-            ++next;
+        ProtocolUtilities::InventoryFolderSkeleton *parent = parents.front();
+        parents.pop();
 
-            ProtocolUtilities::InventoryFolderSkeleton *parent = inventory->GetChildFolderById(iter->first);
-            if (parent)
-            {
-                // Mark all World Libary folder descendents non-editable.
-                iter->second.editable = false;
-                parent->AddChildFolder(iter->second);
-                progress = true;
-                library_folders.erase(iter);
-            }
+        ChildIndex::const_iterator iter = children.find(parent->id);
+        if (iter == children.end())
+            continue;
 
-            iter = next;
+        const std::vector<size_t> &indices = iter->second;
+        for(size_t i = 0; i < indices.size(); ++i)
+        {
+            if (added[indices[i]])
+                continue;
+            added[indices[i]] = true;
+
+            const FolderRecord &record = folders[indices[i]];
+            // Mark all World Libary folder descendents and the harcoded OpenSim folders non-editable.
+            bool editable = !library && !(parent == root && IsHardcodedOpenSimFolder(record.name.c_str()));
+            parents.push(parent->AddChildFolder(MakeFolder(record, editable)));
         }
     }
 
+    return root;
+}
+
+InventoryStreamParser::InventoryStreamParser(XmlRpcStreamReader &reader) :
+    reader_(reader)
+{
+    reader_.SetArrayHandler("inventory-skeleton", boost::bind(&InventoryStreamParser::HandleFolder, this, _1, &folders_));
+    reader_.SetArrayHandler("inventory-skel-lib", boost::bind(&InventoryStreamParser::HandleFolder, this, _1, &library_folders_));
+    reader_.SetArrayHandler("inventory-root", boost::bind(&InventoryStreamParser::HandleFolderId, this, _1, &root_id_));
+    reader_.SetArrayHandler("inventory-lib-root", boost::bind(&InventoryStreamParser::HandleFolderId, this, _1, &library_root_id_));
+    reader_.SetArrayHandler("inventory-lib-owner", boost::bind(&InventoryStreamParser::HandleLibraryOwner, this, _1));
+}
+
+void InventoryStreamParser::HandleFolder(const XmlRpcStreamReader::Members &element, InventoryParser::FolderRecordList *folders)
+{
+    folders->push_back(InventoryParser::FolderRecord());
+    InventoryParser::FolderRecord &folder = folders->back();
+
+    const std::string *val = XmlRpcStreamReader::GetMember(element, "name");
+    if (val)
+        folder.name = *val;
+
+    val = XmlRpcStreamReader::GetMember(element, "parent_id");
+    if (val)
+        folder.parent_id.FromString(*val);
+
+    val = XmlRpcStreamReader::GetMember(element, "version");
+    if (val)
+        folder.version = ParseString<int>(*val, 0);
+
+    val = XmlRpcStreamReader::GetMember(element, "type_default");
+    if (val)
+        folder.type_default = ParseString<int>(*val, 0);
+
+    val = XmlRpcStreamReader::GetMember(element, "folder_id");
+    if (val)
+        folder.id.FromString(*val);
+}
+
+void InventoryStreamParser::HandleFolderId(const XmlRpcStreamReader::Members &element, RexUUID *id)
+{
+    // The first element of the array is used
+    const std::string *val = XmlRpcStreamReader::GetMember(element, "folder_id");
+    if (val && id->IsNull())
+        id->FromString(*val);
+}
+
+void InventoryStreamParser::HandleLibraryOwner(const XmlRpcStreamReader::Members &element)
+{
+    // In legacy servers inventory-lib-owner is array.
+    const std::string *val = XmlRpcStreamReader::GetMember(element, "agent_id");
+    if (val && library_owner_id_.IsNull())
+        library_owner_id_.FromString(*val);
+}
+
+boost::shared_ptr<ProtocolUtilities::InventorySkeleton> InventoryStreamParser::ExtractInventory()
+{
+    boost::shared_ptr<ProtocolUtilities::InventorySkeleton> inventory =
+        boost::shared_ptr<ProtocolUtilities::InventorySkeleton>(new ProtocolUtilities::InventorySkeleton);
+
+    /********** My Inventory **********/
+    // The reader keeps only scalars, so an array member is present but has no value
+    if (!reader_.HasValue("inventory-skeleton") || reader_.GetValue("inventory-skeleton"))
+        throw XmlRpcException("Failed to read inventory, inventory-skeleton in the reply was not properly formed!");
+
+    if (!reader_.HasValue("inventory-root"))
+        throw XmlRpcException("Failed to read inventory, inventory-root in the reply was not present!");
+
+    if (root_id_.IsNull())
+        throw XmlRpcException("Failed to read inventory, inventory-root value folder_id was not present, null or unparseable!");
+
+    ProtocolUtilities::InventoryFolderSkeleton *root = InventoryParser::AddFolders(*inventory, folders_, root_id_, false);
+    if (!root || root->name != "My Inventory")
+        throw XmlRpcException("Failed to read inventory, inventory-root value folder_id pointed to a nonexisting folder!");
+
+    /********** World Library **********/
+    if (!reader_.HasValue("inventory-lib-owner"))
+        throw XmlRpcException("Failed to read inventory, inventory-lib-owner in the reply was not present!");
+
+    // In Taiga inventory-lib-owner isn't array, just single value.
+    const std::string *owner = reader_.GetValue("inventory-lib-owner");
+    if (owner)
+        library_owner_id_.FromString(*owner);
+
+    if (library_owner_id_.IsNull())
+        throw XmlRpcException("Failed to read inventory, inventory-lib-owner value agent_id was null or unparseable!");
+
+    inventory->worldLibraryOwnerId = library_owner_id_;
+
+    if (!reader_.HasValue("inventory-skel-lib") || reader_.GetValue("inventory-skel-lib"))
+    {
+        // Note: E.g. ScienceSim doens't have have World Library. Don't throw exception, just return here.
+        return inventory;
+    }
+
+    if (!reader_.HasValue("inventory-lib-root"))
+        throw XmlRpcException("Failed to read inventory, inventory-lib-root in the reply was not present!");
+
+    if (library_root_id_.IsNull())
+        throw XmlRpcException("Failed to read inventory, inventory-lib-root value folder_id was not present, null or unparseable!");
+
+    if (!InventoryParser::AddFolders(*inventory, library_folders_, library_root_id_, true))
+        throw XmlRpcException("Failed to read inventory, inventory-lib-root value folder_id pointed to a nonexisting folder!");
+
     return inventory;
 }
 
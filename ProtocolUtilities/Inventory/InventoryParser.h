@@ -8,18 +8,40 @@
 #ifndef incl_Protocol_InventoryParser_h
 #define incl_Protocol_InventoryParser_h
 
+#include "RexUUID.h"
+#include "XmlRpcStreamReader.h"
+
 namespace ProtocolUtilities
 {
+    class InventorySkeleton;
     class InventoryFolderSkeleton;
 
     class InventoryParser
     {
     public:
+        /// Folder as read from the reply, before it is put to the inventory tree.
+        struct FolderRecord
+        {
+            FolderRecord() : version(0), type_default(0) {}
+            RexUUID id;
+            RexUUID parent_id;
+            std::string name;
+            int version;
+            int type_default;
+        };
+        typedef std::vector<FolderRecord> FolderRecordList;
+
         /// This function reads the inventory tree that was stored in the XMLRPC login_to_simulator reply.
         /// @param call Pass in the object to a XMLRPCEPI call that has already been performed. Only the reply part will be read by this function.
         /// @return The inventory object, or null pointer if an error occurred.
         static boost::shared_ptr<ProtocolUtilities::InventorySkeleton> ExtractInventoryFromXMLRPCReply(XmlRpcEpi &call);
 
+        /// Puts folders to the inventory tree, under the folder whose id is rootId, which is added under the root of the inventory.
+        /// The folders that are not descendants of the root folder are left out.
+        /// @param library True if the folders are the World Library, whose folders are all non-editable.
+        /// @return The added root folder, or null if there was no root folder in the folders.
+        static InventoryFolderSkeleton *AddFolders(InventorySkeleton &inventory, const FolderRecordList &folders, const RexUUID &rootId, bool library);
+
         static void SetErrorFolder(ProtocolUtilities::InventoryFolderSkeleton *root);
 
     private:
@@ -28,6 +50,36 @@ namespace ProtocolUtilities
         /// @return True if one of the harcoded folders, false if not.
         static bool IsHardcodedOpenSimFolder(const char *name);
     };
+
+    /// Reads the inventory from a login_to_simulator reply while it is being received.
+    /** The folders of the inventory-skeleton and inventory-skel-lib arrays are collected as compact records
+        when they are read, and put to the inventory tree by ExtractInventory() once the reply has been read.
+     */
+    class InventoryStreamParser
+    {
+    public:
+        /// Constructor. Sets the array handlers of the reader.
+        explicit InventoryStreamParser(XmlRpcStreamReader &reader);
+
+        /// Builds the inventory from the reply that the reader has read.
+        /// @throw XmlRpcException if the inventory in the reply was not properly formed.
+        boost::shared_ptr<ProtocolUtilities::InventorySkeleton> ExtractInventory();
+
+        /// @return Number of folders read.
+        size_t GetFolderCount() const { return folders_.size() + library_folders_.size(); }
+
+    private:
+        void HandleFolder(const XmlRpcStreamReader::Members &element, InventoryParser::FolderRecordList *folders);
+        void HandleFolderId(const XmlRpcStreamReader::Members &element, RexUUID *id);
+        void HandleLibraryOwner(const XmlRpcStreamReader::Members &element);
+
+        XmlRpcStreamReader &reader_;
+        InventoryParser::FolderRecordList folders_;
+        InventoryParser::FolderRecordList library_folders_;
+        RexUUID root_id_;
+        RexUUID library_root_id_;
+        RexUUID library_owner_id_;
+    };
 }
 
 #endif // incl_Protocol_InventoryParser_h
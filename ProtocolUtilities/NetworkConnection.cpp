@@ -2,9 +2,17 @@
 #include "StableHeaders.h"
 
 #include <utility>
+#include <cstring>
+#include <cassert>
 
 #include "NetworkConnection.h"
 
+#if defined(__linux__) && defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 14))
+#define NETWORKCONNECTION_HAVE_SENDMMSG
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+
 using namespace std;
 
 namespace ProtocolUtilities
@@ -45,6 +53,45 @@ void NetworkConnection::SendBytes(const uint8_t *bytes, size_t count)
     socket.sendBytes(bytes, (int)count);
 }
 
+size_t NetworkConnection::SendBatch(const std::vector<std::vector<uint8_t> > &datagrams, size_t count)
+{
+    assert(count <= datagrams.size());
+    size_t sent = 0;
+    size_t calls = 0;
+
+#ifdef NETWORKCONNECTION_HAVE_SENDMMSG
+    const size_t cMaxBatch = 64;
+    mmsghdr headers[cMaxBatch];
+    iovec buffers[cMaxBatch];
+    const int fd = socket.impl()->sockfd();
+    while(sent < count)
+    {
+        const size_t batch = min(count - sent, cMaxBatch);
+        memset(headers, 0, sizeof(mmsghdr) * batch);
+        for(size_t i = 0; i < batch; ++i)
+        {
+            const std::vector<uint8_t> &datagram = datagrams[sent + i];
+            buffers[i].iov_base = (void *)&datagram[0];
+            buffers[i].iov_len = datagram.size();
+            headers[i].msg_hdr.msg_iov = &buffers[i];
+            headers[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int numSent = sendmmsg(fd, headers, (unsigned int)batch, 0);
+        ++calls;
+        // On error, send the rest one by one, which reports the error through the usual Poco exceptions.
+        if (numSent <= 0)
+            break;
+        sent += numSent;
+    }
+#endif
+
+    for(; sent < count; ++sent, ++calls)
+        SendBytes(&datagrams[sent][0], datagrams[sent].size());
+
+    return calls;
+}
+
 void NetworkConnection::Close()
 {
     socket.close();
@@ -5,6 +5,8 @@
 #include "Poco/Net/DatagramSocket.h"
 #include "RexTypes.h"
 
+#include <vector>
+
 namespace ProtocolUtilities
 {
     /// NetworkConnection represents the socket of a bidirectional UDP connection.
@@ -26,6 +28,13 @@ namespace ProtocolUtilities
         /// Pushes out a packet with the given contents.
         void SendBytes(const uint8_t *bytes, size_t count);
 
+        /// Pushes out several packets. Where the platform supports it (sendmmsg on Linux), the packets are
+        /// handed to the kernel with as few system calls as possible, otherwise they are sent one by one.
+        /// @param datagrams Contents of the packets.
+        /// @param count Number of packets to send from the start of datagrams.
+        /// @return The number of send calls made.
+        size_t SendBatch(const std::vector<std::vector<uint8_t> > &datagrams, size_t count);
+
         /// Closes the socket.
         void Close();
 
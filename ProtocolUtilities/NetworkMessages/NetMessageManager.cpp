@@ -18,6 +18,7 @@
 #include <sstream>
 #include <vector>
 #include <cstring>
+#include <algorithm>
 
 #include <boost/timer.hpp>
 
@@ -151,6 +152,10 @@ namespace ProtocolUtilities
 #ifdef PROFILING
     ,sentDatagrams(65536)
     ,sentDatabytes(65536)
+    ,sentMessages(65536)
+    ,sentMessageBytes(65536)
+    ,appendedAcks(65536)
+    ,sendCalls(65536)
     ,receivedDatagrams(65536)
     ,receivedDatabytes(65536)
     ,resentPackets(65536)
@@ -162,6 +167,8 @@ namespace ProtocolUtilities
     ,lastHeardSince(0.0)
     ,lastHeardSinceTick(0)
     ,pingId(0)
+    ,batchOutbound(true)
+    ,numOutboundDatagrams(0)
     {
         receivedSequenceNumbers.clear();
     }
@@ -404,10 +411,20 @@ namespace ProtocolUtilities
         while(receivedSequenceNumbers.size() > cMaxSeqNumMemorySize)
             receivedSequenceNumbers.erase(receivedSequenceNumbers.begin()); // We remove from the front to guarantee the smallest(oldest) are removed first.
 
-        // Acknowledge all the new accumulated packets that the server sent as reliable.
+        ManagePingSends();
+
+        // Send everything that was queued since the last frame. The acks for the packets received above ride along
+        // in these datagrams, and the ones that did not fit are sent in separate PacketAck messages.
+        FlushOutboundDatagrams();
         SendPendingACKs();
+        FlushOutboundDatagrams();
+    }
 
-        ManagePingSends();
+    void NetMessageManager::SetOutboundBatching(bool enable)
+    {
+        batchOutbound = enable;
+        if (!batchOutbound)
+            FlushOutboundDatagrams();
     }
 
     bool NetMessageManager::ConnectTo(const char *serverAddress, int port)
@@ -425,9 +442,26 @@ namespace ProtocolUtilities
         }
     }
 
-    void NetMessageManager::Disconnect()
+    void NetMessageManager::Disconnect(bool flush)
     {
-        connection->Close();
+        if (connection)
+        {
+            // Send what is queued, e.g. a LogoutRequest sent just before disconnecting, and the pending acks.
+            if (flush && connection->Open())
+            {
+                try
+                {
+                    SendPendingACKs();
+                    FlushOutboundDatagrams();
+                }
+                catch(Poco::Net::NetException &e)
+                {
+                    std::cout << "Failed to send queued datagrams on disconnect. Error: " << e.message() << std::endl;
+                }
+            }
+            connection->Close();
+        }
+        numOutboundDatagrams = 0;
         ClearMessagePoolMemory();
         receivedSequenceNumbers.clear();
     }
@@ -526,17 +560,78 @@ namespace ProtocolUtilities
 
         std::vector<uint8_t> &data = msg->GetData();
         assert(data.size() > 0);
-        connection->SendBytes(&data[0], data.size());
+
+        // Copy to the outbound queue. Reliable messages may be acked and recycled before the queue is flushed.
+        if (numOutboundDatagrams == outboundDatagrams.size())
+            outboundDatagrams.push_back(std::vector<uint8_t>());
+        outboundDatagrams[numOutboundDatagrams++].assign(data.begin(), data.end());
 
 #ifdef PROFILING
-        sentDatagrams.InsertRecord(1.0);
-        sentDatabytes.InsertRecord(data.size());
+        sentMessages.InsertRecord(1.0);
+        sentMessageBytes.InsertRecord(data.size());
 #endif
 
+        if (!batchOutbound)
+            FlushOutboundDatagrams();
+
         if (messageListener)
             messageListener->OnNetworkMessageSent(msg);
     }
 
+    void NetMessageManager::FlushOutboundDatagrams()
+    {
+        if (numOutboundDatagrams == 0)
+            return;
+
+        PROFILE(NetMessageManager_FlushOutboundDatagrams);
+        const size_t count = numOutboundDatagrams;
+        numOutboundDatagrams = 0;
+        if (!connection.get())
+            return;
+
+        for(size_t i = 0; i < count && !pendingACKs.empty(); ++i)
+            AppendPendingACKs(outboundDatagrams[i]);
+
+        size_t calls = connection->SendBatch(outboundDatagrams, count);
+
+#ifdef PROFILING
+        for(size_t i = 0; i < count; ++i)
+        {
+            sentDatagrams.InsertRecord(1.0);
+            sentDatabytes.InsertRecord(outboundDatagrams[i].size());
+        }
+        sendCalls.InsertRecord(calls);
+#endif
+    }
+
+    void NetMessageManager::AppendPendingACKs(std::vector<uint8_t> &datagram)
+    {
+        // Stay below the MTU used by the other SLUDP implementations, so the appended acks never cause fragmentation.
+        const size_t cMaxDatagramSize = 1200;
+        const size_t cMaxAppendedAcks = 255;
+        if (datagram.size() < 6 || (datagram[0] & NetFlagAck) != 0 || datagram.size() + 1 + 4 > cMaxDatagramSize)
+            return;
+
+        size_t numAcks = std::min(pendingACKs.size(), std::min(cMaxAppendedAcks, (cMaxDatagramSize - datagram.size() - 1) / 4));
+        std::set<uint32_t>::iterator it = pendingACKs.begin();
+        for(size_t i = 0; i < numAcks; ++i, ++it)
+        {
+            // Unlike in PacketAck messages, appended acks are in big endian, like the packet sequence numbers.
+            const uint32_t id = *it;
+            datagram.push_back((uint8_t)(id >> 24));
+            datagram.push_back((uint8_t)(id >> 16));
+            datagram.push_back((uint8_t)(id >> 8));
+            datagram.push_back((uint8_t)id);
+        }
+        datagram.push_back((uint8_t)numAcks);
+        datagram[0] |= NetFlagAck;
+        pendingACKs.erase(pendingACKs.begin(), it);
+
+#ifdef PROFILING
+        appendedAcks.InsertRecord((double)numAcks);
+#endif
+    }
+
     void NetMessageManager::QueuePacketACK(uint32_t packetID)
     {
         pendingACKs.insert(packetID);
@@ -5,6 +5,7 @@
 
 #include <list>
 #include <set>
+#include <vector>
 
 #include <boost/shared_ptr.hpp>
 
@@ -38,7 +39,8 @@ namespace ProtocolUtilities
         bool ConnectTo(const char *serverAddress, int port);
 
         /// Disconnets from the current server.
-        void Disconnect();
+        /// @param flush If true, the queued datagrams are sent before the connection is closed. Pass false after a network error.
+        void Disconnect(bool flush = true);
 
         /// To start building a new outbound message, call this.
         /// @return An empty message holder where the message can be built.
@@ -49,8 +51,20 @@ namespace ProtocolUtilities
 
         /// Reads in all inbound UDP messages and processes them forward to the application through the listener.
         /// Checks and resends any timed out reliable outbound messages. This could be moved into a separate thread, but not that timing specific so not necessary atm.
+        /// Finally sends out the queued outbound datagrams, see SetOutboundBatching().
         void ProcessMessages();
 
+        /// Sets whether outbound datagrams are batched.
+        /// When enabled (the default), finished messages are queued and sent all at once at the end of ProcessMessages(),
+        /// with pending acks appended to them. When disabled, each message is sent immediately, still carrying any pending acks.
+        void SetOutboundBatching(bool enable);
+
+        /// @return True if outbound datagrams are batched.
+        bool GetOutboundBatching() const { return batchOutbound; }
+
+        /// Sends out all queued outbound datagrams, appending pending acks to them.
+        void FlushOutboundDatagrams();
+
         /// Interprets the given byte stream as a message and dumps it contents out to the log. Useful only for diagnostics and such.
         void DumpNetworkMessage(NetMsgID id, NetInMessage *msg);
 
@@ -81,6 +95,18 @@ namespace ProtocolUtilities
         /// A history of sent data bytes.
         EventHistory sentDatabytes;
 
+        /// A history of sent messages, before batching. Each message also counts as a datagram in sentDatagrams.
+        EventHistory sentMessages;
+
+        /// A history of sent message bytes, excluding appended acks.
+        EventHistory sentMessageBytes;
+
+        /// A history of acks appended to outbound datagrams instead of being sent in separate PacketAck messages.
+        EventHistory appendedAcks;
+
+        /// A history of send calls made to flush the outbound datagrams.
+        EventHistory sendCalls;
+
         /// A history of received datagrams.
         EventHistory receivedDatagrams;
 
@@ -128,6 +154,9 @@ namespace ProtocolUtilities
         /// Sends pending acks to the server.
         void SendPendingACKs();
 
+        /// Appends as many pending acks to the given outbound datagram as fit in it.
+        void AppendPendingACKs(std::vector<uint8_t> &datagram);
+
         /// Processes a single raw datagram received from the network.
         void HandleInboundBytes(std::vector<uint8_t> &data);
 
@@ -154,6 +183,7 @@ namespace ProtocolUtilities
         void SendStartPingCheck(uint8_t pingId, uint32_t oldestUnacked);
 
         /// Called to send out a message that is already binary-mangled to the proper final format. (packet number, zerocoding, flags, ...)
+        /// The message data is copied to the outbound queue, so the message struct may be reused right after this call.
         void SendProcessedMessage(NetOutMessage *msg);
 
         /// Adds message to the queue of reliable outbound messages.
@@ -189,6 +219,16 @@ namespace ProtocolUtilities
         /// Packet acks pending to be sent
         std::set<uint32_t> pendingACKs;
 
+        /// Whether outbound datagrams are batched until the end of ProcessMessages().
+        bool batchOutbound;
+
+        /// Outbound datagrams waiting to be sent. Only the first numOutboundDatagrams are in use; the rest are kept
+        /// to reuse their memory.
+        std::vector<std::vector<uint8_t> > outboundDatagrams;
+
+        /// Number of queued outbound datagrams.
+        size_t numOutboundDatagrams;
+
         typedef std::list<std::pair<time_t, NetOutMessage*> > MessageResendList;
         /// A pool of NetOutMessages that are in the outbound queue. Need to keep the unacked reliable messages in
         /// memory for possible resending.
@@ -4,6 +4,9 @@
 
 #include "OpenSim/BuddyList.h"
 #include "OpenSim/BuddyListParser.h"
+#include "CoreStringUtils.h"
+
+#include <boost/bind.hpp>
 
 namespace ProtocolUtilities
 {
@@ -62,4 +65,42 @@ namespace ProtocolUtilities
         return buddy_list;
     }
 
-}
\ No newline at end of file
+    BuddyListStreamParser::BuddyListStreamParser(XmlRpcStreamReader &reader) :
+        reader_(reader),
+        buddy_list_(new ProtocolUtilities::BuddyList()),
+        buddy_count_(0)
+    {
+        reader_.SetArrayHandler("buddy-list", boost::bind(&BuddyListStreamParser::HandleBuddy, this, _1));
+    }
+
+    void BuddyListStreamParser::HandleBuddy(const XmlRpcStreamReader::Members &element)
+    {
+        RexUUID id;
+        int rights_given = 0;
+        int rights_has = 0;
+
+        const std::string *val = XmlRpcStreamReader::GetMember(element, "buddy_id");
+        if (val)
+            id.FromString(*val);
+
+        val = XmlRpcStreamReader::GetMember(element, "buddy_rights_given");
+        if (val)
+            rights_given = ParseString<int>(*val, 0);
+
+        val = XmlRpcStreamReader::GetMember(element, "buddy_rights_has");
+        if (val)
+            rights_has = ParseString<int>(*val, 0);
+
+        buddy_list_->AddBuddy(new ProtocolUtilities::Buddy(id, rights_given, rights_has));
+        ++buddy_count_;
+    }
+
+    ProtocolUtilities::BuddyListPtr BuddyListStreamParser::ExtractBuddyList()
+    {
+        // The reader keeps only scalars, so an array member is present but has no value
+        if (!reader_.HasValue("buddy-list") || reader_.GetValue("buddy-list"))
+            throw XmlRpcException("Failed to read buddy list, buddy-list in the reply was not properly formed!");
+
+        return buddy_list_;
+    }
+}
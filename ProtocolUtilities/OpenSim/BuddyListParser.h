@@ -9,6 +9,7 @@
 #define incl_Protocol_BuddyListParser_h
 
 #include "OpenSim/BuddyList.h"
+#include "XmlRpcStreamReader.h"
 
 namespace ProtocolUtilities
 {
@@ -32,6 +33,33 @@ namespace ProtocolUtilities
 
     };
 
+    /**
+     *  Reads the buddy list from a login reply while it is being received. The buddies are added to the
+     *  list as they are read.
+     */
+    class BuddyListStreamParser
+    {
+    public:
+        //! Constructor. Sets the array handler of the reader.
+        explicit BuddyListStreamParser(XmlRpcStreamReader &reader);
+
+        /**
+         *  Returns the buddy list read from the reply.
+         *  \throw XmlRpcException if there was no buddy list in the reply.
+         */
+        ProtocolUtilities::BuddyListPtr ExtractBuddyList();
+
+        //! Returns number of buddies read
+        size_t GetBuddyCount() const { return buddy_count_; }
+
+    private:
+        void HandleBuddy(const XmlRpcStreamReader::Members &element);
+
+        XmlRpcStreamReader &reader_;
+        ProtocolUtilities::BuddyListPtr buddy_list_;
+        size_t buddy_count_;
+    };
+
 }
 
 #endif // incl_Protocol_BuddyListParser_h
\ No newline at end of file
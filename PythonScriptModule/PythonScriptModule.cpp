@@ -110,6 +110,63 @@
 //==== Note py developers: MemoryLeakCheck must be the last include in order to make it work fully ====//
 #include "MemoryLeakCheck.h"
 
+namespace
+{
+    //! Submesh indices by entity id.
+    typedef std::map<entity_id_t, QList<uint> > SubmeshMap;
+
+    //! Finds the submeshes of visible prims that use a texture, from the asset reference index of the scene.
+    /*! Mesh prims are matched by their texture materials, other prims by their face textures. Default textures
+        of prims are not included.
+        \param match_urls Whether to match also url texture ids that contain texture_id.
+     */
+    void FindPrimSubmeshesWithTexture(const Scene::SceneManager &scene, const std::string &texture_id, bool match_urls, SubmeshMap &result)
+    {
+        const Scene::AssetReferenceIndex::ReferenceVector &refs = scene.GetAssetReferenceIndex().GetReferences(texture_id);
+        for(uint r = 0; r < refs.size(); ++r)
+        {
+            const Scene::AssetReferenceIndex::Reference &ref = refs[r];
+            if (ref.type != RexTypes::RexAT_Texture || ref.slot == Scene::AssetReferenceIndex::ALL_SLOTS)
+                continue;
+
+            Scene::EntityPtr entity = scene.GetEntity(ref.entity);
+            if (!entity)
+                continue;
+            EC_OpenSimPrim *prim = entity->GetComponent<EC_OpenSimPrim>().get();
+            if (!prim || ref.component != prim)
+                continue;
+
+            // Only prims that are already visible as a mesh or a custom object count
+            EC_Mesh *meshptr = entity->GetComponent<EC_Mesh>().get();
+            EC_OgreCustomObject *custom_object_ptr = entity->GetComponent<EC_OgreCustomObject>().get();
+            if (meshptr)
+            {
+                if (prim->DrawType != RexTypes::DRAWTYPE_MESH || !meshptr->GetEntity())
+                    continue;
+                if (!match_urls)
+                {
+                    MaterialMap::const_iterator mat = prim->Materials.find(ref.slot);
+                    if (mat == prim->Materials.end() || mat->second.asset_id != texture_id)
+                        continue;
+                }
+            }
+            else if (custom_object_ptr)
+            {
+                if (prim->DrawType != RexTypes::DRAWTYPE_PRIM || !custom_object_ptr->GetEntity())
+                    continue;
+            }
+            else
+                continue;
+
+            result[ref.entity].append(ref.slot);
+        }
+
+        // The index does not keep the references in order
+        for(SubmeshMap::iterator i = result.begin(); i != result.end(); ++i)
+            qSort(i->second);
+    }
+}
+
 namespace PythonScript
 {
     std::string PythonScriptModule::type_name_static_ = "PythonScript";
@@ -118,7 +175,8 @@ namespace PythonScript
 
     PythonScriptModule::PythonScriptModule()
     :IModule(type_name_static_),
-    pmmModule(0), pmmDict(0), pmmClass(0), pmmInstance(0)
+    pmmModule(0), pmmDict(0), pmmClass(0), pmmInstance(0),
+    frameBudget_(0.005)
     {
         pythonqt_inited = false;
         inboundCategoryID_ = 0;
@@ -241,10 +299,21 @@ namespace PythonScript
         RegisterConsoleCommand(Console::CreateCommand(
             "PyReset", "Resets the Python interpreter - should free all it's memory, and clear all state.", 
             Console::Bind(this, &PythonScriptModule::ConsoleReset)));
+
+        RegisterConsoleCommand(Console::CreateCommand(
+            "PyStats", "Prints the time used by each Python handler and task. Usage: PyStats(reset) to also clear the statistics.",
+            Console::Bind(this, &PythonScriptModule::ConsoleStats)));
+
+        RegisterConsoleCommand(Console::CreateCommand(
+            "PyBudget", "Sets the time in milliseconds that Python may use per frame for deferred events and tasks. Usage: PyBudget(5)",
+            Console::Bind(this, &PythonScriptModule::ConsoleBudget)));
+
+        frameBudget_ = framework_->GetDefaultConfig().DeclareSetting("PythonScript", "frame_budget_ms", 5.0f) / 1000.0f;
     }
 
     bool PythonScriptModule::HandleEvent(event_category_id_t category_id, event_id_t event_id, IEventData* data)
     {    
+        PROFILE(PythonScript_HandleEvent);
         PyObject* value = NULL;
 
         //input events. 
@@ -489,6 +558,38 @@ namespace PythonScript
         return Console::ResultSuccess();
     }
 
+    Console::CommandResult PythonScriptModule::ConsoleStats(const StringVector &params)
+    {
+        if (!pmmInstance)
+            return Console::ResultFailure("Python module manager is not running.");
+
+        int reset = (params.size() > 0 && params[0] == "reset") ? 1 : 0;
+        PyObject *report = PyObject_CallMethod(pmmInstance, "get_stats", "i", reset);
+        if (!report || !PyString_Check(report))
+        {
+            Py_XDECREF(report);
+            PyErr_Print();
+            return Console::ResultFailure("Could not get Python handler statistics.");
+        }
+
+        std::string text = PyString_AsString(report);
+        Py_DECREF(report);
+        return Console::ResultSuccess(text);
+    }
+
+    Console::CommandResult PythonScriptModule::ConsoleBudget(const StringVector &params)
+    {
+        if (params.size() != 1)
+            return Console::ResultSuccess("Python frame budget is " + ToString(frameBudget_ * 1000.0f) + " ms.");
+
+        float budget = ParseString<float>(params[0], -1.0f);
+        if (budget < 0.0f)
+            return Console::ResultFailure("Usage: PyBudget(milliseconds)");
+
+        frameBudget_ = budget / 1000.0f;
+        return Console::ResultSuccess("Python frame budget set to " + params[0] + " ms.");
+    }
+
     Console::CommandResult PythonScriptModule::ConsoleReset(const StringVector &params)
     {
         //engine_->Reset();
@@ -525,8 +626,17 @@ namespace PythonScript
         //engine_->RunString("import time; time.sleep(0.01);"); //a hack to save cpu now.
 
         // Somehow this causes extreme lag in consoleless mode         
+        // The module manager runs the deferred events and tasks for as long as the budget allows,
+        // see bin/pymodules/core/scheduler.py. PyStats shows where the time went.
         if (pmmInstance != NULL)
-            PyObject_CallMethod(pmmInstance, "run", "f", frametime);
+        {
+            PROFILE(PythonScript_Update);
+            PyObject *ret = PyObject_CallMethod(pmmInstance, "run", "ff", frametime, frameBudget_);
+            if (ret)
+                Py_DECREF(ret);
+            else
+                PyErr_Print();
+        }
         
         /*char** args = new char*[2]; //is this 2 'cause the latter terminates?
         std::string methodname = "run";
@@ -540,6 +650,8 @@ namespace PythonScript
 
         //XXX not ported to UImodule / OIS replacement yet
    //     boost::shared_ptr<Input::InputModuleOIS> input = framework_->GetModuleManager()->GetModule<Input::InputModuleOIS>(Foundation::Module::MT_Input).lock();
+
+        RESETPROFILER;
     }
 
     PythonScriptModule* PythonScriptModule::GetInstance()
@@ -631,8 +743,6 @@ namespace PythonScript
     //this whole thing could be probably implemented in py now as well, but perhaps ok in c++ for speed
   QList<Scene::Entity*> PythonScriptModule::ApplyUICanvasToSubmeshesWithTexture(QWidget* qwidget_ptr, QObject* qobject_ptr, QString uuidstr, uint refresh_rate)
     {
-        // Iterate the scene to find all submeshes that use this texture uuid
-        QList<uint> submeshes_;
         QList<Scene::Entity*> affected_entitys_;
 
         if (!qwidget_ptr)
@@ -655,77 +765,16 @@ namespace PythonScript
           return;
           }*/
 
-        Scene::EntityList prims = scene->GetEntitiesWithComponent("EC_OpenSimPrim");
-        foreach(Scene::EntityPtr e, prims)
+        // Find the submeshes from the asset reference index instead of iterating the whole scene
+        SubmeshMap found;
+        FindPrimSubmeshesWithTexture(*scene, texture_uuid.ToString(), false, found);
+        for(SubmeshMap::const_iterator i = found.begin(); i != found.end(); ++i)
         {
-            submeshes_.clear();
-
-            EC_OpenSimPrim *prim = e->GetComponent<EC_OpenSimPrim>().get();
-
-            if (prim->DrawType == RexTypes::DRAWTYPE_MESH || prim->DrawType == RexTypes::DRAWTYPE_PRIM)
-            {
-                ComponentPtr mesh = e->GetComponent(EC_Mesh::TypeNameStatic());
-                ComponentPtr custom_object = e->GetComponent(EC_OgreCustomObject::TypeNameStatic());
-            
-                EC_Mesh *meshptr = 0;
-                EC_OgreCustomObject *custom_object_ptr = 0;
-
-                if (mesh) 
-                {
-                    meshptr = checked_static_cast<EC_Mesh*>(mesh.get());
-                    if (!meshptr)
-                        continue;
-                    if (!meshptr->GetEntity())
-                        continue;
-                }
-                else if (custom_object)
-                {
-                    custom_object_ptr = checked_static_cast<EC_OgreCustomObject*>(custom_object.get());
-                    if (!custom_object_ptr)
-                        continue;
-                    if (!custom_object_ptr->GetEntity())
-                      continue;
-                }
-                else
-                    continue;
-            
-                // Iterate mesh materials map
-                if (meshptr)
-                {
-                    MaterialMap material_map = prim->Materials;
-                    MaterialMap::const_iterator i = material_map.begin();
-                    while (i != material_map.end())
-                    {
-                        // Store sumbeshes to list where we want to apply the new widget as texture
-                        uint submesh_id = i->first;
-                        if ((i->second.Type == RexTypes::RexAT_Texture) && (i->second.asset_id.compare(texture_uuid.ToString()) == 0))
-                            submeshes_.append(submesh_id);
-                        ++i;
-                    }
-                }
-                // Iterate custom object texture map
-                else if (custom_object_ptr && prim->PrimTextures.size() > 0 )
-                {
-                    TextureMap texture_map = prim->PrimTextures;
-                    TextureMap::const_iterator i = texture_map.begin();
-
-                    while (i != texture_map.end()) /// @todo This causes unresolved crash in some cases!
-                    {
-                        uint submesh_id = i->first;
-                        if (i->second == texture_uuid.ToString())
-                            submeshes_.append(submesh_id);
-                        ++i;
-                    }
-                }
-                else
-                    continue;
-
-                if (submeshes_.size() > 0)
-                {
-                    PythonScriptModule::Add3DCanvasComponents(e.get(), qwidget_ptr, submeshes_, refresh_rate);
-                    affected_entitys_.append(e.get());
-                }
-            }
+            Scene::EntityPtr e = scene->GetEntity(i->first);
+            if (!e)
+                continue;
+            PythonScriptModule::Add3DCanvasComponents(e.get(), qwidget_ptr, i->second, refresh_rate);
+            affected_entitys_.append(e.get());
         }
 
         return affected_entitys_;
@@ -970,93 +1019,11 @@ PyObject* CheckSceneForTexture(PyObject* self, PyObject* args)
         return NULL;
     }
 
-    // Iterate the scene to find all submeshes that use this texture uuid
-    QList<uint> submeshes_;
-    bool submeshes_found_ = false;
-    Scene::EntityList prims = scene->GetEntitiesWithComponent("EC_OpenSimPrim");
-    foreach(Scene::EntityPtr e, prims)
-    {
-        Scene::Entity &entity = *e.get();
-        submeshes_.clear();
-
-        EC_OpenSimPrim &prim = *entity.GetComponent<EC_OpenSimPrim>();
-
-        if (prim.DrawType == RexTypes::DRAWTYPE_MESH || prim.DrawType == RexTypes::DRAWTYPE_PRIM)
-        {
-            ComponentPtr mesh = entity.GetComponent(EC_Mesh::TypeNameStatic());
-            ComponentPtr custom_object = entity.GetComponent(EC_OgreCustomObject::TypeNameStatic());
-
-            EC_Mesh *meshptr = 0;
-            EC_OgreCustomObject *custom_object_ptr = 0;
-
-            if (mesh)
-            {
-                meshptr = checked_static_cast<EC_Mesh*>(mesh.get());
-                if (!meshptr)
-                    continue;
-                if (!meshptr->GetEntity())
-                    continue;
-            }
-            else if (custom_object)
-            {
-                custom_object_ptr = checked_static_cast<EC_OgreCustomObject*>(custom_object.get());
-                if (!custom_object_ptr)
-                    continue;
-                if (!custom_object_ptr->GetEntity())
-                    continue;
-            }
-            else
-                continue;
-            
-            // Iterate mesh materials map
-            if (meshptr)
-            {
-                MaterialMap material_map = prim.Materials;
-                MaterialMap::const_iterator i = material_map.begin();
-                while (i != material_map.end())
-                {
-                    // Store sumbeshes to list where we want to apply the new widget as texture
-                    uint submesh_id = i->first;
-                    if ((i->second.Type == RexTypes::RexAT_Texture))
-                    {
-                        if ((i->second.asset_id.compare(texture_uuid.ToString()) == 0))
-                        {
-                            submeshes_.append(submesh_id);
-                        }
-                        else
-                        {
-                            // Url asset id check for containing texture UUID
-                            QString q_asset_id(i->second.asset_id.c_str());
-                            if (q_asset_id.contains(texture_uuid.ToString().c_str()))
-                                submeshes_.append(submesh_id);
-                        }
-                    }
-                    ++i;
-                }
-            }
-            // Iterate custom object texture map
-            else if (custom_object_ptr && prim.PrimTextures.size() > 0 )
-            {
-                TextureMap texture_map = prim.PrimTextures;
-                TextureMap::const_iterator i = texture_map.begin();
-
-                while (i != texture_map.end()) /// @todo This causes unresolved crash in some cases!
-                {
-                    uint submesh_id = i->first;
-                    if (i->second == texture_uuid.ToString())
-                        submeshes_.append(submesh_id);
-                    ++i;
-                }
-            }
-            else
-                continue;
-
-            if (submeshes_.size() > 0)
-                Py_RETURN_TRUE; // No need to iterate further if any submeshes were found
-        }
-    }
-
-    if (submeshes_found_)
+    // Find the submeshes from the asset reference index instead of iterating the whole scene.
+    // Url asset ids of mesh materials are indexed also by the uuid they contain.
+    SubmeshMap found;
+    FindPrimSubmeshesWithTexture(*scene, texture_uuid.ToString(), true, found);
+    if (!found.empty())
         Py_RETURN_TRUE;
     else
         Py_RETURN_FALSE;
@@ -1204,19 +1171,24 @@ PyObject* GetSubmeshesWithTexture(PyObject* self, PyObject* args)
         else
             Py_RETURN_NONE;
         
-        // Iterate mesh materials map
+        // Only this prim's uses of the texture are looked up from the asset reference index
+        Scene::AssetReferenceIndex::ReferenceVector refs;
+        if (primentity->GetScene())
+            primentity->GetScene()->GetAssetReferenceIndex().GetReferences(texture_uuid.ToString(), ent_id, refs);
+
+        // Iterate mesh materials using the texture
         if (meshptr)
         {
-            MaterialMap material_map = prim.Materials;
-            MaterialMap::const_iterator i = material_map.begin();
-            while (i != material_map.end())
+            for (uint r = 0; r < refs.size(); ++r)
             {
                 // Store sumbeshes to list where we want to apply the new widget as texture
-                uint submesh_id = i->first;
-                if ((i->second.Type == RexTypes::RexAT_Texture) && (i->second.asset_id.compare(texture_uuid.ToString()) == 0))
+                uint submesh_id = refs[r].slot;
+                MaterialMap::const_iterator mat = prim.Materials.find(submesh_id);
+                if (refs[r].component == &prim && refs[r].type == RexTypes::RexAT_Texture &&
+                    mat != prim.Materials.end() && mat->second.asset_id == texture_uuid.ToString())
                     submeshes_.append(submesh_id);
-                ++i;
             }
+            qSort(submeshes_);
         }
         // Iterate custom object texture map
         else if (custom_object_ptr)
@@ -1226,9 +1198,7 @@ PyObject* GetSubmeshesWithTexture(PyObject* self, PyObject* args)
             Ogre::ManualObject* manual = RexLogic::CreatePrimGeometry(PythonScript::self()->GetFramework(), prim, false);
             custom_object_ptr->CommitChanges(manual);
 
-            TextureMap texture_map = prim.PrimTextures;
-            TextureMap::const_iterator i = texture_map.begin();
-            if (i == texture_map.end())
+            if (prim.PrimTextures.empty())
             {
                 if (prim.getPrimDefaultTextureID() == QString(texture_uuid.ToString().c_str()))
                     for (uint submesh = 0; submesh < 6; ++submesh)
@@ -1236,13 +1206,10 @@ PyObject* GetSubmeshesWithTexture(PyObject* self, PyObject* args)
             }
             else
             {
-                while (i != texture_map.end())
-                {
-                    uint submesh_id = i->first;
-                    if (i->second.compare(texture_uuid.ToString()) == 0)
-                        submeshes_.append(submesh_id);
-                    ++i;
-                }
+                for (uint r = 0; r < refs.size(); ++r)
+                    if (refs[r].component == &prim && refs[r].slot != Scene::AssetReferenceIndex::ALL_SLOTS)
+                        submeshes_.append(refs[r].slot);
+                qSort(submeshes_);
             }
         }
         else
@@ -1408,6 +1375,38 @@ PyObject* PyLogError(PyObject *self, PyObject *args)
     Py_RETURN_NONE;
 }
 
+PyObject* PyProfileBegin(PyObject *self, PyObject *args)
+{
+    const char* name;
+    if(!PyArg_ParseTuple(args, "s", &name))
+    {
+        PyErr_SetString(PyExc_ValueError, "Needs a string.");
+        return NULL;
+    }
+#ifdef PROFILING
+    Foundation::Profiler *profiler = Foundation::ProfilerSection::GetProfiler();
+    if (profiler)
+        profiler->StartBlock(std::string("Py_") + name);
+#endif
+    Py_RETURN_NONE;
+}
+
+PyObject* PyProfileEnd(PyObject *self, PyObject *args)
+{
+    const char* name;
+    if(!PyArg_ParseTuple(args, "s", &name))
+    {
+        PyErr_SetString(PyExc_ValueError, "Needs a string.");
+        return NULL;
+    }
+#ifdef PROFILING
+    Foundation::Profiler *profiler = Foundation::ProfilerSection::GetProfiler();
+    if (profiler)
+        profiler->EndBlock(std::string("Py_") + name);
+#endif
+    Py_RETURN_NONE;
+}
+
 PyObject* SetAvatarYaw(PyObject *self, PyObject *args)
 {
     float newyaw;
@@ -1703,6 +1702,12 @@ static PyMethodDef EmbMethods[] = {
     {"logError", (PyCFunction)PyLogError, METH_VARARGS,
     "Prints a text using the LogError-method."},
 
+    {"profileBegin", (PyCFunction)PyProfileBegin, METH_VARARGS,
+    "Starts a block with the given name in the profiler, under the block of the current Python call."},
+
+    {"profileEnd", (PyCFunction)PyProfileEnd, METH_VARARGS,
+    "Ends a block started with profileBegin."},
+
     {"getUiView", (PyCFunction)GetUIView, METH_NOARGS, 
     "Gets the Naali-Qt UI main view"},
     
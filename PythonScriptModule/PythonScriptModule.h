@@ -95,6 +95,8 @@ namespace PythonScript
         Console::CommandResult ConsoleRunString(const StringVector &params);
         Console::CommandResult ConsoleRunFile(const StringVector &params);
         Console::CommandResult ConsoleReset(const StringVector &params);
+        Console::CommandResult ConsoleStats(const StringVector &params);
+        Console::CommandResult ConsoleBudget(const StringVector &params);
 
         MODULE_LOGGING_FUNCTIONS
 
@@ -152,6 +154,9 @@ namespace PythonScript
         PyObject *pmmModule, *pmmDict, *pmmClass, *pmmInstance;
         PyObject *pmmArgs, *pmmValue;
 
+        //! Seconds per frame the module manager may use for deferred events and tasks, see PyBudget
+        float frameBudget_;
+
         //Foundation::ScriptObject* modulemanager;
         
         // can't get passing __VA_ARGS__ to pass my args 
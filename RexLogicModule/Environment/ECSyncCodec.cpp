@@ -0,0 +1,907 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+
+#include "StableHeaders.h"
+#include "DebugOperatorNew.h"
+
+#include "Environment/ECSyncCodec.h"
+#include "RexLogicModule.h"
+
+#include "Entity.h"
+#include "IComponent.h"
+#include "IAttribute.h"
+#include "ComponentManager.h"
+#include "AssetReference.h"
+#include "Transform.h"
+#include "Quaternion.h"
+#include "Color.h"
+
+#include <QByteArray>
+#include <QDomDocument>
+#include <QMetaObject>
+#include <QStringList>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "MemoryLeakCheck.h"
+
+namespace RexLogic
+{
+
+namespace
+{
+    const char cPrefix[] = "ECB1:";
+    const uint cPrefixLength = 5;
+
+    //! Maximum number of fragments, limited by the five digits the fragment header has room for
+    const uint cMaxFragments = 99999;
+
+    enum PayloadKind
+    {
+        PayloadSnapshot = 0,
+        PayloadDelta = 1
+    };
+
+    const u8 cFlagQuantized = 1;
+
+    enum ComponentEncoding
+    {
+        EncodingAttributes = 0,
+        EncodingXml = 1
+    };
+
+    //! Type codes of attribute values
+    enum AttributeType
+    {
+        TypeInt = 1,
+        TypeUInt = 2,
+        TypeReal = 3,
+        TypeString = 4,
+        TypeBool = 5,
+        TypeVector3 = 6,
+        TypeQuaternion = 7,
+        TypeColor = 8,
+        TypeAssetReference = 9,
+        TypeTransform = 10,
+        TypeText = 11
+    };
+
+    void WriteU8(std::string &out, u8 value)
+    {
+        out.push_back((char)value);
+    }
+
+    void WriteVarUInt(std::string &out, u64 value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back((char)((value & 0x7f) | 0x80));
+            value >>= 7;
+        }
+        out.push_back((char)value);
+    }
+
+    void WriteVarInt(std::string &out, s64 value)
+    {
+        // Zigzag encoding, so that small negative numbers are small too
+        WriteVarUInt(out, ((u64)value << 1) ^ (u64)(value >> 63));
+    }
+
+    void WriteU32(std::string &out, u32 value)
+    {
+        for (uint i = 0; i < 4; ++i)
+            out.push_back((char)((value >> (i * 8)) & 0xff));
+    }
+
+    void WriteBytes(std::string &out, const std::string &bytes)
+    {
+        WriteVarUInt(out, bytes.size());
+        out.append(bytes);
+    }
+
+    void WriteString(std::string &out, const QString &str)
+    {
+        QByteArray utf8 = str.toUtf8();
+        WriteVarUInt(out, utf8.size());
+        out.append(utf8.data(), utf8.size());
+    }
+
+    void WriteReal(std::string &out, float value, float step)
+    {
+        if (step > 0.f)
+        {
+            double steps = floor((double)value / step + 0.5);
+            // Keep the value within what the varint can hold
+            const double limit = 4.0e18;
+            if (steps > limit)
+                steps = limit;
+            if (steps < -limit)
+                steps = -limit;
+            WriteVarInt(out, (s64)steps);
+        }
+        else
+        {
+            u32 bits;
+            memcpy(&bits, &value, sizeof bits);
+            WriteU32(out, bits);
+        }
+    }
+
+    void WriteVector3(std::string &out, const Vector3df &value, float step)
+    {
+        WriteReal(out, value.x, step);
+        WriteReal(out, value.y, step);
+        WriteReal(out, value.z, step);
+    }
+
+    //! Reads the values written by the Write functions. Reading past the end sets the reader invalid.
+    class ByteReader
+    {
+    public:
+        explicit ByteReader(const std::string &data) : data_(data), pos_(0), ok_(true) {}
+
+        bool Ok() const { return ok_; }
+        bool AtEnd() const { return pos_ >= data_.size(); }
+
+        u8 ReadU8()
+        {
+            if (pos_ >= data_.size())
+            {
+                ok_ = false;
+                return 0;
+            }
+            return (u8)data_[pos_++];
+        }
+
+        u64 ReadVarUInt()
+        {
+            u64 value = 0;
+            for (uint shift = 0; shift < 64; shift += 7)
+            {
+                u8 byte = ReadU8();
+                value |= (u64)(byte & 0x7f) << shift;
+                if (!(byte & 0x80))
+                    return value;
+            }
+            ok_ = false;
+            return 0;
+        }
+
+        s64 ReadVarInt()
+        {
+            u64 value = ReadVarUInt();
+            return (s64)(value >> 1) ^ -(s64)(value & 1);
+        }
+
+        u32 ReadU32()
+        {
+            u32 value = 0;
+            for (uint i = 0; i < 4; ++i)
+                value |= (u32)ReadU8() << (i * 8);
+            return value;
+        }
+
+        std::string ReadBytes()
+        {
+            u64 size = ReadVarUInt();
+            if (!ok_ || size > data_.size() - pos_)
+            {
+                ok_ = false;
+                return std::string();
+            }
+            std::string bytes = data_.substr(pos_, (size_t)size);
+            pos_ += (size_t)size;
+            return bytes;
+        }
+
+        QString ReadString()
+        {
+            std::string utf8 = ReadBytes();
+            return QString::fromUtf8(utf8.data(), utf8.size());
+        }
+
+        float ReadReal(float step)
+        {
+            if (step > 0.f)
+                return (float)(ReadVarInt() * (double)step);
+            u32 bits = ReadU32();
+            float value;
+            memcpy(&value, &bits, sizeof value);
+            return value;
+        }
+
+        Vector3df ReadVector3(float step)
+        {
+            float x = ReadReal(step);
+            float y = ReadReal(step);
+            float z = ReadReal(step);
+            return Vector3df(x, y, z);
+        }
+
+    private:
+        const std::string &data_;
+        size_t pos_;
+        bool ok_;
+    };
+
+    s16 QuantizeUnit(float value)
+    {
+        if (value > 1.f)
+            value = 1.f;
+        if (value < -1.f)
+            value = -1.f;
+        return (s16)floor(value * 32767.f + 0.5f);
+    }
+
+    u8 QuantizeColor(float value)
+    {
+        if (value > 1.f)
+            value = 1.f;
+        if (value < 0.f)
+            value = 0.f;
+        return (u8)floor(value * 255.f + 0.5f);
+    }
+
+    bool IsEmbeddedAsXml(const IComponent *component)
+    {
+        // The attributes of a dynamic component are not fixed, so indices would not identify them
+        return component->TypeName() == "EC_DynamicComponent";
+    }
+
+    QString SerializeToXml(const IComponent *component)
+    {
+        QDomDocument doc;
+        QDomElement entity_elem = doc.createElement("entity");
+        doc.appendChild(entity_elem);
+        component->SerializeTo(doc, entity_elem);
+        return doc.toString(-1);
+    }
+}
+
+ECSyncCodec::ECSyncCodec(Foundation::Framework *framework) :
+    framework_(framework),
+    realStep_(0.f)
+{
+}
+
+u32 ECSyncCodec::HashTypeName(const QString &typeName)
+{
+    // FNV-1a
+    QByteArray bytes = typeName.toUtf8();
+    u32 hash = 2166136261u;
+    for (int i = 0; i < bytes.size(); ++i)
+    {
+        hash ^= (u8)bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+QString ECSyncCodec::LookupTypeName(u32 hash)
+{
+    QHash<u32, QString>::const_iterator i = typeNames_.find(hash);
+    if (i != typeNames_.end())
+        return i.value();
+
+    // Component types may have been registered since the last lookup
+    QStringList names = framework_->GetComponentManager()->GetAvailableComponentTypeNames();
+    if (names.size() == typeNames_.size())
+        return QString();
+    typeNames_.clear();
+    foreach(QString name, names)
+        typeNames_[HashTypeName(name)] = name;
+    return typeNames_.value(hash);
+}
+
+bool ECSyncCodec::EncodeAttribute(const IAttribute *attribute, float step, std::string &out) const
+{
+    if (const Attribute<int> *a = dynamic_cast<const Attribute<int> *>(attribute))
+    {
+        WriteU8(out, TypeInt);
+        WriteVarInt(out, a->Get());
+    }
+    else if (const Attribute<uint> *a = dynamic_cast<const Attribute<uint> *>(attribute))
+    {
+        WriteU8(out, TypeUInt);
+        WriteVarUInt(out, a->Get());
+    }
+    else if (const Attribute<float> *a = dynamic_cast<const Attribute<float> *>(attribute))
+    {
+        WriteU8(out, TypeReal);
+        WriteReal(out, a->Get(), step);
+    }
+    else if (const Attribute<QString> *a = dynamic_cast<const Attribute<QString> *>(attribute))
+    {
+        WriteU8(out, TypeString);
+        WriteString(out, a->Get());
+    }
+    else if (const Attribute<bool> *a = dynamic_cast<const Attribute<bool> *>(attribute))
+    {
+        WriteU8(out, TypeBool);
+        WriteU8(out, a->Get() ? 1 : 0);
+    }
+    else if (const Attribute<Vector3df> *a = dynamic_cast<const Attribute<Vector3df> *>(attribute))
+    {
+        WriteU8(out, TypeVector3);
+        WriteVector3(out, a->Get(), step);
+    }
+    else if (const Attribute<Quaternion> *a = dynamic_cast<const Attribute<Quaternion> *>(attribute))
+    {
+        const Quaternion &q = a->Get();
+        WriteU8(out, TypeQuaternion);
+        if (step > 0.f)
+        {
+            // Components of a unit quaternion are within [-1, 1]
+            WriteVarInt(out, QuantizeUnit(q.w));
+            WriteVarInt(out, QuantizeUnit(q.x));
+            WriteVarInt(out, QuantizeUnit(q.y));
+            WriteVarInt(out, QuantizeUnit(q.z));
+        }
+        else
+        {
+            WriteReal(out, q.w, 0.f);
+            WriteReal(out, q.x, 0.f);
+            WriteReal(out, q.y, 0.f);
+            WriteReal(out, q.z, 0.f);
+        }
+    }
+    else if (const Attribute<Color> *a = dynamic_cast<const Attribute<Color> *>(attribute))
+    {
+        const Color &c = a->Get();
+        WriteU8(out, TypeColor);
+        if (step > 0.f)
+        {
+            WriteU8(out, QuantizeColor(c.r));
+            WriteU8(out, QuantizeColor(c.g));
+            WriteU8(out, QuantizeColor(c.b));
+            WriteU8(out, QuantizeColor(c.a));
+        }
+        else
+        {
+            WriteReal(out, c.r, 0.f);
+            WriteReal(out, c.g, 0.f);
+            WriteReal(out, c.b, 0.f);
+            WriteReal(out, c.a, 0.f);
+        }
+    }
+    else if (const Attribute<AssetReference> *a = dynamic_cast<const Attribute<AssetReference> *>(attribute))
+    {
+        WriteU8(out, TypeAssetReference);
+        WriteString(out, a->Get().id);
+        WriteString(out, a->Get().type);
+    }
+    else if (const Attribute<Transform> *a = dynamic_cast<const Attribute<Transform> *>(attribute))
+    {
+        const Transform &t = a->Get();
+        WriteU8(out, TypeTransform);
+        WriteVector3(out, t.position, step);
+        WriteVector3(out, t.rotation, step);
+        WriteVector3(out, t.scale, step);
+    }
+    else if (attribute)
+    {
+        // Other types, eg. qvariant and qvariantlist, as their XML serialization text
+        WriteU8(out, TypeText);
+        std::string text = attribute->ToString();
+        WriteBytes(out, text);
+    }
+    else
+        return false;
+
+    return true;
+}
+
+bool ECSyncCodec::DecodeAttribute(IAttribute *attribute, const std::string &value, float step, AttributeChange::Type change) const
+{
+    ByteReader reader(value);
+    u8 type = reader.ReadU8();
+    switch(type)
+    {
+    case TypeInt:
+        if (Attribute<int> *a = dynamic_cast<Attribute<int> *>(attribute))
+        {
+            int v = (int)reader.ReadVarInt();
+            if (reader.Ok())
+                a->Set(v, change);
+            return reader.Ok();
+        }
+        break;
+    case TypeUInt:
+        if (Attribute<uint> *a = dynamic_cast<Attribute<uint> *>(attribute))
+        {
+            uint v = (uint)reader.ReadVarUInt();
+            if (reader.Ok())
+                a->Set(v, change);
+            return reader.Ok();
+        }
+        break;
+    case TypeReal:
+        if (Attribute<float> *a = dynamic_cast<Attribute<float> *>(attribute))
+        {
+            float v = reader.ReadReal(step);
+            if (reader.Ok())
+                a->Set(v, change);
+            return reader.Ok();
+        }
+        break;
+    case TypeString:
+        if (Attribute<QString> *a = dynamic_cast<Attribute<QString> *>(attribute))
+        {
+            QString v = reader.ReadString();
+            if (reader.Ok())
+                a->Set(v, change);
+            return reader.Ok();
+        }
+        break;
+    case TypeBool:
+        if (Attribute<bool> *a = dynamic_cast<Attribute<bool> *>(attribute))
+        {
+            bool v = reader.ReadU8() != 0;
+            if (reader.Ok())
+                a->Set(v, change);
+            return reader.Ok();
+        }
+        break;
+    case TypeVector3:
+        if (Attribute<Vector3df> *a = dynamic_cast<Attribute<Vector3df> *>(attribute))
+        {
+            Vector3df v = reader.ReadVector3(step);
+            if (reader.Ok())
+                a->Set(v, change);
+            return reader.Ok();
+        }
+        break;
+    case TypeQuaternion:
+        if (Attribute<Quaternion> *a = dynamic_cast<Attribute<Quaternion> *>(attribute))
+        {
+            Quaternion q;
+            if (step > 0.f)
+            {
+                q.w = reader.ReadVarInt() / 32767.f;
+                q.x = reader.ReadVarInt() / 32767.f;
+                q.y = reader.ReadVarInt() / 32767.f;
+                q.z = reader.ReadVarInt() / 32767.f;
+                q.normalize();
+            }
+            else
+            {
+                q.w = reader.ReadReal(0.f);
+                q.x = reader.ReadReal(0.f);
+                q.y = reader.ReadReal(0.f);
+                q.z = reader.ReadReal(0.f);
+            }
+            if (reader.Ok())
+                a->Set(q, change);
+            return reader.Ok();
+        }
+        break;
+    case TypeColor:
+        if (Attribute<Color> *a = dynamic_cast<Attribute<Color> *>(attribute))
+        {
+            Color c;
+            if (step > 0.f)
+            {
+                c.r = reader.ReadU8() / 255.f;
+                c.g = reader.ReadU8() / 255.f;
+                c.b = reader.ReadU8() / 255.f;
+                c.a = reader.ReadU8() / 255.f;
+            }
+            else
+            {
+                c.r = reader.ReadReal(0.f);
+                c.g = reader.ReadReal(0.f);
+                c.b = reader.ReadReal(0.f);
+                c.a = reader.ReadReal(0.f);
+            }
+            if (reader.Ok())
+                a->Set(c, change);
+            return reader.Ok();
+        }
+        break;
+    case TypeAssetReference:
+        if (Attribute<AssetReference> *a = dynamic_cast<Attribute<AssetReference> *>(attribute))
+        {
+            AssetReference ref;
+            ref.id = reader.ReadString();
+            ref.type = reader.ReadString();
+            if (reader.Ok())
+                a->Set(ref, change);
+            return reader.Ok();
+        }
+        break;
+    case TypeTransform:
+        if (Attribute<Transform> *a = dynamic_cast<Attribute<Transform> *>(attribute))
+        {
+            Transform t;
+            t.position = reader.ReadVector3(step);
+            t.rotation = reader.ReadVector3(step);
+            t.scale = reader.ReadVector3(step);
+            if (reader.Ok())
+                a->Set(t, change);
+            return reader.Ok();
+        }
+        break;
+    case TypeText:
+        if (attribute)
+        {
+            std::string text = reader.ReadBytes();
+            if (reader.Ok())
+                attribute->FromString(text, change);
+            return reader.Ok();
+        }
+        break;
+    }
+
+    return false;
+}
+
+void ECSyncCodec::EncodeComponent(const IComponent *component, float step, ComponentState &state) const
+{
+    state.typeName = component->TypeName();
+    state.name = component->Name();
+    state.attributes.clear();
+    state.xml = IsEmbeddedAsXml(component);
+    if (state.xml)
+    {
+        QByteArray xml = SerializeToXml(component).toUtf8();
+        state.attributes.push_back(std::string(xml.data(), xml.size()));
+        return;
+    }
+
+    const AttributeVector &attributes = component->GetAttributes();
+    state.attributes.resize(attributes.size());
+    for (uint i = 0; i < attributes.size(); ++i)
+        EncodeAttribute(attributes[i], step, state.attributes[i]);
+}
+
+void ECSyncCodec::Encode(Scene::Entity *entity, EntityState &state) const
+{
+    state.clear();
+    const Scene::Entity::ComponentVector &components = entity->GetComponentVector();
+    for (uint i = 0; i < components.size(); ++i)
+    {
+        if (!components[i]->IsSerializable() || !components[i]->GetNetworkSyncEnabled())
+            continue;
+        state.push_back(ComponentState());
+        EncodeComponent(components[i].get(), realStep_, state.back());
+    }
+}
+
+bool ECSyncCodec::SameComponents(const EntityState &a, const EntityState &b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (uint i = 0; i < a.size(); ++i)
+    {
+        if (a[i].typeName != b[i].typeName || a[i].name != b[i].name || a[i].xml != b[i].xml)
+            return false;
+        if (!a[i].xml && a[i].attributes.size() != b[i].attributes.size())
+            return false;
+    }
+    return true;
+}
+
+std::string ECSyncCodec::WriteSnapshot(const EntityState &state) const
+{
+    std::string out;
+    WriteU8(out, PayloadSnapshot);
+    if (realStep_ > 0.f)
+    {
+        WriteU8(out, cFlagQuantized);
+        WriteReal(out, realStep_, 0.f);
+    }
+    else
+        WriteU8(out, 0);
+
+    WriteVarUInt(out, state.size());
+    for (uint i = 0; i < state.size(); ++i)
+    {
+        const ComponentState &comp = state[i];
+        WriteU32(out, HashTypeName(comp.typeName));
+        WriteString(out, comp.name);
+        WriteU8(out, comp.xml ? EncodingXml : EncodingAttributes);
+        if (comp.xml)
+            WriteBytes(out, comp.attributes.front());
+        else
+        {
+            WriteVarUInt(out, comp.attributes.size());
+            for (uint j = 0; j < comp.attributes.size(); ++j)
+                WriteBytes(out, comp.attributes[j]);
+        }
+    }
+    return out;
+}
+
+std::string ECSyncCodec::WriteDelta(const EntityState &previous, const EntityState &current, uint &changed) const
+{
+    changed = 0;
+    std::string body;
+    uint changed_components = 0;
+    for (uint i = 0; i < current.size() && i < previous.size(); ++i)
+    {
+        const ComponentState &comp = current[i];
+        const ComponentState &prev = previous[i];
+
+        std::string comp_body;
+        uint comp_changed = 0;
+        if (comp.xml)
+        {
+            if (comp.attributes.front() != prev.attributes.front())
+            {
+                WriteBytes(comp_body, comp.attributes.front());
+                comp_changed = 1;
+            }
+        }
+        else
+        {
+            std::string attrs;
+            for (uint j = 0; j < comp.attributes.size() && j < prev.attributes.size(); ++j)
+            {
+                if (comp.attributes[j] == prev.attributes[j])
+                    continue;
+                WriteVarUInt(attrs, j);
+                WriteBytes(attrs, comp.attributes[j]);
+                ++comp_changed;
+            }
+            if (comp_changed)
+            {
+                WriteVarUInt(comp_body, comp_changed);
+                comp_body.append(attrs);
+            }
+        }
+
+        if (!comp_changed)
+            continue;
+        WriteU32(body, HashTypeName(comp.typeName));
+        WriteString(body, comp.name);
+        WriteU8(body, comp.xml ? EncodingXml : EncodingAttributes);
+        body.append(comp_body);
+        ++changed_components;
+        changed += comp_changed;
+    }
+
+    if (!changed_components)
+        return std::string();
+
+    std::string out;
+    WriteU8(out, PayloadDelta);
+    if (realStep_ > 0.f)
+    {
+        WriteU8(out, cFlagQuantized);
+        WriteReal(out, realStep_, 0.f);
+    }
+    else
+        WriteU8(out, 0);
+    WriteVarUInt(out, changed_components);
+    out.append(body);
+    return out;
+}
+
+bool ECSyncCodec::Apply(Scene::Entity *entity, const std::string &data, ApplyResult &result)
+{
+    ByteReader reader(data);
+    u8 kind = reader.ReadU8();
+    u8 flags = reader.ReadU8();
+    float step = 0.f;
+    if (flags & cFlagQuantized)
+        step = reader.ReadReal(0.f);
+    uint count = (uint)reader.ReadVarUInt();
+    if (!reader.Ok() || (kind != PayloadSnapshot && kind != PayloadDelta))
+        return false;
+
+    std::vector<IComponent *> received;
+    for (uint i = 0; i < count; ++i)
+    {
+        u32 hash = reader.ReadU32();
+        QString name = reader.ReadString();
+        u8 encoding = reader.ReadU8();
+        if (!reader.Ok())
+            return false;
+
+        QString type_name = LookupTypeName(hash);
+        ComponentPtr comp;
+        if (!type_name.isEmpty())
+        {
+            comp = entity->GetComponent(type_name, name);
+            if (!comp)
+            {
+                comp = entity->GetOrCreateComponent(type_name, name, AttributeChange::LocalOnly);
+                if (comp)
+                    ++result.createdComponents;
+            }
+        }
+        if (!comp)
+            RexLogicModule::LogWarning("Could not create entity component from binary EC data, unknown type hash " + ToString(hash));
+        // If it's an existing component, and has network sync disabled, skip
+        else if (!comp->GetNetworkSyncEnabled())
+            comp.reset();
+        if (comp)
+            received.push_back(comp.get());
+
+        if (encoding == EncodingXml)
+        {
+            std::string xml = reader.ReadBytes();
+            if (!reader.Ok())
+                return false;
+            ++result.attributes;
+            if (!comp)
+                continue;
+            QByteArray current = SerializeToXml(comp.get()).toUtf8();
+            if (std::string(current.data(), current.size()) == xml)
+                continue;
+            QDomDocument doc;
+            if (!doc.setContent(QByteArray::fromRawData(xml.data(), xml.size())))
+                continue;
+            QDomElement comp_elem = doc.firstChildElement("entity").firstChildElement("component");
+            if (comp_elem.isNull())
+                continue;
+            comp->DeserializeFrom(comp_elem, AttributeChange::Disconnected);
+            comp->ComponentChanged(AttributeChange::LocalOnly);
+            ++result.changedAttributes;
+        }
+        else if (encoding == EncodingAttributes)
+        {
+            uint attr_count = (uint)reader.ReadVarUInt();
+            if (!reader.Ok())
+                return false;
+            std::vector<IAttribute *> changed;
+            const AttributeVector *attributes = comp ? &comp->GetAttributes() : 0;
+            for (uint j = 0; j < attr_count; ++j)
+            {
+                uint index = (kind == PayloadDelta) ? (uint)reader.ReadVarUInt() : j;
+                std::string value = reader.ReadBytes();
+                if (!reader.Ok())
+                    return false;
+                ++result.attributes;
+                if (!attributes || index >= attributes->size())
+                    continue;
+
+                // Set only values that differ from the local ones, so that unchanged attributes signal nothing
+                IAttribute *attribute = (*attributes)[index];
+                std::string current;
+                EncodeAttribute(attribute, step, current);
+                if (current == value)
+                    continue;
+                if (DecodeAttribute(attribute, value, step, AttributeChange::Disconnected))
+                    changed.push_back(attribute);
+            }
+
+            for (uint j = 0; j < changed.size(); ++j)
+                changed[j]->Changed(AttributeChange::LocalOnly);
+            if (!changed.empty())
+            {
+                //! \todo OnChanged() is deprecated, but scripts still listen to it.
+                QMetaObject::invokeMethod(comp.get(), "OnChanged");
+                result.changedAttributes += changed.size();
+            }
+        }
+        else
+            return false;
+    }
+
+    if (kind == PayloadSnapshot)
+    {
+        // Remove the synced serializable EC's that are no longer in the data.
+        // The majority of EC's are not serializable, are handled internally, and must not be removed.
+        Scene::Entity::ComponentVector all_components = entity->GetComponentVector();
+        for (uint i = 0; i < all_components.size(); ++i)
+        {
+            if (!all_components[i]->IsSerializable() || !all_components[i]->GetNetworkSyncEnabled())
+                continue;
+            if (std::find(received.begin(), received.end(), all_components[i].get()) != received.end())
+                continue;
+            entity->RemoveComponent(all_components[i], AttributeChange::LocalOnly);
+            ++result.removedComponents;
+        }
+    }
+
+    return true;
+}
+
+bool ECSyncCodec::IsBinary(const std::string &freedata)
+{
+    return freedata.compare(0, cPrefixLength, cPrefix) == 0;
+}
+
+bool ECSyncCodec::IsFragment(const std::string &freedata)
+{
+    // Base64 has no colons, so only fragments have one after the prefix
+    return IsBinary(freedata) && freedata.find(':', cPrefixLength) != std::string::npos;
+}
+
+void ECSyncCodec::Frame(const std::string &data, uint maxSize, uint messageId, StringVector &frames)
+{
+    QByteArray base64 = QByteArray::fromRawData(data.data(), data.size()).toBase64();
+    if (cPrefixLength + base64.size() <= maxSize)
+    {
+        frames.push_back(std::string(cPrefix) + std::string(base64.data(), base64.size()));
+        return;
+    }
+
+    // The header has room for cMaxFragments fragments, which is far more than anyone should send
+    const uint header_size = cPrefixLength + 10 + 1 + 5 + 1 + 5 + 1;
+    uint piece_size = maxSize > header_size ? maxSize - header_size : 1;
+    uint count = (base64.size() + piece_size - 1) / piece_size;
+    for (uint i = 0; i < count; ++i)
+    {
+        std::string frame = std::string(cPrefix) + ToString(messageId) + ":" + ToString(i) + "/" + ToString(count) + ":";
+        uint start = i * piece_size;
+        uint size = std::min(piece_size, (uint)base64.size() - start);
+        frame.append(base64.data() + start, size);
+        frames.push_back(frame);
+    }
+}
+
+bool ECSyncCodec::Unframe(const std::string &freedata, std::string &data)
+{
+    if (!IsBinary(freedata) || IsFragment(freedata))
+        return false;
+    QByteArray bytes = QByteArray::fromBase64(QByteArray(freedata.data() + cPrefixLength, freedata.size() - cPrefixLength));
+    data.assign(bytes.data(), bytes.size());
+    return !data.empty();
+}
+
+bool ECSyncReassembler::Add(const std::string &object, const std::string &fragment, std::string &complete)
+{
+    // Parse "ECB1:<message id>:<index>/<count>:<piece>"
+    size_t id_end = fragment.find(':', cPrefixLength);
+    size_t index_end = fragment.find('/', id_end + 1);
+    size_t count_end = fragment.find(':', index_end + 1);
+    if (id_end == std::string::npos || index_end == std::string::npos || count_end == std::string::npos)
+        return false;
+    uint id = ParseString<uint>(fragment.substr(cPrefixLength, id_end - cPrefixLength), 0);
+    uint index = ParseString<uint>(fragment.substr(id_end + 1, index_end - id_end - 1), 0);
+    uint count = ParseString<uint>(fragment.substr(index_end + 1, count_end - index_end - 1), 0);
+    if (count == 0 || count > cMaxFragments || index >= count || count_end + 1 >= fragment.size())
+        return false;
+
+    std::map<std::string, Message>::iterator i = messages_.find(object);
+    if (i == messages_.end() && messages_.size() >= maxMessages_)
+    {
+        // Make room by dropping the message that has waited the longest
+        std::map<std::string, Message>::iterator oldest = messages_.begin();
+        for (std::map<std::string, Message>::iterator j = messages_.begin(); j != messages_.end(); ++j)
+            if (j->second.age > oldest->second.age)
+                oldest = j;
+        if (oldest != messages_.end())
+            messages_.erase(oldest);
+    }
+    if (i == messages_.end() || i->second.id != id || i->second.count != count)
+    {
+        Message &message = messages_[object];
+        message.id = id;
+        message.count = count;
+        message.pieces.clear();
+        message.age = 0.0;
+        i = messages_.find(object);
+    }
+
+    Message &message = i->second;
+    if (message.pieces.find(index) == message.pieces.end())
+        message.pieces[index] = fragment.substr(count_end + 1);
+    if (message.pieces.size() < count)
+        return false;
+
+    // The pieces are ordered by index
+    complete = cPrefix;
+    for (std::map<uint, std::string>::const_iterator j = message.pieces.begin(); j != message.pieces.end(); ++j)
+        complete.append(j->second);
+    messages_.erase(i);
+    return true;
+}
+
+void ECSyncReassembler::Update(f64 frametime)
+{
+    std::map<std::string, Message>::iterator i = messages_.begin();
+    while (i != messages_.end())
+    {
+        i->second.age += frametime;
+        if (i->second.age > timeout_)
+            messages_.erase(i++);
+        else
+            ++i;
+    }
+}
+
+}
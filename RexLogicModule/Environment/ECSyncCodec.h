@@ -0,0 +1,185 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+
+#ifndef incl_RexLogicModule_ECSyncCodec_h
+#define incl_RexLogicModule_ECSyncCodec_h
+
+#include "CoreTypes.h"
+#include "ForwardDefines.h"
+#include "AttributeChangeType.h"
+
+#include <QHash>
+#include <QString>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Scene
+{
+    class Entity;
+}
+
+class IComponent;
+class IAttribute;
+
+namespace RexLogic
+{
+    //! Compact binary encoding of the network synced entity components of a prim, sent as RexFreeData.
+    /*! Components are identified by a hash of their type name and attributes by their index in the component,
+        so that no names are sent. A snapshot contains all synced components of the entity, a delta only the
+        attributes that differ from a previous state. Reals, and the vectors, quaternions, colors and transforms
+        made of them, can be quantized to a step to make them smaller.
+
+        The binary data is sent as text, "ECB1:" followed by base64. Data that is longer than the maximum size
+        of one RexFreeData is split into fragments "ECB1:<message id>:<index>/<count>:<base64 piece>", which
+        ECSyncReassembler puts together again. Components whose attributes are not fixed, such as
+        EC_DynamicComponent, are embedded as their XML serialization.
+     */
+    class ECSyncCodec
+    {
+    public:
+        //! Encoded values of one component
+        struct ComponentState
+        {
+            QString typeName;
+            QString name;
+            //! True if the component is embedded as XML, which is then the only item of attributes
+            bool xml;
+            //! Encoded attribute values by attribute index, including the type code
+            std::vector<std::string> attributes;
+        };
+
+        //! Encoded values of the synced components of an entity
+        typedef std::vector<ComponentState> EntityState;
+
+        //! Result of applying data to an entity
+        struct ApplyResult
+        {
+            ApplyResult() : attributes(0), changedAttributes(0), createdComponents(0), removedComponents(0) {}
+            //! Attributes in the data
+            uint attributes;
+            //! Attributes whose value differed from the local one and was set
+            uint changedAttributes;
+            uint createdComponents;
+            uint removedComponents;
+        };
+
+        //! Constructor
+        /*! \param framework Framework, used for looking up component type names by their hashes
+         */
+        explicit ECSyncCodec(Foundation::Framework *framework);
+
+        //! Sets the quantization step of reals, 0 sends them exactly
+        void SetRealStep(float step) { realStep_ = step; }
+
+        //! Returns the quantization step of reals
+        float GetRealStep() const { return realStep_; }
+
+        //! Encodes the current values of the network synced serializable components of an entity
+        void Encode(Scene::Entity *entity, EntityState &state) const;
+
+        //! Returns whether two states have the same components, so that a delta between them can be written
+        static bool SameComponents(const EntityState &a, const EntityState &b);
+
+        //! Writes a snapshot of all components in a state
+        std::string WriteSnapshot(const EntityState &state) const;
+
+        //! Writes the attributes of current that differ from previous. The states must have the same components.
+        /*! \param changed Set to the number of changed attributes
+            \return Delta, or empty string if nothing changed
+         */
+        std::string WriteDelta(const EntityState &previous, const EntityState &current, uint &changed) const;
+
+        //! Applies a snapshot or delta to an entity. Only attributes whose value differs from the local one are set.
+        /*! Components that are not in the entity are created. A snapshot also removes the synced serializable
+            components that are not in it. The attribute changes are signalled as LocalOnly.
+            \return False if the data could not be decoded
+         */
+        bool Apply(Scene::Entity *entity, const std::string &data, ApplyResult &result);
+
+        //! Returns whether freedata is in the binary format, either whole or a fragment
+        static bool IsBinary(const std::string &freedata);
+
+        //! Returns whether freedata is a fragment
+        static bool IsFragment(const std::string &freedata);
+
+        //! Converts binary data to freedata, fragmented to pieces of at most maxSize characters if necessary
+        /*! \param messageId Id that tells the fragments of this data apart from those of other data of the entity
+         */
+        static void Frame(const std::string &data, uint maxSize, uint messageId, StringVector &frames);
+
+        //! Converts unfragmented freedata back to binary data. Returns false if the data is not valid.
+        static bool Unframe(const std::string &freedata, std::string &data);
+
+        //! Returns the hash a component type is identified with
+        static u32 HashTypeName(const QString &typeName);
+
+    private:
+        //! Encodes one attribute, returns false if its type is not known
+        bool EncodeAttribute(const IAttribute *attribute, float step, std::string &out) const;
+
+        //! Decodes an attribute value encoded with EncodeAttribute and sets it
+        bool DecodeAttribute(IAttribute *attribute, const std::string &value, float step, AttributeChange::Type change) const;
+
+        //! Encodes one component
+        void EncodeComponent(const IComponent *component, float step, ComponentState &state) const;
+
+        //! Returns the type name of a hash, or empty string if it is not a known component type
+        QString LookupTypeName(u32 hash);
+
+        Foundation::Framework *framework_;
+        float realStep_;
+        //! Component type names by hash
+        QHash<u32, QString> typeNames_;
+    };
+
+    //! Puts fragmented RexFreeData back together
+    /*! Only one unfinished message is kept per object, and at most maxMessages objects. A message whose fragments
+        have not all arrived within the timeout is dropped, eg. when only the last fragment stored by the server
+        was received.
+     */
+    class ECSyncReassembler
+    {
+    public:
+        //! Constructor
+        /*! \param maxMessages Maximum number of unfinished messages, the oldest is dropped to make room for a new one
+            \param timeout Seconds after which an unfinished message is dropped
+         */
+        explicit ECSyncReassembler(uint maxMessages = 256, f64 timeout = 10.0) : maxMessages_(maxMessages), timeout_(timeout) {}
+
+        //! Adds a fragment of an object's freedata
+        /*! Fragments of a newer message replace an unfinished older one. Fragments that claim more pieces than
+            ECSyncCodec::Frame can produce are rejected.
+            \param object Id of the object, eg. its full uuid as a string
+            \param complete Set to the complete unfragmented freedata when the last fragment arrives
+            \return True if the freedata is complete
+         */
+        bool Add(const std::string &object, const std::string &fragment, std::string &complete);
+
+        //! Ages the unfinished messages and drops those that have timed out
+        void Update(f64 frametime);
+
+        //! Drops the unfinished message of an object, eg. when the object is removed
+        void Remove(const std::string &object) { messages_.erase(object); }
+
+        //! Drops all unfinished messages
+        void Clear() { messages_.clear(); }
+
+    private:
+        struct Message
+        {
+            uint id;
+            uint count;
+            //! Received pieces by index
+            std::map<uint, std::string> pieces;
+            //! Seconds since the first fragment arrived
+            f64 age;
+        };
+
+        std::map<std::string, Message> messages_;
+        uint maxMessages_;
+        f64 timeout_;
+    };
+}
+
+#endif
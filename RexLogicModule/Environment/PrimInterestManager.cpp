@@ -0,0 +1,344 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+
+#include "StableHeaders.h"
+#include "Environment/PrimInterestManager.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    //! Seconds without new prims or pending asset requests after which the region is interactive
+    const f64 cSettleTime = 1.0;
+
+    //! FNV-1a
+    u32 HashBytes(u32 hash, const void *data, size_t size)
+    {
+        const u8 *bytes = static_cast<const u8 *>(data);
+        for(size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    template<typename T> u32 HashValue(u32 hash, const T &value)
+    {
+        return HashBytes(hash, &value, sizeof(T));
+    }
+
+    //! Distance of a root prim and its index in the deferred map
+    typedef std::pair<f32, entity_id_t> Candidate;
+}
+
+namespace RexLogic
+{
+
+PrimObjectUpdate::PrimObjectUpdate() :
+    regionHandle(0), localId(0), material(0), clickAction(0), parentId(0), updateFlags(0),
+    pathCurve(0), profileCurve(0), pathBegin(0), pathEnd(0), pathScaleX(0), pathScaleY(0), pathShearX(0), pathShearY(0),
+    pathTwist(0), pathTwistBegin(0), pathRadiusOffset(0), pathTaperX(0), pathTaperY(0), pathRevolutions(0), pathSkew(0),
+    profileBegin(0), profileEnd(0), profileHollow(0)
+{
+    textColor[0] = textColor[1] = textColor[2] = textColor[3] = 0;
+}
+
+size_t PrimObjectUpdate::GetMemoryUse() const
+{
+    return sizeof(PrimObjectUpdate) + objectData.capacity() + textureEntry.capacity() + hoveringText.capacity() +
+        mediaUrl.capacity() + extraParams.capacity();
+}
+
+u32 PrimObjectUpdate::GetShapeHash() const
+{
+    u32 hash = 2166136261u;
+    hash = HashValue(hash, pathCurve);
+    hash = HashValue(hash, profileCurve);
+    hash = HashValue(hash, pathBegin);
+    hash = HashValue(hash, pathEnd);
+    hash = HashValue(hash, pathScaleX);
+    hash = HashValue(hash, pathScaleY);
+    hash = HashValue(hash, pathShearX);
+    hash = HashValue(hash, pathShearY);
+    hash = HashValue(hash, pathTwist);
+    hash = HashValue(hash, pathTwistBegin);
+    hash = HashValue(hash, pathRadiusOffset);
+    hash = HashValue(hash, pathTaperX);
+    hash = HashValue(hash, pathTaperY);
+    hash = HashValue(hash, pathRevolutions);
+    hash = HashValue(hash, pathSkew);
+    hash = HashValue(hash, profileBegin);
+    hash = HashValue(hash, profileEnd);
+    hash = HashValue(hash, profileHollow);
+    if (!textureEntry.empty())
+        hash = HashBytes(hash, &textureEntry[0], textureEntry.size());
+    if (!extraParams.empty())
+        hash = HashBytes(hash, &extraParams[0], extraParams.size());
+    return hash;
+}
+
+PrimInterestManager::PrimInterestManager() :
+    enabled_(false),
+    interestDistance_(64.0f),
+    minAngularSize_(0.02f),
+    checkInterval_(0.25),
+    maxPromotions_(200),
+    hasCamera_(false),
+    cameraHalfAngle_(0.0f),
+    cameraFarClip_(0.0f),
+    checkTime_(0.0),
+    promotionsLeft_(false),
+    measuring_(false),
+    firstUpdate_(0),
+    settled_(0)
+{
+}
+
+void PrimInterestManager::SetCamera(const Vector3df &position, const Vector3df &direction, f32 halfAngle, f32 farClip)
+{
+    hasCamera_ = true;
+    cameraPosition_ = position;
+    cameraDirection_ = direction;
+    cameraHalfAngle_ = halfAngle;
+    cameraFarClip_ = farClip;
+}
+
+bool PrimInterestManager::ShouldDefer(const PrimObjectUpdate &update, bool hasPendingChildren) const
+{
+    if (!enabled_ || hasPendingChildren)
+        return false;
+
+    // Children go with their parent. Children of prims that have not arrived are created as before, so that
+    // RexLogicModule attaches them when the parent arrives.
+    if (update.parentId != 0)
+        return IsDeferred(update.parentId);
+
+    return !IsInteresting(update.position, update.scale);
+}
+
+void PrimInterestManager::Defer(const PrimObjectUpdate &update)
+{
+    UpdateMap::iterator i = deferred_.find(update.localId);
+    if (i != deferred_.end())
+    {
+        RemoveFromParent(i->second);
+        i->second = update;
+    }
+    else
+    {
+        deferred_[update.localId] = update;
+        ++stats_.deferred;
+    }
+
+    if (update.parentId != 0)
+        children_[update.parentId].insert(update.localId);
+}
+
+void PrimInterestManager::Promote(entity_id_t localId, std::vector<PrimObjectUpdate> &children)
+{
+    UpdateMap::iterator i = deferred_.find(localId);
+    if (i != deferred_.end())
+    {
+        RemoveFromParent(i->second);
+        deferred_.erase(i);
+    }
+
+    TakeChildren(localId, &children);
+}
+
+void PrimInterestManager::UpdatePosition(entity_id_t localId, const Vector3df &position)
+{
+    UpdateMap::iterator i = deferred_.find(localId);
+    if (i != deferred_.end())
+        i->second.position = position;
+}
+
+void PrimInterestManager::Remove(entity_id_t localId)
+{
+    UpdateMap::iterator i = deferred_.find(localId);
+    if (i == deferred_.end())
+        return;
+
+    RemoveFromParent(i->second);
+    deferred_.erase(i);
+
+    // The children are dropped with the parent like the children of prim entities
+    std::vector<PrimObjectUpdate> children;
+    TakeChildren(localId, &children);
+}
+
+void PrimInterestManager::TakePromotions(f64 frametime, std::vector<PrimObjectUpdate> &promoted)
+{
+    if (deferred_.empty())
+    {
+        promotionsLeft_ = false;
+        return;
+    }
+
+    checkTime_ += frametime;
+    if (checkTime_ < checkInterval_)
+        return;
+    checkTime_ = 0.0;
+
+    std::vector<Candidate> candidates;
+    for(UpdateMap::const_iterator i = deferred_.begin(); i != deferred_.end(); ++i)
+    {
+        const PrimObjectUpdate &update = i->second;
+        if (update.parentId != 0)
+            continue;
+        if (!enabled_ || IsInteresting(update.position, update.scale))
+            candidates.push_back(Candidate(cameraPosition_.getDistanceFromSQ(update.position), update.localId));
+    }
+
+    size_t count = std::min<size_t>(candidates.size(), maxPromotions_);
+    std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end());
+    for(size_t i = 0; i < count; ++i)
+    {
+        UpdateMap::iterator j = deferred_.find(candidates[i].second);
+        promoted.push_back(j->second);
+        deferred_.erase(j);
+        TakeChildren(candidates[i].second, &promoted);
+    }
+
+    promotionsLeft_ = candidates.size() > count;
+}
+
+void PrimInterestManager::OnObjectUpdate()
+{
+    if (measuring_ || stats_.timeToInteractive >= 0.0)
+        return;
+
+    measuring_ = true;
+    firstUpdate_ = GetCurrentClockTime();
+    settled_ = 0;
+}
+
+void PrimInterestManager::OnCreated(bool wasDeferred)
+{
+    if (wasDeferred)
+        ++stats_.promoted;
+    else
+        ++stats_.created;
+    settled_ = 0;
+}
+
+void PrimInterestManager::UpdateActivity(uint pendingRequests)
+{
+    if (!measuring_)
+        return;
+
+    if (pendingRequests > 0 || promotionsLeft_)
+    {
+        settled_ = 0;
+        return;
+    }
+
+    tick_t now = GetCurrentClockTime();
+    if (settled_ == 0)
+    {
+        settled_ = now;
+        return;
+    }
+
+    f64 freq = (f64)GetCurrentClockFreq();
+    if ((now - settled_) / freq >= cSettleTime)
+    {
+        stats_.timeToInteractive = (settled_ - firstUpdate_) / freq;
+        measuring_ = false;
+    }
+}
+
+size_t PrimInterestManager::GetMemoryUse() const
+{
+    size_t size = 0;
+    for(UpdateMap::const_iterator i = deferred_.begin(); i != deferred_.end(); ++i)
+        size += i->second.GetMemoryUse();
+    return size;
+}
+
+size_t PrimInterestManager::GetDistinctShapeCount() const
+{
+    std::set<u32> hashes;
+    for(UpdateMap::const_iterator i = deferred_.begin(); i != deferred_.end(); ++i)
+        hashes.insert(i->second.GetShapeHash());
+    return hashes.size();
+}
+
+void PrimInterestManager::ResetStats()
+{
+    stats_ = Stats();
+    measuring_ = false;
+}
+
+void PrimInterestManager::Clear()
+{
+    deferred_.clear();
+    children_.clear();
+    checkTime_ = 0.0;
+    promotionsLeft_ = false;
+    measuring_ = false;
+    stats_.timeToInteractive = -1.0;
+}
+
+bool PrimInterestManager::IsInteresting(const Vector3df &position, const Vector3df &scale) const
+{
+    if (!hasCamera_)
+        return true;
+
+    Vector3df offset = position - cameraPosition_;
+    f32 distance = offset.getLength();
+    if (distance <= interestDistance_)
+        return true;
+
+    // Too small to see from this far
+    f32 radius = scale.getLength() * 0.5f;
+    if (radius * 2.0f < minAngularSize_ * distance)
+        return false;
+
+    if (distance <= radius)
+        return true;
+    if (cameraFarClip_ > 0.0f && distance - radius > cameraFarClip_)
+        return false;
+
+    // Bounding sphere against the view cone
+    f32 cosAngle = offset.dotProduct(cameraDirection_) / distance;
+    f32 angle = acos(std::max(-1.0f, std::min(1.0f, cosAngle)));
+    return angle <= cameraHalfAngle_ + asin(radius / distance);
+}
+
+void PrimInterestManager::RemoveFromParent(const PrimObjectUpdate &update)
+{
+    if (update.parentId == 0)
+        return;
+
+    ChildMap::iterator i = children_.find(update.parentId);
+    if (i == children_.end())
+        return;
+    i->second.erase(update.localId);
+    if (i->second.empty())
+        children_.erase(i);
+}
+
+void PrimInterestManager::TakeChildren(entity_id_t localId, std::vector<PrimObjectUpdate> *out)
+{
+    ChildMap::iterator i = children_.find(localId);
+    if (i == children_.end())
+        return;
+
+    std::set<entity_id_t> ids;
+    ids.swap(i->second);
+    children_.erase(i);
+
+    for(std::set<entity_id_t>::const_iterator j = ids.begin(); j != ids.end(); ++j)
+    {
+        UpdateMap::iterator k = deferred_.find(*j);
+        if (k == deferred_.end())
+            continue;
+        out->push_back(k->second);
+        deferred_.erase(k);
+        TakeChildren(*j, out);
+    }
+}
+
+}
@@ -0,0 +1,220 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+
+#ifndef incl_RexLogicModule_PrimInterestManager_h
+#define incl_RexLogicModule_PrimInterestManager_h
+
+#include "CoreTypes.h"
+#include "RexUUID.h"
+#include "Vector3D.h"
+#include "HighPerfClock.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace RexLogic
+{
+    //! Contents of one object of an ObjectUpdate message, as read from the message.
+    struct PrimObjectUpdate
+    {
+        PrimObjectUpdate();
+
+        //! Returns the bytes used by the update, including the variable length data
+        size_t GetMemoryUse() const;
+
+        //! Returns a hash of the shape, textures and extra parameters, which is the same for identical looking prims
+        u32 GetShapeHash() const;
+
+        u64 regionHandle;
+        entity_id_t localId;
+        RexUUID fullId;
+        u8 material;
+        u8 clickAction;
+        Vector3df scale;
+        //! Position, velocity, acceleration, orientation and angular velocity, 60 bytes. Empty if the message had invalid data.
+        std::vector<u8> objectData;
+        //! Position from the object data or the latest terse update
+        Vector3df position;
+        entity_id_t parentId;
+        u32 updateFlags;
+
+        //! Prim shape, as the values are in the message
+        u8 pathCurve;
+        u8 profileCurve;
+        u16 pathBegin;
+        u16 pathEnd;
+        u8 pathScaleX;
+        u8 pathScaleY;
+        s8 pathShearX;
+        s8 pathShearY;
+        s8 pathTwist;
+        s8 pathTwistBegin;
+        s8 pathRadiusOffset;
+        s8 pathTaperX;
+        s8 pathTaperY;
+        u8 pathRevolutions;
+        s8 pathSkew;
+        u16 profileBegin;
+        u16 profileEnd;
+        u16 profileHollow;
+
+        std::vector<u8> textureEntry;
+        std::string hoveringText;
+        u8 textColor[4];
+        std::string mediaUrl;
+        //! Extra parameters, empty if there were none
+        std::vector<u8> extraParams;
+    };
+
+    //! Decides which prims are created as entities, and keeps the rest as their ObjectUpdates until they become interesting.
+    /*! A root prim is interesting when it is within the interest distance of the camera, or when it is in the view
+        and its size relative to its distance is at least the minimum angular size. Prims that are not interesting
+        when their ObjectUpdate arrives are deferred: the update is kept, and no entity is created or assets requested
+        for them. Children of deferred prims are deferred with them. Primitive asks for the deferred prims that have
+        become interesting with TakePromotions() and creates them, nearest first.
+
+        Also measures the time to interactive of a region: the time from the first ObjectUpdate until the prims
+        in range have been created and their assets loaded.
+     */
+    class PrimInterestManager
+    {
+    public:
+        //! Counters of the interest management
+        struct Stats
+        {
+            Stats() : created(0), deferred(0), promoted(0), timeToInteractive(-1.0) {}
+            //! Prims created as entities when their first ObjectUpdate arrived
+            uint created;
+            //! Prims deferred
+            uint deferred;
+            //! Deferred prims created later
+            uint promoted;
+            //! Seconds from the first ObjectUpdate until the region was interactive, -1 if it is not yet
+            f64 timeToInteractive;
+        };
+
+        PrimInterestManager();
+
+        //! Sets whether prims are deferred. When disabled, every prim is created as it arrives.
+        void SetEnabled(bool enabled) { enabled_ = enabled; }
+        bool IsEnabled() const { return enabled_; }
+
+        //! Sets the distance within which all prims are created
+        void SetInterestDistance(f32 distance) { interestDistance_ = distance; }
+
+        //! Sets the minimum size of a prim divided by its distance for creating prims beyond the interest distance
+        void SetMinAngularSize(f32 size) { minAngularSize_ = size; }
+
+        //! Sets the time in seconds between checks for deferred prims to create
+        void SetCheckInterval(f64 interval) { checkInterval_ = interval; }
+
+        //! Sets the maximum number of deferred root prims created per check
+        void SetMaxPromotions(uint count) { maxPromotions_ = count; }
+
+        //! Sets the camera used to tell whether prims are interesting
+        /*! \param position Camera position
+            \param direction Unit vector of the view direction
+            \param halfAngle Half of the widest angle of the view, in radians
+            \param farClip Far clip distance, 0 for none
+         */
+        void SetCamera(const Vector3df &position, const Vector3df &direction, f32 halfAngle, f32 farClip);
+
+        //! Returns true if the ObjectUpdate should be deferred instead of creating the prim
+        /*! \param hasPendingChildren True if objects have arrived with the prim as their parent
+         */
+        bool ShouldDefer(const PrimObjectUpdate &update, bool hasPendingChildren) const;
+
+        //! Stores the ObjectUpdate of a deferred prim, replacing an earlier one
+        void Defer(const PrimObjectUpdate &update);
+
+        //! Returns true if the prim is deferred
+        bool IsDeferred(entity_id_t localId) const { return deferred_.find(localId) != deferred_.end(); }
+
+        //! Removes a deferred prim, when it is created, and moves its deferred children to children, parents first
+        void Promote(entity_id_t localId, std::vector<PrimObjectUpdate> &children);
+
+        //! Updates the position of a deferred prim from a terse update
+        void UpdatePosition(entity_id_t localId, const Vector3df &position);
+
+        //! Removes a killed deferred prim and its children
+        void Remove(entity_id_t localId);
+
+        //! Moves the updates of the deferred prims that have become interesting to promoted, at most once per check interval.
+        /*! The nearest root prims are taken first, each followed by its children.
+         */
+        void TakePromotions(f64 frametime, std::vector<PrimObjectUpdate> &promoted);
+
+        //! Call when an ObjectUpdate arrives. Starts the measurement of the time to interactive.
+        void OnObjectUpdate();
+
+        //! Call when a prim is created. Counts the prim and restarts the wait for the region to settle.
+        void OnCreated(bool wasDeferred);
+
+        //! Updates the measurement of the time to interactive
+        /*! \param pendingRequests Asset requests of prims that have not finished
+         */
+        void UpdateActivity(uint pendingRequests);
+
+        //! Returns the number of deferred prims
+        size_t GetDeferredCount() const { return deferred_.size(); }
+
+        //! Returns the bytes used by the updates of the deferred prims
+        size_t GetMemoryUse() const;
+
+        //! Returns the number of different shape hashes of the deferred prims
+        size_t GetDistinctShapeCount() const;
+
+        const Stats& GetStats() const { return stats_; }
+
+        //! Resets the counters and restarts the measurement of the time to interactive from the next ObjectUpdate
+        void ResetStats();
+
+        //! Forgets all deferred prims, on logout
+        void Clear();
+
+    private:
+        //! Returns true if a root prim at the position with the scale should be created
+        bool IsInteresting(const Vector3df &position, const Vector3df &scale) const;
+
+        //! Removes the deferred prim from the children of its parent
+        void RemoveFromParent(const PrimObjectUpdate &update);
+
+        //! Moves the deferred children of the prim to out, recursively, parents first
+        void TakeChildren(entity_id_t localId, std::vector<PrimObjectUpdate> *out);
+
+        bool enabled_;
+        f32 interestDistance_;
+        f32 minAngularSize_;
+        f64 checkInterval_;
+        uint maxPromotions_;
+
+        bool hasCamera_;
+        Vector3df cameraPosition_;
+        Vector3df cameraDirection_;
+        f32 cameraHalfAngle_;
+        f32 cameraFarClip_;
+
+        typedef std::map<entity_id_t, PrimObjectUpdate> UpdateMap;
+        UpdateMap deferred_;
+
+        //! Deferred children by parent
+        typedef std::map<entity_id_t, std::set<entity_id_t> > ChildMap;
+        ChildMap children_;
+
+        //! Time since the last check for promotions
+        f64 checkTime_;
+        //! Whether there were interesting prims left over from the last check
+        bool promotionsLeft_;
+
+        //! Whether the time to interactive is being measured
+        bool measuring_;
+        tick_t firstUpdate_;
+        //! Time when the region last had no work left, or 0 if it has work
+        tick_t settled_;
+
+        Stats stats_;
+    };
+}
+
+#endif
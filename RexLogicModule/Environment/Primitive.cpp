@@ -49,25 +49,53 @@
 #include "IAttribute.h"
 
 #include <OgreSceneNode.h>
+#include <OgreCamera.h>
 
 #include <QUrl>
 #include <QColor>
 #include <QDomDocument>
 
+#include <boost/bind.hpp>
+
+#include <algorithm>
+
 namespace RexLogic
 {
 
-Primitive::Primitive(RexLogicModule *rexlogicmodule) : rexlogicmodule_(rexlogicmodule)
+//! Seconds after which queued prim geometry is created even if the frame budget is used
+static const double cPrimGeometryDeadline = 0.5;
+
+Primitive::Primitive(RexLogicModule *rexlogicmodule) :
+    rexlogicmodule_(rexlogicmodule),
+    ec_codec_(rexlogicmodule->GetFramework()),
+    ec_sync_message_id_(0)
 {
+    Foundation::ConfigurationManager &config = rexlogicmodule_->GetFramework()->GetDefaultConfig();
+    // Off by default: clients and servers that predate the binary format only read the XML freedata
+    binary_ec_sync_ = config.DeclareSetting("RexLogicModule", "binary_ec_sync", false);
+    ec_sync_max_size_ = config.DeclareSetting("RexLogicModule", "ec_sync_max_size", 1000);
+    ec_sync_keyframe_delay_ = config.DeclareSetting("RexLogicModule", "ec_sync_keyframe_delay", 1.0f);
+    ec_codec_.SetRealStep(config.DeclareSetting("RexLogicModule", "ec_sync_real_step", 0.0f));
+    if (ec_sync_max_size_ < 100)
+        ec_sync_max_size_ = 100;
+
+    interest_.SetEnabled(config.DeclareSetting("RexLogicModule", "interest_management", true));
+    interest_.SetInterestDistance(config.DeclareSetting("RexLogicModule", "interest_distance", 64.0f));
+    interest_.SetMinAngularSize(config.DeclareSetting("RexLogicModule", "interest_min_angular_size", 0.02f));
+    interest_.SetCheckInterval(config.DeclareSetting("RexLogicModule", "interest_check_interval", 0.25f));
+    interest_.SetMaxPromotions(config.DeclareSetting("RexLogicModule", "interest_max_promotions", 200));
 }
 
 Primitive::~Primitive()
 {
+    CancelPrimGeometryWork();
 }
 
 void Primitive::Update(f64 frametime)
 {
-    SerializeECsToNetwork();
+    SerializeECsToNetwork(frametime);
+    ec_reassembler_.Update(frametime);
+    UpdateInterest(frametime);
 }
 
 Scene::EntityPtr Primitive::GetOrCreatePrimEntity(entity_id_t entityid, const RexUUID &fullid, bool *created)
@@ -141,148 +169,242 @@ bool Primitive::HandleOSNE_ObjectUpdate(ProtocolUtilities::NetworkEventInboundDa
     size_t instance_count = data->message->ReadCurrentBlockInstanceCount();
     for(size_t i = 0; i < instance_count; ++i)
     {
-        uint32_t localid = msg->ReadU32();
-        msg->SkipToNextVariable();        // State U8
-        RexUUID fullid = msg->ReadUUID();
-        msg->SkipToNextVariable();        // CRC U32
-        uint8_t pcode = msg->ReadU8();
-        UNREFERENCED_PARAM(pcode);
-        bool was_created;
+        PrimObjectUpdate update;
+        update.regionHandle = regionhandle;
+        ReadObjectUpdate(*msg, update);
+        msg->SkipToNextInstanceStart();
 
-        Scene::EntityPtr entity = GetOrCreatePrimEntity(localid, fullid, &was_created);
-        EC_OpenSimPrim *prim = entity->GetComponent<EC_OpenSimPrim>().get();
-        EC_NetworkPosition *netpos = entity->GetComponent<EC_NetworkPosition>().get();
+        interest_.OnObjectUpdate();
 
-        ///\todo Are we setting the param or looking up by this param? I think the latter, but this is now doing the former. 
-        ///      Will cause problems with multigrid support.
-        prim->RegionHandle = regionhandle;
+        // Prims that are not interesting yet are kept as their update, without creating an entity
+        bool deferred = interest_.IsDeferred(update.localId);
+        if (!rexlogicmodule_->GetPrimEntity(update.localId) &&
+            interest_.ShouldDefer(update, rexlogicmodule_->HasPendingChildren(update.localId)))
+            interest_.Defer(update);
+        else
+            ApplyObjectUpdate(update, deferred);
+    }
 
-        prim->Material = msg->ReadU8();
-        prim->ClickAction = msg->ReadU8();
+    return false;
+}
 
-        prim->Scale = msg->ReadVector3();
-        // Scale is not handled by interpolation system, so set directly
-        HandlePrimScaleAndVisibility(localid);
+void Primitive::ReadObjectUpdate(ProtocolUtilities::NetInMessage &msg, PrimObjectUpdate &update)
+{
+    update.localId = msg.ReadU32();
+    msg.SkipToNextVariable();        // State U8
+    update.fullId = msg.ReadUUID();
+    msg.SkipToNextVariable();        // CRC U32
+    msg.SkipToNextVariable();        // PCode U8
+
+    update.material = msg.ReadU8();
+    update.clickAction = msg.ReadU8();
+    update.scale = msg.ReadVector3();
+
+    size_t bytes_read = 0;
+    const uint8_t *objectdatabytes = msg.ReadBuffer(&bytes_read);
+    if (bytes_read == 60)
+    {
+        update.objectData.assign(objectdatabytes, objectdatabytes + bytes_read);
+        update.position = *reinterpret_cast<const Vector3df*>(&objectdatabytes[0]);
+    }
 
-        size_t bytes_read = 0;
-        const uint8_t *objectdatabytes = msg->ReadBuffer(&bytes_read);
-        if (bytes_read == 60)
-        {
-            // The data contents:
-            // ofs  0 - pos xyz - 3 x float (3x4 bytes)
-            // ofs 12 - vel xyz - 3 x float (3x4 bytes)
-            // ofs 24 - acc xyz - 3 x float (3x4 bytes)
-            // ofs 36 - orientation, quat with last (w) component omitted - 3 x float (3x4 bytes)
-            // ofs 48 - angular velocity - 3 x float (3x4 bytes)
-            // total 60 bytes
-
-            Vector3df vec = (*reinterpret_cast<const Vector3df*>(&objectdatabytes[0]));
-            if (IsValidPositionVector(vec))
-                netpos->position_ = vec;
-
-            vec = *reinterpret_cast<const Vector3df*>(&objectdatabytes[12]);
-            if (IsValidVelocityVector(vec))
-                netpos->velocity_ = vec;
-
-            vec = *reinterpret_cast<const Vector3df*>(&objectdatabytes[24]);
-            if (IsValidVelocityVector(vec)) // Use Velocity validation for Acceleration as well - it's ok as they are quite similar.
-                netpos->accel_ = vec;
-
-            netpos->orientation_ = UnpackQuaternionFromFloat3((float*)&objectdatabytes[36]);
-            vec = *reinterpret_cast<const Vector3df*>(&objectdatabytes[48]);
-            if (IsValidVelocityVector(vec)) // Use Velocity validation for Angular Velocity as well - it's ok as they are quite similar.
-                netpos->rotvel_ = vec;
-            netpos->Updated();
-        }
-        else
-            RexLogicModule::LogError("Error reading ObjectData for prim:" + ToString(prim->LocalId) + ". Bytes read:" + ToString(bytes_read));
-
-        prim->ParentId = msg->ReadU32();
-        prim->UpdateFlags = msg->ReadU32();
-
-        // Read prim shape
-        prim->PathCurve.Set(msg->ReadU8(), AttributeChange::LocalOnly);
-        prim->ProfileCurve.Set(msg->ReadU8(), AttributeChange::LocalOnly);
-        prim->PathBegin.Set(msg->ReadU16() * 0.00002f, AttributeChange::LocalOnly);
-        prim->PathEnd.Set(msg->ReadU16() * 0.00002f, AttributeChange::LocalOnly);
-        prim->PathScaleX.Set(msg->ReadU8() * 0.01f, AttributeChange::LocalOnly);
-        prim->PathScaleY.Set(msg->ReadU8() * 0.01f, AttributeChange::LocalOnly);
-        prim->PathShearX.Set(((int8_t)msg->ReadU8()) * 0.01f, AttributeChange::LocalOnly);
-        prim->PathShearY.Set(((int8_t)msg->ReadU8()) * 0.01f, AttributeChange::LocalOnly);
-        prim->PathTwist.Set(msg->ReadS8() * 0.01f, AttributeChange::LocalOnly);
-        prim->PathTwistBegin.Set(msg->ReadS8() * 0.01f, AttributeChange::LocalOnly);
-        prim->PathRadiusOffset.Set(msg->ReadS8() * 0.01f, AttributeChange::LocalOnly);
-        prim->PathTaperX.Set(msg->ReadS8() * 0.01f, AttributeChange::LocalOnly);
-        prim->PathTaperY.Set(msg->ReadS8() * 0.01f, AttributeChange::LocalOnly);
-        prim->PathRevolutions.Set(1.0f + msg->ReadU8() * 0.015f, AttributeChange::LocalOnly);
-        prim->PathSkew.Set( msg->ReadS8() * 0.01f, AttributeChange::LocalOnly);
-        prim->ProfileBegin.Set(msg->ReadU16() * 0.00002f, AttributeChange::LocalOnly);
-        prim->ProfileEnd.Set(msg->ReadU16() * 0.00002f, AttributeChange::LocalOnly);
-        prim->ProfileHollow.Set(msg->ReadU16() * 0.00002f, AttributeChange::LocalOnly);
-        prim->HasPrimShapeData = true;
-
-        // Texture entry
-        const uint8_t *textureentrybytes = msg->ReadBuffer(&bytes_read);
-        ParseTextureEntryData(*prim, textureentrybytes, bytes_read);
-
-        // Hovering text
-        msg->SkipToFirstVariableByName("Text");
-        prim->HoveringText = msg->ReadString();
-
-        // Text color
-        const uint8_t *colorBytes = msg->ReadBuffer(&bytes_read);
-        assert(bytes_read == 4 && "Invalid length for fixed-sized variable TextColor in ObjectUpdate packet! Should be 4 bytes always.");
-        if (bytes_read != 4)
-            throw Exception("Invalid length for fixed-sized variable TextColor in ObjectUpdate packet! Should be 4 bytes always.");
-
-        // Convert from bytes to QColor
-        int idx = 0;
-        int r = colorBytes[idx++];
-        int g = colorBytes[idx++];
-        int b = colorBytes[idx++];
-        int a = 255 - colorBytes[idx++];
-        QColor color(r, g, b, a);
-
-        AttachHoveringTextComponent(entity, prim->HoveringText, color);
-
-        // read mediaurl, and send an event if it was changed
-        std::string prevMediaUrl = prim->MediaUrl;
-        prim->MediaUrl = msg->ReadString();
-        //RexLogicModule::LogInfo("MediaURL: " + prim->MediaUrl);
-        if (prim->MediaUrl.compare(prevMediaUrl) != 0)
-        {
-            //RexLogicModule::LogInfo("MediaURL changed: " + prim->MediaUrl);
-            Scene::Events::EntityEventData event_data;
-            event_data.entity = entity;
-            EventManagerPtr event_manager = rexlogicmodule_->GetFramework()->GetEventManager();
-            event_manager->SendEvent("Scene", Scene::Events::EVENT_ENTITY_MEDIAURL_SET, &event_data);
-        }
+    update.parentId = msg.ReadU32();
+    update.updateFlags = msg.ReadU32();
+
+    // Prim shape
+    update.pathCurve = msg.ReadU8();
+    update.profileCurve = msg.ReadU8();
+    update.pathBegin = msg.ReadU16();
+    update.pathEnd = msg.ReadU16();
+    update.pathScaleX = msg.ReadU8();
+    update.pathScaleY = msg.ReadU8();
+    update.pathShearX = (int8_t)msg.ReadU8();
+    update.pathShearY = (int8_t)msg.ReadU8();
+    update.pathTwist = msg.ReadS8();
+    update.pathTwistBegin = msg.ReadS8();
+    update.pathRadiusOffset = msg.ReadS8();
+    update.pathTaperX = msg.ReadS8();
+    update.pathTaperY = msg.ReadS8();
+    update.pathRevolutions = msg.ReadU8();
+    update.pathSkew = msg.ReadS8();
+    update.profileBegin = msg.ReadU16();
+    update.profileEnd = msg.ReadU16();
+    update.profileHollow = msg.ReadU16();
+
+    // Texture entry
+    const uint8_t *textureentrybytes = msg.ReadBuffer(&bytes_read);
+    update.textureEntry.assign(textureentrybytes, textureentrybytes + bytes_read);
+
+    // Hovering text
+    msg.SkipToFirstVariableByName("Text");
+    update.hoveringText = msg.ReadString();
+
+    // Text color
+    const uint8_t *colorBytes = msg.ReadBuffer(&bytes_read);
+    assert(bytes_read == 4 && "Invalid length for fixed-sized variable TextColor in ObjectUpdate packet! Should be 4 bytes always.");
+    if (bytes_read != 4)
+        throw Exception("Invalid length for fixed-sized variable TextColor in ObjectUpdate packet! Should be 4 bytes always.");
+    memcpy(update.textColor, colorBytes, 4);
+
+    update.mediaUrl = msg.ReadString();
+
+    msg.SkipToNextVariable(); // PSBlock
+
+    // If there are extra params, keep them.
+    if (msg.ReadVariableSize() > 1)
+    {
+        const uint8_t *extra_params_data = msg.ReadBuffer(&bytes_read);
+        update.extraParams.assign(extra_params_data, extra_params_data + bytes_read);
+    }
+}
 
-        msg->SkipToNextVariable(); // PSBlock
+void Primitive::ApplyObjectUpdate(const PrimObjectUpdate &update, bool wasDeferred)
+{
+    entity_id_t localid = update.localId;
+    bool was_created;
 
-        // If there are extra params, handle them.
-        if (msg->ReadVariableSize() > 1)
-        {
-            const uint8_t *extra_params_data = msg->ReadBuffer(&bytes_read);
-            HandleExtraParams(localid, extra_params_data);
-        }
+    Scene::EntityPtr entity = GetOrCreatePrimEntity(localid, update.fullId, &was_created);
+    if (!entity)
+        return;
+    EC_OpenSimPrim *prim = entity->GetComponent<EC_OpenSimPrim>().get();
+    EC_NetworkPosition *netpos = entity->GetComponent<EC_NetworkPosition>().get();
 
-        msg->SkipToNextInstanceStart();
+    ///\todo Are we setting the param or looking up by this param? I think the latter, but this is now doing the former. 
+    ///      Will cause problems with multigrid support.
+    prim->RegionHandle = update.regionHandle;
 
-        HandleDrawType(localid);
+    prim->Material = update.material;
+    prim->ClickAction = update.clickAction;
 
-        // Handle setting the prim as child of another object, or possibly being parent itself
-        rexlogicmodule_->HandleMissingParent(localid);
-        rexlogicmodule_->HandleObjectParent(localid);
-        if (was_created)
-        {
-            Scene::ScenePtr scene = rexlogicmodule_->GetFramework()->GetDefaultWorldScene();
-            if (scene)
-                scene->EmitEntityCreated(entity, AttributeChange::LocalOnly);
-        }
+    prim->Scale = update.scale;
+    // Scale is not handled by interpolation system, so set directly
+    HandlePrimScaleAndVisibility(localid);
+
+    if (update.objectData.size() == 60)
+    {
+        const uint8_t *objectdatabytes = &update.objectData[0];
+        // The data contents:
+        // ofs  0 - pos xyz - 3 x float (3x4 bytes)
+        // ofs 12 - vel xyz - 3 x float (3x4 bytes)
+        // ofs 24 - acc xyz - 3 x float (3x4 bytes)
+        // ofs 36 - orientation, quat with last (w) component omitted - 3 x float (3x4 bytes)
+        // ofs 48 - angular velocity - 3 x float (3x4 bytes)
+        // total 60 bytes
+
+        // The position may have been updated by terse updates while the prim was deferred
+        if (IsValidPositionVector(update.position))
+            netpos->position_ = update.position;
+
+        Vector3df vec = *reinterpret_cast<const Vector3df*>(&objectdatabytes[12]);
+        if (IsValidVelocityVector(vec))
+            netpos->velocity_ = vec;
+
+        vec = *reinterpret_cast<const Vector3df*>(&objectdatabytes[24]);
+        if (IsValidVelocityVector(vec)) // Use Velocity validation for Acceleration as well - it's ok as they are quite similar.
+            netpos->accel_ = vec;
+
+        netpos->orientation_ = UnpackQuaternionFromFloat3((float*)&objectdatabytes[36]);
+        vec = *reinterpret_cast<const Vector3df*>(&objectdatabytes[48]);
+        if (IsValidVelocityVector(vec)) // Use Velocity validation for Angular Velocity as well - it's ok as they are quite similar.
+            netpos->rotvel_ = vec;
+        netpos->Updated();
+    }
+    else
+        RexLogicModule::LogError("Error reading ObjectData for prim:" + ToString(prim->LocalId) + ". Bytes read:" + ToString(update.objectData.size()));
+
+    prim->ParentId = update.parentId;
+    prim->UpdateFlags = update.updateFlags;
+
+    // Prim shape
+    prim->PathCurve.Set(update.pathCurve, AttributeChange::LocalOnly);
+    prim->ProfileCurve.Set(update.profileCurve, AttributeChange::LocalOnly);
+    prim->PathBegin.Set(update.pathBegin * 0.00002f, AttributeChange::LocalOnly);
+    prim->PathEnd.Set(update.pathEnd * 0.00002f, AttributeChange::LocalOnly);
+    prim->PathScaleX.Set(update.pathScaleX * 0.01f, AttributeChange::LocalOnly);
+    prim->PathScaleY.Set(update.pathScaleY * 0.01f, AttributeChange::LocalOnly);
+    prim->PathShearX.Set(update.pathShearX * 0.01f, AttributeChange::LocalOnly);
+    prim->PathShearY.Set(update.pathShearY * 0.01f, AttributeChange::LocalOnly);
+    prim->PathTwist.Set(update.pathTwist * 0.01f, AttributeChange::LocalOnly);
+    prim->PathTwistBegin.Set(update.pathTwistBegin * 0.01f, AttributeChange::LocalOnly);
+    prim->PathRadiusOffset.Set(update.pathRadiusOffset * 0.01f, AttributeChange::LocalOnly);
+    prim->PathTaperX.Set(update.pathTaperX * 0.01f, AttributeChange::LocalOnly);
+    prim->PathTaperY.Set(update.pathTaperY * 0.01f, AttributeChange::LocalOnly);
+    prim->PathRevolutions.Set(1.0f + update.pathRevolutions * 0.015f, AttributeChange::LocalOnly);
+    prim->PathSkew.Set(update.pathSkew * 0.01f, AttributeChange::LocalOnly);
+    prim->ProfileBegin.Set(update.profileBegin * 0.00002f, AttributeChange::LocalOnly);
+    prim->ProfileEnd.Set(update.profileEnd * 0.00002f, AttributeChange::LocalOnly);
+    prim->ProfileHollow.Set(update.profileHollow * 0.00002f, AttributeChange::LocalOnly);
+    prim->HasPrimShapeData = true;
+
+    // Texture entry
+    ParseTextureEntryData(*prim, update.textureEntry.empty() ? 0 : &update.textureEntry[0], update.textureEntry.size());
+
+    // Hovering text
+    prim->HoveringText = update.hoveringText;
+
+    // Convert text color from bytes to QColor
+    QColor color(update.textColor[0], update.textColor[1], update.textColor[2], 255 - update.textColor[3]);
+
+    AttachHoveringTextComponent(entity, prim->HoveringText, color);
+
+    // set mediaurl, and send an event if it was changed
+    std::string prevMediaUrl = prim->MediaUrl;
+    prim->MediaUrl = update.mediaUrl;
+    if (prim->MediaUrl.compare(prevMediaUrl) != 0)
+    {
+        Scene::Events::EntityEventData event_data;
+        event_data.entity = entity;
+        EventManagerPtr event_manager = rexlogicmodule_->GetFramework()->GetEventManager();
+        event_manager->SendEvent("Scene", Scene::Events::EVENT_ENTITY_MEDIAURL_SET, &event_data);
     }
 
-    return false;
+    // If there are extra params, handle them.
+    if (!update.extraParams.empty())
+        HandleExtraParams(localid, &update.extraParams[0]);
+
+    HandleDrawType(localid);
+
+    // Handle setting the prim as child of another object, or possibly being parent itself
+    rexlogicmodule_->HandleMissingParent(localid);
+    rexlogicmodule_->HandleObjectParent(localid);
+    if (was_created)
+    {
+        interest_.OnCreated(wasDeferred);
+        Scene::ScenePtr scene = rexlogicmodule_->GetFramework()->GetDefaultWorldScene();
+        if (scene)
+            scene->EmitEntityCreated(entity, AttributeChange::LocalOnly);
+    }
+
+    // Children that were deferred with the prim are created now
+    std::vector<PrimObjectUpdate> children;
+    interest_.Promote(localid, children);
+    for(size_t i = 0; i < children.size(); ++i)
+        ApplyObjectUpdate(children[i], true);
+}
+
+void Primitive::UpdateInterest(f64 frametime)
+{
+    PROFILE(Primitive_UpdateInterest);
+
+    OgreRenderer::RendererPtr renderer = rexlogicmodule_->GetOgreRendererPtr();
+    Ogre::Camera *camera = renderer ? renderer->GetCurrentCamera() : 0;
+    if (camera)
+    {
+        Ogre::Vector3 pos = camera->getDerivedPosition();
+        Ogre::Vector3 dir = camera->getDerivedDirection();
+        // Half of the diagonal of the view
+        f32 tanHalfFovY = tan(camera->getFOVy().valueRadians() * 0.5f);
+        f32 aspect = camera->getAspectRatio();
+        f32 halfAngle = atan(tanHalfFovY * sqrt(1.0f + aspect * aspect));
+        interest_.SetCamera(Vector3df(pos.x, pos.y, pos.z), Vector3df(dir.x, dir.y, dir.z), halfAngle, camera->getFarClipDistance());
+    }
+
+    std::vector<PrimObjectUpdate> promoted;
+    interest_.TakePromotions(frametime, promoted);
+    for(size_t i = 0; i < promoted.size(); ++i)
+        ApplyObjectUpdate(promoted[i], true);
+
+    interest_.UpdateActivity(prim_resource_request_tags_.size());
 }
 
 void Primitive::HandleTerseObjectUpdateForPrim_44bytes(const uint8_t* bytes)
@@ -303,7 +425,14 @@ void Primitive::HandleTerseObjectUpdateForPrim_44bytes(const uint8_t* bytes)
     i += 6;
     
     Scene::EntityPtr entity = rexlogicmodule_->GetPrimEntity(localid);
-    if(!entity) return;
+    if(!entity)
+    {
+        // Deferred prims only keep their position
+        Vector3df vec = GetProcessedVector(&bytes[i]);
+        if (IsValidPositionVector(vec))
+            interest_.UpdatePosition(localid, vec);
+        return;
+    }
     EC_NetworkPosition *netpos = entity->GetComponent<EC_NetworkPosition>().get();
 
     Vector3df vec = GetProcessedVector(&bytes[i]);
@@ -345,7 +474,14 @@ void Primitive::HandleTerseObjectUpdateForPrim_60bytes(const uint8_t* bytes)
     i += 6;
     
     Scene::EntityPtr entity = rexlogicmodule_->GetPrimEntity(localid);
-    if(!entity) return;
+    if(!entity)
+    {
+        // Deferred prims only keep their position
+        Vector3df vec = GetProcessedVector(&bytes[i]);
+        if (IsValidPositionVector(vec))
+            interest_.UpdatePosition(localid, vec);
+        return;
+    }
     EC_NetworkPosition *netpos = entity->GetComponent<EC_NetworkPosition>().get();
 
     Vector3df vec = GetProcessedVector(&bytes[i]);
@@ -496,6 +632,17 @@ bool Primitive::HandleRexGM_RexFreeData(ProtocolUtilities::NetworkEventInboundDa
     for (uint i = 1; i < params.size(); ++i)
         freedata.append(params[i]);
     
+    // Binary EC data may be split into several messages, wait for all of them
+    if (ECSyncCodec::IsBinary(freedata))
+        ec_sync_stats_.receivedBytes += freedata.size();
+    if (ECSyncCodec::IsFragment(freedata))
+    {
+        std::string complete;
+        if (!ec_reassembler_.Add(primuuid.ToString(), freedata, complete))
+            return false;
+        freedata = complete;
+    }
+    
     Scene::EntityPtr entity = rexlogicmodule_->GetPrimEntity(primuuid);
     // If cannot get the entity, put to pending rexfreedata
     if (entity)
@@ -665,14 +812,17 @@ void Primitive::SendRexFreeData(entity_id_t entityid)
     if (!free || !prim )
         return;
 
+    SendRexData(prim->FullId, free->FreeData);
+}
+
+void Primitive::SendRexData(const RexUUID& fullid, const std::string& freedata)
+{
     WorldStreamPtr conn = rexlogicmodule_->GetServerConnection();
     if (!conn)
         return;
 
-    RexUUID fullid = prim->FullId;
     StringVector strings;
     strings.push_back(fullid.ToString());
-    const std::string& freedata = free->FreeData;
 
     // Split freedata into chunks of 200
     for (uint i = 0; i < freedata.length(); i += 200)
@@ -803,6 +953,28 @@ void Primitive::HandleRexFreeData(entity_id_t entityid, const std::string& freed
     EC_FreeData& free = *(dynamic_cast<EC_FreeData*>(freeptr.get()));
     free.FreeData = freedata;
     
+    if (ECSyncCodec::IsBinary(freedata))
+    {
+        PROFILE(Primitive_ApplyBinaryECs);
+        std::string data;
+        ECSyncCodec::ApplyResult result;
+        if (!ECSyncCodec::Unframe(freedata, data) || !ec_codec_.Apply(entity.get(), data, result))
+        {
+            RexLogicModule::LogWarning("Could not decode binary entity component data of entity " + ToString(entityid));
+            return;
+        }
+        ec_sync_stats_.received++;
+        ec_sync_stats_.receivedAttributes += result.attributes;
+        ec_sync_stats_.changedAttributes += result.changedAttributes;
+        // Nothing to tell if the data was identical to what we had, eg. our own update or a repeated keyframe
+        if (!result.changedAttributes && !result.createdComponents && !result.removedComponents)
+            return;
+        Scene::Events::SceneEventData event_data(entity->GetId());
+        EventManagerPtr event_manager = rexlogicmodule_->GetFramework()->GetEventManager();
+        event_manager->SendEvent("Scene", Scene::Events::EVENT_ENTITY_ECS_RECEIVED, &event_data);
+        return;
+    }
+    
     // Parse into XML form (may or may not succeed), and create/update EC's as result
     // (primitive form of EC serialization/replication)
     QDomDocument temp_doc;
@@ -817,6 +989,8 @@ void Primitive::HandleRexFreeData(entity_id_t entityid, const std::string& freed
 
 bool Primitive::HandleOSNE_KillObject(uint32_t objectid)
 {
+    interest_.Remove(objectid);
+
     Scene::ScenePtr scene = rexlogicmodule_->GetFramework()->GetDefaultWorldScene();
     if (!scene)
         return false;
@@ -841,11 +1015,15 @@ bool Primitive::HandleOSNE_KillObject(uint32_t objectid)
         if (prim->ParentId == objectid)
         {
             childfullid = prim->FullId;
+            ec_reassembler_.Remove(childfullid.ToString());
+            DiscardRequestTags(prim->LocalId);
             scene->RemoveEntity(prim->LocalId);
             rexlogicmodule_->UnregisterFullId(childfullid);
         }
     }
 
+    ec_reassembler_.Remove(fullid.ToString());
+    DiscardRequestTags(objectid);
     scene->RemoveEntity(objectid);
     rexlogicmodule_->UnregisterFullId(fullid);
     return false;
@@ -893,13 +1071,16 @@ void Primitive::HandleDrawType(entity_id_t entityid)
 {
     ///\todo Make this only discard mesh resource request tags.
     // Discard old request tags for this entity
-    DiscardRequestTags(entityid, prim_resource_request_tags_);
+    DiscardRequestTags(entityid);
 
     Scene::EntityPtr entity = rexlogicmodule_->GetPrimEntity(entityid);
     if (!entity)
         return;
 
     EC_OpenSimPrim &prim = *(entity->GetComponent<EC_OpenSimPrim>().get());
+    // Prim data has changed, so the assets used by this prim may have too
+    prim.UpdateAssetReferences();
+
     if ((prim.DrawType == RexTypes::DRAWTYPE_MESH) && (!RexTypes::IsNull(prim.MeshID)))
     {
         // Remove custom object component if exists
@@ -929,11 +1110,7 @@ void Primitive::HandleDrawType(entity_id_t entityid)
                 GetService<OgreRenderer::Renderer>(Service::ST_Renderer).lock();
             if (renderer)
             {
-                request_tag_t tag = renderer->RequestResource(mesh_name, OgreRenderer::OgreMeshResource::GetTypeStatic());
-
-                // Remember that we are going to get a resource event for this entity
-                if (tag)
-                    prim_resource_request_tags_[std::make_pair(tag, RexTypes::RexAT_Mesh)] = entityid;
+                RequestPrimResource(renderer.get(), entityid, mesh_name, OgreRenderer::OgreMeshResource::GetTypeStatic(), RexTypes::RexAT_Mesh);
             }
         }
         
@@ -945,11 +1122,7 @@ void Primitive::HandleDrawType(entity_id_t entityid)
                 GetService<OgreRenderer::Renderer>(Service::ST_Renderer).lock();
             if (renderer)
             {
-                request_tag_t tag = renderer->RequestResource(skeleton_name, OgreRenderer::OgreSkeletonResource::GetTypeStatic());
-
-                // Remember that we are going to get a resource event for this entity
-                if (tag)
-                    prim_resource_request_tags_[std::make_pair(tag, RexTypes::RexAT_Skeleton)] = entityid;
+                RequestPrimResource(renderer.get(), entityid, skeleton_name, OgreRenderer::OgreSkeletonResource::GetTypeStatic(), RexTypes::RexAT_Skeleton);
             }
         }
         
@@ -996,15 +1169,7 @@ void Primitive::HandleDrawType(entity_id_t entityid)
 
         // Create/update geometry
         if (prim.HasPrimShapeData)
-        {
-            Ogre::ManualObject* manual = CreatePrimGeometry(rexlogicmodule_->GetFramework(), prim);
-            custom.CommitChanges(manual);
-            
-            Scene::Events::EntityEventData event_data;
-            event_data.entity = entity;
-            EventManagerPtr event_manager = rexlogicmodule_->GetFramework()->GetEventManager();
-            event_manager->SendEvent("Scene", Scene::Events::EVENT_ENTITY_VISUALS_MODIFIED, &event_data);
-        }
+            QueuePrimGeometry(entityid);
     }
 
     if (!RexTypes::IsNull(prim.ParticleScriptID))
@@ -1028,11 +1193,7 @@ void Primitive::HandleDrawType(entity_id_t entityid)
                 GetService<OgreRenderer::Renderer>(Service::ST_Renderer).lock();
             if (renderer)
             {
-                request_tag_t tag = renderer->RequestResource(script_name, OgreRenderer::OgreParticleResource::GetTypeStatic());
-
-                // Remember that we are going to get a resource event for this entity
-                if (tag)
-                    prim_resource_request_tags_[std::make_pair(tag, RexTypes::RexAT_ParticleScript)] = entityid;
+                RequestPrimResource(renderer.get(), entityid, script_name, OgreRenderer::OgreParticleResource::GetTypeStatic(), RexTypes::RexAT_ParticleScript);
             }
         }
     }
@@ -1067,11 +1228,7 @@ void Primitive::HandlePrimTexturesAndMaterial(entity_id_t entityid)
         // Request material if don't have it yet
         if (!renderer->GetResource(matname, OgreRenderer::OgreMaterialResource::GetTypeStatic()))
         {
-            request_tag_t tag = renderer->RequestResource(matname, OgreRenderer::OgreMaterialResource::GetTypeStatic());
-             
-            // Remember that we are going to get a resource event for this entity
-            if (tag)
-                prim_resource_request_tags_[std::make_pair(tag, RexTypes::RexAT_MaterialScript)] = entityid;
+            RequestPrimResource(renderer.get(), entityid, matname, OgreRenderer::OgreMaterialResource::GetTypeStatic(), RexTypes::RexAT_MaterialScript);
         }
     }
     else
@@ -1098,11 +1255,7 @@ void Primitive::HandlePrimTexturesAndMaterial(entity_id_t entityid)
             // Request texture if don't have it yet
             if (!renderer->GetResource(texname, OgreRenderer::OgreTextureResource::GetTypeStatic()))
             {
-                request_tag_t tag = renderer->RequestResource(texname, OgreRenderer::OgreTextureResource::GetTypeStatic());
-             
-                // Remember that we are going to get a resource event for this entity
-                if (tag)
-                    prim_resource_request_tags_[std::make_pair(tag, RexTypes::RexAT_Texture)] = entityid;
+                RequestPrimResource(renderer.get(), entityid, texname, OgreRenderer::OgreTextureResource::GetTypeStatic(), RexTypes::RexAT_Texture);
             }
             
             ++j;
@@ -1156,11 +1309,7 @@ void Primitive::HandleMeshMaterials(entity_id_t entityid)
                     HandleTextureReady(entityid, res);
                 else
                 {
-                    request_tag_t tag = renderer->RequestResource(mat_name, OgreRenderer::OgreTextureResource::GetTypeStatic());
-
-                    // Remember that we are going to get a resource event for this entity
-                    if (tag)
-                        prim_resource_request_tags_[std::make_pair(tag, RexTypes::RexAT_Texture)] = entityid;   
+                    RequestPrimResource(renderer.get(), entityid, mat_name, OgreRenderer::OgreTextureResource::GetTypeStatic(), RexTypes::RexAT_Texture);
                 } 
             }
             break;
@@ -1171,11 +1320,7 @@ void Primitive::HandleMeshMaterials(entity_id_t entityid)
                     HandleMaterialResourceReady(entityid, res);
                 else
                 {
-                    request_tag_t tag = renderer->RequestResource(mat_name, OgreRenderer::OgreMaterialResource::GetTypeStatic());
-
-                    // Remember that we are going to get a resource event for this entity
-                    if (tag)
-                        prim_resource_request_tags_[std::make_pair(tag, RexTypes::RexAT_MaterialScript)] = entityid;   
+                    RequestPrimResource(renderer.get(), entityid, mat_name, OgreRenderer::OgreMaterialResource::GetTypeStatic(), RexTypes::RexAT_MaterialScript);
                 } 
             }
             break;
@@ -1359,7 +1504,7 @@ bool Primitive::HandleResourceEvent(event_id_t event_id, IEventData* data)
         switch(asset_type)
         {
         case RexAT_Texture:
-            HandleTextureReady(i->second, res);
+            HandleTextureReadyForConsumers(i->second, res);
             break;
         case RexAT_Mesh:
             HandleMeshReady(i->second, res);
@@ -1378,6 +1523,7 @@ bool Primitive::HandleResourceEvent(event_id_t event_id, IEventData* data)
             break;
         }
 
+        prim_resource_request_ids_.erase(event_data->tag_);
         prim_resource_request_tags_.erase(i);
         return true;
     }
@@ -1504,27 +1650,67 @@ void Primitive::HandleTextureReady(entity_id_t entityid, Foundation::ResourcePtr
         if (!meshptr) return;
         // If don't have the actual mesh entity yet, no use trying to set texture
         if (!meshptr->GetEntity()) return;
-        
-        MaterialMap::const_iterator i = prim->Materials.begin();
-        while (i != prim->Materials.end())
+        Scene::SceneManager *scene = entity->GetScene();
+        if (!scene) return;
+
+        // Only visit the submeshes that use this texture
+        Scene::AssetReferenceIndex::ReferenceVector refs;
+        scene->GetAssetReferenceIndex().GetReferences(res->GetId(), entityid, refs);
+        bool modified = false;
+        for (uint i = 0; i < refs.size(); ++i)
         {
-            uint idx = i->first;
-            if ((i->second.Type == RexTypes::RexAT_Texture || i->second.Type == RexTypes::RexAT_TextureJPEG) && (i->second.asset_id.compare(res->GetId()) == 0))
-            {
-                // Use a legacy material with the same name as the texture
-                OgreRenderer::GetOrCreateLegacyMaterial(res->GetId(), OgreRenderer::LEGACYMAT_NORMAL);
-                meshptr->SetMaterial(idx, res->GetId());
-                
-                Scene::Events::EntityEventData event_data;
-                event_data.entity = entity;
-                EventManagerPtr event_manager = rexlogicmodule_->GetFramework()->GetEventManager();
-                event_manager->SendEvent("Scene", Scene::Events::EVENT_ENTITY_VISUALS_MODIFIED, &event_data);
-            }
-            ++i;
+            if (refs[i].component != prim)
+                continue;
+            if (refs[i].type != RexTypes::RexAT_Texture && refs[i].type != RexTypes::RexAT_TextureJPEG)
+                continue;
+            uint idx = refs[i].slot;
+            // Already set when the texture was handled for another entity
+            if (meshptr->GetMaterialName(idx) == res->GetId())
+                continue;
+
+            // Use a legacy material with the same name as the texture
+            OgreRenderer::GetOrCreateLegacyMaterial(res->GetId(), OgreRenderer::LEGACYMAT_NORMAL);
+            meshptr->SetMaterial(idx, res->GetId());
+            modified = true;
+        }
+
+        if (modified)
+        {
+            Scene::Events::EntityEventData event_data;
+            event_data.entity = entity;
+            EventManagerPtr event_manager = rexlogicmodule_->GetFramework()->GetEventManager();
+            event_manager->SendEvent("Scene", Scene::Events::EVENT_ENTITY_VISUALS_MODIFIED, &event_data);
         }
     }
 }
 
+void Primitive::HandleTextureReadyForConsumers(entity_id_t entityid, Foundation::ResourcePtr res)
+{
+    if (!res)
+        return;
+
+    Scene::EntityPtr entity = rexlogicmodule_->GetPrimEntity(entityid);
+    Scene::SceneManager *scene = entity ? entity->GetScene() : 0;
+    if (!scene)
+    {
+        HandleTextureReady(entityid, res);
+        return;
+    }
+
+    // Every prim waiting for this texture can be set up now, instead of each one waiting for its own request tag.
+    // The copy is needed, as setting up an entity may modify the index.
+    std::vector<entity_id_t> consumers;
+    const Scene::AssetReferenceIndex::ReferenceVector &refs = scene->GetAssetReferenceIndex().GetReferences(res->GetId());
+    for (uint i = 0; i < refs.size(); ++i)
+        if (std::find(consumers.begin(), consumers.end(), refs[i].entity) == consumers.end())
+            consumers.push_back(refs[i].entity);
+    if (std::find(consumers.begin(), consumers.end(), entityid) == consumers.end())
+        consumers.push_back(entityid);
+
+    for (uint i = 0; i < consumers.size(); ++i)
+        HandleTextureReady(consumers[i], res);
+}
+
 void Primitive::HandleMaterialResourceReady(entity_id_t entityid, Foundation::ResourcePtr res)
 {
     assert(res.get());
@@ -1546,15 +1732,7 @@ void Primitive::HandleMaterialResourceReady(entity_id_t entityid, Foundation::Re
         {
             // Update geometry now that the material exists
             if (prim->HasPrimShapeData)
-            {
-                Ogre::ManualObject* manual = CreatePrimGeometry(rexlogicmodule_->GetFramework(), *prim);
-                custom->CommitChanges(manual);
-
-                Scene::Events::EntityEventData event_data;
-                event_data.entity = entity;
-                EventManagerPtr event_manager = rexlogicmodule_->GetFramework()->GetEventManager();
-                event_manager->SendEvent("Scene", Scene::Events::EVENT_ENTITY_VISUALS_MODIFIED, &event_data);
-            }
+                QueuePrimGeometry(entityid);
         }
     }
     
@@ -1566,12 +1744,16 @@ void Primitive::HandleMaterialResourceReady(entity_id_t entityid, Foundation::Re
         {
             // If don't have the actual mesh entity yet, no use trying to set the material
             if (!meshptr->GetEntity()) return;
-            
-            MaterialMap::const_iterator i = prim->Materials.begin();
-            while (i != prim->Materials.end())
+            Scene::SceneManager *scene = entity->GetScene();
+            if (!scene) return;
+
+            // Only visit the submeshes that use this material
+            Scene::AssetReferenceIndex::ReferenceVector refs;
+            scene->GetAssetReferenceIndex().GetReferences(res->GetId(), entityid, refs);
+            for (uint i = 0; i < refs.size(); ++i)
             {
-                uint idx = i->first;
-                if ((i->second.Type == RexTypes::RexAT_MaterialScript) && (i->second.asset_id == res->GetId()))
+                uint idx = refs[i].slot;
+                if ((refs[i].component == prim) && (refs[i].type == RexTypes::RexAT_MaterialScript))
                 {
                     OgreRenderer::OgreMaterialResource *materialRes = dynamic_cast<OgreRenderer::OgreMaterialResource*>(res.get());
                     assert(materialRes);
@@ -1597,25 +1779,100 @@ void Primitive::HandleMaterialResourceReady(entity_id_t entityid, Foundation::Re
                         //RexLogicModule::LogDebug(ss.str());
                     }
                 }
-                ++i;
             }
         }
     }
 }
 
-void Primitive::DiscardRequestTags(entity_id_t entityid, Primitive::EntityResourceRequestMap& map)
+void Primitive::QueuePrimGeometry(entity_id_t entityid)
 {
-    std::vector<Primitive::EntityResourceRequestMap::iterator> tags_to_remove;
+    Foundation::FrameSchedulerPtr scheduler = rexlogicmodule_->GetFramework()->GetFrameScheduler();
+    if (!scheduler)
+        return;
+
+    // Later prim data replaces the geometry queued for the earlier
+    std::map<entity_id_t, Foundation::frame_work_id_t>::iterator i = prim_geometry_work_.find(entityid);
+    if (i != prim_geometry_work_.end())
+        scheduler->CancelWork(i->second);
+
+    prim_geometry_work_[entityid] = scheduler->QueueWork("Primitive_CreateGeometry",
+        boost::bind(&Primitive::UpdatePrimGeometry, this, entityid), Foundation::FrameScheduler::PriorityNormal, cPrimGeometryDeadline);
+}
+
+void Primitive::UpdatePrimGeometry(entity_id_t entityid)
+{
+    prim_geometry_work_.erase(entityid);
+
+    // The prim may have been killed or turned into a mesh since the work was queued
+    Scene::EntityPtr entity = rexlogicmodule_->GetPrimEntity(entityid);
+    if (!entity)
+        return;
+    EC_OpenSimPrim *prim = entity->GetComponent<EC_OpenSimPrim>().get();
+    EC_OgreCustomObject *custom = entity->GetComponent<EC_OgreCustomObject>().get();
+    if (!prim || !custom || prim->DrawType != RexTypes::DRAWTYPE_PRIM || !prim->HasPrimShapeData)
+        return;
+
+    Ogre::ManualObject* manual = CreatePrimGeometry(rexlogicmodule_->GetFramework(), *prim);
+    custom->CommitChanges(manual);
+
+    Scene::Events::EntityEventData event_data;
+    event_data.entity = entity;
+    EventManagerPtr event_manager = rexlogicmodule_->GetFramework()->GetEventManager();
+    event_manager->SendEvent("Scene", Scene::Events::EVENT_ENTITY_VISUALS_MODIFIED, &event_data);
+}
 
-    EntityResourceRequestMap::iterator i = map.begin();
-    while (i != map.end())
+void Primitive::CancelPrimGeometryWork()
+{
+    Foundation::FrameSchedulerPtr scheduler = rexlogicmodule_->GetFramework()->GetFrameScheduler();
+    if (scheduler)
     {
-        if (i->second == entityid)
-            tags_to_remove.push_back(i);
-        ++i;
+        std::map<entity_id_t, Foundation::frame_work_id_t>::const_iterator i = prim_geometry_work_.begin();
+        while (i != prim_geometry_work_.end())
+        {
+            scheduler->CancelWork(i->second);
+            ++i;
+        }
+    }
+    prim_geometry_work_.clear();
+}
+
+void Primitive::RequestPrimResource(OgreRenderer::Renderer* renderer, entity_id_t entityid, const std::string& id,
+    const std::string& type, asset_type_t asset_type)
+{
+    request_tag_t tag = renderer->RequestResource(id, type);
+
+    // Remember that we are going to get a resource event for this entity
+    if (tag)
+    {
+        prim_resource_request_tags_[std::make_pair(tag, asset_type)] = entityid;
+        prim_resource_request_ids_[tag] = std::make_pair(id, type);
+    }
+}
+
+void Primitive::DiscardRequestTags(entity_id_t entityid)
+{
+    boost::shared_ptr<OgreRenderer::Renderer> renderer = rexlogicmodule_->GetFramework()->GetServiceManager()->
+        GetService<OgreRenderer::Renderer>(Service::ST_Renderer).lock();
+
+    EntityResourceRequestMap::iterator i = prim_resource_request_tags_.begin();
+    while (i != prim_resource_request_tags_.end())
+    {
+        if (i->second != entityid)
+        {
+            ++i;
+            continue;
+        }
+
+        // Let the renderer stop downloads that no one else waits for
+        ResourceRequestIdMap::iterator j = prim_resource_request_ids_.find(i->first.first);
+        if (j != prim_resource_request_ids_.end())
+        {
+            if (renderer)
+                renderer->CancelResourceRequest(j->second.first, j->second.second, j->first);
+            prim_resource_request_ids_.erase(j);
+        }
+        prim_resource_request_tags_.erase(i++);
     }
-    for (int j = 0; j < tags_to_remove.size(); ++j)
-        map.erase(tags_to_remove[j]);
 }
 
 void Primitive::HandlePrimScaleAndVisibility(entity_id_t entityid)
@@ -1968,9 +2225,14 @@ bool Primitive::HandleOSNE_AttachedSoundGainChange(ProtocolUtilities::NetworkEve
 void Primitive::HandleLogout()
 {
     prim_resource_request_tags_.clear();
+    prim_resource_request_ids_.clear();
+    CancelPrimGeometryWork();
     pending_rexprimdata_.clear();
     pending_rexfreedata_.clear();
     local_dirty_entities_.clear();
+    ec_sync_states_.clear();
+    ec_reassembler_.Clear();
+    interest_.Clear();
 }
 
 
@@ -2005,6 +2267,8 @@ void Primitive::RegisterToComponentChangeSignals(Scene::ScenePtr scene)
 {
     connect(scene.get(), SIGNAL( AttributeChanged(IComponent*, IAttribute*, AttributeChange::Type) ),
         this, SLOT( OnAttributeChanged(IComponent*, IAttribute*, AttributeChange::Type) ));
+    connect(scene.get(), SIGNAL( ComponentAttributesChanged(IComponent*, const AttributeVector&, AttributeChange::Type) ),
+        this, SLOT( OnComponentAttributesChanged(IComponent*, const AttributeVector&, AttributeChange::Type) ));
     connect(scene.get(), SIGNAL( ComponentAdded(Scene::Entity*, IComponent*, AttributeChange::Type) ),
         this, SLOT( OnEntityChanged(Scene::Entity*, IComponent*, AttributeChange::Type) ));
     connect(scene.get(), SIGNAL( ComponentRemoved(Scene::Entity*, IComponent*, AttributeChange::Type) ),
@@ -2012,6 +2276,14 @@ void Primitive::RegisterToComponentChangeSignals(Scene::ScenePtr scene)
 }
 
 void Primitive::OnAttributeChanged(IComponent* comp, IAttribute* attribute, AttributeChange::Type change)
+{
+    // Batched changes come once per component from OnComponentAttributesChanged
+    if ((!comp) || comp->IsAttributeChangeBatched())
+        return;
+    OnComponentAttributesChanged(comp, AttributeVector(1, attribute), change);
+}
+
+void Primitive::OnComponentAttributesChanged(IComponent* comp, const AttributeVector& attributes, AttributeChange::Type change)
 {
     if ((!comp) || (!comp->IsSerializable()) || (!comp->GetNetworkSyncEnabled()))
         return;
@@ -2083,8 +2355,10 @@ void Primitive::OnPrimDescriptionChanged(const EC_OpenSimPrim& prim)
     }
 }
 
-void Primitive::SerializeECsToNetwork()
+void Primitive::SerializeECsToNetwork(f64 frametime)
 {
+    PROFILE(Primitive_SerializeECsToNetwork);
+
     // Process the local change list for entities we have modified ourselves and have to send the EC data for
     for (EntityIdSet::iterator i = local_dirty_entities_.begin(); i != local_dirty_entities_.end(); ++i)
     {
@@ -2092,43 +2366,151 @@ void Primitive::SerializeECsToNetwork()
         if (!entity)
             continue;
         
-        //std::cout << "Processing locally dirty entity" << std::endl;
-        
-        const Scene::Entity::ComponentVector& components = entity->GetComponentVector();
-        
-        // Get/create freedata component
-        ComponentPtr freeptr = entity->GetOrCreateComponent(EC_FreeData::TypeNameStatic());
-        if (!freeptr)
+        if (!binary_ec_sync_)
+        {
+            std::string freedata;
+            if (!SerializeECsToXml(entity, freedata))
+                continue;
+            
+            // Get/create freedata component
+            ComponentPtr freeptr = entity->GetOrCreateComponent(EC_FreeData::TypeNameStatic());
+            if (!freeptr)
+                continue;
+            EC_FreeData& free = *(dynamic_cast<EC_FreeData*>(freeptr.get()));
+            free.FreeData = freedata;
+            SendRexFreeData(*i);
+            ec_sync_stats_.snapshots++;
+            ec_sync_stats_.fragments++;
+            ec_sync_stats_.sentBytes += freedata.size();
             continue;
-        EC_FreeData& free = *(dynamic_cast<EC_FreeData*>(freeptr.get()));
+        }
         
-        QDomDocument temp_doc;
-        QDomElement entity_elem = temp_doc.createElement("entity");
+        ECSyncState& sync = ec_sync_states_[*i];
+        ECSyncCodec::EntityState state;
+        ec_codec_.Encode(entity.get(), state);
         
-        QString id_str;
-        id_str.setNum(entity->GetId());
-        entity_elem.setAttribute("id", id_str);
+        // Send everything when the components have changed, otherwise only the attributes that have changed
+        std::string data;
+        if (sync.state.empty() || !ECSyncCodec::SameComponents(sync.state, state))
+        {
+            data = ec_codec_.WriteSnapshot(state);
+            sync.keyframePending = false;
+            ec_sync_stats_.snapshots++;
+        }
+        else
+        {
+            uint changed = 0;
+            data = ec_codec_.WriteDelta(sync.state, state, changed);
+            if (data.empty())
+                continue;
+            sync.keyframePending = true;
+            ec_sync_stats_.deltas++;
+            ec_sync_stats_.sentAttributes += changed;
+        }
         
-        for (uint j = 0; j < components.size(); ++j)
+        sync.state.swap(state);
+        sync.quietTime = 0.0;
+        // The server keeps only the last fragment, so a fragmented update is always followed by a keyframe
+        if (SendECSyncData(*i, data, true) > 1)
+            sync.keyframePending = true;
+    }
+    local_dirty_entities_.clear();
+    
+    if (!binary_ec_sync_)
+        return;
+    
+    // The server keeps only the latest freedata of a prim for the clients that join later, so after the deltas
+    // or fragments have stopped, send the whole state once more as a single message
+    ECSyncStateMap::iterator i = ec_sync_states_.begin();
+    while (i != ec_sync_states_.end())
+    {
+        ECSyncState& sync = i->second;
+        if (!sync.keyframePending)
         {
-            if ((components[j]->IsSerializable()) && (components[j]->GetNetworkSyncEnabled()))
-                components[j]->SerializeTo(temp_doc, entity_elem);
+            ++i;
+            continue;
         }
         
-        temp_doc.appendChild(entity_elem);
-        QByteArray bytes = temp_doc.toByteArray();
+        sync.quietTime += frametime;
+        if (sync.quietTime < ec_sync_keyframe_delay_)
+        {
+            ++i;
+            continue;
+        }
         
-        if (bytes.size() > 1000)
+        if (!rexlogicmodule_->GetPrimEntity(i->first))
         {
-            RexLogicModule::LogError("Entity component serialized data is too large (>1000 bytes), not sending update");
+            ec_sync_states_.erase(i++);
             continue;
         }
         
-        //std::cout << "Sending freedata" << std::endl;
-        free.FreeData = std::string(bytes.data(), bytes.size());
-        SendRexFreeData(*i);
+        sync.keyframePending = false;
+        if (SendECSyncData(i->first, ec_codec_.WriteSnapshot(sync.state), false))
+            ec_sync_stats_.keyframes++;
+        ++i;
     }
-    local_dirty_entities_.clear();
+}
+
+bool Primitive::SerializeECsToXml(Scene::EntityPtr entity, std::string& freedata)
+{
+    const Scene::Entity::ComponentVector& components = entity->GetComponentVector();
+    
+    QDomDocument temp_doc;
+    QDomElement entity_elem = temp_doc.createElement("entity");
+    
+    QString id_str;
+    id_str.setNum(entity->GetId());
+    entity_elem.setAttribute("id", id_str);
+    
+    for (uint j = 0; j < components.size(); ++j)
+    {
+        if ((components[j]->IsSerializable()) && (components[j]->GetNetworkSyncEnabled()))
+            components[j]->SerializeTo(temp_doc, entity_elem);
+    }
+    
+    temp_doc.appendChild(entity_elem);
+    QByteArray bytes = temp_doc.toByteArray();
+    
+    if (bytes.size() > (int)ec_sync_max_size_)
+    {
+        RexLogicModule::LogError("Entity component serialized data is too large (>" + ToString(ec_sync_max_size_) + " bytes), not sending update");
+        return false;
+    }
+    
+    freedata = std::string(bytes.data(), bytes.size());
+    return true;
+}
+
+uint Primitive::SendECSyncData(entity_id_t entityid, const std::string& data, bool fragment)
+{
+    Scene::EntityPtr entity = rexlogicmodule_->GetPrimEntity(entityid);
+    if (!entity)
+        return 0;
+    EC_OpenSimPrim* prim = entity->GetComponent<EC_OpenSimPrim>().get();
+    if (!prim)
+        return 0;
+    
+    StringVector frames;
+    ECSyncCodec::Frame(data, ec_sync_max_size_, ec_sync_message_id_++, frames);
+    if (frames.size() > 1 && !fragment)
+    {
+        RexLogicModule::LogWarning("Entity component data of entity " + ToString(entityid) + " is too large (>" +
+            ToString(ec_sync_max_size_) + " bytes) for a keyframe, clients that join later will not get it");
+        return 0;
+    }
+    
+    // Keep the unfragmented data in EC_FreeData, the same as what a receiver ends up with
+    ComponentPtr freeptr = entity->GetOrCreateComponent(EC_FreeData::TypeNameStatic());
+    if (freeptr && frames.size() == 1)
+        dynamic_cast<EC_FreeData*>(freeptr.get())->FreeData = frames.front();
+    
+    for (uint i = 0; i < frames.size(); ++i)
+    {
+        SendRexData(prim->FullId, frames[i]);
+        ec_sync_stats_.fragments++;
+        ec_sync_stats_.sentBytes += frames[i].size();
+    }
+    return frames.size();
 }
 
 void Primitive::DeserializeECsFromFreeData(Scene::EntityPtr entity, QDomDocument& doc)
@@ -14,6 +14,9 @@
 #include "IComponent.h"
 #include "SceneManager.h"
 #include "Color.h"
+#include "Environment/ECSyncCodec.h"
+#include "Environment/PrimInterestManager.h"
+#include "FrameScheduler.h"
 
 #include <QObject>
 
@@ -22,9 +25,15 @@ class QDomDocument;
 
 class EC_OpenSimPrim;
 
+namespace OgreRenderer
+{
+    class Renderer;
+}
+
 namespace ProtocolUtilities
 {
     class NetworkEventInboundData;
+    class NetInMessage;
 }
 
 namespace RexLogic
@@ -58,12 +67,42 @@ namespace RexLogic
         void HandleTerseObjectUpdateForPrim_44bytes(const uint8_t* bytes);
         void HandleTerseObjectUpdateForPrim_60bytes(const uint8_t* bytes);
 
+        //! Returns true if the ObjectUpdate of the prim has been kept without creating an entity, because the prim is not yet interesting
+        bool IsDeferred(entity_id_t entityid) const { return interest_.IsDeferred(entityid); }
+
         bool HandleResourceEvent(event_id_t event_id, IEventData* data);
 
         void HandleLogout();
 
         typedef std::map<std::pair<request_tag_t, asset_type_t>, entity_id_t> EntityResourceRequestMap;
 
+        //! Counters of the entity component data sent and received as RexFreeData
+        struct ECSyncStats
+        {
+            ECSyncStats() : snapshots(0), deltas(0), keyframes(0), fragments(0), sentBytes(0), sentAttributes(0),
+                received(0), receivedBytes(0), receivedAttributes(0), changedAttributes(0) {}
+            //! Updates sent with all components
+            uint snapshots;
+            //! Updates sent with only the changed attributes
+            uint deltas;
+            //! Snapshots sent after the entity has stopped changing
+            uint keyframes;
+            //! RexData messages sent
+            uint fragments;
+            //! Bytes of freedata sent
+            u64 sentBytes;
+            //! Attributes sent in deltas
+            u64 sentAttributes;
+            //! Updates received
+            uint received;
+            //! Bytes of freedata received
+            u64 receivedBytes;
+            //! Attributes received
+            u64 receivedAttributes;
+            //! Received attributes that differed from the local value
+            u64 changedAttributes;
+        };
+
         // Send RexPrimData of a prim entity to server
         ///\todo Move to WorldStream?
         void SendRexPrimData(entity_id_t entityid);
@@ -77,10 +116,27 @@ namespace RexLogic
         
         // Deserialize EC's sent by server
         void DeserializeECsFromFreeData(Scene::EntityPtr entity, QDomDocument& doc);
+
+        //! Returns the counters of entity component data sent and received
+        const ECSyncStats& GetECSyncStats() const { return ec_sync_stats_; }
+
+        //! Resets the entity component data counters
+        void ResetECSyncStats() { ec_sync_stats_ = ECSyncStats(); }
+
+        //! Returns the interest management of prims
+        const PrimInterestManager& GetInterestManager() const { return interest_; }
+
+        //! Resets the interest management counters and measures the time to interactive again
+        void ResetInterestStats() { interest_.ResetStats(); }
+
+        //! Returns the number of prim asset requests that have not finished
+        size_t GetPendingRequestCount() const { return prim_resource_request_tags_.size(); }
         
     public slots:
         //! Trigger EC sync because of component attributes changing
         void OnAttributeChanged(IComponent* comp, IAttribute* attribute, AttributeChange::Type change);
+        //! Trigger EC sync once for a batch of attribute changes of a component
+        void OnComponentAttributesChanged(IComponent* comp, const AttributeVector& attributes, AttributeChange::Type change);
         //! Trigger EC sync because of components added/removed to entity
         void OnEntityChanged(Scene::Entity* entity, IComponent* comp, AttributeChange::Type change);
         //! When rex prim propeties have changed, send update to sim
@@ -100,6 +156,16 @@ namespace RexLogic
         //!         Does not return null. If the entity doesn't exist, an entity with the given entityid and fullid is created and returned.
         Scene::EntityPtr GetOrCreatePrimEntity(entity_id_t entityid, const RexUUID &fullid, bool *was_created);
         Scene::EntityPtr CreateNewPrimEntity(entity_id_t entityid);
+
+        //! Reads one object of an ObjectUpdate message
+        void ReadObjectUpdate(ProtocolUtilities::NetInMessage &msg, PrimObjectUpdate &update);
+
+        //! Creates or updates the prim entity of an ObjectUpdate, and the deferred children of the prim
+        //! @param wasDeferred True if the update was deferred before.
+        void ApplyObjectUpdate(const PrimObjectUpdate &update, bool wasDeferred);
+
+        //! Creates the deferred prims that have become interesting
+        void UpdateInterest(f64 frametime);
         
         //! checks if stored pending rexdata exists for prim and handles it
         //! @param entityid Entity id.
@@ -177,16 +243,45 @@ namespace RexLogic
         //! handles mesh or prim texture resource being ready
         void HandleTextureReady(entity_id_t entity, Foundation::ResourcePtr res);
 
+        //! handles texture resource being ready for all prims that use it, found from the scene's asset reference index
+        void HandleTextureReadyForConsumers(entity_id_t entity, Foundation::ResourcePtr res);
+
         void HandleMaterialResourceReady(entity_id_t entityid, Foundation::ResourcePtr res);
 
         //! handles prim size and visibility
         void HandlePrimScaleAndVisibility(entity_id_t entityid);
 
-        //! discards request tags for certain entity
-        void DiscardRequestTags(entity_id_t, EntityResourceRequestMap& map);
+        //! queues the geometry of a prim to be created by the frame scheduler, replacing the work queued earlier for it
+        void QueuePrimGeometry(entity_id_t entityid);
+
+        //! creates the geometry of a prim into its custom object. Run by the frame scheduler
+        void UpdatePrimGeometry(entity_id_t entityid);
+
+        //! cancels the queued prim geometry work
+        void CancelPrimGeometryWork();
+
+        //! requests a renderer resource for an entity, and remembers the request tag
+        void RequestPrimResource(OgreRenderer::Renderer* renderer, entity_id_t entityid, const std::string& id,
+            const std::string& type, asset_type_t asset_type);
+
+        //! discards request tags for certain entity, and cancels the requests
+        void DiscardRequestTags(entity_id_t entityid);
 
         // Go through dirty lists & send changed components to server
-        void SerializeECsToNetwork();
+        void SerializeECsToNetwork(f64 frametime);
+
+        //! Serializes the EC's of an entity to XML freedata, the format used before the binary encoding
+        bool SerializeECsToXml(Scene::EntityPtr entity, std::string& freedata);
+
+        //! Sends binary EC data of an entity
+        /*! \param fragment Whether the data may be fragmented to several RexData messages if necessary. If not,
+                data that does not fit one message is not sent.
+            \return Number of RexData messages sent
+         */
+        uint SendECSyncData(entity_id_t entityid, const std::string& data, bool fragment);
+
+        //! Sends one RexData message
+        void SendRexData(const RexUUID& fullid, const std::string& freedata);
 
         //! Return valid uuid if given id is valid uuid or if given id
         //! is valid asset url with format: 'http://domain/path/xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx'
@@ -200,6 +295,14 @@ namespace RexLogic
         //! maps tags of all pending resource request to prim entities.
         EntityResourceRequestMap prim_resource_request_tags_;
 
+        typedef std::map<request_tag_t, std::pair<std::string, std::string> > ResourceRequestIdMap;
+
+        //! resource ids and types of the pending resource requests, for canceling them
+        ResourceRequestIdMap prim_resource_request_ids_;
+
+        //! frame scheduler work that creates prim geometry, by entity
+        std::map<entity_id_t, Foundation::frame_work_id_t> prim_geometry_work_;
+
         //! pending rexprimdatas. This map exists because in some cases the network messages that describe prim parameters
         //! are received before the actual objects have been created (first ObjectUpdate is received). Any such pending
         //! messages are queued here to wait that the object is created. The real problem here is that SLUDP doesn't give
@@ -214,6 +317,42 @@ namespace RexLogic
         typedef std::set<entity_id_t> EntityIdSet;
         //! entities with local EC changes
         EntityIdSet local_dirty_entities_;
+
+        //! Last EC state sent of an entity
+        struct ECSyncState
+        {
+            ECSyncState() : keyframePending(false), quietTime(0.0) {}
+            ECSyncCodec::EntityState state;
+            //! Whether deltas or a fragmented snapshot have been sent after the last unfragmented snapshot
+            bool keyframePending;
+            //! Time since the last update was sent
+            f64 quietTime;
+        };
+        typedef std::map<entity_id_t, ECSyncState> ECSyncStateMap;
+        ECSyncStateMap ec_sync_states_;
+
+        //! Binary EC data encoder and decoder
+        ECSyncCodec ec_codec_;
+
+        //! Fragments of received binary EC data
+        ECSyncReassembler ec_reassembler_;
+
+        //! Id of the next fragmented message
+        uint ec_sync_message_id_;
+
+        //! Whether EC's are sent in the binary format. If false (the default), they are sent as XML. Received EC's are read in either format.
+        bool binary_ec_sync_;
+
+        //! Maximum size of the freedata of one RexData message
+        uint ec_sync_max_size_;
+
+        //! Time without changes after which the whole EC state is sent again, so that the data stored by the server is complete
+        f64 ec_sync_keyframe_delay_;
+
+        ECSyncStats ec_sync_stats_;
+
+        //! Prims that are kept as their ObjectUpdate until they come into range or view
+        PrimInterestManager interest_;
     };
 }
 #endif
@@ -317,12 +317,12 @@ bool NetworkEventHandler::HandleOSNE_ImprovedTerseObjectUpdate(NetworkEventInbou
         case 44:
             //this size is only for prims
             localid = *reinterpret_cast<uint32_t*>((uint32_t*)&bytes[0]);
-            if (owner_->GetPrimEntity(localid))
+            if (owner_->GetPrimEntity(localid) || owner_->GetPrimitiveHandler()->IsDeferred(localid))
                 owner_->GetPrimitiveHandler()->HandleTerseObjectUpdateForPrim_44bytes(bytes);
             break;
         case 60:
             localid = *reinterpret_cast<uint32_t*>((uint32_t*)&bytes[0]); 
-            if (owner_->GetPrimEntity(localid)) 
+            if (owner_->GetPrimEntity(localid) || owner_->GetPrimitiveHandler()->IsDeferred(localid))
                 owner_->GetPrimitiveHandler()->HandleTerseObjectUpdateForPrim_60bytes(bytes);
             else if (owner_->GetAvatarEntity(localid))
                 owner_->GetAvatarHandler()->HandleTerseObjectUpdateForAvatar_60bytes(bytes);
@@ -349,7 +349,7 @@ bool NetworkEventHandler::HandleOSNE_KillObject(NetworkEventInboundData* data)
     for(size_t i = 0; i < instance_count; ++i)
     {
         uint32_t killedobjectid = msg.ReadU32();
-        if (owner_->GetPrimEntity(killedobjectid))
+        if (owner_->GetPrimEntity(killedobjectid) || owner_->GetPrimitiveHandler()->IsDeferred(killedobjectid))
             return owner_->GetPrimitiveHandler()->HandleOSNE_KillObject(killedobjectid);
         if (owner_->GetAvatarEntity(killedobjectid))
             return owner_->GetAvatarHandler()->HandleOSNE_KillObject(killedobjectid);
@@ -160,6 +160,8 @@
 #include <OgreEntity.h>
 #include <OgreBillboard.h>
 #include <OgreBillboardSet.h>
+#include <OgreTextureManager.h>
+#include <OgreMeshManager.h>
 
 #include <boost/make_shared.hpp>
 
@@ -385,6 +387,14 @@ void RexLogicModule::PostInitialize()
         "Toggle flight mode.",
         Console::Bind(this, &RexLogicModule::ConsoleToggleFlyMode)));
 
+    RegisterConsoleCommand(Console::CreateCommand("ECSyncStats",
+        "Prints the amount of entity component data sent and received. Usage: ECSyncStats(reset)",
+        Console::Bind(this, &RexLogicModule::ConsoleECSyncStats)));
+
+    RegisterConsoleCommand(Console::CreateCommand("InterestStats",
+        "Prints the prim entities, the prims deferred until they come into range or view, and the time to interactive. Usage: InterestStats(reset)",
+        Console::Bind(this, &RexLogicModule::ConsoleInterestStats)));
+
 #ifdef EC_Highlight_ENABLED
     RegisterConsoleCommand(Console::CreateCommand("Highlight",
         "Adds/removes EC_Highlight for every prim and mesh. Usage: highlight(add|remove)."
@@ -1216,6 +1226,60 @@ Console::CommandResult RexLogicModule::ConsoleToggleFlyMode(const StringVector &
     return Console::ResultSuccess();
 }
 
+Console::CommandResult RexLogicModule::ConsoleECSyncStats(const StringVector &params)
+{
+    if (!primitive_)
+        return Console::ResultFailure("Primitive handler not initialized.");
+
+    const Primitive::ECSyncStats &stats = primitive_->GetECSyncStats();
+    uint sent = stats.snapshots + stats.deltas + stats.keyframes;
+    std::stringstream ss;
+    ss << "Sent " << sent << " updates (" << stats.snapshots << " snapshots, " << stats.deltas << " deltas with "
+       << stats.sentAttributes << " attributes, " << stats.keyframes << " keyframes) in " << stats.fragments
+       << " messages, " << stats.sentBytes << " bytes";
+    if (sent)
+        ss << ", " << stats.sentBytes / sent << " bytes per update";
+    ss << std::endl << "Received " << stats.received << " binary updates, " << stats.receivedBytes << " bytes";
+    if (stats.received)
+        ss << ", " << stats.receivedBytes / stats.received << " bytes per update";
+    ss << ", " << stats.changedAttributes << " of " << stats.receivedAttributes << " attributes changed";
+
+    if (params.size() > 0 && params[0] == "reset")
+        primitive_->ResetECSyncStats();
+
+    return Console::ResultSuccess(ss.str());
+}
+
+Console::CommandResult RexLogicModule::ConsoleInterestStats(const StringVector &params)
+{
+    if (!primitive_)
+        return Console::ResultFailure("Primitive handler not initialized.");
+
+    const PrimInterestManager &interest = primitive_->GetInterestManager();
+    const PrimInterestManager::Stats &stats = interest.GetStats();
+    Scene::ScenePtr scene = framework_->GetDefaultWorldScene();
+    size_t prims = scene ? scene->GetEntitiesWithComponent(EC_OpenSimPrim::TypeNameStatic()).size() : 0;
+
+    std::stringstream ss;
+    ss << "Interest management " << (interest.IsEnabled() ? "enabled" : "disabled") << ", " << prims << " prim entities ("
+       << stats.created << " created on arrival, " << stats.promoted << " when they became interesting)" << std::endl
+       << interest.GetDeferredCount() << " prims deferred (" << stats.deferred << " in total), " << interest.GetDistinctShapeCount()
+       << " distinct shapes, " << interest.GetMemoryUse() << " bytes" << std::endl;
+    if (Ogre::TextureManager::getSingletonPtr() && Ogre::MeshManager::getSingletonPtr())
+        ss << "Ogre textures " << Ogre::TextureManager::getSingleton().getMemoryUsage() / 1024 << " KB, meshes "
+           << Ogre::MeshManager::getSingleton().getMemoryUsage() / 1024 << " KB, ";
+    ss << primitive_->GetPendingRequestCount() << " prim asset requests pending" << std::endl;
+    if (stats.timeToInteractive >= 0.0)
+        ss << "Time to interactive " << stats.timeToInteractive << " s";
+    else
+        ss << "Region not yet interactive";
+
+    if (params.size() > 0 && params[0] == "reset")
+        primitive_->ResetInterestStats();
+
+    return Console::ResultSuccess(ss.str());
+}
+
 Console::CommandResult RexLogicModule::ConsoleHighlightTest(const StringVector &params)
 {
 #ifdef EC_Highlight_ENABLED
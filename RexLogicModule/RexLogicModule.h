@@ -185,6 +185,9 @@ namespace RexLogic
         //! handles assignment of child objects, who were previously missing this object as a parent
         void HandleMissingParent(entity_id_t entityid);
 
+        //! returns true if objects are waiting for the entity as their parent
+        bool HasPendingChildren(entity_id_t entityid) const { return pending_parents_.find(entityid) != pending_parents_.end(); }
+
         //! login from py - temp while loginui misses dllexport
         void StartLoginOpensim(const QString &firstAndLast, const QString &password, const QString &serverAddressWithPort);
 
@@ -263,6 +266,12 @@ namespace RexLogic
         //! Console command for test EC_Highlight. Adds EC_Highlight for every avatar.
         Console::CommandResult ConsoleHighlightTest(const StringVector &params);
 
+        //! Prints the counters of entity component data sent and received as RexFreeData. Usage: ECSyncStats(reset)
+        Console::CommandResult ConsoleECSyncStats(const StringVector &params);
+
+        //! Prints the prim entities, the deferred prims, the memory used by them and the time to interactive. Usage: InterestStats(reset)
+        Console::CommandResult ConsoleInterestStats(const StringVector &params);
+
         /// Returns Ogre renderer pointer. Convenience function for making code cleaner.
         OgreRenderer::RendererPtr GetOgreRendererPtr() const;
 
@@ -3,6 +3,7 @@
 #include "StableHeaders.h"
 #include "XmlRpcException.h"
 #include "XmlRpcConnection.h"
+#include "XmlRpcStreamReader.h"
 #include "HttpRequest.h"
 
 #include <Poco/URI.h>
@@ -14,6 +15,7 @@
 #endif
 
 #include <boost/lexical_cast.hpp>
+#include <boost/bind.hpp>
 
 #ifdef _MSC_VER
 #pragma warning( pop )
@@ -60,3 +62,28 @@ XMLRPC_REQUEST XmlRpcConnection::Send(const char* data)
     // Convert the XML string to a XMLRPC reply structure.
     return XMLRPC_REQUEST_FromXML((const char*)&response_data[0], (int)(response_data.size()), 0);
 }
+
+void XmlRpcConnection::Send(const char* data, XmlRpcStreamReader& reader)
+{
+    reader.Reset();
+
+    HttpUtilities::HttpRequest request;
+    request.SetUrl(strUrl_);
+    request.SetRequestData("text/xml", data);
+    request.SetMethod(HttpUtilities::HttpRequest::Post);
+    request.SetResponseHandler(boost::bind(&XmlRpcStreamReader::AddData, &reader, _1, _2));
+    request.Perform();
+
+    // A reader error aborts the transfer, report it rather than the failed write
+    if (!reader.GetError().empty())
+        throw XmlRpcException(std::string("XmlRpcEpi exception in XmlRpcConnection::Send() " + reader.GetError()));
+
+    if (!request.GetSuccess())
+        throw XmlRpcException(std::string("XmlRpcEpi exception in XmlRpcConnection::Send() " + request.GetReason()));
+
+    if (reader.GetStats().bytes == 0)
+        throw XmlRpcException(std::string("XmlRpcEpi exception in XmlRpcConnection::Send() response data size was zero: "));
+
+    if (!reader.Finish())
+        throw XmlRpcException(std::string("XmlRpcEpi exception in XmlRpcConnection::Send() " + reader.GetError()));
+}
@@ -4,6 +4,8 @@
 
 #include <xmlrpc.h>
 
+class XmlRpcStreamReader;
+
 /**
  * Represents a XMLRPC connection. You can do multiple XMLRPC requests/replies using the same connection.
  * @note use class throught XMLRPCEPI-class. 
@@ -43,6 +45,14 @@ public:
 	 **/
 	XMLRPC_REQUEST Send(const char* data);  
 
+	/**
+	 * Sends the XMLRPC request data over to the server, and reads the reply with a stream reader as it arrives.
+	 * @param data is pure xml which is constructed in @p XMLRPCCall -class
+	 * @param reader is the reader the reply is read with.
+	 * @throw XMLRPCException is send failed for some reason, or the reply could not be read.
+	 **/
+	void Send(const char* data, XmlRpcStreamReader& reader);
+
 private:
 	std::string strUrl_;
 };
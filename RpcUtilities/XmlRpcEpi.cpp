@@ -6,29 +6,30 @@
 #include "XmlRpcEpi.h"
 #include "XmlRpcConnection.h"
 #include "XmlRpcCall.h"
+#include "XmlRpcStreamReader.h"
 
 #include <xmlrpc.h>
 
 XmlRpcEpi::XmlRpcEpi() 
-: callMethod_(""), call_(0), connection_(0)
+: callMethod_(""), call_(0), connection_(0), streamReader_(0)
 {
 }
 
 XmlRpcEpi::XmlRpcEpi(const std::string& method) 
-: callMethod_(""), call_(0), connection_(0)
+: callMethod_(""), call_(0), connection_(0), streamReader_(0)
 {
     CreateCall(method);
 }
 
 XmlRpcEpi::XmlRpcEpi(const std::string& method, const std::string& address, const std::string& port) 
-: callMethod_(""), call_(0), connection_(0)
+: callMethod_(""), call_(0), connection_(0), streamReader_(0)
 {
     Connect(address, port);
     CreateCall(method);
 }
 
 XmlRpcEpi::XmlRpcEpi(const std::string& method, const std::string& url) 
-: callMethod_(""), call_(0), connection_(0)
+: callMethod_(""), call_(0), connection_(0), streamReader_(0)
 {
     Connect(url);
     CreateCall(method);
@@ -99,7 +100,10 @@ void XmlRpcEpi::Send()
 
     try
     {
-        call_->SetReply(connection_->Send(pXmlData));
+        if (streamReader_)
+            connection_->Send(pXmlData, *streamReader_);
+        else
+            call_->SetReply(connection_->Send(pXmlData));
     }
     catch(XmlRpcException& ex)
     {
@@ -129,6 +133,9 @@ bool XmlRpcEpi::HasReply(const char* name) const
 {
     assert(name && strlen(name) > 0);
 
+    if (streamReader_)
+        return streamReader_->HasValue(name);
+
     if (call_ == 0)
         return false;
     XMLRPC_VALUE result = XMLRPC_RequestGetData(call_->GetReply());
@@ -7,6 +7,7 @@
 
 class XmlRpcConnection;
 class XmlRpcCall;
+class XmlRpcStreamReader;
 
 	/**
 	 * This class purpose is to be easy interface for XMLRPC-epi function calls. You only need to include this 
@@ -80,6 +81,15 @@ class XmlRpcCall;
 			@throw XMLRPCException if message cannot be send or problem occures. */
 		void Send();
 
+		/** Sets a stream reader that the replies are read with as they arrive, instead of building them in memory.
+			GetReply() and HasReply() then read the scalar values of the reply from the reader, and GetVectorReply()
+			is not available; set array handlers to the reader to read arrays. Set null to stop streaming.
+			@param reader The reader, which must exist as long as it is set. Not owned by this object. */
+		void SetStreamReader(XmlRpcStreamReader *reader) { streamReader_ = reader; }
+
+		/// Returns the stream reader the replies are read with, or null if they are not streamed
+		XmlRpcStreamReader *GetStreamReader() const { return streamReader_; }
+
 		/**
 		 * Sets a new call method name. 
 		 * @param method is new xmlrpc request method name. 
@@ -147,6 +157,7 @@ class XmlRpcCall;
 		std::string callMethod_;
 		XmlRpcConnection* connection_;
 		XmlRpcCall* call_;
+		XmlRpcStreamReader* streamReader_;
 	};
 
 	#include "XmlRpcEpiTemplates.h"
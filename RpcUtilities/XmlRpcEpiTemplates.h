@@ -5,6 +5,7 @@
 #endif
 
 #include "XmlRpcCall.h"
+#include "XmlRpcStreamReader.h"
 
 #include <xmlrpc.h>
 
@@ -27,6 +28,29 @@ template <typename T> T XmlRpcEpi::GetReply(const char* name) const
     if (call_ == 0)
         throw XmlRpcException(std::string("XmlRpcEpi exception in GetReply() error: Call object is zero pointer"));
 
+    if (streamReader_)
+    {
+        // The reader keeps the scalar values as text
+        const std::string *text = streamReader_->GetValue(name);
+        if (!text)
+        {
+            std::string strName(name);
+            if (streamReader_->HasValue(name))
+                throw XmlRpcException(std::string("XmlRpcEpi exception in GetReply() error: XML reply contain Vector data! (Tried to retrieve reply by ID ") + strName);
+            throw XmlRpcException(std::string("XmlRpcEpi exception in GetReply() error: XML reply data was not found! (Tried to retrieve reply by ID ") + strName);
+        }
+
+        try
+        {
+            return boost::lexical_cast<T>(*text);
+        }
+        catch (boost::bad_lexical_cast&)
+        {
+            std::string strName(name);
+            throw XmlRpcException(std::string("XmlRpcEpi exception in GetReply() error: XML reply data was not converted to wanted type! (Tried to retrieve reply by ID ") + strName);
+        }
+    }
+
     // I'm probably not understanding the value hierarchy here.. samples use XMLRPC_VectorRewind(XMLRPC_RequestGetData(request))
     // but it seems to walk into the first element of the vector, after which GetValueWithID doesn't find the correct sibling. wtf?
 
@@ -135,6 +159,9 @@ template <typename T> std::vector<T> XmlRpcEpi::GetVectorReply(const char* name)
     if (call_ == 0)
         throw XmlRpcException(std::string("XmlRpcEpi exception in GetReply() error: Call object is zero pointer"));
 
+    if (streamReader_)
+        throw XmlRpcException(std::string("XmlRpcEpi exception in GetVectorReply() error: the reply was streamed, arrays are only given to the array handlers of the reader"));
+
     // I'm probably not understanding the value hierarchy here.. samples use XMLRPC_VectorRewind(XMLRPC_RequestGetData(request))
     // but it seems to walk into the first element of the vector, after which GetValueWithID doesn't find the correct sibling. wtf?
 
@@ -0,0 +1,256 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+
+#include "StableHeaders.h"
+#include "XmlRpcStreamReader.h"
+#include "HighPerfClock.h"
+#include "CoreStringUtils.h"
+
+#include <QXmlStreamReader>
+
+XmlRpcStreamReader::XmlRpcStreamReader() :
+    xml_(new QXmlStreamReader())
+{
+    Reset();
+}
+
+XmlRpcStreamReader::~XmlRpcStreamReader()
+{
+    delete xml_;
+}
+
+void XmlRpcStreamReader::SetArrayHandler(const std::string& name, const ArrayHandler& handler)
+{
+    handlers_[name] = handler;
+}
+
+void XmlRpcStreamReader::Reset()
+{
+    xml_->clear();
+    values_.clear();
+    containers_.clear();
+    valuesSize_ = 0;
+    names_.clear();
+    isContainer_.clear();
+    valueDepth_ = 0;
+    text_.clear();
+    collectText_ = false;
+    typeEnded_ = false;
+    handler_ = 0;
+    element_.clear();
+    elementSize_ = 0;
+    inElement_ = false;
+    chunkSize_ = 0;
+    stats_.bytes = 0;
+    stats_.elements = 0;
+    stats_.peakBytesHeld = 0;
+    stats_.parseTime = 0.0;
+    error_.clear();
+}
+
+bool XmlRpcStreamReader::AddData(const u8 *data, uint size)
+{
+    if (!error_.empty())
+        return false;
+
+    tick_t start = GetCurrentClockTime();
+
+    stats_.bytes += size;
+    chunkSize_ = size;
+    xml_->addData(QByteArray((const char*)data, size));
+    bool success = Parse();
+    UpdateBytesHeld();
+
+    stats_.parseTime += (f64)(GetCurrentClockTime() - start) / GetCurrentClockFreq();
+    return success;
+}
+
+bool XmlRpcStreamReader::Finish()
+{
+    if (!error_.empty())
+        return false;
+
+    if (xml_->error() == QXmlStreamReader::PrematureEndOfDocumentError)
+        error_ = "XmlRpcStreamReader: the reply ended before it was complete";
+    else if (values_.empty() && containers_.empty())
+        error_ = "XmlRpcStreamReader: the reply did not contain any data";
+
+    return error_.empty();
+}
+
+bool XmlRpcStreamReader::HasValue(const std::string& name) const
+{
+    return values_.find(name) != values_.end() || containers_.find(name) != containers_.end();
+}
+
+const std::string* XmlRpcStreamReader::GetValue(const std::string& name) const
+{
+    std::map<std::string, std::string>::const_iterator i = values_.find(name);
+    if (i == values_.end())
+        return 0;
+    return &i->second;
+}
+
+// static
+const std::string* XmlRpcStreamReader::GetMember(const Members& element, const char* name)
+{
+    for(Members::const_iterator i = element.begin(); i != element.end(); ++i)
+        if (i->first == name)
+            return &i->second;
+    return 0;
+}
+
+bool XmlRpcStreamReader::Parse()
+{
+    // The depths of the values that are kept: the members of the reply struct are at depth 2, the elements of
+    // an array member at 3 and the members of a struct element at 4.
+    while(!xml_->atEnd())
+    {
+        switch(xml_->readNext())
+        {
+        case QXmlStreamReader::StartElement:
+        {
+            QStringRef name = xml_->name();
+            if (name == "value")
+            {
+                ++valueDepth_;
+                if (names_.size() < valueDepth_ + 2)
+                {
+                    names_.resize(valueDepth_ + 2);
+                    isContainer_.resize(valueDepth_ + 2);
+                }
+                isContainer_[valueDepth_] = false;
+                text_.clear();
+                typeEnded_ = false;
+                collectText_ = valueDepth_ == 2 || (valueDepth_ == 3 && handler_ && !inElement_) || (valueDepth_ == 4 && inElement_);
+            }
+            else if (name == "struct" || name == "array")
+            {
+                text_.clear();
+                collectText_ = false;
+                if (valueDepth_ > 0)
+                    isContainer_[valueDepth_] = true;
+
+                if (valueDepth_ == 2)
+                {
+                    containers_.insert(names_[2]);
+                    if (name == "array")
+                    {
+                        std::map<std::string, ArrayHandler>::const_iterator i = handlers_.find(names_[2]);
+                        handler_ = i != handlers_.end() ? &i->second : 0;
+                    }
+                }
+                else if (valueDepth_ == 3 && handler_ && !inElement_ && name == "struct")
+                {
+                    element_.clear();
+                    elementSize_ = 0;
+                    inElement_ = true;
+                }
+            }
+            else if (name == "name")
+            {
+                text_.clear();
+                collectText_ = valueDepth_ == 1 || (valueDepth_ == 3 && inElement_);
+            }
+            else if (valueDepth_ > 0 && !isContainer_[valueDepth_])
+            {
+                // Type element of a scalar, eg. <string> or <i4>
+                text_.clear();
+            }
+            break;
+        }
+
+        case QXmlStreamReader::Characters:
+            // Convert as xmlrpc-epi does, so that the values are the same as in a reply read by it
+            if (collectText_ && !typeEnded_)
+                text_ += xml_->text().toString().toStdString();
+            break;
+
+        case QXmlStreamReader::EndElement:
+        {
+            QStringRef name = xml_->name();
+            if (name == "value")
+            {
+                if (valueDepth_ > 0)
+                {
+                    if (!isContainer_[valueDepth_] && collectText_)
+                        AddScalar();
+                    --valueDepth_;
+                }
+                text_.clear();
+                collectText_ = false;
+                typeEnded_ = false;
+            }
+            else if (name == "name")
+            {
+                if (collectText_)
+                    names_[valueDepth_ + 1] = text_;
+                text_.clear();
+                collectText_ = false;
+            }
+            else if (name == "struct")
+            {
+                if (valueDepth_ == 3 && inElement_)
+                {
+                    UpdateBytesHeld();
+                    ++stats_.elements;
+                    (*handler_)(element_);
+                    element_.clear();
+                    elementSize_ = 0;
+                    inElement_ = false;
+                }
+            }
+            else if (name == "array")
+            {
+                if (valueDepth_ == 2)
+                    handler_ = 0;
+            }
+            else if (valueDepth_ > 0 && !isContainer_[valueDepth_] && name != "member" && name != "data")
+            {
+                // Type element of a scalar. Indented replies have whitespace after it, which is not part of the value.
+                typeEnded_ = true;
+            }
+            break;
+        }
+
+        default:
+            break;
+        }
+    }
+
+    if (xml_->hasError() && xml_->error() != QXmlStreamReader::PrematureEndOfDocumentError)
+    {
+        error_ = "XmlRpcStreamReader: the reply was not valid XML: " + xml_->errorString().toStdString() +
+            " at line " + ToString(xml_->lineNumber());
+        return false;
+    }
+
+    return true;
+}
+
+void XmlRpcStreamReader::AddScalar()
+{
+    if (valueDepth_ == 2)
+    {
+        const std::string &name = names_[2];
+        values_[name] = text_;
+        valuesSize_ += name.size() + text_.size();
+    }
+    else if (valueDepth_ == 3 && handler_ && !inElement_)
+    {
+        Members element(1, std::make_pair(std::string(), text_));
+        ++stats_.elements;
+        (*handler_)(element);
+    }
+    else if (valueDepth_ == 4 && inElement_)
+    {
+        element_.push_back(std::make_pair(names_[4], text_));
+        elementSize_ += names_[4].size() + text_.size();
+    }
+}
+
+void XmlRpcStreamReader::UpdateBytesHeld()
+{
+    uint held = chunkSize_ + valuesSize_ + elementSize_ + text_.size();
+    if (held > stats_.peakBytesHeld)
+        stats_.peakBytesHeld = held;
+}
@@ -0,0 +1,138 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+#ifndef incl_RpcUtilities_XmlRpcStreamReader_h
+#define incl_RpcUtilities_XmlRpcStreamReader_h
+
+#include "CoreTypes.h"
+
+#include <boost/function.hpp>
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+class QXmlStreamReader;
+
+	/**
+	 * Reads a XMLRPC reply incrementally, as its data arrives, instead of building the whole reply in memory.
+	 *
+	 * The reply is expected to be a struct, as replies to login calls are. Its scalar members are kept and can be
+	 * read with GetValue(). Arrays are not kept; instead, a handler can be set for an array member, which is given
+	 * the elements of the array one at a time as they are read. Struct elements are given as their scalar members,
+	 * scalar elements as one member with an empty name. Arrays that have no handler, and values nested deeper
+	 * than the members of array elements, are skipped.
+	 *
+	 * @code
+	 *  XmlRpcStreamReader reader;
+	 *  reader.SetArrayHandler("buddy-list", boost::bind(&MyParser::HandleBuddy, &parser, _1));
+	 *  call.SetStreamReader(&reader);
+	 *  call.Send();
+	 *  std::string agentId = call.GetReply<std::string>("agent_id");
+	 * @endcode
+	 */
+	class XmlRpcStreamReader
+	{
+	public:
+		/// Scalar members of a struct, by name, in the order they were read
+		typedef std::vector<std::pair<std::string, std::string> > Members;
+
+		/// Handler of array elements
+		typedef boost::function<void (const Members &element)> ArrayHandler;
+
+		/// Statistics of reading a reply
+		struct Stats
+		{
+			/// Bytes of the reply
+			uint bytes;
+			/// Array elements given to handlers
+			uint elements;
+			/// Most bytes held by the reader at once: the unparsed data, the kept values and the element being read
+			uint peakBytesHeld;
+			/// Time spent in parsing, in seconds
+			f64 parseTime;
+		};
+
+		XmlRpcStreamReader();
+		~XmlRpcStreamReader();
+
+		/// Sets a handler for the elements of an array member of the reply.
+		void SetArrayHandler(const std::string& name, const ArrayHandler& handler);
+
+		/// Clears the read values and statistics, for reading a new reply. The array handlers are kept.
+		void Reset();
+
+		/**
+		 * Parses the next piece of the reply.
+		 * @return false if the data is not a valid XMLRPC reply. The error is then in GetError().
+		 */
+		bool AddData(const u8 *data, uint size);
+
+		/**
+		 * Checks that the whole reply was read. Call after the last AddData().
+		 * @return false if the reply was incomplete or invalid.
+		 */
+		bool Finish();
+
+		/// Returns the error, or empty string if there was none
+		const std::string& GetError() const { return error_; }
+
+		/// Returns whether the reply contains a member of any type
+		bool HasValue(const std::string& name) const;
+
+		/// Returns a scalar member of the reply as text, or null if there is no such scalar member
+		const std::string* GetValue(const std::string& name) const;
+
+		/// Returns a member of an array element by name, or null if there is no such member
+		static const std::string* GetMember(const Members& element, const char* name);
+
+		/// Returns the statistics of reading the reply
+		const Stats& GetStats() const { return stats_; }
+
+	private:
+		/// Handles the parsed XML up to the end of the data added so far
+		bool Parse();
+
+		/// Adds a scalar value that has been read
+		void AddScalar();
+
+		/// Updates the peak of bytes held
+		void UpdateBytesHeld();
+
+		QXmlStreamReader* xml_;
+		std::map<std::string, ArrayHandler> handlers_;
+
+		/// Scalar members of the reply
+		std::map<std::string, std::string> values_;
+		/// Array and struct members of the reply
+		std::set<std::string> containers_;
+		uint valuesSize_;
+
+		/// Member names by value depth
+		std::vector<std::string> names_;
+		/// Whether the value at each depth is an array or struct
+		std::vector<bool> isContainer_;
+		/// Number of <value> elements the parser is in
+		uint valueDepth_;
+
+		/// Text of the scalar or name being read
+		std::string text_;
+		bool collectText_;
+		/// Whether the type element of the scalar being read has ended, so that the text after it is whitespace
+		bool typeEnded_;
+
+		/// Handler of the array being read, or null
+		const ArrayHandler* handler_;
+		/// Element being read, if it is a struct
+		Members element_;
+		uint elementSize_;
+		bool inElement_;
+
+		/// Size of the piece of data being parsed
+		uint chunkSize_;
+
+		Stats stats_;
+		std::string error_;
+	};
+
+#endif
@@ -0,0 +1,108 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+
+#include "StableHeaders.h"
+#include "DebugOperatorNew.h"
+
+#include "AssetReferenceIndex.h"
+
+#include <algorithm>
+
+#include "MemoryLeakCheck.h"
+
+namespace Scene
+{
+    const AssetReferenceIndex::ReferenceVector AssetReferenceIndex::empty_;
+
+    void AssetReferenceIndex::AddReference(const std::string &asset_id, entity_id_t entity, const IComponent *component, uint slot, int type)
+    {
+        if (asset_id.empty())
+            return;
+
+        Reference ref;
+        ref.entity = entity;
+        ref.component = component;
+        ref.slot = slot;
+        ref.type = type;
+        references_[asset_id].push_back(ref);
+
+        // Remember each asset only once per component; a prim often uses the same texture on several faces.
+        std::vector<std::string> &assets = owners_[std::make_pair(entity, component)];
+        if (std::find(assets.begin(), assets.end(), asset_id) == assets.end())
+            assets.push_back(asset_id);
+    }
+
+    void AssetReferenceIndex::ClearReferences(entity_id_t entity, const IComponent *component)
+    {
+        OwnerMap::iterator owner = owners_.find(std::make_pair(entity, component));
+        if (owner == owners_.end())
+            return;
+
+        const std::vector<std::string> &assets = owner->second;
+        for(size_t i = 0; i < assets.size(); ++i)
+            RemoveFromAsset(assets[i], component);
+        owners_.erase(owner);
+    }
+
+    void AssetReferenceIndex::RemoveEntity(entity_id_t entity)
+    {
+        OwnerMap::iterator begin = owners_.lower_bound(std::make_pair(entity, (const IComponent *)0));
+        OwnerMap::iterator end = begin;
+        while(end != owners_.end() && end->first.first == entity)
+        {
+            const std::vector<std::string> &assets = end->second;
+            for(size_t i = 0; i < assets.size(); ++i)
+                RemoveFromAsset(assets[i], end->first.second);
+            ++end;
+        }
+        owners_.erase(begin, end);
+    }
+
+    void AssetReferenceIndex::Clear()
+    {
+        references_.clear();
+        owners_.clear();
+    }
+
+    const AssetReferenceIndex::ReferenceVector &AssetReferenceIndex::GetReferences(const std::string &asset_id) const
+    {
+        ReferenceMap::const_iterator it = references_.find(asset_id);
+        return it != references_.end() ? it->second : empty_;
+    }
+
+    void AssetReferenceIndex::GetReferences(const std::string &asset_id, entity_id_t entity, ReferenceVector &result) const
+    {
+        const ReferenceVector &refs = GetReferences(asset_id);
+        for(size_t i = 0; i < refs.size(); ++i)
+            if (refs[i].entity == entity)
+                result.push_back(refs[i]);
+    }
+
+    bool AssetReferenceIndex::HasReferences(const std::string &asset_id) const
+    {
+        return references_.find(asset_id) != references_.end();
+    }
+
+    void AssetReferenceIndex::RemoveFromAsset(const std::string &asset_id, const IComponent *component)
+    {
+        ReferenceMap::iterator it = references_.find(asset_id);
+        if (it == references_.end())
+            return;
+
+        // Order of the references does not matter, so swap the removed ones to the end.
+        ReferenceVector &refs = it->second;
+        size_t i = 0;
+        while(i < refs.size())
+        {
+            if (refs[i].component == component)
+            {
+                refs[i] = refs.back();
+                refs.pop_back();
+            }
+            else
+                ++i;
+        }
+
+        if (refs.empty())
+            references_.erase(it);
+    }
+}
@@ -0,0 +1,102 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+
+#ifndef incl_SceneManager_AssetReferenceIndex_h
+#define incl_SceneManager_AssetReferenceIndex_h
+
+#include "CoreTypes.h"
+
+#include <boost/unordered_map.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+
+class IComponent;
+
+namespace Scene
+{
+    //! Reverse index from asset ids to the entities and submeshes that use them.
+    /*! Every SceneManager owns one asset reference index. Components that refer to assets (f.ex. EC_OpenSimPrim
+        materials and texture entries, EC_Mesh mesh and material refs) register their references here whenever
+        they change, so that the consumers of an asset can be found without iterating the whole scene when the
+        asset arrives.
+
+        A component always replaces all of its references at once with ClearReferences() followed by
+        AddReference() calls. The references of a component are removed when the component or its entity is
+        removed from the scene.
+
+        \ingroup Scene_group
+    */
+    class AssetReferenceIndex
+    {
+    public:
+        //! Slot value for references that apply to all submeshes, f.ex. the default texture of a prim.
+        static const uint ALL_SLOTS = 0xffffffff;
+
+        //! A single use of an asset.
+        struct Reference
+        {
+            //! Entity that uses the asset.
+            entity_id_t entity;
+            //! Component that registered the reference.
+            const IComponent *component;
+            //! Submesh or face index the asset is used in, or ALL_SLOTS.
+            uint slot;
+            //! Asset type the asset is used as (RexTypes asset type).
+            int type;
+        };
+
+        typedef std::vector<Reference> ReferenceVector;
+
+        //! Adds a reference to an asset. Empty asset ids are ignored.
+        void AddReference(const std::string &asset_id, entity_id_t entity, const IComponent *component, uint slot, int type);
+
+        //! Removes all references registered by a component.
+        void ClearReferences(entity_id_t entity, const IComponent *component);
+
+        //! Removes all references of an entity.
+        void RemoveEntity(entity_id_t entity);
+
+        //! Removes all references.
+        void Clear();
+
+        //! Returns all uses of an asset. The vector is empty if the asset is not used.
+        /*! The returned reference is invalidated by any modification of the index.
+         */
+        const ReferenceVector &GetReferences(const std::string &asset_id) const;
+
+        //! Returns uses of an asset by one entity.
+        /*! Found references are appended to result.
+         */
+        void GetReferences(const std::string &asset_id, entity_id_t entity, ReferenceVector &result) const;
+
+        //! Returns true if any entity uses an asset.
+        bool HasReferences(const std::string &asset_id) const;
+
+        //! Returns number of distinct assets in the index.
+        size_t Size() const { return references_.size(); }
+
+    private:
+        typedef boost::unordered_map<std::string, ReferenceVector> ReferenceMap;
+
+        //! Key of the references registered by one component. Ordered by entity first, so RemoveEntity() is a range erase.
+        typedef std::pair<entity_id_t, const IComponent *> OwnerKey;
+
+        //! Asset ids referenced by each component, so references can be removed without searching the whole index.
+        typedef std::map<OwnerKey, std::vector<std::string> > OwnerMap;
+
+        //! Removes the references of one component to one asset.
+        void RemoveFromAsset(const std::string &asset_id, const IComponent *component);
+
+        //! Uses of each asset.
+        ReferenceMap references_;
+
+        //! Referenced assets by component.
+        OwnerMap owners_;
+
+        //! Returned for assets that are not in the index.
+        static const ReferenceVector empty_;
+    };
+}
+
+#endif
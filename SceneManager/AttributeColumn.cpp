@@ -0,0 +1,93 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+
+#include "StableHeaders.h"
+#include "DebugOperatorNew.h"
+
+#include "AttributeColumn.h"
+#include "IAttribute.h"
+#include "Vector3D.h"
+#include "Quaternion.h"
+#include "Color.h"
+#include "Transform.h"
+
+#include <cmath>
+
+#include "MemoryLeakCheck.h"
+
+namespace Scene
+{
+namespace AttributeColumn
+{
+    uint GetStride(const IAttribute *attribute)
+    {
+        if (dynamic_cast<const Attribute<float> *>(attribute) || dynamic_cast<const Attribute<int> *>(attribute) ||
+            dynamic_cast<const Attribute<uint> *>(attribute) || dynamic_cast<const Attribute<bool> *>(attribute))
+            return 1;
+        if (dynamic_cast<const Attribute<Vector3df> *>(attribute))
+            return 3;
+        if (dynamic_cast<const Attribute<Quaternion> *>(attribute) || dynamic_cast<const Attribute<Color> *>(attribute))
+            return 4;
+        if (dynamic_cast<const Attribute<Transform> *>(attribute))
+            return 9;
+        return 0;
+    }
+
+    bool Read(const IAttribute *attribute, float *out)
+    {
+        // Transform and float are by far the most common column types, so they are tested first.
+        if (const Attribute<Transform> *t = dynamic_cast<const Attribute<Transform> *>(attribute))
+        {
+            const Transform &tr = t->Get();
+            out[0] = tr.position.x; out[1] = tr.position.y; out[2] = tr.position.z;
+            out[3] = tr.rotation.x; out[4] = tr.rotation.y; out[5] = tr.rotation.z;
+            out[6] = tr.scale.x; out[7] = tr.scale.y; out[8] = tr.scale.z;
+        }
+        else if (const Attribute<float> *f = dynamic_cast<const Attribute<float> *>(attribute))
+            out[0] = f->Get();
+        else if (const Attribute<Vector3df> *v = dynamic_cast<const Attribute<Vector3df> *>(attribute))
+        {
+            out[0] = v->Get().x; out[1] = v->Get().y; out[2] = v->Get().z;
+        }
+        else if (const Attribute<Quaternion> *q = dynamic_cast<const Attribute<Quaternion> *>(attribute))
+        {
+            out[0] = q->Get().x; out[1] = q->Get().y; out[2] = q->Get().z; out[3] = q->Get().w;
+        }
+        else if (const Attribute<Color> *c = dynamic_cast<const Attribute<Color> *>(attribute))
+        {
+            out[0] = c->Get().r; out[1] = c->Get().g; out[2] = c->Get().b; out[3] = c->Get().a;
+        }
+        else if (const Attribute<int> *i = dynamic_cast<const Attribute<int> *>(attribute))
+            out[0] = (float)i->Get();
+        else if (const Attribute<uint> *u = dynamic_cast<const Attribute<uint> *>(attribute))
+            out[0] = (float)u->Get();
+        else if (const Attribute<bool> *b = dynamic_cast<const Attribute<bool> *>(attribute))
+            out[0] = b->Get() ? 1.f : 0.f;
+        else
+            return false;
+        return true;
+    }
+
+    bool Write(IAttribute *attribute, const float *in, AttributeChange::Type change)
+    {
+        if (Attribute<Transform> *t = dynamic_cast<Attribute<Transform> *>(attribute))
+            t->Set(Transform(Vector3df(in[0], in[1], in[2]), Vector3df(in[3], in[4], in[5]), Vector3df(in[6], in[7], in[8])), change);
+        else if (Attribute<float> *f = dynamic_cast<Attribute<float> *>(attribute))
+            f->Set(in[0], change);
+        else if (Attribute<Vector3df> *v = dynamic_cast<Attribute<Vector3df> *>(attribute))
+            v->Set(Vector3df(in[0], in[1], in[2]), change);
+        else if (Attribute<Quaternion> *q = dynamic_cast<Attribute<Quaternion> *>(attribute))
+            q->Set(Quaternion(in[0], in[1], in[2], in[3]), change);
+        else if (Attribute<Color> *c = dynamic_cast<Attribute<Color> *>(attribute))
+            c->Set(Color(in[0], in[1], in[2], in[3]), change);
+        else if (Attribute<int> *i = dynamic_cast<Attribute<int> *>(attribute))
+            i->Set((int)floor(in[0] + 0.5f), change);
+        else if (Attribute<uint> *u = dynamic_cast<Attribute<uint> *>(attribute))
+            u->Set(in[0] > 0.f ? (uint)(in[0] + 0.5f) : 0, change);
+        else if (Attribute<bool> *b = dynamic_cast<Attribute<bool> *>(attribute))
+            b->Set(in[0] != 0.f, change);
+        else
+            return false;
+        return true;
+    }
+}
+}
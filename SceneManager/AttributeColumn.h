@@ -0,0 +1,46 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+
+#ifndef incl_SceneManager_AttributeColumn_h
+#define incl_SceneManager_AttributeColumn_h
+
+#include "CoreTypes.h"
+#include "AttributeChangeType.h"
+
+class IAttribute;
+
+namespace Scene
+{
+    //! Conversion of numeric attribute values to and from flat float arrays.
+    /*! Used by SceneManager::ReadAttributeColumn and WriteAttributeColumn, which read or write one attribute of many
+        entities at once. Each value takes GetStride() consecutive floats:
+        - bool, int, uint, float: the value
+        - Vector3df: x, y, z
+        - Quaternion: x, y, z, w
+        - Color: r, g, b, a
+        - Transform: position x, y, z, rotation x, y, z, scale x, y, z
+
+        Other attribute types have no column layout.
+
+        \ingroup Scene_group
+    */
+    namespace AttributeColumn
+    {
+        //! Largest stride of any attribute type.
+        const uint MaxStride = 9;
+
+        //! Returns the number of floats per value of the attribute, or 0 if the attribute type is not numeric.
+        uint GetStride(const IAttribute *attribute);
+
+        //! Writes the value of the attribute to GetStride() floats starting at out.
+        /*! \return False if the attribute type is not numeric.
+         */
+        bool Read(const IAttribute *attribute, float *out);
+
+        //! Sets the value of the attribute from GetStride() floats starting at in.
+        /*! \return False if the attribute type is not numeric.
+         */
+        bool Write(IAttribute *attribute, const float *in, AttributeChange::Type change);
+    }
+}
+
+#endif
@@ -14,6 +14,7 @@
 #include "CoreStdIncludes.h"
 #include "Transform.h"
 #include "AssetReference.h"
+#include "CoreNumberFormat.h"
 
 #include <QVariant>
 #include <QStringList>
@@ -55,46 +56,44 @@ template<> std::string Attribute<bool>::ToString() const
 
 template<> std::string Attribute<int>::ToString() const
 {
-    return ::ToString<int>(Get());
+    char buffer[MAX_NUMBER_STRING_LENGTH];
+    return std::string(buffer, FormatInt(Get(), buffer));
 }
 
 template<> std::string Attribute<uint>::ToString() const
 {
-    return ::ToString<uint>(Get());
+    char buffer[MAX_NUMBER_STRING_LENGTH];
+    return std::string(buffer, FormatUInt(Get(), buffer));
 }
 
 template<> std::string Attribute<float>::ToString() const
 {
-    return ::ToString<float>(Get());
+    char buffer[MAX_NUMBER_STRING_LENGTH];
+    return std::string(buffer, FormatFloat(Get(), buffer));
 }
 
 template<> std::string Attribute<Vector3df>::ToString() const
 {
     Vector3df value = Get();
-    
-    return ::ToString<float>(value.x) + " " +
-        ::ToString<float>(value.y) + " " +
-        ::ToString<float>(value.z);
+    const float values[3] = { value.x, value.y, value.z };
+    char buffer[3 * MAX_NUMBER_STRING_LENGTH];
+    return std::string(buffer, FormatFloatList(values, 3, ' ', buffer));
 }
     
 template<> std::string Attribute<Quaternion>::ToString() const
 {
     Quaternion value = Get();
-    
-    return ::ToString<float>(value.w) + " " +
-        ::ToString<float>(value.x) + " " +
-        ::ToString<float>(value.y) + " " +
-        ::ToString<float>(value.z);
+    const float values[4] = { value.w, value.x, value.y, value.z };
+    char buffer[4 * MAX_NUMBER_STRING_LENGTH];
+    return std::string(buffer, FormatFloatList(values, 4, ' ', buffer));
 }
 
 template<> std::string Attribute<Color>::ToString() const
 {
     Color value = Get();
-    
-    return ::ToString<float>(value.r) + " " +
-        ::ToString<float>(value.g) + " " +
-        ::ToString<float>(value.b) + " " +
-        ::ToString<float>(value.a);
+    const float values[4] = { value.r, value.g, value.b, value.a };
+    char buffer[4 * MAX_NUMBER_STRING_LENGTH];
+    return std::string(buffer, FormatFloatList(values, 4, ' ', buffer));
 }
 
 template<> std::string Attribute<AssetReference>::ToString() const
@@ -125,24 +124,13 @@ template<> std::string Attribute<QVariantList >::ToString() const
 
 template<> std::string Attribute<Transform>::ToString() const
 {
-    QString value("");
     Transform transform = Get();
-    Vector3df editValues[3];
-    editValues[0] = transform.position;
-    editValues[1] = transform.rotation;
-    editValues[2] = transform.scale;
-
-    for(uint i = 0; i < 3; i++)
-    {
-        value += QString::number(editValues[i].x);
-        value += ",";
-        value += QString::number(editValues[i].y);
-        value += ",";
-        value += QString::number(editValues[i].z);
-        if(i < 2)
-            value += ",";
-    }
-    return value.toStdString();
+    const float values[9] = {
+        transform.position.x, transform.position.y, transform.position.z,
+        transform.rotation.x, transform.rotation.y, transform.rotation.z,
+        transform.scale.x, transform.scale.y, transform.scale.z };
+    char buffer[9 * MAX_NUMBER_STRING_LENGTH];
+    return std::string(buffer, FormatFloatList(values, 9, ',', buffer));
 }
 
 // TYPENAMETOSTRING TEMPLATE IMPLEMENTATIONS.
@@ -226,95 +214,54 @@ template<> void Attribute<bool>::FromString(const std::string& str, AttributeCha
 
 template<> void Attribute<int>::FromString(const std::string& str, AttributeChange::Type change)
 {
-    try
-    {
-        int value = ParseString<int>(str);
+    int value;
+    if (ParseIntString(str.data(), str.data() + str.size(), value))
         Set(value, change);
-    }
-    catch (...) {}
 }
 
 template<> void Attribute<uint>::FromString(const std::string& str, AttributeChange::Type change)
 {
-    try
-    {
-        uint value = ParseString<uint>(str);
+    uint value;
+    if (ParseUIntString(str.data(), str.data() + str.size(), value))
         Set(value, change);
-    }
-    catch (...) {}
 }
 
 template<> void Attribute<float>::FromString(const std::string& str, AttributeChange::Type change)
 {
-    try
-    {
-        float value = ParseString<float>(str);
+    float value;
+    if (ParseFloatString(str.data(), str.data() + str.size(), value))
         Set(value, change);
-    }
-    catch (...) {}
 }
 
 template<> void Attribute<Vector3df>::FromString(const std::string& str, AttributeChange::Type change)
 {
-    StringVector components = SplitString(str, ' ');
-    if (components.size() == 3)
-    {
-        try
-        {
-            Vector3df value;
-            value.x = ParseString<float>(components[0]);
-            value.y = ParseString<float>(components[1]);
-            value.z = ParseString<float>(components[2]);
-            Set(value, change);
-        }
-        catch (...) {}
-    }
+    float values[3];
+    if (ParseFloatList(str.data(), str.data() + str.size(), ' ', values, 3) == 3)
+        Set(Vector3df(values[0], values[1], values[2]), change);
 }
 
 template<> void Attribute<Color>::FromString(const std::string& str, AttributeChange::Type change)
 {
-    Color value;
-    StringVector components = SplitString(str, ' ');
-    if (components.size() == 3)
-    {
-        try
-        {
-            value.r = ParseString<float>(components[0]);
-            value.g = ParseString<float>(components[1]);
-            value.b = ParseString<float>(components[2]);
-            Set(value, change);
-        }
-        catch (...) {}
-    }
-    if (components.size() == 4)
-    {
-        try
-        {
-            value.r = ParseString<float>(components[0]);
-            value.g = ParseString<float>(components[1]);
-            value.b = ParseString<float>(components[2]);
-            value.a = ParseString<float>(components[3]);
-            Set(value, change);
-        }
-        catch (...) {}
-    }
+    // Alpha is optional.
+    float values[4];
+    int count = ParseFloatList(str.data(), str.data() + str.size(), ' ', values, 4);
+    if (count == 3)
+        Set(Color(values[0], values[1], values[2]), change);
+    else if (count == 4)
+        Set(Color(values[0], values[1], values[2], values[3]), change);
 }
 
 template<> void Attribute<Quaternion>::FromString(const std::string& str, AttributeChange::Type change)
 {
-    StringVector components = SplitString(str, ' ');
-    if (components.size() == 4)
+    float values[4];
+    if (ParseFloatList(str.data(), str.data() + str.size(), ' ', values, 4) == 4)
     {
-        try
-        {
-            Quaternion value;
-            value.w = ParseString<float>(components[0]);
-            value.x = ParseString<float>(components[1]);
-            value.y = ParseString<float>(components[2]);
-            value.z = ParseString<float>(components[3]);
-            Set(value, change);
-        }
-        catch (...) {}
+        Quaternion value;
+        value.w = values[0];
+        value.x = values[1];
+        value.y = values[2];
+        value.z = values[3];
+        Set(value, change);
     }
 }
 
@@ -352,18 +299,10 @@ template<> void Attribute<QVariantList >::FromString(const std::string& str, Att
 
 template<> void Attribute<Transform>::FromString(const std::string& str, AttributeChange::Type change)
 {
-    QString value = QString::fromStdString(str);
-    QStringList matrixElements = value.split(',');
     Transform result;
-    if(matrixElements.size() == 9) //Ensure that we a have right amount of elements.
+    float values[9];
+    if (ParseFloatList(str.data(), str.data() + str.size(), ',', values, 9) == 9) //Ensure that we a have right amount of elements.
     {
-        float values[9];
-        for(uint i = 0; i < 3; i++)
-        {
-            uint startIndex = 3 * i;
-            for(uint j = 0; j < 3; j++)
-                values[j + startIndex] = ParseString<float>(matrixElements[j + startIndex].toStdString(), 0.0f);
-        }
         result.SetPos(values[0], values[1], values[2]);
         result.SetRot(values[3], values[4], values[5]);
         result.SetScale(values[6], values[7], values[8]);
@@ -16,6 +16,8 @@
 
 #include <QDomDocument>
 
+#include <algorithm>
+
 IComponent::IComponent(Foundation::Framework* framework) :
     parent_entity_(0),
     framework_(framework),
@@ -174,23 +176,84 @@ QString IComponent::ReadAttributeType(QDomElement& comp_element, const QString &
 
 void IComponent::AttributeChanged(IAttribute* attribute, AttributeChange::Type change)
 {
+    // Resolve Default before the change is coalesced, so that it is merged and delivered as the change it stands for.
     if (change == AttributeChange::Default)
-        change = updatemode_;
+        change = GetUpdateMode();
     if (change == AttributeChange::Disconnected)
         return; // No signals
     
-    // Trigger scenemanager signal
-    if (parent_entity_)
+    Scene::SceneManager* scene = parent_entity_ ? parent_entity_->GetScene() : 0;
+    if (scene && scene->IsAttributeChangeBatching())
     {
-        Scene::SceneManager* scene = parent_entity_->GetScene();
-        if (scene)
-            scene->EmitAttributeChanged(this, attribute, change);
+        // Coalesce repeated changes of the same attribute. Replicate wins over LocalOnly.
+        for(size_t i = 0; i < pending_changes_.size(); ++i)
+            if (pending_changes_[i].first == attribute)
+            {
+                if (change == AttributeChange::Replicate)
+                    pending_changes_[i].second = AttributeChange::Replicate;
+                return;
+            }
+        if (pending_changes_.empty())
+            scene->MarkComponentDirty(this);
+        pending_changes_.push_back(std::make_pair(attribute, change));
+        return;
     }
     
+    // Trigger scenemanager signal
+    if (scene)
+        scene->EmitAttributeChanged(this, attribute, change);
+    
     // Trigger internal signal
     emit OnAttributeChanged(attribute, change);
 }
 
+void IComponent::FlushAttributeChanges()
+{
+    if (pending_changes_.empty())
+        return;
+
+    std::vector<std::pair<IAttribute*, AttributeChange::Type> > changes;
+    changes.swap(pending_changes_);
+
+    Scene::SceneManager* scene = parent_entity_ ? parent_entity_->GetScene() : 0;
+    AttributeVector localChanges;
+    AttributeVector replicatedChanges;
+    for(size_t i = 0; i < changes.size(); ++i)
+    {
+        IAttribute *attribute = changes[i].first;
+        // Dynamic attributes may have been removed after they were changed.
+        if (std::find(attributes_.begin(), attributes_.end(), attribute) == attributes_.end())
+            continue;
+
+        AttributeChange::Type change = changes[i].second;
+        if (change == AttributeChange::Default)
+            change = GetUpdateMode();
+
+        if (scene)
+            scene->EmitAttributeChanged(this, attribute, change);
+        emit OnAttributeChanged(attribute, change);
+
+        if (change == AttributeChange::Replicate)
+            replicatedChanges.push_back(attribute);
+        else
+            localChanges.push_back(attribute);
+    }
+
+    EmitAttributesChanged(localChanges, AttributeChange::LocalOnly);
+    EmitAttributesChanged(replicatedChanges, AttributeChange::Replicate);
+}
+
+void IComponent::EmitAttributesChanged(const AttributeVector &attributes, AttributeChange::Type change)
+{
+    if (attributes.empty())
+        return;
+
+    Scene::SceneManager* scene = parent_entity_ ? parent_entity_->GetScene() : 0;
+    if (scene)
+        scene->EmitComponentAttributesChanged(this, attributes, change);
+    emit OnAttributesChanged(attributes, change);
+}
+
 void IComponent::AttributeChanged(const QString& attributeName, AttributeChange::Type change)
 {
     if (change == AttributeChange::Disconnected)
@@ -247,6 +310,12 @@ void IComponent::SetTemporary(bool enable)
     temporary_ = enable;
 }
 
+bool IComponent::IsAttributeChangeBatched() const
+{
+    Scene::SceneManager* scene = parent_entity_ ? parent_entity_->GetScene() : 0;
+    return scene && scene->IsAttributeChangeBatching();
+}
+
 bool IComponent::IsTemporary() const
 {
     if ((parent_entity_) && (parent_entity_->IsTemporary()))
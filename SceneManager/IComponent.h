@@ -118,7 +118,9 @@ public slots:
     /// @param change Informs to the component the type of change that occurred.
     ///
     /// This function calls Scene::EmitAttributeChanged and triggers the 
-    /// OnAttributeChanged signal of this component.
+    /// OnAttributeChanged signal of this component. If the parent scene is batching
+    /// attribute changes, the attribute is only marked dirty, and the signals are emitted
+    /// when the scene flushes the changes.
     /// 
     /// This function is called by IAttribute::Changed whenever the value in that
     /// attribute is changed.
@@ -144,6 +146,17 @@ public slots:
     /// Do not rely on it.
     void ComponentChanged(AttributeChange::Type change);
 
+    /// Delivers the attribute changes that were coalesced while the parent scene was batching changes.
+    /// Called by SceneManager::FlushAttributeChanges, there is usually no need to call this directly.
+    void FlushAttributeChanges();
+
+    /// Returns true if the attribute changes of this component are delivered in batches, ie. the parent scene is batching.
+    /// Listeners of both OnAttributeChanged and OnAttributesChanged can ignore OnAttributeChanged when this is true.
+    bool IsAttributeChangeBatched() const;
+
+    /// Returns true if this component has attribute changes that have not yet been delivered.
+    bool HasPendingAttributeChanges() const { return !pending_changes_.empty(); }
+
     /// Returns the Entity this Component is part of.
     /// \note Calling this function will return null if it is called in the ctor of this Component. This is
     ///       because the parent entity has not yet been set with a call to SetParentEntity at that point.
@@ -215,6 +228,11 @@ signals:
     /// This signal is emitted when an Attribute of this Component has changed. 
     void OnAttributeChanged(IAttribute* attribute, AttributeChange::Type change);
 
+    /// This signal is emitted when one or more Attributes of this Component have changed.
+    /// Emitted only when the scene batches attribute changes, once per flush and change type with all
+    /// the attributes that changed. Unbatched changes are signalled by OnAttributeChanged alone.
+    void OnAttributesChanged(const AttributeVector &attributes, AttributeChange::Type change);
+
     ///\todo In the future, provide a method of listening to a change of specific Attribute, instead of having to
     /// always connect to the above function and if(...)'ing if it was the change we were interested in.
 
@@ -274,6 +292,12 @@ protected:
 private:
     /// Called by IAttribute on initialization of each attribute
     void AddAttribute(IAttribute* attr) { attributes_.push_back(attr); }
+
+    /// Emits the batched change signals of this component and the parent scene.
+    void EmitAttributesChanged(const AttributeVector &attributes, AttributeChange::Type change);
+
+    /// Attributes changed while the parent scene was batching changes, with the strongest change type of each.
+    std::vector<std::pair<IAttribute*, AttributeChange::Type> > pending_changes_;
     
 };
 
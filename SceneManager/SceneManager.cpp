@@ -12,25 +12,58 @@
 #include "IComponent.h"
 #include "ForwardDefines.h"
 #include "EC_Name.h"
+#include "ConfigurationManager.h"
+#include "AttributeColumn.h"
 
 #include <QString>
 #include <QDomDocument>
 #include <QFile>
 
+#include <limits>
+#include <typeinfo>
+
 #include "MemoryLeakCheck.h"
 
+namespace
+{
+    //! Converts entity ids passed by scripts.
+    void ToIdVector(const QVariantList &list, std::vector<entity_id_t> &ids)
+    {
+        ids.reserve(list.size());
+        for(int i = 0; i < list.size(); ++i)
+            ids.push_back((entity_id_t)list[i].toUInt());
+    }
+
+    //! Converts change type passed by scripts as a number.
+    AttributeChange::Type ToChangeType(int change)
+    {
+        if (change < AttributeChange::Default || change > AttributeChange::Replicate)
+            return AttributeChange::Default;
+        return static_cast<AttributeChange::Type>(change);
+    }
+}
+
 namespace Scene
 {
     uint SceneManager::gid_ = 0;
 
-    SceneManager::SceneManager() : framework_(0)
+    SceneManager::SceneManager() :
+        framework_(0),
+        batch_attribute_changes_(false)
     {
     }
 
     SceneManager::SceneManager(const QString &name, Foundation::Framework *framework) :
         name_(name),
-        framework_(framework)
+        framework_(framework),
+        batch_attribute_changes_(false)
     {
+        if (framework_)
+        {
+            spatial_index_.SetCellSize(framework_->GetDefaultConfig().DeclareSetting("SceneManager", "spatial_index_cell_size", 16.f));
+            // The framework flushes the changes once per frame
+            batch_attribute_changes_ = framework_->GetDefaultConfig().DeclareSetting("SceneManager", "batch_attribute_changes", true);
+        }
     }
 
     SceneManager::~SceneManager()
@@ -127,6 +160,8 @@ namespace Scene
             event_category_id_t cat_id = framework_->GetEventManager()->QueryEventCategory("Scene");
             framework_->GetEventManager()->SendEvent(cat_id, Events::EVENT_ENTITY_DELETED, &event_data);
             
+            spatial_index_.Remove(id);
+            asset_reference_index_.RemoveEntity(id);
             entities_.erase(it);
             // If entity somehow manages to live, at least it doesn't belong to the scene anymore
             del_entity->SetScene(0);
@@ -153,6 +188,8 @@ namespace Scene
             ++it;
         }
         entities_.clear();
+        spatial_index_.Clear();
+        asset_reference_index_.Clear();
         emit SceneCleared();
     }
     
@@ -182,6 +219,10 @@ namespace Scene
     
     void SceneManager::EmitComponentRemoved(Scene::Entity* entity, IComponent* comp, AttributeChange::Type change)
     {
+        // Drop the entity's position if the component being removed provided it, and the assets it used.
+        spatial_index_.RemoveOwnedBy(entity->GetId(), comp);
+        asset_reference_index_.ClearReferences(entity->GetId(), comp);
+
         if (change == AttributeChange::Disconnected)
             return;
         if (change == AttributeChange::Default)
@@ -198,6 +239,45 @@ namespace Scene
         emit AttributeChanged(comp, attribute, change);
     }
 
+    void SceneManager::EmitComponentAttributesChanged(IComponent* comp, const AttributeVector &attributes, AttributeChange::Type change)
+    {
+        if (change == AttributeChange::Disconnected || attributes.empty())
+            return;
+        if (change == AttributeChange::Default)
+            change = comp->GetUpdateMode();
+        emit ComponentAttributesChanged(comp, attributes, change);
+    }
+
+    void SceneManager::MarkComponentDirty(IComponent* comp)
+    {
+        if (comp)
+            dirty_components_.push_back(QPointer<IComponent>(comp));
+    }
+
+    void SceneManager::SetAttributeChangeBatching(bool enable)
+    {
+        if (batch_attribute_changes_ == enable)
+            return;
+        // Flush while still batching, so that listeners that skip AttributeChanged while batching get the changes
+        // from ComponentAttributesChanged
+        if (!enable)
+            FlushAttributeChanges();
+        batch_attribute_changes_ = enable;
+    }
+
+    void SceneManager::FlushAttributeChanges()
+    {
+        if (dirty_components_.empty())
+            return;
+
+        // Handlers may change attributes again; those changes are marked dirty anew and delivered on the next flush.
+        std::vector<QPointer<IComponent> > dirty;
+        dirty.swap(dirty_components_);
+        for(size_t i = 0; i < dirty.size(); ++i)
+            if (!dirty[i].isNull())
+                dirty[i]->FlushAttributeChanges();
+    }
+
   /*void SceneManager::EmitComponentInitialized(IComponent* comp)
     {
         emit ComponentInitialized(comp);
@@ -240,6 +320,206 @@ namespace Scene
         return ret;
     }
 
+    QList<Scene::Entity*> SceneManager::ToEntityList(const std::vector<entity_id_t> &ids) const
+    {
+        QList<Scene::Entity*> ret;
+        for(size_t i = 0; i < ids.size(); ++i)
+        {
+            EntityMap::const_iterator it = entities_.find(ids[i]);
+            if (it != entities_.end())
+                ret.append(it->second.get());
+        }
+
+        return ret;
+    }
+
+    QList<Scene::Entity*> SceneManager::GetEntitiesInRadius(const QVector3D &center, float radius) const
+    {
+        std::vector<entity_id_t> ids;
+        spatial_index_.QueryRadius(Vector3df(center.x(), center.y(), center.z()), radius, ids);
+        return ToEntityList(ids);
+    }
+
+    QList<Scene::Entity*> SceneManager::GetEntitiesInBox(const QVector3D &min, const QVector3D &max) const
+    {
+        std::vector<entity_id_t> ids;
+        spatial_index_.QueryBox(Vector3df(min.x(), min.y(), min.z()), Vector3df(max.x(), max.y(), max.z()), ids);
+        return ToEntityList(ids);
+    }
+
+    QList<Scene::Entity*> SceneManager::GetNearestEntities(const QVector3D &center, int count) const
+    {
+        std::vector<entity_id_t> ids;
+        if (count > 0)
+            spatial_index_.QueryNearest(Vector3df(center.x(), center.y(), center.z()), count, ids);
+        return ToEntityList(ids);
+    }
+
+    QVariantList SceneManager::GetEntityIdsInRadius(const QVector3D &center, float radius) const
+    {
+        std::vector<entity_id_t> ids;
+        spatial_index_.QueryRadius(Vector3df(center.x(), center.y(), center.z()), radius, ids);
+
+        QVariantList ret;
+        ret.reserve(ids.size());
+        for(size_t i = 0; i < ids.size(); ++i)
+            ret.append(QVariant(ids[i]));
+        return ret;
+    }
+
+    QVariantList SceneManager::GetEntityIdsInBox(const QVector3D &min, const QVector3D &max) const
+    {
+        std::vector<entity_id_t> ids;
+        spatial_index_.QueryBox(Vector3df(min.x(), min.y(), min.z()), Vector3df(max.x(), max.y(), max.z()), ids);
+
+        QVariantList ret;
+        ret.reserve(ids.size());
+        for(size_t i = 0; i < ids.size(); ++i)
+            ret.append(QVariant(ids[i]));
+        return ret;
+    }
+
+    QVariantList SceneManager::GetAttributeColumn(const QVariantList &ids, const QString &type_name, const QString &attribute_name) const
+    {
+        std::vector<entity_id_t> id_vector;
+        ToIdVector(ids, id_vector);
+        std::vector<float> values;
+        ReadAttributeColumn(id_vector, type_name, attribute_name, values);
+
+        QVariantList ret;
+        ret.reserve(values.size());
+        for(size_t i = 0; i < values.size(); ++i)
+            ret.append(QVariant((double)values[i]));
+        return ret;
+    }
+
+    QByteArray SceneManager::GetAttributeColumnData(const QVariantList &ids, const QString &type_name, const QString &attribute_name) const
+    {
+        std::vector<entity_id_t> id_vector;
+        ToIdVector(ids, id_vector);
+        std::vector<float> values;
+        ReadAttributeColumn(id_vector, type_name, attribute_name, values);
+        if (values.empty())
+            return QByteArray();
+        return QByteArray(reinterpret_cast<const char *>(&values[0]), (int)(values.size() * sizeof(float)));
+    }
+
+    int SceneManager::SetAttributeColumn(const QVariantList &ids, const QString &type_name, const QString &attribute_name,
+        const QVariantList &values, int change)
+    {
+        std::vector<entity_id_t> id_vector;
+        ToIdVector(ids, id_vector);
+        std::vector<float> value_vector(values.size());
+        for(int i = 0; i < values.size(); ++i)
+            value_vector[i] = values[i].toFloat();
+        if (value_vector.empty())
+            return 0;
+        return (int)WriteAttributeColumn(id_vector, type_name, attribute_name, &value_vector[0], value_vector.size(), ToChangeType(change));
+    }
+
+    int SceneManager::SetAttributeColumnData(const QVariantList &ids, const QString &type_name, const QString &attribute_name,
+        const QByteArray &data, int change)
+    {
+        std::vector<entity_id_t> id_vector;
+        ToIdVector(ids, id_vector);
+        if (data.isEmpty())
+            return 0;
+        // The data of a QByteArray is heap allocated, so it is suitably aligned for floats.
+        return (int)WriteAttributeColumn(id_vector, type_name, attribute_name, reinterpret_cast<const float *>(data.constData()),
+            data.size() / sizeof(float), ToChangeType(change));
+    }
+
+    IAttribute *SceneManager::FindColumnAttribute(entity_id_t id, const QString &type_name, const std::string &attribute_name, size_t &index) const
+    {
+        EntityMap::const_iterator it = entities_.find(id);
+        if (it == entities_.end())
+            return 0;
+        ComponentPtr component = it->second->GetComponent(type_name);
+        if (!component)
+            return 0;
+
+        const AttributeVector &attributes = component->GetAttributes();
+        if (index < attributes.size() && attribute_name == attributes[index]->GetName())
+            return attributes[index];
+        for(size_t i = 0; i < attributes.size(); ++i)
+            if (attribute_name == attributes[i]->GetName())
+            {
+                index = i;
+                return attributes[i];
+            }
+        return 0;
+    }
+
+    uint SceneManager::ReadAttributeColumn(const std::vector<entity_id_t> &ids, const QString &type_name, const QString &attribute_name,
+        std::vector<float> &values) const
+    {
+        values.clear();
+
+        const std::string name = attribute_name.toStdString();
+        std::vector<IAttribute *> attributes(ids.size(), 0);
+        const std::type_info *column_type = 0;
+        uint stride = 0;
+        size_t index = 0;
+        for(size_t i = 0; i < ids.size(); ++i)
+        {
+            attributes[i] = FindColumnAttribute(ids[i], type_name, name, index);
+            if (attributes[i] && !stride)
+            {
+                stride = AttributeColumn::GetStride(attributes[i]);
+                column_type = &typeid(*attributes[i]);
+            }
+        }
+        if (!stride)
+            return 0;
+
+        values.resize(ids.size() * stride, std::numeric_limits<float>::quiet_NaN());
+        for(size_t i = 0; i < attributes.size(); ++i)
+            // Dynamic components may have attributes of different types with the same name.
+            if (attributes[i] && typeid(*attributes[i]) == *column_type)
+                AttributeColumn::Read(attributes[i], &values[i * stride]);
+        return stride;
+    }
+
+    uint SceneManager::WriteAttributeColumn(const std::vector<entity_id_t> &ids, const QString &type_name, const QString &attribute_name,
+        const float *values, size_t count, AttributeChange::Type change)
+    {
+        const std::string name = attribute_name.toStdString();
+        const std::type_info *column_type = 0;
+        uint stride = 0;
+        size_t index = 0;
+        uint written = 0;
+
+        bool was_batching = batch_attribute_changes_;
+        batch_attribute_changes_ = true;
+        for(size_t i = 0; i < ids.size(); ++i)
+        {
+            IAttribute *attribute = FindColumnAttribute(ids[i], type_name, name, index);
+            if (!attribute)
+                continue;
+            if (!stride)
+            {
+                stride = AttributeColumn::GetStride(attribute);
+                column_type = &typeid(*attribute);
+                if (!stride || count != ids.size() * stride)
+                    break;
+            }
+
+            const float *value = values + i * stride;
+            if (value[0] != value[0]) // NaN marks a skipped entity
+                continue;
+            // Resolve Default per component, as the changes are delivered in batches by change type.
+            AttributeChange::Type attribute_change = change;
+            if (attribute_change == AttributeChange::Default && attribute->GetOwner())
+                attribute_change = attribute->GetOwner()->GetUpdateMode();
+            if (typeid(*attribute) == *column_type && AttributeColumn::Write(attribute, value, attribute_change))
+                ++written;
+        }
+        if (!was_batching)
+            SetAttributeChangeBatching(false);
+
+        return written;
+    }
+
     QList<Scene::Entity*> SceneManager::GetEntitiesWithComponentRaw(const QString &type_name) const
     {
         QList<Scene::Entity*> ret;
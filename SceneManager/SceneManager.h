@@ -7,10 +7,14 @@
 #include "CoreStdIncludes.h"
 #include "Entity.h"
 #include "IComponent.h"
+#include "SpatialIndex.h"
+#include "AssetReferenceIndex.h"
 
 #include <QObject>
 #include <QVariant>
 #include <QStringList>
+#include <QPointer>
+#include <QVector3D>
 
 namespace Scene
 {
@@ -58,6 +62,65 @@ namespace Scene
         //! Return a scene document with just the desired entity
         QByteArray GetEntityXml(Scene::Entity *entity);
 
+        //! Returns entities whose position is within radius of center. Uses the spatial index.
+        QList<Scene::Entity*> GetEntitiesInRadius(const QVector3D &center, float radius) const;
+
+        //! Returns entities whose position is inside the axis-aligned box [min, max]. Uses the spatial index.
+        QList<Scene::Entity*> GetEntitiesInBox(const QVector3D &min, const QVector3D &max) const;
+
+        //! Returns at most count entities nearest to center, nearest first. Uses the spatial index.
+        QList<Scene::Entity*> GetNearestEntities(const QVector3D &center, int count) const;
+
+        //! Returns ids of entities whose position is within radius of center. Uses the spatial index.
+        /*! Cheaper for scripts than GetEntitiesInRadius, as no entity wrappers need to be created.
+         */
+        QVariantList GetEntityIdsInRadius(const QVector3D &center, float radius) const;
+
+        //! Returns ids of entities whose position is inside the axis-aligned box [min, max]. Uses the spatial index.
+        QVariantList GetEntityIdsInBox(const QVector3D &min, const QVector3D &max) const;
+
+        //! Reads one attribute of several entities as a flat list of numbers. See ReadAttributeColumn.
+        QVariantList GetAttributeColumn(const QVariantList &ids, const QString &type_name, const QString &attribute_name) const;
+
+        //! Reads one attribute of several entities as packed 32-bit floats in native byte order. See ReadAttributeColumn.
+        /*! Python scripts can convert the result without per-value overhead, f.ex. with array.array('f', data).
+         */
+        QByteArray GetAttributeColumnData(const QVariantList &ids, const QString &type_name, const QString &attribute_name) const;
+
+        //! Writes one attribute of several entities from a flat list of numbers. See WriteAttributeColumn.
+        /*! \param change AttributeChange::Type of the change
+            \return Number of entities written.
+         */
+        int SetAttributeColumn(const QVariantList &ids, const QString &type_name, const QString &attribute_name,
+            const QVariantList &values, int change = AttributeChange::Default);
+
+        //! Writes one attribute of several entities from packed 32-bit floats in native byte order. See WriteAttributeColumn.
+        /*! \param change AttributeChange::Type of the change
+            \return Number of entities written.
+         */
+        int SetAttributeColumnData(const QVariantList &ids, const QString &type_name, const QString &attribute_name,
+            const QByteArray &data, int change = AttributeChange::Default);
+
+        //! Enables or disables batching of attribute change signals.
+        /*! While batching is enabled, attribute changes are not signalled immediately. Instead, each changed attribute
+            is marked dirty in its component, and all changes are delivered once by FlushAttributeChanges(), which the
+            framework calls once per frame. Setting the same attribute several times during a frame results in a single
+            AttributeChanged signal. If an attribute is changed both with LocalOnly and Replicate, the change is delivered
+            as Replicate. Disabling batching flushes the pending changes.
+
+            Scenes created by the framework batch by default, which can be changed with batch_attribute_changes in the
+            SceneManager configuration group.
+         */
+        void SetAttributeChangeBatching(bool enable);
+
+        //! Returns whether attribute change signals are batched.
+        bool IsAttributeChangeBatching() const { return batch_attribute_changes_; }
+
+        //! Delivers all attribute changes that have been coalesced while batching was enabled.
+        /*! Emits AttributeChanged for each dirty attribute, and ComponentAttributesChanged once per component and change type.
+         */
+        void FlushAttributeChanges();
+
     public:
         //! destructor
         ~SceneManager();
@@ -143,9 +206,52 @@ namespace Scene
         //! Returns entity map for introspection purposes
         const EntityMap &GetEntityMap() const { return entities_; }
 
+        //! Returns the spatial index of entity positions.
+        /*! The positions are maintained by EC_Placeable. Use for proximity queries instead of iterating all entities.
+         */
+        SpatialIndex &GetSpatialIndex() { return spatial_index_; }
+
+        //! Returns the spatial index of entity positions.
+        const SpatialIndex &GetSpatialIndex() const { return spatial_index_; }
+
+        //! Returns the index of assets used by the entities.
+        /*! Use to find the entities and submeshes that use an asset instead of iterating all entities.
+         */
+        AssetReferenceIndex &GetAssetReferenceIndex() { return asset_reference_index_; }
+
+        //! Returns the index of assets used by the entities.
+        const AssetReferenceIndex &GetAssetReferenceIndex() const { return asset_reference_index_; }
+
         //! Return list of entities with a spesific component present.
         //! \param type_name Type name of the component
         EntityList GetEntitiesWithComponent(const QString &type_name) const;
+
+        //! Reads one numeric attribute of several entities into a flat array.
+        /*! Meant for scripts and tools that process the same attribute of many entities, f.ex. all EC_Placeable transforms.
+            For the layout of the values, see AttributeColumn.
+            \param ids Entities to read
+            \param type_name Type name of the component
+            \param attribute_name Name of the attribute
+            \param values Replaced with stride floats per entity, in the order of ids. The values of entities that do
+                   not have the component or attribute are NaN.
+            \return Number of floats per entity, or 0 if no entity has the attribute or the attribute is not numeric.
+         */
+        uint ReadAttributeColumn(const std::vector<entity_id_t> &ids, const QString &type_name, const QString &attribute_name,
+            std::vector<float> &values) const;
+
+        //! Writes one numeric attribute of several entities from a flat array.
+        /*! All changes are delivered as one batch, with a single ComponentAttributesChanged signal per component.
+            If the scene is already batching attribute changes, they are delivered on the next flush.
+            \param ids Entities to write
+            \param type_name Type name of the component
+            \param attribute_name Name of the attribute
+            \param values Stride floats per entity, in the order of ids. Entities whose first value is NaN are skipped.
+            \param count Number of floats in values. Must be stride times the number of ids.
+            \param change Type of change
+            \return Number of entities written.
+         */
+        uint WriteAttributeColumn(const std::vector<entity_id_t> &ids, const QString &type_name, const QString &attribute_name,
+            const float *values, size_t count, AttributeChange::Type change = AttributeChange::Default);
         
         //! Emit notification of an attribute changing. Called by IComponent.
         /*! \param comp Component pointer
@@ -153,6 +259,16 @@ namespace Scene
             \param change Type of change (local, from network...)
          */
         void EmitAttributeChanged(IComponent* comp, IAttribute* attribute, AttributeChange::Type change);
+
+        //! Emit notification of several attributes of a component changing at once. Called by IComponent.
+        /*! \param comp Component pointer
+            \param attributes Changed attributes
+            \param change Type of change (local, from network...)
+         */
+        void EmitComponentAttributesChanged(IComponent* comp, const AttributeVector &attributes, AttributeChange::Type change);
+
+        //! Records a component as having pending batched attribute changes. Called by IComponent.
+        void MarkComponentDirty(IComponent* comp);
         
         //! Emit a notification of a component being added to entity. Called by the entity
         /*! \param entity Entity pointer
@@ -216,6 +332,14 @@ namespace Scene
          */
         void AttributeChanged(IComponent* comp, IAttribute* attribute, AttributeChange::Type change);
 
+        //! Signal when one or more attributes of a component have changed
+        /*! Emitted once per component and change type when batched attribute changes are flushed. When batching is
+            disabled, only AttributeChanged is emitted. Listeners that process whole components, f.ex. to rebuild
+            geometry or serialize changes to network, can connect to both, and ignore AttributeChanged while
+            IsAttributeChangeBatching() is true, to do the work once per component.
+         */
+        void ComponentAttributesChanged(IComponent* comp, const AttributeVector &attributes, AttributeChange::Type change);
+
         //! Signal when a component is added to an entity and should possibly be replicated (if the change originates from local)
         /*! Network synchronization managers should connect to this
          */
@@ -263,6 +387,27 @@ namespace Scene
 
         //! Name of the scene
         QString name_;
+
+        //! Spatial index of entity positions
+        SpatialIndex spatial_index_;
+
+        //! Reverse index of assets used by the entities
+        AssetReferenceIndex asset_reference_index_;
+
+        //! Converts entity ids returned by the spatial index to entities
+        QList<Scene::Entity*> ToEntityList(const std::vector<entity_id_t> &ids) const;
+
+        //! Finds an attribute of an entity for the column functions.
+        /*! \param index Index of the attribute in the previous component, tried first as components of the same type
+                   usually have the same attributes. Updated to the index of the found attribute.
+         */
+        IAttribute *FindColumnAttribute(entity_id_t id, const QString &type_name, const std::string &attribute_name, size_t &index) const;
+
+        //! Are attribute change signals batched
+        bool batch_attribute_changes_;
+
+        //! Components that have pending batched attribute changes. Guarded, as components may be deleted before the flush.
+        std::vector<QPointer<IComponent> > dirty_components_;
     };
 }
 
@@ -0,0 +1,455 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+
+#include "StableHeaders.h"
+#include "DebugOperatorNew.h"
+
+#include "SpatialIndex.h"
+
+#include <boost/thread.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#include "MemoryLeakCheck.h"
+
+namespace
+{
+    //! Cell coordinates are packed to 21 bits each.
+    const int MAX_CELL_COORD = (1 << 20) - 1;
+
+    //! Collects entities inside a sphere.
+    struct RadiusCollector
+    {
+        Vector3df center;
+        float radiusSq;
+        std::vector<entity_id_t> *result;
+
+        template<typename Cell> bool operator()(const Cell &cell)
+        {
+            for(size_t i = 0; i < cell.size(); ++i)
+                if (cell[i].position.getDistanceFromSQ(center) <= radiusSq)
+                    result->push_back(cell[i].id);
+            return true;
+        }
+    };
+
+    //! Collects entities inside a box.
+    struct BoxCollector
+    {
+        Vector3df min;
+        Vector3df max;
+        std::vector<entity_id_t> *result;
+
+        template<typename Cell> bool operator()(const Cell &cell)
+        {
+            for(size_t i = 0; i < cell.size(); ++i)
+            {
+                const Vector3df &p = cell[i].position;
+                if (p.x >= min.x && p.y >= min.y && p.z >= min.z && p.x <= max.x && p.y <= max.y && p.z <= max.z)
+                    result->push_back(cell[i].id);
+            }
+            return true;
+        }
+    };
+
+    //! Keeps the count nearest entities seen so far in a max-heap on distance.
+    struct NearestCollector
+    {
+        typedef std::pair<float, entity_id_t> Candidate;
+
+        Vector3df center;
+        size_t count;
+        std::vector<Candidate> heap;
+
+        bool Full() const { return heap.size() >= count; }
+        float WorstDistanceSq() const { return heap.front().first; }
+
+        template<typename Cell> bool operator()(const Cell &cell)
+        {
+            for(size_t i = 0; i < cell.size(); ++i)
+            {
+                float distSq = cell[i].position.getDistanceFromSQ(center);
+                if (!Full())
+                {
+                    heap.push_back(Candidate(distSq, cell[i].id));
+                    std::push_heap(heap.begin(), heap.end());
+                }
+                else if (distSq < WorstDistanceSq())
+                {
+                    std::pop_heap(heap.begin(), heap.end());
+                    heap.back() = Candidate(distSq, cell[i].id);
+                    std::push_heap(heap.begin(), heap.end());
+                }
+            }
+            return true;
+        }
+    };
+
+    //! Runs a contiguous range of batched radius queries.
+    struct RadiusBatchWorker
+    {
+        const Scene::SpatialIndex *index;
+        const std::vector<Scene::SpatialIndex::RadiusQuery> *queries;
+        std::vector<std::vector<entity_id_t> > *results;
+        size_t begin;
+        size_t end;
+
+        void operator()() const
+        {
+            for(size_t i = begin; i < end; ++i)
+                index->QueryRadius((*queries)[i].center, (*queries)[i].radius, (*results)[i]);
+        }
+    };
+}
+
+namespace Scene
+{
+    SpatialIndex::SpatialIndex(float cellSize) :
+        cell_size_(1.f),
+        inv_cell_size_(1.f)
+    {
+        Clear();
+        SetCellSize(cellSize);
+    }
+
+    void SpatialIndex::SetCellSize(float cellSize)
+    {
+        if (!(cellSize > 0.f))
+            cellSize = 16.f;
+        if (cellSize == cell_size_)
+            return;
+
+        // Collect the current contents and reinsert them with the new cell size.
+        std::vector<std::pair<CellEntry, const IComponent *> > contents;
+        contents.reserve(entries_.size());
+        for(CellMap::const_iterator it = cells_.begin(); it != cells_.end(); ++it)
+            for(size_t i = 0; i < it->second.size(); ++i)
+                contents.push_back(std::make_pair(it->second[i], entries_[it->second[i].id].owner));
+
+        Clear();
+        cell_size_ = cellSize;
+        inv_cell_size_ = 1.f / cellSize;
+        for(size_t i = 0; i < contents.size(); ++i)
+            Update(contents[i].first.id, contents[i].first.position, contents[i].second);
+    }
+
+    SpatialIndex::CellCoord SpatialIndex::ToCellCoord(const Vector3df &position) const
+    {
+        float c[3] = { position.x, position.y, position.z };
+        int result[3];
+        for(int i = 0; i < 3; ++i)
+        {
+            float cell = std::floor(c[i] * inv_cell_size_);
+            // Clamp to the packable range. Written so that NaN ends up in the minimum cell.
+            if (!(cell > (float)-MAX_CELL_COORD))
+                cell = (float)-MAX_CELL_COORD;
+            if (!(cell < (float)MAX_CELL_COORD))
+                cell = (float)MAX_CELL_COORD;
+            result[i] = (int)cell;
+        }
+
+        CellCoord coord;
+        coord.x = result[0];
+        coord.y = result[1];
+        coord.z = result[2];
+        return coord;
+    }
+
+    SpatialIndex::CellKey SpatialIndex::ToKey(const CellCoord &coord)
+    {
+        const CellKey mask = (1 << 21) - 1;
+        return (((CellKey)coord.x & mask) << 42) | (((CellKey)coord.y & mask) << 21) | ((CellKey)coord.z & mask);
+    }
+
+    void SpatialIndex::Update(entity_id_t id, const Vector3df &position, const IComponent *owner)
+    {
+        CellCoord coord = ToCellCoord(position);
+        CellKey key = ToKey(coord);
+
+        EntryMap::iterator entry = entries_.find(id);
+        if (entry != entries_.end())
+        {
+            entry->second.owner = owner;
+            if (entry->second.cell == key)
+            {
+                // Still in the same cell, just update the position.
+                Cell &cell = cells_[key];
+                for(size_t i = 0; i < cell.size(); ++i)
+                    if (cell[i].id == id)
+                    {
+                        cell[i].position = position;
+                        return;
+                    }
+            }
+            RemoveFromCell(entry->second.cell, id);
+            entry->second.cell = key;
+        }
+        else
+        {
+            Entry newEntry;
+            newEntry.cell = key;
+            newEntry.owner = owner;
+            entries_[id] = newEntry;
+        }
+
+        CellEntry cellEntry;
+        cellEntry.id = id;
+        cellEntry.position = position;
+        cells_[key].push_back(cellEntry);
+
+        min_cell_.x = std::min(min_cell_.x, coord.x);
+        min_cell_.y = std::min(min_cell_.y, coord.y);
+        min_cell_.z = std::min(min_cell_.z, coord.z);
+        max_cell_.x = std::max(max_cell_.x, coord.x);
+        max_cell_.y = std::max(max_cell_.y, coord.y);
+        max_cell_.z = std::max(max_cell_.z, coord.z);
+    }
+
+    void SpatialIndex::RemoveFromCell(CellKey key, entity_id_t id)
+    {
+        CellMap::iterator cell = cells_.find(key);
+        if (cell == cells_.end())
+            return;
+
+        Cell &entries = cell->second;
+        for(size_t i = 0; i < entries.size(); ++i)
+            if (entries[i].id == id)
+            {
+                entries[i] = entries.back();
+                entries.pop_back();
+                break;
+            }
+
+        if (entries.empty())
+            cells_.erase(cell);
+    }
+
+    bool SpatialIndex::Remove(entity_id_t id)
+    {
+        EntryMap::iterator entry = entries_.find(id);
+        if (entry == entries_.end())
+            return false;
+
+        RemoveFromCell(entry->second.cell, id);
+        entries_.erase(entry);
+        return true;
+    }
+
+    bool SpatialIndex::RemoveOwnedBy(entity_id_t id, const IComponent *owner)
+    {
+        EntryMap::iterator entry = entries_.find(id);
+        if (entry == entries_.end() || entry->second.owner != owner)
+            return false;
+
+        RemoveFromCell(entry->second.cell, id);
+        entries_.erase(entry);
+        return true;
+    }
+
+    void SpatialIndex::Clear()
+    {
+        cells_.clear();
+        entries_.clear();
+        min_cell_.x = min_cell_.y = min_cell_.z = MAX_CELL_COORD;
+        max_cell_.x = max_cell_.y = max_cell_.z = -MAX_CELL_COORD;
+    }
+
+    bool SpatialIndex::GetPosition(entity_id_t id, Vector3df &position) const
+    {
+        EntryMap::const_iterator entry = entries_.find(id);
+        if (entry == entries_.end())
+            return false;
+
+        CellMap::const_iterator cell = cells_.find(entry->second.cell);
+        if (cell == cells_.end())
+            return false;
+
+        for(size_t i = 0; i < cell->second.size(); ++i)
+            if (cell->second[i].id == id)
+            {
+                position = cell->second[i].position;
+                return true;
+            }
+        return false;
+    }
+
+    template<typename Visitor> void SpatialIndex::VisitCells(const Vector3df &min, const Vector3df &max, Visitor &visitor) const
+    {
+        if (cells_.empty())
+            return;
+
+        CellCoord lo = ToCellCoord(min);
+        CellCoord hi = ToCellCoord(max);
+        lo.x = std::max(lo.x, min_cell_.x);
+        lo.y = std::max(lo.y, min_cell_.y);
+        lo.z = std::max(lo.z, min_cell_.z);
+        hi.x = std::min(hi.x, max_cell_.x);
+        hi.y = std::min(hi.y, max_cell_.y);
+        hi.z = std::min(hi.z, max_cell_.z);
+        if (lo.x > hi.x || lo.y > hi.y || lo.z > hi.z)
+            return;
+
+        // If the query volume covers more cells than there are occupied ones, it is faster to walk all of them.
+        double volume = (double)(hi.x - lo.x + 1) * (double)(hi.y - lo.y + 1) * (double)(hi.z - lo.z + 1);
+        if (volume > (double)cells_.size())
+        {
+            for(CellMap::const_iterator it = cells_.begin(); it != cells_.end(); ++it)
+                if (!visitor(it->second))
+                    return;
+            return;
+        }
+
+        CellCoord c;
+        for(c.x = lo.x; c.x <= hi.x; ++c.x)
+            for(c.y = lo.y; c.y <= hi.y; ++c.y)
+                for(c.z = lo.z; c.z <= hi.z; ++c.z)
+                {
+                    CellMap::const_iterator it = cells_.find(ToKey(c));
+                    if (it != cells_.end() && !visitor(it->second))
+                        return;
+                }
+    }
+
+    void SpatialIndex::QueryRadius(const Vector3df &center, float radius, std::vector<entity_id_t> &result) const
+    {
+        if (radius < 0.f)
+            return;
+
+        RadiusCollector collector;
+        collector.center = center;
+        collector.radiusSq = radius * radius;
+        collector.result = &result;
+        const Vector3df extent(radius, radius, radius);
+        VisitCells(center - extent, center + extent, collector);
+    }
+
+    void SpatialIndex::QueryBox(const Vector3df &min, const Vector3df &max, std::vector<entity_id_t> &result) const
+    {
+        BoxCollector collector;
+        collector.min = min;
+        collector.max = max;
+        collector.result = &result;
+        VisitCells(min, max, collector);
+    }
+
+    void SpatialIndex::QueryNearest(const Vector3df &center, size_t count, std::vector<entity_id_t> &result) const
+    {
+        if (count == 0 || entries_.empty())
+            return;
+
+        NearestCollector collector;
+        collector.center = center;
+        collector.count = count;
+        collector.heap.reserve(std::min(count, entries_.size()));
+
+        // Visit cells in growing cubic shells around the center cell. When the shells closer than d have been
+        // visited, every unvisited entity is at least d - 1 cells away from the center, so the search can stop
+        // once the worst of the count best candidates is closer than that.
+        const CellCoord c = ToCellCoord(center);
+        const size_t maxCellLookups = cells_.size() * 4 + 64;
+        size_t cellLookups = 0;
+        bool exhaustive = false;
+        // Shells that do not reach the occupied cells can be skipped.
+        int firstShell = std::max(std::max(std::max(min_cell_.x - c.x, c.x - max_cell_.x), std::max(min_cell_.y - c.y, c.y - max_cell_.y)),
+            std::max(std::max(min_cell_.z - c.z, c.z - max_cell_.z), 0));
+        for(int d = firstShell; ; ++d)
+        {
+            if (collector.Full())
+            {
+                float reach = (float)std::max(d - 1, 0) * cell_size_;
+                if (collector.WorstDistanceSq() <= reach * reach)
+                    break;
+            }
+
+            CellCoord lo = { c.x - d, c.y - d, c.z - d };
+            CellCoord hi = { c.x + d, c.y + d, c.z + d };
+            // The shell covers all occupied cells; nothing is left after this one.
+            bool last = lo.x <= min_cell_.x && lo.y <= min_cell_.y && lo.z <= min_cell_.z &&
+                hi.x >= max_cell_.x && hi.y >= max_cell_.y && hi.z >= max_cell_.z;
+
+            CellCoord cell;
+            for(cell.x = std::max(lo.x, min_cell_.x); cell.x <= std::min(hi.x, max_cell_.x); ++cell.x)
+                for(cell.y = std::max(lo.y, min_cell_.y); cell.y <= std::min(hi.y, max_cell_.y); ++cell.y)
+                {
+                    // On the x or y faces of the shell every z is visited, inside them only the two z faces.
+                    bool face = cell.x == lo.x || cell.x == hi.x || cell.y == lo.y || cell.y == hi.y;
+                    int zBegin = face ? std::max(lo.z, min_cell_.z) : lo.z;
+                    int zEnd = face ? std::min(hi.z, max_cell_.z) : hi.z;
+                    int step = face ? 1 : std::max(2 * d, 1);
+                    for(cell.z = zBegin; cell.z <= zEnd; cell.z += step)
+                    {
+                        if (cell.z < min_cell_.z || cell.z > max_cell_.z)
+                            continue;
+                        ++cellLookups;
+                        CellMap::const_iterator it = cells_.find(ToKey(cell));
+                        if (it != cells_.end())
+                            collector(it->second);
+                    }
+                }
+
+            if (last)
+                break;
+            // Sparse scene and a far away center; checking every cell once is cheaper than growing further.
+            if (cellLookups > maxCellLookups)
+            {
+                exhaustive = true;
+                break;
+            }
+        }
+
+        if (exhaustive)
+        {
+            collector.heap.clear();
+            for(CellMap::const_iterator it = cells_.begin(); it != cells_.end(); ++it)
+                collector(it->second);
+        }
+
+        std::sort_heap(collector.heap.begin(), collector.heap.end());
+        for(size_t i = 0; i < collector.heap.size(); ++i)
+            result.push_back(collector.heap[i].second);
+    }
+
+    void SpatialIndex::QueryRadiusBatch(const std::vector<RadiusQuery> &queries, std::vector<std::vector<entity_id_t> > &results,
+        uint numThreads) const
+    {
+        results.clear();
+        results.resize(queries.size());
+        if (queries.empty())
+            return;
+
+        if (numThreads == 0)
+            numThreads = boost::thread::hardware_concurrency();
+        // Starting threads costs more than a handful of queries.
+        const size_t minQueriesPerThread = 16;
+        numThreads = (uint)std::min((size_t)std::max(numThreads, 1u), (queries.size() + minQueriesPerThread - 1) / minQueriesPerThread);
+
+        RadiusBatchWorker worker;
+        worker.index = this;
+        worker.queries = &queries;
+        worker.results = &results;
+
+        if (numThreads <= 1)
+        {
+            worker.begin = 0;
+            worker.end = queries.size();
+            worker();
+            return;
+        }
+
+        // The calling thread runs the last range itself.
+        boost::thread_group threads;
+        const size_t perThread = (queries.size() + numThreads - 1) / numThreads;
+        for(uint i = 0; i < numThreads; ++i)
+        {
+            worker.begin = std::min(queries.size(), i * perThread);
+            worker.end = std::min(queries.size(), worker.begin + perThread);
+            if (worker.begin == worker.end)
+                break;
+            if (i + 1 < numThreads && worker.end < queries.size())
+                threads.create_thread(worker);
+            else
+                worker();
+        }
+        threads.join_all();
+    }
+}
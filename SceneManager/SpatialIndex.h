@@ -0,0 +1,165 @@
+// For conditions of distribution and use, see copyright notice in license.txt
+
+#ifndef incl_SceneManager_SpatialIndex_h
+#define incl_SceneManager_SpatialIndex_h
+
+#include "CoreTypes.h"
+#include "Vector3D.h"
+
+#include <boost/unordered_map.hpp>
+#include <boost/cstdint.hpp>
+
+#include <vector>
+
+class IComponent;
+
+namespace Scene
+{
+    //! Loose uniform grid of entity positions for proximity queries.
+    /*! Every SceneManager owns one spatial index. Each entity has at most one position in the index, which is
+        provided by one of its components (EC_Placeable keeps the world position of its entity up to date).
+        The entry is removed when the entity, or the component that provided the position, is removed from
+        the scene.
+
+        Space is divided into cubic cells, and only the occupied cells are stored, so the extents of the
+        scene do not need to be known beforehand. Queries only visit the cells that overlap the query volume.
+        The cell size should be roughly the size of a typical query radius.
+
+        Updating the index is not threadsafe. The const query functions may be called from several threads at
+        once as long as the index is not being modified, which QueryRadiusBatch() makes use of.
+
+        \ingroup Scene_group
+    */
+    class SpatialIndex
+    {
+    public:
+        //! A single radius query for QueryRadiusBatch().
+        struct RadiusQuery
+        {
+            RadiusQuery() : radius(0.f) {}
+            RadiusQuery(const Vector3df &c, float r) : center(c), radius(r) {}
+
+            Vector3df center;
+            float radius;
+        };
+
+        //! Constructor.
+        /*! \param cellSize Edge length of a grid cell in world units.
+         */
+        explicit SpatialIndex(float cellSize = 16.f);
+
+        //! Sets the edge length of a grid cell. All entries are redistributed.
+        void SetCellSize(float cellSize);
+
+        //! Returns the edge length of a grid cell.
+        float GetCellSize() const { return cell_size_; }
+
+        //! Inserts an entity to the index, or moves it if it is already there.
+        /*! \param id Entity id
+            \param position World position of the entity
+            \param owner Component that provides the position, or null.
+         */
+        void Update(entity_id_t id, const Vector3df &position, const IComponent *owner = 0);
+
+        //! Removes an entity from the index. Returns true if the entity was in the index.
+        bool Remove(entity_id_t id);
+
+        //! Removes an entity from the index, if its position was provided by the given component.
+        bool RemoveOwnedBy(entity_id_t id, const IComponent *owner);
+
+        //! Removes all entities.
+        void Clear();
+
+        //! Returns number of entities in the index.
+        size_t Size() const { return entries_.size(); }
+
+        //! Returns number of occupied cells.
+        size_t GetCellCount() const { return cells_.size(); }
+
+        //! Returns position of an entity in the index.
+        /*! \return True if the entity was found, false otherwise.
+         */
+        bool GetPosition(entity_id_t id, Vector3df &position) const;
+
+        //! Finds entities that are within radius of a point.
+        /*! Found entity ids are appended to result in no particular order.
+         */
+        void QueryRadius(const Vector3df &center, float radius, std::vector<entity_id_t> &result) const;
+
+        //! Finds entities that are inside an axis-aligned box.
+        /*! Found entity ids are appended to result in no particular order.
+         */
+        void QueryBox(const Vector3df &min, const Vector3df &max, std::vector<entity_id_t> &result) const;
+
+        //! Finds the count entities nearest to a point.
+        /*! Found entity ids are appended to result, nearest first.
+         */
+        void QueryNearest(const Vector3df &center, size_t count, std::vector<entity_id_t> &result) const;
+
+        //! Runs several radius queries in parallel.
+        /*! \param queries Queries to run.
+            \param results Resized to the number of queries, results[i] holds the result of queries[i].
+            \param numThreads Number of threads to use. Zero uses the number of hardware threads.
+         */
+        void QueryRadiusBatch(const std::vector<RadiusQuery> &queries, std::vector<std::vector<entity_id_t> > &results,
+            uint numThreads = 0) const;
+
+    private:
+        typedef boost::uint64_t CellKey;
+
+        //! Integer coordinates of a cell.
+        struct CellCoord
+        {
+            int x, y, z;
+        };
+
+        //! Entity stored in a cell. The position is duplicated here so that queries do not need entry lookups.
+        struct CellEntry
+        {
+            entity_id_t id;
+            Vector3df position;
+        };
+
+        typedef std::vector<CellEntry> Cell;
+        typedef boost::unordered_map<CellKey, Cell> CellMap;
+
+        //! Bookkeeping of an entity in the index.
+        struct Entry
+        {
+            CellKey cell;
+            const IComponent *owner;
+        };
+
+        typedef boost::unordered_map<entity_id_t, Entry> EntryMap;
+
+        //! Returns the cell containing a position.
+        CellCoord ToCellCoord(const Vector3df &position) const;
+
+        //! Packs cell coordinates to a key.
+        static CellKey ToKey(const CellCoord &coord);
+
+        //! Removes an entity from its cell, and the cell if it became empty.
+        void RemoveFromCell(CellKey key, entity_id_t id);
+
+        //! Calls visitor for every cell overlapping the given box. Visiting stops if the visitor returns false.
+        template<typename Visitor> void VisitCells(const Vector3df &min, const Vector3df &max, Visitor &visitor) const;
+
+        //! Occupied cells.
+        CellMap cells_;
+
+        //! All entities in the index.
+        EntryMap entries_;
+
+        //! Edge length of a cell.
+        float cell_size_;
+
+        //! 1 / cell_size_.
+        float inv_cell_size_;
+
+        //! Bounds of the cells that have been occupied since the last Clear(). Never shrinks otherwise.
+        CellCoord min_cell_;
+        CellCoord max_cell_;
+    };
+}
+
+#endif
@@ -59,18 +59,22 @@ namespace Console
 
     __inline void ConsoleManager::Print(const std::string &text)
     {
+        MutexLock lock(print_mutex_);
         if(ui_initialized_)
-        {
-            Console::ConsoleEventData* event_data = new Console::ConsoleEventData(text);
-            parent_->GetFramework()->GetEventManager()->SendDelayedEvent(console_category_id_,
-                Console::Events::EVENT_CONSOLE_PRINT_LINE, EventDataPtr(event_data));
-        }
+            SendPrintEvent(text);
         else
         {
             early_messages_.push_back(text);
         }
     }
 
+    void ConsoleManager::SendPrintEvent(const std::string &text)
+    {
+        Console::ConsoleEventData* event_data = new Console::ConsoleEventData(text);
+        parent_->GetFramework()->GetEventManager()->SendDelayedEvent(console_category_id_,
+            Console::Events::EVENT_CONSOLE_PRINT_LINE, EventDataPtr(event_data));
+    }
+
     void ConsoleManager::ExecuteCommand(const std::string &command)
     {
         if (command_manager_)
@@ -79,11 +83,13 @@ namespace Console
 
     void ConsoleManager::SetUiInitialized(bool initialized)
     {
+        MutexLock lock(print_mutex_);
         this->ui_initialized_ = initialized;
         if (ui_initialized_)
         {
+            // Send with the lock held, so that messages printed meanwhile come after these
             for(unsigned i=0; i<early_messages_.size();i++)
-                Print(early_messages_.at(i));
+                SendPrintEvent(early_messages_.at(i));
 
             early_messages_.clear();
         }
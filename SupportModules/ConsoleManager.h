@@ -9,6 +9,7 @@
 #include "ConsoleServiceInterface.h"
 #include "CommandManager.h"
 #include "LogListenerInterface.h"
+#include "CoreThread.h"
 
 namespace Foundation
 {
@@ -65,6 +66,8 @@ namespace Console
         void UnsubscribeLogListener();
 
     private:
+        //! Sends text to the console UI. Called with print_mutex_ held.
+        void SendPrintEvent(const std::string &text);
 
         //Console event category
         event_category_id_t console_category_id_;
@@ -86,6 +89,10 @@ namespace Console
 
         //!indicates whether the UI is initialized
         bool ui_initialized_;
+
+        //! Protects early_messages_ and ui_initialized_. Log messages are printed from the threads that log them,
+        //! and from the log writer thread when the log is written asynchronously.
+        Mutex print_mutex_;
     };
 
     //! loglistener is used to listen log messages from renderer
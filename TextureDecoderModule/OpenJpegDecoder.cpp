@@ -41,6 +41,7 @@
 #include "ThreadTaskManager.h"
 #include "OpenJpegDecoder.h"
 #include "Profiler.h"
+#include "HighPerfClock.h"
 
 #include <openjpeg.h>
 
@@ -116,6 +117,7 @@ namespace TextureDecoder
 
         bool texture_id_is_url = QString(request->id_.c_str()).startsWith("http");
 
+        tick_t start = GetCurrentClockTime();
         DecodeResultPtr result(new DecodeResult());
 
         result->id_ = request->id_;
@@ -125,6 +127,8 @@ namespace TextureDecoder
         result->original_height_ = 0;
         result->components_ = 0;
         result->tag_ = request->tag_;
+        result->is_jpeg2000_ = false;
+        result->decode_time_ = 0.0;
 
         if (!texture_id_is_url)
         {
@@ -195,6 +199,13 @@ namespace TextureDecoder
                     }
                 }
          
+                // Mipmaps for the decoded texture cache, so that textures are read from it ready for upload
+                if (request->mipmaps_ && request->level_ == 0)
+                {
+                    PROFILE(OpenJpegDecoder_GenerateMipmaps);
+                    texture->GenerateMipmaps();
+                }
+
                 result->texture_ = resource;
                 result->is_jpeg2000_ = true;
             }
@@ -271,6 +282,7 @@ namespace TextureDecoder
 
         }
 
+        result->decode_time_ = (GetCurrentClockTime() - start) / (f64)GetCurrentClockFreq();
         QueueResult<DecodeResult>(result);
     }
 }
@@ -16,6 +16,9 @@
 
 namespace TextureDecoder
 {
+    //! Marks files that have the mipmap levels of the texture. Files without it have only the full size image.
+    static const quint32 MIPMAP_FILE_MAGIC = 0x4d495053;
+
     TextureCache::TextureCache(Foundation::Framework* framework) :
         QObject(),
         framework_(framework),
@@ -55,77 +58,181 @@ namespace TextureDecoder
     {
     }
 
-    void TextureCache::StoreTexture(Foundation::TextureInterface *texture)
+    bool TextureCache::StoreTexture(Foundation::TextureInterface *texture)
     {
         QString id = GetHash(texture->GetId());
         QFile decoded_texture(GetFullPath(id));
         if (!decoded_texture.exists())
         {
             if (!decoded_texture.open(QIODevice::ReadWrite))
-                return;
+                return false;
 
-            // Write metadata
             QDataStream data_stream(&decoded_texture);
-            data_stream << texture->GetComponents()
-                        << texture->GetWidth()
-                        << texture->GetHeight()
-                        << texture->GetLevel()
-                        << texture->GetFormat()
-                        << (int)texture->GetDataSize();
-
-            // Write data
-            data_stream.writeRawData((const char *)texture->GetData(), texture->GetDataSize());
+            uint mips = texture->GetMipCount();
+            if (mips > 1)
+            {
+                // Write metadata and the size of each mipmap level
+                data_stream << MIPMAP_FILE_MAGIC
+                            << texture->GetComponents()
+                            << texture->GetWidth()
+                            << texture->GetHeight()
+                            << texture->GetLevel()
+                            << texture->GetFormat()
+                            << mips;
+                for (uint i = 0; i < mips; ++i)
+                    data_stream << texture->GetMipDataSize(i);
+
+                // Write data
+                for (uint i = 0; i < mips; ++i)
+                    data_stream.writeRawData((const char *)texture->GetMipData(i), texture->GetMipDataSize(i));
+            }
+            else
+            {
+                // Write metadata
+                data_stream << texture->GetComponents()
+                            << texture->GetWidth()
+                            << texture->GetHeight()
+                            << texture->GetLevel()
+                            << texture->GetFormat()
+                            << (int)texture->GetDataSize();
+
+                // Write data
+                data_stream.writeRawData((const char *)texture->GetData(), texture->GetDataSize());
+            }
       
             decoded_texture.close();
             current_cache_size_ += decoded_texture.size();
 
-            // Remove unneeded encoded asset cache entry for this texture
-            boost::shared_ptr<Foundation::AssetServiceInterface> asset_service = framework_->GetServiceManager()->GetService<Foundation::AssetServiceInterface>(Service::ST_Asset).lock();
-            if (asset_service)
-                asset_service->RemoveAssetFromCache(texture->GetId());
+            // Remove unneeded encoded asset cache entry for this texture. Lower quality levels of a texture stored
+            // without mipmaps are decoded from the encoded asset when the texture memory budget reduces the texture,
+            // so then the asset is kept.
+            if (mips > 1)
+            {
+                boost::shared_ptr<Foundation::AssetServiceInterface> asset_service = framework_->GetServiceManager()->GetService<Foundation::AssetServiceInterface>(Service::ST_Asset).lock();
+                if (asset_service)
+                    asset_service->RemoveAssetFromCache(texture->GetId());
+            }
 
-            TextureDecoderModule::LogDebug("Stored decoded texture " + id.left(7).toStdString() + "... to texture cache");
+            if (TextureDecoderModule::IsLogEnabled(Poco::Message::PRIO_DEBUG))
+                TextureDecoderModule::LogDebug("Stored decoded texture " + id.left(7).toStdString() + "... to texture cache");
             CheckCacheSize();
+            return true;
         }
+        return false;
     }
 
-    TextureResource *TextureCache::GetTexture(const std::string &texture_id)
+    TextureResource *TextureCache::GetTexture(const std::string &texture_id, int level)
     {
         QString id = GetHash(texture_id);
-        QFile decoded_texture(GetFullPath(id));
-        if (decoded_texture.exists())
+        boost::shared_ptr<QFile> decoded_texture(new QFile(GetFullPath(id)));
+        if (decoded_texture->exists())
         {
-            if (!decoded_texture.open(QIODevice::ReadOnly))
+            if (!decoded_texture->open(QIODevice::ReadOnly))
                 return 0;
 
-            int data_length, format, level;
+            QDataStream data_stream(decoded_texture.get());
+            quint32 magic = 0;
+            data_stream >> magic;
+            if (magic == MIPMAP_FILE_MAGIC)
+                return GetMipmapTexture(texture_id, level, decoded_texture, data_stream);
+
+            // Only the full size image is in the file
+            if (level != 0)
+                return 0;
+            decoded_texture->seek(0);
+            data_stream.resetStatus();
+
+            int data_length, format, stored_level;
             uint components, width, height;
 
             // Read metadata
-            QDataStream data_stream(&decoded_texture);
             data_stream >> components;
             data_stream >> width;
             data_stream >> height;
-            data_stream >> level;
+            data_stream >> stored_level;
             data_stream >> format;
             data_stream >> data_length;
 
             // Init TextureResource with metadata
             TextureResource *texture = new TextureResource(texture_id, width, height, components);
-            texture->SetLevel(level);
+            texture->SetLevel(stored_level);
             texture->SetFormat(format);
 
             // Read data
             char *data_str_ptr = (char*)texture->GetData();
             data_stream.readRawData(data_str_ptr, data_length);
 
-            decoded_texture.close();
-            TextureDecoderModule::LogDebug("Found decoded texture " + id.left(7).toStdString() + "... from cache");
+            decoded_texture->close();
+            if (TextureDecoderModule::IsLogEnabled(Poco::Message::PRIO_DEBUG))
+                TextureDecoderModule::LogDebug("Found decoded texture " + id.left(7).toStdString() + "... from cache");
             return texture;
         }
         return 0;
     }
 
+    TextureResource *TextureCache::GetMipmapTexture(const std::string &texture_id, int level, boost::shared_ptr<QFile> file,
+        QDataStream &data_stream)
+    {
+        int stored_level, format;
+        uint components, width, height, mips;
+
+        // Read metadata and the size of each mipmap level
+        data_stream >> components;
+        data_stream >> width;
+        data_stream >> height;
+        data_stream >> stored_level;
+        data_stream >> format;
+        data_stream >> mips;
+        if (data_stream.status() != QDataStream::Ok || level < 0 || (uint)level >= mips || mips > 32)
+            return 0;
+
+        std::vector<uint> mip_sizes(mips);
+        for (uint i = 0; i < mips; ++i)
+            data_stream >> mip_sizes[i];
+        if (data_stream.status() != QDataStream::Ok)
+            return 0;
+
+        // The requested level is the first mipmap level in the texture
+        qint64 offset = file->pos();
+        for (int i = 0; i < level; ++i)
+            offset += mip_sizes[i];
+        mip_sizes.erase(mip_sizes.begin(), mip_sizes.begin() + level);
+        qint64 size = 0;
+        for (uint i = 0; i < mip_sizes.size(); ++i)
+            size += mip_sizes[i];
+        if (offset + size > file->size())
+            return 0;
+
+        uint level_width = TextureResource::GetMipDimension(width, level);
+        uint level_height = TextureResource::GetMipDimension(height, level);
+        if (mip_sizes[0] != level_width * level_height * components)
+            return 0;
+
+        TextureResource *texture = new TextureResource(texture_id);
+        texture->SetLevel(stored_level + level);
+        texture->SetFormat(format);
+
+        // Map the data, so that it is read only once, when the texture is created from it
+        u8 *data = file->map(offset, size);
+        if (data)
+            texture->SetMappedData(file, data, level_width, level_height, components, mip_sizes);
+        else
+        {
+            // Read only the image of the level to own memory
+            texture->SetSize(level_width, level_height, components);
+            file->seek(offset);
+            if (file->read((char *)texture->GetData(), mip_sizes[0]) != mip_sizes[0])
+            {
+                delete texture;
+                return 0;
+            }
+        }
+        if (TextureDecoderModule::IsLogEnabled(Poco::Message::PRIO_DEBUG))
+            TextureDecoderModule::LogDebug("Found decoded texture " + GetHash(texture_id).left(7).toStdString() + "... level " +
+                ToString(level) + " from cache");
+        return texture;
+    }
+
     void TextureCache::DeleteFromCache(const std::string &texture_id)
     {
         QString id = GetHash(texture_id);
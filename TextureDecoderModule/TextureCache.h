@@ -6,6 +6,9 @@
 #include <QObject>
 #include <QDir>
 
+class QFile;
+class QDataStream;
+
 #include "Foundation.h"
 #include "TextureResource.h"
 
@@ -31,11 +34,14 @@ namespace TextureDecoder
         public slots:
             //! Store a texture to disk cache
             //! @param TextureInterface implementing pointer
-            void StoreTexture(Foundation::TextureInterface *texture);
+            //! @return true if the texture was stored, false if it was already in the cache or could not be written
+            bool StoreTexture(Foundation::TextureInterface *texture);
 
             //! Get a texture resource from cache
             //! @param texture id
-            TextureResource *GetTexture(const std::string &texture_id);
+            //! @param level quality level, each level halves the width and height. Levels above 0 are found only
+            //! from files that have the mipmap levels.
+            TextureResource *GetTexture(const std::string &texture_id, int level = 0);
 
             //! Delete a texture from disk cache
             //! @param texture_id
@@ -66,6 +72,10 @@ namespace TextureDecoder
             QString GetFullPath(QString hash_id);
 
         private:
+            //! Get a texture resource from a file that has the mipmap levels, the metadata is read from data_stream
+            TextureResource *GetMipmapTexture(const std::string &texture_id, int level, boost::shared_ptr<QFile> file,
+                QDataStream &data_stream);
+
             Foundation::Framework* framework_;
 
             QString DEFAULT_TEXTURE_CACHE_DIR;
@@ -33,6 +33,11 @@ namespace TextureDecoder
         EventManagerPtr event_manager = framework_->GetEventManager();
         asset_event_category_ = event_manager->QueryEventCategory("Asset");
         task_event_category_ = event_manager->QueryEventCategory("Task");
+
+        RegisterConsoleCommand(Console::CreateCommand("TextureCacheStats",
+            "Prints the texture decodes and the use of the decoded texture cache, to compare entering a region with an empty and a "
+            "full cache. Usage: TextureCacheStats(reset)",
+            Console::Bind(this, &TextureDecoderModule::ConsoleTextureCacheStats)));
     }
     
     // virtual
@@ -71,6 +76,25 @@ namespace TextureDecoder
         }
         return false;
     }
+
+    Console::CommandResult TextureDecoderModule::ConsoleTextureCacheStats(const StringVector &params)
+    {
+        if (!texture_service_)
+            return Console::ResultFailure("Texture service not initialized.");
+
+        const TextureService::Stats &stats = texture_service_->GetStats();
+        std::stringstream ss;
+        ss << stats.decodes << " decodes in " << stats.decode_time * 1000.0 << " ms of decoder thread time" << std::endl
+           << stats.cache_hits << " textures from the decoded texture cache in " << stats.cache_time * 1000.0 << " ms, "
+           << stats.cache_bytes / 1024 << " KB, " << stats.level_cache_hits << " lower quality levels" << std::endl
+           << stats.stores << " textures stored to the cache in " << stats.store_time * 1000.0 << " ms, mipmaps "
+           << (texture_service_->GetDecodedMipmaps() ? "enabled" : "disabled");
+
+        if (params.size() > 0 && params[0] == "reset")
+            texture_service_->ResetStats();
+
+        return Console::ResultSuccess(ss.str());
+    }
 }
 
 extern "C" void POCO_LIBRARY_API SetProfiler(Foundation::Profiler *profiler);
@@ -35,6 +35,9 @@ namespace TextureDecoder
         //! returns name of this module. Needed for logging.
         static const std::string &NameStatic() { return type_name_static_; }
 
+        //! Prints the decodes and the decoded texture cache use. With parameter reset, resets the counters.
+        Console::CommandResult ConsoleTextureCacheStats(const StringVector &params);
+
     private:
         //! Type name of the module.
         static std::string type_name_static_;
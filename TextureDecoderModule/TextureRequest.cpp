@@ -6,6 +6,7 @@ namespace TextureDecoder
 {
     TextureRequest::TextureRequest() :
         requested_(false),
+        asset_tag_(0),
         decode_requested_(false),
         size_(0),
         received_(0),
@@ -20,6 +21,7 @@ namespace TextureDecoder
     TextureRequest::TextureRequest(const std::string& id) : 
         id_(id),
         requested_(false),
+        asset_tag_(0),
         decode_requested_(false),
         size_(0),
         received_(0),
@@ -13,6 +13,8 @@ namespace TextureDecoder
     class DecodeRequest : public Foundation::ThreadTaskRequest
     {
     public:
+        DecodeRequest() : level_(0), mipmaps_(false) {}
+
         //! Texture asset ID
         std::string id_;
 
@@ -21,6 +23,9 @@ namespace TextureDecoder
 
         //! Quality level to decode, 0 = highest
         int level_;
+
+        //! Whether to generate the mipmaps of a JPEG2000 texture decoded at the highest level
+        bool mipmaps_;
     };
 
     typedef boost::shared_ptr<DecodeRequest> DecodeRequestPtr;
@@ -51,6 +56,9 @@ namespace TextureDecoder
         uint components_;
 
         bool is_jpeg2000_;
+
+        //! Seconds spent decoding, including generating mipmaps
+        f64 decode_time_;
     };
     
     typedef boost::shared_ptr<DecodeResult> DecodeResultPtr;
@@ -73,6 +81,9 @@ namespace TextureDecoder
         //! Sets asset request status
         void SetRequested(bool requested) { requested_ = requested; }
 
+        //! Sets the request tag of the asset request
+        void SetAssetTag(request_tag_t tag) { asset_tag_ = tag; }
+
         //! Sets decode request status
         void SetDecodeRequested(bool requested) { decode_requested_ = requested; }
 
@@ -109,6 +120,9 @@ namespace TextureDecoder
         //! Returns asset request status
         bool IsRequested() const { return requested_; }
         
+        //! Returns the request tag of the asset request, 0 if not requested
+        request_tag_t GetAssetTag() const { return asset_tag_; }
+
         //! Returns decode request status
         bool IsDecodeRequested() const { return decode_requested_; }
 
@@ -151,6 +165,9 @@ namespace TextureDecoder
         //! whether asset request has been queued
         bool requested_;
 
+        //! asset request tag, 0 if not requested
+        request_tag_t asset_tag_;
+
         //! whether decode request has been queued
         bool decode_requested_;
 
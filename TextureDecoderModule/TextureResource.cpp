@@ -4,6 +4,8 @@
 
 #include "TextureResource.h"
 
+#include <QFile>
+
 namespace TextureDecoder
 {
     TextureResource::TextureResource(const std::string& id) : 
@@ -12,7 +14,8 @@ namespace TextureDecoder
         height_(0),
         components_(0),
         level_(-1),
-        format_(-1)
+        format_(-1),
+        mapped_(0)
     {
     }
 
@@ -22,7 +25,8 @@ namespace TextureDecoder
         height_(height),
         components_(components),
         level_(-1),
-        format_(-1)
+        format_(-1),
+        mapped_(0)
     {
         data_.resize(width * height * components);
         data_size_ = width * height * components;
@@ -30,10 +34,98 @@ namespace TextureDecoder
 
     TextureResource::~TextureResource()
     {
+        if (mapped_)
+            file_->unmap(mapped_);
+    }
+
+    u8* TextureResource::GetMipData(uint mip)
+    {
+        if (mip >= GetMipCount())
+            return 0;
+
+        u8* data = GetData();
+        for (uint i = 0; i < mip; ++i)
+            data += mip_sizes_[i];
+        return data;
+    }
+
+    uint TextureResource::GetMipDataSize(uint mip)
+    {
+        if (mip >= GetMipCount())
+            return 0;
+        return mip_sizes_.empty() ? data_size_ : mip_sizes_[mip];
+    }
+
+    void TextureResource::GenerateMipmaps()
+    {
+        if (!mip_sizes_.empty() || mapped_ || format_ != -1 || !width_ || !height_ || !components_)
+            return;
+        if (data_.size() < width_ * height_ * components_)
+            return;
+
+        // Size the whole chain first, as the data is reallocated
+        uint levels = 1;
+        uint total = width_ * height_ * components_;
+        mip_sizes_.push_back(total);
+        while (GetMipDimension(width_, levels - 1) > 1 || GetMipDimension(height_, levels - 1) > 1)
+        {
+            uint size = GetMipDimension(width_, levels) * GetMipDimension(height_, levels) * components_;
+            mip_sizes_.push_back(size);
+            total += size;
+            ++levels;
+        }
+        data_.resize(total);
+
+        uint src_offset = 0;
+        for (uint mip = 1; mip < levels; ++mip)
+        {
+            uint src_width = GetMipDimension(width_, mip - 1);
+            uint src_height = GetMipDimension(height_, mip - 1);
+            uint width = GetMipDimension(width_, mip);
+            uint height = GetMipDimension(height_, mip);
+            uint dest_offset = src_offset + mip_sizes_[mip - 1];
+            const u8* src = &data_[src_offset];
+            u8* dest = &data_[dest_offset];
+
+            for (uint y = 0; y < height; ++y)
+            {
+                // When a dimension was already 1, the same row or column is used twice
+                const u8* row0 = src + std::min(y * 2, src_height - 1) * src_width * components_;
+                const u8* row1 = src + std::min(y * 2 + 1, src_height - 1) * src_width * components_;
+                for (uint x = 0; x < width; ++x)
+                {
+                    uint x0 = std::min(x * 2, src_width - 1) * components_;
+                    uint x1 = std::min(x * 2 + 1, src_width - 1) * components_;
+                    for (uint c = 0; c < components_; ++c)
+                        *dest++ = (u8)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+                }
+            }
+
+            src_offset = dest_offset;
+        }
+    }
+
+    void TextureResource::SetMappedData(boost::shared_ptr<QFile> file, u8* data, uint width, uint height, uint components,
+        const std::vector<uint>& mip_sizes)
+    {
+        if (mapped_)
+            file_->unmap(mapped_);
+
+        width_ = width;
+        height_ = height;
+        components_ = components;
+        data_.clear();
+        file_ = file;
+        mapped_ = data;
+        mip_sizes_ = mip_sizes;
+        data_size_ = mip_sizes_.empty() ? 0 : mip_sizes_[0];
+        if (mip_sizes_.size() == 1)
+            mip_sizes_.clear();
     }
 
     void TextureResource::SetSize(uint width, uint height, uint components)
     {
+        mip_sizes_.clear();
         width_ = width;
         height_ = height;
         components_ = components;
@@ -56,6 +148,6 @@ namespace TextureDecoder
     
     bool TextureResource::IsValid() const
     {
-        return data_.size() > 0;
+        return mapped_ || data_.size() > 0;
     }
 }
\ No newline at end of file
@@ -5,6 +5,8 @@
 
 #include "TextureInterface.h"
 
+class QFile;
+
 namespace TextureDecoder
 {
     class TextureResource : public Foundation::TextureInterface
@@ -19,9 +21,12 @@ namespace TextureDecoder
         virtual uint GetHeight() const { return height_; }
         virtual uint GetComponents() const { return components_; }
         virtual int GetLevel() const { return level_; }
-        virtual u8* GetData() { return &data_[0]; }
-        virtual uint GetDataSize() { return data_size_; }
+        virtual u8* GetData() { return mapped_ ? mapped_ : &data_[0]; }
+        virtual uint GetDataSize() { return mip_sizes_.empty() ? data_size_ : mip_sizes_[0]; }
         virtual int GetFormat() { return format_; }
+        virtual uint GetMipCount() const { return mip_sizes_.empty() ? 1 : mip_sizes_.size(); }
+        virtual u8* GetMipData(uint mip);
+        virtual uint GetMipDataSize(uint mip);
         virtual const std::string& GetType() const;
         static const std::string& GetTypeStatic();
 
@@ -32,6 +37,25 @@ namespace TextureDecoder
         void SetLevel(int level) { level_ = level; }
         void SetFormat(int format) { format_ = format; }
 
+        //! Appends the mipmap levels of the image to the data, down to 1x1, by averaging 2x2 pixels
+        /*! Only for textures with a byte per component (format -1). Does nothing if the texture already has mipmaps.
+         */
+        void GenerateMipmaps();
+
+        //! Uses a memory mapped file as the data, instead of own memory
+        /*! \param file File that was mapped, kept open while the texture exists
+            \param data Mapped data of the mipmap levels, one after another
+            \param width Width of the full size image
+            \param height Height of the full size image
+            \param components Number of components
+            \param mip_sizes Data sizes of the mipmap levels, the first one is the full size image
+         */
+        void SetMappedData(boost::shared_ptr<QFile> file, u8* data, uint width, uint height, uint components,
+            const std::vector<uint>& mip_sizes);
+
+        //! Returns width or height of a mipmap level
+        static uint GetMipDimension(uint size, uint mip) { return std::max<uint>(size >> mip, 1); }
+
     private:
         uint width_;
         uint height_;
@@ -40,7 +64,14 @@ namespace TextureDecoder
         int format_;
         int level_;
         std::vector<u8> data_;
+
+        //! Data sizes of the mipmap levels, empty if there is only the full size image
+        std::vector<uint> mip_sizes_;
+
+        //! Mapped file and its data, if the data is not in data_
+        boost::shared_ptr<QFile> file_;
+        u8* mapped_;
     };
 }
 
-#endif
\ No newline at end of file
+#endif
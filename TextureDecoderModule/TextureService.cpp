@@ -16,9 +16,12 @@
 #include "ThreadTaskManager.h"
 #include "ConfigurationManager.h"
 #include "TextureCache.h"
+#include "HighPerfClock.h"
 
 #include <QStringList>
 
+#include <algorithm>
+
 namespace TextureDecoder
 {
     static const int DEFAULT_MAX_DECODES = 4;
@@ -35,6 +38,8 @@ namespace TextureDecoder
         if (max_decodes_per_frame_ <= 0) 
             max_decodes_per_frame_ = 1;
 
+        decoded_mipmaps_ = framework_->GetDefaultConfig().DeclareSetting("TextureDecoder", "decoded_mipmaps", true);
+
         // Create decoder thread task and let the framework thread task manager handle it
         OpenJpegDecoder* decoder = new OpenJpegDecoder();
         decoder->SetDecodesPerFrame(max_decodes_per_frame_);
@@ -65,9 +70,15 @@ namespace TextureDecoder
         }
 
         // Check cache
+        tick_t start = GetCurrentClockTime();
         TextureResource *texture = cache_->GetTexture(asset_id);
         if (texture)
         {
+            ++stats_.cache_hits;
+            stats_.cache_time += (GetCurrentClockTime() - start) / (f64)GetCurrentClockFreq();
+            for (uint i = 0; i < texture->GetMipCount(); ++i)
+                stats_.cache_bytes += texture->GetMipDataSize(i);
+
             CacheReply reply;
             reply.tags.push_back(tag);
             reply.resource = Foundation::ResourcePtr(texture);
@@ -83,6 +94,74 @@ namespace TextureDecoder
         return tag;
     }
 
+    void TextureService::CancelTextureRequest(const std::string& asset_id, request_tag_t tag)
+    {
+        CacheReplys::iterator c = cache_replys_.find(asset_id);
+        if (c != cache_replys_.end())
+        {
+            RequestTagVector& tags = c->second.tags;
+            tags.erase(std::remove(tags.begin(), tags.end(), tag), tags.end());
+            if (tags.empty())
+                cache_replys_.erase(c);
+            return;
+        }
+
+        TextureRequestMap::iterator i = requests_.find(asset_id);
+        if (i == requests_.end())
+            return;
+        RequestTagVector& tags = i->second.tags_;
+        tags.erase(std::remove(tags.begin(), tags.end(), tag), tags.end());
+        if (!tags.empty())
+            return;
+
+        // A decode already queued finds no request and is dropped
+        if (i->second.GetAssetTag())
+        {
+            boost::shared_ptr<Foundation::AssetServiceInterface> asset_service = 
+                framework_->GetServiceManager()->GetService<Foundation::AssetServiceInterface>(Service::ST_Asset).lock();
+            if (asset_service)
+                asset_service->CancelAssetRequest(asset_id, i->second.GetAssetTag());
+        }
+        TextureDecoderModule::LogDebug("Texture request " + asset_id + " canceled");
+        requests_.erase(i);
+    }
+
+    request_tag_t TextureService::RequestTextureLevel(const std::string& asset_id, int level)
+    {
+        // While the texture is being received, decoding it is already in progress
+        if (requests_.find(asset_id) != requests_.end())
+            return 0;
+
+        // The decoded texture cache has the level if it has the mipmaps of the texture
+        TextureResource *texture = cache_->GetTexture(asset_id, level);
+        if (texture)
+        {
+            ++stats_.level_cache_hits;
+            request_tag_t tag = framework_->GetEventManager()->GetNextRequestTag();
+            Resource::Events::ResourceReady* event_data = new Resource::Events::ResourceReady(asset_id, Foundation::ResourcePtr(texture), tag);
+            framework_->GetEventManager()->SendDelayedEvent(resource_event_category_, Resource::Events::RESOURCE_READY, EventDataPtr(event_data));
+            return tag;
+        }
+
+        boost::shared_ptr<Foundation::AssetServiceInterface> asset_service = 
+            framework_->GetServiceManager()->GetService<Foundation::AssetServiceInterface>(Service::ST_Asset).lock();
+        if (!asset_service)
+            return 0;
+
+        Foundation::AssetPtr asset = asset_service->GetAsset(asset_id, RexTypes::ASSETTYPENAME_TEXTURE);
+        if (!asset || !asset->GetSize())
+            return 0;
+
+        DecodeRequestPtr decode_request(new DecodeRequest());
+        decode_request->id_ = asset_id;
+        decode_request->level_ = level;
+        decode_request->source_ = asset;
+        request_tag_t tag = framework_->GetThreadTaskManager()->AddRequest<DecodeRequest>("TextureDecoder", decode_request);
+        if (tag)
+            level_decodes_[tag] = asset_id;
+        return tag;
+    }
+
     TextureResource *TextureService::GetFromCache(const std::string &texture_id)
     {
         if (cache_)
@@ -158,7 +237,7 @@ namespace TextureDecoder
         // If asset not yet requested, request now
         if (!request.IsRequested())
         {
-            asset_service->RequestAsset(request.GetId(), "Texture");
+            request.SetAssetTag(asset_service->RequestAsset(request.GetId(), "Texture"));
             request.SetRequested(true);
         }
 
@@ -180,6 +259,7 @@ namespace TextureDecoder
                 DecodeRequestPtr new_decode_request(new DecodeRequest());
                 new_decode_request->id_ = request.GetId();
                 new_decode_request->level_ = request.GetNextLevel();
+                new_decode_request->mipmaps_ = decoded_mipmaps_ && new_decode_request->level_ == 0;
                 new_decode_request->source_ = asset;
                 framework_->GetThreadTaskManager()->AddRequest<DecodeRequest>("TextureDecoder", new_decode_request);
                 
@@ -195,6 +275,28 @@ namespace TextureDecoder
         DecodeResult* result = dynamic_cast<DecodeResult*>(data);
         if (!result || result->task_description_ != "TextureDecoder")
             return false;
+
+        ++stats_.decodes;
+        stats_.decode_time += result->decode_time_;
+
+        // Decode of a lower quality level, the result is not stored to the cache
+        std::map<request_tag_t, std::string>::iterator l = level_decodes_.find(result->tag_);
+        if (l != level_decodes_.end())
+        {
+            EventManagerPtr event_manager = framework_->GetEventManager();
+            if (result->texture_)
+            {
+                Resource::Events::ResourceReady event_data(l->second, result->texture_, l->first);
+                event_manager->SendEvent(resource_event_category_, Resource::Events::RESOURCE_READY, &event_data);
+            }
+            else
+            {
+                Resource::Events::ResourceCanceled event_data(l->second, l->first);
+                event_manager->SendEvent(resource_event_category_, Resource::Events::RESOURCE_CANCELED, &event_data);
+            }
+            level_decodes_.erase(l);
+            return true;
+        }
         
         TextureRequestMap::iterator i = requests_.find(result->id_);
         if (i != requests_.end())
@@ -204,8 +306,9 @@ namespace TextureDecoder
             if (result->texture_)
             {
                 TextureResource* texture = checked_static_cast<TextureResource*>(result->texture_.get());
-                TextureDecoderModule::LogDebug("Decoded texture w " + ToString<uint>(texture->GetWidth()) + " h " +
-                    ToString<uint>(texture->GetHeight()) + " level " + ToString<int>(result->level_));
+                if (TextureDecoderModule::IsLogEnabled(Poco::Message::PRIO_DEBUG))
+                    TextureDecoderModule::LogDebug("Decoded texture w " + ToString<uint>(texture->GetWidth()) + " h " +
+                        ToString<uint>(texture->GetHeight()) + " level " + ToString<int>(result->level_));
 
                 // Send resource ready event for each request tag in the request
                 const RequestTagVector& tags = i->second.GetTags();
@@ -217,12 +320,14 @@ namespace TextureDecoder
                 }
 
                 // Store to cache if decoding is complete
-                if (result->level_ == 0)
+                if (result->level_ == 0 && (cache_->CacheEverything() || result->is_jpeg2000_))
                 {
-                    if (cache_->CacheEverything())
-                        cache_->StoreTexture(texture);
-                    else if (result->is_jpeg2000_)
-                        cache_->StoreTexture(texture);
+                    tick_t start = GetCurrentClockTime();
+                    if (cache_->StoreTexture(texture))
+                    {
+                        ++stats_.stores;
+                        stats_.store_time += (GetCurrentClockTime() - start) / (f64)GetCurrentClockFreq();
+                    }
                 }
             }   
             
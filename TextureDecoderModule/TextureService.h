@@ -21,6 +21,29 @@ namespace TextureDecoder
     class TextureService : public Foundation::TextureServiceInterface
     {
     public:
+        //! Counters of decodes and decoded texture cache use, for comparing region entry with and without a warm cache
+        struct Stats
+        {
+            Stats() : decodes(0), decode_time(0.0), cache_hits(0), cache_time(0.0), cache_bytes(0), level_cache_hits(0),
+                stores(0), store_time(0.0) {}
+            //! JPEG2000 and image decodes, of all quality levels
+            uint decodes;
+            //! Seconds spent decoding in the decoder thread
+            f64 decode_time;
+            //! Textures found from the decoded texture cache
+            uint cache_hits;
+            //! Seconds spent reading textures from the cache
+            f64 cache_time;
+            //! Data of the textures found from the cache
+            u64 cache_bytes;
+            //! Lower quality levels found from the cache
+            uint level_cache_hits;
+            //! Textures stored to the cache
+            uint stores;
+            //! Seconds spent storing textures to the cache
+            f64 store_time;
+        };
+
         //! Constructor
         TextureService(Foundation::Framework* framework);
         
@@ -33,6 +56,21 @@ namespace TextureDecoder
          */
         virtual request_tag_t RequestTexture(const std::string& asset_id);
 
+        //! Removes a request tag from a texture request, and cancels the asset request when no tags are left
+        /*! \param asset_id asset ID of texture
+            \param tag request tag returned by RequestTexture
+         */
+        virtual void CancelTextureRequest(const std::string& asset_id, request_tag_t tag);
+
+        //! Queues a decode of an already received texture at a lower quality level
+        /*! The level is read from the decoded texture cache if it has the mipmap levels of the texture.
+            \param asset_id asset ID of texture
+            \param level quality level to decode
+            \return request tag, will be used in the RESOURCE_READY or RESOURCE_CANCELED event. 0 if the texture
+                    is still being received, or neither the decoded texture cache nor the asset cache has it
+         */
+        virtual request_tag_t RequestTextureLevel(const std::string& asset_id, int level);
+
         //! Gets a texture rousource from cache
         //! @param texture_id as std::string
         //! @return valid ptr if found, 0 ptr if not
@@ -50,6 +88,13 @@ namespace TextureDecoder
         
         //! Handles a thread task event. Called by TextureDecoderModule
         bool HandleTaskEvent(event_id_t event_id, IEventData* data);
+
+        //! Returns whether decoded JPEG2000 textures get their mipmap levels, for the cache
+        bool GetDecodedMipmaps() const { return decoded_mipmaps_; }
+
+        const Stats& GetStats() const { return stats_; }
+
+        void ResetStats() { stats_ = Stats(); }
         
     private:
         //! Updates a texture request
@@ -75,8 +120,16 @@ namespace TextureDecoder
 
         CacheReplys cache_replys_;
 
+        //! Texture ids of decodes of lower quality levels, by request tag
+        std::map<request_tag_t, std::string> level_decodes_;
+
         //! Max decodes per frame
         int max_decodes_per_frame_;
+
+        //! Whether to generate the mipmap levels of decoded JPEG2000 textures
+        bool decoded_mipmaps_;
+
+        Stats stats_;
     };
 }
 
@@ -0,0 +1,43 @@
+print("Loading bulk attribute example script.");
+
+// Lifts every placeable within 20 units of this entity by one unit, first one entity at a time and then as one
+// attribute column, and prints how long each took. The column functions read and write one attribute of many
+// entities in one call, and deliver the changes as a single batch.
+
+var radius = 20;
+var stride = 9; // Transform: position xyz, rotation xyz, scale xyz
+var defaultChange = 0; // AttributeChange::Default, same as setting Position
+
+function LiftPerEntity(ids, dz)
+{
+    for(var i = 0; i < ids.length; ++i)
+    {
+        var placeable = scene.GetEntityRaw(ids[i]).GetComponentRaw("EC_Placeable");
+        if (!placeable)
+            continue;
+        var pos = placeable.Position;
+        pos.z += dz;
+        placeable.Position = pos;
+    }
+}
+
+function LiftBulk(ids, dz)
+{
+    var values = scene.GetAttributeColumn(ids, "EC_Placeable", "Transform");
+    for(var i = 2; i < values.length; i += stride)
+        values[i] += dz;
+    scene.SetAttributeColumn(ids, "EC_Placeable", "Transform", values, defaultChange);
+}
+
+var center = me.placeable.Position;
+var ids = scene.GetEntityIdsInRadius(center, radius);
+
+var start = new Date().getTime();
+LiftPerEntity(ids, 1.0);
+var perEntityTime = new Date().getTime() - start;
+
+start = new Date().getTime();
+LiftBulk(ids, -1.0);
+var bulkTime = new Date().getTime() - start;
+
+print(ids.length + " entities: per entity " + perEntityTime + " ms, bulk " + bulkTime + " ms");
@@ -0,0 +1,78 @@
+"""Compares per-entity and bulk scene access from Python.
+
+The bulk path reads and writes one attribute of all entities at once with
+SceneManager.GetAttributeColumnData / SetAttributeColumnData, which pass the
+values as packed floats instead of one wrapper object per entity.
+
+Run benchmark() from the python console once a scene is loaded, or enable
+the BulkSceneBenchmark component in default.ini to run it on the first
+frame that has placeables. Per-entity writes go through EC_Placeable.Position,
+which uses the update mode of the component, so the bulk writes use the same
+Default change type to compare equal work. Both replicate by default, so
+prefer a local scene.
+"""
+
+import time
+import array
+
+import circuits
+import naali
+
+COMPONENT = "EC_Placeable"
+ATTRIBUTE = "Transform"
+TRANSFORM_STRIDE = 9 # position xyz, rotation xyz, scale xyz
+DEFAULT = 0 # AttributeChange::Default, same as setting Position
+
+def move_per_entity(scene, ids, dz):
+    for entid in ids:
+        placeable = scene.GetEntityRaw(entid).GetComponentRaw(COMPONENT)
+        pos = placeable.Position
+        pos.setZ(pos.z() + dz)
+        placeable.Position = pos
+
+def move_bulk(scene, ids, dz):
+    values = array.array('f', scene.GetAttributeColumnData(ids, COMPONENT, ATTRIBUTE))
+    for i in xrange(2, len(values), TRANSFORM_STRIDE):
+        values[i] += dz
+    scene.SetAttributeColumnData(ids, COMPONENT, ATTRIBUTE, values.tostring(), DEFAULT)
+
+def benchmark(rounds=10):
+    scene = naali.getDefaultScene()
+    ids = scene.GetEntityIdsWithComponent(COMPONENT)
+    if not ids:
+        print "bulkscene: no entities with", COMPONENT
+        return
+
+    # Every round moves the entities up and back down, so the scene is left as it was.
+    start = time.time()
+    for n in range(rounds):
+        move_per_entity(scene, ids, 0.01)
+        move_per_entity(scene, ids, -0.01)
+    per_entity = time.time() - start
+
+    start = time.time()
+    for n in range(rounds):
+        move_bulk(scene, ids, 0.01)
+        move_bulk(scene, ids, -0.01)
+    bulk = time.time() - start
+
+    print "bulkscene: %d entities, %d rounds: per entity %.1f ms, bulk %.1f ms" % \
+        (len(ids), rounds, per_entity * 1000, bulk * 1000)
+
+class BulkSceneBenchmark(circuits.BaseComponent):
+    def __init__(self):
+        circuits.BaseComponent.__init__(self)
+        self.done = False
+
+    @circuits.handler("update")
+    def update(self, frametime):
+        if self.done:
+            return
+        scene = naali.getDefaultScene()
+        if scene is not None and scene.GetEntityIdsWithComponent(COMPONENT):
+            self.done = True
+            benchmark()
+
+    @circuits.handler("on_logout")
+    def on_logout(self, evid):
+        self.done = False
@@ -15,6 +15,7 @@ from core.logger import NaaliLogger
 #from collections import namedtuple
 #MouseInfo = namedtuple('MouseInfo', 'x y rel_x rel_y')
 from core.mouseinfo import MouseInfo
+from core.scheduler import Scheduler, TimedManager
 
 #XXX a temporary fix 'cause circuits socket internals depend on a Started event now
 from circuits.core.events import Started
@@ -47,6 +48,7 @@ class ComponentRunner:
         
         self.firstrun = True
         r.restart = False
+        self.scheduler = Scheduler()
         self.start()
         r.manager = self
 
@@ -62,8 +64,9 @@ class ComponentRunner:
         # to something that shows e.g. in console, so prints from scripts show
         # (people commonly use those for debugging so they should show somewhere)
         d = Debugger(IgnoreChannels = ignchannels, logger=NaaliLogger()) #IgnoreEvents = ignored)
-        self.m = Manager() + d
+        self.m = TimedManager(self.scheduler.stats) + d
         #self.m = Manager()
+        self.scheduler.clear() #the events and tasks were for the components of the previous run
 
         #or __all__ in pymodules __init__ ? (i.e. import pymodules would do that)
         if self.firstrun:
@@ -78,12 +81,32 @@ class ComponentRunner:
 
         self.m.push(Started(self.m, None)) #webserver requires this now, temporarily XXX
                     
-    def run(self, deltatime=0.1):
+    def run(self, deltatime=0.1, budget=None):
+        """budget: seconds per frame for the Python side, see core.scheduler"""
         #print "."
+        s = self.scheduler
+        if budget is not None:
+            s.budget = budget
+        s.begin_frame()
         self.send_event(Update(deltatime), "update") #so that all components are updated immediately once for this frame
         #XXX should this be using the __tick__ mechanism of circuits, and how?
         m = self.m
         m.tick()
+        #what is left of the budget goes to the deferred events and then to the tasks
+        s.run_deferred(self.send_event)
+        s.run_tasks()
+        s.end_frame()
+
+    def get_stats(self, reset=False):
+        report = self.scheduler.report()
+        if reset:
+            self.scheduler.stats.reset()
+        return report
+
+    def defer_event(self, event, channel, key=None):
+        """queues a notification event for run(), or sends it right away if the queue is full"""
+        if not self.scheduler.defer(event, channel, key):
+            self.send_event(event, channel)
 
     def send_event(self, event, channel):
         """simulate sync sending of events using the async lib.
@@ -146,12 +169,16 @@ class ComponentRunner:
     def SCENE_ADDED(self, name):
         return self.send_event(SceneAdded(name), "on_sceneadded")
         
+    #the notification events below are delivered in run() as the frame budget allows,
+    #so they can't be used to stop the event from going to the other modules
     def ENTITY_UPDATED(self, entid):
         #print "Entity updated!", entid
-        return self.send_event(EntityUpdate(entid), "on_entityupdated")
+        self.defer_event(EntityUpdate(entid), "on_entityupdated", entid)
+        return False
 
     def ENTITY_VISUALS_MODIFIED(self, entid):
-        return self.send_event(EntityUpdate(entid), "on_entity_visuals_modified")
+        self.defer_event(EntityUpdate(entid), "on_entity_visuals_modified", entid)
+        return False
 
     def LOGIN_INFO(self, id): 
         #print "Login Info", id
@@ -169,7 +196,8 @@ class ComponentRunner:
 
     def GENERIC_MESSAGE(self, typename, data):
         #print "Circuits got Generic Message event:", data
-        return self.send_event(GenericMessage(typename, data), "on_genericmessage")
+        self.defer_event(GenericMessage(typename, data), "on_genericmessage")
+        return False
 
     def WORLD_STREAM_READY(self, event_id):
         return self.send_event(WorldStreamReady(event_id), "on_worldstreamready")
@@ -0,0 +1,282 @@
+"""Time accounting and frame budgets for the Python side of Naali.
+
+Everything in Python runs in the main thread, in the middle of the frame,
+so every handler adds directly to the frame time. The Scheduler measures
+the wall time of each circuits handler, delivers the notification type
+events (entity updates, generic messages) only as far as the per-frame
+budget allows, and runs generator based tasks a slice at a time:
+
+    from core.scheduler import spawn, NextFrame
+
+    def build_index(ents):
+        for ent in ents:
+            index(ent)
+            yield             #may continue in this frame if there is time left
+        yield NextFrame       #wait for the next frame in any case
+
+    spawn(build_index(ents), "build_index")
+
+The measured times are also put in the C++ profiler tree, one block per
+handler, and can be printed with the PyStats console command.
+"""
+
+from collections import deque
+from inspect import getargspec
+from timeit import default_timer as timer
+import traceback
+
+try:
+    import rexviewer as r
+except ImportError: #not running under rex
+    import mockviewer as r
+
+from circuits import Manager
+
+#the profiler is only there when running in the viewer
+profile_begin = getattr(r, "profileBegin", None)
+profile_end = getattr(r, "profileEnd", None)
+
+DEFAULT_BUDGET = 0.005 #seconds per frame, used until the viewer gives its own
+MAX_DEFERRED = 10000 #deferred events kept at most, more are delivered right away
+
+class NextFrame(object):
+    """Yield this from a task to not continue it before the next frame."""
+    pass
+
+class HandlerStats:
+    """Accumulated wall times per name (handler, task or event channel)."""
+
+    def __init__(self):
+        self.reset()
+
+    def reset(self):
+        self.times = {} #name -> [calls, total, max]
+        self.frames = 0
+        self.over_budget = 0
+        self.overflow = 0
+
+    def add(self, name, elapsed):
+        t = self.times.get(name)
+        if t is None:
+            self.times[name] = [1, elapsed, elapsed]
+        else:
+            t[0] += 1
+            t[1] += elapsed
+            if elapsed > t[2]:
+                t[2] = elapsed
+
+    def report(self):
+        lines = []
+        items = sorted(self.times.items(), key=lambda i: i[1][1], reverse=True)
+        for name, (calls, total, maxtime) in items:
+            lines.append("%-50s calls %7d  total %9.2f ms  avg %7.3f ms  max %7.3f ms" %
+                (name, calls, total * 1000.0, total * 1000.0 / calls, maxtime * 1000.0))
+        return lines
+
+class TimedHandler(object):
+    """Wraps a circuits handler to measure it.
+
+    The circuits handler attributes (channels, target, filter, priority)
+    are looked up from the original, so that the manager registers the
+    wrapper the same way as it would the handler itself."""
+
+    __slots__ = ["handler", "name", "stats", "event"]
+
+    def __init__(self, handler, stats):
+        self.handler = handler
+        self.stats = stats
+        owner = getattr(handler, "im_self", None)
+        if owner is not None:
+            self.name = "%s.%s" % (owner.__class__.__name__, handler.__name__)
+        else:
+            self.name = getattr(handler, "__name__", repr(handler))
+        #the manager would inspect the arguments of the wrapper, which takes any
+        if hasattr(handler, "event"):
+            self.event = handler.event
+        else:
+            args = getargspec(handler)[0]
+            if args and args[0] == "self":
+                del args[0]
+            self.event = bool(args and args[0] == "event")
+
+    def __getattr__(self, name):
+        return getattr(self.handler, name)
+
+    def __call__(self, *args, **kwargs):
+        if profile_begin is not None:
+            profile_begin(self.name)
+        start = timer()
+        try:
+            return self.handler(*args, **kwargs)
+        finally:
+            self.stats.add(self.name, timer() - start)
+            if profile_end is not None:
+                profile_end(self.name)
+
+    def __repr__(self):
+        return repr(self.handler)
+
+class TimedManager(Manager):
+    """A circuits Manager that measures every handler it calls.
+
+    The handlers are wrapped when they are added, and the components
+    remove them with the original, so the wrappers are looked up by it."""
+
+    def __init__(self, stats, *args, **kwargs):
+        Manager.__init__(self, *args, **kwargs)
+        self.stats = stats
+        self._timedhandlers = {} #original handler -> TimedHandler
+
+    def addHandler(self, handler, *channels, **kwargs):
+        if not isinstance(handler, TimedHandler):
+            timed = self._timedhandlers.get(handler)
+            if timed is None:
+                timed = self._timedhandlers[handler] = TimedHandler(handler, self.stats)
+            handler = timed
+        Manager.addHandler(self, handler, *channels, **kwargs)
+
+    add = addHandler
+
+    def removeHandler(self, handler, channel=None):
+        timed = self._timedhandlers.get(handler, handler)
+        Manager.removeHandler(self, timed, channel)
+        #removing from one channel leaves the handler registered on the others
+        if timed not in self._handlerattrs:
+            self._timedhandlers.pop(getattr(timed, "handler", handler), None)
+
+    remove = removeHandler
+
+class Task:
+    def __init__(self, gen, name):
+        self.gen = gen
+        self.name = name
+        self.cancelled = False
+
+class Scheduler:
+    """Keeps the Python work of a frame within a time budget.
+
+    The budget is shared by everything that runs in ComponentRunner.run:
+    first the update handlers, then the deferred events and then the tasks.
+    At least one deferred event and one task step are run every frame so
+    that a too small budget slows them down instead of stopping them.
+    """
+
+    instance = None
+
+    def __init__(self, budget=DEFAULT_BUDGET):
+        Scheduler.instance = self
+        self.budget = budget
+        self.stats = HandlerStats()
+        self.deferred = deque() #keys of the deferred events, in the order they were first queued
+        self.pending = {} #key -> (event, channel)
+        self.nextkey = 0
+        self.tasks = deque()
+        self.framestart = timer()
+
+    def clear(self):
+        """Drops the queued events and tasks, used when the components are reloaded."""
+        self.deferred.clear()
+        self.pending.clear()
+        self.tasks.clear()
+
+    def begin_frame(self):
+        self.framestart = timer()
+        self.stats.frames += 1
+
+    def end_frame(self):
+        if timer() - self.framestart > self.budget:
+            self.stats.over_budget += 1
+
+    def time_left(self):
+        return self.budget - (timer() - self.framestart)
+
+    def defer(self, event, channel, key=None):
+        """Queues an event whose handlers don't need to run right away.
+
+        An event with the same channel and key, f.ex. the id of the entity,
+        replaces the one already queued and keeps its place in the queue.
+        Returns False if the queue is full and the event was not queued,
+        the caller must then deliver it right away.
+        """
+        if key is not None:
+            key = (channel, key)
+            if key in self.pending:
+                self.pending[key] = (event, channel)
+                return True
+        if len(self.deferred) >= MAX_DEFERRED:
+            self.stats.overflow += 1
+            return False
+        if key is None:
+            key = self.nextkey
+            self.nextkey += 1
+        self.deferred.append(key)
+        self.pending[key] = (event, channel)
+        return True
+
+    def run_deferred(self, send):
+        delivered = 0
+        while self.deferred and (delivered == 0 or self.time_left() > 0):
+            event, channel = self.pending.pop(self.deferred.popleft())
+            send(event, channel)
+            delivered += 1
+        return delivered
+
+    def spawn(self, gen, name=None):
+        """Runs a generator as a task, one step per yield, until it is exhausted."""
+        if name is None:
+            name = getattr(gen, "__name__", "task")
+        task = Task(gen, "task " + name)
+        self.tasks.append(task)
+        return task
+
+    def cancel(self, task):
+        task.cancelled = True
+
+    def run_tasks(self):
+        waiting = []
+        steps = 0
+        while self.tasks and (steps == 0 or self.time_left() > 0):
+            task = self.tasks.popleft()
+            if task.cancelled:
+                continue
+            ret = self.step(task)
+            if ret is NextFrame:
+                waiting.append(task)
+            elif ret is not None:
+                self.tasks.append(task)
+            steps += 1
+        self.tasks.extend(waiting)
+        return steps
+
+    def step(self, task):
+        """Returns what the task yielded, or None when it is done."""
+        if profile_begin is not None:
+            profile_begin(task.name)
+        start = timer()
+        try:
+            try:
+                ret = task.gen.next()
+            except StopIteration:
+                return None
+            except:
+                r.logInfo("Python task %s failed:" % task.name)
+                r.logInfo(traceback.format_exc())
+                return None
+            if ret is None:
+                return True
+            return ret
+        finally:
+            self.stats.add(task.name, timer() - start)
+            if profile_end is not None:
+                profile_end(task.name)
+
+    def report(self):
+        s = self.stats
+        lines = ["Python frame budget %.2f ms, %d of %d frames over budget, %d deferred events queued, %d delivered right away as the queue was full, %d tasks" %
+            (self.budget * 1000.0, s.over_budget, s.frames, len(self.deferred), s.overflow, len(self.tasks))]
+        lines.extend(s.report())
+        return "\n".join(lines)
+
+def spawn(gen, name=None):
+    """Runs a generator as a task of the Python module manager."""
+    return Scheduler.instance.spawn(gen, name)
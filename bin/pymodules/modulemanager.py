@@ -4,10 +4,13 @@ import rexviewer as r
 
 class ModuleManager:
     #was not calling update to not confuse with the eventhandlers
-    def run(self, elapsedtime):
+    def run(self, elapsedtime, budget=None):
         pass
         #print ".",
         #print elapsedtime
+
+    def get_stats(self, reset=False):
+        return "Python handler statistics are only kept by the Circuits Manager."
         
     """here was using 'on_chat' but changed to viewer event names,
     perhaps clearest as these are what the viewer calls,
@@ -0,0 +1,162 @@
+#!/usr/bin/env python
+"""Local stand-in for an HTTP asset server, for measuring the HTTP asset fetching of the viewer.
+
+Serves the files of a directory. Both plain urls (http://localhost:8000/<file>) and GetTexture
+cap style requests (http://localhost:8000/?texture_id=<uuid>, served from <dir>/<uuid> or
+<dir>/<uuid>.<any extension>) are accepted. Latency and a per connection bandwidth limit
+make the local server behave like a remote one.
+
+The server prints the number of requests, the most connections it had open at the same time
+and how many requests each connection carried, so keep-alive reuse and the viewer's connection
+limits can be checked. The viewer side timings, including the time until the visible assets of
+a burst of requests were fetched, are printed with the HttpAssetStats console command.
+
+    python httpassetserver.py --dir assets --latency 50 --rate 200
+
+To let the viewer fetch textures and meshes from it, point the GetTexture cap to the server, or
+request the assets with http urls.
+"""
+
+import os
+import sys
+import time
+import threading
+from optparse import OptionParser
+
+try:
+    from BaseHTTPServer import HTTPServer, BaseHTTPRequestHandler
+    from SocketServer import ThreadingMixIn
+    from urlparse import urlparse, parse_qs
+except ImportError: #python 3
+    from http.server import HTTPServer, BaseHTTPRequestHandler
+    from socketserver import ThreadingMixIn
+    from urllib.parse import urlparse, parse_qs
+
+class Stats:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.requests = 0
+        self.missing = 0
+        self.bytes = 0
+        self.open = 0
+        self.max_open = 0
+        self.connections = 0
+        self.requests_per_connection = []
+
+    def connection_opened(self):
+        self.lock.acquire()
+        self.open += 1
+        self.connections += 1
+        self.max_open = max(self.max_open, self.open)
+        self.lock.release()
+
+    def connection_closed(self, requests):
+        self.lock.acquire()
+        self.open -= 1
+        self.requests_per_connection.append(requests)
+        self.lock.release()
+
+    def report(self):
+        per_connection = self.requests_per_connection or [0]
+        return ("%d requests (%d not found), %d bytes, %d connections, at most %d open at a time, "
+                "%.1f requests per connection on average, %d at most" %
+                (self.requests, self.missing, self.bytes, self.connections, self.max_open,
+                 sum(per_connection) / float(len(per_connection)), max(per_connection)))
+
+stats = Stats()
+
+class AssetHandler(BaseHTTPRequestHandler):
+    #keep-alive
+    protocol_version = "HTTP/1.1"
+
+    def setup(self):
+        BaseHTTPRequestHandler.setup(self)
+        self.served = 0
+        stats.connection_opened()
+
+    def finish(self):
+        stats.connection_closed(self.served)
+        BaseHTTPRequestHandler.finish(self)
+
+    def find_file(self):
+        url = urlparse(self.path)
+        query = parse_qs(url.query)
+        if "texture_id" in query:
+            name = query["texture_id"][0]
+            for f in os.listdir(self.server.dir):
+                if f == name or f.startswith(name + "."):
+                    return os.path.join(self.server.dir, f)
+            return None
+        path = os.path.normpath(os.path.join(self.server.dir, url.path.lstrip("/")))
+        if not path.startswith(os.path.abspath(self.server.dir)) or not os.path.isfile(path):
+            return None
+        return path
+
+    def do_GET(self):
+        self.served += 1
+        stats.lock.acquire()
+        stats.requests += 1
+        stats.lock.release()
+
+        time.sleep(self.server.latency)
+
+        path = self.find_file()
+        if path is None:
+            stats.lock.acquire()
+            stats.missing += 1
+            stats.lock.release()
+            self.send_response(404)
+            self.send_header("Content-Length", "0")
+            self.end_headers()
+            return
+
+        data = open(path, "rb").read()
+        self.send_response(200)
+        self.send_header("Content-Type", "application/octet-stream")
+        self.send_header("Content-Length", str(len(data)))
+        self.end_headers()
+
+        #send in slices to keep to the bandwidth limit of the connection
+        rate = self.server.rate
+        step = 16384
+        for i in range(0, len(data), step):
+            chunk = data[i:i + step]
+            self.wfile.write(chunk)
+            if rate:
+                time.sleep(len(chunk) / rate)
+
+        stats.lock.acquire()
+        stats.bytes += len(data)
+        stats.lock.release()
+
+    def log_message(self, format, *args):
+        if self.server.verbose:
+            BaseHTTPRequestHandler.log_message(self, format, *args)
+
+class AssetServer(ThreadingMixIn, HTTPServer):
+    daemon_threads = True
+
+def main():
+    parser = OptionParser(usage="%prog [options]")
+    parser.add_option("--dir", default=".", help="directory of the asset files")
+    parser.add_option("--port", type="int", default=8000)
+    parser.add_option("--latency", type="float", default=0.0, help="milliseconds before each response")
+    parser.add_option("--rate", type="float", default=0.0, help="kilobytes per second per connection, 0 for no limit")
+    parser.add_option("--verbose", action="store_true", default=False, help="log every request")
+    options, args = parser.parse_args()
+
+    server = AssetServer(("", options.port), AssetHandler)
+    server.dir = os.path.abspath(options.dir)
+    server.latency = options.latency / 1000.0
+    server.rate = options.rate * 1024.0
+    server.verbose = options.verbose
+
+    print("Serving %s on port %d" % (server.dir, options.port))
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    print(stats.report())
+
+if __name__ == "__main__":
+    main()
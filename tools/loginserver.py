@@ -0,0 +1,217 @@
+#!/usr/bin/env python
+"""Local stand-in for an OpenSim login server, for measuring how the viewer reads large login replies.
+
+Answers login_to_simulator XML-RPC calls with a reply that has a generated inventory skeleton and
+World Library of the given sizes, and a buddy list. The reply is sent in slices, optionally at a
+limited rate, so that the viewer reads it as it arrives like from a remote server.
+
+    python loginserver.py --folders 20000 --buddies 500 --rate 500
+
+Log in with any name and password to localhost:9000 (or the --port given). The viewer logs the
+size of the reply, the time spent receiving and parsing it, the time spent building the inventory
+and the most bytes held by the reply parser, when the login reply has been read. The sim address
+in the reply points to --sim-ip and --sim-port, so the login fails after that unless a simulator
+runs there. Set stream_login_reply to false in the ProtocolModuleOpenSim group of the viewer
+configuration to compare with reading the reply as a whole.
+
+With --indent the reply is written one element per line, indented, like many servers write it.
+With --dump the reply is written to a file instead of being served.
+"""
+
+import random
+import re
+import time
+import uuid
+from optparse import OptionParser
+
+try:
+    from BaseHTTPServer import HTTPServer, BaseHTTPRequestHandler
+    from SocketServer import ThreadingMixIn
+except ImportError: #python 3
+    from http.server import HTTPServer, BaseHTTPRequestHandler
+    from socketserver import ThreadingMixIn
+
+HARDCODED_FOLDERS = ["Animations", "Body Parts", "Calling Cards", "Clothing", "Gestures", "Landmarks",
+    "Lost And Found", "Notecards", "Objects", "Photo Album", "Scripts", "Sounds", "Textures", "Trash"]
+
+def value(v):
+    if isinstance(v, bool):
+        return "<value><boolean>%d</boolean></value>" % int(v)
+    if isinstance(v, int):
+        return "<value><i4>%d</i4></value>" % v
+    if isinstance(v, float):
+        return "<value><double>%f</double></value>" % v
+    return "<value><string>%s</string></value>" % v.replace("&", "&amp;").replace("<", "&lt;")
+
+def member(name, v):
+    #arrays and structs are passed in as already formatted values
+    if not (isinstance(v, str) and v.startswith("<value>")):
+        v = value(v)
+    return "<member><name>%s</name>%s</member>" % (name, v)
+
+def struct(members):
+    return "<value><struct>%s</struct></value>" % "".join(member(name, v) for name, v in members)
+
+def array(items):
+    return "<value><array><data>%s</data></array></value>" % "".join(items)
+
+def folder(name, folder_id, parent_id, type_default=-1):
+    return struct([("name", name), ("parent_id", parent_id), ("version", 1),
+                   ("type_default", type_default), ("folder_id", folder_id)])
+
+def skeleton(root_name, count, fanout, rng):
+    """Returns the root folder id and the folder structs of a tree of count folders."""
+    root_id = str(uuid.UUID(int=rng.getrandbits(128)))
+    folders = [folder(root_name, root_id, "00000000-0000-0000-0000-000000000000", 8)]
+    parents = [root_id]
+    for name in HARDCODED_FOLDERS[:max(0, min(len(HARDCODED_FOLDERS), count - 1))]:
+        folder_id = str(uuid.UUID(int=rng.getrandbits(128)))
+        folders.append(folder(name, folder_id, root_id))
+        parents.append(folder_id)
+    index = 0
+    while len(folders) < count:
+        #fill the tree level by level, listing the folders in random order like servers do
+        parent = parents[index // fanout]
+        folder_id = str(uuid.UUID(int=rng.getrandbits(128)))
+        folders.append(folder("Folder %d" % len(folders), folder_id, parent))
+        parents.append(folder_id)
+        index += 1
+    root = folders[0]
+    rest = folders[1:]
+    rng.shuffle(rest)
+    return root_id, [root] + rest
+
+def make_reply(options):
+    rng = random.Random(options.seed)
+    root_id, folders = skeleton("My Inventory", options.folders, options.fanout, rng)
+    lib_root_id, lib_folders = skeleton("OpenSim Library", options.library_folders, options.fanout, rng)
+    buddies = [struct([("buddy_id", str(uuid.UUID(int=rng.getrandbits(128)))),
+                       ("buddy_rights_given", 1), ("buddy_rights_has", 1)]) for i in range(options.buddies)]
+    agent_id = str(uuid.UUID(int=rng.getrandbits(128)))
+    members = [
+        ("login", "true"),
+        ("session_id", str(uuid.uuid4())),
+        ("secure_session_id", str(uuid.uuid4())),
+        ("agent_id", agent_id),
+        ("circuit_code", rng.randint(1, 2 ** 31 - 1)),
+        ("first_name", "Test"),
+        ("last_name", "User"),
+        ("sim_ip", options.sim_ip),
+        ("sim_port", options.sim_port),
+        ("region_x", 256000),
+        ("region_y", 256000),
+        ("seed_capability", "http://%s:%d/CAPS/%s0000/" % (options.sim_ip, options.sim_port, uuid.uuid4())),
+        ("message", "Welcome to the stand-in login server"),
+        ("inventory-root", array([struct([("folder_id", root_id)])])),
+        ("inventory-skeleton", array(folders)),
+        ("inventory-lib-root", array([struct([("folder_id", lib_root_id)])])),
+        ("inventory-lib-owner", array([struct([("agent_id", str(uuid.UUID(int=rng.getrandbits(128))))])])),
+        ("inventory-skel-lib", array(lib_folders)),
+        ("buddy-list", array(buddies)),
+        ("gestures", array([])),
+        ("event_categories", array([])),
+        ("classified_categories", array([struct([("category_id", 1), ("category_name", "Shopping")])])),
+        ("ui-config", array([struct([("allow_first_life", "Y")])])),
+        ("login-flags", array([struct([("stipend_since_login", "N"), ("ever_logged_in", "Y")])])),
+    ]
+    reply = ('<?xml version="1.0" encoding="utf-8"?><methodResponse><params><param>%s</param></params>'
+             '</methodResponse>' % struct(members))
+    if options.indent:
+        reply = indent(reply)
+    return reply.encode("utf-8")
+
+def indent(xml, step="  "):
+    """Returns xml with each element on a line of its own, except scalar elements with their text."""
+    tokens = re.findall(r"<[^>]+>|[^<]+", xml)
+    lines = []
+    depth = 0
+    i = 0
+    while i < len(tokens):
+        token = tokens[i]
+        if token.startswith("<?"):
+            lines.append(token)
+        elif token.startswith("</"):
+            depth -= 1
+            lines.append(step * depth + token)
+        elif i + 1 < len(tokens) and tokens[i + 1].startswith("</"):
+            #empty element, eg. <data></data>
+            lines.append(step * depth + token + tokens[i + 1])
+            i += 1
+        elif i + 2 < len(tokens) and not tokens[i + 1].startswith("<"):
+            #element with text, eg. <i4>123</i4>
+            lines.append(step * depth + "".join(tokens[i:i + 3]))
+            i += 2
+        else:
+            lines.append(step * depth + token)
+            depth += 1
+        i += 1
+    return "\n".join(lines) + "\n"
+
+class LoginHandler(BaseHTTPRequestHandler):
+    def do_POST(self):
+        length = int(self.headers.get("Content-Length", 0))
+        request = self.rfile.read(length)
+        if b"login_to_simulator" not in request:
+            self.send_error(400, "only login_to_simulator is supported")
+            return
+
+        data = self.server.reply
+        self.send_response(200)
+        self.send_header("Content-Type", "text/xml")
+        self.send_header("Content-Length", str(len(data)))
+        self.end_headers()
+
+        #send in slices to keep to the bandwidth limit
+        start = time.time()
+        rate = self.server.rate
+        step = 16384
+        for i in range(0, len(data), step):
+            chunk = data[i:i + step]
+            self.wfile.write(chunk)
+            if rate:
+                time.sleep(len(chunk) / rate)
+        print("Sent a login reply of %d bytes in %.0f ms" % (len(data), (time.time() - start) * 1000.0))
+
+    def log_message(self, format, *args):
+        if self.server.verbose:
+            BaseHTTPRequestHandler.log_message(self, format, *args)
+
+class LoginServer(ThreadingMixIn, HTTPServer):
+    daemon_threads = True
+
+def main():
+    parser = OptionParser(usage="%prog [options]")
+    parser.add_option("--port", type="int", default=9000)
+    parser.add_option("--folders", type="int", default=10000, help="folders in the inventory skeleton")
+    parser.add_option("--library-folders", type="int", default=200, help="folders in the World Library")
+    parser.add_option("--fanout", type="int", default=8, help="subfolders per generated folder")
+    parser.add_option("--buddies", type="int", default=100)
+    parser.add_option("--rate", type="float", default=0.0, help="kilobytes per second, 0 for no limit")
+    parser.add_option("--sim-ip", default="127.0.0.1", help="simulator address put in the reply")
+    parser.add_option("--sim-port", type="int", default=9001, help="simulator port put in the reply")
+    parser.add_option("--seed", type="int", default=1, help="seed of the generated ids")
+    parser.add_option("--indent", action="store_true", default=False, help="write the reply indented, one element per line")
+    parser.add_option("--dump", metavar="FILE", help="write the reply to FILE and exit")
+    parser.add_option("--verbose", action="store_true", default=False, help="log every request")
+    options, args = parser.parse_args()
+
+    reply = make_reply(options)
+    if options.dump:
+        open(options.dump, "wb").write(reply)
+        print("Wrote a login reply of %d bytes to %s" % (len(reply), options.dump))
+        return
+
+    server = LoginServer(("", options.port), LoginHandler)
+    server.reply = reply
+    server.rate = options.rate * 1024.0
+    server.verbose = options.verbose
+
+    print("Serving login replies of %d bytes (%d folders, %d library folders, %d buddies) on port %d" %
+          (len(reply), options.folders, options.library_folders, options.buddies, options.port))
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+if __name__ == "__main__":
+    main()